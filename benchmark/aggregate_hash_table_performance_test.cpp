@@ -13,6 +13,8 @@ See the Mulan PSL v2 for more details. */
 #include "common/lang/memory.h"
 #include "common/lang/vector.h"
 #include "sql/expr/aggregate_hash_table.h"
+#include "sql/operator/group_by_vec_physical_operator.h"
+#include "storage/field/field_meta.h"
 
 class AggregateHashTableBenchmark : public benchmark::Fixture
 {
@@ -92,4 +94,179 @@ BENCHMARK_DEFINE_F(DISABLED_LinearProbingAggregateHashTableBenchmark, Aggregate)
 BENCHMARK_REGISTER_F(DISABLED_LinearProbingAggregateHashTableBenchmark, Aggregate)->Arg(16)->Arg(1024)->Arg(8192);
 #endif
 
+/**
+ * @brief 比较 StandardAggregateHashTable 和 RowAggregateHashTable 的聚合性能
+ * @details 每次迭代写入一个 8192 行的 Chunk，分组列 (key int) 有 range(0) 个不同的值，计算 sum(value)、count(*)
+ */
+class AggregateHashTableCompareBenchmark : public benchmark::Fixture
+{
+public:
+  static constexpr int ROWS = Column::DEFAULT_CAPACITY;
+
+  void SetUp(const ::benchmark::State &state) override
+  {
+    key_meta_.init("key", AttrType::INTS, 0, 4, true, 0);
+    value_meta_.init("value", AttrType::INTS, 4, 4, true, 1);
+    key_expr_ = make_unique<FieldExpr>(nullptr, &key_meta_);
+    sum_expr_ = make_unique<AggregateExpr>(AggregateExpr::Type::SUM, make_unique<FieldExpr>(nullptr, &value_meta_));
+    count_expr_ = make_unique<AggregateExpr>(AggregateExpr::Type::COUNT, make_unique<ValueExpr>(Value(1)));
+
+    group_chunk_.add_column(make_unique<Column>(key_meta_), 0);
+    aggr_chunk_.add_column(make_unique<Column>(value_meta_), 0);
+    for (int i = 0; i < ROWS; i++) {
+      int key = (i * 7919) % state.range(0);
+      group_chunk_.column(0).append_one((char *)&key);
+      aggr_chunk_.column(0).append_one((char *)&i);
+    }
+    aggr_chunk_.add_column(make_unique<Column>(), 1);
+    count_expr_->child()->get_column(group_chunk_, aggr_chunk_.column(1));
+  }
+
+  void TearDown(const ::benchmark::State &state) override
+  {
+    group_chunk_.reset();
+    aggr_chunk_.reset();
+  }
+
+  vector<Expression *> group_by_exprs() { return {key_expr_.get()}; }
+  vector<Expression *> aggregate_exprs() { return {sum_expr_.get(), count_expr_.get()}; }
+
+  void run(benchmark::State &state, AggregateHashTable &hash_table)
+  {
+    for (auto _ : state) {
+      hash_table.add_chunk(group_chunk_, aggr_chunk_);
+    }
+    state.SetItemsProcessed(state.iterations() * ROWS);
+  }
+
+protected:
+  FieldMeta              key_meta_;
+  FieldMeta              value_meta_;
+  unique_ptr<Expression> key_expr_;
+  unique_ptr<AggregateExpr> sum_expr_;
+  unique_ptr<AggregateExpr> count_expr_;
+  Chunk                  group_chunk_;
+  Chunk                  aggr_chunk_;
+};
+
+BENCHMARK_DEFINE_F(AggregateHashTableCompareBenchmark, Standard)(benchmark::State &state)
+{
+  StandardAggregateHashTable hash_table(aggregate_exprs());
+  run(state, hash_table);
+}
+
+BENCHMARK_DEFINE_F(AggregateHashTableCompareBenchmark, Row)(benchmark::State &state)
+{
+  RowAggregateHashTable hash_table(group_by_exprs(), aggregate_exprs());
+  run(state, hash_table);
+}
+
+BENCHMARK_REGISTER_F(AggregateHashTableCompareBenchmark, Standard)->Arg(8)->Arg(1024)->Arg(1 << 16);
+BENCHMARK_REGISTER_F(AggregateHashTableCompareBenchmark, Row)->Arg(8)->Arg(1024)->Arg(1 << 16);
+
+/**
+ * @brief 按顺序输出事先准备好的 Chunk，作为 group by 算子的子算子
+ */
+class ChunkListPhysicalOperator : public PhysicalOperator
+{
+public:
+  explicit ChunkListPhysicalOperator(const vector<unique_ptr<Chunk>> &chunks) : chunks_(chunks) {}
+
+  PhysicalOperatorType type() const override { return PhysicalOperatorType::TABLE_SCAN_VEC; }
+
+  RC open(Trx *) override
+  {
+    pos_ = 0;
+    return RC::SUCCESS;
+  }
+
+  RC next(Chunk &chunk) override
+  {
+    if (pos_ >= chunks_.size()) {
+      return RC::RECORD_EOF;
+    }
+    return chunk.reference(*chunks_[pos_++]);
+  }
+
+  RC close() override { return RC::SUCCESS; }
+
+private:
+  const vector<unique_ptr<Chunk>> &chunks_;
+  size_t                           pos_ = 0;
+};
+
+/**
+ * @brief 测试 GroupByVecPhysicalOperator 从读取子算子的 Chunk 到输出聚合结果的整个过程
+ * @details 输入有 range(0) 行，分组列 (key int) 有 range(1) 个不同的值，计算 sum(value)、count(*)
+ */
+class GroupByVecBenchmark : public benchmark::Fixture
+{
+public:
+  void SetUp(const ::benchmark::State &state) override
+  {
+    key_meta_.init("key", AttrType::INTS, 0, 4, true, 0);
+    value_meta_.init("value", AttrType::INTS, 4, 4, true, 1);
+
+    const int rows   = state.range(0);
+    const int groups = state.range(1);
+    for (int start = 0; start < rows; start += Column::DEFAULT_CAPACITY) {
+      auto chunk = make_unique<Chunk>();
+      chunk->add_column(make_unique<Column>(key_meta_), 0);
+      chunk->add_column(make_unique<Column>(value_meta_), 1);
+      for (int i = start; i < min<int>(rows, start + Column::DEFAULT_CAPACITY); i++) {
+        int key = i % groups;
+        chunk->column(0).append_one((char *)&key);
+        chunk->column(1).append_one((char *)&i);
+      }
+      chunks_.push_back(std::move(chunk));
+    }
+  }
+
+  void TearDown(const ::benchmark::State &state) override { chunks_.clear(); }
+
+  unique_ptr<PhysicalOperator> create_operator()
+  {
+    aggregate_exprs_.clear();
+    aggregate_exprs_.push_back(
+        make_unique<AggregateExpr>(AggregateExpr::Type::SUM, make_unique<FieldExpr>(nullptr, &value_meta_)));
+    aggregate_exprs_.push_back(
+        make_unique<AggregateExpr>(AggregateExpr::Type::COUNT, make_unique<ValueExpr>(Value(1))));
+
+    vector<unique_ptr<Expression>> group_by_exprs;
+    group_by_exprs.push_back(make_unique<FieldExpr>(nullptr, &key_meta_));
+    vector<Expression *> aggregate_exprs;
+    for (auto &expr : aggregate_exprs_) {
+      aggregate_exprs.push_back(expr.get());
+    }
+
+    auto oper = make_unique<GroupByVecPhysicalOperator>(std::move(group_by_exprs), std::move(aggregate_exprs));
+    oper->add_child(make_unique<ChunkListPhysicalOperator>(chunks_));
+    return oper;
+  }
+
+protected:
+  FieldMeta                      key_meta_;
+  FieldMeta                      value_meta_;
+  vector<unique_ptr<Chunk>>      chunks_;
+  vector<unique_ptr<Expression>> aggregate_exprs_;
+};
+
+BENCHMARK_DEFINE_F(GroupByVecBenchmark, GroupBy)(benchmark::State &state)
+{
+  unique_ptr<PhysicalOperator> oper = create_operator();
+  for (auto _ : state) {
+    oper->open(nullptr);
+    Chunk chunk;
+    int   rows = 0;
+    while (oper->next(chunk) == RC::SUCCESS) {
+      rows += chunk.rows();
+    }
+    oper->close();
+    benchmark::DoNotOptimize(rows);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_REGISTER_F(GroupByVecBenchmark, GroupBy)->ArgsProduct({{1 << 16, 1 << 20}, {8, 1024, 1 << 16}});
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -40,6 +40,10 @@ struct Stat
   int64_t scan_open_failed_count = 0;
   int64_t mismatch_count         = 0;
   int64_t scan_other_count       = 0;
+
+  int64_t lookup_success_count  = 0;
+  int64_t lookup_mismatch_count = 0;
+  int64_t lookup_other_count    = 0;
 };
 
 class BenchmarkBase : public Fixture
@@ -57,7 +61,9 @@ public:
       return;
     }
 
-    bpm_.init(make_unique<VacuousDoubleWriteBuffer>());
+    // 第二个参数是页帧表的分片个数，分片个数为1时相当于不分片的实现
+    bpm_ = make_unique<BufferPoolManager>(512, static_cast<int>(state.range(1)));
+    bpm_->init(make_unique<VacuousDoubleWriteBuffer>());
 
     string log_name       = this->Name() + ".log";
     string btree_filename = this->Name() + ".btree";
@@ -71,7 +77,7 @@ public:
     const char *filename = btree_filename.c_str();
 
     RC rc = handler_.create(
-        log_handler_, bpm_, filename, AttrType::INTS, sizeof(int32_t) /*attr_len*/, internal_max_size, leaf_max_size);
+        log_handler_, *bpm_, filename, AttrType::INTS, sizeof(int32_t) /*attr_len*/, internal_max_size, leaf_max_size);
     if (rc != RC::SUCCESS) {
       throw runtime_error("failed to create btree handler");
     }
@@ -86,6 +92,7 @@ public:
     }
 
     handler_.close();
+    bpm_.reset();
     LOG_INFO("test %s teardown done. threads=%d, thread index=%d",
         this->Name().c_str(),
         state.threads(),
@@ -180,8 +187,23 @@ public:
     }
   }
 
+  void Lookup(uint32_t value, Stat &stat)
+  {
+    const char *key = reinterpret_cast<const char *>(&value);
+
+    list<RID> rids;
+    RC        rc = handler_.get_entry(key, sizeof(value), rids);
+    if (rc != RC::SUCCESS) {
+      stat.lookup_other_count++;
+    } else if (rids.size() != 1 || rids.front() != RID(value, value)) {
+      stat.lookup_mismatch_count++;
+    } else {
+      stat.lookup_success_count++;
+    }
+  }
+
 protected:
-  BufferPoolManager bpm_{512};
+  unique_ptr<BufferPoolManager> bpm_;
   BplusTreeHandler  handler_;
   VacuousLogHandler log_handler_;
 };
@@ -208,7 +230,9 @@ BENCHMARK_DEFINE_F(InsertionBenchmark, Insertion)(State &state)
   state.counters["other"]     = Counter(stat.insert_other_count, Counter::kIsRate);
 }
 
-BENCHMARK_REGISTER_F(InsertionBenchmark, Insertion)->Threads(10);
+BENCHMARK_REGISTER_F(InsertionBenchmark, Insertion)->Threads(10)->ArgNames({"count", "frame_shards"})
+    ->Args({0, 1})
+    ->Args({0, BPFrameManager::DEFAULT_SHARD_NUM});
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -247,7 +271,9 @@ BENCHMARK_DEFINE_F(DeletionBenchmark, Deletion)(State &state)
   state.counters["other"]     = Counter(stat.delete_other_count, Counter::kIsRate);
 }
 
-BENCHMARK_REGISTER_F(DeletionBenchmark, Deletion)->Threads(10)->Arg(4 * 10000);
+BENCHMARK_REGISTER_F(DeletionBenchmark, Deletion)->Threads(10)->ArgNames({"count", "frame_shards"})
+    ->Args({4 * 10000, 1})
+    ->Args({4 * 10000, BPFrameManager::DEFAULT_SHARD_NUM});
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -290,7 +316,100 @@ BENCHMARK_DEFINE_F(ScanBenchmark, Scan)(State &state)
   state.counters["other"]                 = Counter(stat.scan_other_count, Counter::kIsRate);
 }
 
-BENCHMARK_REGISTER_F(ScanBenchmark, Scan)->Threads(10)->Arg(4 * 10000);
+BENCHMARK_REGISTER_F(ScanBenchmark, Scan)->Threads(10)->ArgNames({"count", "frame_shards"})
+    ->Args({4 * 10000, 1})
+    ->Args({4 * 10000, BPFrameManager::DEFAULT_SHARD_NUM});
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 点查询，主要的开销是在节点内二分查找时比较键值
+ */
+class LookupBenchmark : public BenchmarkBase
+{
+public:
+  string Name() const override { return "lookup"; }
+
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    BenchmarkBase::SetUp(state);
+
+    // 单次查找很快，TRACE 日志的开销会掩盖查找本身
+    g_log->set_log_level(LOG_LEVEL_INFO);
+
+    uint32_t max = GetRangeMax(state);
+    ASSERT(max > 0, "invalid argument count. %ld", state.range(0));
+    FillUp(0, max);
+  }
+};
+
+BENCHMARK_DEFINE_F(LookupBenchmark, Lookup)(State &state)
+{
+  IntegerGenerator generator(0, GetRangeMax(state) - 1);
+  Stat             stat;
+
+  for (auto _ : state) {
+    uint32_t value = static_cast<uint32_t>(generator.next());
+    Lookup(value, stat);
+  }
+
+  state.counters["success"]  = Counter(stat.lookup_success_count, Counter::kIsRate);
+  state.counters["mismatch"] = Counter(stat.lookup_mismatch_count, Counter::kIsRate);
+  state.counters["other"]    = Counter(stat.lookup_other_count, Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(LookupBenchmark, Lookup)->Threads(10)->ArgNames({"count", "frame_shards"})
+    ->Args({4 * 10000, 1})
+    ->Args({4 * 10000, BPFrameManager::DEFAULT_SHARD_NUM});
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 只读的点查询在不同线程数下的扩展性
+ * @details 第三个参数表示是否使用乐观读。不使用乐观读时，每次查找都要对根节点加读锁，
+ * 线程多了之后根节点的锁就会成为瓶颈
+ */
+class ReadScalingBenchmark : public LookupBenchmark
+{
+public:
+  string Name() const override { return "read_scaling"; }
+
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    LookupBenchmark::SetUp(state);
+    handler_.set_optimistic_read(state.range(2) != 0);
+  }
+};
+
+BENCHMARK_DEFINE_F(ReadScalingBenchmark, ReadScaling)(State &state)
+{
+  IntegerGenerator generator(0, GetRangeMax(state) - 1);
+  Stat             stat;
+
+  for (auto _ : state) {
+    uint32_t value = static_cast<uint32_t>(generator.next());
+    Lookup(value, stat);
+  }
+
+  state.counters["success"]  = Counter(stat.lookup_success_count, Counter::kIsRate);
+  state.counters["mismatch"] = Counter(stat.lookup_mismatch_count, Counter::kIsRate);
+  state.counters["other"]    = Counter(stat.lookup_other_count, Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(ReadScalingBenchmark, ReadScaling)
+    ->ThreadRange(1, 64)
+    ->UseRealTime()
+    ->ArgNames({"count", "frame_shards", "optimistic"})
+    ->Args({4 * 10000, BPFrameManager::DEFAULT_SHARD_NUM, 0})
+    ->Args({4 * 10000, BPFrameManager::DEFAULT_SHARD_NUM, 1});
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -344,7 +463,9 @@ BENCHMARK_DEFINE_F(MixtureBenchmark, Mixture)(State &state)
       {"scan_open_failed", Counter(stat.scan_open_failed_count, Counter::kIsRate)}});
 }
 
-BENCHMARK_REGISTER_F(MixtureBenchmark, Mixture)->Threads(10)->Arg(4 * 10000);
+BENCHMARK_REGISTER_F(MixtureBenchmark, Mixture)->Threads(10)->ArgNames({"count", "frame_shards"})
+    ->Args({4 * 10000, 1})
+    ->Args({4 * 10000, BPFrameManager::DEFAULT_SHARD_NUM});
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,146 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/lang/stdexcept.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/vacuous_log_handler.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 测试检查点刷新脏页(flush_all_pages)的吞吐量
+ * @details 所有页面都在内存中，每次迭代把一部分页面标记为脏页，然后全部刷新到磁盘。
+ * 参数 dirty_stride 表示每隔几个页面有一个脏页：为1时所有脏页都是相邻的，可以合并成少量的
+ * pwritev 调用；为2时没有相邻的脏页，每个页面单独写一次，相当于没有合并写入时的表现。
+ * 参数 dblwr 表示是否经过 double write buffer。
+ */
+class FlushBenchmark : public Fixture
+{
+public:
+  static constexpr int FILE_PAGE_NUM = 1024;
+  static constexpr int FRAME_NUM     = (FILE_PAGE_NUM / DEFAULT_ITEM_NUM_PER_POOL + 1) * DEFAULT_ITEM_NUM_PER_POOL;
+
+  string file_name() const { return "flush.bp"; }
+  string dblwr_file_name() const { return "flush.dblwr"; }
+
+  void SetUp(const State &state) override
+  {
+    LoggerFactory::init_default("flush.log", LOG_LEVEL_INFO);
+
+    ::remove(file_name().c_str());
+    ::remove(dblwr_file_name().c_str());
+
+    bpm_ = make_unique<BufferPoolManager>(FRAME_NUM * BP_PAGE_SIZE);
+    unique_ptr<DoubleWriteBuffer> dblwr_buffer;
+    if (state.range(1) != 0) {
+      auto disk_dblwr_buffer = make_unique<DiskDoubleWriteBuffer>(*bpm_);
+      RC   rc                = disk_dblwr_buffer->open_file(dblwr_file_name().c_str());
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to open double write buffer file. rc=%s", strrc(rc));
+        throw runtime_error("failed to open double write buffer file");
+      }
+      dblwr_buffer = std::move(disk_dblwr_buffer);
+    } else {
+      dblwr_buffer = make_unique<VacuousDoubleWriteBuffer>();
+    }
+    bpm_->init(std::move(dblwr_buffer));
+
+    RC rc = bpm_->create_file(file_name().c_str());
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to create buffer pool file. filename=%s, rc=%s", file_name().c_str(), strrc(rc));
+      throw runtime_error("failed to create buffer pool file");
+    }
+
+    rc = bpm_->open_file(log_handler_, file_name().c_str(), buffer_pool_);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to open buffer pool file. filename=%s, rc=%s", file_name().c_str(), strrc(rc));
+      throw runtime_error("failed to open buffer pool file");
+    }
+
+    // 第0个页面是文件头，已经分配过了
+    frames_.clear();
+    for (int i = 1; i < FILE_PAGE_NUM; i++) {
+      Frame *frame = nullptr;
+      rc           = buffer_pool_->allocate_page(&frame);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to allocate page. rc=%s", strrc(rc));
+        throw runtime_error("failed to allocate page");
+      }
+      frames_.push_back(frame);
+    }
+    buffer_pool_->flush_all_pages();
+  }
+
+  void TearDown(const State &state) override
+  {
+    for (Frame *frame : frames_) {
+      buffer_pool_->unpin_page(frame);
+    }
+    frames_.clear();
+
+    buffer_pool_->close_file();
+    bpm_->close_file(file_name().c_str());
+    buffer_pool_ = nullptr;
+    bpm_.reset();
+    ::remove(file_name().c_str());
+    ::remove(dblwr_file_name().c_str());
+  }
+
+  int MarkDirty(int stride)
+  {
+    int count = 0;
+    for (size_t i = 0; i < frames_.size(); i += stride) {
+      frames_[i]->mark_dirty();
+      count++;
+    }
+    return count;
+  }
+
+protected:
+  unique_ptr<BufferPoolManager> bpm_;
+  DiskBufferPool               *buffer_pool_ = nullptr;
+  VacuousLogHandler             log_handler_;
+  vector<Frame *>               frames_;
+};
+
+BENCHMARK_DEFINE_F(FlushBenchmark, FlushAllPages)(State &state)
+{
+  const int stride        = static_cast<int>(state.range(0));
+  int64_t   flushed_pages = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    flushed_pages += MarkDirty(stride);
+    state.ResumeTiming();
+
+    RC rc = buffer_pool_->flush_all_pages();
+    if (OB_FAIL(rc)) {
+      state.SkipWithError("failed to flush all pages");
+      break;
+    }
+  }
+
+  state.SetItemsProcessed(flushed_pages);
+  state.SetBytesProcessed(flushed_pages * BP_PAGE_SIZE);
+}
+
+BENCHMARK_REGISTER_F(FlushBenchmark, FlushAllPages)
+    ->ArgNames({"dirty_stride", "dblwr"})
+    ->Args({1, 0})
+    ->Args({2, 0})
+    ->Args({1, 1})
+    ->Args({2, 1});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,145 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common/lang/stdexcept.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/vacuous_log_handler.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 测试冷数据全文件扫描的吞吐量
+ * @details 每次迭代前关闭文件并让操作系统丢弃文件缓存，然后使用 BufferPoolIterator 遍历所有页面。
+ * 参数 read_ahead 是每次预读的页面个数，0表示不预读；参数 uring 表示是否使用 io_uring。
+ */
+class ReadAheadBenchmark : public Fixture
+{
+public:
+  static constexpr int FILE_PAGE_NUM = 4096;
+
+  string file_name() const { return "read_ahead.bp"; }
+
+  void SetUp(const State &state) override
+  {
+    LoggerFactory::init_default("read_ahead.log", LOG_LEVEL_INFO);
+
+    ::remove(file_name().c_str());
+    bpm_ = make_unique<BufferPoolManager>();
+    bpm_->init(make_unique<VacuousDoubleWriteBuffer>());
+    bpm_->init_io_engine(state.range(1) != 0 ? "uring" : "sync", 64);
+    bpm_->set_read_ahead_pages(static_cast<int>(state.range(0)));
+
+    RC rc = bpm_->create_file(file_name().c_str());
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to create buffer pool file. filename=%s, rc=%s", file_name().c_str(), strrc(rc));
+      throw runtime_error("failed to create buffer pool file");
+    }
+
+    DiskBufferPool *buffer_pool = nullptr;
+    rc                          = bpm_->open_file(log_handler_, file_name().c_str(), buffer_pool);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to open buffer pool file. filename=%s, rc=%s", file_name().c_str(), strrc(rc));
+      throw runtime_error("failed to open buffer pool file");
+    }
+
+    // 第0个页面是文件头，已经分配过了
+    for (int i = 1; i < FILE_PAGE_NUM; i++) {
+      Frame *frame = nullptr;
+      rc           = buffer_pool->allocate_page(&frame);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to allocate page. rc=%s", strrc(rc));
+        throw runtime_error("failed to allocate page");
+      }
+      frame->mark_dirty();
+      buffer_pool->unpin_page(frame);
+    }
+    bpm_->close_file(file_name().c_str());
+  }
+
+  void TearDown(const State &state) override
+  {
+    bpm_.reset();
+    ::remove(file_name().c_str());
+  }
+
+  /**
+   * @brief 让操作系统丢弃文件缓存，下次读取时需要访问磁盘
+   */
+  void DropFileCache()
+  {
+    int fd = ::open(file_name().c_str(), O_RDONLY);
+    if (fd >= 0) {
+      ::fdatasync(fd);
+      ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      ::close(fd);
+    }
+  }
+
+protected:
+  unique_ptr<BufferPoolManager> bpm_;
+  VacuousLogHandler             log_handler_;
+};
+
+BENCHMARK_DEFINE_F(ReadAheadBenchmark, ColdScan)(State &state)
+{
+  int64_t scanned_pages = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    DropFileCache();
+    DiskBufferPool *buffer_pool = nullptr;
+    RC              rc          = bpm_->open_file(log_handler_, file_name().c_str(), buffer_pool);
+    if (OB_FAIL(rc)) {
+      state.SkipWithError("failed to open buffer pool file");
+      break;
+    }
+    state.ResumeTiming();
+
+    BufferPoolIterator iterator;
+    iterator.init(*buffer_pool, 1, true /*read_ahead*/);
+    while (iterator.has_next()) {
+      Frame *frame = nullptr;
+      rc           = buffer_pool->get_this_page(iterator.next(), &frame);
+      if (OB_FAIL(rc)) {
+        break;
+      }
+      buffer_pool->unpin_page(frame);
+      scanned_pages++;
+    }
+
+    state.PauseTiming();
+    bpm_->close_file(file_name().c_str());
+    state.ResumeTiming();
+
+    if (OB_FAIL(rc)) {
+      state.SkipWithError("failed to get page");
+      break;
+    }
+  }
+
+  state.SetItemsProcessed(scanned_pages);
+  state.SetBytesProcessed(scanned_pages * BP_PAGE_SIZE);
+}
+
+BENCHMARK_REGISTER_F(ReadAheadBenchmark, ColdScan)
+    ->ArgNames({"read_ahead", "uring"})
+    ->Args({0, 0})
+    ->Args({32, 0})
+    ->Args({32, 1})
+    ->Unit(kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,148 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/lang/stdexcept.h"
+#include "common/log/log.h"
+#include "common/math/integer_generator.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/vacuous_log_handler.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 测试不同的页帧置换策略在点查和全表扫描混合负载下的命中率
+ * @details 缓冲池可以容纳 FRAME_NUM 个页面，文件中有 FILE_PAGE_NUM 个页面。
+ * 大部分操作是在 HOT_PAGE_NUM 个热点页面上做点查，每隔 SCAN_INTERVAL 次操作做一次全文件扫描。
+ * 理想情况下，热点页面能一直留在内存中，扫描不会把它们淘汰出去。
+ */
+class ReplacerBenchmark : public Fixture
+{
+public:
+  static constexpr int FRAME_NUM     = 2 * DEFAULT_ITEM_NUM_PER_POOL;
+  static constexpr int FILE_PAGE_NUM = 4 * FRAME_NUM;
+  static constexpr int HOT_PAGE_NUM  = FRAME_NUM / 4;
+  static constexpr int SCAN_INTERVAL = 1000;
+
+  static const char *replacer_name(const State &state) { return state.range(0) == 0 ? "lru" : "2q"; }
+
+  string file_name() const { return "replacer.bp"; }
+
+  void SetUp(const State &state) override
+  {
+    LoggerFactory::init_default("replacer.log", LOG_LEVEL_INFO);
+
+    bpm_ = make_unique<BufferPoolManager>(
+        FRAME_NUM * BP_PAGE_SIZE, BPFrameManager::DEFAULT_SHARD_NUM, replacer_name(state));
+    bpm_->init(make_unique<VacuousDoubleWriteBuffer>());
+
+    ::remove(file_name().c_str());
+    RC rc = bpm_->create_file(file_name().c_str());
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to create buffer pool file. filename=%s, rc=%s", file_name().c_str(), strrc(rc));
+      throw runtime_error("failed to create buffer pool file");
+    }
+
+    rc = bpm_->open_file(log_handler_, file_name().c_str(), buffer_pool_);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to open buffer pool file. filename=%s, rc=%s", file_name().c_str(), strrc(rc));
+      throw runtime_error("failed to open buffer pool file");
+    }
+
+    // 第0个页面是文件头，已经分配过了
+    for (int i = 1; i < FILE_PAGE_NUM; i++) {
+      Frame *frame = nullptr;
+      rc           = buffer_pool_->allocate_page(&frame);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to allocate page. rc=%s", strrc(rc));
+        throw runtime_error("failed to allocate page");
+      }
+      buffer_pool_->unpin_page(frame);
+    }
+  }
+
+  void TearDown(const State &state) override
+  {
+    buffer_pool_->close_file();
+    bpm_->close_file(file_name().c_str());
+    buffer_pool_ = nullptr;
+    bpm_.reset();
+    ::remove(file_name().c_str());
+  }
+
+  void Lookup(PageNum page_num)
+  {
+    Frame *frame = nullptr;
+    RC     rc    = buffer_pool_->get_this_page(page_num, &frame);
+    if (OB_SUCC(rc)) {
+      buffer_pool_->unpin_page(frame);
+    }
+  }
+
+  void Scan()
+  {
+    for (PageNum page_num = 1; page_num < FILE_PAGE_NUM; page_num++) {
+      Lookup(page_num);
+    }
+  }
+
+protected:
+  unique_ptr<BufferPoolManager> bpm_;
+  DiskBufferPool               *buffer_pool_ = nullptr;
+  VacuousLogHandler             log_handler_;
+};
+
+BENCHMARK_DEFINE_F(ReplacerBenchmark, MixedLookupAndScan)(State &state)
+{
+  IntegerGenerator generator(1, HOT_PAGE_NUM);
+  BPFrameManager  &frame_manager = bpm_->get_frame_manager();
+
+  const uint64_t hit_count_before  = frame_manager.hit_count();
+  const uint64_t miss_count_before = frame_manager.miss_count();
+
+  // 扫描的页面基本都不在内存中，单独统计点查的命中率才能看出置换策略的差别
+  uint64_t scan_hit_count  = 0;
+  uint64_t scan_miss_count = 0;
+  int64_t  scan_count      = 0;
+  int64_t  op_count        = 0;
+  for (auto _ : state) {
+    if (++op_count % SCAN_INTERVAL == 0) {
+      const uint64_t hit_count  = frame_manager.hit_count();
+      const uint64_t miss_count = frame_manager.miss_count();
+      Scan();
+      scan_hit_count += frame_manager.hit_count() - hit_count;
+      scan_miss_count += frame_manager.miss_count() - miss_count;
+      scan_count++;
+    } else {
+      Lookup(generator.next());
+    }
+  }
+
+  const uint64_t hit_count  = frame_manager.hit_count() - hit_count_before;
+  const uint64_t miss_count = frame_manager.miss_count() - miss_count_before;
+
+  const double lookup_hit_count  = static_cast<double>(hit_count - scan_hit_count);
+  const double lookup_miss_count = static_cast<double>(miss_count - scan_miss_count);
+  const double total_count       = static_cast<double>(hit_count + miss_count);
+
+  state.SetLabel(replacer_name(state));
+  state.counters["hit_ratio"] = Counter(total_count > 0 ? hit_count / total_count : 0);
+  state.counters["lookup_hit_ratio"] =
+      Counter(lookup_hit_count + lookup_miss_count > 0 ? lookup_hit_count / (lookup_hit_count + lookup_miss_count) : 0);
+  state.counters["scans"] = Counter(scan_count);
+}
+
+BENCHMARK_REGISTER_F(ReplacerBenchmark, MixedLookupAndScan)->ArgNames({"replacer"})->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
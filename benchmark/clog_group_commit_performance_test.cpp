@@ -0,0 +1,108 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/lang/chrono.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/stdexcept.h"
+#include "common/log/log.h"
+#include "storage/clog/disk_log_handler.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 测试提交事务时写日志的延迟和吞吐量
+ * @details 每次迭代模拟一次事务提交：追加一条提交日志，然后等待这条日志刷到磁盘上。
+ * 多个线程并发提交时，刷新线程会把它们的日志合并成一组，只写一次文件、刷一次盘。
+ * items_per_second 就是每秒提交的事务数，latency_us 是平均每次提交的延迟。
+ * 参数 payload 是每条日志的大小。
+ */
+class GroupCommitBenchmark : public Fixture
+{
+public:
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    LoggerFactory::init_default("clog_group_commit.log", LOG_LEVEL_INFO);
+
+    filesystem::remove_all(directory_);
+    log_handler_ = make_unique<DiskLogHandler>();
+    RC rc        = log_handler_->init(directory_.c_str());
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to init log handler. rc=%s", strrc(rc));
+      throw runtime_error("failed to init log handler");
+    }
+
+    rc = log_handler_->start();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to start log handler. rc=%s", strrc(rc));
+      throw runtime_error("failed to start log handler");
+    }
+  }
+
+  void TearDown(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    log_handler_->stop();
+    log_handler_->await_termination();
+    log_handler_.reset();
+    filesystem::remove_all(directory_);
+  }
+
+protected:
+  string                     directory_ = "clog_group_commit";
+  unique_ptr<DiskLogHandler> log_handler_;
+};
+
+BENCHMARK_DEFINE_F(GroupCommitBenchmark, Commit)(State &state)
+{
+  const int payload_size = static_cast<int>(state.range(0));
+
+  chrono::nanoseconds total_latency{0};
+  for (auto _ : state) {
+    const auto begin = chrono::steady_clock::now();
+
+    LSN lsn = 0;
+    RC  rc  = log_handler_->append(lsn, LogModule::Id::TRANSACTION, vector<char>(payload_size, 'a'));
+    if (OB_SUCC(rc)) {
+      rc = log_handler_->wait_lsn(lsn);
+    }
+    if (OB_FAIL(rc)) {
+      state.SkipWithError("failed to commit");
+      break;
+    }
+
+    total_latency += chrono::steady_clock::now() - begin;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  if (state.iterations() > 0) {
+    const double latency_us = chrono::duration<double, micro>(total_latency).count() / state.iterations();
+    state.counters["latency_us"] = Counter(latency_us, Counter::kAvgThreads);
+  }
+}
+
+BENCHMARK_REGISTER_F(GroupCommitBenchmark, Commit)
+    ->ArgName("payload")
+    ->Arg(64)
+    ->Arg(1024)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,160 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/conf/ini.h"
+#include "common/ini_setting.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/stdexcept.h"
+#include "common/log/log.h"
+#include "common/value.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/db/db.h"
+#include "storage/table/table.h"
+#include "storage/trx/trx.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 测试崩溃恢复的时间
+ * @details 先准备一个数据库：建几张表，插入一些数据，等日志都落盘之后，在页面还没有刷到磁盘时把文件复制一份，
+ * 相当于在这个时刻崩溃了。每次迭代都从这份文件启动数据库，计时的部分就是回放日志的时间。
+ * 参数 threads 是回放日志的线程数，参考 CLOG_REPLAY_THREADS 配置项。
+ */
+class ReplayBenchmark : public Fixture
+{
+public:
+  static constexpr int TABLE_NUM       = 8;
+  static constexpr int FIELD_NUM       = 8;
+  static constexpr int RECORD_NUM      = 20000;  /// 每张表的记录数
+  static constexpr int RECORDS_PER_TRX = 100;
+
+  void SetUp(const State &state) override
+  {
+    LoggerFactory::init_default("clog_replay.log", LOG_LEVEL_INFO);
+
+    // 不在后台刷脏页，让所有的修改都需要通过日志恢复
+    get_properties()->put(BUFFER_POOL_CLEANER_THREADS, "0", STORAGE);
+
+    if (!filesystem::exists(crash_path_)) {
+      prepare();
+    }
+  }
+
+  void TearDown(const State &state) override
+  {
+    get_properties()->put(CLOG_REPLAY_THREADS, CLOG_REPLAY_THREADS_DEFAULT, STORAGE);
+    filesystem::remove_all(recover_path_);
+  }
+
+  /**
+   * @brief 从崩溃时的文件恢复数据库
+   */
+  void recover(State &state, int thread_num)
+  {
+    state.PauseTiming();
+    filesystem::remove_all(recover_path_);
+    filesystem::copy(crash_path_, recover_path_, filesystem::copy_options::recursive);
+    get_properties()->put(CLOG_REPLAY_THREADS, to_string(thread_num), STORAGE);
+    state.ResumeTiming();
+
+    auto db = make_unique<Db>();
+    RC   rc = db->init("recover_db", recover_path_.c_str(), "mvcc", "disk");
+    if (OB_FAIL(rc)) {
+      state.SkipWithError("failed to recover db");
+    }
+
+    state.PauseTiming();
+    db.reset();
+    state.ResumeTiming();
+  }
+
+private:
+  void prepare()
+  {
+    const filesystem::path db_path = directory_ / "db";
+    filesystem::remove_all(directory_);
+    filesystem::create_directories(db_path);
+
+    auto db = make_unique<Db>();
+    RC   rc = db->init("db", db_path.c_str(), "mvcc", "disk");
+    if (OB_FAIL(rc)) {
+      throw runtime_error("failed to init db");
+    }
+
+    vector<AttrInfoSqlNode> attr_infos(FIELD_NUM);
+    for (int i = 0; i < FIELD_NUM; i++) {
+      attr_infos[i].name   = "field_" + to_string(i);
+      attr_infos[i].type   = AttrType::INTS;
+      attr_infos[i].length = 4;
+    }
+
+    vector<Table *> tables;
+    for (int i = 0; i < TABLE_NUM; i++) {
+      const string table_name = "table_" + to_string(i);
+      if (OB_FAIL(db->create_table(table_name.c_str(), attr_infos, {})) || OB_FAIL(db->sync())) {
+        throw runtime_error("failed to create table");
+      }
+      tables.push_back(db->find_table(table_name.c_str()));
+    }
+
+    vector<Value> values(FIELD_NUM);
+    for (int i = 0; i < RECORD_NUM; i += RECORDS_PER_TRX) {
+      Trx *trx = db->trx_kit().create_trx(db->log_handler());
+      trx->start_if_need();
+      for (int j = i; j < i + RECORDS_PER_TRX; j++) {
+        for (Value &value : values) {
+          value.set_int(j);
+        }
+        for (Table *table : tables) {
+          Record record;
+          if (OB_FAIL(table->make_record(FIELD_NUM, values.data(), record)) ||
+              OB_FAIL(trx->insert_record(table, record))) {
+            throw runtime_error("failed to insert record");
+          }
+        }
+      }
+      if (OB_FAIL(trx->commit())) {
+        throw runtime_error("failed to commit");
+      }
+      db->trx_kit().destroy_trx(trx);
+    }
+
+    DiskLogHandler &log_handler = static_cast<DiskLogHandler &>(db->log_handler());
+    log_handler.wait_lsn(log_handler.current_lsn());
+    filesystem::copy(db_path, crash_path_, filesystem::copy_options::recursive);
+    LOG_INFO("prepare crashed db done. lsn=%ld", log_handler.current_lsn());
+  }
+
+protected:
+  filesystem::path directory_    = "clog_replay";
+  filesystem::path crash_path_   = directory_ / "crash";
+  filesystem::path recover_path_ = directory_ / "recover";
+};
+
+BENCHMARK_DEFINE_F(ReplayBenchmark, Recover)(State &state)
+{
+  for (auto _ : state) {
+    recover(state, static_cast<int>(state.range(0)));
+  }
+}
+
+BENCHMARK_REGISTER_F(ReplayBenchmark, Recover)
+    ->ArgName("threads")
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->Unit(kMillisecond)
+    ->Iterations(3);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,95 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/lang/limits.h"
+#include "common/lang/random.h"
+#include "common/lang/vector.h"
+#include "sql/expr/join_hash_table.h"
+
+/**
+ * @brief 测试 hash join 构建侧哈希表的构建和探测性能
+ * @details range(0) 是构建侧的行数，range(1) 表示是否按照L2缓存大小分区。
+ * 探测的哈希值一半能在构建侧找到，一半找不到。
+ */
+class JoinHashTableBenchmark : public benchmark::Fixture
+{
+public:
+  static constexpr int PROBE_ROWS = 4096;
+
+  void SetUp(const ::benchmark::State &state) override
+  {
+    mt19937 random(0);
+    auto    random_hash = [&random]() { return (static_cast<uint64_t>(random()) << 32) | random(); };
+    build_hashes_.resize(state.range(0));
+    for (uint64_t &hash : build_hashes_) {
+      hash = random_hash();
+    }
+
+    probe_hashes_.resize(PROBE_ROWS);
+    for (int i = 0; i < PROBE_ROWS; i++) {
+      probe_hashes_[i] = i % 2 == 0 ? build_hashes_[random() % build_hashes_.size()] : random_hash();
+    }
+    heads_.resize(PROBE_ROWS);
+  }
+
+  void TearDown(const ::benchmark::State &state) override
+  {
+    hash_table_.reset();
+    build_hashes_.clear();
+    probe_hashes_.clear();
+  }
+
+  size_t partition_threshold(const ::benchmark::State &state) const
+  {
+    return state.range(1) != 0 ? JoinHashTable::default_partition_threshold() : numeric_limits<size_t>::max();
+  }
+
+  void build(const ::benchmark::State &state)
+  {
+    hash_table_.reset();
+    for (uint64_t hash : build_hashes_) {
+      hash_table_.add(hash);
+    }
+    hash_table_.build(partition_threshold(state));
+  }
+
+protected:
+  vector<uint64_t> build_hashes_;
+  vector<uint64_t> probe_hashes_;
+  vector<uint32_t> heads_;
+  JoinHashTable    hash_table_;
+};
+
+BENCHMARK_DEFINE_F(JoinHashTableBenchmark, Build)(benchmark::State &state)
+{
+  for (auto _ : state) {
+    build(state);
+  }
+  state.SetItemsProcessed(state.iterations() * build_hashes_.size());
+}
+
+BENCHMARK_DEFINE_F(JoinHashTableBenchmark, Probe)(benchmark::State &state)
+{
+  build(state);
+  state.counters["partitions"] = hash_table_.partition_num();
+
+  for (auto _ : state) {
+    hash_table_.find_batch(probe_hashes_.data(), PROBE_ROWS, heads_.data());
+    benchmark::DoNotOptimize(heads_.data());
+  }
+  state.SetItemsProcessed(state.iterations() * PROBE_ROWS);
+}
+
+BENCHMARK_REGISTER_F(JoinHashTableBenchmark, Build)->ArgsProduct({{1 << 12, 1 << 16, 1 << 20, 1 << 22}, {0, 1}});
+BENCHMARK_REGISTER_F(JoinHashTableBenchmark, Probe)->ArgsProduct({{1 << 12, 1 << 16, 1 << 20, 1 << 22}, {0, 1}});
+
+BENCHMARK_MAIN();
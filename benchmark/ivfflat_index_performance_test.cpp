@@ -0,0 +1,167 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/lang/algorithm.h"
+#include "common/lang/memory.h"
+#include "common/lang/random.h"
+#include "common/lang/stdexcept.h"
+#include "common/lang/utility.h"
+#include "common/lang/vector.h"
+#include "common/log/log.h"
+#include "common/math/vector_distance.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/vacuous_log_handler.h"
+#include "storage/index/ivfflat_index.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 测试 ivfflat 索引在不同 probes 下的召回率和查询吞吐
+ * @details 数据围绕着若干个中心分布，与真实的 embedding 一样有聚类的特征。
+ * 索引只构建一次，每个测试用例使用不同的 probes 查询同一批向量，召回率(recall@10)通过 counter 输出，
+ * items_per_second 就是 QPS。参数 probes 与 lists 相同时就是精确查询。
+ */
+class IvfflatBenchmark : public Fixture
+{
+public:
+  static constexpr int DIMENSION  = 64;
+  static constexpr int VECTOR_NUM = 20000;
+  static constexpr int QUERY_NUM  = 200;
+  static constexpr int LISTS      = 128;
+  static constexpr int LIMIT      = 10;
+
+  void SetUp(const State &state) override
+  {
+    if (index_) {
+      return;
+    }
+
+    LoggerFactory::init_default("ivfflat_benchmark.log", LOG_LEVEL_INFO);
+
+    vectors_ = random_vectors(VECTOR_NUM, 1);
+    queries_ = random_vectors(QUERY_NUM, 2);
+
+    ::remove(file_name().c_str());
+    bpm_ = make_unique<BufferPoolManager>();
+    bpm_->init(make_unique<VacuousDoubleWriteBuffer>());
+
+    field_meta_ = FieldMeta("embedding", AttrType::VECTORS, 0, DIMENSION * sizeof(float), true, 0);
+    index_meta_.init("ivf", field_meta_);
+
+    index_ = make_unique<IvfflatIndex>();
+    index_->set_options(VectorDistanceType::L2, LISTS, 1);
+    RC rc = index_->create(log_handler_, *bpm_, file_name().c_str(), index_meta_, {field_meta_});
+    if (OB_SUCC(rc)) {
+      rc = index_->train(vectors_.data(), VECTOR_NUM);
+    }
+    for (int i = 0; OB_SUCC(rc) && i < VECTOR_NUM; i++) {
+      RID rid(i / 100, i % 100);
+      rc = index_->insert_entry(reinterpret_cast<const char *>(vectors_.data() + i * DIMENSION), &rid);
+    }
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to build ivfflat index. rc=%s", strrc(rc));
+      throw runtime_error("failed to build ivfflat index");
+    }
+
+    // 暴力计算出每个查询真正最近的向量，用于计算召回率
+    ground_truth_.resize(QUERY_NUM);
+    for (int q = 0; q < QUERY_NUM; q++) {
+      vector<pair<float, int>> distances(VECTOR_NUM);
+      for (int i = 0; i < VECTOR_NUM; i++) {
+        distances[i] = {l2_distance(queries_.data() + q * DIMENSION, vectors_.data() + i * DIMENSION, DIMENSION), i};
+      }
+      partial_sort(distances.begin(), distances.begin() + LIMIT, distances.end());
+      for (int i = 0; i < LIMIT; i++) {
+        ground_truth_[q].emplace_back(distances[i].second / 100, distances[i].second % 100);
+      }
+    }
+  }
+
+  void TearDown(const State &state) override {}
+
+  static string file_name() { return "ivfflat_benchmark.index"; }
+
+  static vector<float> random_vectors(int num, unsigned seed)
+  {
+    mt19937                    random(1024);
+    normal_distribution<float> distribution(0.0f, 1.0f);
+    vector<float>              centers(256 * DIMENSION);
+    for (float &value : centers) {
+      value = distribution(random);
+    }
+
+    random.seed(seed);
+    uniform_int_distribution<int> center_distribution(0, 255);
+    vector<float>                 vectors(static_cast<size_t>(num) * DIMENSION);
+    for (int i = 0; i < num; i++) {
+      const float *center = centers.data() + center_distribution(random) * DIMENSION;
+      for (int d = 0; d < DIMENSION; d++) {
+        vectors[static_cast<size_t>(i) * DIMENSION + d] = center[d] + distribution(random);
+      }
+    }
+    return vectors;
+  }
+
+protected:
+  static inline unique_ptr<BufferPoolManager> bpm_;
+  static inline VacuousLogHandler             log_handler_;
+  static inline FieldMeta                     field_meta_;
+  static inline IndexMeta                     index_meta_;
+  static inline unique_ptr<IvfflatIndex>      index_;
+  static inline vector<float>                 vectors_;
+  static inline vector<float>                 queries_;
+  static inline vector<vector<RID>>           ground_truth_;
+};
+
+BENCHMARK_DEFINE_F(IvfflatBenchmark, Search)(State &state)
+{
+  const int probes  = static_cast<int>(state.range(0));
+  int64_t   queries = 0;
+
+  vector<RID> rids;
+  for (auto _ : state) {
+    const int q  = static_cast<int>(queries % QUERY_NUM);
+    RC        rc = index_->ann_search(queries_.data() + q * DIMENSION, LIMIT, probes, rids);
+    if (OB_FAIL(rc)) {
+      state.SkipWithError("failed to search");
+      break;
+    }
+    queries++;
+  }
+  state.SetItemsProcessed(queries);
+
+  // 召回率不计入查询时间
+  int64_t hits = 0;
+  for (int q = 0; q < QUERY_NUM; q++) {
+    index_->ann_search(queries_.data() + q * DIMENSION, LIMIT, probes, rids);
+    for (const RID &rid : rids) {
+      hits += count(ground_truth_[q].begin(), ground_truth_[q].end(), rid);
+    }
+  }
+  state.counters["recall"] = static_cast<double>(hits) / (QUERY_NUM * LIMIT);
+}
+
+BENCHMARK_REGISTER_F(IvfflatBenchmark, Search)
+    ->ArgName("probes")
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(IvfflatBenchmark::LISTS)
+    ->Unit(kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -85,7 +85,9 @@ public:
       return;
     }
 
-    bpm_.init(make_unique<VacuousDoubleWriteBuffer>());
+    // 第二个参数是页帧表的分片个数，分片个数为1时相当于不分片的实现
+    bpm_ = make_unique<BufferPoolManager>(512, static_cast<int>(state.range(1)));
+    bpm_->init(make_unique<VacuousDoubleWriteBuffer>());
 
     string log_name        = this->Name() + ".log";
     string record_filename = this->record_filename();
@@ -93,13 +95,13 @@ public:
 
     ::remove(record_filename.c_str());
 
-    RC rc = bpm_.create_file(record_filename.c_str());
+    RC rc = bpm_->create_file(record_filename.c_str());
     if (rc != RC::SUCCESS) {
       LOG_WARN("failed to create record buffer pool file. filename=%s, rc=%s", record_filename.c_str(), strrc(rc));
       throw runtime_error("failed to create record buffer pool file.");
     }
 
-    rc = bpm_.open_file(log_handler_, record_filename.c_str(), buffer_pool_);
+    rc = bpm_->open_file(log_handler_, record_filename.c_str(), buffer_pool_);
     if (rc != RC::SUCCESS) {
       LOG_WARN("failed to open record file. filename=%s, rc=%s", record_filename.c_str(), strrc(rc));
       throw runtime_error("failed to open record file");
@@ -127,8 +129,9 @@ public:
     // TODO 很怪，引入double write buffer后，必须要求先close buffer pool，再执行bpm.close_file。
     // 以后必须修理好bpm、buffer pool、double write buffer之间的关系
     buffer_pool_->close_file();
-    bpm_.close_file(this->record_filename().c_str());
+    bpm_->close_file(this->record_filename().c_str());
     buffer_pool_ = nullptr;
+    bpm_.reset();
     LOG_INFO("test %s teardown done. threads=%d, thread index=%d",
         this->Name().c_str(),
         state.threads(),
@@ -230,7 +233,7 @@ public:
   }
 
 protected:
-  BufferPoolManager  bpm_{512};
+  unique_ptr<BufferPoolManager> bpm_;
   DiskBufferPool    *buffer_pool_ = nullptr;
   RecordFileHandler *handler_;
   VacuousLogHandler  log_handler_;
@@ -257,7 +260,9 @@ BENCHMARK_DEFINE_F(InsertionBenchmark, Insertion)(State &state)
   state.counters["other"]   = Counter(stat.insert_other_count, Counter::kIsRate);
 }
 
-BENCHMARK_REGISTER_F(InsertionBenchmark, Insertion)->Threads(10);
+BENCHMARK_REGISTER_F(InsertionBenchmark, Insertion)->Threads(10)->ArgNames({"count", "frame_shards"})
+    ->Args({0, 1})
+    ->Args({0, BPFrameManager::DEFAULT_SHARD_NUM});
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -308,7 +313,9 @@ BENCHMARK_DEFINE_F(DeletionBenchmark, Deletion)(State &state)
   state.counters["other"]     = Counter(stat.delete_other_count, Counter::kIsRate);
 }
 
-BENCHMARK_REGISTER_F(DeletionBenchmark, Deletion)->Threads(10)->Arg(4 * 10000);
+BENCHMARK_REGISTER_F(DeletionBenchmark, Deletion)->Threads(10)->ArgNames({"count", "frame_shards"})
+    ->Args({4 * 10000, 1})
+    ->Args({4 * 10000, BPFrameManager::DEFAULT_SHARD_NUM});
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -352,7 +359,9 @@ BENCHMARK_DEFINE_F(ScanBenchmark, Scan)(State &state)
   state.counters["other"]                 = Counter(stat.scan_other_count, Counter::kIsRate);
 }
 
-BENCHMARK_REGISTER_F(ScanBenchmark, Scan)->Threads(10)->Arg(4 * 10000);
+BENCHMARK_REGISTER_F(ScanBenchmark, Scan)->Threads(10)->ArgNames({"count", "frame_shards"})
+    ->Args({4 * 10000, 1})
+    ->Args({4 * 10000, BPFrameManager::DEFAULT_SHARD_NUM});
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -415,7 +424,9 @@ BENCHMARK_DEFINE_F(MixtureBenchmark, Mixture)(State &state)
       {"scan_open_failed", Counter(stat.scan_open_failed_count, Counter::kIsRate)}});
 }
 
-BENCHMARK_REGISTER_F(MixtureBenchmark, Mixture)->Threads(10)->Arg(4 * 10000);
+BENCHMARK_REGISTER_F(MixtureBenchmark, Mixture)->Threads(10)->ArgNames({"count", "frame_shards"})
+    ->Args({4 * 10000, 1})
+    ->Args({4 * 10000, BPFrameManager::DEFAULT_SHARD_NUM});
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,82 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/lang/vector.h"
+#include "common/log/log.h"
+#include "storage/clog/vacuous_log_handler.h"
+#include "storage/trx/mvcc_trx.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 所有线程共享的事务模块
+ * @details 多个测试线程之间没有同步，使用函数内的静态变量保证只初始化一次
+ */
+MvccTrxKit &trx_kit()
+{
+  static MvccTrxKit *trx_kit = []() {
+    LoggerFactory::init_default("trx_kit_benchmark.log", LOG_LEVEL_WARN);
+    MvccTrxKit *kit = new MvccTrxKit();
+    kit->init();
+    return kit;
+  }();
+  return *trx_kit;
+}
+
+VacuousLogHandler log_handler;
+
+/**
+ * @brief 测试 MVCC 事务的创建、开始、提交和销毁的吞吐
+ * @details 模拟大量的自动提交语句，每条语句都会创建并销毁一个事务。需要使用 CONCURRENCY 模式编译
+ */
+static void BeginCommit(State &state)
+{
+  MvccTrxKit &kit = trx_kit();
+  for (auto _ : state) {
+    Trx *trx = kit.create_trx(log_handler);
+    trx->start_if_need();
+    trx->commit();
+    kit.destroy_trx(trx);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BeginCommit)->ThreadRange(1, 16)->UseRealTime();
+
+/**
+ * @brief 有 active_trx_num 个活跃事务时，计算最小活跃事务ID的耗时
+ */
+static void MinActiveTrxId(State &state)
+{
+  MvccTrxKit   &kit = trx_kit();
+  vector<Trx *> trxes;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    Trx *trx = kit.create_trx(log_handler);
+    trx->start_if_need();
+    trxes.push_back(trx);
+  }
+
+  for (auto _ : state) {
+    DoNotOptimize(kit.min_active_trx_id());
+  }
+
+  for (Trx *trx : trxes) {
+    trx->rollback();
+    kit.destroy_trx(trx);
+  }
+}
+
+BENCHMARK(MinActiveTrxId)->ArgName("active_trx_num")->Arg(0)->Arg(64)->Arg(1024);
+
+BENCHMARK_MAIN();
@@ -14,12 +14,14 @@ See the Mulan PSL v2 for more details. */
 
 #include <dirent.h>
 #include <iostream>
+#include <limits.h>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include "common/io/io.h"
+#include "common/lang/algorithm.h"
 #include "common/lang/string.h"
 #include "common/log/log.h"
 #include "common/math/regex.h"
@@ -386,4 +388,111 @@ int readn(int fd, void *buf, int size)
   }
   return 0;
 }
+
+int pwriten(int fd, const void *buf, int size, off_t offset)
+{
+  const char *tmp = (const char *)buf;
+  while (size > 0) {
+    const ssize_t ret = ::pwrite(fd, tmp, size, offset);
+    if (ret >= 0) {
+      tmp += ret;
+      size -= ret;
+      offset += ret;
+      continue;
+    }
+    const int err = errno;
+    if (EAGAIN != err && EINTR != err)
+      return err;
+  }
+  return 0;
+}
+
+int preadn(int fd, void *buf, int size, off_t offset)
+{
+  char *tmp = (char *)buf;
+  while (size > 0) {
+    const ssize_t ret = ::pread(fd, tmp, size, offset);
+    if (ret > 0) {
+      tmp += ret;
+      size -= ret;
+      offset += ret;
+      continue;
+    }
+    if (0 == ret)
+      return -1;  // end of file
+
+    const int err = errno;
+    if (EAGAIN != err && EINTR != err)
+      return err;
+  }
+  return 0;
+}
+
+/**
+ * @brief 跳过已经处理完的数据
+ * @details 把已经完整处理的段跳过，部分处理的段调整起始地址和长度
+ */
+static void advance_iovec(struct iovec *&iov, int &iovcnt, size_t done)
+{
+  while (iovcnt > 0 && done >= iov->iov_len) {
+    done -= iov->iov_len;
+    iov++;
+    iovcnt--;
+  }
+
+  if (iovcnt > 0) {
+    iov->iov_base = (char *)iov->iov_base + done;
+    iov->iov_len -= done;
+  }
+}
+
+int writevn(int fd, struct iovec *iov, int iovcnt)
+{
+  while (iovcnt > 0) {
+    const ssize_t ret = ::writev(fd, iov, min(iovcnt, IOV_MAX));
+    if (ret >= 0) {
+      advance_iovec(iov, iovcnt, ret);
+      continue;
+    }
+    const int err = errno;
+    if (EAGAIN != err && EINTR != err)
+      return err;
+  }
+  return 0;
+}
+
+int pwritevn(int fd, struct iovec *iov, int iovcnt, off_t offset)
+{
+  while (iovcnt > 0) {
+    const ssize_t ret = ::pwritev(fd, iov, min(iovcnt, IOV_MAX), offset);
+    if (ret >= 0) {
+      offset += ret;
+      advance_iovec(iov, iovcnt, ret);
+      continue;
+    }
+    const int err = errno;
+    if (EAGAIN != err && EINTR != err)
+      return err;
+  }
+  return 0;
+}
+
+int preadvn(int fd, struct iovec *iov, int iovcnt, off_t offset)
+{
+  while (iovcnt > 0) {
+    const ssize_t ret = ::preadv(fd, iov, min(iovcnt, IOV_MAX), offset);
+    if (ret > 0) {
+      offset += ret;
+      advance_iovec(iov, iovcnt, ret);
+      continue;
+    }
+    if (0 == ret)
+      return -1;  // end of file
+
+    const int err = errno;
+    if (EAGAIN != err && EINTR != err)
+      return err;
+  }
+  return 0;
+}
 }  // namespace common
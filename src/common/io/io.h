@@ -14,6 +14,8 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <sys/types.h>
+#include <sys/uio.h>
 #include <vector>
 
 #include "common/defs.h"
@@ -77,4 +79,40 @@ int writen(int fd, const void *buf, int size);
  */
 int readn(int fd, void *buf, int size);
 
+/**
+ * @brief 把多段内存中的数据一次性写入到文件当前位置
+ * @details 与 pwritevn 一样，出现部分写入时会继续写剩下的数据
+ * @param iov 调用过程中会被修改
+ * @return int 0 表示成功，否则返回errno
+ */
+int writevn(int fd, struct iovec *iov, int iovcnt);
+
+/**
+ * @brief 在指定偏移位置一次性写入所有指定数据，不会修改文件偏移量
+ * @details 多个线程可以同时使用同一个描述符写不同的位置，不需要加锁
+ * @return int 0 表示成功，否则返回errno
+ */
+int pwriten(int fd, const void *buf, int size, off_t offset);
+
+/**
+ * @brief 在指定偏移位置一次性读取指定长度的数据，不会修改文件偏移量
+ * @return int 返回0表示成功。-1 表示读取到文件尾，并且没有读到size大小数据，其它表示errno
+ */
+int preadn(int fd, void *buf, int size, off_t offset);
+
+/**
+ * @brief 把多段内存中的数据写入到文件中连续的位置
+ * @details 一次系统调用写入的段数不能超过IOV_MAX，这里会自动拆分。出现部分写入时会继续写剩下的数据。
+ * @param iov 调用过程中会被修改
+ * @return int 0 表示成功，否则返回errno
+ */
+int pwritevn(int fd, struct iovec *iov, int iovcnt, off_t offset);
+
+/**
+ * @brief 从文件中连续的位置读取数据到多段内存中
+ * @param iov 调用过程中会被修改
+ * @return int 返回0表示成功。-1 表示读取到文件尾，并且没有读满所有内存，其它表示errno
+ */
+int preadvn(int fd, struct iovec *iov, int iovcnt, off_t offset);
+
 }  // namespace common
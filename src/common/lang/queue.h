@@ -12,4 +12,5 @@ See the Mulan PSL v2 for more details. */
 
 #include <queue>
 
-using std::queue;
\ No newline at end of file
+using std::queue;
+using std::priority_queue;
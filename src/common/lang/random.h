@@ -14,4 +14,6 @@ See the Mulan PSL v2 for more details. */
 
 using std::mt19937;
 using std::random_device;
-using std::uniform_int_distribution;
\ No newline at end of file
+using std::normal_distribution;
+using std::uniform_int_distribution;
+using std::uniform_real_distribution;
\ No newline at end of file
@@ -0,0 +1,54 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief 64位整数的哈希函数，使用 MurmurHash3 的 fmix64
+ */
+inline uint64_t hash_mix64(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/**
+ * @brief 计算一段内存的哈希值。4字节的数据（整数、日期等）直接按照整数计算
+ */
+inline uint64_t hash_bytes(const char *data, int len)
+{
+  if (len == sizeof(uint32_t)) {
+    uint32_t value = 0;
+    memcpy(&value, data, sizeof(value));
+    return hash_mix64(value);
+  }
+
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < len; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash_mix64(hash ^ len);
+}
+
+/**
+ * @brief 把多个哈希值合并成一个，与 boost::hash_combine 相同
+ */
+inline uint64_t hash_combine(uint64_t seed, uint64_t hash)
+{
+  return seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
@@ -0,0 +1,185 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <math.h>
+#include <strings.h>
+
+#include "common/math/vector_distance.h"
+#include "common/math/simd_util.h"
+
+namespace common {
+
+const char *vector_distance_type_name(VectorDistanceType type)
+{
+  switch (type) {
+    case VectorDistanceType::L2: return "l2";
+    case VectorDistanceType::COSINE: return "cosine";
+    case VectorDistanceType::INNER_PRODUCT: return "inner_product";
+  }
+  return "unknown";
+}
+
+bool vector_distance_type_from_string(const char *name, VectorDistanceType &type)
+{
+  static constexpr VectorDistanceType types[] = {
+      VectorDistanceType::L2, VectorDistanceType::COSINE, VectorDistanceType::INNER_PRODUCT};
+  for (VectorDistanceType candidate : types) {
+    if (0 == strcasecmp(name, vector_distance_type_name(candidate))) {
+      type = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+#if defined(USE_SIMD)
+
+namespace {
+
+float mm256_reduce_add_ps(__m256 value)
+{
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+  sum        = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum        = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+  return _mm_cvtss_f32(sum);
+}
+
+}  // namespace
+
+// 每次处理两组8个float，使用两个累加器减少加法之间的依赖
+float l2_distance(const float *left, const float *right, int dim)
+{
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+
+  int i = 0;
+  for (; i + 2 * SIMD_WIDTH <= dim; i += 2 * SIMD_WIDTH) {
+    __m256 diff0 = _mm256_sub_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i));
+    __m256 diff1 = _mm256_sub_ps(_mm256_loadu_ps(left + i + SIMD_WIDTH), _mm256_loadu_ps(right + i + SIMD_WIDTH));
+    sum0         = _mm256_add_ps(sum0, _mm256_mul_ps(diff0, diff0));
+    sum1         = _mm256_add_ps(sum1, _mm256_mul_ps(diff1, diff1));
+  }
+  for (; i + SIMD_WIDTH <= dim; i += SIMD_WIDTH) {
+    __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i));
+    sum0        = _mm256_add_ps(sum0, _mm256_mul_ps(diff, diff));
+  }
+
+  float result = mm256_reduce_add_ps(_mm256_add_ps(sum0, sum1));
+  for (; i < dim; i++) {
+    const float diff = left[i] - right[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+float inner_product(const float *left, const float *right, int dim)
+{
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+
+  int i = 0;
+  for (; i + 2 * SIMD_WIDTH <= dim; i += 2 * SIMD_WIDTH) {
+    sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i)));
+    sum1 = _mm256_add_ps(
+        sum1, _mm256_mul_ps(_mm256_loadu_ps(left + i + SIMD_WIDTH), _mm256_loadu_ps(right + i + SIMD_WIDTH)));
+  }
+  for (; i + SIMD_WIDTH <= dim; i += SIMD_WIDTH) {
+    sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i)));
+  }
+
+  float result = mm256_reduce_add_ps(_mm256_add_ps(sum0, sum1));
+  for (; i < dim; i++) {
+    result += left[i] * right[i];
+  }
+  return result;
+}
+
+// 内积和两个向量的模在一次遍历中算出来
+float cosine_distance(const float *left, const float *right, int dim)
+{
+  __m256 dot        = _mm256_setzero_ps();
+  __m256 left_norm  = _mm256_setzero_ps();
+  __m256 right_norm = _mm256_setzero_ps();
+
+  int i = 0;
+  for (; i + SIMD_WIDTH <= dim; i += SIMD_WIDTH) {
+    __m256 l   = _mm256_loadu_ps(left + i);
+    __m256 r   = _mm256_loadu_ps(right + i);
+    dot        = _mm256_add_ps(dot, _mm256_mul_ps(l, r));
+    left_norm  = _mm256_add_ps(left_norm, _mm256_mul_ps(l, l));
+    right_norm = _mm256_add_ps(right_norm, _mm256_mul_ps(r, r));
+  }
+
+  float dot_sum   = mm256_reduce_add_ps(dot);
+  float left_sum  = mm256_reduce_add_ps(left_norm);
+  float right_sum = mm256_reduce_add_ps(right_norm);
+  for (; i < dim; i++) {
+    dot_sum += left[i] * right[i];
+    left_sum += left[i] * left[i];
+    right_sum += right[i] * right[i];
+  }
+
+  if (left_sum == 0 || right_sum == 0) {
+    return 1.0f;
+  }
+  return 1.0f - dot_sum / sqrtf(left_sum * right_sum);
+}
+
+#else  // USE_SIMD
+
+float l2_distance(const float *left, const float *right, int dim)
+{
+  float result = 0;
+  for (int i = 0; i < dim; i++) {
+    const float diff = left[i] - right[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+float inner_product(const float *left, const float *right, int dim)
+{
+  float result = 0;
+  for (int i = 0; i < dim; i++) {
+    result += left[i] * right[i];
+  }
+  return result;
+}
+
+float cosine_distance(const float *left, const float *right, int dim)
+{
+  float dot_sum   = 0;
+  float left_sum  = 0;
+  float right_sum = 0;
+  for (int i = 0; i < dim; i++) {
+    dot_sum += left[i] * right[i];
+    left_sum += left[i] * left[i];
+    right_sum += right[i] * right[i];
+  }
+
+  if (left_sum == 0 || right_sum == 0) {
+    return 1.0f;
+  }
+  return 1.0f - dot_sum / sqrtf(left_sum * right_sum);
+}
+
+#endif  // USE_SIMD
+
+float vector_distance(VectorDistanceType type, const float *left, const float *right, int dim)
+{
+  switch (type) {
+    case VectorDistanceType::L2: return l2_distance(left, right, dim);
+    case VectorDistanceType::COSINE: return cosine_distance(left, right, dim);
+    case VectorDistanceType::INNER_PRODUCT: return -inner_product(left, right, dim);
+  }
+  return 0;
+}
+
+}  // namespace common
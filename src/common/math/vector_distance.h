@@ -0,0 +1,48 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+namespace common {
+
+/**
+ * @brief 向量距离的计算方式
+ * @details 所有的距离都是越小越近
+ */
+enum class VectorDistanceType
+{
+  L2,             ///< 欧氏距离的平方
+  COSINE,         ///< 1 - 余弦相似度
+  INNER_PRODUCT,  ///< 内积的相反数
+};
+
+const char *vector_distance_type_name(VectorDistanceType type);
+
+/**
+ * @brief 按照名字(l2/cosine/inner_product，不区分大小写)解析距离的计算方式
+ */
+bool vector_distance_type_from_string(const char *name, VectorDistanceType &type);
+
+/**
+ * @brief 欧氏距离的平方
+ * @details 编译时打开 USE_SIMD 会使用 AVX2 指令，否则使用标量实现
+ */
+float l2_distance(const float *left, const float *right, int dim);
+
+/// 内积
+float inner_product(const float *left, const float *right, int dim);
+
+/// 1 - 余弦相似度。有一个向量全是0时返回1
+float cosine_distance(const float *left, const float *right, int dim);
+
+/// 按照 type 计算距离
+float vector_distance(VectorDistanceType type, const float *left, const float *right, int dim);
+
+}  // namespace common
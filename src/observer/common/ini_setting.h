@@ -25,3 +25,49 @@ See the Mulan PSL v2 for more details. */
 #define SOCKET_BUFFER_SIZE 8192
 
 #define SESSION_STAGE_NAME "SessionStage"
+
+// storage section
+#define STORAGE "STORAGE"
+// buffer pool frame replacement policy: lru or 2q
+#define BUFFER_POOL_REPLACER "BUFFER_POOL_REPLACER"
+#define BUFFER_POOL_REPLACER_DEFAULT "lru"
+// number of pages read ahead by sequential scans, 0 to disable
+#define BUFFER_POOL_READ_AHEAD_PAGES "BUFFER_POOL_READ_AHEAD_PAGES"
+#define BUFFER_POOL_READ_AHEAD_PAGES_DEFAULT "32"
+// number of background threads writing back dirty pages, 0 to disable. only takes effect with CONCURRENCY
+#define BUFFER_POOL_CLEANER_THREADS "BUFFER_POOL_CLEANER_THREADS"
+#define BUFFER_POOL_CLEANER_THREADS_DEFAULT "1"
+// background cleaners start writing back dirty pages when the dirty ratio(percent) passes the low watermark
+#define BUFFER_POOL_DIRTY_LOW_WATERMARK "BUFFER_POOL_DIRTY_LOW_WATERMARK"
+#define BUFFER_POOL_DIRTY_LOW_WATERMARK_DEFAULT "10"
+// background cleaners never sleep when the dirty ratio(percent) passes the high watermark
+#define BUFFER_POOL_DIRTY_HIGH_WATERMARK "BUFFER_POOL_DIRTY_HIGH_WATERMARK"
+#define BUFFER_POOL_DIRTY_HIGH_WATERMARK_DEFAULT "50"
+// number of threads replaying redo logs during recovery, 1 to replay in the current thread.
+// more than 1 thread only takes effect with CONCURRENCY
+#define CLOG_REPLAY_THREADS "CLOG_REPLAY_THREADS"
+#define CLOG_REPLAY_THREADS_DEFAULT "1"
+// buffer pool page io engine: uring or sync
+#define IO_ENGINE "IO_ENGINE"
+#define IO_ENGINE_DEFAULT "uring"
+// max number of in-flight io requests of async io engine
+#define IO_QUEUE_DEPTH "IO_QUEUE_DEPTH"
+#define IO_QUEUE_DEPTH_DEFAULT "64"
+// fill factor(percent) of the nodes built by bulk loading when creating an index on a populated table
+#define INDEX_BULK_LOAD_FILL_FACTOR "INDEX_BULK_LOAD_FILL_FACTOR"
+#define INDEX_BULK_LOAD_FILL_FACTOR_DEFAULT "90"
+// memory(MB) used to sort keys when bulk loading an index, sorted runs are spilled to disk beyond it
+#define INDEX_BULK_LOAD_SORT_BUFFER_MB "INDEX_BULK_LOAD_SORT_BUFFER_MB"
+#define INDEX_BULK_LOAD_SORT_BUFFER_MB_DEFAULT "64"
+// store the leaf pages of newly created indexes in the prefix/suffix compressed format, 1 to enable
+#define INDEX_LEAF_COMPRESSION "INDEX_LEAF_COMPRESSION"
+#define INDEX_LEAF_COMPRESSION_DEFAULT "0"
+// interval(ms) between two rounds of purging the records deleted by mvcc transactions, 0 to disable the vacuum thread
+#define MVCC_VACUUM_INTERVAL_MS "MVCC_VACUUM_INTERVAL_MS"
+#define MVCC_VACUUM_INTERVAL_MS_DEFAULT "1000"
+// max number of pages scanned by one round of vacuum
+#define MVCC_VACUUM_PAGES_PER_ROUND "MVCC_VACUUM_PAGES_PER_ROUND"
+#define MVCC_VACUUM_PAGES_PER_ROUND_DEFAULT "256"
+// max number of records purged by one round of vacuum
+#define MVCC_VACUUM_RECORDS_PER_ROUND "MVCC_VACUUM_RECORDS_PER_ROUND"
+#define MVCC_VACUUM_RECORDS_PER_ROUND_DEFAULT "4096"
@@ -0,0 +1,54 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "common/lang/comparator.h"
+#include "common/lang/sstream.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+#include "common/type/vector_type.h"
+#include "common/value.h"
+
+int VectorType::compare(const Value &left, const Value &right) const
+{
+  ASSERT(left.attr_type() == AttrType::VECTORS, "left type is not vector");
+  if (right.attr_type() != AttrType::VECTORS) {
+    return INT32_MAX;
+  }
+
+  const float *left_values  = reinterpret_cast<const float *>(left.data());
+  const float *right_values = reinterpret_cast<const float *>(right.data());
+  const int    left_dim     = left.length() / static_cast<int>(sizeof(float));
+  const int    right_dim    = right.length() / static_cast<int>(sizeof(float));
+  for (int i = 0; i < left_dim && i < right_dim; i++) {
+    int result = common::compare_float((void *)&left_values[i], (void *)&right_values[i]);
+    if (result != 0) {
+      return result;
+    }
+  }
+  return left_dim == right_dim ? 0 : (left_dim < right_dim ? -1 : 1);
+}
+
+RC VectorType::to_string(const Value &val, string &result) const
+{
+  const float *values = reinterpret_cast<const float *>(val.data());
+  const int    dim    = val.length() / static_cast<int>(sizeof(float));
+
+  stringstream ss;
+  ss << "[";
+  for (int i = 0; i < dim; i++) {
+    if (i > 0) {
+      ss << ",";
+    }
+    ss << common::double_to_str(values[i]);
+  }
+  ss << "]";
+  result = ss.str();
+  return RC::SUCCESS;
+}
@@ -15,6 +15,7 @@ See the Mulan PSL v2 for more details. */
 /**
  * @brief 向量类型
  * @ingroup DataType
+ * @details 值是连续存放的 float 数组，长度是数组的字节数。比较时按照元素逐个比较，前面的元素都相同时，维度小的更小。
  */
 class VectorType : public DataType
 {
@@ -22,11 +23,11 @@ public:
   VectorType() : DataType(AttrType::VECTORS) {}
   virtual ~VectorType() {}
 
-  int compare(const Value &left, const Value &right) const override { return INT32_MAX; }
+  int compare(const Value &left, const Value &right) const override;
 
   RC add(const Value &left, const Value &right, Value &result) const override { return RC::UNIMPLEMENTED; }
   RC subtract(const Value &left, const Value &right, Value &result) const override { return RC::UNIMPLEMENTED; }
   RC multiply(const Value &left, const Value &right, Value &result) const override { return RC::UNIMPLEMENTED; }
 
-  RC to_string(const Value &val, string &result) const override { return RC::UNIMPLEMENTED; }
+  RC to_string(const Value &val, string &result) const override;
 };
\ No newline at end of file
@@ -42,6 +42,10 @@ Value::Value(const Value &other)
       set_string_from_other(other);
     } break;
 
+    case AttrType::VECTORS: {
+      set_vector_from_other(other);
+    } break;
+
     default: {
       this->value_ = other.value_;
     } break;
@@ -73,6 +77,10 @@ Value &Value::operator=(const Value &other)
       set_string_from_other(other);
     } break;
 
+    case AttrType::VECTORS: {
+      set_vector_from_other(other);
+    } break;
+
     default: {
       this->value_ = other.value_;
     } break;
@@ -100,6 +108,7 @@ void Value::reset()
   switch (attr_type_) {
     case AttrType::TEXT:
     case AttrType::CHARS:
+    case AttrType::VECTORS:
       if (own_data_ && value_.pointer_value_ != nullptr) {
         delete[] value_.pointer_value_;
         value_.pointer_value_ = nullptr;
@@ -139,6 +148,9 @@ void Value::set_data(char *data, int length)
       value_.int_value_ = *(int *)data;
       length_           = length;
     } break;
+    case AttrType::VECTORS: {
+      set_vector(reinterpret_cast<const float *>(data), length / static_cast<int>(sizeof(float)));
+    } break;
     default: {
       LOG_WARN("unknown data type: %d", attr_type_);
     } break;
@@ -228,12 +240,36 @@ void Value::set_value(const Value &value)
       value_.int_value_ = value.value_.int_value_;
       length_ = value.length_;
     } break;
+    case AttrType::VECTORS: {
+      set_vector(reinterpret_cast<const float *>(value.data()), value.length() / static_cast<int>(sizeof(float)));
+    } break;
     default: {
       ASSERT(false, "got an invalid value type");
     } break;
   }
 }
 
+void Value::set_vector(const float *values, int dim)
+{
+  reset();
+  attr_type_            = AttrType::VECTORS;
+  own_data_             = true;
+  length_               = dim * static_cast<int>(sizeof(float));
+  value_.pointer_value_ = new char[length_ > 0 ? length_ : 1];
+  if (length_ > 0) {
+    memcpy(value_.pointer_value_, values, length_);
+  }
+}
+
+void Value::set_vector_from_other(const Value &other)
+{
+  ASSERT(attr_type_ == AttrType::VECTORS, "attr type is not VECTORS");
+  if (own_data_ && other.value_.pointer_value_ != nullptr) {
+    this->value_.pointer_value_ = new char[this->length_ > 0 ? this->length_ : 1];
+    memcpy(this->value_.pointer_value_, other.value_.pointer_value_, this->length_);
+  }
+}
+
 void Value::set_string_from_other(const Value &other)
 {
   ASSERT(attr_type_ == AttrType::CHARS || attr_type_ == AttrType::TEXT, "attr type is not CHARS/TEXT");
@@ -249,7 +285,8 @@ char *Value::data() const
 {
   switch (attr_type_) {
     case AttrType::TEXT:
-    case AttrType::CHARS: {
+    case AttrType::CHARS:
+    case AttrType::VECTORS: {
       return value_.pointer_value_;
     } break;
     default: {
@@ -119,6 +119,12 @@ public:
   void set_string(const char *s, int len = 0);
   void set_empty_string(int len);
   void set_string_from_other(const Value &other);
+  /// 向量类型，length 是所有元素的字节数
+  void set_vector(const float *values, int dim);
+
+private:
+  /// 复制 other 中申请的内存，用于向量类型
+  void set_vector_from_other(const Value &other);
 
 private:
   AttrType attr_type_ = AttrType::UNDEFINED;
@@ -133,6 +139,6 @@ private:
   } value_ = {.int_value_ = 0};
 
   /// 是否申请并占有内存, 目前对于 CHARS 类型 own_data_ 为true, 其余类型 own_data_ 为false
-  /// TEXT类型也为true
+  /// TEXT、VECTORS类型也为true
   bool own_data_ = false;
 };
@@ -88,6 +88,12 @@ public:
   void set_use_cascade(bool use_cascade) { use_cascade_ = use_cascade; }
   bool use_cascade() const { return use_cascade_; }
 
+  void   set_join_memory_limit(size_t join_memory_limit) { join_memory_limit_ = join_memory_limit; }
+  size_t join_memory_limit() const { return join_memory_limit_; }
+
+  void set_explain_analyze(bool explain_analyze) { explain_analyze_ = explain_analyze; }
+  bool explain_analyze() const { return explain_analyze_; }
+
   void          set_execution_mode(const ExecutionMode mode) { execution_mode_ = mode; }
   ExecutionMode get_execution_mode() const { return execution_mode_; }
 
@@ -114,9 +120,12 @@ private:
 
   bool trx_multi_operation_mode_ = false;  ///< 当前事务的模式，是否多语句模式. 单语句模式自动提交
 
-  bool sql_debug_   = false;  ///< 是否输出SQL调试信息
-  bool hash_join_   = false;  ///< 是否使用hash join
-  bool use_cascade_ = false;  ///< 是否使用 cascade 优化器
+  bool sql_debug_       = false;  ///< 是否输出SQL调试信息
+  bool hash_join_       = false;  ///< 是否使用hash join
+  bool use_cascade_     = false;  ///< 是否使用 cascade 优化器
+  bool explain_analyze_ = false;  ///< explain 时是否执行查询，输出执行时的统计信息
+
+  size_t join_memory_limit_ = 256 * 1024 * 1024;  ///< 每个 hash join 的构建侧最多使用多少内存，0表示不限制
 
   // 是否使用了 `chunk_iterator` 模式。 只有在设置了 `chunk_iterator`
   // 并且可以生成相关物理执行计划时才会使用 `chunk_iterator` 模式。
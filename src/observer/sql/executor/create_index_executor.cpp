@@ -39,5 +39,5 @@ RC CreateIndexExecutor::execute(SQLStageEvent *sql_event)
   Table *table = create_index_stmt->table();
 
   return table->create_index(
-      trx, create_index_stmt->field_meta(), create_index_stmt->index_name().c_str(), create_index_stmt->is_unique());
+      trx, create_index_stmt->field_metas(), create_index_stmt->index_name().c_str(), create_index_stmt->is_unique());
 }
\ No newline at end of file
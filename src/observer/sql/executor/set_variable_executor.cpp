@@ -42,6 +42,21 @@ RC SetVariableExecutor::execute(SQLStageEvent *sql_event)
           session->set_hash_join(bool_value);
           LOG_TRACE("set hash_join to %d", bool_value);
         }
+      } else if (strcasecmp(var_name, "join_memory_limit") == 0) {
+        // 单位是字节，0 表示不限制
+        if (var_value.attr_type() == AttrType::INTS && var_value.get_int() >= 0) {
+          session->set_join_memory_limit(static_cast<size_t>(var_value.get_int()));
+          LOG_TRACE("set join_memory_limit to %d", var_value.get_int());
+        } else {
+          rc = RC::VARIABLE_NOT_VALID;
+        }
+      } else if (strcasecmp(var_name, "explain_analyze") == 0) {
+        bool bool_value = false;
+        rc              = var_value_to_boolean(var_value, bool_value);
+        if (rc == RC::SUCCESS) {
+          session->set_explain_analyze(bool_value);
+          LOG_TRACE("set explain_analyze to %d", bool_value);
+        }
       } else if (strcasecmp(var_name, "use_cascade") == 0) {
         // TODO: remove this params, due to the dblab needed, likely to be long-existing
         bool bool_value = false;
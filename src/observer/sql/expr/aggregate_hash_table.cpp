@@ -9,6 +9,8 @@ MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
 #include "sql/expr/aggregate_hash_table.h"
+#include "common/lang/algorithm.h"
+#include "common/math/hash_util.h"
 #include "sql/expr/aggregate_state.h"
 
 // ----------------------------------StandardAggregateHashTable------------------
@@ -77,7 +79,8 @@ RC StandardAggregateHashTable::Scanner::next(Chunk &output_chunk)
           return rc;
         }
       } else {
-        if (OB_FAIL(output_chunk.column(i).append_value(group_by_values[col_idx]))) {
+        rc = output_chunk.column(i).append_value(group_by_values[col_idx]);
+        if (OB_FAIL(rc)) {
           LOG_WARN("append value failed");
           return rc;
         }
@@ -114,6 +117,243 @@ bool StandardAggregateHashTable::VectorEqual::operator()(const vector<Value> &lh
   return true;
 }
 
+// ----------------------------------RowAggregateHashTable------------------
+
+namespace {
+
+int align8(int size) { return (size + 7) & ~7; }
+
+bool is_row_key_type(AttrType type)
+{
+  return type == AttrType::CHARS || type == AttrType::INTS || type == AttrType::DATES || type == AttrType::BOOLEANS;
+}
+
+}  // namespace
+
+RowAggregateHashTable::RowAggregateHashTable(
+    const vector<Expression *> &group_by_exprs, const vector<Expression *> &aggregations)
+{
+  for (Expression *expr : group_by_exprs) {
+    key_offsets_.push_back(key_width_);
+    key_lengths_.push_back(expr->value_length());
+    key_width_ += expr->value_length();
+  }
+
+  // 聚合状态按照参数的实际类型创建，读取参数列时不需要再做类型转换
+  int offset = align8(key_width_);
+  for (Expression *expr : aggregations) {
+    ASSERT(expr->type() == ExprType::AGGREGATION, "expect aggregate expression");
+    auto *aggregate_expr = static_cast<AggregateExpr *>(expr);
+    aggr_types_.push_back(aggregate_expr->aggregate_type());
+    aggr_child_types_.push_back(aggregate_expr->child()->value_type());
+    state_offsets_.push_back(offset);
+    offset += align8(aggregate_state_size(aggr_types_.back(), aggr_child_types_.back()));
+  }
+  row_width_ = max(offset, 8);
+
+  const int state_start = align8(key_width_);
+  initial_states_.resize(row_width_ - state_start);
+  for (size_t i = 0; i < aggr_types_.size(); i++) {
+    RC rc = init_aggregate_state(
+        initial_states_.data() + state_offsets_[i] - state_start, aggr_types_[i], aggr_child_types_[i]);
+    ASSERT(OB_SUCC(rc), "unsupported aggregation. rc=%s", strrc(rc));
+  }
+
+  slots_.resize(INITIAL_CAPACITY);
+}
+
+bool RowAggregateHashTable::support(
+    const vector<Expression *> &group_by_exprs, const vector<Expression *> &aggregations)
+{
+  for (Expression *expr : group_by_exprs) {
+    if (!is_row_key_type(expr->value_type()) || expr->value_length() <= 0) {
+      return false;
+    }
+  }
+
+  for (Expression *expr : aggregations) {
+    if (expr->type() != ExprType::AGGREGATION) {
+      return false;
+    }
+    auto *aggregate_expr = static_cast<AggregateExpr *>(expr);
+    if (aggregate_state_size(aggregate_expr->aggregate_type(), aggregate_expr->child()->value_type()) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RowAggregateHashTable::encode_column(const Column &column, int key_index, int rows)
+{
+  const int   key_length = key_lengths_[key_index];
+  const int   attr_len   = column.attr_len();
+  const int   step       = column.column_type() == Column::Type::CONSTANT_COLUMN ? 0 : attr_len;
+  const bool  first      = key_index == 0;
+  const char *src        = column.data();
+  char       *dest       = keys_.data() + key_offsets_[key_index];
+
+  auto encode = [&](auto &&encode_value) {
+    for (int i = 0; i < rows; i++, src += step, dest += key_width_) {
+      const uint64_t hash = encode_value(src, dest);
+      hashes_[i]          = first ? hash : hash_combine(hashes_[i], hash);
+    }
+  };
+
+  if (column.attr_type() == AttrType::CHARS) {
+    // 只保留结束符之前的部分，后面补0，这样相等的字符串编码后按字节比较也相等
+    const int max_length = min(attr_len, key_length);
+    encode([key_length, max_length](const char *data, char *key) {
+      const int length = static_cast<int>(strnlen(data, max_length));
+      memcpy(key, data, length);
+      memset(key + length, 0, key_length - length);
+      return hash_bytes(key, length);
+    });
+  } else if (attr_len == sizeof(uint32_t) && key_length == sizeof(uint32_t)) {
+    encode([](const char *data, char *key) {
+      uint32_t value = 0;
+      memcpy(&value, data, sizeof(value));
+      memcpy(key, &value, sizeof(value));
+      return hash_mix64(value);
+    });
+  } else {
+    const int length = min(attr_len, key_length);
+    encode([key_length, length](const char *data, char *key) {
+      memcpy(key, data, length);
+      memset(key + length, 0, key_length - length);
+      return hash_bytes(key, key_length);
+    });
+  }
+}
+
+char *RowAggregateHashTable::find_or_create_group(uint64_t hash, const char *key)
+{
+  if ((groups_.size() + 1) * 2 > slots_.size()) {
+    resize();
+  }
+
+  const size_t mask = slots_.size() - 1;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    Slot &slot = slots_[pos];
+    if (slot.row == nullptr) {
+      char *row = arena_.AllocateAligned(row_width_);
+      memcpy(row, key, key_width_);
+      memcpy(row + align8(key_width_), initial_states_.data(), initial_states_.size());
+
+      slot.hash = hash;
+      slot.row  = row;
+      groups_.push_back(row);
+      return row;
+    }
+
+    if (slot.hash == hash && memcmp(slot.row, key, key_width_) == 0) {
+      return slot.row;
+    }
+  }
+}
+
+void RowAggregateHashTable::resize()
+{
+  vector<Slot> slots(slots_.size() * 2);
+  const size_t mask = slots.size() - 1;
+  for (const Slot &slot : slots_) {
+    if (slot.row == nullptr) {
+      continue;
+    }
+
+    size_t pos = slot.hash & mask;
+    while (slots[pos].row != nullptr) {
+      pos = (pos + 1) & mask;
+    }
+    slots[pos] = slot;
+  }
+  slots_.swap(slots);
+}
+
+RC RowAggregateHashTable::add_chunk(Chunk &groups_chunk, Chunk &aggrs_chunk)
+{
+  if (groups_chunk.rows() != aggrs_chunk.rows()) {
+    LOG_WARN("groups_chunk and aggrs_chunk have different rows: %d, %d", groups_chunk.rows(), aggrs_chunk.rows());
+    return RC::INVALID_ARGUMENT;
+  }
+  if (groups_chunk.column_num() != static_cast<int>(key_lengths_.size()) ||
+      aggrs_chunk.column_num() != static_cast<int>(aggr_types_.size())) {
+    LOG_WARN("unexpected column number. groups=%d, aggregations=%d",
+        groups_chunk.column_num(), aggrs_chunk.column_num());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const int rows = groups_chunk.rows();
+  if (rows == 0) {
+    return RC::SUCCESS;
+  }
+
+  keys_.resize(static_cast<size_t>(rows) * key_width_);
+  hashes_.assign(rows, 0);
+  rows_.resize(rows);
+  for (int i = 0; i < groups_chunk.column_num(); i++) {
+    encode_column(groups_chunk.column(i), i, rows);
+  }
+
+  for (int i = 0; i < rows; i++) {
+    if (i + PREFETCH_DISTANCE < rows) {
+      __builtin_prefetch(&slots_[hashes_[i + PREFETCH_DISTANCE] & (slots_.size() - 1)]);
+    }
+    rows_[i] = find_or_create_group(hashes_[i], keys_.data() + static_cast<size_t>(i) * key_width_);
+  }
+
+  for (size_t i = 0; i < aggr_types_.size(); i++) {
+    RC rc = aggregate_state_update_by_rows(
+        rows_.data(), state_offsets_[i], aggr_types_[i], aggr_child_types_[i], aggrs_chunk.column(i));
+    if (OB_FAIL(rc)) {
+      LOG_WARN("update aggregate state failed. rc=%s", strrc(rc));
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+void RowAggregateHashTable::Scanner::open_scan() { scan_pos_ = 0; }
+
+RC RowAggregateHashTable::Scanner::next(Chunk &output_chunk)
+{
+  auto        *hash_table = static_cast<RowAggregateHashTable *>(hash_table_);
+  const auto  &groups     = hash_table->groups_;
+  const size_t key_num    = hash_table->key_lengths_.size();
+  if (scan_pos_ >= groups.size()) {
+    return RC::RECORD_EOF;
+  }
+
+  const int    num  = min<int>(groups.size() - scan_pos_, output_chunk.capacity() - output_chunk.rows());
+  char *const *rows = groups.data() + scan_pos_;
+  for (int i = 0; i < output_chunk.column_num(); i++) {
+    const size_t col_idx = output_chunk.column_ids(i);
+    Column      &column  = output_chunk.column(i);
+    if (col_idx < key_num) {
+      const int key_offset = hash_table->key_offsets_[col_idx];
+      for (int r = 0; r < num; r++) {
+        column.append_one(rows[r] + key_offset);
+      }
+      continue;
+    }
+
+    const size_t aggr_idx     = col_idx - key_num;
+    const int    state_offset = hash_table->state_offsets_[aggr_idx];
+    for (int r = 0; r < num; r++) {
+      RC rc = finialize_aggregate_state(rows[r] + state_offset,
+          hash_table_->aggr_types_[aggr_idx],
+          hash_table_->aggr_child_types_[aggr_idx],
+          column);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("finialize aggregate state failed. rc=%s", strrc(rc));
+        return rc;
+      }
+    }
+  }
+
+  scan_pos_ += num;
+  return RC::SUCCESS;
+}
+
 // ----------------------------------LinearProbingAggregateHashTable------------------
 #ifdef USE_SIMD
 template <typename V>
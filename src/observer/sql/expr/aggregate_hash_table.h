@@ -15,6 +15,7 @@ See the Mulan PSL v2 for more details. */
 #include "common/math/simd_util.h"
 #include "common/sys/rc.h"
 #include "sql/expr/expression.h"
+#include "storage/common/arena_allocator.h"
 
 /**
  * @brief 用于hash group by 的哈希表实现，不支持并发访问。
@@ -107,6 +108,83 @@ public:
   StandardHashTable aggr_values_;
 };
 
+/**
+ * @brief 分组键按行存储的哈希表实现
+ * @details 每个分组占用一行定长的内存，前面是所有分组列拼接成的键，后面紧跟着每个聚合函数的状态。
+ * 行从 Arena 中分配，新增分组时不需要为分组值和聚合状态单独分配内存。
+ * add_chunk 时先按列把分组列编码成行格式并计算哈希值，再逐行查找分组，最后按列更新聚合状态。
+ * 分组列只支持 CHARS/INTS/DATES/BOOLEANS 这些按字节比较就可以判断相等的定长类型，CHARS 结束符之后的部分会清零。
+ * 其它情况使用 StandardAggregateHashTable。
+ */
+class RowAggregateHashTable : public AggregateHashTable
+{
+public:
+  class Scanner : public AggregateHashTable::Scanner
+  {
+  public:
+    explicit Scanner(AggregateHashTable *hash_table) : AggregateHashTable::Scanner(hash_table) {}
+    ~Scanner() = default;
+
+    void open_scan() override;
+
+    RC next(Chunk &chunk) override;
+
+  private:
+    size_t scan_pos_ = 0;
+  };
+
+  RowAggregateHashTable(const vector<Expression *> &group_by_exprs, const vector<Expression *> &aggregations);
+  virtual ~RowAggregateHashTable() = default;
+
+  /**
+   * @brief 分组列和聚合函数是否都能使用这个哈希表
+   */
+  static bool support(const vector<Expression *> &group_by_exprs, const vector<Expression *> &aggregations);
+
+  RC add_chunk(Chunk &groups_chunk, Chunk &aggrs_chunk) override;
+
+  /**
+   * @brief 分组的个数
+   */
+  size_t size() const { return groups_.size(); }
+
+private:
+  struct Slot
+  {
+    uint64_t hash = 0;
+    char    *row  = nullptr;  ///< 分组所在的行，nullptr 表示空槽位
+  };
+
+  /**
+   * @brief 把分组列的每个值编码到 keys_ 中对应的位置，同时计算哈希值合并到 hashes_ 中
+   */
+  void encode_column(const Column &column, int key_index, int rows);
+
+  char *find_or_create_group(uint64_t hash, const char *key);
+
+  void resize();
+
+private:
+  static constexpr size_t INITIAL_CAPACITY  = 1024;
+  static constexpr int    PREFETCH_DISTANCE = 16;
+
+  vector<int>  key_lengths_;     ///< 每个分组列在行中占用的字节数
+  vector<int>  key_offsets_;     ///< 每个分组列在行中的偏移
+  int          key_width_ = 0;   ///< 所有分组列的总长度
+  vector<int>  state_offsets_;   ///< 每个聚合状态在行中的偏移
+  int          row_width_ = 0;   ///< 每行的长度，按8字节对齐
+  vector<char> initial_states_;  ///< 初始化好的聚合状态，新增分组时直接复制
+
+  Arena          arena_;
+  vector<Slot>   slots_;
+  vector<char *> groups_;  ///< 按照插入顺序记录每个分组的行
+
+  // add_chunk 时使用的临时空间，每次复用
+  vector<char>     keys_;
+  vector<uint64_t> hashes_;
+  vector<char *>   rows_;
+};
+
 /**
  * @brief 线性探测哈希表实现
  * @note 当前只支持group by 列为 char/char(4) 类型，且聚合列为单列。
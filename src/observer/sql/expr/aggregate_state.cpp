@@ -45,35 +45,65 @@ void CountState<T>::update(const T *values, int size)
   value += size;
 }
 
-void* create_aggregate_state(AggregateExpr::Type aggr_type, AttrType attr_type)
+int aggregate_state_size(AggregateExpr::Type aggr_type, AttrType attr_type)
+{
+  if (aggr_type == AggregateExpr::Type::SUM) {
+    if (attr_type == AttrType::INTS) {
+      return sizeof(SumState<int>);
+    } else if (attr_type == AttrType::FLOATS) {
+      return sizeof(SumState<float>);
+    }
+  } else if (aggr_type == AggregateExpr::Type::COUNT) {
+    return sizeof(CountState<int>);
+  } else if (aggr_type == AggregateExpr::Type::AVG) {
+    if (attr_type == AttrType::INTS) {
+      return sizeof(AvgState<int>);
+    } else if (attr_type == AttrType::FLOATS) {
+      return sizeof(AvgState<float>);
+    }
+  }
+  return 0;
+}
+
+RC init_aggregate_state(void *state, AggregateExpr::Type aggr_type, AttrType attr_type)
 {
-  void* state_ptr = nullptr;
   if (aggr_type == AggregateExpr::Type::SUM) {
     if (attr_type == AttrType::INTS) {
-      state_ptr = malloc(sizeof(SumState<int>));
-      new (state_ptr) SumState<int>();
+      new (state) SumState<int>();
     } else if (attr_type == AttrType::FLOATS) {
-      state_ptr = malloc(sizeof(SumState<float>));
-      new (state_ptr) SumState<float>();
+      new (state) SumState<float>();
     } else {
       LOG_WARN("unsupported aggregate value type");
+      return RC::UNIMPLEMENTED;
     }
   } else if (aggr_type == AggregateExpr::Type::COUNT) {
-    state_ptr = malloc(sizeof(CountState<int>));
-    new (state_ptr) CountState<int>();
+    new (state) CountState<int>();
   } else if (aggr_type == AggregateExpr::Type::AVG) {
     if (attr_type == AttrType::INTS) {
-      state_ptr = malloc(sizeof(AvgState<int>));
-      new (state_ptr) AvgState<int>();
+      new (state) AvgState<int>();
     } else if (attr_type == AttrType::FLOATS) {
-      state_ptr = malloc(sizeof(AvgState<float>));
-      new (state_ptr) AvgState<float>();
+      new (state) AvgState<float>();
     } else {
       LOG_WARN("unsupported aggregate value type");
+      return RC::UNIMPLEMENTED;
     }
   } else {
     LOG_WARN("unsupported aggregator type");
+    return RC::UNIMPLEMENTED;
+  }
+  return RC::SUCCESS;
+}
+
+void* create_aggregate_state(AggregateExpr::Type aggr_type, AttrType attr_type)
+{
+  const int size = aggregate_state_size(aggr_type, attr_type);
+  if (size == 0) {
+    LOG_WARN("unsupported aggregate type or value type");
+    return nullptr;
   }
+
+  void *state_ptr = malloc(size);
+  init_aggregate_state(state_ptr, aggr_type, attr_type);
   return state_ptr;
 }
 
@@ -183,6 +213,104 @@ RC aggregate_state_update_by_column(void *state, AggregateExpr::Type aggr_type,
   return rc;
 }
 
+template <class STATE, typename T>
+void update_aggregate_state_by_selection(void *state, const Column &column, const int *selection, int size)
+{
+  STATE   *state_ptr = reinterpret_cast<STATE *>(state);
+  const T *data      = reinterpret_cast<const T *>(column.data());
+  if (column.column_type() == Column::Type::CONSTANT_COLUMN) {
+    for (int i = 0; i < size; i++) {
+      state_ptr->update(data[0]);
+    }
+  } else {
+    for (int i = 0; i < size; i++) {
+      state_ptr->update(data[selection[i]]);
+    }
+  }
+}
+
+RC aggregate_state_update_by_selection(void *state, AggregateExpr::Type aggr_type, AttrType attr_type,
+    const Column &col, const int *selection, int size)
+{
+  RC rc = RC::SUCCESS;
+  if (aggr_type == AggregateExpr::Type::SUM) {
+    if (attr_type == AttrType::INTS) {
+      update_aggregate_state_by_selection<SumState<int>, int>(state, col, selection, size);
+    } else if (attr_type == AttrType::FLOATS) {
+      update_aggregate_state_by_selection<SumState<float>, float>(state, col, selection, size);
+    } else {
+      LOG_WARN("unsupported aggregate value type");
+      rc = RC::UNIMPLEMENTED;
+    }
+  } else if (aggr_type == AggregateExpr::Type::COUNT) {
+    // count 不关心参数的类型和值
+    static_cast<CountState<int> *>(state)->value += size;
+  } else if (aggr_type == AggregateExpr::Type::AVG) {
+    if (attr_type == AttrType::INTS) {
+      update_aggregate_state_by_selection<AvgState<int>, int>(state, col, selection, size);
+    } else if (attr_type == AttrType::FLOATS) {
+      update_aggregate_state_by_selection<AvgState<float>, float>(state, col, selection, size);
+    } else {
+      LOG_WARN("unsupported aggregate value type");
+      rc = RC::UNIMPLEMENTED;
+    }
+  } else {
+    LOG_WARN("unsupported aggregator type");
+    rc = RC::UNIMPLEMENTED;
+  }
+  return rc;
+}
+
+template <class STATE, typename T>
+void update_aggregate_state_by_rows(char *const *rows, int state_offset, const Column &column)
+{
+  const T  *data  = reinterpret_cast<const T *>(column.data());
+  const int count = column.count();
+  if (column.column_type() == Column::Type::CONSTANT_COLUMN) {
+    for (int i = 0; i < count; i++) {
+      reinterpret_cast<STATE *>(rows[i] + state_offset)->update(data[0]);
+    }
+  } else {
+    for (int i = 0; i < count; i++) {
+      reinterpret_cast<STATE *>(rows[i] + state_offset)->update(data[i]);
+    }
+  }
+}
+
+RC aggregate_state_update_by_rows(
+    char *const *rows, int state_offset, AggregateExpr::Type aggr_type, AttrType attr_type, const Column &col)
+{
+  RC rc = RC::SUCCESS;
+  if (aggr_type == AggregateExpr::Type::SUM) {
+    if (attr_type == AttrType::INTS) {
+      update_aggregate_state_by_rows<SumState<int>, int>(rows, state_offset, col);
+    } else if (attr_type == AttrType::FLOATS) {
+      update_aggregate_state_by_rows<SumState<float>, float>(rows, state_offset, col);
+    } else {
+      LOG_WARN("unsupported aggregate value type");
+      rc = RC::UNIMPLEMENTED;
+    }
+  } else if (aggr_type == AggregateExpr::Type::COUNT) {
+    // count 不关心参数的类型和值
+    for (int i = 0; i < col.count(); i++) {
+      reinterpret_cast<CountState<int> *>(rows[i] + state_offset)->value++;
+    }
+  } else if (aggr_type == AggregateExpr::Type::AVG) {
+    if (attr_type == AttrType::INTS) {
+      update_aggregate_state_by_rows<AvgState<int>, int>(rows, state_offset, col);
+    } else if (attr_type == AttrType::FLOATS) {
+      update_aggregate_state_by_rows<AvgState<float>, float>(rows, state_offset, col);
+    } else {
+      LOG_WARN("unsupported aggregate value type");
+      rc = RC::UNIMPLEMENTED;
+    }
+  } else {
+    LOG_WARN("unsupported aggregator type");
+    rc = RC::UNIMPLEMENTED;
+  }
+  return rc;
+}
+
 template class SumState<int>;
 template class SumState<float>;
 
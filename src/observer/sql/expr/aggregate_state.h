@@ -8,6 +8,8 @@ EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
 MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
+#pragma once
+
 #include "sql/expr/expression.h"
 #include "common/type/attr_type.h"
 template <class T>
@@ -62,7 +64,34 @@ public:
 
 void *create_aggregate_state(AggregateExpr::Type aggr_type, AttrType attr_type);
 
+/**
+ * @brief 聚合状态占用的字节数，不支持的聚合类型返回0
+ * @details 聚合状态都是 trivially destructible 的，可以直接放在调用者提供的内存中，不需要单独分配和释放
+ */
+int aggregate_state_size(AggregateExpr::Type aggr_type, AttrType attr_type);
+
+/**
+ * @brief 在 state 指向的内存中构造聚合状态，内存大小至少是 aggregate_state_size
+ */
+RC init_aggregate_state(void *state, AggregateExpr::Type aggr_type, AttrType attr_type);
+
 RC aggregate_state_update_by_value(void *state, AggregateExpr::Type aggr_type, AttrType attr_type, const Value &val);
 RC aggregate_state_update_by_column(void *state, AggregateExpr::Type aggr_type, AttrType attr_type, Column &col);
 
+/**
+ * @brief 按列更新聚合状态，只处理 selection 中的行
+ * @details 用于带有选择向量的 Chunk，不需要先把有效的行整理到新的列中
+ * @param selection 有效的行号
+ * @param size 有效的行数
+ */
+RC aggregate_state_update_by_selection(void *state, AggregateExpr::Type aggr_type, AttrType attr_type,
+    const Column &col, const int *selection, int size);
+
+/**
+ * @brief 按列更新多个分组的聚合状态
+ * @details 第 i 行的值更新到 rows[i] + state_offset 处的聚合状态中，rows 的长度与 col 的行数相同
+ */
+RC aggregate_state_update_by_rows(
+    char *const *rows, int state_offset, AggregateExpr::Type aggr_type, AttrType attr_type, const Column &col);
+
 RC finialize_aggregate_state(void *state, AggregateExpr::Type aggr_type, AttrType attr_type, Column &col);
\ No newline at end of file
@@ -0,0 +1,191 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <unistd.h>
+
+#include "sql/expr/join_hash_table.h"
+#include "common/lang/algorithm.h"
+#include "common/log/log.h"
+
+using namespace std;
+
+namespace {
+
+/// 不小于 n 的最小的2的幂
+size_t next_power_of_two(size_t n)
+{
+  size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace
+
+size_t JoinHashTable::default_partition_threshold()
+{
+  static const size_t threshold = []() -> size_t {
+    long l2_cache_size = -1;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    l2_cache_size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    return l2_cache_size > 0 ? static_cast<size_t>(l2_cache_size) : 256 * 1024;
+  }();
+  return threshold;
+}
+
+void JoinHashTable::reset()
+{
+  radix_bits_ = 0;
+  hashes_.clear();
+  next_.clear();
+  slots_.clear();
+  partition_offsets_.clear();
+}
+
+void JoinHashTable::build(size_t partition_threshold)
+{
+  const size_t row_num = hashes_.size();
+  ASSERT(row_num < INVALID_ROW, "too many rows in join hash table. rows=%lu", row_num);
+
+  // 槽位数是行数的2倍
+  static_assert(ROW_MEMORY_SIZE == 2 * sizeof(Slot) + sizeof(uint64_t) + sizeof(uint32_t));
+  const size_t table_bytes = row_num * ROW_MEMORY_SIZE;
+  radix_bits_              = 0;
+  while (radix_bits_ < MAX_RADIX_BITS && (table_bytes >> radix_bits_) > partition_threshold) {
+    radix_bits_++;
+  }
+
+  const int partition_num = 1 << radix_bits_;
+  vector<uint32_t> partition_count(partition_num, 0);
+  for (uint64_t hash : hashes_) {
+    partition_count[partition_of(hash)]++;
+  }
+
+  partition_offsets_.resize(partition_num + 1);
+  size_t slot_num = 0;
+  for (int i = 0; i < partition_num; i++) {
+    partition_offsets_[i] = slot_num;
+    if (partition_count[i] > 0) {
+      slot_num += next_power_of_two(partition_count[i] * 2);
+    }
+  }
+  partition_offsets_[partition_num] = slot_num;
+
+  slots_.assign(slot_num, Slot{0, 0});
+  next_.assign(row_num, INVALID_ROW);
+
+  if (radix_bits_ == 0) {
+    for (uint32_t row = 0; row < row_num; row++) {
+      insert(row);
+    }
+    return;
+  }
+
+  // 先按分区排序再插入，插入一个分区时只会访问这个分区的槽位
+  vector<uint32_t> &offsets = partition_count;
+  uint32_t          offset  = 0;
+  for (int i = 0; i < partition_num; i++) {
+    uint32_t count = offsets[i];
+    offsets[i]     = offset;
+    offset += count;
+  }
+
+  vector<uint32_t> partition_rows(row_num);
+  for (uint32_t row = 0; row < row_num; row++) {
+    partition_rows[offsets[partition_of(hashes_[row])]++] = row;
+  }
+
+  for (uint32_t row : partition_rows) {
+    insert(row);
+  }
+
+  LOG_DEBUG("join hash table partitioned. rows=%lu, partitions=%d", row_num, partition_num);
+}
+
+void JoinHashTable::insert(uint32_t row)
+{
+  const uint64_t hash      = hashes_[row];
+  const uint32_t partition = partition_of(hash);
+  const size_t   base      = partition_offsets_[partition];
+  const size_t   mask      = partition_offsets_[partition + 1] - base - 1;
+  const uint32_t tag       = tag_of(hash);
+
+  for (size_t index = (hash >> radix_bits_) & mask;; index = (index + 1) & mask) {
+    Slot &slot = slots_[base + index];
+    if (slot.head == 0) {
+      slot.tag  = tag;
+      slot.head = row + 1;
+      return;
+    }
+
+    if (slot.tag == tag) {
+      next_[row] = slot.head - 1;
+      slot.head  = row + 1;
+      return;
+    }
+  }
+}
+
+uint32_t JoinHashTable::find(uint64_t hash) const
+{
+  if (hashes_.empty()) {
+    return INVALID_ROW;
+  }
+
+  const uint32_t partition = partition_of(hash);
+  const size_t   base      = partition_offsets_[partition];
+  const size_t   capacity  = partition_offsets_[partition + 1] - base;
+  if (capacity == 0) {
+    return INVALID_ROW;
+  }
+
+  const size_t   mask = capacity - 1;
+  const uint32_t tag  = tag_of(hash);
+  for (size_t index = (hash >> radix_bits_) & mask;; index = (index + 1) & mask) {
+    const Slot &slot = slots_[base + index];
+    if (slot.head == 0) {
+      return INVALID_ROW;
+    }
+    if (slot.tag == tag) {
+      return slot.head - 1;
+    }
+  }
+}
+
+void JoinHashTable::find_batch(const uint64_t *hashes, int num, uint32_t *heads) const
+{
+  if (hashes_.empty()) {
+    for (int i = 0; i < num; i++) {
+      heads[i] = INVALID_ROW;
+    }
+    return;
+  }
+
+  // 提前预取后面要访问的槽位，让多次缓存未命中的访存重叠起来
+  for (int i = 0; i < num; i++) {
+    if (i + PREFETCH_DISTANCE < num) {
+      const uint64_t hash      = hashes[i + PREFETCH_DISTANCE];
+      const uint32_t partition = partition_of(hash);
+      const size_t   base      = partition_offsets_[partition];
+      const size_t   capacity  = partition_offsets_[partition + 1] - base;
+      if (capacity != 0) {
+        __builtin_prefetch(&slots_[base + ((hash >> radix_bits_) & (capacity - 1))]);
+      }
+    }
+    heads[i] = find(hashes[i]);
+  }
+}
+
+size_t JoinHashTable::memory_size() const
+{
+  return hashes_.size() * sizeof(uint64_t) + next_.size() * sizeof(uint32_t) + slots_.size() * sizeof(Slot);
+}
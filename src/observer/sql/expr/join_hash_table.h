@@ -0,0 +1,122 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/lang/limits.h"
+#include "common/lang/vector.h"
+
+/**
+ * @brief hash join 构建侧使用的哈希表，不支持并发访问
+ * @details 哈希表中只保存构建侧每一行的哈希值和行号，行数据和连接键由使用者保存，探测时由使用者比较连接键。
+ *
+ * 使用开放地址法(线性探测)，每个槽位8个字节，保存哈希值的高32位和一条链表的头。
+ * 哈希值高32位相同的行串成一个链表，链表的 next 指针保存在单独的数组中。
+ * 这样槽位数组很紧凑，探测时大部分情况只需要访问一个缓存行。
+ *
+ * 当哈希表的大小超过 partition_threshold(默认是L2缓存的大小)时，使用哈希值的低位把构建侧分成多个分区，
+ * 每个分区是一个独立的小哈希表。构建时按分区依次插入，插入一个分区时访问的槽位一直在L2缓存中。
+ * 探测时每次只访问一个槽位，批量探测时通过预取隐藏缓存未命中的延迟。
+ */
+class JoinHashTable
+{
+public:
+  static constexpr uint32_t INVALID_ROW = numeric_limits<uint32_t>::max();
+
+  /// 最多分成多少个分区的位数
+  static constexpr int MAX_RADIX_BITS = 10;
+
+  /// 批量查找时提前多少行预取槽位
+  static constexpr int PREFETCH_DISTANCE = 16;
+
+  /// 平均每一行占用的内存：2个槽位、一个哈希值和一个 next 指针
+  static constexpr size_t ROW_MEMORY_SIZE = 2 * 8 + sizeof(uint64_t) + sizeof(uint32_t);
+
+  /**
+   * @brief 默认的分区阈值，即L2缓存的大小
+   */
+  static size_t default_partition_threshold();
+
+public:
+  JoinHashTable() = default;
+
+  /**
+   * @brief 清空哈希表
+   */
+  void reset();
+
+  /**
+   * @brief 添加构建侧的一行，行号就是添加的顺序
+   */
+  void add(uint64_t hash) { hashes_.push_back(hash); }
+
+  /**
+   * @brief 所有的行添加完成后，构建哈希表
+   * @param partition_threshold 哈希表超过多少字节时分区
+   */
+  void build(size_t partition_threshold);
+
+  /**
+   * @brief 查找哈希值对应链表的第一行
+   * @details 链表中的行只保证哈希值的高32位相同，使用者需要比较完整的哈希值和连接键
+   * @return 第一行的行号，没有时返回 INVALID_ROW
+   */
+  uint32_t find(uint64_t hash) const;
+
+  /**
+   * @brief 批量查找，结果与依次调用 find 相同
+   * @details 查找时预取后面的哈希值对应的槽位
+   * @param hashes 要查找的哈希值
+   * @param num    要查找多少个
+   * @param heads  每个哈希值对应链表的第一行
+   */
+  void find_batch(const uint64_t *hashes, int num, uint32_t *heads) const;
+
+  /**
+   * @brief 链表中的下一行
+   */
+  uint32_t next(uint32_t row) const { return next_[row]; }
+
+  uint64_t hash(uint32_t row) const { return hashes_[row]; }
+
+  size_t size() const { return hashes_.size(); }
+  bool   empty() const { return hashes_.empty(); }
+
+  int partition_num() const { return 1 << radix_bits_; }
+
+  /**
+   * @brief 哈希表本身占用的内存，不包括行数据
+   */
+  size_t memory_size() const;
+
+private:
+  struct Slot
+  {
+    uint32_t tag;   ///< 哈希值的高32位
+    uint32_t head;  ///< 链表第一行的行号加1，0表示空槽位
+  };
+
+  static uint32_t tag_of(uint64_t hash) { return static_cast<uint32_t>(hash >> 32); }
+
+  uint32_t partition_of(uint64_t hash) const { return static_cast<uint32_t>(hash) & ((1U << radix_bits_) - 1); }
+
+  void insert(uint32_t row);
+
+private:
+  int radix_bits_ = 0;
+
+  vector<uint64_t> hashes_;             ///< 每一行的哈希值
+  vector<uint32_t> next_;               ///< 每一行在链表中的下一行
+  vector<Slot>     slots_;              ///< 所有分区的槽位
+  vector<size_t>   partition_offsets_;  ///< 每个分区的槽位在 slots_ 中的起始位置，最后一个是 slots_ 的大小
+};
@@ -317,6 +317,9 @@ public:
 
   void set_names(const vector<TupleCellSpec> &specs) { specs_ = specs; }
   void set_cells(const vector<Value> &cells) { cells_ = cells; }
+  void set_cells(vector<Value> &&cells) { cells_ = std::move(cells); }
+
+  const vector<Value> &cells() const { return cells_; }
 
   virtual int cell_num() const override { return static_cast<int>(cells_.size()); }
 
@@ -57,7 +57,13 @@ RC AggregateVecPhysicalOperator::open(Trx *trx)
       value_expressions_[aggr_idx]->get_column(chunk_, column);
       ASSERT(aggregate_expressions_[aggr_idx]->type() == ExprType::AGGREGATION, "expect aggregate expression");
       auto *aggregate_expr = static_cast<AggregateExpr *>(aggregate_expressions_[aggr_idx]);
-      rc = aggregate_state_update_by_column(aggr_values_.at(aggr_idx), aggregate_expr->aggregate_type(), aggregate_expr->child()->value_type(), column);
+      if (chunk_.has_selection()) {
+        rc = aggregate_state_update_by_selection(aggr_values_.at(aggr_idx), aggregate_expr->aggregate_type(),
+            aggregate_expr->child()->value_type(), column, chunk_.selection(), chunk_.selected_rows());
+      } else {
+        rc = aggregate_state_update_by_column(aggr_values_.at(aggr_idx), aggregate_expr->aggregate_type(),
+            aggregate_expr->child()->value_type(), column);
+      }
       if (OB_FAIL(rc)) {
         LOG_INFO("failed to update aggregate state. rc=%s", strrc(rc));
         return rc;
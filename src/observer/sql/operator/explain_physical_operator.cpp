@@ -18,18 +18,55 @@ See the Mulan PSL v2 for more details. */
 
 using namespace std;
 
-RC ExplainPhysicalOperator::open(Trx *)
+RC ExplainPhysicalOperator::open(Trx *trx)
 {
   ASSERT(children_.size() == 1, "explain must has 1 child");
+  trx_ = trx;
   return RC::SUCCESS;
 }
 
 RC ExplainPhysicalOperator::close() { return RC::SUCCESS; }
 
-void ExplainPhysicalOperator::generate_physical_plan()
+RC ExplainPhysicalOperator::generate_physical_plan(bool vectorized)
 {
   ASSERT(children_.size() == 1, "explain must has 1 child");
+  if (analyze_) {
+    RC rc = analyze(vectorized);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+
   physical_plan_ = OptimizerUtils::dump_physical_plan(children_.front());
+  return RC::SUCCESS;
+}
+
+RC ExplainPhysicalOperator::analyze(bool vectorized)
+{
+  PhysicalOperator *child = children_.front().get();
+
+  RC rc = child->open(trx_);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to open child operator. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  if (vectorized) {
+    Chunk chunk;
+    while (OB_SUCC(rc = child->next(chunk))) {
+      chunk.reset();
+    }
+  } else {
+    while (OB_SUCC(rc = child->next())) {
+    }
+  }
+
+  RC close_rc = child->close();
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to execute child operator. rc=%s", strrc(rc));
+    return rc;
+  }
+  return close_rc;
 }
 
 RC ExplainPhysicalOperator::next()
@@ -37,7 +74,11 @@ RC ExplainPhysicalOperator::next()
   if (!physical_plan_.empty()) {
     return RC::RECORD_EOF;
   }
-  generate_physical_plan();
+
+  RC rc = generate_physical_plan(false /*vectorized*/);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
 
   vector<Value> cells;
   Value         cell(physical_plan_.c_str());
@@ -51,7 +92,11 @@ RC ExplainPhysicalOperator::next(Chunk &chunk)
   if (!physical_plan_.empty()) {
     return RC::RECORD_EOF;
   }
-  generate_physical_plan();
+
+  RC rc = generate_physical_plan(true /*vectorized*/);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
 
   Value         cell(physical_plan_.c_str());
   auto column = make_unique<Column>();
@@ -19,11 +19,12 @@ See the Mulan PSL v2 for more details. */
 /**
  * @brief Explain物理算子
  * @ingroup PhysicalOperator
+ * @details analyze 为 true 时先把查询执行一遍，再输出执行计划，这样算子可以在 param 中输出执行时的统计信息
  */
 class ExplainPhysicalOperator : public PhysicalOperator
 {
 public:
-  ExplainPhysicalOperator()          = default;
+  ExplainPhysicalOperator(bool analyze = false) : analyze_(analyze) {}
   virtual ~ExplainPhysicalOperator() = default;
 
   PhysicalOperatorType type() const override { return PhysicalOperatorType::EXPLAIN; }
@@ -48,9 +49,12 @@ public:
   }
 
 private:
-  void generate_physical_plan();
+  RC generate_physical_plan(bool vectorized);
+  RC analyze(bool vectorized);
 
 private:
+  bool           analyze_ = false;
+  Trx           *trx_     = nullptr;
   string         physical_plan_;
   ValueListTuple tuple_;
 };
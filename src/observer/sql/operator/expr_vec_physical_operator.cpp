@@ -49,6 +49,10 @@ RC ExprVecPhysicalOperator::next(Chunk &chunk)
       expressions_[i]->get_column(chunk_, *column);
       evaled_chunk_.add_column(std::move(column), i);
     }
+    // 表达式是按照所有的行计算的，行号不变，直接沿用孩子的选择向量
+    if (chunk_.has_selection()) {
+      evaled_chunk_.set_selection(chunk_.selection(), chunk_.selected_rows());
+    }
     chunk.reference(evaled_chunk_);
   }
   return rc;
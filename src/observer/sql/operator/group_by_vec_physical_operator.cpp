@@ -8,4 +8,137 @@ EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
 MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
-#include "sql/operator/group_by_vec_physical_operator.h"
\ No newline at end of file
+#include "sql/operator/group_by_vec_physical_operator.h"
+#include "common/log/log.h"
+
+using namespace std;
+using namespace common;
+
+GroupByVecPhysicalOperator::GroupByVecPhysicalOperator(
+    vector<unique_ptr<Expression>> &&group_by_exprs, vector<Expression *> &&expressions)
+    : group_by_exprs_(std::move(group_by_exprs)), aggregate_expressions_(std::move(expressions))
+{
+  for (unique_ptr<Expression> &expr : group_by_exprs_) {
+    group_by_expressions_.push_back(expr.get());
+  }
+
+  value_expressions_.reserve(aggregate_expressions_.size());
+  for (Expression *expr : aggregate_expressions_) {
+    ASSERT(expr->type() == ExprType::AGGREGATION, "expected an aggregation expression");
+    auto *aggregate_expr = static_cast<AggregateExpr *>(expr);
+    ASSERT(aggregate_expr->child() != nullptr, "aggregation expression must have a child expression");
+    value_expressions_.push_back(aggregate_expr->child().get());
+  }
+
+  // 输出的列先是分组列，再是聚合列
+  int column_id = 0;
+  for (Expression *expr : group_by_expressions_) {
+    output_chunk_.add_column(make_unique<Column>(expr->value_type(), expr->value_length()), column_id++);
+  }
+  for (Expression *expr : aggregate_expressions_) {
+    output_chunk_.add_column(make_unique<Column>(expr->value_type(), expr->value_length()), column_id++);
+  }
+}
+
+RC GroupByVecPhysicalOperator::eval_columns(const vector<Expression *> &expressions, Chunk &chunk, Chunk &output)
+{
+  output.reset();
+  for (size_t i = 0; i < expressions.size(); i++) {
+    auto column = make_unique<Column>();
+    RC   rc     = expressions[i]->get_column(chunk, *column);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get column of expression. expr=%s, rc=%s", expressions[i]->name(), strrc(rc));
+      return rc;
+    }
+    output.add_column(std::move(column), i);
+  }
+
+  // 哈希表按照连续的行处理数据，这里只整理用到的列
+  if (chunk.has_selection()) {
+    output.set_selection(chunk.selection(), chunk.selected_rows());
+    return output.compact();
+  }
+  return RC::SUCCESS;
+}
+
+RC GroupByVecPhysicalOperator::open(Trx *trx)
+{
+  ASSERT(children_.size() == 1, "group by operator only support one child, but got %d", children_.size());
+
+  PhysicalOperator &child = *children_[0];
+  RC                rc    = child.open(trx);
+  if (OB_FAIL(rc)) {
+    LOG_INFO("failed to open child operator. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  const bool use_row_table = RowAggregateHashTable::support(group_by_expressions_, aggregate_expressions_);
+  if (use_row_table) {
+    hash_table_ = make_unique<RowAggregateHashTable>(group_by_expressions_, aggregate_expressions_);
+  } else {
+    hash_table_ = make_unique<StandardAggregateHashTable>(aggregate_expressions_);
+  }
+
+  while (OB_SUCC(rc = child.next(chunk_))) {
+    rc = eval_columns(group_by_expressions_, chunk_, groups_chunk_);
+    if (OB_SUCC(rc)) {
+      rc = eval_columns(value_expressions_, chunk_, aggrs_chunk_);
+    }
+    if (OB_SUCC(rc)) {
+      rc = hash_table_->add_chunk(groups_chunk_, aggrs_chunk_);
+    }
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to aggregate chunk. rc=%s", strrc(rc));
+      return rc;
+    }
+  }
+
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to get next chunk from child. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  groups_chunk_.reset();
+  aggrs_chunk_.reset();
+
+  if (use_row_table) {
+    scanner_ = make_unique<RowAggregateHashTable::Scanner>(hash_table_.get());
+  } else {
+    scanner_ = make_unique<StandardAggregateHashTable::Scanner>(hash_table_.get());
+  }
+  scanner_->open_scan();
+  return RC::SUCCESS;
+}
+
+RC GroupByVecPhysicalOperator::next(Chunk &chunk)
+{
+  if (scanner_ == nullptr) {
+    return RC::RECORD_EOF;
+  }
+
+  output_chunk_.reset_data();
+  RC rc = scanner_->next(output_chunk_);
+  if (OB_FAIL(rc)) {
+    if (rc != RC::RECORD_EOF) {
+      LOG_WARN("failed to scan aggregate hash table. rc=%s", strrc(rc));
+    }
+    return rc;
+  }
+
+  return chunk.reference(output_chunk_);
+}
+
+RC GroupByVecPhysicalOperator::close()
+{
+  if (scanner_ != nullptr) {
+    scanner_->close_scan();
+    scanner_.reset();
+  }
+  hash_table_.reset();
+  chunk_.reset();
+  output_chunk_.reset_data();
+
+  children_[0]->close();
+  LOG_INFO("close group by(vec) operator");
+  return RC::SUCCESS;
+}
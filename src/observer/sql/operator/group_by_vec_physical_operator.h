@@ -16,19 +16,41 @@ See the Mulan PSL v2 for more details. */
 /**
  * @brief Group By 物理算子(vectorized)
  * @ingroup PhysicalOperator
+ * @details open 时按 Chunk 读取子算子的所有数据，计算分组列和聚合函数的参数列，写入聚合哈希表中。
+ * 优先使用 RowAggregateHashTable，分组列或聚合函数不支持时使用 StandardAggregateHashTable。
+ * next 时扫描哈希表输出聚合结果。输出的 Chunk 中先是分组列，然后是聚合列，与 LogicalPlanGenerator
+ * 中给上层表达式绑定的位置(pos)一致。
  */
 class GroupByVecPhysicalOperator : public PhysicalOperator
 {
 public:
-  GroupByVecPhysicalOperator(vector<unique_ptr<Expression>> &&group_by_exprs, vector<Expression *> &&expressions){};
+  GroupByVecPhysicalOperator(vector<unique_ptr<Expression>> &&group_by_exprs, vector<Expression *> &&expressions);
 
   virtual ~GroupByVecPhysicalOperator() = default;
 
   PhysicalOperatorType type() const override { return PhysicalOperatorType::GROUP_BY_VEC; }
 
-  RC open(Trx *trx) override { return RC::UNIMPLEMENTED; }
-  RC next(Chunk &chunk) override { return RC::UNIMPLEMENTED; }
-  RC close() override { return RC::UNIMPLEMENTED; }
+  RC open(Trx *trx) override;
+  RC next(Chunk &chunk) override;
+  RC close() override;
 
 private:
+  /**
+   * @brief 计算表达式，结果按顺序放到 output 中
+   */
+  static RC eval_columns(const vector<Expression *> &expressions, Chunk &chunk, Chunk &output);
+
+private:
+  vector<unique_ptr<Expression>> group_by_exprs_;
+  vector<Expression *>           group_by_expressions_;   ///< group_by_exprs_ 的指针，方便与聚合参数统一处理
+  vector<Expression *>           aggregate_expressions_;  ///< 聚合表达式
+  vector<Expression *>           value_expressions_;      ///< 聚合函数的参数
+
+  unique_ptr<AggregateHashTable>          hash_table_;
+  unique_ptr<AggregateHashTable::Scanner> scanner_;
+
+  Chunk chunk_;         ///< 子算子输出的数据
+  Chunk groups_chunk_;  ///< 分组列
+  Chunk aggrs_chunk_;   ///< 聚合函数的参数列
+  Chunk output_chunk_;
 };
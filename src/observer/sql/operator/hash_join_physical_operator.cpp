@@ -8,4 +8,984 @@ EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
 MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
+#include <unistd.h>
+
 #include "sql/operator/hash_join_physical_operator.h"
+#include "common/lang/atomic.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/sstream.h"
+#include "common/log/log.h"
+#include "common/math/hash_util.h"
+#include "sql/expr/expression.h"
+
+using namespace std;
+
+namespace {
+
+bool bytes_equal(const char *left, int left_len, const char *right, int right_len)
+{
+  return left_len == right_len && memcmp(left, right, left_len) == 0;
+}
+
+const char *column_data(const Column &column, int row)
+{
+  const int index = column.column_type() == Column::Type::CONSTANT_COLUMN ? 0 : row;
+  return column.data() + static_cast<size_t>(index) * column.attr_len();
+}
+
+int key_length(const Column &column, const char *data)
+{
+  if (column.attr_type() == AttrType::CHARS) {
+    return static_cast<int>(strnlen(data, column.attr_len()));
+  }
+  return column.attr_len();
+}
+
+/**
+ * @brief 按列计算哈希值，多个连接键的哈希值合并在一起
+ * @details 与 eval_keys 一样使用 hash_bytes，火山模型和向量化模型下同样的值得到的哈希值相同。
+ * CHARS 类型只计算结束符之前的部分，与 Value 的比较一致
+ */
+void hash_column(const Column &column, int rows, uint64_t *hashes, bool first)
+{
+  for (int i = 0; i < rows; i++) {
+    const char    *data = column_data(column, i);
+    const uint64_t hash = hash_bytes(data, key_length(column, data));
+    hashes[i]           = first ? hash : hash_combine(hashes[i], hash);
+  }
+}
+
+void collect_specs(const Tuple &tuple, vector<TupleCellSpec> &specs)
+{
+  specs.resize(tuple.cell_num());
+  for (int i = 0; i < tuple.cell_num(); i++) {
+    tuple.spec_at(i, specs[i]);
+  }
+}
+
+}  // namespace
+
+HashJoinPhysicalOperator::HashJoinPhysicalOperator(
+    vector<unique_ptr<Expression>> &&left_keys, vector<unique_ptr<Expression>> &&right_keys)
+    : left_keys_(std::move(left_keys)),
+      right_keys_(std::move(right_keys)),
+      partition_threshold_(JoinHashTable::default_partition_threshold())
+{
+  ASSERT(left_keys_.size() == right_keys_.size(), "left keys and right keys should have the same size");
+}
+
+string HashJoinPhysicalOperator::param() const
+{
+  auto key_name = [](const Expression &expr) -> string {
+    if (expr.type() == ExprType::FIELD) {
+      const auto &field_expr = static_cast<const FieldExpr &>(expr);
+      return string(field_expr.table_name()) + "." + field_expr.field_name();
+    }
+    return expr.name();
+  };
+
+  stringstream ss;
+  for (size_t i = 0; i < left_keys_.size(); i++) {
+    if (i != 0) {
+      ss << " AND ";
+    }
+    ss << key_name(*left_keys_[i]) << "=" << key_name(*right_keys_[i]);
+  }
+
+  if (executed_) {
+    ss << ", spill_partitions=" << spill_partition_num_ << ", spill_bytes=" << spill_bytes_;
+  }
+  return ss.str();
+}
+
+RC HashJoinPhysicalOperator::open(Trx *trx)
+{
+  if (children_.size() != 2) {
+    LOG_WARN("hash join operator should have 2 children");
+    return RC::INTERNAL;
+  }
+
+  left_  = children_[0].get();
+  right_ = children_[1].get();
+
+  RC rc = left_->open(trx);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to open left oper. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  rc = right_->open(trx);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to open right oper. rc=%s", strrc(rc));
+    left_->close();
+    return rc;
+  }
+
+  built_               = false;
+  executed_            = false;
+  spilled_             = false;
+  spill_bytes_         = 0;
+  spill_partition_num_ = 0;
+  clear_build_side();
+  return rc;
+}
+
+RC HashJoinPhysicalOperator::next()
+{
+  RC rc = RC::SUCCESS;
+  if (!built_) {
+    rc = build();
+    if (OB_FAIL(rc) && rc != RC::RECORD_EOF) {
+      return rc;
+    }
+  }
+
+  // 构建侧没有数据，不需要再读取探测侧
+  if (hash_table_.empty()) {
+    return RC::RECORD_EOF;
+  }
+
+  const size_t key_num = left_keys_.size();
+  while (true) {
+    while (probe_match_ != JoinHashTable::INVALID_ROW) {
+      const uint32_t row = probe_match_;
+      probe_match_       = hash_table_.next(row);
+      if (hash_table_.hash(row) != probe_hash_) {
+        continue;
+      }
+
+      const Value *build_keys = &build_keys_[row * key_num];
+      bool         equal      = true;
+      for (size_t i = 0; i < key_num && equal; i++) {
+        equal = bytes_equal(
+            probe_keys_[i].data(), probe_keys_[i].length(), build_keys[i].data(), build_keys[i].length());
+      }
+
+      if (equal) {
+        joined_tuple_.set_right(&build_tuples_[row]);
+        return RC::SUCCESS;
+      }
+    }
+
+    Tuple *left_tuple = nullptr;
+    if (current_partition_.probe == nullptr) {
+      rc         = left_->next();
+      left_tuple = OB_SUCC(rc) ? left_->current_tuple() : nullptr;
+    } else {
+      uint64_t    hash = 0;
+      const char *data = nullptr;
+      int         len  = 0;
+      rc               = current_partition_.probe->next(hash, data, len);
+      if (OB_SUCC(rc)) {
+        vector<Value> cells;
+        decode_tuple(data, len, cells);
+        probe_tuple_.set_cells(std::move(cells));
+        left_tuple = &probe_tuple_;
+      }
+    }
+
+    // 当前分区连接完了，继续连接下一个分区
+    if (rc == RC::RECORD_EOF && spilled_) {
+      rc = next_spill_partition(false /*vectorized*/);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+      continue;
+    }
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    rc = eval_keys(left_keys_, *left_tuple, probe_keys_.data(), probe_hash_);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    joined_tuple_.set_left(left_tuple);
+    probe_match_ = hash_table_.find(probe_hash_);
+  }
+  return rc;
+}
+
+RC HashJoinPhysicalOperator::next(Chunk &chunk)
+{
+  RC rc = RC::SUCCESS;
+  if (!built_) {
+    rc = build_chunk();
+    if (OB_FAIL(rc) && rc != RC::RECORD_EOF) {
+      return rc;
+    }
+  }
+
+  if (hash_table_.empty()) {
+    return RC::RECORD_EOF;
+  }
+
+  output_left_rows_.clear();
+  output_right_rows_.clear();
+  while (output_left_rows_.size() < static_cast<size_t>(Chunk::MAX_ROWS)) {
+    if (probe_row_ >= static_cast<int>(probe_hashes_.size())) {
+      // 输出的行引用了当前探测侧的 Chunk 和构建侧，先输出再读取下一个
+      if (!output_left_rows_.empty()) {
+        break;
+      }
+
+      rc = probe_chunk();
+      if (rc == RC::RECORD_EOF && spilled_) {
+        rc = next_spill_partition(true /*vectorized*/);
+      }
+      if (rc == RC::RECORD_EOF) {
+        break;
+      }
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+      continue;
+    }
+
+    // 一次处理一行的所有匹配，输出的 Chunk 满了之后，下次从 probe_match_ 继续
+    const uint64_t probe_hash = probe_hashes_[probe_row_];
+    while (probe_match_ != JoinHashTable::INVALID_ROW &&
+           output_left_rows_.size() < static_cast<size_t>(Chunk::MAX_ROWS)) {
+      const uint32_t row = probe_match_;
+      probe_match_       = hash_table_.next(row);
+      if (hash_table_.hash(row) == probe_hash && chunk_keys_equal(probe_row_, row)) {
+        output_left_rows_.push_back(probe_row_);
+        output_right_rows_.push_back(row);
+      }
+    }
+
+    if (probe_match_ == JoinHashTable::INVALID_ROW) {
+      probe_row_++;
+      if (probe_row_ < static_cast<int>(probe_heads_.size())) {
+        probe_match_ = probe_heads_[probe_row_];
+      }
+    }
+  }
+
+  if (output_left_rows_.empty()) {
+    return RC::RECORD_EOF;
+  }
+  return output_chunk(chunk);
+}
+
+RC HashJoinPhysicalOperator::close()
+{
+  RC rc = RC::SUCCESS;
+  if (left_ != nullptr) {
+    rc = left_->close();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to close left oper. rc=%s", strrc(rc));
+    }
+  }
+
+  if (right_ != nullptr) {
+    RC right_rc = right_->close();
+    if (OB_FAIL(right_rc)) {
+      LOG_WARN("failed to close right oper. rc=%s", strrc(right_rc));
+      rc = right_rc;
+    }
+  }
+
+  LOG_TRACE("hash join closed. build rows=%lu, partitions=%d, spill partitions=%d, spill bytes=%ld",
+      hash_table_.size(), hash_table_.partition_num(), spill_partition_num_, spill_bytes_);
+  clear_build_side();
+  spill_partitions_.clear();
+  current_partition_ = SpillPartition();
+  probe_chunk_.reset();
+  probe_key_chunk_.reset();
+  output_chunk_.reset();
+  spill_chunk_.reset();
+  built_ = false;
+  return rc;
+}
+
+Tuple *HashJoinPhysicalOperator::current_tuple() { return &joined_tuple_; }
+
+RC HashJoinPhysicalOperator::eval_keys(
+    vector<unique_ptr<Expression>> &keys, const Tuple &tuple, Value *values, uint64_t &hash)
+{
+  for (size_t i = 0; i < keys.size(); i++) {
+    RC rc = keys[i]->get_value(tuple, values[i]);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get join key value. rc=%s", strrc(rc));
+      return rc;
+    }
+
+    const uint64_t key_hash = hash_bytes(values[i].data(), values[i].length());
+    hash                    = (i == 0) ? key_hash : hash_combine(hash, key_hash);
+  }
+  return RC::SUCCESS;
+}
+
+RC HashJoinPhysicalOperator::eval_key_columns(
+    vector<unique_ptr<Expression>> &keys, Chunk &chunk, Chunk &key_chunk, uint64_t *hashes)
+{
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto column = make_unique<Column>();
+    RC   rc     = keys[i]->get_column(chunk, *column);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get join key column. rc=%s", strrc(rc));
+      return rc;
+    }
+    key_chunk.add_column(std::move(column), i);
+  }
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    hash_column(key_chunk.column(i), chunk.rows(), hashes, i == 0);
+  }
+  return RC::SUCCESS;
+}
+
+size_t HashJoinPhysicalOperator::row_memory_size(bool vectorized) const
+{
+  if (vectorized) {
+    return sizeof(ChunkRow) + JoinHashTable::ROW_MEMORY_SIZE;
+  }
+  return sizeof(ValueListTuple) + build_specs_.size() * (sizeof(Value) + sizeof(TupleCellSpec)) +
+         right_keys_.size() * sizeof(Value) + JoinHashTable::ROW_MEMORY_SIZE;
+}
+
+void HashJoinPhysicalOperator::add_build_tuple(ValueListTuple &&row, const Value *keys, uint64_t hash)
+{
+  build_keys_.insert(build_keys_.end(), keys, keys + right_keys_.size());
+
+  memory_used_ += row_memory_size(false /*vectorized*/);
+  for (const Value &cell : row.cells()) {
+    memory_used_ += cell.length();
+  }
+
+  build_tuples_.emplace_back(std::move(row));
+  hash_table_.add(hash);
+}
+
+RC HashJoinPhysicalOperator::add_build_chunk(unique_ptr<Chunk> chunk, const uint64_t *hashes)
+{
+  const int rows = chunk->rows();
+  auto      key_chunk = make_unique<Chunk>();
+  if (hashes == nullptr) {
+    probe_hashes_.resize(rows);
+    RC rc = eval_key_columns(right_keys_, *chunk, *key_chunk, probe_hashes_.data());
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    hashes = probe_hashes_.data();
+  } else {
+    for (size_t i = 0; i < right_keys_.size(); i++) {
+      auto column = make_unique<Column>();
+      RC   rc     = right_keys_[i]->get_column(*chunk, *column);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to get join key column of build side. rc=%s", strrc(rc));
+        return rc;
+      }
+      key_chunk->add_column(std::move(column), i);
+    }
+  }
+
+  const uint32_t chunk_index = static_cast<uint32_t>(build_chunks_.size());
+  for (int i = 0; i < rows; i++) {
+    hash_table_.add(hashes[i]);
+    build_rows_.push_back(ChunkRow{chunk_index, static_cast<uint32_t>(i)});
+  }
+
+  memory_used_ += rows * row_memory_size(true /*vectorized*/);
+  for (int i = 0; i < chunk->column_num(); i++) {
+    memory_used_ += chunk->column(i).capacity() * chunk->column(i).attr_len();
+  }
+
+  build_chunks_.push_back(std::move(chunk));
+  build_key_chunks_.push_back(std::move(key_chunk));
+  return RC::SUCCESS;
+}
+
+void HashJoinPhysicalOperator::clear_build_side()
+{
+  hash_table_.reset();
+  build_tuples_.clear();
+  build_keys_.clear();
+  build_chunks_.clear();
+  build_key_chunks_.clear();
+  build_rows_.clear();
+  memory_used_ = 0;
+
+  probe_match_ = JoinHashTable::INVALID_ROW;
+  probe_row_   = 0;
+  probe_hashes_.clear();
+  probe_heads_.clear();
+}
+
+RC HashJoinPhysicalOperator::build()
+{
+  probe_keys_.resize(right_keys_.size());
+
+  RC rc = RC::SUCCESS;
+  while (OB_SUCC(rc = right_->next())) {
+    ValueListTuple row;
+    rc = ValueListTuple::make(*right_->current_tuple(), row);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to copy tuple of build side. rc=%s", strrc(rc));
+      return rc;
+    }
+
+    uint64_t hash = 0;
+    rc            = eval_keys(right_keys_, row, probe_keys_.data(), hash);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    if (spilled_) {
+      encode_tuple(row.cells(), row_buffer_);
+      SpillFile &file = *spill_partitions_[spill_partition_of(hash, 0)].build;
+      rc              = spill_row(file, hash, row_buffer_.data(), row_buffer_.size());
+    } else {
+      add_build_tuple(std::move(row), probe_keys_.data(), hash);
+      if (over_memory_limit()) {
+        rc = spill_build_side(false /*vectorized*/);
+      }
+    }
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to read build side. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  built_    = true;
+  executed_ = true;
+  if (!spilled_) {
+    hash_table_.build(partition_threshold_);
+    LOG_TRACE("hash join built. rows=%lu, partitions=%d", hash_table_.size(), hash_table_.partition_num());
+    return RC::SUCCESS;
+  }
+
+  rc = spill_probe_side(false /*vectorized*/);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  return next_spill_partition(false /*vectorized*/);
+}
+
+RC HashJoinPhysicalOperator::build_chunk()
+{
+  RC    rc = RC::SUCCESS;
+  Chunk chunk;
+  while (OB_SUCC(rc = right_->next(chunk))) {
+    // 哈希表按照行号引用数据，先把选择向量中的行整理成连续的
+    rc = chunk.compact();
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    const int rows = chunk.rows();
+    if (rows == 0) {
+      continue;
+    }
+
+    if (build_schema_.empty()) {
+      for (int i = 0; i < chunk.column_num(); i++) {
+        build_schema_.emplace_back(chunk.column(i).attr_type(), chunk.column(i).attr_len());
+      }
+    }
+
+    if (spilled_) {
+      Chunk key_chunk;
+      probe_hashes_.resize(rows);
+      rc = eval_key_columns(right_keys_, chunk, key_chunk, probe_hashes_.data());
+      for (int i = 0; i < rows && OB_SUCC(rc); i++) {
+        encode_chunk_row(chunk, i, row_buffer_);
+        SpillFile &file = *spill_partitions_[spill_partition_of(probe_hashes_[i], 0)].build;
+        rc              = spill_row(file, probe_hashes_[i], row_buffer_.data(), row_buffer_.size());
+      }
+    } else {
+      // 孩子返回的 Chunk 引用的是它内部的数据，需要拷贝一份
+      rc = add_build_chunk(make_unique<Chunk>(chunk), nullptr);
+      if (OB_SUCC(rc) && over_memory_limit()) {
+        rc = spill_build_side(true /*vectorized*/);
+      }
+    }
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to add chunk of build side. rc=%s", strrc(rc));
+      return rc;
+    }
+    chunk.reset();
+  }
+
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to read build side. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  probe_hashes_.clear();
+  built_    = true;
+  executed_ = true;
+  if (!spilled_) {
+    hash_table_.build(partition_threshold_);
+    LOG_TRACE("hash join built. rows=%lu, partitions=%d", hash_table_.size(), hash_table_.partition_num());
+    return RC::SUCCESS;
+  }
+
+  rc = spill_probe_side(true /*vectorized*/);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  return next_spill_partition(true /*vectorized*/);
+}
+
+RC HashJoinPhysicalOperator::probe_chunk()
+{
+  probe_chunk_.reset();
+  probe_key_chunk_.reset();
+  probe_hashes_.clear();
+  probe_heads_.clear();
+  probe_row_   = 0;
+  probe_match_ = JoinHashTable::INVALID_ROW;
+
+  RC rc = RC::SUCCESS;
+  if (current_partition_.probe == nullptr) {
+    rc = left_->next(probe_chunk_);
+    if (OB_SUCC(rc)) {
+      rc = probe_chunk_.compact();
+    }
+  } else {
+    rc = read_spill_chunk(*current_partition_.probe, probe_schema_, spill_chunk_, nullptr);
+    if (OB_SUCC(rc)) {
+      rc = probe_chunk_.reference(spill_chunk_);
+    }
+  }
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  const int rows = probe_chunk_.rows();
+  probe_hashes_.resize(rows);
+  probe_heads_.resize(rows);
+  rc = eval_key_columns(left_keys_, probe_chunk_, probe_key_chunk_, probe_hashes_.data());
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  hash_table_.find_batch(probe_hashes_.data(), rows, probe_heads_.data());
+  if (rows > 0) {
+    probe_match_ = probe_heads_[0];
+  }
+  return RC::SUCCESS;
+}
+
+bool HashJoinPhysicalOperator::chunk_keys_equal(int probe_row, uint32_t build_row)
+{
+  const ChunkRow &location  = build_rows_[build_row];
+  Chunk          &key_chunk = *build_key_chunks_[location.chunk];
+  for (int i = 0; i < probe_key_chunk_.column_num(); i++) {
+    const Column &probe_column = probe_key_chunk_.column(i);
+    const Column &build_column = key_chunk.column(i);
+    const char   *probe_data   = column_data(probe_column, probe_row);
+    const char   *build_data   = column_data(build_column, location.row);
+    if (!bytes_equal(probe_data,
+            key_length(probe_column, probe_data),
+            build_data,
+            key_length(build_column, build_data))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+RC HashJoinPhysicalOperator::output_chunk(Chunk &chunk)
+{
+  const int left_column_num  = probe_chunk_.column_num();
+  const int right_column_num = build_chunks_.front()->column_num();
+  if (output_chunk_.column_num() != left_column_num + right_column_num) {
+    output_chunk_.reset();
+    for (int i = 0; i < left_column_num; i++) {
+      const Column &column = probe_chunk_.column(i);
+      output_chunk_.add_column(make_unique<Column>(column.attr_type(), column.attr_len()), i);
+    }
+    for (int i = 0; i < right_column_num; i++) {
+      const Column &column = build_chunks_.front()->column(i);
+      output_chunk_.add_column(make_unique<Column>(column.attr_type(), column.attr_len()), left_column_num + i);
+    }
+  }
+  output_chunk_.reset_data();
+
+  // 按列拷贝，每一列的数据是连续写入的
+  for (int i = 0; i < left_column_num; i++) {
+    const Column &input  = probe_chunk_.column(i);
+    Column       &output = output_chunk_.column(i);
+    for (uint32_t row : output_left_rows_) {
+      output.append_one(column_data(input, row));
+    }
+  }
+
+  for (int i = 0; i < right_column_num; i++) {
+    Column &output = output_chunk_.column(left_column_num + i);
+    for (uint32_t row : output_right_rows_) {
+      const ChunkRow &location = build_rows_[row];
+      output.append_one(column_data(build_chunks_[location.chunk]->column(i), location.row));
+    }
+  }
+
+  return chunk.reference(output_chunk_);
+}
+
+int HashJoinPhysicalOperator::spill_partition_of(uint64_t hash, int level)
+{
+  // 使用哈希值的高位，低位已经用于哈希表内的分区和槽位
+  const int shift = 64 - SPILL_PARTITION_BITS * (level + 1);
+  return static_cast<int>((hash >> shift) & (SPILL_FANOUT - 1));
+}
+
+RC HashJoinPhysicalOperator::create_spill_partitions(int level, vector<SpillPartition> &partitions)
+{
+  static atomic<uint64_t> file_sequence{0};
+
+  const string directory =
+      spill_directory_.empty() ? filesystem::temp_directory_path().string() : spill_directory_;
+
+  partitions.resize(SPILL_FANOUT);
+  for (SpillPartition &partition : partitions) {
+    const string file_prefix = directory + "/hash_join." + to_string(getpid()) + "." + to_string(file_sequence++);
+
+    partition.level = level;
+    partition.build = make_unique<SpillFile>();
+    partition.probe = make_unique<SpillFile>();
+
+    RC rc = partition.build->create(file_prefix + ".build.spill");
+    if (OB_SUCC(rc)) {
+      rc = partition.probe->create(file_prefix + ".probe.spill");
+    }
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to create spill files of hash join. prefix=%s, rc=%s", file_prefix.c_str(), strrc(rc));
+      return rc;
+    }
+  }
+
+  spill_partition_num_ += SPILL_FANOUT;
+  return RC::SUCCESS;
+}
+
+RC HashJoinPhysicalOperator::spill_row(SpillFile &file, uint64_t hash, const char *data, int len)
+{
+  const int64_t size = file.size();
+  RC            rc   = file.append(hash, data, len);
+  spill_bytes_ += file.size() - size;
+  return rc;
+}
+
+RC HashJoinPhysicalOperator::spill_build_side(bool vectorized)
+{
+  LOG_INFO("hash join build side exceeds memory limit, spill to disk. memory used=%lu, memory limit=%lu, rows=%lu",
+      memory_used_, memory_limit_, hash_table_.size());
+
+  RC rc = create_spill_partitions(0, spill_partitions_);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  if (!vectorized) {
+    collect_specs(build_tuples_.front(), build_specs_);
+  }
+
+  for (uint32_t row = 0; row < hash_table_.size() && OB_SUCC(rc); row++) {
+    if (vectorized) {
+      const ChunkRow &location = build_rows_[row];
+      encode_chunk_row(*build_chunks_[location.chunk], location.row, row_buffer_);
+    } else {
+      encode_tuple(build_tuples_[row].cells(), row_buffer_);
+    }
+
+    const uint64_t hash = hash_table_.hash(row);
+    rc = spill_row(*spill_partitions_[spill_partition_of(hash, 0)].build, hash, row_buffer_.data(), row_buffer_.size());
+  }
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to spill build side of hash join. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  spilled_ = true;
+  clear_build_side();
+  return RC::SUCCESS;
+}
+
+RC HashJoinPhysicalOperator::spill_probe_side(bool vectorized)
+{
+  RC rc = RC::SUCCESS;
+  if (!vectorized) {
+    while (OB_SUCC(rc = left_->next())) {
+      ValueListTuple row;
+      rc = ValueListTuple::make(*left_->current_tuple(), row);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to copy tuple of probe side. rc=%s", strrc(rc));
+        return rc;
+      }
+      if (probe_specs_.empty()) {
+        collect_specs(row, probe_specs_);
+      }
+
+      uint64_t hash = 0;
+      rc            = eval_keys(left_keys_, row, probe_keys_.data(), hash);
+      if (OB_SUCC(rc)) {
+        encode_tuple(row.cells(), row_buffer_);
+        SpillFile &file = *spill_partitions_[spill_partition_of(hash, 0)].probe;
+        rc              = spill_row(file, hash, row_buffer_.data(), row_buffer_.size());
+      }
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+  } else {
+    Chunk chunk;
+    while (OB_SUCC(rc = left_->next(chunk))) {
+      rc = chunk.compact();
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+
+      const int rows = chunk.rows();
+      if (probe_schema_.empty() && rows > 0) {
+        for (int i = 0; i < chunk.column_num(); i++) {
+          probe_schema_.emplace_back(chunk.column(i).attr_type(), chunk.column(i).attr_len());
+        }
+      }
+
+      Chunk key_chunk;
+      probe_hashes_.resize(rows);
+      rc = eval_key_columns(left_keys_, chunk, key_chunk, probe_hashes_.data());
+      for (int i = 0; i < rows && OB_SUCC(rc); i++) {
+        encode_chunk_row(chunk, i, row_buffer_);
+        SpillFile &file = *spill_partitions_[spill_partition_of(probe_hashes_[i], 0)].probe;
+        rc              = spill_row(file, probe_hashes_[i], row_buffer_.data(), row_buffer_.size());
+      }
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+      chunk.reset();
+    }
+    probe_hashes_.clear();
+  }
+
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to read probe side. rc=%s", strrc(rc));
+    return rc;
+  }
+  return RC::SUCCESS;
+}
+
+RC HashJoinPhysicalOperator::repartition(SpillPartition &partition, vector<SpillPartition> &children)
+{
+  vector<SpillPartition> partitions;
+  RC                     rc = create_spill_partitions(partition.level + 1, partitions);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  for (bool build_side : {true, false}) {
+    SpillFile &file = build_side ? *partition.build : *partition.probe;
+    rc              = file.rewind();
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    uint64_t    hash = 0;
+    const char *data = nullptr;
+    int         len  = 0;
+    while (OB_SUCC(rc = file.next(hash, data, len))) {
+      SpillPartition &child = partitions[spill_partition_of(hash, partition.level + 1)];
+      rc                    = spill_row(build_side ? *child.build : *child.probe, hash, data, len);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+    if (rc != RC::RECORD_EOF) {
+      LOG_WARN("failed to read spill file. path=%s, rc=%s", file.path().c_str(), strrc(rc));
+      return rc;
+    }
+  }
+
+  LOG_TRACE("hash join repartitioned. level=%d, build bytes=%ld, probe bytes=%ld",
+      partition.level + 1, partition.build->size(), partition.probe->size());
+  for (SpillPartition &child : partitions) {
+    children.push_back(std::move(child));
+  }
+  return RC::SUCCESS;
+}
+
+RC HashJoinPhysicalOperator::next_spill_partition(bool vectorized)
+{
+  clear_build_side();
+  current_partition_ = SpillPartition();
+
+  while (!spill_partitions_.empty()) {
+    SpillPartition partition = std::move(spill_partitions_.back());
+    spill_partitions_.pop_back();
+
+    // 有一边没有数据的分区不会产生结果
+    if (partition.build->record_num() == 0 || partition.probe->record_num() == 0) {
+      continue;
+    }
+
+    const size_t memory_size =
+        partition.build->size() + partition.build->record_num() * row_memory_size(vectorized);
+    if (memory_limit_ != 0 && memory_size > memory_limit_) {
+      if (partition.level + 1 < MAX_SPILL_LEVEL) {
+        RC rc = repartition(partition, spill_partitions_);
+        if (OB_FAIL(rc)) {
+          return rc;
+        }
+        continue;
+      }
+
+      // 连接键相同的行太多时，再分区也没有用
+      LOG_INFO("spill partition of hash join is still too large. level=%d, memory size=%lu, memory limit=%lu",
+          partition.level, memory_size, memory_limit_);
+    }
+
+    RC rc = load_spill_partition(partition, vectorized);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    current_partition_ = std::move(partition);
+    return RC::SUCCESS;
+  }
+  return RC::RECORD_EOF;
+}
+
+RC HashJoinPhysicalOperator::load_spill_partition(SpillPartition &partition, bool vectorized)
+{
+  RC rc = partition.build->rewind();
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  if (!vectorized) {
+    uint64_t    hash = 0;
+    const char *data = nullptr;
+    int         len  = 0;
+    while (OB_SUCC(rc = partition.build->next(hash, data, len))) {
+      vector<Value> cells;
+      decode_tuple(data, len, cells);
+
+      ValueListTuple row;
+      row.set_names(build_specs_);
+      row.set_cells(std::move(cells));
+
+      uint64_t key_hash = 0;
+      rc                = eval_keys(right_keys_, row, probe_keys_.data(), key_hash);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+      add_build_tuple(std::move(row), probe_keys_.data(), hash);
+    }
+    probe_tuple_.set_names(probe_specs_);
+  } else {
+    vector<uint64_t> hashes;
+    while (true) {
+      auto chunk = make_unique<Chunk>();
+      rc         = read_spill_chunk(*partition.build, build_schema_, *chunk, &hashes);
+      if (OB_FAIL(rc)) {
+        break;
+      }
+      rc = add_build_chunk(std::move(chunk), hashes.data());
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+  }
+
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to load spill partition. path=%s, rc=%s", partition.build->path().c_str(), strrc(rc));
+    return rc;
+  }
+
+  hash_table_.build(partition_threshold_);
+  LOG_TRACE("hash join spill partition loaded. level=%d, rows=%lu", partition.level, hash_table_.size());
+  return partition.probe->rewind();
+}
+
+void HashJoinPhysicalOperator::encode_tuple(const vector<Value> &cells, vector<char> &buffer)
+{
+  buffer.clear();
+  for (const Value &cell : cells) {
+    const int32_t type   = static_cast<int32_t>(cell.attr_type());
+    const int32_t length = cell.length();
+    const char   *data   = cell.data();
+    buffer.insert(buffer.end(), reinterpret_cast<const char *>(&type), reinterpret_cast<const char *>(&type + 1));
+    buffer.insert(buffer.end(), reinterpret_cast<const char *>(&length), reinterpret_cast<const char *>(&length + 1));
+    buffer.insert(buffer.end(), data, data + length);
+  }
+}
+
+void HashJoinPhysicalOperator::decode_tuple(const char *data, int len, vector<Value> &cells)
+{
+  const char *end = data + len;
+  while (data < end) {
+    int32_t type   = 0;
+    int32_t length = 0;
+    memcpy(&type, data, sizeof(type));
+    memcpy(&length, data + sizeof(type), sizeof(length));
+    data += sizeof(type) + sizeof(length);
+
+    Value value;
+    const AttrType attr_type = static_cast<AttrType>(type);
+    if (attr_type == AttrType::BOOLEANS) {
+      value.set_boolean(length > 0 && *data != 0);
+    } else if (length == 0 && (attr_type == AttrType::CHARS || attr_type == AttrType::TEXT)) {
+      value.set_string("");
+      value.set_type(attr_type);
+    } else {
+      value.set_type(attr_type);
+      if (length > 0) {
+        value.set_data(data, length);
+      }
+    }
+    cells.emplace_back(std::move(value));
+    data += length;
+  }
+}
+
+void HashJoinPhysicalOperator::encode_chunk_row(const Chunk &chunk, int row, vector<char> &buffer)
+{
+  buffer.clear();
+  for (int i = 0; i < chunk.column_num(); i++) {
+    const Column &column = chunk.column(i);
+    const char   *data   = column_data(column, row);
+    buffer.insert(buffer.end(), data, data + column.attr_len());
+  }
+}
+
+RC HashJoinPhysicalOperator::read_spill_chunk(
+    SpillFile &file, const vector<pair<AttrType, int>> &schema, Chunk &chunk, vector<uint64_t> *hashes)
+{
+  if (chunk.column_num() == 0) {
+    for (size_t i = 0; i < schema.size(); i++) {
+      chunk.add_column(make_unique<Column>(schema[i].first, schema[i].second, Chunk::MAX_ROWS), i);
+    }
+  }
+  chunk.reset_data();
+  if (hashes != nullptr) {
+    hashes->clear();
+  }
+
+  RC          rc   = RC::SUCCESS;
+  uint64_t    hash = 0;
+  const char *data = nullptr;
+  int         len  = 0;
+  while (chunk.rows() < Chunk::MAX_ROWS && OB_SUCC(rc = file.next(hash, data, len))) {
+    for (int i = 0; i < chunk.column_num(); i++) {
+      Column &column = chunk.column(i);
+      column.append_one(data);
+      data += column.attr_len();
+    }
+    if (hashes != nullptr) {
+      hashes->push_back(hash);
+    }
+  }
+
+  if (OB_FAIL(rc) && rc != RC::RECORD_EOF) {
+    return rc;
+  }
+  return chunk.rows() == 0 ? RC::RECORD_EOF : RC::SUCCESS;
+}
@@ -10,12 +10,174 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include "sql/expr/join_hash_table.h"
 #include "sql/operator/physical_operator.h"
 #include "sql/parser/parse.h"
+#include "storage/common/chunk.h"
+#include "storage/common/spill_file.h"
 
 /**
  * @brief Hash Join 算子
  * @ingroup PhysicalOperator
+ * @details 等值连接。先把右孩子(构建侧)的数据全部读出来，按照连接键建立哈希表(JoinHashTable)，
+ * 然后逐个读取左孩子(探测侧)的数据，在哈希表中查找连接键相等的行。这样每个孩子只需要遍历一次。
+ *
+ * 同时支持火山模型(next())和向量化模型(next(Chunk &))，在第一次调用时构建哈希表。
+ * 向量化模型下，一次计算探测侧整个 Chunk 的哈希值并批量查找，然后按列把结果拷贝到输出的 Chunk 中，
+ * 输出的 Chunk 中依次是左孩子和右孩子的所有列。
+ *
+ * 连接键当前支持 INTS、DATES 和 CHARS 类型，由 PhysicalPlanGenerator::can_use_hash_join 判断。
+ *
+ * 构建侧占用的内存超过 memory_limit 时，转为 grace hash join：按哈希值的高位把构建侧和探测侧都分成
+ * SPILL_FANOUT 个分区写到临时文件中，然后依次连接每一对分区。一个分区的构建侧仍然放不下时，
+ * 使用哈希值中接下来的几位递归地再分区，最多 MAX_SPILL_LEVEL 层。
  */
-class HashJoinPhysicalOperator
-{};
\ No newline at end of file
+class HashJoinPhysicalOperator : public PhysicalOperator
+{
+public:
+  static constexpr int SPILL_PARTITION_BITS = 4;  ///< 每一层溢出分区使用哈希值的多少位
+  static constexpr int SPILL_FANOUT         = 1 << SPILL_PARTITION_BITS;
+  static constexpr int MAX_SPILL_LEVEL      = 4;
+
+  /**
+   * @param left_keys  左孩子中的连接键
+   * @param right_keys 右孩子中的连接键，与 left_keys 一一对应
+   */
+  HashJoinPhysicalOperator(vector<unique_ptr<Expression>> &&left_keys, vector<unique_ptr<Expression>> &&right_keys);
+  virtual ~HashJoinPhysicalOperator() = default;
+
+  PhysicalOperatorType type() const override { return PhysicalOperatorType::HASH_JOIN; }
+
+  OpType get_op_type() const override { return OpType::INNERHASHJOIN; }
+
+  string param() const override;
+
+  RC     open(Trx *trx) override;
+  RC     next() override;
+  RC     next(Chunk &chunk) override;
+  RC     close() override;
+  Tuple *current_tuple() override;
+
+  /**
+   * @brief 设置构建侧的哈希表超过多少字节时分区，默认是L2缓存的大小
+   */
+  void set_partition_threshold(size_t partition_threshold) { partition_threshold_ = partition_threshold; }
+
+  /**
+   * @brief 构建侧分成了多少个分区。构建之前返回1
+   */
+  int partition_num() const { return hash_table_.partition_num(); }
+
+  /**
+   * @brief 设置构建侧最多使用多少字节的内存，0表示不限制
+   */
+  void set_memory_limit(size_t memory_limit) { memory_limit_ = memory_limit; }
+
+  /**
+   * @brief 设置溢出的临时文件放在哪个目录，默认是系统的临时目录
+   */
+  void set_spill_directory(const string &spill_directory) { spill_directory_ = spill_directory; }
+
+  int64_t spill_bytes() const { return spill_bytes_; }                ///< 一共写了多少字节的临时文件
+  int     spill_partition_num() const { return spill_partition_num_; }  ///< 一共创建了多少对溢出分区
+
+private:
+  /// 构建侧在 build_chunks_ 中的位置
+  struct ChunkRow
+  {
+    uint32_t chunk;
+    uint32_t row;
+  };
+
+  /// 溢出到文件中的一对分区
+  struct SpillPartition
+  {
+    unique_ptr<SpillFile> build;
+    unique_ptr<SpillFile> probe;
+    int                   level = 0;  ///< 第几层分区，决定使用哈希值的哪几位
+  };
+
+  RC build();        //! 火山模型下读取右孩子，构建哈希表
+  RC build_chunk();  //! 向量化模型下读取右孩子，构建哈希表
+
+  RC   probe_chunk();                                    //! 读取左孩子的下一个 Chunk，并批量查找哈希表
+  bool chunk_keys_equal(int probe_row, uint32_t build_row);  //! 比较探测侧和构建侧的连接键
+  RC   output_chunk(Chunk &chunk);                        //! 把匹配的行按列拷贝到输出的 Chunk 中
+
+  RC eval_keys(vector<unique_ptr<Expression>> &keys, const Tuple &tuple, Value *values, uint64_t &hash);
+  RC eval_key_columns(vector<unique_ptr<Expression>> &keys, Chunk &chunk, Chunk &key_chunk, uint64_t *hashes);
+
+  void add_build_tuple(ValueListTuple &&row, const Value *keys, uint64_t hash);  //! 火山模型下把一行加到内存中
+  RC   add_build_chunk(unique_ptr<Chunk> chunk, const uint64_t *hashes);  //! 向量化模型下把一个 Chunk 加到内存中
+  void clear_build_side();                                               //! 清空内存中的构建侧
+  size_t row_memory_size(bool vectorized) const;  //! 除了行数据之外，构建侧每一行额外占用的内存
+  bool   over_memory_limit() const { return memory_limit_ != 0 && memory_used_ > memory_limit_; }
+
+  static int spill_partition_of(uint64_t hash, int level);
+  RC create_spill_partitions(int level, vector<SpillPartition> &partitions);
+  RC spill_row(SpillFile &file, uint64_t hash, const char *data, int len);
+  RC spill_build_side(bool vectorized);  //! 把内存中的构建侧写到第0层的分区中，之后的行直接写到文件中
+  RC spill_probe_side(bool vectorized);  //! 把探测侧全部写到第0层的分区中
+  RC repartition(SpillPartition &partition, vector<SpillPartition> &children);
+  RC next_spill_partition(bool vectorized);  //! 加载下一对分区的构建侧，没有时返回 RECORD_EOF
+  RC load_spill_partition(SpillPartition &partition, bool vectorized);
+
+  static void encode_tuple(const vector<Value> &cells, vector<char> &buffer);
+  static void decode_tuple(const char *data, int len, vector<Value> &cells);
+  static void encode_chunk_row(const Chunk &chunk, int row, vector<char> &buffer);
+  static RC   read_spill_chunk(
+        SpillFile &file, const vector<pair<AttrType, int>> &schema, Chunk &chunk, vector<uint64_t> *hashes);
+
+private:
+  vector<unique_ptr<Expression>> left_keys_;
+  vector<unique_ptr<Expression>> right_keys_;
+
+  size_t        partition_threshold_;
+  JoinHashTable hash_table_;
+  bool          built_    = false;  //! 是否已经构建了哈希表
+  bool          executed_ = false;  //! 是否执行过，执行过之后 param 中输出溢出的统计信息
+
+  // 内存限制和溢出
+  size_t                 memory_limit_ = 0;
+  size_t                 memory_used_  = 0;  //! 内存中的构建侧大约占用了多少字节
+  string                 spill_directory_;
+  bool                   spilled_             = false;
+  int64_t                spill_bytes_         = 0;
+  int                    spill_partition_num_ = 0;
+  vector<SpillPartition> spill_partitions_;   //! 还没有连接的分区，后进先出
+  SpillPartition         current_partition_;  //! 正在连接的分区，探测侧从它的文件中读取
+  vector<char>           row_buffer_;         //! 编码一行时使用的缓冲区
+
+  PhysicalOperator *left_  = nullptr;
+  PhysicalOperator *right_ = nullptr;
+
+  // 火山模型
+  vector<ValueListTuple> build_tuples_;  //! 构建侧所有的行
+  vector<Value>          build_keys_;    //! 构建侧每一行的连接键
+  vector<Value>          probe_keys_;    //! 探测侧当前行的连接键
+  uint64_t               probe_hash_  = 0;
+  uint32_t               probe_match_ = JoinHashTable::INVALID_ROW;  //! 探测侧当前行下一个要比较的构建侧行
+  JoinedTuple            joined_tuple_;
+  vector<TupleCellSpec>  build_specs_;  //! 构建侧的列，从文件中读出来的行使用
+  vector<TupleCellSpec>  probe_specs_;
+  ValueListTuple         probe_tuple_;  //! 从文件中读出来的探测侧的行
+
+  // 向量化模型
+  vector<unique_ptr<Chunk>> build_chunks_;      //! 构建侧所有的数据
+  vector<unique_ptr<Chunk>> build_key_chunks_;  //! 构建侧的连接键，与 build_chunks_ 一一对应
+  vector<ChunkRow>          build_rows_;        //! 构建侧每一行所在的位置
+
+  Chunk            probe_chunk_;      //! 探测侧当前的 Chunk
+  Chunk            probe_key_chunk_;  //! 探测侧当前 Chunk 的连接键
+  vector<uint64_t> probe_hashes_;
+  vector<uint32_t> probe_heads_;
+  int              probe_row_ = 0;  //! 探测侧当前 Chunk 中正在处理的行
+
+  vector<pair<AttrType, int>> build_schema_;  //! 构建侧每一列的类型和长度，从文件中读取时使用
+  vector<pair<AttrType, int>> probe_schema_;
+  Chunk                       spill_chunk_;  //! 从文件中读出来的探测侧的 Chunk
+
+  vector<uint32_t> output_left_rows_;   //! 匹配的探测侧行
+  vector<uint32_t> output_right_rows_;  //! 匹配的构建侧行
+  Chunk            output_chunk_;
+};
\ No newline at end of file
@@ -16,21 +16,16 @@ See the Mulan PSL v2 for more details. */
 #include "storage/index/index.h"
 #include "storage/trx/trx.h"
 
-IndexScanPhysicalOperator::IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode, const Value *left_value,
-    bool left_inclusive, const Value *right_value, bool right_inclusive)
+IndexScanPhysicalOperator::IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode,
+    const vector<Value> &left_values, bool left_inclusive, const vector<Value> &right_values, bool right_inclusive)
     : table_(table),
       index_(index),
       mode_(mode),
+      left_values_(left_values),
+      right_values_(right_values),
       left_inclusive_(left_inclusive),
       right_inclusive_(right_inclusive)
-{
-  if (left_value) {
-    left_value_ = *left_value;
-  }
-  if (right_value) {
-    right_value_ = *right_value;
-  }
-}
+{}
 
 RC IndexScanPhysicalOperator::open(Trx *trx)
 {
@@ -38,11 +33,16 @@ RC IndexScanPhysicalOperator::open(Trx *trx)
     return RC::INTERNAL;
   }
 
-  IndexScanner *index_scanner = index_->create_scanner(left_value_.data(),
-      left_value_.length(),
+  string left_key;
+  string right_key;
+  make_key(left_values_, left_key);
+  make_key(right_values_, right_key);
+
+  IndexScanner *index_scanner = index_->create_scanner(left_values_.empty() ? nullptr : left_key.data(),
+      static_cast<int>(left_key.size()),
       left_inclusive_,
-      right_value_.data(),
-      right_value_.length(),
+      right_values_.empty() ? nullptr : right_key.data(),
+      static_cast<int>(right_key.size()),
       right_inclusive_);
   if (nullptr == index_scanner) {
     LOG_WARN("failed to create index scanner");
@@ -65,7 +65,11 @@ RC IndexScanPhysicalOperator::next()
   bool filter_result = false;
   while (RC::SUCCESS == (rc = index_scanner_->next_entry(&rid))) {
     rc = table_->get_record(rid, current_record_);
-    if (OB_FAIL(rc)) {
+    if (rc == RC::RECORD_NOT_EXIST) {
+      // 拿到索引项之后，记录被 MvccVacuum 清理掉了。这样的记录对所有事务都不可见，直接跳过
+      LOG_TRACE("record has been purged. rid=%s", rid.to_string().c_str());
+      continue;
+    } else if (OB_FAIL(rc)) {
       LOG_TRACE("failed to get record. rid=%s, rc=%s", rid.to_string().c_str(), strrc(rc));
       return rc;
     }
@@ -135,6 +139,24 @@ RC IndexScanPhysicalOperator::filter(RowTuple &tuple, bool &result)
   return rc;
 }
 
+void IndexScanPhysicalOperator::make_key(const vector<Value> &values, string &key) const
+{
+  key.clear();
+  const vector<FieldMeta> &field_metas = index_->field_metas();
+  if (field_metas.size() == 1 && values.size() == 1) {
+    key.assign(values.front().data(), values.front().length());
+    return;
+  }
+
+  for (size_t i = 0; i < values.size() && i < field_metas.size(); i++) {
+    const Value &value  = values[i];
+    const int    length = field_metas[i].len();
+    const size_t offset = key.size();
+    key.resize(offset + length, '\0');
+    memcpy(key.data() + offset, value.data(), std::min(length, value.length()));
+  }
+}
+
 string IndexScanPhysicalOperator::param() const
 {
   return string(index_->index_meta().name()) + " ON " + table_->name();
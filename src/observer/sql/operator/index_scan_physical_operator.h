@@ -21,12 +21,14 @@ See the Mulan PSL v2 for more details. */
 /**
  * @brief 索引扫描物理算子
  * @ingroup PhysicalOperator
+ * @details 扫描范围的左右边界按照索引字段的顺序给出，可以只包含前面几个字段，值的类型需要与字段类型一致。
+ * 边界为空表示没有这一侧的边界。
  */
 class IndexScanPhysicalOperator : public PhysicalOperator
 {
 public:
-  IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode, const Value *left_value,
-      bool left_inclusive, const Value *right_value, bool right_inclusive);
+  IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode, const vector<Value> &left_values,
+      bool left_inclusive, const vector<Value> &right_values, bool right_inclusive);
 
   virtual ~IndexScanPhysicalOperator() = default;
 
@@ -46,6 +48,12 @@ private:
   // 与TableScanPhysicalOperator代码相同，可以优化
   RC filter(RowTuple &tuple, bool &result);
 
+  /**
+   * @brief 把边界的值按照索引字段拼成键值
+   * @details 单个字段时直接使用值本身，由索引处理字符串的长度。多个字段时每个字段按照字段长度补齐
+   */
+  void make_key(const vector<Value> &values, string &key) const;
+
 private:
   Trx          *trx_           = nullptr;
   Table        *table_         = nullptr;
@@ -56,10 +64,10 @@ private:
   Record   current_record_;
   RowTuple tuple_;
 
-  Value left_value_;
-  Value right_value_;
-  bool  left_inclusive_  = false;
-  bool  right_inclusive_ = false;
+  vector<Value> left_values_;
+  vector<Value> right_values_;
+  bool          left_inclusive_  = false;
+  bool          right_inclusive_ = false;
 
   vector<unique_ptr<Expression>> predicates_;
 };
@@ -60,6 +60,8 @@ RC NestedLoopJoinPhysicalOperator::next()
         return rc;
       }
     }
+
+    return rc;
   }
   return rc;
 }
@@ -25,8 +25,6 @@ RC TableScanVecPhysicalOperator::open(Trx *trx)
   for (int i = 0; i < table_->table_meta().field_num(); ++i) {
     all_columns_.add_column(
         make_unique<Column>(*table_->table_meta().field(i)), table_->table_meta().field(i)->field_id());
-    filterd_columns_.add_column(
-        make_unique<Column>(*table_->table_meta().field(i)), table_->table_meta().field(i)->field_id());
   }
   return rc;
 }
@@ -35,32 +33,42 @@ RC TableScanVecPhysicalOperator::next(Chunk &chunk)
 {
   RC rc = RC::SUCCESS;
 
-  all_columns_.reset_data();
-  filterd_columns_.reset_data();
-  if (OB_SUCC(rc = chunk_scanner_.next_chunk(all_columns_))) {
-    select_.assign(all_columns_.rows(), 1);
+  while (true) {
+    all_columns_.reset_data();
+    if (OB_FAIL(rc = chunk_scanner_.next_chunk(all_columns_))) {
+      return rc;
+    }
+
     if (predicates_.empty()) {
-      chunk.reference(all_columns_);
-    } else {
-      rc = filter(all_columns_);
-      if (rc != RC::SUCCESS) {
-        LOG_TRACE("filtered failed=%s", strrc(rc));
-        return rc;
-      }
-      // TODO: if all setted, it doesn't need to set one by one
-      for (int i = 0; i < all_columns_.rows(); i++) {
-        if (select_[i] == 0) {
-          continue;
-        }
-        for (int j = 0; j < all_columns_.column_num(); j++) {
-          filterd_columns_.column(j).append_value(
-              all_columns_.column(filterd_columns_.column_ids(j)).get_value(i));
-        }
-      }
-      chunk.reference(filterd_columns_);
+      return chunk.reference(all_columns_);
+    }
+
+    const int rows = all_columns_.rows();
+    select_.assign(rows, 1);
+    rc = filter(all_columns_);
+    if (rc != RC::SUCCESS) {
+      LOG_TRACE("filtered failed=%s", strrc(rc));
+      return rc;
     }
+
+    // 不拷贝过滤后的数据，只记录哪些行是有效的，由下游算子按照选择向量读取
+    selection_.resize(rows);
+    int selected = 0;
+    for (int i = 0; i < rows; i++) {
+      selection_[selected] = i;
+      selected += select_[i] != 0;
+    }
+
+    if (selected == 0) {
+      continue;
+    }
+
+    rc = chunk.reference(all_columns_);
+    if (OB_SUCC(rc) && selected < rows) {
+      chunk.set_selection(selection_.data(), selected);
+    }
+    return rc;
   }
-  return rc;
 }
 
 RC TableScanVecPhysicalOperator::close() { return chunk_scanner_.close_scan(); }
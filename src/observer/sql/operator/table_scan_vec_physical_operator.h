@@ -46,7 +46,7 @@ private:
   ReadWriteMode                  mode_  = ReadWriteMode::READ_WRITE;
   ChunkFileScanner               chunk_scanner_;
   Chunk                          all_columns_;
-  Chunk                          filterd_columns_;
   vector<uint8_t>                select_;
+  vector<int>                    selection_;  ///< 过滤之后有效的行号
   vector<unique_ptr<Expression>> predicates_;
 };
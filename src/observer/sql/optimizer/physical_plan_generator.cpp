@@ -13,7 +13,9 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "common/log/log.h"
+#include "common/lang/unordered_map.h"
 #include "sql/expr/expression.h"
+#include "sql/expr/expression_iterator.h"
 #include "session/session.h"
 #include "sql/operator/aggregate_vec_physical_operator.h"
 #include "sql/operator/calc_logical_operator.h"
@@ -45,6 +47,9 @@ See the Mulan PSL v2 for more details. */
 #include "sql/optimizer/physical_plan_generator.h"
 #include "sql/operator/order_by_logical_operator.h"
 #include "sql/operator/order_by_physical_operator.h"
+#include "storage/db/db.h"
+#include "storage/index/index.h"
+#include "storage/table/table.h"
 
 using namespace std;
 
@@ -120,6 +125,9 @@ RC PhysicalPlanGenerator::create_vec(
     case LogicalOperatorType::EXPLAIN: {
       return create_vec_plan(static_cast<ExplainLogicalOperator &>(logical_operator), oper, session);
     } break;
+    case LogicalOperatorType::JOIN: {
+      return create_vec_plan(static_cast<JoinLogicalOperator &>(logical_operator), oper, session);
+    } break;
     default: {
       LOG_WARN("unknown logical operator type: %d", logical_operator.type());
       return RC::INVALID_ARGUMENT;
@@ -128,6 +136,204 @@ RC PhysicalPlanGenerator::create_vec(
   return rc;
 }
 
+namespace {
+
+/**
+ * @brief 可以用于索引查找的条件
+ * @details 字段与常量比较的条件，字段统一放在比较的左边
+ */
+struct IndexPredicate
+{
+  const FieldMeta *field = nullptr;
+  CompOp           comp  = NO_OP;
+  const Value     *value = nullptr;
+};
+
+/**
+ * @brief 从过滤条件中找出字段与常量比较的条件
+ */
+vector<IndexPredicate> collect_index_predicates(vector<unique_ptr<Expression>> &predicates)
+{
+  vector<IndexPredicate> index_predicates;
+  for (auto &expr : predicates) {
+    if (expr->type() != ExprType::COMPARISON) {
+      continue;
+    }
+
+    auto                    comparison_expr = static_cast<ComparisonExpr *>(expr.get());
+    unique_ptr<Expression> &left_expr       = comparison_expr->left();
+    unique_ptr<Expression> &right_expr      = comparison_expr->right();
+
+    IndexPredicate predicate;
+    predicate.comp = comparison_expr->comp();
+    if (left_expr->type() == ExprType::FIELD && right_expr->type() == ExprType::VALUE) {
+      predicate.field = static_cast<FieldExpr *>(left_expr.get())->field().meta();
+      predicate.value = &static_cast<ValueExpr *>(right_expr.get())->get_value();
+    } else if (right_expr->type() == ExprType::FIELD && left_expr->type() == ExprType::VALUE) {
+      predicate.field = static_cast<FieldExpr *>(right_expr.get())->field().meta();
+      predicate.value = &static_cast<ValueExpr *>(left_expr.get())->get_value();
+      // 常量在左边时，交换比较的方向
+      switch (predicate.comp) {
+        case LESS_THAN: predicate.comp = GREAT_THAN; break;
+        case LESS_EQUAL: predicate.comp = GREAT_EQUAL; break;
+        case GREAT_THAN: predicate.comp = LESS_THAN; break;
+        case GREAT_EQUAL: predicate.comp = LESS_EQUAL; break;
+        default: break;
+      }
+    } else {
+      continue;
+    }
+
+    // 类型不同时需要转换，转换后的比较结果不一定一致，简单起见不使用索引
+    if (predicate.field == nullptr || predicate.field->type() != predicate.value->attr_type()) {
+      continue;
+    }
+    index_predicates.push_back(predicate);
+  }
+  return index_predicates;
+}
+
+/**
+ * @brief 索引的扫描范围
+ */
+struct IndexScanRange
+{
+  vector<Value> left_values;
+  vector<Value> right_values;
+  bool          left_inclusive  = true;
+  bool          right_inclusive = true;
+
+  int  equal_num = 0;      ///< 使用等值条件的字段个数
+  bool has_range = false;  ///< 最后一个字段是否使用了范围条件
+};
+
+/**
+ * @brief 按照最左前缀的规则，计算索引的扫描范围
+ * @details 索引前面的字段使用等值条件，紧跟着的一个字段可以使用范围条件。
+ * 过滤条件仍然会在扫描时计算，所以这里得到的范围可以比实际的结果大。
+ */
+IndexScanRange match_index(const Index &index, const vector<IndexPredicate> &predicates)
+{
+  IndexScanRange range;
+
+  const vector<FieldMeta> &field_metas = index.field_metas();
+  auto find_predicate = [&predicates](const FieldMeta &field_meta, CompOp comp1, CompOp comp2) -> const IndexPredicate * {
+    for (const IndexPredicate &predicate : predicates) {
+      if (0 == strcmp(predicate.field->name(), field_meta.name()) &&
+          (predicate.comp == comp1 || predicate.comp == comp2)) {
+        return &predicate;
+      }
+    }
+    return nullptr;
+  };
+
+  size_t field_index = 0;
+  for (; field_index < field_metas.size(); field_index++) {
+    const IndexPredicate *predicate = find_predicate(field_metas[field_index], EQUAL_TO, EQUAL_TO);
+    if (predicate == nullptr) {
+      break;
+    }
+    range.left_values.push_back(*predicate->value);
+    range.right_values.push_back(*predicate->value);
+    range.equal_num++;
+  }
+
+  // 只有等值的前缀，才能继续使用后面字段的范围条件
+  if (range.equal_num == 0 || field_index >= field_metas.size()) {
+    return range;
+  }
+
+  const FieldMeta &field_meta = field_metas[field_index];
+  // 字符串比字段长时会被截断，作为范围的边界就不准确了
+  auto usable = [&field_meta](const IndexPredicate *predicate) {
+    return predicate != nullptr && predicate->value->length() <= field_meta.len();
+  };
+
+  const IndexPredicate *lower = find_predicate(field_meta, GREAT_THAN, GREAT_EQUAL);
+  if (usable(lower)) {
+    range.left_values.push_back(*lower->value);
+    range.left_inclusive = lower->comp == GREAT_EQUAL;
+    range.has_range      = true;
+  }
+
+  const IndexPredicate *upper = find_predicate(field_meta, LESS_THAN, LESS_EQUAL);
+  if (usable(upper)) {
+    range.right_values.push_back(*upper->value);
+    range.right_inclusive = upper->comp == LESS_EQUAL;
+    range.has_range       = true;
+  }
+  return range;
+}
+
+/**
+ * @brief 计算向量化执行时，每张表的列在子算子输出的 Chunk 中从哪个位置开始
+ * @details 表扫描输出表的所有列，连接算子依次输出左右两个孩子的所有列。
+ * 分组算子输出的是分组列和聚合列，上层表达式的位置在生成逻辑计划时已经绑定好了
+ * @return 子算子中是否有连接算子。没有时 Chunk 中只有一张表的列，不需要重新绑定
+ */
+bool collect_column_offsets(LogicalOperator &oper, unordered_map<const Table *, int> &offsets, int &column_num)
+{
+  if (oper.type() == LogicalOperatorType::GROUP_BY) {
+    return false;
+  }
+
+  if (oper.type() == LogicalOperatorType::TABLE_GET) {
+    Table *table   = static_cast<TableGetLogicalOperator &>(oper).table();
+    offsets[table] = column_num;
+    column_num += table->table_meta().field_num();
+    return false;
+  }
+
+  bool has_join = oper.type() == LogicalOperatorType::JOIN;
+  for (unique_ptr<LogicalOperator> &child : oper.children()) {
+    has_join = collect_column_offsets(*child, offsets, column_num) || has_join;
+  }
+  return has_join;
+}
+
+RC bind_field_pos(Expression &expr, const unordered_map<const Table *, int> &offsets)
+{
+  if (expr.type() != ExprType::FIELD) {
+    return ExpressionIterator::iterate_child_expr(
+        expr, [&offsets](unique_ptr<Expression> &child) { return bind_field_pos(*child, offsets); });
+  }
+
+  auto &field_expr = static_cast<FieldExpr &>(expr);
+  auto  iter       = offsets.find(field_expr.field().table());
+  if (iter == offsets.end()) {
+    LOG_WARN("cannot find table of field in child operator. field=%s.%s",
+             field_expr.table_name(), field_expr.field_name());
+    return RC::INTERNAL;
+  }
+
+  field_expr.set_pos(iter->second + field_expr.field().meta()->field_id());
+  return RC::SUCCESS;
+}
+
+/**
+ * @brief 向量化执行时，字段表达式默认按照 field_id 从 Chunk 中取列。子算子中有连接时，
+ * 需要按照字段在连接结果中的位置重新绑定
+ */
+template <typename ExprList>
+RC bind_vec_field_pos(LogicalOperator &child_oper, ExprList &expressions)
+{
+  unordered_map<const Table *, int> offsets;
+  int                               column_num = 0;
+  if (!collect_column_offsets(child_oper, offsets, column_num)) {
+    return RC::SUCCESS;
+  }
+
+  for (auto &expr : expressions) {
+    RC rc = bind_field_pos(*expr, offsets);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+}  // namespace
+
 RC PhysicalPlanGenerator::create_plan(
     TableGetLogicalOperator &table_get_oper, unique_ptr<PhysicalOperator> &oper, Session *session)
 {
@@ -135,57 +341,40 @@ RC PhysicalPlanGenerator::create_plan(
   // 看看是否有可以用于索引查找的表达式
   Table *table = table_get_oper.table();
 
-  Index     *index      = nullptr;
-  ValueExpr *value_expr = nullptr;
-  for (auto &expr : predicates) {
-    if (expr->type() == ExprType::COMPARISON) {
-      auto comparison_expr = static_cast<ComparisonExpr *>(expr.get());
-      // 简单处理，就找等值查询
-      if (comparison_expr->comp() != EQUAL_TO && comparison_expr->comp() != NOT_EQUAL) {
-        continue;
-      }
+  // 选择等值前缀最长的索引，前缀一样长时优先选择还能使用范围条件的
+  const vector<IndexPredicate> index_predicates = collect_index_predicates(predicates);
 
-      unique_ptr<Expression> &left_expr  = comparison_expr->left();
-      unique_ptr<Expression> &right_expr = comparison_expr->right();
-      // 左右比较的一边最少是一个值
-      if (left_expr->type() != ExprType::VALUE && right_expr->type() != ExprType::VALUE) {
+  Index         *index = nullptr;
+  IndexScanRange index_range;
+  if (!index_predicates.empty()) {
+    const TableMeta &table_meta = table->table_meta();
+    for (int i = 0; i < table_meta.index_num(); i++) {
+      Index *candidate = table->find_index(table_meta.index(i)->name());
+      if (nullptr == candidate) {
         continue;
       }
 
-      FieldExpr *field_expr = nullptr;
-      if (left_expr->type() == ExprType::FIELD) {
-        ASSERT(right_expr->type() == ExprType::VALUE, "right expr should be a value expr while left is field expr");
-        field_expr = static_cast<FieldExpr *>(left_expr.get());
-        value_expr = static_cast<ValueExpr *>(right_expr.get());
-      } else if (right_expr->type() == ExprType::FIELD) {
-        ASSERT(left_expr->type() == ExprType::VALUE, "left expr should be a value expr while right is a field expr");
-        field_expr = static_cast<FieldExpr *>(right_expr.get());
-        value_expr = static_cast<ValueExpr *>(left_expr.get());
-      }
-
-      if (field_expr == nullptr) {
+      IndexScanRange range = match_index(*candidate, index_predicates);
+      if (range.equal_num == 0) {
         continue;
       }
 
-      const Field &field = field_expr->field();
-      index              = table->find_index_by_field(field.field_name());
-      if (nullptr != index) {
-        break;
+      if (index == nullptr || range.equal_num > index_range.equal_num ||
+          (range.equal_num == index_range.equal_num && range.has_range && !index_range.has_range)) {
+        index       = candidate;
+        index_range = std::move(range);
       }
     }
   }
 
   if (index != nullptr) {
-    ASSERT(value_expr != nullptr, "got an index but value expr is null ?");
-
-    const Value               &value           = value_expr->get_value();
     IndexScanPhysicalOperator *index_scan_oper = new IndexScanPhysicalOperator(table,
         index,
         table_get_oper.read_write_mode(),
-        &value,
-        true /*left_inclusive*/,
-        &value,
-        true /*right_inclusive*/);
+        index_range.left_values,
+        index_range.left_inclusive,
+        index_range.right_values,
+        index_range.right_inclusive);
 
     index_scan_oper->set_predicates(std::move(predicates));
     oper = unique_ptr<PhysicalOperator>(index_scan_oper);
@@ -297,7 +486,7 @@ RC PhysicalPlanGenerator::create_plan(
 
   RC rc = RC::SUCCESS;
 
-  unique_ptr<PhysicalOperator> explain_physical_oper(new ExplainPhysicalOperator);
+  unique_ptr<PhysicalOperator> explain_physical_oper(new ExplainPhysicalOperator(session->explain_analyze()));
   for (unique_ptr<LogicalOperator> &child_oper : child_opers) {
     unique_ptr<PhysicalOperator> child_physical_oper;
     rc = create(*child_oper, child_physical_oper, session);
@@ -324,7 +513,7 @@ RC PhysicalPlanGenerator::create_plan(
     return RC::INTERNAL;
   }
   if (session->hash_join_on() && can_use_hash_join(join_oper)) {
-    // your code here
+    return create_hash_join_plan(join_oper, oper, session, false /*vectorized*/);
   } else {
     unique_ptr<PhysicalOperator> join_physical_oper(new NestedLoopJoinPhysicalOperator());
     for (auto &child_oper : child_opers) {
@@ -338,15 +527,94 @@ RC PhysicalPlanGenerator::create_plan(
       join_physical_oper->add_child(std::move(child_physical_oper));
     }
 
+    // nested loop join 不处理连接条件，由上层的谓词算子过滤
+    vector<unique_ptr<Expression>> &join_predicates = join_oper.get_join_predicates();
+    if (!join_predicates.empty()) {
+      auto conjunction_expr = make_unique<ConjunctionExpr>(ConjunctionExpr::Type::AND, join_predicates);
+      auto predicate_oper   = make_unique<PredicatePhysicalOperator>(std::move(conjunction_expr));
+      predicate_oper->add_child(std::move(join_physical_oper));
+      join_physical_oper = std::move(predicate_oper);
+    }
+
     oper = std::move(join_physical_oper);
   }
   return rc;
 }
 
+RC PhysicalPlanGenerator::create_hash_join_plan(
+    JoinLogicalOperator &join_oper, unique_ptr<PhysicalOperator> &oper, Session *session, bool vectorized)
+{
+  RC rc = RC::SUCCESS;
+
+  vector<unique_ptr<LogicalOperator>> &child_opers = join_oper.children();
+
+  // PredicateToJoinRewriter 保证了比较的左边是左孩子的字段，右边是右孩子的字段
+  vector<unique_ptr<Expression>> left_keys;
+  vector<unique_ptr<Expression>> right_keys;
+  for (unique_ptr<Expression> &predicate : join_oper.get_join_predicates()) {
+    auto comparison_expr = static_cast<ComparisonExpr *>(predicate.get());
+    left_keys.push_back(std::move(comparison_expr->left()));
+    right_keys.push_back(std::move(comparison_expr->right()));
+  }
+  join_oper.clear_join_predicates();
+
+  if (vectorized) {
+    rc = bind_vec_field_pos(*child_opers[0], left_keys);
+    if (OB_SUCC(rc)) {
+      rc = bind_vec_field_pos(*child_opers[1], right_keys);
+    }
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to bind join keys. rc=%s", strrc(rc));
+      return rc;
+    }
+  }
+
+  auto join_physical_oper = make_unique<HashJoinPhysicalOperator>(std::move(left_keys), std::move(right_keys));
+  join_physical_oper->set_memory_limit(session->join_memory_limit());
+  if (session->get_current_db() != nullptr) {
+    join_physical_oper->set_spill_directory(session->get_current_db()->path());
+  }
+  for (auto &child_oper : child_opers) {
+    unique_ptr<PhysicalOperator> child_physical_oper;
+    rc = vectorized ? create_vec(*child_oper, child_physical_oper, session)
+                    : create(*child_oper, child_physical_oper, session);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to create physical child oper. rc=%s", strrc(rc));
+      return rc;
+    }
+
+    join_physical_oper->add_child(std::move(child_physical_oper));
+  }
+
+  oper = std::move(join_physical_oper);
+  return rc;
+}
+
 bool PhysicalPlanGenerator::can_use_hash_join(JoinLogicalOperator &join_oper)
 {
-  // your code here
-  return false;
+  vector<unique_ptr<Expression>> &join_predicates = join_oper.get_join_predicates();
+  if (join_predicates.empty()) {
+    return false;
+  }
+
+  // 连接条件都是 PredicateToJoinRewriter 移过来的字段等值比较，这里只需要检查类型是否支持
+  for (unique_ptr<Expression> &predicate : join_predicates) {
+    if (predicate->type() != ExprType::COMPARISON) {
+      return false;
+    }
+
+    auto *comparison_expr = static_cast<ComparisonExpr *>(predicate.get());
+    if (comparison_expr->comp() != CompOp::EQUAL_TO) {
+      return false;
+    }
+
+    // 浮点数的比较有误差，无法通过哈希值判断是否相等
+    const AttrType key_type = comparison_expr->left()->value_type();
+    if (key_type != AttrType::INTS && key_type != AttrType::DATES && key_type != AttrType::CHARS) {
+      return false;
+    }
+  }
+  return true;
 }
 
 RC PhysicalPlanGenerator::create_plan(
@@ -425,6 +693,18 @@ RC PhysicalPlanGenerator::create_vec_plan(
 {
   RC                           rc            = RC::SUCCESS;
   unique_ptr<PhysicalOperator> physical_oper = nullptr;
+
+  ASSERT(logical_oper.children().size() == 1, "group by operator should have 1 child");
+  LogicalOperator &child_oper = *logical_oper.children().front();
+  rc                          = bind_vec_field_pos(child_oper, logical_oper.group_by_expressions());
+  if (OB_SUCC(rc)) {
+    rc = bind_vec_field_pos(child_oper, logical_oper.aggregate_expressions());
+  }
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to bind expressions of group by(vec) operator. rc=%s", strrc(rc));
+    return rc;
+  }
+
   if (logical_oper.group_by_expressions().empty()) {
     physical_oper = make_unique<AggregateVecPhysicalOperator>(std::move(logical_oper.aggregate_expressions()));
   } else {
@@ -432,9 +712,6 @@ RC PhysicalPlanGenerator::create_vec_plan(
         std::move(logical_oper.group_by_expressions()), std::move(logical_oper.aggregate_expressions()));
   }
 
-  ASSERT(logical_oper.children().size() == 1, "group by operator should have 1 child");
-
-  LogicalOperator             &child_oper = *logical_oper.children().front();
   unique_ptr<PhysicalOperator> child_physical_oper;
   rc = create_vec(child_oper, child_physical_oper, session);
   if (OB_FAIL(rc)) {
@@ -460,7 +737,13 @@ RC PhysicalPlanGenerator::create_vec_plan(
   RC rc = RC::SUCCESS;
   if (!child_opers.empty()) {
     LogicalOperator *child_oper = child_opers.front().get();
-    rc                          = create_vec(*child_oper, child_phy_oper, session);
+    rc                          = bind_vec_field_pos(*child_oper, project_oper.expressions());
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("failed to bind expressions of project operator. rc=%s", strrc(rc));
+      return rc;
+    }
+
+    rc = create_vec(*child_oper, child_phy_oper, session);
     if (rc != RC::SUCCESS) {
       LOG_WARN("failed to create project logical operator's child physical operator. rc=%s", strrc(rc));
       return rc;
@@ -492,7 +775,7 @@ RC PhysicalPlanGenerator::create_vec_plan(
 
   RC rc = RC::SUCCESS;
   // reuse `ExplainPhysicalOperator` in explain vectorized physical plan
-  unique_ptr<PhysicalOperator> explain_physical_oper(new ExplainPhysicalOperator);
+  unique_ptr<PhysicalOperator> explain_physical_oper(new ExplainPhysicalOperator(session->explain_analyze()));
   for (unique_ptr<LogicalOperator> &child_oper : child_opers) {
     unique_ptr<PhysicalOperator> child_physical_oper;
     rc = create_vec(*child_oper, child_physical_oper, session);
@@ -507,3 +790,19 @@ RC PhysicalPlanGenerator::create_vec_plan(
   oper = std::move(explain_physical_oper);
   return rc;
 }
+
+RC PhysicalPlanGenerator::create_vec_plan(
+    JoinLogicalOperator &join_oper, unique_ptr<PhysicalOperator> &oper, Session *session)
+{
+  if (join_oper.children().size() != 2) {
+    LOG_WARN("join operator should have 2 children, but have %d", join_oper.children().size());
+    return RC::INTERNAL;
+  }
+
+  // 向量化执行只支持 hash join
+  if (!can_use_hash_join(join_oper)) {
+    LOG_WARN("vectorized join only supports equi-join on int, date or char columns");
+    return RC::UNIMPLEMENTED;
+  }
+  return create_hash_join_plan(join_oper, oper, session, true /*vectorized*/);
+}
@@ -9,3 +9,120 @@ MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
 #include "sql/optimizer/predicate_to_join_rule.h"
+#include "common/lang/algorithm.h"
+#include "common/log/log.h"
+#include "sql/expr/expression.h"
+#include "sql/operator/join_logical_operator.h"
+#include "sql/operator/logical_operator.h"
+#include "sql/operator/table_get_logical_operator.h"
+
+using namespace std;
+
+RC PredicateToJoinRewriter::rewrite(unique_ptr<LogicalOperator> &oper, bool &change_made)
+{
+  if (oper->type() != LogicalOperatorType::PREDICATE || oper->children().size() != 1) {
+    return RC::SUCCESS;
+  }
+
+  unique_ptr<LogicalOperator> &child_oper = oper->children().front();
+  if (child_oper->type() != LogicalOperatorType::JOIN || child_oper->children().size() != 2) {
+    return RC::SUCCESS;
+  }
+
+  vector<unique_ptr<Expression>> &predicate_exprs = oper->expressions();
+  if (predicate_exprs.size() != 1) {
+    return RC::SUCCESS;
+  }
+
+  auto *join_oper = static_cast<JoinLogicalOperator *>(child_oper.get());
+
+  vector<const Table *> left_tables;
+  vector<const Table *> right_tables;
+  collect_tables(*join_oper->children()[0], left_tables);
+  collect_tables(*join_oper->children()[1], right_tables);
+
+  unique_ptr<Expression> &predicate_expr = predicate_exprs.front();
+  if (predicate_expr->type() == ExprType::CONJUNCTION) {
+    auto *conjunction_expr = static_cast<ConjunctionExpr *>(predicate_expr.get());
+    if (conjunction_expr->conjunction_type() != ConjunctionExpr::Type::AND) {
+      return RC::SUCCESS;
+    }
+
+    vector<unique_ptr<Expression>> &child_exprs = conjunction_expr->children();
+    for (auto iter = child_exprs.begin(); iter != child_exprs.end();) {
+      if (is_equi_join_predicate(**iter, left_tables, right_tables)) {
+        join_oper->add_join_predicate(std::move(*iter));
+        iter        = child_exprs.erase(iter);
+        change_made = true;
+      } else {
+        ++iter;
+      }
+    }
+
+    if (!child_exprs.empty()) {
+      return RC::SUCCESS;
+    }
+  } else if (is_equi_join_predicate(*predicate_expr, left_tables, right_tables)) {
+    join_oper->add_join_predicate(std::move(predicate_expr));
+    change_made = true;
+  } else {
+    return RC::SUCCESS;
+  }
+
+  // 所有的条件都移动到了连接算子中，谓词算子就不需要了
+  LOG_TRACE("all expressions of predicate operator were moved to join operator, remove the predicate operator");
+  unique_ptr<LogicalOperator> join = std::move(child_oper);
+  oper                             = std::move(join);
+  change_made                      = true;
+  return RC::SUCCESS;
+}
+
+void PredicateToJoinRewriter::collect_tables(LogicalOperator &oper, vector<const Table *> &tables)
+{
+  if (oper.type() == LogicalOperatorType::TABLE_GET) {
+    tables.push_back(static_cast<TableGetLogicalOperator &>(oper).table());
+  }
+
+  for (unique_ptr<LogicalOperator> &child : oper.children()) {
+    collect_tables(*child, tables);
+  }
+}
+
+bool PredicateToJoinRewriter::is_equi_join_predicate(
+    Expression &expr, const vector<const Table *> &left_tables, const vector<const Table *> &right_tables)
+{
+  if (expr.type() != ExprType::COMPARISON) {
+    return false;
+  }
+
+  auto &comparison_expr = static_cast<ComparisonExpr &>(expr);
+  if (comparison_expr.comp() != CompOp::EQUAL_TO) {
+    return false;
+  }
+
+  unique_ptr<Expression> &left  = comparison_expr.left();
+  unique_ptr<Expression> &right = comparison_expr.right();
+  if (left->type() != ExprType::FIELD || right->type() != ExprType::FIELD ||
+      left->value_type() != right->value_type()) {
+    return false;
+  }
+
+  // 同一张表同时出现在两边时(比如自连接)，无法区分字段属于哪一边
+  auto side_of = [&left_tables, &right_tables](const Expression &field_expr) {
+    const Table *table    = static_cast<const FieldExpr &>(field_expr).field().table();
+    const bool   in_left  = find(left_tables.begin(), left_tables.end(), table) != left_tables.end();
+    const bool   in_right = find(right_tables.begin(), right_tables.end(), table) != right_tables.end();
+    return in_left == in_right ? 0 : (in_left ? 1 : 2);
+  };
+
+  const int left_side  = side_of(*left);
+  const int right_side = side_of(*right);
+  if (left_side == 0 || right_side == 0 || left_side == right_side) {
+    return false;
+  }
+
+  if (left_side == 2) {
+    left.swap(right);
+  }
+  return true;
+}
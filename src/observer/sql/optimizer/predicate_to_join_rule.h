@@ -13,9 +13,33 @@ See the Mulan PSL v2 for more details. */
 #include "common/lang/vector.h"
 #include "sql/optimizer/rewrite_rule.h"
 
+class LogicalOperator;
+class Table;
+
 /**
  * @brief 将一些谓词表达式下推到join中
  * @ingroup Rewriter
+ * @details 连接条件和 where 条件都是连接算子上层的谓词算子。其中左右两边分别是两个孩子中的字段，
+ * 并且类型相同的等值比较，会从谓词算子中移动到连接算子的 join_predicates 中，物理计划生成时可以据此选择 hash join。
+ * 如果谓词算子的条件都移走了，谓词算子也会删除。
  */
-class PredicateToJoinRewriter
-{};
+class PredicateToJoinRewriter : public RewriteRule
+{
+public:
+  PredicateToJoinRewriter()          = default;
+  virtual ~PredicateToJoinRewriter() = default;
+
+  RC rewrite(unique_ptr<LogicalOperator> &oper, bool &change_made) override;
+
+private:
+  /**
+   * @brief 收集算子及其所有子算子扫描的表
+   */
+  void collect_tables(LogicalOperator &oper, vector<const Table *> &tables);
+
+  /**
+   * @brief 判断是否是左右两边各自引用一个孩子中字段的等值比较。如果是右边引用左孩子，会交换比较的左右两边
+   */
+  bool is_equi_join_predicate(
+      Expression &expr, const vector<const Table *> &left_tables, const vector<const Table *> &right_tables);
+};
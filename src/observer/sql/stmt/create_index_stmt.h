@@ -27,25 +27,26 @@ class FieldMeta;
 class CreateIndexStmt : public Stmt
 {
 public:
-  CreateIndexStmt(Table *table, const FieldMeta *field_meta, const string &index_name, bool is_unique = false)
-      : table_(table), field_meta_(field_meta), index_name_(index_name), is_unique_(is_unique)
+  CreateIndexStmt(
+      Table *table, const vector<const FieldMeta *> &field_metas, const string &index_name, bool is_unique = false)
+      : table_(table), field_metas_(field_metas), index_name_(index_name), is_unique_(is_unique)
   {}
 
   virtual ~CreateIndexStmt() = default;
 
   StmtType type() const override { return StmtType::CREATE_INDEX; }
 
-  Table           *table() const { return table_; }
-  const FieldMeta *field_meta() const { return field_meta_; }
-  const string    &index_name() const { return index_name_; }
-  bool             is_unique() const { return is_unique_; }
+  Table                           *table() const { return table_; }
+  const vector<const FieldMeta *> &field_metas() const { return field_metas_; }
+  const string                    &index_name() const { return index_name_; }
+  bool                             is_unique() const { return is_unique_; }
 
 public:
   static RC create(Db *db, const CreateIndexSqlNode &create_index, Stmt *&stmt);
 
 private:
-  Table           *table_      = nullptr;
-  const FieldMeta *field_meta_ = nullptr;
-  string           index_name_;
-  bool             is_unique_ = false;
+  Table                    *table_ = nullptr;
+  vector<const FieldMeta *> field_metas_;
+  string                    index_name_;
+  bool                      is_unique_ = false;
 };
@@ -17,6 +17,7 @@ See the Mulan PSL v2 for more details. */
 #include "common/io/io.h"
 #include "common/lang/mutex.h"
 #include "common/lang/algorithm.h"
+#include "common/lang/thread.h"
 #include "common/log/log.h"
 #include "common/math/crc.h"
 #include "storage/buffer/disk_buffer_pool.h"
@@ -27,6 +28,16 @@ using namespace common;
 
 static const int MEM_POOL_ITEM_NUM = 20;
 
+/// flush_all_pages 每次持有锁刷新的页面个数
+static const int FLUSH_BATCH_PAGE_NUM = 64;
+
+/// 从磁盘加载的页面在上一个加载的页面之后，而且距离不超过这个值，就认为是顺序读
+static const int SEQUENTIAL_LOAD_DISTANCE = 4;
+/// 连续顺序读多少次以后开始预读
+static const int SEQUENTIAL_LOAD_THRESHOLD = 2;
+
+static bool frame_page_num_less(const Frame *a, const Frame *b) { return a->page_num() < b->page_num(); }
+
 ////////////////////////////////////////////////////////////////////////////////
 
 string BPFileHeader::to_string() const
@@ -38,38 +49,132 @@ string BPFileHeader::to_string() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
-BPFrameManager::BPFrameManager(const char *name) : allocator_(name) {}
+BPFrameManager::BPFrameManager(const char *name, int shard_num /* = DEFAULT_SHARD_NUM */,
+    const char *replacer_name /* = nullptr */)
+    : replacer_name_(replacer_name == nullptr ? "" : replacer_name), allocator_(name)
+{
+  if (shard_num <= 0) {
+    shard_num = 1;
+  }
+
+  shards_.reserve(shard_num);
+  for (int i = 0; i < shard_num; i++) {
+    shards_.push_back(make_unique<FrameShard>());
+  }
+}
 
 RC BPFrameManager::init(int pool_num)
 {
   int ret = allocator_.init(false, pool_num);
-  if (ret == 0) {
-    return RC::SUCCESS;
+  if (ret != 0) {
+    return RC::NOMEM;
   }
-  return RC::NOMEM;
+
+  // 页帧总数是固定的，平均分配到各个分片上
+  const size_t capacity = max(static_cast<size_t>(pool_num) * DEFAULT_ITEM_NUM_PER_POOL / shards_.size(),
+                              static_cast<size_t>(1));
+  for (auto &shard : shards_) {
+    RC rc = FrameReplacer::create(replacer_name_.c_str(), capacity, shard->replacer);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to create frame replacer, use lru instead. name=%s, rc=%s", replacer_name_.c_str(), strrc(rc));
+      shard->replacer = make_unique<LruFrameReplacer>();
+    }
+  }
+  replacer_name_ = shards_.front()->replacer->name();
+  return RC::SUCCESS;
 }
 
 RC BPFrameManager::cleanup()
 {
-  if (frames_.count() > 0) {
+  if (frame_num() > 0) {
     return RC::INTERNAL;
   }
 
-  frames_.destroy();
+  for (auto &shard : shards_) {
+    lock_guard<mutex> lock_guard(shard->lock);
+    shard->frames.clear();
+    shard->replacer.reset();
+  }
   return RC::SUCCESS;
 }
 
-int BPFrameManager::purge_frames(int count, function<RC(Frame *frame)> purger)
+size_t BPFrameManager::frame_num() const
 {
-  lock_guard<mutex> lock_guard(lock_);
+  size_t count = 0;
+  for (const auto &shard : shards_) {
+    lock_guard<mutex> lock_guard(shard->lock);
+    count += shard->frames.size();
+  }
+  return count;
+}
 
-  vector<Frame *> frames_can_purge;
+size_t BPFrameManager::dirty_frame_num() const
+{
+  size_t count = 0;
+  for (const auto &shard : shards_) {
+    lock_guard<mutex> lock_guard(shard->lock);
+    for (const auto &[frame_id, frame] : shard->frames) {
+      if (frame->dirty()) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+uint64_t BPFrameManager::hit_count() const
+{
+  uint64_t count = 0;
+  for (const auto &shard : shards_) {
+    lock_guard<mutex> lock_guard(shard->lock);
+    count += shard->hit_count;
+  }
+  return count;
+}
+
+uint64_t BPFrameManager::miss_count() const
+{
+  uint64_t count = 0;
+  for (const auto &shard : shards_) {
+    lock_guard<mutex> lock_guard(shard->lock);
+    count += shard->miss_count;
+  }
+  return count;
+}
+
+BPFrameManager::FrameShard &BPFrameManager::shard_of(const FrameId &frame_id) const
+{
+  // 同一个文件相邻的页面分散到不同的分片上，顺序扫描时不会集中在一个分片
+  uint64_t key = static_cast<uint64_t>(frame_id.hash()) * 0x9E3779B97F4A7C15ULL;
+  return *shards_[(key >> 32) % shards_.size()];
+}
+
+int BPFrameManager::purge_frames(int count, function<RC(Frame *frame)> purger)
+{
   if (count <= 0) {
     count = 1;
   }
+
+  const size_t shard_num   = shards_.size();
+  const size_t start       = purge_cursor_.fetch_add(1) % shard_num;
+  int          freed_count = 0;
+  for (size_t i = 0; i < shard_num && freed_count < count; i++) {
+    FrameShard &shard = *shards_[(start + i) % shard_num];
+    freed_count += purge_shard(shard, count - freed_count, purger);
+  }
+
+  LOG_INFO("purge frame done. number=%d", freed_count);
+  return freed_count;
+}
+
+int BPFrameManager::purge_shard(FrameShard &shard, int count, function<RC(Frame *frame)> &purger)
+{
+  lock_guard<mutex> lock_guard(shard.lock);
+
+  vector<Frame *> frames_can_purge;
   frames_can_purge.reserve(count);
 
-  auto purge_finder = [&frames_can_purge, count](const FrameId &frame_id, Frame *const frame) {
+  auto purge_finder = [&frames_can_purge, count](Frame *frame) {
     if (frame->can_purge()) {
       frame->pin();
       frames_can_purge.push_back(frame);
@@ -80,16 +185,16 @@ int BPFrameManager::purge_frames(int count, function<RC(Frame *frame)> purger)
     return true;  // true continue to look up
   };
 
-  frames_.foreach_reverse(purge_finder);
-  LOG_INFO("purge frames find %ld pages total", frames_can_purge.size());
+  shard.replacer->foreach_victim(purge_finder);
+  LOG_DEBUG("purge frames find %ld pages in shard", frames_can_purge.size());
 
-  /// 当前还在frameManager的锁内，而 purger 是一个非常耗时的操作
-  /// 他需要把脏页数据刷新到磁盘上去，所以这里会极大地降低并发度
+  /// 当前还在分片的锁内，而 purger 是一个非常耗时的操作
+  /// 他需要把脏页数据刷新到磁盘上去，所以这里会降低当前分片的并发度，但是不影响其它分片
   int freed_count = 0;
   for (Frame *frame : frames_can_purge) {
     RC rc = purger(frame);
     if (RC::SUCCESS == rc) {
-      free_internal(frame->frame_id(), frame);
+      free_internal(shard, frame->frame_id(), frame);
       freed_count++;
     } else {
       frame->unpin();
@@ -97,24 +202,69 @@ int BPFrameManager::purge_frames(int count, function<RC(Frame *frame)> purger)
                frame->frame_id().to_string().c_str(), strrc(rc));
     }
   }
-  LOG_INFO("purge frame done. number=%d", freed_count);
   return freed_count;
 }
 
+int BPFrameManager::find_dirty_victims(int shard_index, int count, vector<Frame *> &frames)
+{
+  if (shard_index < 0 || shard_index >= static_cast<int>(shards_.size()) || count <= 0) {
+    return 0;
+  }
+
+  FrameShard       &shard = *shards_[shard_index];
+  lock_guard<mutex> lock_guard(shard.lock);
+
+  int  found_count = 0;
+  auto dirty_finder = [&frames, &found_count, count](Frame *frame) {
+    if (frame->can_purge() && frame->dirty()) {
+      frame->pin();
+      frames.push_back(frame);
+      found_count++;
+    }
+    return found_count < count;
+  };
+
+  shard.replacer->foreach_victim(dirty_finder);
+  return found_count;
+}
+
 Frame *BPFrameManager::get(int buffer_pool_id, PageNum page_num)
 {
-  FrameId                     frame_id(buffer_pool_id, page_num);
+  FrameId     frame_id(buffer_pool_id, page_num);
+  FrameShard &shard = shard_of(frame_id);
 
-  lock_guard<mutex> lock_guard(lock_);
-  return get_internal(frame_id);
+  lock_guard<mutex> lock_guard(shard.lock);
+  Frame *frame = get_internal(shard, frame_id);
+  if (frame != nullptr) {
+    shard.hit_count++;
+  } else {
+    shard.miss_count++;
+  }
+  return frame;
 }
 
-Frame *BPFrameManager::get_internal(const FrameId &frame_id)
+bool BPFrameManager::contains(int buffer_pool_id, PageNum page_num) const
+{
+  FrameId     frame_id(buffer_pool_id, page_num);
+  FrameShard &shard = shard_of(frame_id);
+
+  lock_guard<mutex> lock_guard(shard.lock);
+  return shard.frames.find(frame_id) != shard.frames.end();
+}
+
+Frame *BPFrameManager::get_internal(FrameShard &shard, const FrameId &frame_id)
 {
   Frame *frame = nullptr;
-  (void)frames_.get(frame_id, frame);
-  if (frame != nullptr) {
+  auto   iter  = shard.frames.find(frame_id);
+  if (iter != shard.frames.end()) {
+    frame = iter->second;
     frame->pin();
+    if (frame->read_ahead()) {
+      // 预读页面的第一次访问，在置换策略看来就是页面刚刚加载进来
+      frame->set_read_ahead(false);
+    } else {
+      shard.replacer->access(frame);
+    }
     LOG_DEBUG("got a frame. frame=%s", frame->to_string().c_str());
   }
   return frame;
@@ -122,11 +272,12 @@ Frame *BPFrameManager::get_internal(const FrameId &frame_id)
 
 Frame *BPFrameManager::alloc(int buffer_pool_id, PageNum page_num)
 {
-  FrameId frame_id(buffer_pool_id, page_num);
+  FrameId     frame_id(buffer_pool_id, page_num);
+  FrameShard &shard = shard_of(frame_id);
 
-  lock_guard<mutex> lock_guard(lock_);
+  lock_guard<mutex> lock_guard(shard.lock);
 
-  Frame                      *frame = get_internal(frame_id);
+  Frame *frame = get_internal(shard, frame_id);
   if (frame != nullptr) {
     return frame;
   }
@@ -138,7 +289,8 @@ Frame *BPFrameManager::alloc(int buffer_pool_id, PageNum page_num)
     frame->set_buffer_pool_id(buffer_pool_id);
     frame->set_page_num(page_num);
     frame->pin();
-    frames_.put(frame_id, frame);
+    shard.frames.emplace(frame_id, frame);
+    shard.replacer->insert(frame);
     LOG_DEBUG("allocate a new frame. frame=%s", frame->to_string().c_str());
   }
   return frame;
@@ -146,49 +298,66 @@ Frame *BPFrameManager::alloc(int buffer_pool_id, PageNum page_num)
 
 RC BPFrameManager::free(int buffer_pool_id, PageNum page_num, Frame *frame)
 {
-  FrameId frame_id(buffer_pool_id, page_num);
+  FrameId     frame_id(buffer_pool_id, page_num);
+  FrameShard &shard = shard_of(frame_id);
 
-  lock_guard<mutex> lock_guard(lock_);
-  return free_internal(frame_id, frame);
+  lock_guard<mutex> lock_guard(shard.lock);
+  return free_internal(shard, frame_id, frame);
 }
 
-RC BPFrameManager::free_internal(const FrameId &frame_id, Frame *frame)
+RC BPFrameManager::try_free(int buffer_pool_id, PageNum page_num, Frame *frame)
 {
-  Frame                *frame_source = nullptr;
-  [[maybe_unused]] bool found        = frames_.get(frame_id, frame_source);
+  FrameId     frame_id(buffer_pool_id, page_num);
+  FrameShard &shard = shard_of(frame_id);
+
+  lock_guard<mutex> lock_guard(shard.lock);
+  if (frame->pin_count() != 1) {
+    return RC::LOCKED_UNLOCK;
+  }
+  return free_internal(shard, frame_id, frame);
+}
+
+RC BPFrameManager::free_internal(FrameShard &shard, const FrameId &frame_id, Frame *frame)
+{
+  auto                    iter         = shard.frames.find(frame_id);
+  [[maybe_unused]] bool   found        = (iter != shard.frames.end());
+  [[maybe_unused]] Frame *frame_source = found ? iter->second : nullptr;
   ASSERT(found && frame == frame_source && frame->pin_count() == 1,
       "failed to free frame. found=%d, frameId=%s, frame_source=%p, frame=%p, pinCount=%d, lbt=%s",
       found, frame_id.to_string().c_str(), frame_source, frame, frame->pin_count(), lbt());
 
+  // 置换策略可能会用 frame_id 记录淘汰历史，所以要在清理页帧之前调用
+  shard.replacer->remove(frame);
+  shard.frames.erase(iter);
   frame->set_page_num(-1);
   frame->unpin();
-  frames_.remove(frame_id);
   allocator_.free(frame);
   return RC::SUCCESS;
 }
 
 list<Frame *> BPFrameManager::find_list(int buffer_pool_id)
 {
-  lock_guard<mutex> lock_guard(lock_);
-
   list<Frame *> frames;
-  auto               fetcher = [&frames, buffer_pool_id](const FrameId &frame_id, Frame *const frame) -> bool {
-    if (buffer_pool_id == frame_id.buffer_pool_id()) {
-      frame->pin();
-      frames.push_back(frame);
+  for (auto &shard : shards_) {
+    lock_guard<mutex> lock_guard(shard->lock);
+    for (auto &[frame_id, frame] : shard->frames) {
+      if (buffer_pool_id == frame_id.buffer_pool_id()) {
+        frame->pin();
+        frames.push_back(frame);
+      }
     }
-    return true;
-  };
-  frames_.foreach (fetcher);
+  }
   return frames;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 BufferPoolIterator::BufferPoolIterator() {}
 BufferPoolIterator::~BufferPoolIterator() {}
-RC BufferPoolIterator::init(DiskBufferPool &bp, PageNum start_page /* = 0 */)
+RC BufferPoolIterator::init(DiskBufferPool &bp, PageNum start_page /* = 0 */, bool read_ahead /* = false */)
 {
-  bitmap_.init(bp.file_header_->bitmap, bp.file_header_->page_count);
+  buffer_pool_    = &bp;
+  read_ahead_     = read_ahead && bp.read_ahead_pages() > 0;
+  read_ahead_end_ = -1;
   if (start_page <= 0) {
     current_page_num_ = -1;
   } else {
@@ -197,13 +366,22 @@ RC BufferPoolIterator::init(DiskBufferPool &bp, PageNum start_page /* = 0 */)
   return RC::SUCCESS;
 }
 
-bool BufferPoolIterator::has_next() { return bitmap_.next_setted_bit(current_page_num_ + 1) != -1; }
+bool BufferPoolIterator::has_next()
+{
+  return buffer_pool_->page_allocator_.next_allocated_page(current_page_num_ + 1) != BP_INVALID_PAGE_NUM;
+}
 
 PageNum BufferPoolIterator::next()
 {
-  PageNum next_page = bitmap_.next_setted_bit(current_page_num_ + 1);
+  PageNum next_page = buffer_pool_->page_allocator_.next_allocated_page(current_page_num_ + 1);
   if (next_page != -1) {
     current_page_num_ = next_page;
+
+    if (read_ahead_ && next_page >= read_ahead_end_) {
+      const int count = buffer_pool_->read_ahead_pages();
+      (void)buffer_pool_->read_ahead(next_page, count);
+      read_ahead_end_ = next_page + count;
+    }
   }
   return next_page;
 }
@@ -217,7 +395,11 @@ RC BufferPoolIterator::reset()
 ////////////////////////////////////////////////////////////////////////////////
 DiskBufferPool::DiskBufferPool(
     BufferPoolManager &bp_manager, BPFrameManager &frame_manager, DoubleWriteBuffer &dblwr_manager, LogHandler &log_handler)
-    : bp_manager_(bp_manager), frame_manager_(frame_manager), dblwr_manager_(dblwr_manager), log_handler_(*this, log_handler)
+    : bp_manager_(bp_manager),
+      frame_manager_(frame_manager),
+      dblwr_manager_(dblwr_manager),
+      log_handler_(*this, log_handler),
+      page_allocator_(BPFileHeader::BITMAP_PAGE_NUM, BPAllocationMapPage::BITMAP_PAGE_NUM)
 {}
 
 DiskBufferPool::~DiskBufferPool()
@@ -271,6 +453,14 @@ RC DiskBufferPool::open_file(const char *file_name)
 
   file_header_ = (BPFileHeader *)hdr_frame_->data();
 
+  if (OB_FAIL(rc = load_allocation_maps())) {
+    LOG_ERROR("Failed to load allocation maps of %s. rc=%s", file_name, strrc(rc));
+    purge_frame(BP_HEADER_PAGE, hdr_frame_);
+    close(fd);
+    file_desc_ = -1;
+    return rc;
+  }
+
   LOG_INFO("Successfully open %s. file_desc=%d, hdr_frame=%p, file header=%s",
            file_name, file_desc_, hdr_frame_, file_header_->to_string().c_str());
   return RC::SUCCESS;
@@ -285,8 +475,13 @@ RC DiskBufferPool::close_file()
 
   hdr_frame_->unpin();
 
-  // TODO: 理论上是在回放时回滚未提交事务，但目前没有undo log，因此不下刷数据page，只通过redo log回放
-  rc = purge_all_pages();
+  {
+    // 后台刷脏页的线程可能会 pin 住这个文件的页面，导致页面无法释放
+    PageCleaner::PauseGuard pause_guard(bp_manager_.page_cleaner());
+
+    // TODO: 理论上是在回放时回滚未提交事务，但目前没有undo log，因此不下刷数据page，只通过redo log回放
+    rc = purge_all_pages();
+  }
   if (rc != RC::SUCCESS) {
     LOG_ERROR("failed to close %s, due to failed to purge pages. rc=%s", file_name_.c_str(), strrc(rc));
     return rc;
@@ -325,10 +520,42 @@ RC DiskBufferPool::get_this_page(PageNum page_num, Frame **frame)
 
   scoped_lock lock_guard(lock_);  // 直接加了一把大锁，其实可以根据访问的页面来细化提高并行度
 
+  Frame *allocated_frame = nullptr;
+  if (OB_FAIL(rc = get_page_internal(page_num, &allocated_frame))) {
+    return rc;
+  }
+
+  // 没有调用方提示的顺序读，比如按照页面编号访问的 B+ 树叶子节点，在这里检测
+  if (page_num > last_load_page_ && page_num <= last_load_page_ + SEQUENTIAL_LOAD_DISTANCE) {
+    sequential_loads_++;
+  } else {
+    sequential_loads_ = 0;
+  }
+  last_load_page_ = page_num;
+  if (sequential_loads_ >= SEQUENTIAL_LOAD_THRESHOLD) {
+    (void)read_ahead_internal(page_num + 1, read_ahead_pages());
+  }
+
+  *frame = allocated_frame;
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::get_page_internal(PageNum page_num, Frame **frame)
+{
+  // 可能已经被其它线程加载了，或者是分配图这种在持有锁时访问的页面
+  if (frame_manager_.contains(id(), page_num)) {
+    Frame *used_match_frame = frame_manager_.get(id(), page_num);
+    if (used_match_frame != nullptr) {
+      used_match_frame->access();
+      *frame = used_match_frame;
+      return RC::SUCCESS;
+    }
+  }
+
   // Allocate one page and load the data into this page
   Frame *allocated_frame = nullptr;
 
-  rc = allocate_frame(page_num, &allocated_frame);
+  RC rc = allocate_frame(page_num, &allocated_frame);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to alloc frame %s:%d, due to failed to alloc page.", file_name_.c_str(), page_num);
     return rc;
@@ -354,53 +581,69 @@ RC DiskBufferPool::allocate_page(Frame **frame)
 
   lock_.lock();
 
-  int byte = 0, bit = 0;
-  if ((file_header_->allocated_pages) < (file_header_->page_count)) {
+  PageNum page_num = page_allocator_.find_free_page();
+  if (page_num != BP_INVALID_PAGE_NUM) {
     // There is one free page
-    for (int i = 0; i < file_header_->page_count; i++) {
-      byte = i / 8;
-      bit  = i % 8;
-      if (((file_header_->bitmap[byte]) & (1 << bit)) == 0) {
-        (file_header_->allocated_pages)++;
-        file_header_->bitmap[byte] |= (1 << bit);
-        // TODO,  do we need clean the loaded page's data?
-        hdr_frame_->mark_dirty();
-        LSN lsn = 0;
-        rc = log_handler_.allocate_page(i, lsn);
-        if (OB_FAIL(rc)) {
-          LOG_ERROR("Failed to log allocate page %d, rc=%s", i, strrc(rc));
-          // 忽略了错误
-        }
+    LSN lsn = 0;
+    rc = log_handler_.allocate_page(page_num, lsn);
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("Failed to log allocate page %d, rc=%s", page_num, strrc(rc));
+      // 忽略了错误
+    }
 
-        hdr_frame_->set_lsn(lsn);
+    // TODO,  do we need clean the loaded page's data?
+    rc = set_page_allocated(page_num, true, lsn);
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("Failed to allocate page %d. file=%s, rc=%s", page_num, file_name_.c_str(), strrc(rc));
+      lock_.unlock();
+      return rc;
+    }
 
-        LOG_DEBUG("allocate a new page without extend buffer pool. page num=%d, buffer pool=%d", i, id());
+    LOG_DEBUG("allocate a new page without extend buffer pool. page num=%d, buffer pool=%d", page_num, id());
 
-        lock_.unlock();
-        return get_this_page(i, frame);
-      }
-    }
+    lock_.unlock();
+    return get_this_page(page_num, frame);
   }
 
-  if (file_header_->page_count >= BPFileHeader::MAX_PAGE_NUM) {
-    LOG_WARN("file buffer pool is full. page count %d, max page count %d",
-        file_header_->page_count, BPFileHeader::MAX_PAGE_NUM);
-    lock_.unlock();
-    return RC::BUFFERPOOL_NOBUF;
+  // 扩展到新的一组时，这一组的第一个页面是分配图
+  page_num              = file_header_->page_count;
+  const bool create_map = page_allocator_.is_map_page(page_num);
+  if (create_map) {
+    page_num++;
   }
 
   LSN lsn = 0;
-  rc = log_handler_.allocate_page(file_header_->page_count, lsn);
+  rc = log_handler_.allocate_page(page_num, lsn);
   if (OB_FAIL(rc)) {
-    LOG_ERROR("Failed to log allocate page %d, rc=%s", file_header_->page_count, strrc(rc));
+    LOG_ERROR("Failed to log allocate page %d, rc=%s", page_num, strrc(rc));
     // 忽略了错误
   }
-  hdr_frame_->set_lsn(lsn);
 
-  PageNum page_num        = file_header_->page_count;
-  Frame  *allocated_frame = nullptr;
+  Frame *map_frame = nullptr;
+  if (create_map) {
+    const PageNum map_page_num = page_num - 1;
+    if ((rc = allocate_frame(map_page_num, &map_frame)) != RC::SUCCESS) {
+      LOG_ERROR("Failed to allocate frame for allocation map %s, due to no free page.", file_name_.c_str());
+      lock_.unlock();
+      return rc;
+    }
+
+    map_frame->set_buffer_pool_id(id());
+    map_frame->access();
+    init_allocation_map(*map_frame, lsn);
+
+    file_header_->allocated_pages++;
+    file_header_->page_count++;
+    page_allocator_.extend(file_header_->page_count);
+    LOG_INFO("create allocation map. buffer_pool_id=%d, pageNum=%d", id(), map_page_num);
+  }
+
+  Frame *allocated_frame = nullptr;
   if ((rc = allocate_frame(page_num, &allocated_frame)) != RC::SUCCESS) {
     LOG_ERROR("Failed to allocate frame %s, due to no free page.", file_name_.c_str());
+    if (map_frame != nullptr) {
+      map_frame->unpin();
+    }
     lock_.unlock();
     return rc;
   }
@@ -408,18 +651,32 @@ RC DiskBufferPool::allocate_page(Frame **frame)
   LOG_INFO("allocate new page by extending bufferpool. buffer_pool_id=%d, pageNum=%d, pin=%d",
            id(), page_num, allocated_frame->pin_count());
 
-  file_header_->allocated_pages++;
   file_header_->page_count++;
+  page_allocator_.extend(file_header_->page_count);
+  reserve_file_space(file_header_->page_count);
+
+  if (map_frame != nullptr) {
+    auto  *map_page = reinterpret_cast<BPAllocationMapPage *>(map_frame->data());
+    Bitmap bitmap(map_page->bitmap, BPAllocationMapPage::BITMAP_PAGE_NUM);
+    bitmap.set_bit(1);  // 新页面紧跟在分配图后面
+    map_page->allocated_pages++;
+    file_header_->allocated_pages++;
+    hdr_frame_->set_lsn(lsn);
+    hdr_frame_->mark_dirty();
 
-  byte = page_num / 8;
-  bit  = page_num % 8;
-  file_header_->bitmap[byte] |= (1 << bit);
-  hdr_frame_->mark_dirty();
+    // 分配图要在新页面的分配状态修改完以后再刷新，回放日志时会根据分配图的LSN判断是否需要修改
+    if ((rc = flush_page_internal(*map_frame)) != RC::SUCCESS) {
+      LOG_WARN("Failed to flush allocation map %s. rc=%s", file_name_.c_str(), strrc(rc));
+    }
+    map_frame->unpin();
+  } else if (OB_FAIL(rc = set_page_allocated(page_num, true, lsn))) {
+    LOG_WARN("Failed to set page allocated. file=%s, page num=%d, rc=%s", file_name_.c_str(), page_num, strrc(rc));
+  }
 
   allocated_frame->set_buffer_pool_id(id());
   allocated_frame->access();
   allocated_frame->clear_page();
-  allocated_frame->set_page_num(file_header_->page_count - 1);
+  allocated_frame->set_page_num(page_num);
 
   // Use flush operation to extension file
   if ((rc = flush_page_internal(*allocated_frame)) != RC::SUCCESS) {
@@ -440,16 +697,25 @@ RC DiskBufferPool::dispose_page(PageNum page_num)
     LOG_ERROR("Failed to dispose page %d, because it is the first page. filename=%s", page_num, file_name_.c_str());
     return RC::INTERNAL;
   }
-  
-  scoped_lock lock_guard(lock_);
-  Frame           *used_frame = frame_manager_.get(id(), page_num);
+
+  if (page_allocator_.is_map_page(page_num)) {
+    LOG_ERROR("Failed to dispose page %d, because it is an allocation map. filename=%s", page_num, file_name_.c_str());
+    return RC::INTERNAL;
+  }
+
+  Frame *used_frame = frame_manager_.get(id(), page_num);
   if (used_frame != nullptr) {
-    ASSERT("the page try to dispose is in use. frame:%s", used_frame->to_string().c_str());
-    frame_manager_.free(id(), page_num, used_frame);
+    // B+树的乐观读可能会短暂地pin住这个页面，它们校验版本号失败后就会释放。
+    // 等待时不能持有缓冲池的锁，否则它们加载其它页面时就会死锁
+    while (frame_manager_.try_free(id(), page_num, used_frame) == RC::LOCKED_UNLOCK) {
+      this_thread::yield();
+    }
   } else {
     LOG_DEBUG("page not found in memory while disposing it. pageNum=%d", page_num);
   }
 
+  scoped_lock lock_guard(lock_);
+
   LSN lsn = 0;
   RC rc = log_handler_.deallocate_page(page_num, lsn);
   if (OB_FAIL(rc)) {
@@ -457,14 +723,117 @@ RC DiskBufferPool::dispose_page(PageNum page_num)
     // ignore error handle
   }
 
-  hdr_frame_->set_lsn(lsn);
+  return set_page_allocated(page_num, false, lsn);
+}
+
+RC DiskBufferPool::set_page_allocated(PageNum page_num, bool allocated, LSN lsn, bool update_lsn /* = true */)
+{
+  const int group = page_allocator_.group_of(page_num);
+  if (group == 0) {
+    Bitmap bitmap(file_header_->bitmap, BPFileHeader::BITMAP_PAGE_NUM);
+    if (allocated) {
+      bitmap.set_bit(page_num);
+    } else {
+      bitmap.clear_bit(page_num);
+    }
+  } else {
+    Frame *map_frame = nullptr;
+    RC     rc        = get_page_internal(page_allocator_.group_start(group), &map_frame);
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("Failed to get allocation map of page %d. file=%s, rc=%s", page_num, file_name_.c_str(), strrc(rc));
+      return rc;
+    }
+
+    auto  *map_page = reinterpret_cast<BPAllocationMapPage *>(map_frame->data());
+    Bitmap bitmap(map_page->bitmap, BPAllocationMapPage::BITMAP_PAGE_NUM);
+    const int index = page_num - page_allocator_.group_start(group);
+    if (allocated) {
+      bitmap.set_bit(index);
+      map_page->allocated_pages++;
+    } else {
+      bitmap.clear_bit(index);
+      map_page->allocated_pages--;
+    }
+    if (update_lsn) {
+      map_frame->set_lsn(lsn);
+    }
+    map_frame->mark_dirty();
+    map_frame->unpin();
+  }
+
+  if (allocated) {
+    page_allocator_.set_allocated(page_num);
+    file_header_->allocated_pages++;
+  } else {
+    page_allocator_.clear_allocated(page_num);
+    file_header_->allocated_pages--;
+  }
+  if (update_lsn) {
+    hdr_frame_->set_lsn(lsn);
+  }
   hdr_frame_->mark_dirty();
-  file_header_->allocated_pages--;
-  char tmp = 1 << (page_num % 8);
-  file_header_->bitmap[page_num / 8] &= ~tmp;
   return RC::SUCCESS;
 }
 
+void DiskBufferPool::init_allocation_map(Frame &frame, LSN lsn)
+{
+  frame.clear_page();
+  auto *map_page            = reinterpret_cast<BPAllocationMapPage *>(frame.data());
+  map_page->allocated_pages = 1;
+  map_page->bitmap[0]       = 0x01;
+  frame.set_lsn(lsn);
+  frame.mark_dirty();
+}
+
+RC DiskBufferPool::load_allocation_maps()
+{
+  page_allocator_.reset(file_header_->page_count);
+  page_allocator_.load_group(0, file_header_->bitmap);
+
+  scoped_lock lock_guard(lock_);
+  const int   group_count = page_allocator_.group_of(file_header_->page_count - 1) + 1;
+  for (int group = 1; group < group_count; group++) {
+    const PageNum map_page_num = page_allocator_.group_start(group);
+    Frame        *map_frame    = nullptr;
+    RC            rc           = get_page_internal(map_page_num, &map_frame);
+    if (OB_FAIL(rc)) {
+      // 这一组的页面都当做已经分配的，不会被重复分配。回放日志时还会修改
+      LOG_WARN("failed to load allocation map. file=%s, page num=%d, rc=%s", file_name_.c_str(), map_page_num, strrc(rc));
+      continue;
+    }
+
+    page_allocator_.load_group(group, reinterpret_cast<BPAllocationMapPage *>(map_frame->data())->bitmap);
+    map_frame->unpin();
+  }
+
+  struct stat st;
+  if (fstat(file_desc_, &st) == 0) {
+    reserved_pages_ = static_cast<PageNum>(st.st_size / BP_PAGE_SIZE);
+  }
+  return RC::SUCCESS;
+}
+
+void DiskBufferPool::reserve_file_space(PageNum page_count)
+{
+  if (page_count <= reserved_pages_) {
+    return;
+  }
+
+  const PageNum reserve_pages = (page_count + EXTENT_PAGE_NUM - 1) / EXTENT_PAGE_NUM * EXTENT_PAGE_NUM;
+#ifdef __linux__
+  // 一次预留一批页面的空间，减少文件系统分配空间的次数，也让文件在磁盘上更连续
+  const off_t offset = static_cast<off_t>(reserved_pages_) * BP_PAGE_SIZE;
+  const off_t length = static_cast<off_t>(reserve_pages - reserved_pages_) * BP_PAGE_SIZE;
+  int         ret    = posix_fallocate(file_desc_, offset, length);
+  if (ret != 0) {
+    // 只是优化，失败了也可以直接写页面扩展文件
+    LOG_WARN("failed to reserve file space. file=%s, page count=%d, error=%s",
+             file_name_.c_str(), reserve_pages, strerror(ret));
+  }
+#endif
+  reserved_pages_ = reserve_pages;
+}
+
 RC DiskBufferPool::unpin_page(Frame *frame)
 {
   frame->unpin();
@@ -506,12 +875,26 @@ RC DiskBufferPool::purge_page(PageNum page_num)
 
 RC DiskBufferPool::purge_all_pages()
 {
-  list<Frame *> used = frame_manager_.find_list(id());
+  list<Frame *>   used = frame_manager_.find_list(id());
+  vector<Frame *> frames(used.begin(), used.end());
+  sort(frames.begin(), frames.end(), frame_page_num_less);
 
   scoped_lock lock_guard(lock_);
-  for (list<Frame *>::iterator it = used.begin(); it != used.end(); ++it) {
-    Frame *frame = *it;
 
+  // 先把可以释放的脏页一起刷新出去，相邻的页面可以合并写入
+  vector<Frame *> dirty_frames;
+  for (Frame *frame : frames) {
+    if (frame->pin_count() == 1 && frame->dirty()) {
+      dirty_frames.push_back(frame);
+    }
+  }
+
+  RC rc = flush_pages_internal(dirty_frames);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to flush dirty pages before purge. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+  }
+
+  for (Frame *frame : frames) {
     purge_frame(frame->page_num(), frame);
   }
   return RC::SUCCESS;
@@ -566,144 +949,362 @@ RC DiskBufferPool::flush_page_internal(Frame &frame)
   return RC::SUCCESS;
 }
 
+RC DiskBufferPool::flush_pages_internal(const vector<Frame *> &frames)
+{
+  if (frames.empty()) {
+    return RC::SUCCESS;
+  }
+
+  for (Frame *frame : frames) {
+    RC rc = log_handler_.flush_page(frame->page());
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("Failed to log flush frame= %s, rc=%s", frame->to_string().c_str(), strrc(rc));
+      // ignore error handle
+    }
+
+    frame->set_check_sum(crc32(frame->page().data, BP_PAGE_DATA_SIZE));
+  }
+
+  RC rc = dblwr_manager_.add_pages(this, frames);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  for (Frame *frame : frames) {
+    frame->clear_dirty();
+  }
+  LOG_DEBUG("Flush blocks. file desc=%d, first page=%d, page count=%d",
+            file_desc_, frames.front()->page_num(), static_cast<int>(frames.size()));
+  return RC::SUCCESS;
+}
+
 RC DiskBufferPool::flush_all_pages()
 {
   list<Frame *> used = frame_manager_.find_list(id());
+
+  vector<Frame *> dirty_frames;
   for (Frame *frame : used) {
-    RC rc = flush_page(*frame);
+    if (frame->dirty()) {
+      dirty_frames.push_back(frame);
+    } else {
+      frame->unpin();
+    }
+  }
+  sort(dirty_frames.begin(), dirty_frames.end(), frame_page_num_less);
+
+  // 分批持有锁，避免刷新大量页面时长时间阻塞其它访问
+  RC rc = RC::SUCCESS;
+  for (size_t begin = 0; begin < dirty_frames.size() && OB_SUCC(rc); begin += FLUSH_BATCH_PAGE_NUM) {
+    const size_t    end = min(begin + FLUSH_BATCH_PAGE_NUM, dirty_frames.size());
+    vector<Frame *> batch(dirty_frames.begin() + begin, dirty_frames.begin() + end);
+
+    scoped_lock lock_guard(lock_);
+    rc = flush_pages_internal(batch);
+  }
+
+  for (Frame *frame : dirty_frames) {
     frame->unpin();
-    if (rc != RC::SUCCESS) {
-      LOG_WARN("failed to flush all pages");
-      return rc;
+  }
+
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to flush all pages. rc=%s", strrc(rc));
+  }
+  return rc;
+}
+
+RC DiskBufferPool::flush_pinned_pages(const vector<Frame *> &frames, int &flushed_count)
+{
+  flushed_count = 0;
+
+  RC rc = RC::SUCCESS;
+  for (size_t begin = 0; begin < frames.size() && OB_SUCC(rc); begin += FLUSH_BATCH_PAGE_NUM) {
+    const size_t end = min(begin + FLUSH_BATCH_PAGE_NUM, frames.size());
+
+    scoped_lock lock_guard(lock_);
+
+    // 持有读锁，刷新时页面不会被修改
+    vector<Frame *> batch;
+    for (size_t i = begin; i < end; i++) {
+      Frame *frame = frames[i];
+      if (frame->dirty() && frame->try_read_latch()) {
+        batch.push_back(frame);
+      }
+    }
+
+    rc = flush_pages_internal(batch);
+    if (OB_SUCC(rc)) {
+      flushed_count += static_cast<int>(batch.size());
+    }
+
+    for (Frame *frame : batch) {
+      frame->read_unlatch();
     }
   }
-  return RC::SUCCESS;
+
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to flush pinned pages. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+  }
+  return rc;
 }
 
 RC DiskBufferPool::recover_page(PageNum page_num)
 {
-  int byte = 0, bit = 0;
-  byte = page_num / 8;
-  bit  = page_num % 8;
-
   scoped_lock lock_guard(lock_);
-  if (!(file_header_->bitmap[byte] & (1 << bit))) {
-    file_header_->bitmap[byte] |= (1 << bit);
-    file_header_->allocated_pages++;
-    file_header_->page_count++;
-    hdr_frame_->mark_dirty();
+  if (page_num >= file_header_->page_count) {
+    // 只能在最后一组内扩展，跨组时需要创建分配图，应该由 redo_allocate_page 处理
+    if (page_allocator_.group_of(page_num) != page_allocator_.group_of(file_header_->page_count - 1)) {
+      LOG_WARN("page %d is not exist. file=%s, page_count=%d", page_num, file_name_.c_str(), file_header_->page_count);
+      return RC::INTERNAL;
+    }
+
+    for (PageNum i = file_header_->page_count; i < page_num; i++) {
+      page_allocator_.extend(i + 1);
+      page_allocator_.clear_allocated(i);
+    }
+    file_header_->page_count = page_num + 1;
+    page_allocator_.extend(file_header_->page_count);
+    page_allocator_.clear_allocated(page_num);
+  }
+
+  if (!page_allocator_.is_allocated(page_num)) {
+    return set_page_allocated(page_num, true, 0 /*lsn*/, false /*update_lsn*/);
   }
   return RC::SUCCESS;
 }
 
 RC DiskBufferPool::write_page(PageNum page_num, Page &page)
 {
-  scoped_lock lock_guard(wr_lock_);
-  int64_t     offset = ((int64_t)page_num) * sizeof(Page);
-  if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to write page %lld of %d due to failed to seek %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_SEEK;
-  }
+  IoBatch batch(bp_manager_.io_engine());
+  batch.add_write(file_desc_, ((int64_t)page_num) * sizeof(Page), {{&page, sizeof(Page)}});
 
-  if (writen(file_desc_, &page, sizeof(Page)) != 0) {
-    LOG_ERROR("Failed to write page %lld of %d due to %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_WRITE;
+  RC rc = batch.submit_and_wait();
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to write page %d of %s. rc=%s", page_num, file_name_.c_str(), strrc(rc));
+    return rc;
   }
 
   LOG_TRACE("write_page: buffer_pool_id:%d, page_num:%d, lsn=%d, check_sum=%d", id(), page_num, page.lsn, page.check_sum);
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::redo_allocate_page(LSN lsn, PageNum page_num)
+RC DiskBufferPool::write_pages(const vector<pair<PageNum, Page *>> &pages)
 {
-  if (hdr_frame_->lsn() >= lsn) {
-    return RC::SUCCESS;
+  IoBatch batch(bp_manager_.io_engine());
+  prepare_write_pages(batch, pages);
+
+  RC rc = batch.submit_and_wait();
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to write pages of %s. page count=%d, rc=%s",
+              file_name_.c_str(), static_cast<int>(pages.size()), strrc(rc));
+    return rc;
   }
 
-  // scoped_lock lock_guard(lock_); // redo 过程中可以不加锁
-  if (page_num < file_header_->page_count) {
-    Bitmap bitmap(file_header_->bitmap, file_header_->page_count);
-    if (bitmap.get_bit(page_num)) {
-      LOG_WARN("page %d has been allocated. file=%s", page_num, file_name_.c_str());
-      return RC::SUCCESS;
+  LOG_TRACE("write_pages: buffer_pool_id:%d, page count=%d, io count=%d",
+            id(), static_cast<int>(pages.size()), static_cast<int>(batch.size()));
+  return RC::SUCCESS;
+}
+
+void DiskBufferPool::prepare_write_pages(IoBatch &batch, const vector<pair<PageNum, Page *>> &pages)
+{
+  vector<struct iovec> iov;
+  PageNum              first_page_num = -1;
+  for (const auto &[page_num, page] : pages) {
+    if (!iov.empty() && page_num != first_page_num + static_cast<PageNum>(iov.size())) {
+      batch.add_write(file_desc_, ((int64_t)first_page_num) * sizeof(Page), std::move(iov));
+      iov.clear();
     }
 
-    bitmap.set_bit(page_num);
-    file_header_->allocated_pages++;
-    hdr_frame_->mark_dirty();
-    return RC::SUCCESS;
+    if (iov.empty()) {
+      first_page_num = page_num;
+    }
+    iov.push_back({page, sizeof(Page)});
   }
 
-  if (page_num > file_header_->page_count) {
-    LOG_WARN("page %d is not continuous. file=%s, page_count=%d",
-             page_num, file_name_.c_str(), file_header_->page_count);
-    return RC::INTERNAL;
+  if (!iov.empty()) {
+    batch.add_write(file_desc_, ((int64_t)first_page_num) * sizeof(Page), std::move(iov));
   }
+}
 
-  // page_num == file_header_->page_count
-  if (file_header_->page_count >= BPFileHeader::MAX_PAGE_NUM) {
-    LOG_WARN("file buffer pool is full. page count %d, max page count %d",
-        file_header_->page_count, BPFileHeader::MAX_PAGE_NUM);
-    return RC::INTERNAL;
-  }
+RC DiskBufferPool::redo_allocate_page(LSN lsn, PageNum page_num)
+{
+  scoped_lock lock_guard(lock_);  // 回放时没有并发，加锁是因为访问分配图的接口需要持有锁
 
-  file_header_->allocated_pages++;
-  file_header_->page_count++;
-  hdr_frame_->set_lsn(lsn);
-  hdr_frame_->mark_dirty();
-  
-  // TODO 应该检查文件是否足够大，包含了当前新分配的页面
+  // 文件头和分配图各自根据自己的LSN判断是否需要回放
+  const bool redo_header = hdr_frame_->lsn() < lsn;
+  if (page_num >= file_header_->page_count) {
+    if (!redo_header) {
+      LOG_WARN("page %d is not exist but header is newer than log. file=%s, page_count=%d, header lsn=%ld, lsn=%ld",
+               page_num, file_name_.c_str(), file_header_->page_count, hdr_frame_->lsn(), lsn);
+      return RC::INTERNAL;
+    }
 
-  Bitmap bitmap(file_header_->bitmap, file_header_->page_count);
-  bitmap.set_bit(page_num);
-  LOG_TRACE("[redo] allocate new page. file=%s, pageNum=%d", file_name_.c_str(), page_num);
-  return RC::SUCCESS;
+    PageNum expected_page_num = file_header_->page_count;
+    if (page_allocator_.is_map_page(expected_page_num)) {
+      expected_page_num++;
+    }
+    if (page_num != expected_page_num) {
+      LOG_WARN("page %d is not continuous. file=%s, page_count=%d",
+               page_num, file_name_.c_str(), file_header_->page_count);
+      return RC::INTERNAL;
+    }
+
+    if (page_num != file_header_->page_count) {
+      RC rc = redo_create_allocation_map(lsn, page_allocator_.group_of(page_num));
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+
+    // 新页面可能还没有写到文件中，预留出空间，保证后面可以读取这个页面
+    file_header_->page_count++;
+    page_allocator_.extend(file_header_->page_count);
+    reserve_file_space(file_header_->page_count);
+    LOG_TRACE("[redo] allocate new page. file=%s, pageNum=%d", file_name_.c_str(), page_num);
+  }
+
+  return redo_page_allocated(lsn, page_num, true);
 }
 
 RC DiskBufferPool::redo_deallocate_page(LSN lsn, PageNum page_num)
 {
-  if (hdr_frame_->lsn() >= lsn) {
-    return RC::SUCCESS;
-  }
+  scoped_lock lock_guard(lock_);
 
   if (page_num >= file_header_->page_count) {
     LOG_WARN("page %d is not exist. file=%s", page_num, file_name_.c_str());
     return RC::INTERNAL;
   }
 
-  Bitmap bitmap(file_header_->bitmap, file_header_->page_count);
-  if (!bitmap.get_bit(page_num)) {
-    LOG_WARN("page %d has been deallocated. file=%s", page_num, file_name_.c_str());
-    return RC::INTERNAL;
+  LOG_TRACE("[redo] deallocate page. file=%s, pageNum=%d", file_name_.c_str(), page_num);
+  return redo_page_allocated(lsn, page_num, false);
+}
+
+RC DiskBufferPool::redo_page_allocated(LSN lsn, PageNum page_num, bool allocated)
+{
+  const bool redo_header = hdr_frame_->lsn() < lsn;
+  const int  group       = page_allocator_.group_of(page_num);
+
+  bool changed = false;
+  bool result  = allocated;  // 回放以后磁盘上的分配状态
+  if (group == 0) {
+    Bitmap bitmap(file_header_->bitmap, BPFileHeader::BITMAP_PAGE_NUM);
+    if (redo_header) {
+      changed = bitmap.get_bit(page_num) != allocated;
+      if (allocated) {
+        bitmap.set_bit(page_num);
+      } else {
+        bitmap.clear_bit(page_num);
+      }
+    }
+    result = bitmap.get_bit(page_num);
+  } else {
+    Frame *map_frame = nullptr;
+    RC     rc        = get_page_internal(page_allocator_.group_start(group), &map_frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get allocation map of page %d. file=%s, rc=%s", page_num, file_name_.c_str(), strrc(rc));
+      return rc;
+    }
+
+    auto     *map_page = reinterpret_cast<BPAllocationMapPage *>(map_frame->data());
+    Bitmap    bitmap(map_page->bitmap, BPAllocationMapPage::BITMAP_PAGE_NUM);
+    const int index = page_num - page_allocator_.group_start(group);
+    if (map_frame->lsn() < lsn) {
+      changed = bitmap.get_bit(index) != allocated;
+      if (changed) {
+        if (allocated) {
+          bitmap.set_bit(index);
+          map_page->allocated_pages++;
+        } else {
+          bitmap.clear_bit(index);
+          map_page->allocated_pages--;
+        }
+      }
+      map_frame->set_lsn(lsn);
+      map_frame->mark_dirty();
+    } else {
+      // 分配图比文件头新，文件头的计数还是要修改的
+      changed = true;
+    }
+    result = bitmap.get_bit(index);
+    map_frame->unpin();
   }
 
-  bitmap.clear_bit(page_num);
-  file_header_->allocated_pages--;
+  if (result) {
+    page_allocator_.set_allocated(page_num);
+  } else {
+    page_allocator_.clear_allocated(page_num);
+  }
+
+  if (!redo_header) {
+    return RC::SUCCESS;
+  }
+
+  if (changed) {
+    file_header_->allocated_pages += allocated ? 1 : -1;
+  } else {
+    LOG_WARN("page %d has been %s. file=%s", page_num, allocated ? "allocated" : "deallocated", file_name_.c_str());
+  }
   hdr_frame_->set_lsn(lsn);
   hdr_frame_->mark_dirty();
-  LOG_TRACE("[redo] deallocate page. file=%s, pageNum=%d", file_name_.c_str(), page_num);
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer)
+RC DiskBufferPool::redo_create_allocation_map(LSN lsn, int group)
 {
-  auto purger = [this](Frame *frame) {
-    if (!frame->dirty()) {
-      return RC::SUCCESS;
+  // 分配图在创建时就刷新过，文件中有这个页面时先读出来
+  const PageNum map_page_num = page_allocator_.group_start(group);
+  Frame        *map_frame    = nullptr;
+  if (map_page_num >= reserved_pages_ || OB_FAIL(get_page_internal(map_page_num, &map_frame))) {
+    RC rc = allocate_frame(map_page_num, &map_frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to allocate frame for allocation map. file=%s, page num=%d, rc=%s",
+               file_name_.c_str(), map_page_num, strrc(rc));
+      return rc;
     }
+    map_frame->set_buffer_pool_id(id());
+    map_frame->access();
+    map_frame->clear_page();
+    map_frame->set_page_num(map_page_num);
+  }
 
-    RC rc = RC::SUCCESS;
-    if (frame->buffer_pool_id() == id()) {
-      rc = this->flush_page_internal(*frame);
-    } else {
-      rc = bp_manager_.flush_page(*frame);
-    }
+  // 磁盘上的分配图比日志旧，说明创建以后还没有写到磁盘上。新页面的分配状态接下来由 redo_page_allocated 修改
+  if (map_frame->lsn() < lsn) {
+    init_allocation_map(*map_frame, 0 /*lsn*/);
+  }
 
-    if (rc != RC::SUCCESS) {
-      LOG_ERROR("Failed to aclloc block due to failed to flush old block. rc=%s", strrc(rc));
-    }
-    return rc;
-  };
+  file_header_->page_count++;
+  file_header_->allocated_pages++;
+  page_allocator_.extend(file_header_->page_count);
+  page_allocator_.load_group(group, reinterpret_cast<BPAllocationMapPage *>(map_frame->data())->bitmap);
+  map_frame->unpin();
+  LOG_TRACE("[redo] create allocation map. file=%s, pageNum=%d", file_name_.c_str(), map_page_num);
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::flush_frame_before_purge(Frame &frame)
+{
+  if (!frame.dirty()) {
+    return RC::SUCCESS;
+  }
+
+  // 前台线程只能等待脏页写完才能拿到页帧
+  bp_manager_.page_cleaner().on_foreground_stall();
+
+  RC rc = RC::SUCCESS;
+  if (frame.buffer_pool_id() == id()) {
+    rc = this->flush_page_internal(frame);
+  } else {
+    rc = bp_manager_.flush_page(frame);
+  }
+
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to aclloc block due to failed to flush old block. rc=%s", strrc(rc));
+  }
+  return rc;
+}
+
+RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer)
+{
+  auto purger = [this](Frame *frame) { return flush_frame_before_purge(*frame); };
 
   while (true) {
     Frame *frame = frame_manager_.alloc(id(), page_num);
@@ -725,7 +1326,7 @@ RC DiskBufferPool::check_page_num(PageNum page_num)
     LOG_ERROR("Invalid pageNum:%d, file's name:%s", page_num, file_name_.c_str());
     return RC::BUFFERPOOL_INVALID_PAGE_NUM;
   }
-  if ((file_header_->bitmap[page_num / 8] & (1 << (page_num % 8))) == 0) {
+  if (!page_allocator_.is_allocated(page_num) || page_allocator_.is_map_page(page_num)) {
     LOG_ERROR("Invalid pageNum:%d, file's name:%s", page_num, file_name_.c_str());
     return RC::BUFFERPOOL_INVALID_PAGE_NUM;
   }
@@ -740,18 +1341,12 @@ RC DiskBufferPool::load_page(PageNum page_num, Frame *frame)
     return rc;
   }
 
-  scoped_lock lock_guard(wr_lock_);
-  int64_t          offset = ((int64_t)page_num) * BP_PAGE_SIZE;
-  if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to load page %s:%d, due to failed to lseek:%s.", file_name_.c_str(), page_num, strerror(errno));
-
-    return RC::IOERR_SEEK;
-  }
-
-  int ret = readn(file_desc_, &page, BP_PAGE_SIZE);
-  if (ret != 0) {
-    LOG_ERROR("Failed to load page %s, file_desc:%d, page num:%d, due to failed to read data:%s, ret=%d, page count=%d",
-              file_name_.c_str(), file_desc_, page_num, strerror(errno), ret, file_header_->allocated_pages);
+  IoBatch batch(bp_manager_.io_engine());
+  batch.add_read(file_desc_, ((int64_t)page_num) * BP_PAGE_SIZE, {{&page, BP_PAGE_SIZE}});
+  rc = batch.submit_and_wait();
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to load page %s, file_desc:%d, page num:%d, due to failed to read data, result=%d, rc=%s",
+              file_name_.c_str(), file_desc_, page_num, batch.result(0), strrc(rc));
     return RC::IOERR_READ;
   }
 
@@ -764,20 +1359,136 @@ RC DiskBufferPool::load_page(PageNum page_num, Frame *frame)
 
 int DiskBufferPool::file_desc() const { return file_desc_; }
 
+int DiskBufferPool::read_ahead_pages() const { return bp_manager_.read_ahead_pages(); }
+
+RC DiskBufferPool::read_ahead(PageNum start_page, int count)
+{
+  // 大部分情况下页面已经预读过了，先不加锁检查一下
+  if (count <= 0 || frame_manager_.contains(id(), start_page)) {
+    return RC::SUCCESS;
+  }
+
+  scoped_lock lock_guard(lock_);
+  return read_ahead_internal(start_page, count);
+}
+
+RC DiskBufferPool::read_ahead_internal(PageNum start_page, int count)
+{
+  if (count <= 0 || start_page < 0 || start_page >= file_header_->page_count ||
+      frame_manager_.contains(id(), start_page)) {
+    return RC::SUCCESS;
+  }
+
+  auto purger = [this](Frame *frame) { return flush_frame_before_purge(*frame); };
+
+  // 先把需要读取的页面都分配好页帧，按照页面编号排序
+  vector<Frame *> frames;
+  int             dblwr_page_count = 0;
+  for (PageNum page_num = page_allocator_.next_allocated_page(start_page);
+       page_num != BP_INVALID_PAGE_NUM && count > 0;
+       page_num = page_allocator_.next_allocated_page(page_num + 1), count--) {
+    if (frame_manager_.contains(id(), page_num)) {
+      continue;
+    }
+
+    // 预读不能为了腾出页帧反复淘汰页面，最多尝试一次
+    Frame *frame = frame_manager_.alloc(id(), page_num);
+    if (nullptr == frame && frame_manager_.purge_frames(1 /*count*/, purger) > 0) {
+      frame = frame_manager_.alloc(id(), page_num);
+    }
+    if (nullptr == frame) {
+      LOG_TRACE("no free frame for read ahead. file=%s, page num=%d", file_name_.c_str(), page_num);
+      break;
+    }
+
+    // 页帧已经可以被其它线程看到了，加上写锁，防止其它线程读到还没有加载完成的数据
+    frame->write_latch();
+    frame->access();
+    last_load_page_ = max(last_load_page_, page_num);
+
+    // double write buffer 中的页面可能比磁盘上的新
+    if (OB_SUCC(dblwr_manager_.read_page(this, page_num, frame->page()))) {
+      frame->set_read_ahead(true);
+      frame->write_unlatch();
+      frame->unpin();
+      dblwr_page_count++;
+      continue;
+    }
+    frames.push_back(frame);
+  }
+
+  if (frames.empty()) {
+    return RC::SUCCESS;
+  }
+
+  IoBatch              batch(bp_manager_.io_engine());
+  vector<struct iovec> iov;
+  PageNum              first_page_num = -1;
+  for (Frame *frame : frames) {
+    if (!iov.empty() && frame->page_num() != first_page_num + static_cast<PageNum>(iov.size())) {
+      batch.add_read(file_desc_, ((int64_t)first_page_num) * BP_PAGE_SIZE, std::move(iov));
+      iov.clear();
+    }
+
+    if (iov.empty()) {
+      first_page_num = frame->page_num();
+    }
+    iov.push_back({&frame->page(), BP_PAGE_SIZE});
+  }
+  batch.add_read(file_desc_, ((int64_t)first_page_num) * BP_PAGE_SIZE, std::move(iov));
+
+  const PageNum first_read_page = frames.front()->page_num();
+  const int     read_page_count = static_cast<int>(frames.size());
+
+  RC rc = batch.submit_and_wait();
+
+  if (OB_FAIL(rc)) {
+    // 可能有其它线程已经在等待这些页面了，所以不能直接释放页帧，一个一个地重新读一次
+    LOG_WARN("failed to read ahead pages, load them one by one. file=%s, first page num=%d, page count=%d, rc=%s",
+             file_name_.c_str(), first_read_page, read_page_count, strrc(rc));
+  }
+
+  for (Frame *frame : frames) {
+    const PageNum page_num = frame->page_num();
+    if (OB_FAIL(rc) && OB_FAIL(load_page(page_num, frame))) {
+      frame->write_unlatch();
+      purge_frame(page_num, frame);
+      continue;
+    }
+
+    frame->set_read_ahead(true);
+    frame->write_unlatch();
+    frame->unpin();
+  }
+
+  LOG_TRACE("read ahead pages. file=%s, first page num=%d, page count=%d, dblwr page count=%d, io count=%d",
+            file_name_.c_str(), first_read_page, read_page_count, dblwr_page_count, static_cast<int>(batch.size()));
+  return RC::SUCCESS;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
-BufferPoolManager::BufferPoolManager(int memory_size /* = 0 */)
+BufferPoolManager::BufferPoolManager(int memory_size /* = 0 */, int frame_shard_num /* = DEFAULT_SHARD_NUM */,
+    const char *frame_replacer /* = nullptr */)
+    : frame_manager_("BufPool", frame_shard_num, frame_replacer),
+      io_engine_(make_unique<SyncIoEngine>()),
+      page_cleaner_(*this)
 {
   if (memory_size <= 0) {
     memory_size = MEM_POOL_ITEM_NUM * DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
   }
   const int pool_num = max(memory_size / BP_PAGE_SIZE / DEFAULT_ITEM_NUM_PER_POOL, 1);
   frame_manager_.init(pool_num);
-  LOG_INFO("buffer pool manager init with memory size %d, page num: %d, pool num: %d",
-           memory_size, pool_num * DEFAULT_ITEM_NUM_PER_POOL, pool_num);
+  set_read_ahead_pages(DEFAULT_READ_AHEAD_PAGES);
+  LOG_INFO("buffer pool manager init with memory size %d, page num: %d, pool num: %d, frame shard num: %d, "
+           "frame replacer: %s",
+           memory_size, pool_num * DEFAULT_ITEM_NUM_PER_POOL, pool_num, frame_manager_.shard_num(),
+           frame_manager_.replacer_name());
 }
 
 BufferPoolManager::~BufferPoolManager()
 {
+  page_cleaner_.stop();
+
   unordered_map<string, DiskBufferPool *> tmp_bps;
   tmp_bps.swap(buffer_pools_);
 
@@ -792,6 +1503,26 @@ RC BufferPoolManager::init(unique_ptr<DoubleWriteBuffer> dblwr_buffer)
   return RC::SUCCESS;
 }
 
+void BufferPoolManager::set_read_ahead_pages(int pages)
+{
+  const int max_pages = static_cast<int>(frame_manager_.total_frame_num()) / MAX_READ_AHEAD_RATIO;
+  read_ahead_pages_   = max(0, min(pages, max_pages));
+}
+
+RC BufferPoolManager::init_io_engine(const char *name, int queue_depth)
+{
+  unique_ptr<IoEngine> io_engine;
+  RC                   rc = IoEngine::create(name, queue_depth, io_engine);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to create io engine. name=%s, queue depth=%d, rc=%s", name, queue_depth, strrc(rc));
+    return rc;
+  }
+
+  io_engine_ = std::move(io_engine);
+  LOG_INFO("buffer pool manager use io engine %s, queue depth=%d", io_engine_->name(), io_engine_->queue_depth());
+  return RC::SUCCESS;
+}
+
 RC BufferPoolManager::create_file(const char *file_name)
 {
   int fd = open(file_name, O_RDWR | O_CREAT | O_EXCL, S_IREAD | S_IWRITE);
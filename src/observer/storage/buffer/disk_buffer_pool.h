@@ -26,15 +26,20 @@ See the Mulan PSL v2 for more details. */
 #include <optional>
 
 #include "common/lang/bitmap.h"
-#include "common/lang/lru_cache.h"
 #include "common/lang/mutex.h"
 #include "common/lang/memory.h"
 #include "common/lang/unordered_map.h"
+#include "common/lang/utility.h"
+#include "common/lang/vector.h"
 #include "common/mm/mem_pool.h"
 #include "common/sys/rc.h"
 #include "common/types.h"
 #include "storage/buffer/frame.h"
+#include "storage/buffer/frame_replacer.h"
+#include "storage/buffer/io_engine.h"
 #include "storage/buffer/page.h"
+#include "storage/buffer/page_allocator.h"
+#include "storage/buffer/page_cleaner.h"
 #include "storage/buffer/buffer_pool_log.h"
 
 class BufferPoolManager;
@@ -51,15 +56,11 @@ class BufferPoolLogHandler;
 #define BP_FILE_SUB_HDR_SIZE (sizeof(BPFileSubHeader))
 
 /**
- * @brief BufferPool的文件第一个页面，存放一些元数据信息，包括了后面每页的分配信息。
+ * @brief BufferPool的文件第一个页面，存放一些元数据信息，包括了前面一部分页面的分配信息。
  * @ingroup BufferPool
- * @details
- * @code
- * TODO 1. 当前的做法，只能分配比较少的页面，你可以扩展一下，支持更多的页面或无限多的页面吗？
- *         可以参考Linux ext(n)和Windows NTFS等文件系统
- *      2. 当前使用bitmap存放页面分配情况，但是这种方法在页面非常多的时候，查找空闲页面的
- *         效率非常低，你有办法优化吗？
- * @endcode
+ * @details 文件头的位图只能记录 BITMAP_PAGE_NUM 个页面(第0组)。后面的页面每 BPAllocationMapPage::BITMAP_PAGE_NUM
+ * 个分成一组，每组的第一个页面是这一组的分配图，参考 BPAllocationMapPage。这样文件的大小就不受文件头的限制了。
+ * page_count 和 allocated_pages 包含了文件头和分配图页面。
  */
 struct BPFileHeader
 {
@@ -69,14 +70,33 @@ struct BPFileHeader
   char    bitmap[0];        //! 页面分配位图, 第0个页面(就是当前页面)，总是1
 
   /**
-   * 能够分配的最大的页面个数，即bitmap的字节数 乘以8
+   * 第0组的页面个数，即bitmap的字节数 乘以8
    */
-  static const int MAX_PAGE_NUM =
+  static const int BITMAP_PAGE_NUM =
       (BP_PAGE_DATA_SIZE - sizeof(buffer_pool_id) - sizeof(page_count) - sizeof(allocated_pages)) * 8;
 
   string to_string() const;
 };
 
+/**
+ * @brief 页面分配图，记录一组页面的分配情况
+ * @ingroup BufferPool
+ * @details 分配图是组内的第一个页面，自己也占用位图中的第0位，总是1。
+ * 第一次分配到某一组的页面时才会创建这一组的分配图，所以分配图的创建不需要单独记录日志，
+ * 回放分配页面的日志时按照同样的规则创建。分配图有自己的LSN，回放时与文件头分别判断是否需要修改。
+ * 各组的位置是固定的，可以直接根据页面编号计算出它属于哪一组，参考 PageAllocator。
+ */
+struct BPAllocationMapPage
+{
+  int32_t allocated_pages;  //! 这一组已经分配了多少个页面，包括分配图自己
+  char    bitmap[0];        //! 页面分配位图
+
+  /**
+   * 每组的页面个数
+   */
+  static const int BITMAP_PAGE_NUM = (BP_PAGE_DATA_SIZE - sizeof(allocated_pages)) * 8;
+};
+
 /**
  * @brief 管理页面Frame
  * @ingroup BufferPool
@@ -84,11 +104,22 @@ struct BPFileHeader
  * 当内存中的页帧不够用时，需要从内存中淘汰一些页帧，以便为新的页帧腾出空间。
  * 这个管理器负责为所有的BufferPool提供页帧管理服务，也就是所有的BufferPool磁盘文件
  * 在访问时都使用这个管理器映射到内存。
+ *
+ * 所有的页面查找都要经过这个管理器，如果只用一把锁保护整个页帧表，在多线程并发访问时这把锁
+ * 就会成为热点。因此这里按照 FrameId 的哈希值把页帧表拆分成多个分片(shard)，每个分片有自己的
+ * 锁和置换策略，命中时只需要锁住对应的分片，pin 本身是原子操作。淘汰页面时也是在分片内部按照
+ * 置换策略淘汰，多个分片轮流提供淘汰的页面。
+ * 分片个数设置为1时，与不分片的实现是等价的，方便做性能对比。
+ * 置换策略可以通过名字指定，参考 FrameReplacer::create。
  */
 class BPFrameManager
 {
 public:
-  BPFrameManager(const char *tag);
+  /// 默认的分片个数
+  static constexpr int DEFAULT_SHARD_NUM = 16;
+
+public:
+  BPFrameManager(const char *tag, int shard_num = DEFAULT_SHARD_NUM, const char *replacer_name = nullptr);
 
   RC init(int pool_num);
   RC cleanup();
@@ -102,6 +133,12 @@ public:
    */
   Frame *get(int buffer_pool_id, PageNum page_num);
 
+  /**
+   * @brief 页面是否在内存中
+   * @details 与 get 不同，不会 pin 住页面，也不算作一次访问
+   */
+  bool contains(int buffer_pool_id, PageNum page_num) const;
+
   /**
    * @brief 列出所有指定文件的页面
    *
@@ -125,25 +162,60 @@ public:
    */
   RC free(int buffer_pool_id, PageNum page_num, Frame *frame);
 
+  /**
+   * @brief 与free相同，但是只有调用者自己pin着页帧时才释放
+   * @details B+树的乐观读不加锁，可能会短暂地pin住一个即将释放的页面。
+   * @return 其它人也pin着这个页帧时返回 RC::LOCKED_UNLOCK，调用者稍后重试
+   */
+  RC try_free(int buffer_pool_id, PageNum page_num, Frame *frame);
+
   /**
    * 如果不能从空闲链表中分配新的页面，就使用这个接口，
    * 尝试从pin count=0的页面中淘汰一些
+   * @details 从上次淘汰结束的分片开始，依次在各个分片内部按照置换策略查找可以淘汰的页面，
+   * 同一时刻只会锁住一个分片
    * @param count 想要purge多少个页面
    * @param purger 需要在释放frame之前，对页面做些什么操作。当前是刷新脏数据到磁盘
    * @return 返回本次清理了多少个页面
    */
   int purge_frames(int count, function<RC(Frame *frame)> purger);
 
-  size_t frame_num() const { return frames_.count(); }
+  /**
+   * @brief 按照置换策略的淘汰顺序，在一个分片中查找没有被 pin 住的脏页
+   * @details 找到的页面会 pin 住再放到 frames 中，调用者用完之后需要 unpin。
+   * 后台刷脏页时使用，先刷新最先会被淘汰的页面，前台淘汰页面时就不需要等待写磁盘了
+   * @param shard_index 分片编号
+   * @param count 最多找多少个页面
+   * @return 本次找到了多少个页面
+   */
+  int find_dirty_victims(int shard_index, int count, vector<Frame *> &frames);
+
+  size_t frame_num() const;
+
+  /**
+   * @brief 当前有多少个脏页
+   * @details 需要遍历所有的页帧，不要频繁调用
+   */
+  size_t dirty_frame_num() const;
 
   /**
    * 测试使用。返回已经从内存申请的个数
    */
   size_t total_frame_num() const { return allocator_.get_size(); }
 
-private:
-  Frame *get_internal(const FrameId &frame_id);
-  RC     free_internal(const FrameId &frame_id, Frame *frame);
+  int shard_num() const { return static_cast<int>(shards_.size()); }
+
+  const char *replacer_name() const { return replacer_name_.c_str(); }
+
+  /**
+   * @brief 调用 get 时页面在内存中的次数
+   */
+  uint64_t hit_count() const;
+
+  /**
+   * @brief 调用 get 时页面不在内存中的次数
+   */
+  uint64_t miss_count() const;
 
 private:
   class BPFrameIdHasher
@@ -152,12 +224,33 @@ private:
     size_t operator()(const FrameId &frame_id) const { return frame_id.hash(); }
   };
 
-  using FrameLruCache  = common::LruCache<FrameId, Frame *, BPFrameIdHasher>;
+  using FrameMap       = unordered_map<FrameId, Frame *, BPFrameIdHasher>;
   using FrameAllocator = common::MemPoolSimple<Frame>;
 
-  mutex          lock_;
-  FrameLruCache  frames_;
-  FrameAllocator allocator_;
+  /**
+   * @brief 页帧表的一个分片
+   */
+  struct FrameShard
+  {
+    mutable mutex             lock;
+    FrameMap                  frames;
+    unique_ptr<FrameReplacer> replacer;
+    uint64_t                  hit_count  = 0;
+    uint64_t                  miss_count = 0;
+  };
+
+private:
+  FrameShard &shard_of(const FrameId &frame_id) const;
+
+  Frame *get_internal(FrameShard &shard, const FrameId &frame_id);
+  RC     free_internal(FrameShard &shard, const FrameId &frame_id, Frame *frame);
+  int    purge_shard(FrameShard &shard, int count, function<RC(Frame *frame)> &purger);
+
+private:
+  vector<unique_ptr<FrameShard>> shards_;
+  string                         replacer_name_;
+  atomic<size_t>                 purge_cursor_{0};  ///< 下次淘汰从哪个分片开始
+  FrameAllocator                 allocator_;
 };
 
 /**
@@ -170,14 +263,19 @@ public:
   BufferPoolIterator();
   ~BufferPoolIterator();
 
-  RC      init(DiskBufferPool &bp, PageNum start_page = 0);
+  /**
+   * @param read_ahead 是否预读。遍历到还没有预读过的页面时，把后面的页面一起读到内存中，参考 DiskBufferPool::read_ahead
+   */
+  RC      init(DiskBufferPool &bp, PageNum start_page = 0, bool read_ahead = false);
   bool    has_next();
   PageNum next();
   RC      reset();
 
 private:
-  common::Bitmap bitmap_;
-  PageNum        current_page_num_ = -1;
+  PageNum         current_page_num_ = -1;
+  DiskBufferPool *buffer_pool_      = nullptr;
+  bool            read_ahead_       = false;
+  PageNum         read_ahead_end_   = -1;  ///< 这个页面之前的页面已经预读过了
 };
 
 /**
@@ -210,8 +308,9 @@ public:
 
   /**
    * @brief 在指定文件中分配一个新的页面，并将其放入缓冲区，返回页面句柄指针。
-   * @details 分配页面时，如果文件中有空闲页，就直接分配一个空闲页；
-   * 如果文件中没有空闲页，则扩展文件规模来增加新的空闲页。
+   * @details 分配页面时，如果文件中有空闲页，就直接分配一个空闲页，参考 PageAllocator；
+   * 如果文件中没有空闲页，则扩展文件规模来增加新的空闲页。扩展到新的一组时，会先创建这一组的分配图。
+   * 文件按照 EXTENT_PAGE_NUM 个页面一次预留磁盘空间。
    */
   RC allocate_page(Frame **frame);
 
@@ -252,10 +351,34 @@ public:
   RC flush_page(Frame &frame);
 
   /**
-   * 刷新所有页面到double write buffer，即使pin count不是0
+   * 刷新所有脏页到double write buffer，即使pin count不是0
+   * @details 页面按照编号排序后分批刷新，编号相邻的页面可以合并成一次写入
    */
   RC flush_all_pages();
 
+  /**
+   * @brief 刷新一批已经被调用者 pin 住的页面，后台刷脏页时使用
+   * @details 已经不是脏页的，或者正在被其它线程修改(拿不到读锁)的页面会跳过。不会 unpin 页面
+   * @param flushed_count 实际刷新了多少个页面
+   */
+  RC flush_pinned_pages(const vector<Frame *> &frames, int &flushed_count);
+
+  /**
+   * @brief 预读页面
+   * @details 把从 start_page 开始的最多 count 个已经分配的页面读到内存中，不会 pin 住这些页面。
+   * 读请求一起提交给 IoEngine，编号连续的页面合并成一次读取。
+   * 如果 start_page 已经在内存中，就认为这些页面已经预读过了，直接返回。
+   * 预读只是一种优化，没有空闲的页帧或者读取失败时，就放弃剩下的页面。
+   * @param start_page 从这个页面开始预读，包含这个页面
+   * @param count 最多预读多少个页面
+   */
+  RC read_ahead(PageNum start_page, int count);
+
+  /**
+   * @brief 每次预读多少个页面，0 表示不预读
+   */
+  int read_ahead_pages() const;
+
   /**
    * 回放日志时处理page0中已被认定为不存在的page
    */
@@ -263,9 +386,22 @@ public:
 
   /**
    * 刷新页面到磁盘
+   * @details 使用pwrite写入指定位置，不同线程写不同的页面时不会相互阻塞
    */
   RC write_page(PageNum page_num, Page &page);
 
+  /**
+   * @brief 把多个页面写入磁盘
+   * @details 页面需要按照编号从小到大排序，编号连续的页面合并成一次写入，所有的写请求一起提交给 IoEngine
+   */
+  RC write_pages(const vector<pair<PageNum, Page *>> &pages);
+
+  /**
+   * @brief 把多个页面的写请求放到 batch 中，由调用方提交
+   * @details 与 write_pages 相同，只是不提交。可以把多个 BufferPool 的写请求放到一起提交
+   */
+  void prepare_write_pages(IoBatch &batch, const vector<pair<PageNum, Page *>> &pages);
+
   RC redo_allocate_page(LSN lsn, PageNum page_num);
   RC redo_deallocate_page(LSN lsn, PageNum page_num);
 
@@ -274,9 +410,62 @@ public:
 
   const char *filename() const { return file_name_.c_str(); }
 
+public:
+  /// 扩展文件时，一次预留多少个页面的磁盘空间
+  static constexpr int EXTENT_PAGE_NUM = 64;
+
 protected:
   RC allocate_frame(PageNum page_num, Frame **buf);
 
+  /**
+   * @brief 获取页面，调用时需要持有 lock_
+   */
+  RC get_page_internal(PageNum page_num, Frame **frame);
+
+  /**
+   * @brief 打开文件时从文件头和各组的分配图加载页面分配信息
+   */
+  RC load_allocation_maps();
+
+  /**
+   * @brief 修改磁盘上页面的分配状态，调用时需要持有 lock_
+   * @details 修改文件头或者页面所在组的分配图，以及文件头中分配的页面个数，同时修改 page_allocator_
+   * @param lsn 修改后的页面LSN
+   * @param update_lsn 是否修改页面的LSN
+   */
+  RC set_page_allocated(PageNum page_num, bool allocated, LSN lsn, bool update_lsn = true);
+
+  /**
+   * @brief 回放日志时修改页面的分配状态
+   * @details 文件头或分配图的LSN比日志的新时不修改，但是会把磁盘上的分配状态同步到 page_allocator_
+   */
+  RC redo_page_allocated(LSN lsn, PageNum page_num, bool allocated);
+
+  /**
+   * @brief 回放日志时创建或者加载一组的分配图，同时扩展文件的页面个数
+   */
+  RC redo_create_allocation_map(LSN lsn, int group);
+
+  /**
+   * @brief 初始化一个新的分配图页面
+   */
+  void init_allocation_map(Frame &frame, LSN lsn);
+
+  /**
+   * @brief 为前 page_count 个页面预留磁盘空间，每次按照 EXTENT_PAGE_NUM 个页面扩展
+   */
+  void reserve_file_space(PageNum page_count);
+
+  /**
+   * @brief 淘汰页帧之前，如果页面是脏的，先刷新到磁盘
+   */
+  RC flush_frame_before_purge(Frame &frame);
+
+  /**
+   * @brief 预读页面，调用时需要持有 lock_
+   */
+  RC read_ahead_internal(PageNum start_page, int count);
+
   /**
    * 刷新指定页面到磁盘(flush)，并且释放关联的Frame
    */
@@ -293,6 +482,11 @@ protected:
    */
   RC flush_page_internal(Frame &frame);
 
+  /**
+   * @brief 一次刷新多个页面，页面需要按照编号从小到大排序
+   */
+  RC flush_pages_internal(const vector<Frame *> &frames);
+
 private:
   BufferPoolManager   &bp_manager_;     /// BufferPool 管理器
   BPFrameManager      &frame_manager_;  /// Frame 管理器
@@ -305,11 +499,16 @@ private:
   Frame        *hdr_frame_      = nullptr;  /// 文件头页面
   BPFileHeader *file_header_    = nullptr;  /// 文件头
   set<PageNum>  disposed_pages_;            /// 已经释放的页面
+  PageAllocator page_allocator_;            /// 所有页面的分配情况，与文件头和分配图同步修改
+  PageNum       reserved_pages_ = 0;        /// 已经预留了磁盘空间的页面个数
 
   string file_name_;  /// 文件名
 
+  /// 顺序读检测，在 lock_ 保护下修改。连续几次从磁盘加载的页面都在上一个页面后面不远处，就认为是在顺序读
+  PageNum last_load_page_   = -1;  /// 上一次从磁盘加载的页面，包括预读的页面
+  int     sequential_loads_ = 0;   /// 连续顺序加载的次数
+
   common::Mutex lock_;
-  common::Mutex wr_lock_;
 
 private:
   friend class BufferPoolIterator;
@@ -322,11 +521,38 @@ private:
 class BufferPoolManager final
 {
 public:
-  BufferPoolManager(int memory_size = 0);
+  /// 默认每次预读的页面个数
+  static constexpr int DEFAULT_READ_AHEAD_PAGES = 32;
+  /// 预读的页面最多占页帧总数的几分之一
+  static constexpr int MAX_READ_AHEAD_RATIO = 8;
+
+public:
+  /**
+   * @param memory_size 页帧占用的内存大小，单位字节
+   * @param frame_shard_num 页帧表的分片个数，参考 BPFrameManager
+   * @param frame_replacer 页帧置换策略的名字，参考 FrameReplacer::create
+   */
+  BufferPoolManager(int memory_size = 0, int frame_shard_num = BPFrameManager::DEFAULT_SHARD_NUM,
+      const char *frame_replacer = nullptr);
   ~BufferPoolManager();
 
   RC init(unique_ptr<DoubleWriteBuffer> dblwr_buffer);
 
+  /**
+   * @brief 设置页面读写使用的 IoEngine，需要在打开文件之前调用
+   * @details 默认使用同步读写
+   * @param name 引擎名字，参考 IoEngine::create
+   * @param queue_depth 异步引擎的队列深度
+   */
+  RC init_io_engine(const char *name, int queue_depth);
+
+  /**
+   * @brief 设置每次预读多少个页面，0 表示不预读
+   * @details 不会超过页帧总数的 1/MAX_READ_AHEAD_RATIO，防止预读的页面把其它页面都淘汰掉
+   */
+  void set_read_ahead_pages(int pages);
+  int  read_ahead_pages() const { return read_ahead_pages_; }
+
   RC create_file(const char *file_name);
   RC open_file(LogHandler &log_handler, const char *file_name, DiskBufferPool *&bp);
   RC close_file(const char *file_name);
@@ -334,7 +560,9 @@ public:
   RC flush_page(Frame &frame);
 
   BPFrameManager    &get_frame_manager() { return frame_manager_; }
+  PageCleaner       &page_cleaner() { return page_cleaner_; }
   DoubleWriteBuffer *get_dblwr_buffer() { return dblwr_buffer_.get(); }
+  IoEngine          &io_engine() { return *io_engine_; }
 
   /**
    * @brief 根据ID获取对应的BufferPool对象
@@ -345,10 +573,16 @@ public:
   RC get_buffer_pool(int32_t id, DiskBufferPool *&bp);
 
 private:
-  BPFrameManager frame_manager_{"BufPool"};
+  BPFrameManager frame_manager_;
+  int            read_ahead_pages_ = DEFAULT_READ_AHEAD_PAGES;
 
+  /// double write buffer 析构时还会写页面，所以放在它前面，在它之后析构
+  unique_ptr<IoEngine>          io_engine_;
   unique_ptr<DoubleWriteBuffer> dblwr_buffer_;
 
+  /// 后台线程会访问下面打开的文件，需要先停止
+  PageCleaner page_cleaner_;
+
   common::Mutex                            lock_;
   unordered_map<string, DiskBufferPool *>  buffer_pools_;
   unordered_map<int32_t, DiskBufferPool *> id_to_buffer_pools_;
@@ -45,6 +45,17 @@ const int32_t DoubleWritePage::SIZE = sizeof(DoubleWritePage);
 
 const int32_t DoubleWriteBufferHeader::SIZE = sizeof(DoubleWriteBufferHeader);
 
+RC DoubleWriteBuffer::add_pages(DiskBufferPool *bp, const vector<Frame *> &frames)
+{
+  for (Frame *frame : frames) {
+    RC rc = add_page(bp, frame->page_num(), frame->page());
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
 DiskDoubleWriteBuffer::DiskDoubleWriteBuffer(BufferPoolManager &bp_manager, int max_pages /*=16*/) 
   : max_pages_(max_pages), bp_manager_(bp_manager)
 {
@@ -77,14 +88,38 @@ RC DiskDoubleWriteBuffer::flush_page()
 {
   sync();
 
+  // 按照文件和页面编号排序，相邻的页面可以一次写入
+  vector<DoubleWritePage *> pages;
+  pages.reserve(dblwr_pages_.size());
   for (const auto &pair : dblwr_pages_) {
-    RC rc = write_page(pair.second);
-    if (rc != RC::SUCCESS) {
-      return rc;
+    pages.push_back(pair.second);
+  }
+  sort(pages.begin(), pages.end(), [](DoubleWritePage *a, DoubleWritePage *b) {
+    if (a->key.buffer_pool_id != b->key.buffer_pool_id) {
+      return a->key.buffer_pool_id < b->key.buffer_pool_id;
     }
-    pair.second->valid = false;
-    write_page_internal(pair.second);
-    delete pair.second;
+    return a->key.page_num < b->key.page_num;
+  });
+
+  RC rc = write_pages(pages);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  // 页面都已经写到 buffer pool 中了，一起把 double write buffer 中的页面标记为无效
+  IoBatch batch(bp_manager_.io_engine());
+  for (DoubleWritePage *page : pages) {
+    page->valid = false;
+    prepare_write_page(batch, page);
+  }
+  rc = batch.submit_and_wait();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to invalidate pages in double write buffer. page count=%d, rc=%s",
+             static_cast<int>(pages.size()), strrc(rc));
+  }
+
+  for (DoubleWritePage *page : pages) {
+    delete page;
   }
 
   dblwr_pages_.clear();
@@ -120,14 +155,14 @@ RC DiskDoubleWriteBuffer::add_page(DiskBufferPool *bp, PageNum page_num, Page &p
 
   if (page_cnt + 1 > header_.page_cnt) {
     header_.page_cnt = page_cnt + 1;
-    if (lseek(file_desc_, 0, SEEK_SET) == -1) {
-      LOG_ERROR("Failed to add page header due to failed to seek %s.", strerror(errno));
-      return RC::IOERR_SEEK;
-    }
 
-    if (writen(file_desc_, &header_, sizeof(header_)) != 0) {
-      LOG_ERROR("Failed to add page header due to %s.", strerror(errno));
-      return RC::IOERR_WRITE;
+    // 页面写完之后再更新文件头，文件头中记录的页面都是完整写入过的
+    IoBatch batch(bp_manager_.io_engine());
+    batch.add_write(file_desc_, 0, {{&header_, sizeof(header_)}});
+    rc = batch.submit_and_wait();
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("Failed to add page header. rc=%s", strrc(rc));
+      return rc;
     }
   }
 
@@ -142,39 +177,67 @@ RC DiskDoubleWriteBuffer::add_page(DiskBufferPool *bp, PageNum page_num, Page &p
   return RC::SUCCESS;
 }
 
+void DiskDoubleWriteBuffer::prepare_write_page(IoBatch &batch, DoubleWritePage *page)
+{
+  const int64_t offset = ((int64_t)page->page_index) * DoubleWritePage::SIZE + DoubleWriteBufferHeader::SIZE;
+  batch.add_write(file_desc_, offset, {{page, static_cast<size_t>(DoubleWritePage::SIZE)}});
+}
+
 RC DiskDoubleWriteBuffer::write_page_internal(DoubleWritePage *page)
 {
-  int32_t page_index = page->page_index;
-  int64_t offset = page_index * DoubleWritePage::SIZE + DoubleWriteBufferHeader::SIZE;
-  if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to add page %lld of %d due to failed to seek %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_SEEK;
-  }
+  IoBatch batch(bp_manager_.io_engine());
+  prepare_write_page(batch, page);
 
-  if (writen(file_desc_, page, DoubleWritePage::SIZE) != 0) {
-    LOG_ERROR("Failed to add page %lld of %d due to %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_WRITE;
+  RC rc = batch.submit_and_wait();
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to write page into double write buffer. page index=%d, rc=%s", page->page_index, strrc(rc));
+    return rc;
   }
-
   return RC::SUCCESS;
 }
 
-RC DiskDoubleWriteBuffer::write_page(DoubleWritePage *dblwr_page)
+RC DiskDoubleWriteBuffer::write_pages(const vector<DoubleWritePage *> &pages)
 {
-  DiskBufferPool *disk_buffer = nullptr;
-  // skip invalid page
-  if (!dblwr_page->valid) {
-    LOG_TRACE("double write buffer write page invalid. buffer_pool_id:%d,page_num:%d,lsn=%d",
-              dblwr_page->key.buffer_pool_id, dblwr_page->key.page_num, dblwr_page->page.lsn);
-    return RC::SUCCESS;
-  }
-  RC rc = bp_manager_.get_buffer_pool(dblwr_page->key.buffer_pool_id, disk_buffer);
-  ASSERT(OB_SUCC(rc) && disk_buffer != nullptr, "failed to get disk buffer pool of %d", dblwr_page->key.buffer_pool_id);
+  // 所有 buffer pool 的写请求一起提交，由 IoEngine 并发执行
+  IoBatch batch(bp_manager_.io_engine());
+  size_t  begin = 0;
+  while (begin < pages.size()) {
+    const int32_t buffer_pool_id = pages[begin]->key.buffer_pool_id;
+
+    vector<pair<PageNum, Page *>> bp_pages;
+    size_t                        end = begin;
+    for (; end < pages.size() && pages[end]->key.buffer_pool_id == buffer_pool_id; end++) {
+      DoubleWritePage *dblwr_page = pages[end];
+      // skip invalid page
+      if (!dblwr_page->valid) {
+        LOG_TRACE("double write buffer write page invalid. buffer_pool_id:%d,page_num:%d,lsn=%d",
+                  dblwr_page->key.buffer_pool_id, dblwr_page->key.page_num, dblwr_page->page.lsn);
+        continue;
+      }
+
+      LOG_TRACE("double write buffer write page. buffer_pool_id:%d,page_num:%d,lsn=%d",
+                dblwr_page->key.buffer_pool_id, dblwr_page->key.page_num, dblwr_page->page.lsn);
+      bp_pages.emplace_back(dblwr_page->key.page_num, &dblwr_page->page);
+    }
+    begin = end;
+
+    if (bp_pages.empty()) {
+      continue;
+    }
+
+    DiskBufferPool *disk_buffer = nullptr;
+    RC              rc          = bp_manager_.get_buffer_pool(buffer_pool_id, disk_buffer);
+    ASSERT(OB_SUCC(rc) && disk_buffer != nullptr, "failed to get disk buffer pool of %d", buffer_pool_id);
 
-  LOG_TRACE("double write buffer write page. buffer_pool_id:%d,page_num:%d,lsn=%d",
-            dblwr_page->key.buffer_pool_id, dblwr_page->key.page_num, dblwr_page->page.lsn);
+    disk_buffer->prepare_write_pages(batch, bp_pages);
+  }
 
-  return disk_buffer->write_page(dblwr_page->key.page_num, dblwr_page->page);
+  RC rc = batch.submit_and_wait();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to write pages to buffer pool. page count=%d, rc=%s", static_cast<int>(pages.size()), strrc(rc));
+    return rc;
+  }
+  return RC::SUCCESS;
 }
 
 RC DiskDoubleWriteBuffer::read_page(DiskBufferPool *bp, PageNum page_num, Page &page)
@@ -216,16 +279,20 @@ RC DiskDoubleWriteBuffer::clear_pages(DiskBufferPool *buffer_pool)
     return a->key.page_num < b->key.page_num;
   });
 
-  RC rc = RC::SUCCESS;
+  vector<pair<PageNum, Page *>> pages;
+  pages.reserve(spec_pages.size());
   for (DoubleWritePage *dbl_page : spec_pages) {
-    rc = buffer_pool->write_page(dbl_page->key.page_num, dbl_page->page);
-    if (OB_FAIL(rc)) {
-      LOG_WARN("Failed to write page %s:%d to disk buffer pool. rc=%s",
-               buffer_pool->filename(), dbl_page->key.page_num, strrc(rc));
-      break;
+    pages.emplace_back(dbl_page->key.page_num, &dbl_page->page);
+  }
+
+  RC rc = buffer_pool->write_pages(pages);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to write pages of %s to disk buffer pool. rc=%s", buffer_pool->filename(), strrc(rc));
+  } else {
+    for (DoubleWritePage *dbl_page : spec_pages) {
+      dbl_page->valid = false;
+      write_page_internal(dbl_page);
     }
-    dbl_page->valid = false;
-    write_page_internal(dbl_page);
   }
 
   for_each(spec_pages.begin(), spec_pages.end(), [](DoubleWritePage *dbl_page) { delete dbl_page; });
@@ -300,3 +367,13 @@ RC VacuousDoubleWriteBuffer::add_page(DiskBufferPool *bp, PageNum page_num, Page
   return bp->write_page(page_num, page);
 }
 
+RC VacuousDoubleWriteBuffer::add_pages(DiskBufferPool *bp, const vector<Frame *> &frames)
+{
+  vector<pair<PageNum, Page *>> pages;
+  pages.reserve(frames.size());
+  for (Frame *frame : frames) {
+    pages.emplace_back(frame->page_num(), &frame->page());
+  }
+  return bp->write_pages(pages);
+}
+
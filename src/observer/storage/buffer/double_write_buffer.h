@@ -16,13 +16,16 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/lang/mutex.h"
 #include "common/lang/unordered_map.h"
+#include "common/lang/vector.h"
 #include "common/types.h"
 #include "common/sys/rc.h"
 #include "storage/buffer/page.h"
 
 class DiskBufferPool;
+class Frame;
 struct DoubleWritePage;
 class BufferPoolManager;
+class IoBatch;
 
 class DoubleWriteBuffer
 {
@@ -35,6 +38,12 @@ public:
    */
   virtual RC add_page(DiskBufferPool *bp, PageNum page_num, Page &page) = 0;
 
+  /**
+   * @brief 一次加入同一个buffer pool的多个页面，页面按照编号从小到大排序
+   * @details 默认实现是逐个调用 add_page
+   */
+  virtual RC add_pages(DiskBufferPool *bp, const vector<Frame *> &frames);
+
   virtual RC read_page(DiskBufferPool *bp, PageNum page_num, Page &page) = 0;
 
   /**
@@ -125,8 +134,9 @@ public:
 private:
   /**
    * 将buffer中的页面写入对应的磁盘
+   * @details 页面需要按照buffer pool和页面编号排序，同一个文件中编号连续的页面会合并成一次写入
    */
-  RC write_page(DoubleWritePage *page);
+  RC write_pages(const vector<DoubleWritePage *> &pages);
 
   /**
    * 将页面写到当前double write buffer文件中
@@ -135,6 +145,11 @@ private:
    */
   RC write_page_internal(DoubleWritePage *page);
 
+  /**
+   * @brief 把写 double write buffer 文件中一个页面的请求加入到 batch 中
+   */
+  void prepare_write_page(IoBatch &batch, DoubleWritePage *page);
+
   /**
    * @brief 将磁盘文件中的内容加载到内存中。在启动时调用
    */
@@ -160,6 +175,11 @@ public:
    */
   RC add_page(DiskBufferPool *bp, PageNum page_num, Page &page) override;
 
+  /**
+   * @brief 直接写入磁盘，编号连续的页面合并成一次写入
+   */
+  RC add_pages(DiskBufferPool *bp, const vector<Frame *> &frames) override;
+
   RC read_page(DiskBufferPool *bp, PageNum page_num, Page &page) override { return RC::BUFFERPOOL_INVALID_PAGE_NUM; }
 
   /**
@@ -75,7 +75,7 @@ public:
    * @details 在 MemPoolSimple 分配和释放一个Frame对象时，不会调用构造函数和析构函数，
    * 而是调用reinit和reset。
    */
-  void reinit() {}
+  void reinit() { read_ahead_ = false; }
   void reset() {}
 
   void clear_page() { memset(&page_, 0, sizeof(page_)); }
@@ -137,6 +137,14 @@ public:
 
   char *data() { return page_.data; }
 
+  /**
+   * @brief 页面是否是预读进来的，而且还没有被访问过
+   * @details 预读的页面第一次被访问时，相当于刚刚加载到内存中，不应该算作再次访问。
+   * 否则像 2Q 这样的置换策略，会把扫描的页面都当成热点页面。
+   */
+  bool read_ahead() const { return read_ahead_; }
+  void set_read_ahead(bool read_ahead) { read_ahead_ = read_ahead; }
+
   bool can_purge() { return pin_count_.load() == 0; }
 
   /**
@@ -166,12 +174,31 @@ public:
   void read_unlatch();
   void read_unlatch(intptr_t xid);
 
+  /**
+   * @brief 获取页帧当前的版本号，用于不加锁的乐观读
+   * @details 每次加写锁和释放写锁时版本号都会加1，所以版本号是奇数时，说明有人正在修改页面。
+   * 乐观读在读取页面之前获取版本号，读取之后使用 validate_version 校验，如果期间页面被修改过，
+   * 读到的内容可能是不一致的，需要重新读取。调用者需要持有页面的pin，防止页帧被淘汰后复用。
+   */
+  uint64_t read_version() const { return version_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief 校验从 read_version 拿到版本号之后，页面是否被修改过
+   * @return 页面没有被修改过，而且拿到版本号时没有人正在修改页面，返回true
+   */
+  bool validate_version(uint64_t version) const
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (version & 1) == 0 && version_.load(std::memory_order_relaxed) == version;
+  }
+
   string to_string() const;
 
 private:
   friend class BufferPool;
 
-  bool          dirty_ = false;
+  bool          dirty_      = false;
+  bool          read_ahead_ = false;
   atomic<int>   pin_count_{0};
   unsigned long acc_time_ = 0;
   FrameId       frame_id_;
@@ -180,6 +207,11 @@ private:
   /// 在非并发编译时，加锁解锁动作将什么都不做
   common::RecursiveSharedMutex lock_;
 
+  /// 乐观读使用的版本号，参考 read_version
+  atomic<uint64_t> version_{0};
+  /// 写锁可以重入，只有最外层的加锁和解锁才修改版本号。只有持有写锁的线程会访问
+  int              write_depth_ = 0;
+
   /// 使用一些手段来做测试，提前检测出头疼的死锁问题
   /// 如果编译时没有增加调试选项，这些代码什么都不做
   common::DebugMutex           debug_lock_;
@@ -0,0 +1,132 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/buffer/frame_replacer.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+
+RC FrameReplacer::create(const char *name, size_t capacity, unique_ptr<FrameReplacer> &replacer)
+{
+  if (common::is_blank(name) || 0 == strcasecmp(name, "lru")) {
+    replacer = make_unique<LruFrameReplacer>();
+  } else if (0 == strcasecmp(name, "2q")) {
+    replacer = make_unique<TwoQueueFrameReplacer>(capacity);
+  } else {
+    LOG_WARN("unknown frame replacer: %s", name);
+    return RC::INVALID_ARGUMENT;
+  }
+  return RC::SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrameList::push_front(Frame *frame)
+{
+  ASSERT(!contains(frame), "frame has been in the list. frame=%s", frame->to_string().c_str());
+  frames_.push_front(frame);
+  index_[frame] = frames_.begin();
+}
+
+void FrameList::move_to_front(Frame *frame)
+{
+  auto iter = index_.find(frame);
+  if (iter == index_.end()) {
+    return;
+  }
+  frames_.splice(frames_.begin(), frames_, iter->second);
+}
+
+bool FrameList::remove(Frame *frame)
+{
+  auto iter = index_.find(frame);
+  if (iter == index_.end()) {
+    return false;
+  }
+  frames_.erase(iter->second);
+  index_.erase(iter);
+  return true;
+}
+
+bool FrameList::foreach_reverse(function<bool(Frame *)> &func)
+{
+  for (auto iter = frames_.rbegin(); iter != frames_.rend(); ++iter) {
+    if (!func(*iter)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TwoQueueFrameReplacer::TwoQueueFrameReplacer(size_t capacity)
+{
+  // 论文中推荐的参数是 A1in 占用 1/4 的容量，A1out 记录 1/2 容量的页帧标识
+  a1in_max_size_  = max(capacity / 4, static_cast<size_t>(1));
+  a1out_max_size_ = max(capacity / 2, static_cast<size_t>(1));
+}
+
+void TwoQueueFrameReplacer::insert(Frame *frame)
+{
+  auto iter = a1out_index_.find(frame->frame_id());
+  if (iter != a1out_index_.end()) {
+    a1out_.erase(iter->second);
+    a1out_index_.erase(iter);
+    am_.push_front(frame);
+  } else {
+    a1in_.push_front(frame);
+  }
+}
+
+void TwoQueueFrameReplacer::access(Frame *frame)
+{
+  // 每次访问页面都是一次独立的 get_this_page，扫描时每个页面只会获取一次，
+  // 所以在 A1in 中再次被访问，就可以认为是热点页面
+  if (a1in_.remove(frame)) {
+    am_.push_front(frame);
+  } else {
+    am_.move_to_front(frame);
+  }
+}
+
+void TwoQueueFrameReplacer::remove(Frame *frame)
+{
+  if (a1in_.remove(frame)) {
+    remember_evicted(frame->frame_id());
+  } else {
+    am_.remove(frame);
+  }
+}
+
+void TwoQueueFrameReplacer::foreach_victim(function<bool(Frame *)> func)
+{
+  if (a1in_.size() > a1in_max_size_) {
+    if (a1in_.foreach_reverse(func)) {
+      am_.foreach_reverse(func);
+    }
+  } else {
+    if (am_.foreach_reverse(func)) {
+      a1in_.foreach_reverse(func);
+    }
+  }
+}
+
+void TwoQueueFrameReplacer::remember_evicted(const FrameId &frame_id)
+{
+  if (a1out_index_.find(frame_id) != a1out_index_.end()) {
+    return;
+  }
+
+  a1out_.push_front(frame_id);
+  a1out_index_[frame_id] = a1out_.begin();
+  if (a1out_.size() > a1out_max_size_) {
+    a1out_index_.erase(a1out_.back());
+    a1out_.pop_back();
+  }
+}
@@ -0,0 +1,150 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/functional.h"
+#include "common/lang/list.h"
+#include "common/lang/memory.h"
+#include "common/lang/unordered_map.h"
+#include "common/sys/rc.h"
+#include "storage/buffer/frame.h"
+
+/**
+ * @brief 页帧置换策略
+ * @ingroup BufferPool
+ * @details 内存中的页帧不够用时，需要淘汰一些页帧。置换策略负责记录页帧的访问历史，并给出
+ * 淘汰页帧的先后顺序。页帧能否被淘汰(比如是否被pin住)，由调用方判断。
+ * BPFrameManager 的每个分片都有一个置换策略对象，由分片的锁来保护，所以这里的实现都不加锁。
+ */
+class FrameReplacer
+{
+public:
+  virtual ~FrameReplacer() = default;
+
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief 一个新的页帧加入到缓存中
+   */
+  virtual void insert(Frame *frame) = 0;
+
+  /**
+   * @brief 访问了一个已经在缓存中的页帧
+   */
+  virtual void access(Frame *frame) = 0;
+
+  /**
+   * @brief 页帧从缓存中移除，可能是被淘汰了，也可能是页面被释放了
+   * @details 调用时页帧中的 frame_id 还是有效的
+   */
+  virtual void remove(Frame *frame) = 0;
+
+  /**
+   * @brief 按照淘汰的优先级从高到低遍历所有页帧
+   * @param func 返回 false 时停止遍历
+   */
+  virtual void foreach_victim(function<bool(Frame *)> func) = 0;
+
+  /**
+   * @brief 根据名字创建置换策略
+   * @param name 置换策略名称，当前支持 lru 和 2q，不区分大小写
+   * @param capacity 这个置换策略最多管理多少个页帧，有些策略会根据容量来调整各个队列的大小
+   * @param replacer 创建出来的对象
+   */
+  static RC create(const char *name, size_t capacity, unique_ptr<FrameReplacer> &replacer);
+};
+
+/**
+ * @brief 页帧链表
+ * @ingroup BufferPool
+ * @details 可以在常数时间内插入、删除和移动到表头的链表，作为各种置换策略的基础组件。
+ * 表头是最新加入或最近访问的页帧，表尾是最老的页帧。
+ */
+class FrameList
+{
+public:
+  size_t size() const { return index_.size(); }
+  bool   contains(Frame *frame) const { return index_.find(frame) != index_.end(); }
+
+  void push_front(Frame *frame);
+  void move_to_front(Frame *frame);
+  bool remove(Frame *frame);
+
+  /**
+   * @brief 从表尾(最老的页帧)开始遍历
+   * @return 如果func返回false中断了遍历，就返回false
+   */
+  bool foreach_reverse(function<bool(Frame *)> &func);
+
+private:
+  list<Frame *>                                 frames_;
+  unordered_map<Frame *, list<Frame *>::iterator> index_;
+};
+
+/**
+ * @brief 最近最少使用(LRU)置换策略
+ * @ingroup BufferPool
+ * @details 一次全表扫描就可能把所有的热点页面都淘汰掉。
+ */
+class LruFrameReplacer : public FrameReplacer
+{
+public:
+  const char *name() const override { return "lru"; }
+
+  void insert(Frame *frame) override { frames_.push_front(frame); }
+  void access(Frame *frame) override { frames_.move_to_front(frame); }
+  void remove(Frame *frame) override { frames_.remove(frame); }
+  void foreach_victim(function<bool(Frame *)> func) override { frames_.foreach_reverse(func); }
+
+private:
+  FrameList frames_;
+};
+
+/**
+ * @brief 2Q置换策略
+ * @ingroup BufferPool
+ * @details 参考 Johnson & Shasha, "2Q: A Low Overhead High Performance Buffer Management Replacement Algorithm"。
+ * 第一次访问的页面放在 A1in 这个先进先出队列中，在 A1in 中再次被访问的页面会移动到 Am 这个LRU队列中。
+ * 从 A1in 淘汰出去的页面，只记录它的页帧标识到 A1out 中。如果一个页面在 A1out 中记录着的时候又被加载了，
+ * 说明它不是只访问一次的页面，也直接放到 Am 中。
+ * 全表扫描访问的页面都只会在 A1in 中停留，不会把 Am 中的热点页面挤出去。
+ */
+class TwoQueueFrameReplacer : public FrameReplacer
+{
+public:
+  explicit TwoQueueFrameReplacer(size_t capacity);
+
+  const char *name() const override { return "2q"; }
+
+  void insert(Frame *frame) override;
+  void access(Frame *frame) override;
+  void remove(Frame *frame) override;
+  void foreach_victim(function<bool(Frame *)> func) override;
+
+private:
+  class FrameIdHasher
+  {
+  public:
+    size_t operator()(const FrameId &frame_id) const { return frame_id.hash(); }
+  };
+
+  void remember_evicted(const FrameId &frame_id);
+
+private:
+  size_t a1in_max_size_  = 0;  ///< A1in 超过这个大小时优先从 A1in 中淘汰
+  size_t a1out_max_size_ = 0;  ///< A1out 最多记录多少个页帧标识
+
+  FrameList a1in_;  ///< 只访问过一次的页面，先进先出
+  FrameList am_;    ///< 多次访问的页面，LRU
+
+  list<FrameId>                                                a1out_;
+  unordered_map<FrameId, list<FrameId>::iterator, FrameIdHasher> a1out_index_;
+};
@@ -0,0 +1,161 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/buffer/io_engine.h"
+#include "common/io/io.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+#include "storage/buffer/uring_io_engine.h"
+
+size_t IoRequest::size() const
+{
+  size_t total = 0;
+  for (const struct iovec &item : iov) {
+    total += item.iov_len;
+  }
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RC IoEngine::create(const char *name, int queue_depth, unique_ptr<IoEngine> &engine)
+{
+  if (0 == strcasecmp(name, "sync")) {
+    engine = make_unique<SyncIoEngine>();
+    return RC::SUCCESS;
+  }
+
+  if (!common::is_blank(name) && 0 != strcasecmp(name, "uring")) {
+    LOG_WARN("unknown io engine: %s", name);
+    return RC::INVALID_ARGUMENT;
+  }
+
+#ifdef MINIOB_HAS_IO_URING
+  auto uring_engine = make_unique<UringIoEngine>();
+  RC   rc           = uring_engine->init(queue_depth);
+  if (OB_SUCC(rc)) {
+    engine = std::move(uring_engine);
+    return RC::SUCCESS;
+  }
+  LOG_WARN("io_uring is not available, use sync io engine instead. rc=%s", strrc(rc));
+#else
+  LOG_WARN("io_uring is not supported on this platform, use sync io engine instead");
+#endif
+
+  engine = make_unique<SyncIoEngine>();
+  return RC::SUCCESS;
+}
+
+void IoEngine::finish(IoRequest *request, int result)
+{
+  request->result = result;
+  request->batch->complete(request);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RC SyncIoEngine::submit(const vector<IoRequest *> &requests)
+{
+  for (IoRequest *request : requests) {
+    // pwritevn/preadvn 会修改iov，这里的请求不会再被使用，直接传进去即可
+    int result = 0;
+    if (request->type == IoRequest::Type::WRITE) {
+      result = common::pwritevn(request->fd, request->iov.data(), static_cast<int>(request->iov.size()), request->offset);
+    } else {
+      result = common::preadvn(request->fd, request->iov.data(), static_cast<int>(request->iov.size()), request->offset);
+    }
+    finish(request, result);
+  }
+  return RC::SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+IoBatch::~IoBatch() { (void)wait(); }
+
+void IoBatch::add_read(int fd, off_t offset, vector<struct iovec> iov)
+{
+  add(IoRequest::Type::READ, fd, offset, std::move(iov));
+}
+
+void IoBatch::add_write(int fd, off_t offset, vector<struct iovec> iov)
+{
+  add(IoRequest::Type::WRITE, fd, offset, std::move(iov));
+}
+
+void IoBatch::add(IoRequest::Type type, int fd, off_t offset, vector<struct iovec> iov)
+{
+  auto request    = make_unique<IoRequest>();
+  request->type   = type;
+  request->fd     = fd;
+  request->offset = offset;
+  request->iov    = std::move(iov);
+  request->batch  = this;
+  requests_.push_back(std::move(request));
+}
+
+RC IoBatch::submit()
+{
+  if (submitted_ >= requests_.size()) {
+    return RC::SUCCESS;
+  }
+
+  vector<IoRequest *> requests;
+  requests.reserve(requests_.size() - submitted_);
+  for (size_t i = submitted_; i < requests_.size(); i++) {
+    requests.push_back(requests_[i].get());
+  }
+
+  {
+    lock_guard<mutex> guard(lock_);
+    pending_ += requests.size();
+  }
+  submitted_ = requests_.size();
+
+  RC rc = engine_.submit(requests);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to submit io requests. engine=%s, count=%d, rc=%s",
+             engine_.name(), static_cast<int>(requests.size()), strrc(rc));
+  }
+  return rc;
+}
+
+RC IoBatch::wait()
+{
+  {
+    unique_lock<mutex> guard(lock_);
+    cond_.wait(guard, [this] { return pending_ == 0; });
+  }
+
+  for (size_t i = 0; i < submitted_; i++) {
+    const IoRequest &request = *requests_[i];
+    if (request.result != 0) {
+      LOG_WARN("io request failed. fd=%d, offset=%ld, size=%ld, result=%d:%s",
+               request.fd, static_cast<long>(request.offset), static_cast<long>(request.size()),
+               request.result, request.result > 0 ? strerror(request.result) : "end of file");
+      return request.type == IoRequest::Type::WRITE ? RC::IOERR_WRITE : RC::IOERR_READ;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC IoBatch::submit_and_wait()
+{
+  RC rc = submit();
+  // 提交失败时也可能有请求已经在执行了，需要等待它们结束
+  RC wait_rc = wait();
+  return OB_FAIL(rc) ? rc : wait_rc;
+}
+
+void IoBatch::complete(IoRequest *request)
+{
+  lock_guard<mutex> guard(lock_);
+  pending_--;
+  if (pending_ == 0) {
+    cond_.notify_all();
+  }
+}
@@ -0,0 +1,168 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "common/lang/condition_variable.h"
+#include "common/lang/memory.h"
+#include "common/lang/mutex.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+
+class IoBatch;
+
+/**
+ * @brief 一个读或写请求
+ * @ingroup BufferPool
+ * @details 读写的是文件中一段连续的数据，内存可以是多段，也就是 preadv/pwritev 的语义。
+ */
+struct IoRequest
+{
+  enum class Type
+  {
+    READ,
+    WRITE,
+  };
+
+  Type                 type   = Type::READ;
+  int                  fd     = -1;
+  off_t                offset = 0;
+  vector<struct iovec> iov;
+  int                  result = 0;        ///< 0 表示成功，-1 表示读到了文件尾，其它是errno
+  IoBatch             *batch  = nullptr;  ///< 请求所属的批次
+
+  size_t size() const;
+};
+
+/**
+ * @brief 异步读写引擎
+ * @ingroup BufferPool
+ * @details 页面的读写都可以通过这个引擎提交。异步的引擎提交请求后立即返回，请求完成后在其它线程中通知
+ * 请求所属的 IoBatch，调用方可以在等待的同时做其它事情；同步的引擎直接在提交的线程中完成读写。
+ * 引擎是所有 BufferPool 共享的，实现需要保证线程安全。
+ */
+class IoEngine
+{
+public:
+  virtual ~IoEngine() = default;
+
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief 最多同时有多少个请求在执行
+   */
+  virtual int queue_depth() const = 0;
+
+  /**
+   * @brief 提交一批请求
+   * @details 请求完成时会调用 IoBatch::complete，可能在当前线程中，也可能在引擎的后台线程中。
+   * 请求的内存在完成之前必须一直有效。
+   */
+  virtual RC submit(const vector<IoRequest *> &requests) = 0;
+
+  /**
+   * @brief 根据名字创建引擎
+   * @details 当前支持 sync 和 uring，不区分大小写。如果 uring 在当前系统中不可用，会使用 sync 代替。
+   * @param name 引擎名字，空字符串使用 uring
+   * @param queue_depth 异步引擎的队列深度
+   */
+  static RC create(const char *name, int queue_depth, unique_ptr<IoEngine> &engine);
+
+protected:
+  /**
+   * @brief 请求完成以后，由引擎调用
+   * @param result 0 表示成功，-1 表示读到了文件尾，其它是errno
+   */
+  static void finish(IoRequest *request, int result);
+};
+
+/**
+ * @brief 同步读写引擎
+ * @ingroup BufferPool
+ * @details 在提交请求的线程中直接调用 preadv/pwritev，是不支持异步IO时的实现。
+ */
+class SyncIoEngine : public IoEngine
+{
+public:
+  const char *name() const override { return "sync"; }
+  int         queue_depth() const override { return 1; }
+
+  RC submit(const vector<IoRequest *> &requests) override;
+};
+
+/**
+ * @brief 一批读写请求
+ * @ingroup BufferPool
+ * @details 调用方把要读写的数据都加入到一个批次中，一起提交给引擎，然后等待全部完成。
+ * 提交之后到等待之前，调用方可以继续做其它事情，比如处理已经读到内存中的数据。
+ * 析构时会等待所有已经提交的请求完成。
+ * @code
+ * IoBatch batch(engine);
+ * batch.add_write(fd, offset, iov);
+ * batch.submit();
+ * // do something else
+ * RC rc = batch.wait();
+ * @endcode
+ */
+class IoBatch
+{
+public:
+  explicit IoBatch(IoEngine &engine) : engine_(engine) {}
+  ~IoBatch();
+
+  IoBatch(const IoBatch &)            = delete;
+  IoBatch &operator=(const IoBatch &) = delete;
+
+  void add_read(int fd, off_t offset, vector<struct iovec> iov);
+  void add_write(int fd, off_t offset, vector<struct iovec> iov);
+
+  bool   empty() const { return requests_.empty(); }
+  size_t size() const { return requests_.size(); }
+
+  /**
+   * @brief 提交所有还没有提交的请求
+   */
+  RC submit();
+
+  /**
+   * @brief 等待所有已经提交的请求完成
+   * @return 只要有一个请求失败就返回失败，读请求返回 IOERR_READ，写请求返回 IOERR_WRITE
+   */
+  RC wait();
+
+  /**
+   * @brief 提交所有还没有提交的请求并等待完成，用于不需要在等待时做其它事情的场景
+   */
+  RC submit_and_wait();
+
+  /**
+   * @brief 返回指定请求的执行结果，需要在 wait 之后调用
+   * @param index 请求加入批次的顺序
+   */
+  int result(size_t index) const { return requests_[index]->result; }
+
+private:
+  friend class IoEngine;
+
+  void add(IoRequest::Type type, int fd, off_t offset, vector<struct iovec> iov);
+  void complete(IoRequest *request);
+
+private:
+  IoEngine                     &engine_;
+  vector<unique_ptr<IoRequest>> requests_;
+  size_t                        submitted_ = 0;  ///< 已经提交了多少个请求
+
+  mutex              lock_;
+  condition_variable cond_;
+  size_t             pending_ = 0;  ///< 已经提交但是还没有完成的请求个数
+};
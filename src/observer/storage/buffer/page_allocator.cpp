@@ -0,0 +1,257 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <bit>
+
+#include "storage/buffer/page_allocator.h"
+#include "common/lang/algorithm.h"
+#include "common/log/log.h"
+
+static constexpr int      WORD_BITS = 64;
+static constexpr uint64_t ALL_ONES  = ~static_cast<uint64_t>(0);
+
+static inline uint64_t bit_mask(int index) { return static_cast<uint64_t>(1) << (index % WORD_BITS); }
+
+PageAllocator::PageAllocator(int first_group_pages, int group_pages)
+    : first_group_pages_(first_group_pages), group_pages_(group_pages)
+{
+  ASSERT(first_group_pages > 0 && group_pages > 1, "invalid group pages. first=%d, others=%d",
+         first_group_pages, group_pages);
+}
+
+int PageAllocator::group_of(PageNum page_num) const
+{
+  if (page_num < first_group_pages_) {
+    return 0;
+  }
+  return 1 + (page_num - first_group_pages_) / group_pages_;
+}
+
+PageNum PageAllocator::group_start(int group) const
+{
+  if (group == 0) {
+    return 0;
+  }
+  return first_group_pages_ + static_cast<PageNum>(group - 1) * group_pages_;
+}
+
+int PageAllocator::group_pages(int group) const { return group == 0 ? first_group_pages_ : group_pages_; }
+
+bool PageAllocator::is_map_page(PageNum page_num) const
+{
+  return page_num >= first_group_pages_ && (page_num - first_group_pages_) % group_pages_ == 0;
+}
+
+void PageAllocator::reset(PageNum page_count)
+{
+  lock_guard<shared_mutex> guard(lock_);
+  groups_.clear();
+  free_groups_.clear();
+  page_count_ = 0;
+  if (page_count > 0) {
+    while (static_cast<int>(groups_.size()) <= group_of(page_count - 1)) {
+      add_group();
+    }
+  }
+  page_count_ = page_count;
+}
+
+void PageAllocator::add_group()
+{
+  const int group = static_cast<int>(groups_.size());
+  Group     new_group;
+  // 超出组内页面个数的位也设置为1，查找空闲页面时不需要单独判断
+  new_group.words.resize((group_pages(group) + WORD_BITS - 1) / WORD_BITS, ALL_ONES);
+  new_group.search_word = static_cast<int>(new_group.words.size());
+  groups_.push_back(std::move(new_group));
+}
+
+PageNum PageAllocator::valid_pages(int group) const
+{
+  return min(static_cast<PageNum>(group_pages(group)), page_count_ - group_start(group));
+}
+
+void PageAllocator::load_group(int group, const char *bitmap)
+{
+  lock_guard<shared_mutex> guard(lock_);
+  if (group < 0 || group >= static_cast<int>(groups_.size())) {
+    LOG_WARN("invalid group. group=%d, group count=%d", group, static_cast<int>(groups_.size()));
+    return;
+  }
+
+  Group        &target = groups_[group];
+  const PageNum pages  = valid_pages(group);
+  for (PageNum i = 0; i < pages; i++) {
+    if ((bitmap[i / 8] & (1 << (i % 8))) == 0) {
+      target.words[i / WORD_BITS] &= ~bit_mask(i);
+    } else {
+      target.words[i / WORD_BITS] |= bit_mask(i);
+    }
+  }
+  recount(group);
+}
+
+void PageAllocator::recount(int group)
+{
+  Group &target      = groups_[group];
+  target.free_pages  = 0;
+  target.search_word = static_cast<int>(target.words.size());
+  for (int i = static_cast<int>(target.words.size()) - 1; i >= 0; i--) {
+    const int zeros = std::popcount(~target.words[i]);
+    if (zeros > 0) {
+      target.free_pages += zeros;
+      target.search_word = i;
+    }
+  }
+
+  if (target.free_pages > 0) {
+    free_groups_.insert(group);
+  } else {
+    free_groups_.erase(group);
+  }
+}
+
+PageNum PageAllocator::page_count() const
+{
+  shared_lock<shared_mutex> guard(lock_);
+  return page_count_;
+}
+
+void PageAllocator::extend(PageNum page_count)
+{
+  lock_guard<shared_mutex> guard(lock_);
+  if (page_count <= page_count_) {
+    return;
+  }
+
+  while (static_cast<int>(groups_.size()) <= group_of(page_count - 1)) {
+    add_group();
+  }
+  page_count_ = page_count;
+}
+
+bool PageAllocator::is_allocated(PageNum page_num) const
+{
+  shared_lock<shared_mutex> guard(lock_);
+  if (page_num < 0 || page_num >= page_count_) {
+    return false;
+  }
+
+  const int     group = group_of(page_num);
+  const PageNum index = page_num - group_start(group);
+  return (groups_[group].words[index / WORD_BITS] & bit_mask(index)) != 0;
+}
+
+bool PageAllocator::set_allocated(PageNum page_num)
+{
+  lock_guard<shared_mutex> guard(lock_);
+  if (page_num < 0 || page_num >= page_count_) {
+    LOG_WARN("invalid page num. page num=%d, page count=%d", page_num, page_count_);
+    return false;
+  }
+
+  const int     group  = group_of(page_num);
+  const PageNum index  = page_num - group_start(group);
+  Group        &target = groups_[group];
+  uint64_t     &word   = target.words[index / WORD_BITS];
+  if ((word & bit_mask(index)) != 0) {
+    return false;
+  }
+
+  word |= bit_mask(index);
+  if (--target.free_pages == 0) {
+    free_groups_.erase(group);
+  }
+  return true;
+}
+
+bool PageAllocator::clear_allocated(PageNum page_num)
+{
+  lock_guard<shared_mutex> guard(lock_);
+  if (page_num < 0 || page_num >= page_count_) {
+    LOG_WARN("invalid page num. page num=%d, page count=%d", page_num, page_count_);
+    return false;
+  }
+
+  const int     group  = group_of(page_num);
+  const PageNum index  = page_num - group_start(group);
+  Group        &target = groups_[group];
+  uint64_t     &word   = target.words[index / WORD_BITS];
+  if ((word & bit_mask(index)) == 0) {
+    return false;
+  }
+
+  word &= ~bit_mask(index);
+  target.search_word = min(target.search_word, static_cast<int>(index / WORD_BITS));
+  if (target.free_pages++ == 0) {
+    free_groups_.insert(group);
+  }
+  return true;
+}
+
+PageNum PageAllocator::find_free_page()
+{
+  lock_guard<shared_mutex> guard(lock_);
+  if (free_groups_.empty()) {
+    return BP_INVALID_PAGE_NUM;
+  }
+
+  const int group  = *free_groups_.begin();
+  Group    &target = groups_[group];
+  for (int i = target.search_word; i < static_cast<int>(target.words.size()); i++) {
+    const uint64_t free_bits = ~target.words[i];
+    if (free_bits != 0) {
+      target.search_word = i;
+      return group_start(group) + static_cast<PageNum>(i) * WORD_BITS + std::countr_zero(free_bits);
+    }
+  }
+
+  LOG_ERROR("no free page found in group. group=%d, free pages=%d", group, target.free_pages);
+  recount(group);
+  return BP_INVALID_PAGE_NUM;
+}
+
+PageNum PageAllocator::next_allocated_page(PageNum start_page) const
+{
+  shared_lock<shared_mutex> guard(lock_);
+
+  PageNum page_num = max(start_page, 0);
+  while (page_num < page_count_) {
+    const int     group     = group_of(page_num);
+    const PageNum first     = group_start(group);
+    const PageNum end_index = valid_pages(group);
+    const Group  &target    = groups_[group];
+    PageNum       index     = page_num - first;
+
+    PageNum found = BP_INVALID_PAGE_NUM;
+    while (index < end_index) {
+      const uint64_t bits = target.words[index / WORD_BITS] & (ALL_ONES << (index % WORD_BITS));
+      if (bits != 0) {
+        found = (index / WORD_BITS) * WORD_BITS + std::countr_zero(bits);
+        break;
+      }
+      index = (index / WORD_BITS + 1) * WORD_BITS;
+    }
+
+    if (found == BP_INVALID_PAGE_NUM || found >= end_index) {
+      page_num = first + end_index;
+      continue;
+    }
+
+    page_num = first + found;
+    if (group > 0 && found == 0) {
+      // 跳过分配图
+      page_num++;
+      continue;
+    }
+    return page_num;
+  }
+  return BP_INVALID_PAGE_NUM;
+}
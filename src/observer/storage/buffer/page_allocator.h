@@ -0,0 +1,131 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/mutex.h"
+#include "common/lang/set.h"
+#include "common/lang/vector.h"
+#include "common/types.h"
+#include "storage/buffer/page.h"
+
+/**
+ * @brief 在内存中记录一个文件所有页面的分配情况，用于快速查找空闲页面
+ * @ingroup BufferPool
+ * @details 文件中的页面分成多个组(group)，第0组的分配位图放在文件头页面中，后面每一组的分配位图放在
+ * 组内的第一个页面中，参考 BPAllocationMapPage。这里按照同样的分组，把每一组的位图按照64位的字保存在内存中，
+ * 同时记录每组有多少个空闲页面，以及下次从哪个字开始查找。有空闲页面的组放在一个有序集合中。
+ * 分配页面时取编号最小的有空闲页面的组，从查找位置开始按字查找。查找位置只有释放页面时才会往回移动，
+ * 所以查找空闲页面的时间均摊下来是常数，与文件的大小无关。
+ * 编号不小于 page_count 的页面在文件中还不存在，在位图中当做已经分配的页面，这样查找空闲页面时不会找到它们。
+ * 这个类不会修改磁盘上的数据，由 DiskBufferPool 同时维护内存和磁盘上的位图。
+ * 所有的接口都是线程安全的，遍历页面时可以与分配、释放页面并发执行。
+ */
+class PageAllocator
+{
+public:
+  /**
+   * @param first_group_pages 第0组的页面个数
+   * @param group_pages 后面每一组的页面个数
+   */
+  PageAllocator(int first_group_pages, int group_pages);
+
+  /**
+   * @brief 页面属于第几组
+   */
+  int group_of(PageNum page_num) const;
+
+  /**
+   * @brief 每组第一个页面的编号。第0组从文件头开始，其它组的第一个页面就是分配图
+   */
+  PageNum group_start(int group) const;
+
+  /**
+   * @brief 每组的页面个数
+   */
+  int group_pages(int group) const;
+
+  /**
+   * @brief 是否是第1组及以后的分配图页面
+   */
+  bool is_map_page(PageNum page_num) const;
+
+  /**
+   * @brief 重新设置文件的页面个数，清空所有的分配信息
+   * @details 所有的页面都当做已经分配的，需要再调用 load_group 加载每组的位图
+   */
+  void reset(PageNum page_count);
+
+  /**
+   * @brief 加载一组页面的分配位图
+   * @param bitmap 磁盘上的位图，格式与 common::Bitmap 相同
+   */
+  void load_group(int group, const char *bitmap);
+
+  /**
+   * @brief 文件中一共有多少个页面，包括文件头和分配图
+   */
+  PageNum page_count() const;
+
+  /**
+   * @brief 扩展文件的页面个数，新增加的页面都是已经分配的状态
+   */
+  void extend(PageNum page_count);
+
+  bool is_allocated(PageNum page_num) const;
+
+  /**
+   * @brief 把页面设置为已经分配
+   * @return 页面原来是已经分配的返回false
+   */
+  bool set_allocated(PageNum page_num);
+
+  /**
+   * @brief 把页面设置为未分配
+   * @return 页面原来是未分配的返回false
+   */
+  bool clear_allocated(PageNum page_num);
+
+  /**
+   * @brief 查找一个空闲页面，不会修改页面的分配状态
+   * @return 没有空闲页面时返回 BP_INVALID_PAGE_NUM，需要扩展文件
+   */
+  PageNum find_free_page();
+
+  /**
+   * @brief 从 start_page 开始查找第一个已经分配的页面，会跳过各组的分配图
+   * @return 没有找到时返回 BP_INVALID_PAGE_NUM
+   */
+  PageNum next_allocated_page(PageNum start_page) const;
+
+private:
+  /**
+   * @brief 一组页面的分配位图
+   */
+  struct Group
+  {
+    vector<uint64_t> words;            ///< 分配位图，1表示已经分配
+    int              free_pages  = 0;  ///< 空闲页面个数
+    int              search_word = 0;  ///< 这个字之前没有空闲页面
+  };
+
+  void    add_group();
+  PageNum valid_pages(int group) const;
+  void    recount(int group);
+
+private:
+  const int first_group_pages_;
+  const int group_pages_;
+
+  mutable shared_mutex lock_;
+  PageNum                     page_count_ = 0;
+  vector<Group>               groups_;
+  set<int>                    free_groups_;  ///< 有空闲页面的组
+};
@@ -0,0 +1,251 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/buffer/page_cleaner.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/sstream.h"
+#include "common/log/log.h"
+#include "common/thread/thread_util.h"
+#include "storage/buffer/disk_buffer_pool.h"
+
+using namespace common;
+
+string PageCleaner::Stats::to_string() const
+{
+  stringstream ss;
+  ss << "pagesFlushed:" << pages_flushed << ", pagesFlushedPerSec:" << pages_flushed_per_sec
+     << ", foregroundStalls:" << foreground_stalls << ", rounds:" << rounds;
+  return ss.str();
+}
+
+PageCleaner::PageCleaner(BufferPoolManager &bp_manager) : bp_manager_(bp_manager) {}
+
+PageCleaner::~PageCleaner() { stop(); }
+
+RC PageCleaner::start(int thread_num, int low_watermark, int high_watermark)
+{
+  if (!threads_.empty()) {
+    LOG_WARN("page cleaner has been started. thread num=%d", thread_num_);
+    return RC::INTERNAL;
+  }
+
+  if (thread_num < 0 || low_watermark < 0 || low_watermark > 100 || high_watermark < low_watermark ||
+      high_watermark > 100) {
+    LOG_WARN("invalid page cleaner arguments. thread num=%d, low watermark=%d, high watermark=%d",
+             thread_num, low_watermark, high_watermark);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  // 每个线程至少负责一个分片
+  thread_num_     = min(thread_num, bp_manager_.get_frame_manager().shard_num());
+  low_watermark_  = low_watermark;
+  high_watermark_ = high_watermark;
+  start_time_     = chrono::steady_clock::now();
+
+  running_ = true;
+  for (int i = 0; i < thread_num_; i++) {
+    threads_.emplace_back(&PageCleaner::thread_func, this, i);
+  }
+
+  LOG_INFO("page cleaner started. thread num=%d, low watermark=%d%%, high watermark=%d%%",
+           thread_num_, low_watermark_, high_watermark_);
+  return RC::SUCCESS;
+}
+
+void PageCleaner::stop()
+{
+  if (threads_.empty()) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> guard(wakeup_lock_);
+    running_ = false;
+  }
+  wakeup_cond_.notify_all();
+
+  for (thread &t : threads_) {
+    t.join();
+  }
+  threads_.clear();
+  thread_num_ = 0;
+  LOG_INFO("page cleaner stopped. stats=%s", stats().to_string().c_str());
+}
+
+void PageCleaner::on_foreground_stall()
+{
+  foreground_stalls_++;
+  if (running_) {
+    {
+      lock_guard<mutex> guard(wakeup_lock_);
+      wakeup_seq_++;
+    }
+    wakeup_cond_.notify_all();
+  }
+}
+
+PageCleaner::Stats PageCleaner::stats() const
+{
+  Stats stats;
+  stats.pages_flushed     = pages_flushed_.load();
+  stats.foreground_stalls = foreground_stalls_.load();
+  stats.rounds            = rounds_.load();
+
+  const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start_time_).count();
+  if (seconds > 0) {
+    stats.pages_flushed_per_sec = stats.pages_flushed / seconds;
+  }
+  return stats;
+}
+
+void PageCleaner::thread_func(int cleaner_index)
+{
+  thread_set_name("PageCleaner");
+  LOG_INFO("page cleaner thread started. index=%d", cleaner_index);
+
+  uint64_t seen_seq = 0;
+  while (running_) {
+    const int flushed_count = clean(cleaner_index);
+    if (flushed_count > 0 && above_high_watermark()) {
+      // 脏页太多，不等待，接着刷新
+      continue;
+    }
+
+    unique_lock<mutex> guard(wakeup_lock_);
+    wakeup_cond_.wait_for(guard, CHECK_INTERVAL, [this, seen_seq] { return !running_ || wakeup_seq_ != seen_seq; });
+    seen_seq = wakeup_seq_;
+  }
+
+  LOG_INFO("page cleaner thread stopped. index=%d", cleaner_index);
+}
+
+bool PageCleaner::above_high_watermark() const
+{
+  BPFrameManager &frame_manager = bp_manager_.get_frame_manager();
+  const size_t    total_num     = frame_manager.total_frame_num();
+  return frame_manager.dirty_frame_num() * 100 > total_num * high_watermark_;
+}
+
+int PageCleaner::clean(int cleaner_index /* = 0 */)
+{
+  if (!begin_round()) {
+    return 0;
+  }
+
+  BPFrameManager &frame_manager = bp_manager_.get_frame_manager();
+  const size_t    total_num     = frame_manager.total_frame_num();
+  const size_t    dirty_num     = frame_manager.dirty_frame_num();
+  const size_t    low_num       = total_num * low_watermark_ / 100;
+  if (dirty_num == 0 || dirty_num <= low_num) {
+    end_round();
+    return 0;
+  }
+
+  // 把脏页降到低水位以下，由各个线程平均分担，每个线程再平均分到自己负责的分片上
+  const int cleaner_num = max(thread_num(), 1);
+  const int shard_num   = frame_manager.shard_num();
+  const int own_shards  = (shard_num - cleaner_index + cleaner_num - 1) / cleaner_num;
+  if (own_shards <= 0) {
+    end_round();
+    return 0;
+  }
+
+  const int target_num = static_cast<int>((dirty_num - low_num + cleaner_num - 1) / cleaner_num);
+
+  // 脏页在分片之间不一定是均匀的，第一遍没有找够时，第二遍不再限制每个分片的个数
+  vector<Frame *> frames;
+  frames.reserve(target_num);
+  for (int pass = 0; pass < 2 && static_cast<int>(frames.size()) < target_num; pass++) {
+    const int remain_num  = target_num - static_cast<int>(frames.size());
+    const int shard_quota = pass == 0 ? (remain_num + own_shards - 1) / own_shards : remain_num;
+    for (int shard = cleaner_index; shard < shard_num && static_cast<int>(frames.size()) < target_num;
+         shard += cleaner_num) {
+      const int quota = min(shard_quota, target_num - static_cast<int>(frames.size()));
+      frame_manager.find_dirty_victims(shard, quota, frames);
+    }
+  }
+
+  const int flushed_count = flush_frames(frames);
+  pages_flushed_ += flushed_count;
+  rounds_++;
+  end_round();
+
+  LOG_DEBUG("page cleaner round done. index=%d, dirty=%ld, total=%ld, found=%ld, flushed=%d",
+            cleaner_index, dirty_num, total_num, frames.size(), flushed_count);
+  return flushed_count;
+}
+
+int PageCleaner::flush_frames(vector<Frame *> &frames)
+{
+  // 同一个文件的页面放在一起，按照页面编号排序，相邻的页面可以合并写入
+  sort(frames.begin(), frames.end(), [](const Frame *a, const Frame *b) {
+    if (a->buffer_pool_id() != b->buffer_pool_id()) {
+      return a->buffer_pool_id() < b->buffer_pool_id();
+    }
+    return a->page_num() < b->page_num();
+  });
+
+  int flushed_count = 0;
+  for (size_t begin = 0; begin < frames.size();) {
+    size_t end = begin + 1;
+    while (end < frames.size() && frames[end]->buffer_pool_id() == frames[begin]->buffer_pool_id()) {
+      end++;
+    }
+
+    vector<Frame *> batch(frames.begin() + begin, frames.begin() + end);
+    DiskBufferPool *buffer_pool = nullptr;
+    RC              rc          = bp_manager_.get_buffer_pool(batch.front()->buffer_pool_id(), buffer_pool);
+    if (OB_SUCC(rc)) {
+      int batch_flushed = 0;
+      rc                = buffer_pool->flush_pinned_pages(batch, batch_flushed);
+      flushed_count += batch_flushed;
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to flush dirty pages. buffer pool id=%d, rc=%s", buffer_pool->id(), strrc(rc));
+      }
+    }
+
+    for (Frame *frame : batch) {
+      frame->unpin();
+    }
+    begin = end;
+  }
+  return flushed_count;
+}
+
+void PageCleaner::pause()
+{
+  unique_lock<mutex> guard(round_lock_);
+  pause_count_++;
+  round_cond_.wait(guard, [this] { return active_rounds_ == 0; });
+}
+
+void PageCleaner::resume()
+{
+  lock_guard<mutex> guard(round_lock_);
+  pause_count_--;
+}
+
+bool PageCleaner::begin_round()
+{
+  lock_guard<mutex> guard(round_lock_);
+  if (pause_count_ > 0) {
+    return false;
+  }
+  active_rounds_++;
+  return true;
+}
+
+void PageCleaner::end_round()
+{
+  lock_guard<mutex> guard(round_lock_);
+  if (--active_rounds_ == 0) {
+    round_cond_.notify_all();
+  }
+}
@@ -0,0 +1,159 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/atomic.h"
+#include "common/lang/chrono.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/mutex.h"
+#include "common/lang/string.h"
+#include "common/lang/thread.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+
+class BufferPoolManager;
+class Frame;
+
+/**
+ * @brief 后台刷脏页的线程
+ * @ingroup BufferPool
+ * @details 没有后台刷脏页时，只有淘汰页面的时候才会把脏页写到磁盘，这时候前台的请求需要等待写磁盘完成，
+ * 参考 DiskBufferPool::allocate_frame。
+ * 这里启动若干个后台线程，定期检查脏页占页帧总数的比例。超过低水位(low watermark)时，按照置换策略的淘汰顺序，
+ * 把没有被 pin 住的脏页写到磁盘，直到脏页比例降到低水位以下。这样前台淘汰页面时基本上都能找到干净的页面。
+ * 脏页比例超过高水位(high watermark)时，说明写入的速度比刷新的速度快，后台线程就不再等待，连续刷新。
+ * 每个线程负责页帧表中的一部分分片，线程之间不会刷新同一个页面。
+ * 前台淘汰页面时如果还需要写脏页，就记录一次前台等待(foreground stall)，同时唤醒后台线程。
+ */
+class PageCleaner
+{
+public:
+  /// 默认的后台线程个数
+  static constexpr int DEFAULT_THREAD_NUM = 1;
+  /// 默认的低水位，脏页占页帧总数的百分比
+  static constexpr int DEFAULT_LOW_WATERMARK = 10;
+  /// 默认的高水位，脏页占页帧总数的百分比
+  static constexpr int DEFAULT_HIGH_WATERMARK = 50;
+  /// 没有被唤醒时，多久检查一次脏页比例
+  static constexpr chrono::milliseconds CHECK_INTERVAL{100};
+
+  /**
+   * @brief 刷脏页的统计信息
+   */
+  struct Stats
+  {
+    uint64_t pages_flushed         = 0;  ///< 后台线程刷新了多少个页面
+    uint64_t foreground_stalls     = 0;  ///< 前台淘汰页面时需要写脏页的次数
+    uint64_t rounds                = 0;  ///< 后台线程刷新了多少轮
+    double   pages_flushed_per_sec = 0;  ///< 启动以后平均每秒刷新多少个页面
+
+    string to_string() const;
+  };
+
+  /**
+   * @brief 暂停刷脏页
+   * @details 关闭文件前需要暂停，防止后台线程 pin 住正在关闭的文件的页面，或者访问已经删除的 DiskBufferPool
+   */
+  class PauseGuard
+  {
+  public:
+    explicit PauseGuard(PageCleaner &cleaner) : cleaner_(cleaner) { cleaner_.pause(); }
+    ~PauseGuard() { cleaner_.resume(); }
+
+  private:
+    PageCleaner &cleaner_;
+  };
+
+public:
+  explicit PageCleaner(BufferPoolManager &bp_manager);
+  ~PageCleaner();
+
+  /**
+   * @brief 设置水位并启动后台线程
+   * @param thread_num 线程个数，0表示不启动后台线程，可以调用 clean 手动刷新
+   * @param low_watermark 低水位，脏页占页帧总数的百分比
+   * @param high_watermark 高水位，不能小于低水位
+   */
+  RC start(int thread_num, int low_watermark, int high_watermark);
+
+  /**
+   * @brief 停止并等待所有的后台线程结束
+   */
+  void stop();
+
+  /**
+   * @brief 前台淘汰页面时需要写脏页
+   */
+  void on_foreground_stall();
+
+  /**
+   * @brief 执行一轮刷新
+   * @details 脏页比例超过低水位时，在 cleaner_index 负责的分片中刷新脏页
+   * @param cleaner_index 第几个后台线程
+   * @return 刷新了多少个页面
+   */
+  int clean(int cleaner_index = 0);
+
+  Stats stats() const;
+
+  int thread_num() const { return thread_num_; }
+  int low_watermark() const { return low_watermark_; }
+  int high_watermark() const { return high_watermark_; }
+
+private:
+  void thread_func(int cleaner_index);
+
+  /**
+   * @brief 等待正在执行的刷新结束，暂停期间不会开始新的刷新
+   * @details 暂停优先，不会因为后台线程一直在刷新而等待太久
+   */
+  void pause();
+  void resume();
+
+  /**
+   * @brief 开始一轮刷新，暂停时返回false
+   */
+  bool begin_round();
+  void end_round();
+
+  /**
+   * @brief 把这些页面按照所属的文件分组刷新，刷新后 unpin
+   */
+  int flush_frames(vector<Frame *> &frames);
+
+  /**
+   * @brief 脏页比例是否超过了高水位
+   */
+  bool above_high_watermark() const;
+
+private:
+  BufferPoolManager &bp_manager_;
+
+  int thread_num_     = 0;
+  int low_watermark_  = DEFAULT_LOW_WATERMARK;
+  int high_watermark_ = DEFAULT_HIGH_WATERMARK;
+
+  vector<thread>     threads_;
+  atomic_bool        running_{false};
+  mutex              wakeup_lock_;
+  condition_variable wakeup_cond_;
+  uint64_t           wakeup_seq_ = 0;  ///< 每次唤醒加1，后台线程据此判断是否被唤醒过
+
+  mutex              round_lock_;
+  condition_variable round_cond_;
+  int                active_rounds_ = 0;  ///< 正在执行的刷新个数
+  int                pause_count_   = 0;  ///< 有多少个 PauseGuard
+
+  atomic<uint64_t>                 pages_flushed_{0};
+  atomic<uint64_t>                 foreground_stalls_{0};
+  atomic<uint64_t>                 rounds_{0};
+  chrono::steady_clock::time_point start_time_ = chrono::steady_clock::now();
+};
@@ -0,0 +1,414 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/buffer/uring_io_engine.h"
+
+#ifdef MINIOB_HAS_IO_URING
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common/io/io.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/chrono.h"
+#include "common/log/log.h"
+
+static int io_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+UringIoEngine::~UringIoEngine()
+{
+  if (reap_thread_.joinable()) {
+    unique_lock<mutex> guard(lock_);
+    // 不可用以后由后台线程等待内核返回还在执行的请求，之后它会自己退出
+    cond_.wait(guard, [this] { return inflight_.empty() || broken_; });
+
+    // 提交一个 user_data 为0的空请求，后台线程收到以后就退出。不可用以后后台线程已经退出了
+    RC rc = RC::SUCCESS;
+    if (!broken_) {
+      io_uring_sqe *sqe = get_sqe();
+      sqe->opcode       = IORING_OP_NOP;
+      sqe->user_data    = 0;
+      rc                = flush_sqes();
+    }
+    guard.unlock();
+
+    if (OB_SUCC(rc)) {
+      reap_thread_.join();
+    } else {
+      LOG_ERROR("failed to stop io_uring reap thread. rc=%s", strrc(rc));
+      reap_thread_.detach();
+      return;  // 后台线程还在使用这些内存，不能释放
+    }
+
+    if (!inflight_.empty()) {
+      LOG_ERROR("io_uring requests are still running in kernel, keep the ring. count=%d",
+                static_cast<int>(inflight_.size()));
+      return;
+    }
+  }
+  destroy();
+}
+
+RC UringIoEngine::init(int queue_depth)
+{
+  if (queue_depth <= 0) {
+    LOG_WARN("invalid io_uring queue depth: %d", queue_depth);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = io_uring_setup(static_cast<unsigned>(queue_depth), &params);
+  if (fd < 0) {
+    LOG_WARN("failed to setup io_uring. queue depth=%d, errno=%d:%s", queue_depth, errno, strerror(errno));
+    return RC::UNIMPLEMENTED;
+  }
+  ring_fd_ = fd;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (MAP_FAILED == sq_ring_) {
+    LOG_WARN("failed to mmap io_uring sq ring. errno=%d:%s", errno, strerror(errno));
+    sq_ring_ = nullptr;
+    destroy();
+    return RC::NOMEM;
+  }
+
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (MAP_FAILED == cq_ring_) {
+      LOG_WARN("failed to mmap io_uring cq ring. errno=%d:%s", errno, strerror(errno));
+      cq_ring_ = nullptr;
+      destroy();
+      return RC::NOMEM;
+    }
+  }
+
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void *sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (MAP_FAILED == sqes) {
+    LOG_WARN("failed to mmap io_uring sqes. errno=%d:%s", errno, strerror(errno));
+    destroy();
+    return RC::NOMEM;
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  char *sq_ring = static_cast<char *>(sq_ring_);
+  sq_tail_      = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.tail);
+  sq_mask_      = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.ring_mask);
+  sq_array_     = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.array);
+
+  char *cq_ring = static_cast<char *>(cq_ring_);
+  cq_head_      = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.head);
+  cq_tail_      = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.tail);
+  cq_mask_      = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.ring_mask);
+  cqes_         = reinterpret_cast<io_uring_cqe *>(cq_ring + params.cq_off.cqes);
+
+  // 同时执行的请求不超过提交队列的大小，完成队列默认是提交队列的两倍，也不会溢出
+  queue_depth_ = min(queue_depth, static_cast<int>(params.sq_entries));
+  reap_thread_ = thread(&UringIoEngine::reap_thread_func, this);
+  LOG_INFO("io_uring engine initialized. queue depth=%d, sq entries=%u, cq entries=%u",
+           queue_depth_, params.sq_entries, params.cq_entries);
+  return RC::SUCCESS;
+}
+
+void UringIoEngine::destroy()
+{
+  if (sqes_ != nullptr) {
+    ::munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    ::munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    ::munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  if (ring_fd_ >= 0) {
+    ::close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+io_uring_sqe *UringIoEngine::get_sqe()
+{
+  // 只有持有 lock_ 的线程会修改 tail，内核在 io_uring_enter 中就会把提交的请求取走，不需要检查 head
+  const unsigned tail  = *sq_tail_;
+  const unsigned index = tail & *sq_mask_;
+  io_uring_sqe  *sqe   = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  to_submit_++;
+  return sqe;
+}
+
+RC UringIoEngine::flush_sqes()
+{
+  while (to_submit_ > 0) {
+    int ret = io_uring_enter(ring_fd_, to_submit_, 0, 0);
+    if (ret >= 0) {
+      to_submit_ -= static_cast<unsigned>(ret);
+      continue;
+    }
+
+    const int err = errno;
+    if (EINTR == err || EAGAIN == err || EBUSY == err) {
+      continue;
+    }
+
+    // 把没有被内核取走的请求撤回，直接按照失败处理
+    LOG_WARN("failed to submit io_uring requests. count=%u, errno=%d:%s", to_submit_, err, strerror(err));
+    unsigned tail = *sq_tail_;
+    for (; to_submit_ > 0; to_submit_--) {
+      tail--;
+      io_uring_sqe *sqe = &sqes_[tail & *sq_mask_];
+      if (sqe->user_data != 0 && sqe->user_data != CANCEL_USER_DATA) {
+        IoRequest *request = reinterpret_cast<IoRequest *>(sqe->user_data);
+        inflight_.erase(request);
+        finish(request, err);
+      }
+    }
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    return RC::IOERR_ACCESS;
+  }
+  return RC::SUCCESS;
+}
+
+RC UringIoEngine::submit(const vector<IoRequest *> &requests)
+{
+  RC rc = RC::SUCCESS;
+
+  unique_lock<mutex> guard(lock_);
+  for (IoRequest *request : requests) {
+    const bool too_many_iov = request->iov.size() > IOV_MAX;
+    while (OB_SUCC(rc) && !broken_ && !too_many_iov && static_cast<int>(inflight_.size()) >= queue_depth_) {
+      rc = flush_sqes();
+      if (OB_SUCC(rc)) {
+        cond_.wait(guard);
+      }
+    }
+
+    if (OB_FAIL(rc) || broken_ || too_many_iov) {
+      // 前面提交失败了，io_uring 不可用了，或者内核不接受这么多段内存，在当前线程中同步执行
+      guard.unlock();
+      finish(request, sync_io(*request, 0));
+      guard.lock();
+      continue;
+    }
+
+    io_uring_sqe *sqe = get_sqe();
+    sqe->opcode       = request->type == IoRequest::Type::WRITE ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd           = request->fd;
+    sqe->addr         = reinterpret_cast<uint64_t>(request->iov.data());
+    sqe->len          = static_cast<uint32_t>(request->iov.size());
+    sqe->off          = static_cast<uint64_t>(request->offset);
+    sqe->user_data    = reinterpret_cast<uint64_t>(request);
+    inflight_.insert(request);
+  }
+
+  if (OB_SUCC(rc) && !broken_) {
+    rc = flush_sqes();
+  }
+  return rc;
+}
+
+int UringIoEngine::wait_completions() { return io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS); }
+
+void UringIoEngine::reap_thread_func()
+{
+  LOG_INFO("io_uring reap thread started");
+  vector<pair<IoRequest *, int>> completions;
+
+  int  failures = 0;
+  bool stop     = false;
+  while (!stop) {
+    int ret = wait_completions();
+    if (ret < 0 && errno != EINTR) {
+      const int err = errno;
+      LOG_WARN("failed to wait io_uring events. errno=%d:%s, failures=%d", err, strerror(err), failures + 1);
+      if (++failures >= MAX_REAP_FAILURES) {
+        LOG_ERROR("io_uring is not available any more, fall back to sync io. errno=%d:%s", err, strerror(err));
+        fallback_to_sync();
+        break;
+      }
+    } else {
+      failures = 0;
+    }
+
+    completions.clear();
+    if (reap_completions(completions)) {
+      stop = true;
+    }
+    for (const auto &[request, res] : completions) {
+      complete(request, res);
+    }
+  }
+  LOG_INFO("io_uring reap thread stopped");
+}
+
+bool UringIoEngine::reap_completions(vector<pair<IoRequest *, int>> &completions)
+{
+  bool           stop = false;
+  unsigned       head = *cq_head_;
+  const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  for (; head != tail; head++) {
+    const io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+    if (0 == cqe->user_data) {
+      stop = true;
+      continue;
+    }
+    if (CANCEL_USER_DATA == cqe->user_data) {
+      continue;  // 取消请求本身的结果不重要，被取消的请求还会有自己的完成事件
+    }
+    completions.emplace_back(reinterpret_cast<IoRequest *>(cqe->user_data), cqe->res);
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+  if (completions.empty()) {
+    return stop;
+  }
+
+  // 先从 inflight_ 中移除，请求完成以后它的内存就可能被释放了
+  lock_guard<mutex> guard(lock_);
+  for (const auto &[request, res] : completions) {
+    inflight_.erase(request);
+  }
+  cond_.notify_all();
+  return stop;
+}
+
+void UringIoEngine::fallback_to_sync()
+{
+  // 内核已经接收的请求在返回完成事件之前还可能读写请求的内存，不能直接在这里完成。
+  // 先全部取消，再等内核返回每个请求，被取消的请求才能同步地重新执行
+  int inflight_num = 0;
+  {
+    lock_guard<mutex> guard(lock_);
+    broken_ = true;
+    for (IoRequest *request : inflight_) {
+      io_uring_sqe *sqe = get_sqe();
+      sqe->opcode       = IORING_OP_ASYNC_CANCEL;
+      sqe->addr         = reinterpret_cast<uint64_t>(request);
+      sqe->user_data    = CANCEL_USER_DATA;
+    }
+    inflight_num = static_cast<int>(inflight_.size());
+    RC rc        = flush_sqes();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to cancel io_uring requests, wait for them to complete. count=%d, rc=%s",
+               inflight_num, strrc(rc));
+    }
+    cond_.notify_all();  // 等待队列空间的提交线程改为同步执行
+  }
+
+  // 等待完成事件已经失败了，直接轮询完成队列。内核可能需要当前线程进入内核态才能发布完成事件，sleep 也可以
+  vector<pair<IoRequest *, int>> completions;
+  const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(DRAIN_TIMEOUT_MS);
+  while (inflight_num > 0) {
+    completions.clear();
+    reap_completions(completions);
+    for (const auto &[request, res] : completions) {
+      if (-ECANCELED == res || -EINTR == res) {
+        // 内核不会再访问被取消的请求的内存了
+        finish(request, sync_io(*request, 0));
+      } else {
+        complete(request, res);
+      }
+    }
+
+    {
+      lock_guard<mutex> guard(lock_);
+      inflight_num = static_cast<int>(inflight_.size());
+    }
+    if (inflight_num == 0 || chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    this_thread::sleep_for(chrono::milliseconds(1));
+  }
+
+  if (inflight_num > 0) {
+    // 这些请求的内存可能还会被内核读写，不能完成它们，调用方会一直等待，也就不会释放或者复用这些内存
+    LOG_ERROR("io_uring requests are still running in kernel after %dms, leave them unfinished. count=%d",
+              DRAIN_TIMEOUT_MS, inflight_num);
+  } else {
+    LOG_WARN("io_uring in-flight requests are drained, later requests are done synchronously");
+  }
+}
+
+void UringIoEngine::complete(IoRequest *request, int res)
+{
+  if (res < 0) {
+    finish(request, -res);
+    return;
+  }
+
+  const size_t size = request->size();
+  if (static_cast<size_t>(res) >= size) {
+    finish(request, 0);
+    return;
+  }
+
+  if (0 == res && request->type == IoRequest::Type::READ && size > 0) {
+    finish(request, -1);  // end of file
+    return;
+  }
+
+  // 只完成了一部分，剩下的同步读写
+  finish(request, sync_io(*request, static_cast<size_t>(res)));
+}
+
+int UringIoEngine::sync_io(const IoRequest &request, size_t done)
+{
+  vector<struct iovec> iov    = request.iov;
+  const off_t          offset = request.offset + static_cast<off_t>(done);
+
+  size_t skip = 0;
+  while (skip < iov.size() && done >= iov[skip].iov_len) {
+    done -= iov[skip].iov_len;
+    skip++;
+  }
+  if (skip >= iov.size()) {
+    return 0;
+  }
+  iov[skip].iov_base = static_cast<char *>(iov[skip].iov_base) + done;
+  iov[skip].iov_len -= done;
+
+  const int iovcnt = static_cast<int>(iov.size() - skip);
+  if (request.type == IoRequest::Type::WRITE) {
+    return common::pwritevn(request.fd, iov.data() + skip, iovcnt, offset);
+  }
+  return common::preadvn(request.fd, iov.data() + skip, iovcnt, offset);
+}
+
+#endif  // MINIOB_HAS_IO_URING
@@ -0,0 +1,117 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define MINIOB_HAS_IO_URING 1
+#endif
+
+#ifdef MINIOB_HAS_IO_URING
+
+#include <stdint.h>
+
+#include "common/lang/condition_variable.h"
+#include "common/lang/mutex.h"
+#include "common/lang/thread.h"
+#include "common/lang/unordered_set.h"
+#include "common/lang/utility.h"
+#include "storage/buffer/io_engine.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * @brief 基于 io_uring 的异步读写引擎
+ * @ingroup BufferPool
+ * @details 没有依赖 liburing，直接使用 io_uring_setup/io_uring_enter 系统调用，自己维护提交队列和完成队列。
+ * 提交请求的线程把请求放到提交队列中就返回，由一个后台线程收割完成队列，通知请求所属的 IoBatch。
+ * 同时在执行的请求不会超过 queue_depth 个，超过时提交线程会等待。
+ * 如果内核返回的读写长度不足，剩下的部分由后台线程使用同步接口完成。
+ * 如果后台线程连续多次等待完成事件失败，认为 io_uring 已经不可用，之后提交的请求都在提交线程中同步执行。
+ * 还在执行的请求先取消，再轮询完成队列直到内核返回每个请求，被取消的请求使用同步接口重新执行。
+ * 内核一直不返回的请求不会完成，调用方会一直等待，请求的内存也就不会被释放或者复用。
+ */
+class UringIoEngine : public IoEngine
+{
+public:
+  UringIoEngine() = default;
+  ~UringIoEngine() override;
+
+  /**
+   * @brief 创建 io_uring 并启动后台线程
+   * @details 内核不支持 io_uring 或者被禁用时返回失败，调用方可以换成同步的引擎。
+   */
+  RC init(int queue_depth);
+
+  const char *name() const override { return "uring"; }
+  int         queue_depth() const override { return queue_depth_; }
+
+  RC submit(const vector<IoRequest *> &requests) override;
+
+protected:
+  /**
+   * @brief 等待至少一个请求完成，返回值和 errno 与 io_uring_enter 相同
+   */
+  virtual int wait_completions();
+
+private:
+  io_uring_sqe *get_sqe();
+  RC            flush_sqes();
+  void          reap_thread_func();
+  void          fallback_to_sync();
+
+  /**
+   * @brief 取出完成队列中所有的完成事件，并把完成的请求从 inflight_ 中移除
+   * @return 是否收到了通知后台线程退出的空请求
+   */
+  bool          reap_completions(vector<pair<IoRequest *, int>> &completions);
+  void          complete(IoRequest *request, int res);
+  static int    sync_io(const IoRequest &request, size_t done);
+  void          destroy();
+
+private:
+  int ring_fd_     = -1;
+  int queue_depth_ = 0;
+
+  // 提交队列
+  void         *sq_ring_      = nullptr;
+  size_t        sq_ring_size_ = 0;
+  unsigned     *sq_tail_      = nullptr;
+  unsigned     *sq_mask_      = nullptr;
+  unsigned     *sq_array_     = nullptr;
+  io_uring_sqe *sqes_         = nullptr;
+  size_t        sqes_size_    = 0;
+
+  // 完成队列。内核支持 IORING_FEAT_SINGLE_MMAP 时与提交队列共用一块内存
+  void         *cq_ring_      = nullptr;
+  size_t        cq_ring_size_ = 0;
+  unsigned     *cq_head_      = nullptr;
+  unsigned     *cq_tail_      = nullptr;
+  unsigned     *cq_mask_      = nullptr;
+  io_uring_cqe *cqes_         = nullptr;
+
+  /// 后台线程连续等待完成事件失败这么多次以后，不再使用 io_uring
+  static constexpr int MAX_REAP_FAILURES = 3;
+  /// 不再使用 io_uring 以后，最多等待多久让内核返回还在执行的请求，单位毫秒
+  static constexpr int DRAIN_TIMEOUT_MS = 10 * 1000;
+  /// 取消请求的 user_data。与通知后台线程退出的0一样，不对应任何请求
+  static constexpr uint64_t CANCEL_USER_DATA = UINT64_MAX;
+
+  mutex                      lock_;               ///< 保护提交队列、inflight_ 和 broken_
+  condition_variable         cond_;               ///< 有请求完成时通知等待的提交线程
+  unordered_set<IoRequest *> inflight_;           ///< 已经提交还没有完成的请求
+  unsigned                   to_submit_ = 0;      ///< 已经放到提交队列但还没有通知内核的请求个数
+  bool                       broken_    = false;  ///< io_uring 不可用了，所有请求都同步执行
+
+  thread reap_thread_;
+};
+
+#endif  // MINIOB_HAS_IO_URING
@@ -50,6 +50,8 @@ RC DiskLogHandler::stop()
   }
 
   running_.store(false);
+  // 唤醒刷新线程和等待日志刷盘的线程，让它们尽快看到停止标识
+  entry_buffer_.wakeup();
 
   LOG_INFO("log handler stopped");
   return RC::SUCCESS;
@@ -133,12 +135,12 @@ RC DiskLogHandler::iterate(function<RC(LogEntry&)> consumer, LSN start_lsn)
   return RC::SUCCESS;
 }
 
-RC DiskLogHandler::_append(LSN &lsn, LogModule module, vector<char> &&data)
+RC DiskLogHandler::_append(LSN &lsn, LogModule module, span<const char> data)
 {
   ASSERT(running_.load(), "log handler is not running. lsn=%ld, module=%s, size=%d", 
         lsn, module.name(), data.size());
 
-  RC rc = entry_buffer_.append(lsn, module, std::move(data));
+  RC rc = entry_buffer_.append(lsn, module, data);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to append log entry to buffer. rc=%s", strrc(rc));
     return rc;
@@ -149,9 +151,9 @@ RC DiskLogHandler::_append(LSN &lsn, LogModule module, vector<char> &&data)
 
 RC DiskLogHandler::wait_lsn(LSN lsn)
 {
-  // 直接强制等待。在生产系统中，我们可能会使用条件变量来等待。
+  // 刷新线程每刷完一组日志都会通过条件变量唤醒等待的线程。超时只是为了检查是否已经停止
   while (running_.load() && current_flushed_lsn() < lsn) {
-    this_thread::sleep_for(chrono::milliseconds(100));
+    entry_buffer_.wait_flushed(lsn, chrono::milliseconds(100));
   }
 
   if (current_flushed_lsn() >= lsn) {
@@ -165,8 +167,9 @@ void DiskLogHandler::thread_func()
 {
   /*
   这个线程一直不停的循环，检查日志缓冲区中是否有日志在内存中，如果在内存中就刷新到磁盘。
-  这种做法很粗暴简单，与生产数据库的做法不同。生产数据库通常会在内存达到一定量，或者一定时间
-  之后，会刷新一下磁盘。这样做的好处是减少磁盘的IO次数，提高性能。
+  刷新时使用组提交：缓冲区中已有的日志合并成一次写入，再刷一次盘。在写文件和刷盘期间，
+  其它线程追加的日志会在下一轮一起刷新，并发提交的事务越多，每次刷盘覆盖的日志就越多。
+  缓冲区为空时等待追加日志的通知，而不是固定地睡眠一段时间。
   */
   thread_set_name("LogHandler");
   LOG_INFO("log handler thread started");
@@ -199,7 +202,7 @@ void DiskLogHandler::thread_func()
     }
 
     if (flush_count == 0 && rc == RC::SUCCESS) {
-      this_thread::sleep_for(chrono::milliseconds(100));
+      entry_buffer_.wait_for_entries(chrono::milliseconds(100));
       continue;
     }
   }
@@ -12,95 +12,244 @@ See the Mulan PSL v2 for more details. */
 // Created by wangyunlai on 2024/01/31
 //
 
+#include <string.h>
+#include <sys/uio.h>
+
 #include "storage/clog/log_buffer.h"
 #include "storage/clog/log_file.h"
+#include "common/lang/algorithm.h"
 #include "common/lang/chrono.h"
+#include "common/lang/thread.h"
+#include "common/log/log.h"
 
 using namespace common;
 
+LogEntryBuffer::LogEntryBuffer() { (void)init(0); }
+
 RC LogEntryBuffer::init(LSN lsn, int32_t max_bytes /*= 0*/)
 {
   current_lsn_.store(lsn);
+  reserved_lsn_.store(lsn);
+  committed_lsn_.store(lsn);
+  written_lsn_.store(lsn);
   flushed_lsn_.store(lsn);
 
   if (max_bytes > 0) {
     max_bytes_ = max_bytes;
   }
+
+  // 至少要能放下一条最大的日志。使用2的幂，方便计算在环形缓冲区中的位置
+  int64_t capacity = 1;
+  while (capacity < max(max_bytes_, LogEntry::max_size())) {
+    capacity <<= 1;
+  }
+  if (capacity != capacity_) {
+    capacity_ = capacity;
+    ring_.reset(new char[capacity_]);
+  }
+
+  reserved_offset_ = 0;
+  committed_offset_.store(0);
+  written_offset_.store(0);
   return RC::SUCCESS;
 }
 
-RC LogEntryBuffer::append(LSN &lsn, LogModule::Id module_id, vector<char> &&data)
+RC LogEntryBuffer::append(LSN &lsn, LogModule::Id module_id, span<const char> data)
 {
-  return append(lsn, LogModule(module_id), std::move(data));
+  return append(lsn, LogModule(module_id), data);
 }
 
-RC LogEntryBuffer::append(LSN &lsn, LogModule module, vector<char> &&data)
+RC LogEntryBuffer::append(LSN &lsn, LogModule module, span<const char> data)
 {
-  /// 控制当前buffer使用的内存
-  /// 简单粗暴，强制原地等待
-  /// 但是如果当前想要新插入的日志比较大，不会做控制。所以理论上容纳的最大buffer内存是2*max_bytes_
-  while (bytes_.load() >= max_bytes_) {
-    this_thread::sleep_for(chrono::milliseconds(10));
+  if (static_cast<int64_t>(data.size()) > LogEntry::max_payload_size()) {
+    LOG_DEBUG("log entry size is too large. size=%ld, max_payload_size=%d", data.size(), LogEntry::max_payload_size());
+    return RC::INVALID_ARGUMENT;
   }
 
-  LogEntry entry;
-  RC rc = entry.init(lsn, module, std::move(data));
-  if (OB_FAIL(rc)) {
-    LOG_WARN("failed to init log entry. rc=%s", strrc(rc));
-    return rc;
-  }
+  LogHeader header;
+  header.size      = static_cast<int32_t>(data.size());
+  header.module_id = module.index();
 
-  lock_guard guard(mutex_);
-  lsn = ++current_lsn_;
-  entry.set_lsn(lsn);
+  const int64_t total_size = LogHeader::SIZE + header.size;
 
-  entries_.push_back(std::move(entry));
-  bytes_ += entry.total_size();
+  lsn        = current_lsn_.fetch_add(1) + 1;
+  header.lsn = lsn;
+
+  // 按照LSN的顺序预留空间，这样缓冲区中的日志也是按照LSN排列的
+  wait_turn(reserved_lsn_, lsn);
+  const int64_t offset = reserved_offset_;
+  wait_for_space(offset + total_size);
+  reserved_offset_ = offset + total_size;
+  reserved_lsn_.store(lsn);
+
+  // 复制数据时不需要等待其它线程
+  copy_in(offset, &header, LogHeader::SIZE);
+  copy_in(offset + LogHeader::SIZE, data.data(), header.size);
+
+  // 按照LSN的顺序发布，刷新线程只会看到完整的日志
+  wait_turn(committed_lsn_, lsn);
+  committed_offset_.store(offset + total_size);
+  committed_lsn_.store(lsn);
+
+  if (flusher_waiting_.load()) {
+    {
+      // 加锁保证刷新线程已经进入等待状态，不会错过通知
+      lock_guard guard(mutex_);
+    }
+    entries_cond_.notify_one();
+  }
   return RC::SUCCESS;
 }
 
+void LogEntryBuffer::wait_turn(const atomic<LSN> &last_lsn, LSN lsn)
+{
+  while (last_lsn.load() != lsn - 1) {
+    this_thread::yield();
+  }
+}
+
+void LogEntryBuffer::wait_for_space(int64_t end_offset)
+{
+  /// 控制当前buffer使用的内存。超过限制时等待刷新线程刷完一组日志
+  auto has_space = [this, end_offset] { return end_offset - written_offset_.load() <= capacity_; };
+  if (has_space()) {
+    return;
+  }
+
+  unique_lock guard(mutex_);
+  while (!flushed_cond_.wait_for(guard, chrono::milliseconds(100), has_space)) {
+    LOG_DEBUG("log entry buffer is full. waiting for flush. capacity=%ld", capacity_);
+  }
+}
+
+void LogEntryBuffer::copy_in(int64_t offset, const void *data, int64_t size)
+{
+  const int64_t pos   = offset & (capacity_ - 1);
+  const int64_t first = min(size, capacity_ - pos);
+  memcpy(ring_.get() + pos, data, first);
+  memcpy(ring_.get(), static_cast<const char *>(data) + first, size - first);
+}
+
+void LogEntryBuffer::copy_out(int64_t offset, void *data, int64_t size) const
+{
+  const int64_t pos   = offset & (capacity_ - 1);
+  const int64_t first = min(size, capacity_ - pos);
+  memcpy(data, ring_.get() + pos, first);
+  memcpy(static_cast<char *>(data) + first, ring_.get(), size - first);
+}
+
 RC LogEntryBuffer::flush(LogFileWriter &writer, int &count)
 {
   count = 0;
 
-  while (entry_number() > 0) {
-    LogEntry entry;
-    {
-      lock_guard guard(mutex_);
-      if (entries_.empty()) {
-        break;
-      }
-
-      LogEntry &front_entry = entries_.front();
-      ASSERT(front_entry.lsn() > 0 && front_entry.payload_size() > 0, "invalid log entry");
-      entry = std::move(entries_.front());
-      ASSERT(entry.payload_size() > 0 && entry.lsn() > 0, "invalid log entry");
-      entries_.pop_front();
-      bytes_ -= entry.total_size();
+  // 已经发布的日志作为一组。写文件和刷盘时不持有锁，其它线程可以继续追加日志
+  const int64_t begin_offset     = written_offset_.load();
+  const int64_t committed_offset = committed_offset_.load();
+  if (begin_offset == committed_offset) {
+    return RC::SUCCESS;
+  }
+
+  // 只写入LSN不超过当前文件上限的那部分日志，剩下的写到下一个文件中
+  int64_t end_offset = begin_offset;
+  LSN     first_lsn  = 0;
+  LSN     last_lsn   = 0;
+  int     entry_num  = 0;
+  while (end_offset < committed_offset) {
+    LogHeader header;
+    copy_out(end_offset, &header, LogHeader::SIZE);
+    ASSERT(header.lsn > 0 && header.size > 0, "invalid log entry. header=%s", header.to_string().c_str());
+    if (header.lsn > writer.end_lsn()) {
+      break;
     }
-    
-    RC rc = writer.write(entry);
-    if (OB_FAIL(rc)) {
-      lock_guard guard(mutex_);
-      entries_.emplace_front(std::move(entry));
-      LogEntry &front_entry = entries_.front();
-      ASSERT(front_entry.lsn() > 0 && front_entry.payload_size() > 0, "invalid log entry");
-      return rc;
-    } else {
-      ++count;
-      flushed_lsn_ = entry.lsn();
+
+    if (first_lsn == 0) {
+      first_lsn = header.lsn;
     }
+    last_lsn = header.lsn;
+    end_offset += LogHeader::SIZE + header.size;
+    entry_num++;
   }
-  
-  return RC::SUCCESS;
+
+  if (entry_num == 0) {
+    return RC::LOG_FILE_FULL;
+  }
+
+  // 这段日志在环形缓冲区中回绕时分成两段
+  struct iovec  iov[2];
+  int           iovcnt = 1;
+  const int64_t pos    = begin_offset & (capacity_ - 1);
+  const int64_t size   = end_offset - begin_offset;
+  iov[0].iov_base      = ring_.get() + pos;
+  iov[0].iov_len       = min(size, capacity_ - pos);
+  if (static_cast<int64_t>(iov[0].iov_len) < size) {
+    iov[1].iov_base = ring_.get();
+    iov[1].iov_len  = size - iov[0].iov_len;
+    iovcnt          = 2;
+  }
+
+  RC rc = writer.write(iov, iovcnt, first_lsn, last_lsn);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to write log entries. first lsn=%ld, last lsn=%ld, rc=%s", first_lsn, last_lsn, strrc(rc));
+    return rc;
+  }
+
+  bool synced = true;
+  rc          = writer.sync();
+  if (OB_FAIL(rc)) {
+    // 已经写入文件的日志不能再写一次，等下一组日志刷盘成功后一起算作刷新完成
+    LOG_WARN("failed to sync log entries. rc=%s", strrc(rc));
+    synced = false;
+  } else if (end_offset < committed_offset) {
+    rc = RC::LOG_FILE_FULL;
+  }
+
+  {
+    lock_guard guard(mutex_);
+    written_offset_.store(end_offset);
+    written_lsn_.store(last_lsn);
+    if (synced) {
+      flushed_lsn_.store(last_lsn);
+    }
+  }
+  flushed_cond_.notify_all();
+
+  count = entry_num;
+  return rc;
+}
+
+bool LogEntryBuffer::wait_for_entries(chrono::milliseconds timeout)
+{
+  auto has_entries = [this] { return committed_offset_.load() != written_offset_.load(); };
+
+  unique_lock guard(mutex_);
+  flusher_waiting_.store(true);
+  bool ret = entries_cond_.wait_for(guard, timeout, has_entries);
+  flusher_waiting_.store(false);
+  return ret;
+}
+
+bool LogEntryBuffer::wait_flushed(LSN lsn, chrono::milliseconds timeout)
+{
+  unique_lock guard(mutex_);
+  return flushed_cond_.wait_for(guard, timeout, [this, lsn] { return flushed_lsn_.load() >= lsn; });
+}
+
+void LogEntryBuffer::wakeup()
+{
+  {
+    // 加锁保证已经检查过条件的线程都进入了等待状态，不会错过通知
+    lock_guard guard(mutex_);
+  }
+  entries_cond_.notify_all();
+  flushed_cond_.notify_all();
 }
 
 int64_t LogEntryBuffer::bytes() const
 {
-  return bytes_.load();
+  return committed_offset_.load() - written_offset_.load();
 }
 
 int32_t LogEntryBuffer::entry_number() const
 {
-  return entries_.size();
+  return static_cast<int32_t>(committed_lsn_.load() - written_lsn_.load());
 }
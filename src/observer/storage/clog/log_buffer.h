@@ -17,8 +17,10 @@ See the Mulan PSL v2 for more details. */
 #include "common/sys/rc.h"
 #include "common/types.h"
 #include "common/lang/mutex.h"
-#include "common/lang/vector.h"
-#include "common/lang/deque.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/chrono.h"
+#include "common/lang/memory.h"
+#include "common/lang/span.h"
 #include "common/lang/atomic.h"
 #include "storage/clog/log_module.h"
 #include "storage/clog/log_entry.h"
@@ -29,31 +31,62 @@ class LogFileWriter;
  * @brief 日志数据缓冲区
  * @ingroup CLog
  * @details 缓存一部分日志在内存中而不是直接写入磁盘。
- * 这里的缓存没有考虑高性能操作，比如使用预分配内存、环形缓冲池等。
- * 在生产数据库中，通常会使用预分配内存形式的缓存来提高性能，并且可以减少内存碎片。
+ * 缓冲区是一块预先分配的环形内存，日志头和日志数据按照写入文件时的格式依次存放在里面。
+ * 追加日志时不加锁：先使用原子操作分配LSN，再按照LSN的顺序预留空间，然后各个线程并发地
+ * 把日志直接复制到预留好的位置，最后再按照LSN的顺序发布出去。按顺序预留和发布都只是推进
+ * 一个偏移量，等待的时间很短。
+ * 刷新时使用组提交(group commit)：把已经发布的日志作为一组，直接把环形缓冲区中连续的一段
+ * (回绕时是两段)一次写入文件，再刷一次盘，然后通过条件变量唤醒所有等待这些日志落盘的线程。
+ * 刷盘期间新追加的日志会在下一组中一起刷新。
+ * 只能有一个线程调用 flush。
  */
 class LogEntryBuffer
 {
 public:
-  LogEntryBuffer()  = default;
+  LogEntryBuffer();
   ~LogEntryBuffer() = default;
 
+  /**
+   * @brief 初始化缓冲区
+   * @details 构造时会使用默认参数初始化，从LSN 0开始。恢复日志后需要再使用最大的LSN初始化
+   * @param lsn 当前最大的LSN，追加的日志从下一个LSN开始
+   * @param max_bytes 缓冲区大小，会向上调整为2的幂，并且至少能放下一条最大的日志
+   */
   RC init(LSN lsn, int32_t max_bytes = 0);
 
   /**
    * @brief 在缓冲区中追加一条日志
+   * @details 日志数据会直接复制到缓冲区中，调用返回后就不再使用 data。缓冲区满时会等待刷新线程腾出空间
    */
-  RC append(LSN &lsn, LogModule::Id module_id, vector<char> &&data);
-  RC append(LSN &lsn, LogModule module, vector<char> &&data);
+  RC append(LSN &lsn, LogModule::Id module_id, span<const char> data);
+  RC append(LSN &lsn, LogModule module, span<const char> data);
 
   /**
    * @brief 刷新缓冲区中的日志到磁盘
-   *
+   * @details 缓冲区中的日志作为一组，合并成一次写入并刷盘，然后唤醒等待的线程
    * @param file_handle 使用它来写文件
    * @param count 刷了多少条日志
    */
   RC flush(LogFileWriter &file_writer, int &count);
 
+  /**
+   * @brief 等待缓冲区中有日志
+   * @details 刷新日志的线程在缓冲区为空时调用
+   * @return 缓冲区中是否有日志
+   */
+  bool wait_for_entries(chrono::milliseconds timeout);
+
+  /**
+   * @brief 等待指定的日志刷新到磁盘
+   * @return 日志是否已经刷新到磁盘
+   */
+  bool wait_flushed(LSN lsn, chrono::milliseconds timeout);
+
+  /**
+   * @brief 唤醒所有等待的线程，停止的时候使用
+   */
+  void wakeup();
+
   /**
    * @brief 当前缓冲区中有多少字节的日志
    */
@@ -68,9 +101,40 @@ public:
   LSN flushed_lsn() const { return flushed_lsn_.load(); }
 
 private:
-  mutex           mutex_;  /// 当前数据结构一定会在多线程中访问，所以强制使用有效的锁，而不是有条件生效的common::Mutex
-  deque<LogEntry> entries_;  /// 日志缓冲区
-  atomic<int64_t> bytes_;    /// 当前缓冲区中的日志数据大小
+  /**
+   * @brief 等待前一条日志完成某个阶段
+   * @details 预留空间和发布日志都要按照LSN的顺序进行
+   */
+  static void wait_turn(const atomic<LSN> &last_lsn, LSN lsn);
+
+  /**
+   * @brief 等待刷新线程腾出空间，直到缓冲区可以容纳到 end_offset 为止
+   */
+  void wait_for_space(int64_t end_offset);
+
+  void copy_in(int64_t offset, const void *data, int64_t size);
+  void copy_out(int64_t offset, void *data, int64_t size) const;
+
+private:
+  /// 当前数据结构一定会在多线程中访问，所以强制使用有效的锁，而不是有条件生效的common::Mutex
+  /// 锁只用来配合条件变量等待，追加日志时不需要加锁
+  mutable mutex mutex_;
+
+  unique_ptr<char[]> ring_;          /// 环形缓冲区
+  int64_t            capacity_ = 0;  /// 环形缓冲区大小，是2的幂
+
+  /// 下面的偏移量都是逻辑偏移，一直增长，使用时再对 capacity_ 取模
+  atomic<LSN>     reserved_lsn_{0};      /// 最后一条预留了空间的日志
+  int64_t         reserved_offset_ = 0;  /// 预留空间的结尾。只有轮到预留空间的线程才会修改
+  atomic<LSN>     committed_lsn_{0};     /// 最后一条已经复制到缓冲区中的日志，在它之前的日志也都复制完了
+  atomic<int64_t> committed_offset_{0};  /// 已经复制完成的日志的结尾
+  atomic<LSN>     written_lsn_{0};       /// 最后一条已经写入文件的日志
+  atomic<int64_t> written_offset_{0};    /// 已经写入文件的日志的结尾，在它之前的空间可以重复使用
+
+  atomic<bool> flusher_waiting_{false};  /// 刷新线程是否在等待新的日志，没有等待时追加日志不需要通知它
+
+  condition_variable entries_cond_;  /// 追加日志时通知刷新线程
+  condition_variable flushed_cond_;  /// 一组日志刷盘后通知等待的线程
 
   atomic<LSN> current_lsn_{0};
   atomic<LSN> flushed_lsn_{0};
@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include <fcntl.h>
+#include <unistd.h>
 
 #include "common/lang/string_view.h"
 #include "common/lang/charconv.h"
@@ -155,7 +156,8 @@ RC LogFileWriter::open(const char *filename, int end_lsn)
   filename_ = filename;
   end_lsn_ = end_lsn;
 
-  fd_ = ::open(filename, O_WRONLY | O_APPEND | O_CREAT | O_SYNC, 0644);
+  // 不使用 O_SYNC，由调用者写完一组日志后调用 sync 刷盘
+  fd_ = ::open(filename, O_WRONLY | O_APPEND | O_CREAT, 0644);
   if (fd_ < 0) {
     LOG_WARN("open file failed. filename=%s, error=%s", filename, strerror(errno));
     return RC::FILE_OPEN;
@@ -183,34 +185,58 @@ RC LogFileWriter::write(LogEntry &entry)
     return RC::LOG_FILE_FULL;
   }
 
+  struct iovec iov[2];
+  iov[0].iov_base = const_cast<LogHeader *>(&entry.header());
+  iov[0].iov_len  = LogHeader::SIZE;
+  iov[1].iov_base = const_cast<char *>(entry.data());
+  iov[1].iov_len  = entry.payload_size();
+  return write(iov, 2, entry.lsn(), entry.lsn());
+}
+
+RC LogFileWriter::write(struct iovec *iov, int iovcnt, LSN first_lsn, LSN last_lsn)
+{
   if (fd_ < 0) {
     return RC::FILE_NOT_OPENED;
   }
 
-  if (entry.lsn() <= last_lsn_) {
-    LOG_WARN("write log entry failed. lsn is too small. filename=%s, last_lsn=%ld, entry=%s", 
-             filename_.c_str(), last_lsn_, entry.to_string().c_str());
+  if (first_lsn <= last_lsn_) {
+    LOG_WARN("write log entries failed. lsn is too small. filename=%s, last_lsn=%ld, first_lsn=%ld", 
+             filename_.c_str(), last_lsn_, first_lsn);
     return RC::INVALID_ARGUMENT;
   }
 
+  ASSERT(last_lsn <= end_lsn_, "log entries exceed the log file. last lsn=%ld, end lsn=%d", last_lsn, end_lsn_);
+
   /// WARNING 这里需要处理日志写一半的情况
   /// 日志只写成功一部分到文件中非常难处理
-  int ret = writen(fd_, reinterpret_cast<const char *>(&entry.header()), LogHeader::SIZE);
+  int ret = writevn(fd_, iov, iovcnt);
   if (0 != ret) {
-    LOG_WARN("write log entry header failed. filename=%s, ret = %d, error=%s, entry=%s", 
-             filename_.c_str(), ret, strerror(errno), entry.to_string().c_str());
+    LOG_WARN("write log entries failed. filename=%s, ret = %d, error=%s, first lsn=%ld, last lsn=%ld", 
+             filename_.c_str(), ret, strerror(ret), first_lsn, last_lsn);
     return RC::IOERR_WRITE;
   }
 
-  ret = writen(fd_, entry.data(), entry.payload_size());
-  if (0 != ret) {
-    LOG_WARN("write log entry payload failed. filename=%s, ret = %d, error=%s, entry=%s", 
-             filename_.c_str(), ret, strerror(errno), entry.to_string().c_str());
-    return RC::IOERR_WRITE;
+  last_lsn_ = last_lsn;
+  LOG_TRACE("write log entries success. filename=%s, first lsn=%ld, last lsn=%d",
+            filename_.c_str(), first_lsn, last_lsn_);
+  return RC::SUCCESS;
+}
+
+RC LogFileWriter::sync()
+{
+  if (fd_ < 0) {
+    return RC::FILE_NOT_OPENED;
   }
 
-  last_lsn_ = entry.lsn();
-  LOG_TRACE("write log entry success. filename=%s, entry=%s", filename_.c_str(), entry.to_string().c_str());
+#ifdef __MACH__
+  int ret = ::fsync(fd_);
+#else
+  int ret = ::fdatasync(fd_);
+#endif
+  if (ret != 0) {
+    LOG_WARN("sync log file failed. filename=%s, error=%s", filename_.c_str(), strerror(errno));
+    return RC::IOERR_SYNC;
+  }
   return RC::SUCCESS;
 }
 
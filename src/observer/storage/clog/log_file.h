@@ -21,7 +21,9 @@ See the Mulan PSL v2 for more details. */
 #include "common/lang/filesystem.h"
 #include "common/lang/fstream.h"
 #include "common/lang/string.h"
+#include "common/lang/vector.h"
 
+struct iovec;
 class LogEntry;
 
 /**
@@ -73,9 +75,28 @@ public:
   /// @brief 关闭当前文件
   RC close();
 
-  /// @brief 写入一条日志
+  /**
+   * @brief 写入一条日志
+   * @details 与批量写入一样，写入后不会刷盘，需要调用 sync
+   */
   RC write(LogEntry &entry);
 
+  /**
+   * @brief 写入一段已经序列化好的日志
+   * @details 数据是按照LSN从小到大排列的日志头和日志数据，可能分成多段内存，但是会合并成一次写入。
+   * 调用者需要保证这些日志的LSN都不超过当前文件的上限。写入后不会刷盘，需要调用 sync
+   * @param iov 日志数据，调用过程中会被修改
+   * @param first_lsn 第一条日志的LSN
+   * @param last_lsn 最后一条日志的LSN
+   */
+  RC write(struct iovec *iov, int iovcnt, LSN first_lsn, LSN last_lsn);
+
+  /**
+   * @brief 把已经写入的日志刷到磁盘上
+   * @details 组提交时一组日志只需要刷一次盘
+   */
+  RC sync();
+
   /**
    * @brief 当前文件是否已经打开
    */
@@ -90,6 +111,9 @@ public:
 
   const char *filename() const { return filename_.c_str(); }
 
+  /// @brief 当前文件允许写入的最大LSN
+  int end_lsn() const { return end_lsn_; }
+
 private:
   string filename_;       /// 日志文件名
   int    fd_       = -1;  /// 日志文件描述符
@@ -101,7 +101,7 @@ public:
 private:
   /**
    * @brief 写入一条日志
-   * @details 子类应该重现实现这个函数
+   * @details 子类应该重现实现这个函数。日志数据只在调用期间有效，需要的话由子类自己复制
    */
-  virtual RC _append(LSN &lsn, LogModule module, vector<char> &&data) = 0;
+  virtual RC _append(LSN &lsn, LogModule module, span<const char> data) = 0;
 };
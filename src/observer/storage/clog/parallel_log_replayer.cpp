@@ -0,0 +1,225 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <string.h>
+
+#include "storage/clog/parallel_log_replayer.h"
+#include "common/lang/algorithm.h"
+#include "common/log/log.h"
+#include "common/thread/thread_util.h"
+#include "storage/buffer/buffer_pool_log.h"
+#include "storage/record/record_log.h"
+
+using namespace common;
+
+ParallelLogReplayer::ParallelLogReplayer(LogReplayer &replayer, int thread_num) : replayer_(replayer)
+{
+  thread_num = max(thread_num, 1);
+  for (int i = 0; i < thread_num; i++) {
+    workers_.emplace_back(make_unique<Worker>());
+  }
+  for (int i = 0; i < thread_num; i++) {
+    workers_[i]->thread_ = thread(&ParallelLogReplayer::thread_func, this, i);
+  }
+  LOG_INFO("parallel log replayer started. thread num=%d", thread_num);
+}
+
+ParallelLogReplayer::~ParallelLogReplayer() { stop(); }
+
+int ParallelLogReplayer::safe_thread_num(int thread_num)
+{
+#ifdef CONCURRENCY
+  return thread_num;
+#else
+  return min(thread_num, 1);
+#endif
+}
+
+RC ParallelLogReplayer::replay(const LogEntry &entry)
+{
+  if (failed_.load()) {
+    // 工作线程已经失败了，没有必要再读取后面的日志
+    lock_guard guard(progress_lock_);
+    return error_rc_;
+  }
+
+  const char   *data         = entry.data();
+  const int32_t payload_size = entry.payload_size();
+
+  Task task;
+  int  index = -1;
+  switch (entry.module().id()) {
+    case LogModule::Id::BUFFER_POOL: {
+      if (payload_size < static_cast<int32_t>(sizeof(BufferPoolLogEntry))) {
+        break;
+      }
+      auto *log = reinterpret_cast<const BufferPoolLogEntry *>(data);
+      index     = worker_of(log->buffer_pool_id);
+      buffer_pool_lsns_[log->buffer_pool_id] = entry.lsn();
+    } break;
+
+    case LogModule::Id::BPLUS_TREE: {
+      // B+树日志的第一个字段是 buffer pool id，参考 BplusTreeLogger::redo
+      int32_t buffer_pool_id = -1;
+      if (payload_size < static_cast<int32_t>(sizeof(buffer_pool_id))) {
+        break;
+      }
+      memcpy(&buffer_pool_id, data, sizeof(buffer_pool_id));
+      index = worker_of(buffer_pool_id);
+    } break;
+
+    case LogModule::Id::RECORD_MANAGER: {
+      if (payload_size < RecordLogHeader::SIZE) {
+        break;
+      }
+      auto *log = reinterpret_cast<const RecordLogHeader *>(data);
+      index     = worker_of(log->buffer_pool_id, log->page_num);
+
+      // 页面可能是前面刚分配出来的，需要等分配日志回放完成
+      const int  buffer_pool_worker = worker_of(log->buffer_pool_id);
+      const auto iter               = buffer_pool_lsns_.find(log->buffer_pool_id);
+      if (buffer_pool_worker != index && iter != buffer_pool_lsns_.end()) {
+        task.wait_worker = buffer_pool_worker;
+        task.wait_lsn    = iter->second;
+      }
+    } break;
+
+    default: {
+      // 事务日志等只修改内存状态，直接在当前线程回放
+    } break;
+  }
+
+  if (index < 0) {
+    return replayer_.replay(entry);
+  }
+
+  RC rc = task.entry.init(entry.lsn(), entry.module(), vector<char>(data, data + payload_size));
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to copy log entry. entry=%s, rc=%s", entry.to_string().c_str(), strrc(rc));
+    return rc;
+  }
+
+  dispatch(index, std::move(task));
+  return RC::SUCCESS;
+}
+
+RC ParallelLogReplayer::on_done()
+{
+  stop();
+
+  if (failed_.load()) {
+    LOG_WARN("failed to replay log entries in parallel. rc=%s", strrc(error_rc_));
+    return error_rc_;
+  }
+
+  return replayer_.on_done();
+}
+
+void ParallelLogReplayer::dispatch(int index, Task &&task)
+{
+  Worker &worker = *workers_[index];
+  {
+    unique_lock guard(worker.lock_);
+    worker.space_cond_.wait(guard, [&worker] { return worker.tasks_.size() < MAX_PENDING_TASKS; });
+    worker.tasks_.emplace_back(std::move(task));
+  }
+  worker.task_cond_.notify_one();
+}
+
+void ParallelLogReplayer::thread_func(int index)
+{
+  thread_set_name("LogReplayer");
+
+  Worker &worker = *workers_[index];
+  while (true) {
+    Task task;
+    {
+      unique_lock guard(worker.lock_);
+      worker.task_cond_.wait(guard, [&worker] { return worker.stopped_ || !worker.tasks_.empty(); });
+      if (worker.tasks_.empty()) {
+        break;
+      }
+
+      task = std::move(worker.tasks_.front());
+      worker.tasks_.pop_front();
+    }
+    worker.space_cond_.notify_one();
+
+    if (task.wait_worker >= 0) {
+      wait_applied(task.wait_worker, task.wait_lsn);
+    }
+
+    // 出错之后不再回放，但是仍然要推进进度，不能让等待的线程卡住
+    if (!failed_.load()) {
+      RC rc = replayer_.replay(task.entry);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to replay log entry. entry=%s, rc=%s", task.entry.to_string().c_str(), strrc(rc));
+        set_error(rc);
+      }
+    }
+
+    worker.applied_lsn_.store(task.entry.lsn());
+    if (task.entry.module().id() == LogModule::Id::BUFFER_POOL) {
+      {
+        lock_guard guard(progress_lock_);
+      }
+      progress_cond_.notify_all();
+    }
+  }
+}
+
+void ParallelLogReplayer::wait_applied(int index, LSN lsn)
+{
+  Worker &worker = *workers_[index];
+  if (worker.applied_lsn_.load() >= lsn) {
+    return;
+  }
+
+  unique_lock guard(progress_lock_);
+  progress_cond_.wait(guard, [&worker, lsn] { return worker.applied_lsn_.load() >= lsn; });
+}
+
+void ParallelLogReplayer::set_error(RC rc)
+{
+  lock_guard guard(progress_lock_);
+  if (!failed_.load()) {
+    error_rc_ = rc;
+    failed_.store(true);
+  }
+}
+
+int ParallelLogReplayer::worker_of(int32_t buffer_pool_id) const
+{
+  return static_cast<int>(static_cast<uint32_t>(buffer_pool_id) % workers_.size());
+}
+
+int ParallelLogReplayer::worker_of(int32_t buffer_pool_id, int32_t page_num) const
+{
+  // 相邻的页面分到不同的线程上
+  const uint32_t key = static_cast<uint32_t>(buffer_pool_id) * 31 + static_cast<uint32_t>(page_num);
+  return static_cast<int>(key % workers_.size());
+}
+
+void ParallelLogReplayer::stop()
+{
+  for (unique_ptr<Worker> &worker : workers_) {
+    {
+      lock_guard guard(worker->lock_);
+      worker->stopped_ = true;
+    }
+    worker->task_cond_.notify_all();
+  }
+
+  for (unique_ptr<Worker> &worker : workers_) {
+    if (worker->thread_.joinable()) {
+      worker->thread_.join();
+    }
+  }
+}
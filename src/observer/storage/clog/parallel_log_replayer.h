@@ -0,0 +1,118 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/types.h"
+#include "common/lang/atomic.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/deque.h"
+#include "common/lang/memory.h"
+#include "common/lang/mutex.h"
+#include "common/lang/thread.h"
+#include "common/lang/unordered_map.h"
+#include "common/lang/vector.h"
+#include "storage/clog/log_entry.h"
+#include "storage/clog/log_replayer.h"
+
+/**
+ * @brief 多线程回放日志
+ * @ingroup CLog
+ * @details 包装另一个日志回放器(通常是 IntegratedLogReplayer)，把日志分发到多个工作线程上并发回放。
+ * 日志还是由一个线程顺序读取，分发规则如下：
+ * - 记录(RECORD_MANAGER)日志只修改一个页面，按照 (buffer_pool_id, page_num) 分配线程，
+ *   同一个页面的日志由同一个线程按照LSN的顺序回放；
+ * - 缓冲池(BUFFER_POOL)和B+树(BPLUS_TREE)日志会修改文件头、分配图或者多个页面，按照 buffer_pool_id
+ *   分配线程，同一个文件的这类日志都由同一个线程按顺序回放；
+ * - 事务(TRANSACTION)日志只修改内存中的事务状态，由读取日志的线程直接回放。
+ * 记录日志依赖所在文件中此前的缓冲池日志(页面要先分配出来)，如果两者不在同一个线程，回放记录日志之前
+ * 要等待对应的线程回放完那条缓冲池日志。被等待的日志本身不会再等待其它日志，所以不会死锁。
+ * 所有日志回放完成后，在 on_done 中等待所有线程结束，再调用被包装的回放器的 on_done，
+ * 比如回滚没有提交的事务。工作线程回放失败时，错误也在 on_done 中返回。
+ */
+class ParallelLogReplayer : public LogReplayer
+{
+public:
+  /**
+   * @param replayer 实际回放日志的对象，它的 replay 需要能在多个线程中调用
+   * @param thread_num 工作线程的个数
+   */
+  ParallelLogReplayer(LogReplayer &replayer, int thread_num);
+  virtual ~ParallelLogReplayer();
+
+  //! @copydoc LogReplayer::replay
+  RC replay(const LogEntry &entry) override;
+
+  //! @copydoc LogReplayer::on_done
+  RC on_done() override;
+
+  int thread_num() const { return static_cast<int>(workers_.size()); }
+
+  /**
+   * @brief 回放数据库日志时实际可以使用的线程数
+   * @details 回放数据库日志时会在多个线程中访问 buffer pool。没有定义 CONCURRENCY 时 buffer pool 的锁和页面的
+   * 读写锁都是空的，不能在多个线程中访问，只能使用一个线程
+   */
+  static int safe_thread_num(int thread_num);
+
+private:
+  /**
+   * @brief 分发给工作线程的一条日志
+   */
+  struct Task
+  {
+    LogEntry entry;
+    int      wait_worker = -1;  /// 回放前需要等待这个线程
+    LSN      wait_lsn    = 0;   /// 回放前需要等待的日志
+  };
+
+  /**
+   * @brief 工作线程
+   */
+  struct Worker
+  {
+    thread             thread_;
+    mutex              lock_;
+    condition_variable task_cond_;   /// 有新的日志时通知工作线程
+    condition_variable space_cond_;  /// 日志被取走时通知读取日志的线程
+    deque<Task>        tasks_;
+    bool               stopped_ = false;
+    atomic<LSN>        applied_lsn_{0};  /// 已经回放完的最后一条日志
+  };
+
+  /// 每个线程最多缓存的日志条数，超过时读取日志的线程等待
+  static constexpr size_t MAX_PENDING_TASKS = 4096;
+
+private:
+  void thread_func(int index);
+
+  void dispatch(int index, Task &&task);
+  void wait_applied(int index, LSN lsn);
+  void set_error(RC rc);
+
+  int worker_of(int32_t buffer_pool_id) const;
+  int worker_of(int32_t buffer_pool_id, int32_t page_num) const;
+
+  /// @brief 等待所有工作线程退出
+  void stop();
+
+private:
+  LogReplayer &replayer_;
+
+  vector<unique_ptr<Worker>> workers_;
+
+  mutex              progress_lock_;  /// 等待其它线程回放缓冲池日志时使用
+  condition_variable progress_cond_;
+
+  unordered_map<int32_t, LSN> buffer_pool_lsns_;  /// 每个文件最后一条缓冲池日志的LSN，只在读取日志的线程中访问
+
+  atomic<bool> failed_{false};
+  RC           error_rc_ = RC::SUCCESS;
+};
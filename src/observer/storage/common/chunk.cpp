@@ -9,6 +9,7 @@ MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
 See the Mulan PSL v2 for more details. */
 
 #include "storage/common/chunk.h"
+#include "common/lang/algorithm.h"
 
 void Chunk::add_column(unique_ptr<Column> col, int col_id)
 {
@@ -27,6 +28,8 @@ RC Chunk::reference(Chunk &chunk)
     columns_[i]->reference(chunk.column(i));
     column_ids_.push_back(chunk.column_ids(i));
   }
+  selection_     = chunk.selection_;
+  has_selection_ = chunk.has_selection_;
   return RC::SUCCESS;
 }
 
@@ -38,6 +41,44 @@ int Chunk::rows() const
   return 0;
 }
 
+void Chunk::set_selection(const int *selection, int size)
+{
+  selection_.assign(selection, selection + size);
+  has_selection_ = true;
+}
+
+void Chunk::clear_selection()
+{
+  selection_.clear();
+  has_selection_ = false;
+}
+
+RC Chunk::compact()
+{
+  if (!has_selection_) {
+    return RC::SUCCESS;
+  }
+
+  const int size = static_cast<int>(selection_.size());
+  for (unique_ptr<Column> &col : columns_) {
+    if (col->column_type() == Column::Type::CONSTANT_COLUMN) {
+      col->set_count(size);
+      continue;
+    }
+
+    auto compacted = make_unique<Column>(col->attr_type(), col->attr_len(), max(size, 1));
+    RC   rc        = compacted->append_selected(*col, selection_.data(), size);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to compact column. rc=%s", strrc(rc));
+      return rc;
+    }
+    col = std::move(compacted);
+  }
+
+  clear_selection();
+  return RC::SUCCESS;
+}
+
 int Chunk::capacity() const
 {
   if (!columns_.empty()) {
@@ -51,10 +92,12 @@ void Chunk::reset_data()
   for (auto &col : columns_) {
     col->reset_data();
   }
+  clear_selection();
 }
 
 void Chunk::reset()
 {
   columns_.clear();
   column_ids_.clear();
+  clear_selection();
 }
\ No newline at end of file
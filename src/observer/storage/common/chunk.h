@@ -22,19 +22,25 @@ See the Mulan PSL v2 for more details. */
 class Chunk
 {
 public:
-  static const int MAX_ROWS = Column::DEFAULT_CAPACITY;
-  Chunk()                   = default;
+  static constexpr int MAX_ROWS = Column::DEFAULT_CAPACITY;
+  Chunk()                       = default;
   Chunk(const Chunk &other)
   {
     for (size_t i = 0; i < other.columns_.size(); ++i) {
       columns_.emplace_back(other.columns_[i]->clone());
     }
-    column_ids_ = other.column_ids_;
+    column_ids_    = other.column_ids_;
+    selection_     = other.selection_;
+    has_selection_ = other.has_selection_;
   }
   Chunk(Chunk &&chunk)
   {
-    columns_    = std::move(chunk.columns_);
-    column_ids_ = std::move(chunk.column_ids_);
+    columns_       = std::move(chunk.columns_);
+    column_ids_    = std::move(chunk.column_ids_);
+    selection_     = std::move(chunk.selection_);
+    has_selection_ = chunk.has_selection_;
+
+    chunk.has_selection_ = false;
   }
 
   int column_num() const { return columns_.size(); }
@@ -65,13 +71,55 @@ public:
 
   void add_column(unique_ptr<Column> col, int col_id);
 
+  /**
+   * @brief 引用另一个 Chunk 的列，选择向量会一起复制过来
+   */
   RC reference(Chunk &chunk);
 
   /**
    * @brief 获取 Chunk 中的行数
+   * @details 这里是列中实际存放的行数，有选择向量时其中只有一部分行是有效的，参考 selected_rows
    */
   int rows() const;
 
+  /**
+   * @brief 设置选择向量
+   * @details 设置之后，Chunk 中只有 selection 中的行是有效的，其它行在逻辑上已经被过滤掉了。
+   * selection 中是递增的行号，这样过滤时不需要拷贝列数据，由下游算子按需读取有效的行。
+   * @param selection 有效的行号，会拷贝一份
+   * @param size 有效的行数
+   */
+  void set_selection(const int *selection, int size);
+
+  /**
+   * @brief 清除选择向量，所有的行都是有效的
+   */
+  void clear_selection();
+
+  bool has_selection() const { return has_selection_; }
+
+  /**
+   * @brief 有效的行号。没有选择向量时返回 nullptr
+   */
+  const int *selection() const { return has_selection_ ? selection_.data() : nullptr; }
+
+  /**
+   * @brief 有效的行数
+   */
+  int selected_rows() const { return has_selection_ ? static_cast<int>(selection_.size()) : rows(); }
+
+  /**
+   * @brief 第 i 个有效的行在列中的行号
+   */
+  int selected_row(int i) const { return has_selection_ ? selection_[i] : i; }
+
+  /**
+   * @brief 按照选择向量把有效的行拷贝到新的列中，之后 Chunk 不再有选择向量
+   * @details 不在原来的列上原地整理，因为这些列可能引用了其它 Chunk 的数据，也可能多个列引用同一份数据。
+   * 按照列的长度直接拷贝定长的数据，不会逐个构造 Value。
+   */
+  RC compact();
+
   /**
    * @brief 获取 Chunk 的容量
    */
@@ -99,4 +147,7 @@ private:
   // TODO: remove it and support multi-tables,
   // `columnd_ids` store the ids of child operator that need to be output
   vector<int> column_ids_;
+
+  vector<int> selection_;              ///< 有效的行号，has_selection_ 为 true 时才有意义
+  bool        has_selection_ = false;  ///< 是否有选择向量
 };
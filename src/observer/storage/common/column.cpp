@@ -118,6 +118,54 @@ RC Column::append(const char *data, int count)
   return RC::SUCCESS;
 }
 
+template <typename T>
+static void gather_values(char *dest, const char *src, const int *selection, int count)
+{
+  T       *dest_values = reinterpret_cast<T *>(dest);
+  const T *src_values  = reinterpret_cast<const T *>(src);
+  for (int i = 0; i < count; i++) {
+    dest_values[i] = src_values[selection[i]];
+  }
+}
+
+RC Column::append_selected(const Column &column, const int *selection, int count)
+{
+  if (!own_) {
+    LOG_WARN("append data to non-owned column");
+    return RC::INTERNAL;
+  }
+  if (count_ + count > capacity_) {
+    LOG_WARN("append data to full column");
+    return RC::INTERNAL;
+  }
+  if (column.attr_len() != attr_len_) {
+    LOG_WARN("append data with different length. expected=%d, actual=%d", attr_len_, column.attr_len());
+    return RC::INTERNAL;
+  }
+
+  char       *dest = data_ + count_ * attr_len_;
+  const char *src  = column.data();
+  if (column.column_type() == Type::CONSTANT_COLUMN) {
+    for (int i = 0; i < count; i++) {
+      memcpy(dest + i * attr_len_, src, attr_len_);
+    }
+  } else {
+    switch (attr_len_) {
+      case 1: gather_values<uint8_t>(dest, src, selection, count); break;
+      case 2: gather_values<uint16_t>(dest, src, selection, count); break;
+      case 4: gather_values<uint32_t>(dest, src, selection, count); break;
+      case 8: gather_values<uint64_t>(dest, src, selection, count); break;
+      default: {
+        for (int i = 0; i < count; i++) {
+          memcpy(dest + i * attr_len_, src + static_cast<size_t>(selection[i]) * attr_len_, attr_len_);
+        }
+      } break;
+    }
+  }
+  count_ += count;
+  return RC::SUCCESS;
+}
+
 RC Column::append_value(const Value &value)
 {
   if (!own_) {
@@ -82,6 +82,14 @@ public:
    */
   RC append(const char *data, int count);
 
+  /**
+   * @brief 把另一个 Column 中指定的行追加到当前 Column 中
+   * @details 按照列值的长度直接拷贝，不会构造 Value。两个 Column 的类型和长度需要相同
+   * @param selection 要拷贝的行号
+   * @param count 要拷贝的行数
+   */
+  RC append_selected(const Column &column, const int *selection, int count);
+
   /**
    * @brief 获取 index 位置的列值
    */
@@ -0,0 +1,172 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "storage/common/spill_file.h"
+#include "common/io/io.h"
+#include "common/lang/algorithm.h"
+#include "common/log/log.h"
+
+using namespace std;
+using namespace common;
+
+SpillFile::~SpillFile() { remove(); }
+
+RC SpillFile::create(const string &path)
+{
+  remove();
+
+  fd_ = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+  if (fd_ < 0) {
+    LOG_WARN("failed to create spill file. path=%s, error=%s", path.c_str(), strerror(errno));
+    return RC::IOERR_OPEN;
+  }
+
+  path_ = path;
+  buffer_.reserve(BUFFER_SIZE);
+  LOG_TRACE("spill file created. path=%s", path_.c_str());
+  return RC::SUCCESS;
+}
+
+RC SpillFile::append(uint64_t hash, const char *data, int len)
+{
+  ASSERT(fd_ >= 0 && !reading_, "spill file is not writable. path=%s", path_.c_str());
+
+  const size_t record_size = HEADER_SIZE + len;
+  if (buffer_.size() + record_size > BUFFER_SIZE && !buffer_.empty()) {
+    RC rc = flush();
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+
+  const uint32_t length = static_cast<uint32_t>(len);
+  const size_t   offset = buffer_.size();
+  buffer_.resize(offset + record_size);
+  memcpy(&buffer_[offset], &hash, sizeof(hash));
+  memcpy(&buffer_[offset + sizeof(hash)], &length, sizeof(length));
+  memcpy(&buffer_[offset + HEADER_SIZE], data, len);
+
+  size_ += record_size;
+  record_num_++;
+  return RC::SUCCESS;
+}
+
+RC SpillFile::flush()
+{
+  if (buffer_.empty()) {
+    return RC::SUCCESS;
+  }
+
+  int ret = pwriten(fd_, buffer_.data(), static_cast<int>(buffer_.size()), flushed_size_);
+  if (ret != 0) {
+    LOG_WARN("failed to write spill file. path=%s, error=%s", path_.c_str(), strerror(ret));
+    return RC::IOERR_WRITE;
+  }
+
+  flushed_size_ += buffer_.size();
+  buffer_.clear();
+  return RC::SUCCESS;
+}
+
+RC SpillFile::rewind()
+{
+  if (fd_ < 0) {
+    return RC::INTERNAL;
+  }
+
+  if (!reading_) {
+    RC rc = flush();
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    reading_ = true;
+  }
+
+  buffer_.clear();
+  buffer_pos_  = 0;
+  read_offset_ = 0;
+  return RC::SUCCESS;
+}
+
+RC SpillFile::next(uint64_t &hash, const char *&data, int &len)
+{
+  ASSERT(reading_, "spill file should be rewound before reading. path=%s", path_.c_str());
+
+  // 缓冲区中剩下的数据不够一条记录时，把剩下的数据移到开头，再从文件中读取
+  auto fill = [this](size_t need) -> RC {
+    const size_t left = buffer_.size() - buffer_pos_;
+    if (left >= need) {
+      return RC::SUCCESS;
+    }
+
+    const int64_t file_left = flushed_size_ - read_offset_;
+    if (static_cast<int64_t>(need - left) > file_left) {
+      return file_left == 0 && left == 0 ? RC::RECORD_EOF : RC::IOERR_READ;
+    }
+
+    memmove(buffer_.data(), buffer_.data() + buffer_pos_, left);
+    const size_t read_size = static_cast<size_t>(min<int64_t>(max<size_t>(need, BUFFER_SIZE) - left, file_left));
+    buffer_.resize(left + read_size);
+    buffer_pos_ = 0;
+
+    int ret = preadn(fd_, buffer_.data() + left, static_cast<int>(read_size), read_offset_);
+    if (ret != 0) {
+      LOG_WARN("failed to read spill file. path=%s, ret=%d", path_.c_str(), ret);
+      return RC::IOERR_READ;
+    }
+    read_offset_ += read_size;
+    return RC::SUCCESS;
+  };
+
+  RC rc = fill(HEADER_SIZE);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  uint32_t length = 0;
+  memcpy(&hash, buffer_.data() + buffer_pos_, sizeof(hash));
+  memcpy(&length, buffer_.data() + buffer_pos_ + sizeof(hash), sizeof(length));
+
+  rc = fill(HEADER_SIZE + length);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("spill file is truncated. path=%s, rc=%s", path_.c_str(), strrc(rc));
+    return RC::IOERR_READ;
+  }
+
+  data = buffer_.data() + buffer_pos_ + HEADER_SIZE;
+  len  = static_cast<int>(length);
+  buffer_pos_ += HEADER_SIZE + length;
+  return RC::SUCCESS;
+}
+
+void SpillFile::remove()
+{
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+    if (::unlink(path_.c_str()) != 0) {
+      LOG_WARN("failed to remove spill file. path=%s, error=%s", path_.c_str(), strerror(errno));
+    }
+  }
+
+  path_.clear();
+  buffer_.clear();
+  buffer_.shrink_to_fit();
+  size_         = 0;
+  record_num_   = 0;
+  flushed_size_ = 0;
+  read_offset_  = 0;
+  buffer_pos_   = 0;
+  reading_      = false;
+}
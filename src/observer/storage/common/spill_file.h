@@ -0,0 +1,84 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+
+/**
+ * @brief 算子内存不够时用来溢出数据的临时文件
+ * @details 先顺序追加写入，写完之后再从头顺序读取，可以反复读取多次。每条记录带有一个哈希值，
+ * 方便使用者读出来之后不用重新计算就可以再次分区。
+ * 读写都经过一个缓冲区，不经过 buffer pool。文件在 remove 或者析构时删除。
+ * 不支持并发访问。
+ */
+class SpillFile
+{
+public:
+  static constexpr int BUFFER_SIZE = 64 * 1024;
+
+  SpillFile() = default;
+  ~SpillFile();
+
+  SpillFile(const SpillFile &)            = delete;
+  SpillFile &operator=(const SpillFile &) = delete;
+
+  /**
+   * @brief 创建临时文件，文件已经存在时会被清空
+   */
+  RC create(const string &path);
+
+  /**
+   * @brief 追加一条记录
+   */
+  RC append(uint64_t hash, const char *data, int len);
+
+  /**
+   * @brief 从头开始读取。会先把写缓冲区中的数据写到文件中
+   */
+  RC rewind();
+
+  /**
+   * @brief 读取下一条记录
+   * @param data 记录的数据，下次调用 next 之前有效
+   * @return 读完时返回 RECORD_EOF
+   */
+  RC next(uint64_t &hash, const char *&data, int &len);
+
+  /**
+   * @brief 关闭并删除文件
+   */
+  void remove();
+
+  const string &path() const { return path_; }
+  int64_t       size() const { return size_; }  ///< 写入的字节数
+  int64_t       record_num() const { return record_num_; }
+
+private:
+  RC flush();
+
+private:
+  static constexpr int HEADER_SIZE = sizeof(uint64_t) + sizeof(uint32_t);  ///< 每条记录前面的哈希值和长度
+
+  string  path_;
+  int     fd_         = -1;
+  int64_t size_       = 0;
+  int64_t record_num_ = 0;
+
+  vector<char> buffer_;           ///< 写的时候缓存还没有写入文件的数据，读的时候缓存从文件中读出来的数据
+  int64_t      flushed_size_ = 0;  ///< 已经写入文件的字节数
+  int64_t      read_offset_  = 0;  ///< 下次从文件的哪个位置读取
+  size_t       buffer_pos_   = 0;  ///< 读取时缓冲区中下一条记录的位置
+  bool         reading_      = false;
+};
@@ -17,21 +17,37 @@ See the Mulan PSL v2 for more details. */
 #include <fcntl.h>
 #include <sys/stat.h>
 
+#include "common/conf/ini.h"
+#include "common/lang/chrono.h"
 #include "common/lang/string.h"
 #include "common/log/log.h"
 #include "common/os/path.h"
 #include "common/global_context.h"
+#include "common/ini_setting.h"
 #include "storage/common/meta_util.h"
 #include "storage/table/table.h"
 #include "storage/table/table_meta.h"
 #include "storage/trx/trx.h"
+#include "storage/trx/mvcc_trx.h"
 #include "storage/clog/disk_log_handler.h"
 #include "storage/clog/integrated_log_replayer.h"
+#include "storage/clog/parallel_log_replayer.h"
 
 using namespace common;
 
 Db::~Db()
 {
+  if (vacuum_) {
+    // 清理时会访问所有的表，要在关闭表之前停止
+    vacuum_->stop();
+    vacuum_.reset();
+  }
+
+  if (buffer_pool_manager_) {
+    // 刷脏页时需要等待日志写入，要在停止日志之前停止
+    buffer_pool_manager_->page_cleaner().stop();
+  }
+
   for (auto &iter : opened_tables_) {
     delete iter.second;
   }
@@ -83,8 +99,11 @@ RC Db::init(const char *name, const char *dbpath, const char *trx_kit_name, cons
 
   storage_engine_ = storage_engine;
 
-  buffer_pool_manager_ = make_unique<BufferPoolManager>();
-  auto dblwr_buffer    = make_unique<DiskDoubleWriteBuffer>(*buffer_pool_manager_);
+  const string frame_replacer =
+      common::get_properties()->get(BUFFER_POOL_REPLACER, BUFFER_POOL_REPLACER_DEFAULT, STORAGE);
+  buffer_pool_manager_ = make_unique<BufferPoolManager>(
+      0 /*memory_size*/, BPFrameManager::DEFAULT_SHARD_NUM, frame_replacer.c_str());
+  auto dblwr_buffer = make_unique<DiskDoubleWriteBuffer>(*buffer_pool_manager_);
 
   const char      *double_write_buffer_filename  = "dblwr.db";
   filesystem::path double_write_buffer_file_path = filesystem::path(dbpath) / double_write_buffer_filename;
@@ -101,6 +120,29 @@ RC Db::init(const char *name, const char *dbpath, const char *trx_kit_name, cons
     return rc;
   }
 
+  const string io_engine          = common::get_properties()->get(IO_ENGINE, IO_ENGINE_DEFAULT, STORAGE);
+  const string io_queue_depth_str = common::get_properties()->get(IO_QUEUE_DEPTH, IO_QUEUE_DEPTH_DEFAULT, STORAGE);
+  int          io_queue_depth     = 0;
+  if (!common::str_to_val(io_queue_depth_str, io_queue_depth) || io_queue_depth <= 0) {
+    LOG_ERROR("Invalid io queue depth: %s", io_queue_depth_str.c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  rc = buffer_pool_manager_->init_io_engine(io_engine.c_str(), io_queue_depth);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to init io engine. io engine=%s, rc=%s", io_engine.c_str(), strrc(rc));
+    return rc;
+  }
+
+  const string read_ahead_pages_str =
+      common::get_properties()->get(BUFFER_POOL_READ_AHEAD_PAGES, BUFFER_POOL_READ_AHEAD_PAGES_DEFAULT, STORAGE);
+  int read_ahead_pages = 0;
+  if (!common::str_to_val(read_ahead_pages_str, read_ahead_pages) || read_ahead_pages < 0) {
+    LOG_ERROR("Invalid buffer pool read ahead pages: %s", read_ahead_pages_str.c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+  buffer_pool_manager_->set_read_ahead_pages(read_ahead_pages);
+
   filesystem::path clog_path       = filesystem::path(dbpath) / "clog";
   LogHandler      *tmp_log_handler = nullptr;
   rc                               = LogHandler::create(log_handler_name, tmp_log_handler);
@@ -147,11 +189,25 @@ RC Db::init(const char *name, const char *dbpath, const char *trx_kit_name, cons
     return rc;
   }
 
+  rc = start_page_cleaner();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to start page cleaner. dbpath=%s, rc=%s", dbpath, strrc(rc));
+    return rc;
+  }
+
+  rc = start_vacuum();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to start vacuum. dbpath=%s, rc=%s", dbpath, strrc(rc));
+    return rc;
+  }
+
   return rc;
 }
 
 RC Db::create_table(const char *table_name, span<const AttrInfoSqlNode> attributes, const vector<string>& primary_keys, const StorageFormat storage_format)
 {
+  MvccVacuum::PauseGuard vacuum_pause_guard(vacuum_.get());
+
   RC rc = RC::SUCCESS;
   // check table_name
   if (opened_tables_.count(table_name) != 0) {
@@ -193,6 +249,8 @@ RC Db::drop_table(const char *table_name){
 
   Table *table = it->second;
 
+  MvccVacuum::PauseGuard vacuum_pause_guard(vacuum_.get());
+
   // 调用表的drop方法，释放资源
  RC drop_rc = table->drop(path_.c_str());
   if (drop_rc != RC::SUCCESS) {
@@ -330,8 +388,35 @@ RC Db::recover()
     return RC::INTERNAL;
   }
 
-  IntegratedLogReplayer log_replayer(*buffer_pool_manager_, unique_ptr<LogReplayer>(trx_log_replayer));
-  RC                    rc = log_handler_->replay(log_replayer, check_point_lsn_ /*start_lsn*/);
+  const string thread_num_str =
+      common::get_properties()->get(CLOG_REPLAY_THREADS, CLOG_REPLAY_THREADS_DEFAULT, STORAGE);
+  int thread_num = 0;
+  if (!common::str_to_val(thread_num_str, thread_num) || thread_num <= 0) {
+    LOG_ERROR("Invalid clog replay threads setting. threads=%s", thread_num_str.c_str());
+    delete trx_log_replayer;
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const int safe_thread_num = ParallelLogReplayer::safe_thread_num(thread_num);
+  if (safe_thread_num != thread_num) {
+    LOG_WARN("buffer pool is not thread safe without concurrency control, replay clog in %d thread(s). configured=%d",
+             safe_thread_num, thread_num);
+    thread_num = safe_thread_num;
+  }
+
+  const auto begin_time = chrono::steady_clock::now();
+
+  IntegratedLogReplayer integrated_replayer(*buffer_pool_manager_, unique_ptr<LogReplayer>(trx_log_replayer));
+
+  // 多个线程回放时，按照页面把日志分给各个线程
+  unique_ptr<ParallelLogReplayer> parallel_replayer;
+  LogReplayer                    *log_replayer = &integrated_replayer;
+  if (thread_num > 1) {
+    parallel_replayer = make_unique<ParallelLogReplayer>(integrated_replayer, thread_num);
+    log_replayer      = parallel_replayer.get();
+  }
+
+  RC rc = log_handler_->replay(*log_replayer, check_point_lsn_ /*start_lsn*/);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to replay log. rc=%s", strrc(rc));
     return rc;
@@ -343,13 +428,15 @@ RC Db::recover()
     return rc;
   }
 
-  rc = log_replayer.on_done();
+  rc = log_replayer->on_done();
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to on_done. rc=%s", strrc(rc));
     return rc;
   }
 
-  LOG_INFO("Successfully recover db. db=%s checkpoint_lsn=%d", name_.c_str(), check_point_lsn_);
+  const auto cost_ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - begin_time).count();
+  LOG_INFO("Successfully recover db. db=%s checkpoint_lsn=%d, replay threads=%d, cost=%ldms",
+           name_.c_str(), check_point_lsn_, thread_num, cost_ms);
   return rc;
 }
 
@@ -450,6 +537,69 @@ RC Db::init_dblwr_buffer()
   return RC::SUCCESS;
 }
 
+RC Db::start_page_cleaner()
+{
+  const string thread_num_str =
+      common::get_properties()->get(BUFFER_POOL_CLEANER_THREADS, BUFFER_POOL_CLEANER_THREADS_DEFAULT, STORAGE);
+  const string low_watermark_str =
+      common::get_properties()->get(BUFFER_POOL_DIRTY_LOW_WATERMARK, BUFFER_POOL_DIRTY_LOW_WATERMARK_DEFAULT, STORAGE);
+  const string high_watermark_str = common::get_properties()->get(
+      BUFFER_POOL_DIRTY_HIGH_WATERMARK, BUFFER_POOL_DIRTY_HIGH_WATERMARK_DEFAULT, STORAGE);
+
+  int thread_num     = 0;
+  int low_watermark  = 0;
+  int high_watermark = 0;
+  if (!common::str_to_val(thread_num_str, thread_num) || !common::str_to_val(low_watermark_str, low_watermark) ||
+      !common::str_to_val(high_watermark_str, high_watermark)) {
+    LOG_ERROR("Invalid page cleaner settings. threads=%s, low watermark=%s, high watermark=%s",
+              thread_num_str.c_str(), low_watermark_str.c_str(), high_watermark_str.c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+
+#ifndef CONCURRENCY
+  // 没有并发控制时页面的读写锁都是空的，后台线程写页面时前台可能正在修改它
+  if (thread_num > 0) {
+    LOG_INFO("page cleaner is disabled without concurrency control. configured threads=%d", thread_num);
+  }
+  thread_num = 0;
+#endif
+
+  return buffer_pool_manager_->page_cleaner().start(thread_num, low_watermark, high_watermark);
+}
+
+RC Db::start_vacuum()
+{
+  auto *mvcc_trx_kit = dynamic_cast<MvccTrxKit *>(trx_kit_.get());
+  if (mvcc_trx_kit == nullptr || get_storage_engine() != StorageEngine::HEAP) {
+    return RC::SUCCESS;
+  }
+
+  const string interval_str =
+      common::get_properties()->get(MVCC_VACUUM_INTERVAL_MS, MVCC_VACUUM_INTERVAL_MS_DEFAULT, STORAGE);
+  const string pages_per_round_str =
+      common::get_properties()->get(MVCC_VACUUM_PAGES_PER_ROUND, MVCC_VACUUM_PAGES_PER_ROUND_DEFAULT, STORAGE);
+  const string records_per_round_str =
+      common::get_properties()->get(MVCC_VACUUM_RECORDS_PER_ROUND, MVCC_VACUUM_RECORDS_PER_ROUND_DEFAULT, STORAGE);
+
+  int interval_ms       = 0;
+  int pages_per_round   = 0;
+  int records_per_round = 0;
+  if (!common::str_to_val(interval_str, interval_ms) || !common::str_to_val(pages_per_round_str, pages_per_round) ||
+      !common::str_to_val(records_per_round_str, records_per_round)) {
+    LOG_ERROR("Invalid vacuum settings. interval=%s, pages per round=%s, records per round=%s",
+              interval_str.c_str(), pages_per_round_str.c_str(), records_per_round_str.c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+
+#ifndef CONCURRENCY
+  // 没有并发控制时，后台线程和前台的请求会同时修改页面
+  interval_ms = 0;
+#endif
+
+  vacuum_ = make_unique<MvccVacuum>(*this, *mvcc_trx_kit);
+  return vacuum_->start(interval_ms, pages_per_round, records_per_round);
+}
+
 LogHandler        &Db::log_handler() { return *log_handler_; }
 BufferPoolManager &Db::buffer_pool_manager() { return *buffer_pool_manager_; }
 TrxKit            &Db::trx_kit() { return *trx_kit_; }
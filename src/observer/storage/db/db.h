@@ -24,6 +24,7 @@ See the Mulan PSL v2 for more details. */
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/clog/disk_log_handler.h"
 #include "storage/buffer/double_write_buffer.h"
+#include "storage/trx/mvcc_vacuum.h"
 #include "oblsm/include/ob_lsm.h"
 
 class Table;
@@ -106,6 +107,9 @@ public:
   /// @brief 获取当前数据库的事务管理器
   TrxKit &trx_kit();
 
+  /// @brief 清理 MVCC 删除的记录，不是 MVCC 事务或者不是 heap 存储引擎时是空指针
+  MvccVacuum *vacuum() { return vacuum_.get(); }
+
   string path() const { return path_; }
 
   oceanbase::ObLsm *lsm() { return lsm_; }
@@ -124,6 +128,12 @@ private:
   /// @brief 初始化数据库的double buffer pool
   RC init_dblwr_buffer();
 
+  /// @brief 启动后台刷脏页的线程。在恢复数据之后执行
+  RC start_page_cleaner();
+
+  /// @brief 启动清理 MVCC 删除记录的线程。在恢复数据之后执行
+  RC start_vacuum();
+
   StorageEngine get_storage_engine()
   {
     StorageEngine engine = StorageEngine::UNKNOWN_ENGINE;
@@ -146,6 +156,7 @@ private:
   unique_ptr<BufferPoolManager>  buffer_pool_manager_;  ///< 当前数据库的buffer pool管理器
   unique_ptr<LogHandler>         log_handler_;          ///< 当前数据库的日志处理器
   unique_ptr<TrxKit>             trx_kit_;              ///< 当前数据库的事务管理器
+  unique_ptr<MvccVacuum>         vacuum_;               ///< 清理 MVCC 删除的记录
   oceanbase::ObLsm              *lsm_;                  ///< 当前数据库的 LSM-Tree 存储引擎
 
   /// 给每个table都分配一个ID，用来记录日志。这里假设所有的DDL都不会并发操作，所以相关的数据都不上锁
@@ -14,9 +14,12 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "storage/index/bplus_tree.h"
-#include "common/lang/lower_bound.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/limits.h"
+#include "common/lang/thread.h"
 #include "common/log/log.h"
 #include "common/global_context.h"
+#include "common/math/simd_util.h"
 #include "sql/parser/parse_defs.h"
 #include "storage/buffer/disk_buffer_pool.h"
 
@@ -43,6 +46,242 @@ int calc_leaf_page_capacity(int attr_length)
   return capacity;
 }
 
+/**
+ * @brief 压缩格式的叶子节点在没有任何公共前缀、后缀时能放下的元素个数
+ * @details 每个元素只存储键值(包含RID)，不再单独存储RID
+ */
+int calc_compressed_leaf_page_capacity(int attr_length)
+{
+  int item_size = attr_length + sizeof(RID);
+  int capacity =
+      ((int)BP_PAGE_DATA_SIZE - LeafIndexNode::HEADER_SIZE - LeafIndexNode::COMPRESSION_HEADER_SIZE) / item_size;
+  return capacity;
+}
+
+namespace {
+
+/**
+ * @brief 两段内存在前 length 个字节中相同前缀的长度
+ */
+int common_prefix_length(const char *left, const char *right, int length)
+{
+  int i = 0;
+  while (i < length && left[i] == right[i]) {
+    i++;
+  }
+  return i;
+}
+
+/**
+ * @brief 两段内存在结尾 left_end、right_end 之前的 length 个字节中相同后缀的长度
+ */
+int common_suffix_length(const char *left_end, const char *right_end, int length)
+{
+  int i = 0;
+  while (i < length && left_end[-1 - i] == right_end[-1 - i]) {
+    i++;
+  }
+  return i;
+}
+
+/**
+ * @brief 二分查找缩小到这个范围之后，用 count_less_keys 统计剩下的键值
+ */
+template <AttrType type>
+constexpr int linear_search_size()
+{
+#if defined(USE_SIMD)
+  if (type == AttrType::INTS || type == AttrType::DATES) {
+    return SIMD_WIDTH;
+  }
+#endif
+  return 1;
+}
+
+/**
+ * @brief 统计连续 count 个键值中小于 key 的个数
+ */
+template <AttrType type>
+int count_less_keys(const char *base, int count, int item_size, int attr_length, const char *key)
+{
+  int result = 0;
+  for (int i = 0; i < count; i++) {
+    result += compare_key<type>(base + i * item_size, key, attr_length) < 0;
+  }
+  return result;
+}
+
+#if defined(USE_SIMD)
+/**
+ * @details 用 gather 一次取出8个键值的属性，超过 count 的部分不会读取。只有属性相同的键值才需要再比较RID。
+ */
+template <>
+int count_less_keys<AttrType::INTS>(const char *base, int count, int item_size, int attr_length, const char *key)
+{
+  const __m256i lanes   = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i mask    = _mm256_cmpgt_epi32(_mm256_set1_epi32(count), lanes);
+  const __m256i offsets = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(item_size));
+  const __m256i values =
+      _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int *>(base), offsets, mask, 1);
+
+  int32_t target;
+  memcpy(&target, key, sizeof(target));
+  const __m256i targets = _mm256_set1_epi32(target);
+
+  const __m256i less  = _mm256_and_si256(_mm256_cmpgt_epi32(targets, values), mask);
+  const __m256i equal = _mm256_and_si256(_mm256_cmpeq_epi32(targets, values), mask);
+
+  int result     = __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(less)));
+  int equal_mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+  while (equal_mask != 0) {
+    const int lane = __builtin_ctz(equal_mask);
+    equal_mask &= equal_mask - 1;
+    result += compare_key<AttrType::INTS>(base + lane * item_size, key, attr_length) < 0;
+  }
+  return result;
+}
+
+template <>
+int count_less_keys<AttrType::DATES>(const char *base, int count, int item_size, int attr_length, const char *key)
+{
+  return count_less_keys<AttrType::INTS>(base, count, item_size, attr_length, key);
+}
+#endif
+
+/**
+ * @brief 在节点中查找第一个不小于 key 的键值
+ * @details 每次折半只根据比较结果选择下一段的起点，没有分支跳转，编译器可以生成条件传送指令。
+ * 节点中的键值带有RID，不会重复，所以第一个不小于 key 的位置就是相同键值所在的位置。
+ */
+template <AttrType type>
+int lower_bound_key(const char *items, int size, int item_size, int attr_length, const char *key, bool *found)
+{
+  const char *base  = items;
+  int         count = size;
+  while (count > linear_search_size<type>()) {
+    const int   half   = count / 2;
+    const char *middle = base + half * item_size;
+    base               = compare_key<type>(middle, key, attr_length) < 0 ? middle : base;
+    count -= half;
+  }
+
+  const int index =
+      static_cast<int>((base - items) / item_size) + count_less_keys<type>(base, count, item_size, attr_length, key);
+  if (found) {
+    *found = index < size && compare_key<type>(items + index * item_size, key, attr_length) == 0;
+  }
+  return index;
+}
+
+/**
+ * @brief 按照字段类型实例化 visitor 中的模板函数
+ */
+template <typename Visitor>
+auto visit_attr_type(AttrType type, Visitor &&visitor)
+{
+  switch (type) {
+    case AttrType::CHARS: return visitor.template operator()<AttrType::CHARS>();
+    case AttrType::TEXT: return visitor.template operator()<AttrType::TEXT>();
+    case AttrType::INTS: return visitor.template operator()<AttrType::INTS>();
+    case AttrType::FLOATS: return visitor.template operator()<AttrType::FLOATS>();
+    case AttrType::VECTORS: return visitor.template operator()<AttrType::VECTORS>();
+    case AttrType::BOOLEANS: return visitor.template operator()<AttrType::BOOLEANS>();
+    case AttrType::DATES: return visitor.template operator()<AttrType::DATES>();
+    default: return visitor.template operator()<AttrType::UNDEFINED>();
+  }
+}
+
+}  // namespace
+
+void AttrComparator::init(AttrType type, int length) { init(vector<AttrType>{type}, vector<int>{length}); }
+
+void AttrComparator::init(const vector<AttrType> &types, const vector<int> &lengths)
+{
+  ASSERT(types.size() == lengths.size() && !types.empty(), "invalid attr types. size=%d", static_cast<int>(types.size()));
+
+  columns_.clear();
+  attr_length_ = 0;
+  for (size_t i = 0; i < types.size(); i++) {
+    Column column;
+    column.type    = types[i];
+    column.offset  = attr_length_;
+    column.length  = lengths[i];
+    column.compare = visit_attr_type(types[i], []<AttrType T>() -> CompareFunc { return &AttrCompare<T>::compare; });
+    columns_.push_back(column);
+
+    attr_length_ += lengths[i];
+  }
+}
+
+int AttrComparator::compare_columns(const char *v1, const char *v2) const
+{
+  for (const Column &column : columns_) {
+    const int result = column.compare(v1 + column.offset, v2 + column.offset, column.length);
+    if (result != 0) {
+      return result;
+    }
+  }
+  return 0;
+}
+
+void KeyComparator::init(AttrType type, int length)
+{
+  attr_comparator_.init(type, length);
+  init_funcs();
+}
+
+void KeyComparator::init(const vector<AttrType> &types, const vector<int> &lengths)
+{
+  attr_comparator_.init(types, lengths);
+  init_funcs();
+}
+
+void KeyComparator::init_funcs()
+{
+  if (attr_comparator_.attr_num() != 1) {
+    compare_func_     = nullptr;
+    lower_bound_func_ = nullptr;
+    return;
+  }
+
+  const AttrType type = attr_comparator_.attr_type();
+  compare_func_       = visit_attr_type(type, []<AttrType T>() -> CompareFunc { return &compare_key<T>; });
+  lower_bound_func_   = visit_attr_type(type, []<AttrType T>() -> LowerBoundFunc { return &lower_bound_key<T>; });
+}
+
+int KeyComparator::compare_columns(const char *v1, const char *v2) const
+{
+  const int result = attr_comparator_(v1, v2);
+  if (result != 0) {
+    return result;
+  }
+
+  const RID *rid1 = (const RID *)(v1 + attr_comparator_.attr_length());
+  const RID *rid2 = (const RID *)(v2 + attr_comparator_.attr_length());
+  return RID::compare(rid1, rid2);
+}
+
+int KeyComparator::lower_bound_columns(const char *items, int size, int item_size, const char *key, bool *found) const
+{
+  const char *base  = items;
+  int         count = size;
+  while (count > 1) {
+    const int   half   = count / 2;
+    const char *middle = base + half * item_size;
+    base               = compare_columns(middle, key) < 0 ? middle : base;
+    count -= half;
+  }
+
+  int index = static_cast<int>((base - items) / item_size);
+  if (count == 1 && compare_columns(base, key) < 0) {
+    index++;
+  }
+  if (found) {
+    *found = index < size && compare_columns(items + index * item_size, key) == 0;
+  }
+  return index;
+}
+
 /////////////////////////////////////////////////////////////////////////////////
 IndexNodeHandler::IndexNodeHandler(BplusTreeMiniTransaction &mtr, const IndexFileHeader &header, Frame *frame)
     : mtr_(mtr), header_(header), frame_(frame), node_((IndexNode *)frame->data())
@@ -69,11 +308,22 @@ int IndexNodeHandler::item_size() const { return key_size() + value_size(); }
 
 int IndexNodeHandler::size() const { return node_->key_num; }
 
-int IndexNodeHandler::max_size() const { return is_leaf() ? header_.leaf_max_size : header_.internal_max_size; }
+int IndexNodeHandler::max_size() const
+{
+  if (!is_leaf()) {
+    return header_.internal_max_size;
+  }
+
+  // 压缩的叶子节点可以放更多的元素，但是分裂后的两个节点再插入一个元素，一定要能放得下，
+  // 所以最多只能是不压缩时的两倍
+  return header_.leaf_compressed ? std::max(header_.leaf_max_size, 2 * header_.leaf_max_size - 2)
+                                 : header_.leaf_max_size;
+}
 
 int IndexNodeHandler::min_size() const
 {
-  const int max = this->max_size();
+  // 压缩的叶子节点只有不超过 leaf_max_size 个元素时才一定能放得下，最小值也按照它来算
+  const int max = (is_leaf() && header_.leaf_compressed) ? header_.leaf_max_size : this->max_size();
   return max - max / 2;
 }
 
@@ -104,6 +354,10 @@ bool IndexNodeHandler::is_safe(BplusTreeOperationType op, bool is_root_node)
       return true;
     } break;
     case BplusTreeOperationType::INSERT: {
+      if (node_->is_leaf && header_.leaf_compressed) {
+        // 插入的键值可能会让前缀变短，只有元素个数不超过不压缩时的容量，才一定不会分裂
+        return size() < header_.leaf_max_size;
+      }
       return size() < max_size();
     } break;
     case BplusTreeOperationType::DELETE: {
@@ -191,6 +445,9 @@ RC LeafIndexNodeHandler::init_empty()
   }
   IndexNodeHandler::init_empty(true /*leaf*/);
   leaf_node_->next_brother = BP_INVALID_PAGE_NUM;
+  if (compressed()) {
+    encode_items(nullptr, 0, 0, 0);
+  }
   return RC::SUCCESS;
 }
 
@@ -211,22 +468,57 @@ PageNum LeafIndexNodeHandler::next_page() const { return leaf_node_->next_brothe
 char *LeafIndexNodeHandler::key_at(int index)
 {
   assert(index >= 0 && index < size());
-  return __key_at(index);
+  if (!compressed()) {
+    return __key_at(index);
+  }
+
+  key_buffer_.resize(key_size());
+  decode_key(index, key_buffer_.data());
+  return key_buffer_.data();
 }
 
 char *LeafIndexNodeHandler::value_at(int index)
 {
   assert(index >= 0 && index < size());
-  return __value_at(index);
+  if (!compressed()) {
+    return __value_at(index);
+  }
+
+  // 压缩格式不单独存储RID，键值的最后一部分就是RID
+  return key_at(index) + header_.attr_length;
 }
 
 int LeafIndexNodeHandler::lookup(const KeyComparator &comparator, const char *key, bool *found /* = nullptr */) const
 {
-  const int                    size = this->size();
-  common::BinaryIterator<char> iter_begin(item_size(), __key_at(0));
-  common::BinaryIterator<char> iter_end(item_size(), __key_at(size));
-  common::BinaryIterator<char> iter = lower_bound(iter_begin, iter_end, key, comparator, found);
-  return iter - iter_begin;
+  if (!compressed()) {
+    return comparator.lower_bound(__key_at(0), size(), item_size(), key, found);
+  }
+
+  // 前缀和后缀只需要拷贝一次，每次比较前只拷贝元素中存储的部分
+  key_buffer_.resize(key_size());
+  char *buffer = key_buffer_.data();
+  decode_key(0, buffer);
+
+  int left  = 0;
+  int right = size();
+  while (left < right) {
+    const int middle = left + (right - left) / 2;
+    copy_slot_to_key(slot_at(middle), buffer);
+    if (comparator(buffer, key) < 0) {
+      left = middle + 1;
+    } else {
+      right = middle;
+    }
+  }
+
+  if (found) {
+    *found = false;
+    if (left < size()) {
+      copy_slot_to_key(slot_at(left), buffer);
+      *found = comparator(buffer, key) == 0;
+    }
+  }
+  return left;
 }
 
 RC LeafIndexNodeHandler::insert(int index, const char *key, const char *value)
@@ -249,7 +541,8 @@ RC LeafIndexNodeHandler::remove(int index)
 {
   assert(index >= 0 && index < size());
 
-  RC rc = mtr_.logger().node_remove_items(*this, index, span<const char>(__item_at(index), item_size()), 1);
+  vector<char> buffer;
+  RC rc = mtr_.logger().node_remove_items(*this, index, span<const char>(items_at(index, 1, buffer), item_size()), 1);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to log remove item. rc=%s", strrc(rc));
     return rc;
@@ -276,11 +569,13 @@ RC LeafIndexNodeHandler::move_half_to(LeafIndexNodeHandler &other)
   const int move_index    = size / 2;
   const int move_item_num = size - move_index;
 
-  other.append(__item_at(move_index), move_item_num);
+  vector<char> buffer;
+  const char  *items = items_at(move_index, move_item_num, buffer);
+  other.append(items, move_item_num);
 
   RC rc = mtr_.logger().node_remove_items(*this,
       move_index,
-      span<const char>(__item_at(move_index), static_cast<size_t>(move_item_num) * item_size()),
+      span<const char>(items, static_cast<size_t>(move_item_num) * item_size()),
       move_item_num);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to log shrink leaf node. rc=%s", strrc(rc));
@@ -292,14 +587,16 @@ RC LeafIndexNodeHandler::move_half_to(LeafIndexNodeHandler &other)
 }
 RC LeafIndexNodeHandler::move_first_to_end(LeafIndexNodeHandler &other)
 {
-  other.append(__item_at(0));
+  vector<char> buffer;
+  other.append(items_at(0, 1, buffer));
 
   return this->remove(0);
 }
 
 RC LeafIndexNodeHandler::move_last_to_front(LeafIndexNodeHandler &other)
 {
-  other.preappend(__item_at(size() - 1));
+  vector<char> buffer;
+  other.preappend(items_at(size() - 1, 1, buffer));
 
   this->remove(size() - 1);
   return RC::SUCCESS;
@@ -309,12 +606,14 @@ RC LeafIndexNodeHandler::move_last_to_front(LeafIndexNodeHandler &other)
  */
 RC LeafIndexNodeHandler::move_to(LeafIndexNodeHandler &other)
 {
-  other.append(__item_at(0), this->size());
+  vector<char> buffer;
+  const char  *items = items_at(0, this->size(), buffer);
+  other.append(items, this->size());
   other.set_next_page(this->next_page());
 
   RC rc = mtr_.logger().node_remove_items(*this,
       0,
-      span<const char>(__item_at(0), static_cast<size_t>(this->size()) * static_cast<size_t>(item_size())),
+      span<const char>(items, static_cast<size_t>(this->size()) * static_cast<size_t>(item_size())),
       this->size());
 
   if (OB_FAIL(rc)) {
@@ -344,13 +643,260 @@ RC LeafIndexNodeHandler::preappend(const char *item) { return insert(0, item, it
 
 char *LeafIndexNodeHandler::__item_at(int index) const { return leaf_node_->array + (index * item_size()); }
 
+const char *LeafIndexNodeHandler::items_at(int index, int num, vector<char> &buffer) const
+{
+  if (!compressed()) {
+    return __item_at(index);
+  }
+
+  const int item_size = this->item_size();
+  buffer.resize(static_cast<size_t>(num) * item_size);
+  for (int i = 0; i < num; i++) {
+    char *item = buffer.data() + static_cast<size_t>(i) * item_size;
+    decode_key(index + i, item);
+    memcpy(item + key_size(), item + header_.attr_length, sizeof(RID));
+  }
+  return buffer.data();
+}
+
+const char *LeafIndexNodeHandler::decode_key(int index, char *buffer) const
+{
+  if (!compressed()) {
+    return __key_at(index);
+  }
+
+  memcpy(buffer, prefix(), prefix_length());
+  memcpy(buffer + header_.attr_length - suffix_length(), suffix(), suffix_length());
+  if (index < size()) {
+    copy_slot_to_key(slot_at(index), buffer);
+  }
+  return buffer;
+}
+
+int LeafIndexNodeHandler::prefix_length() const
+{
+  return compressed() ? reinterpret_cast<const int16_t *>(leaf_node_->array)[0] : 0;
+}
+
+int LeafIndexNodeHandler::suffix_length() const
+{
+  return compressed() ? reinterpret_cast<const int16_t *>(leaf_node_->array)[1] : 0;
+}
+
+char *LeafIndexNodeHandler::prefix() const { return leaf_node_->array + LeafIndexNode::COMPRESSION_HEADER_SIZE; }
+
+char *LeafIndexNodeHandler::suffix() const { return prefix() + prefix_length(); }
+
+char *LeafIndexNodeHandler::slot_at(int index) const
+{
+  return suffix() + suffix_length() + static_cast<size_t>(index) * slot_size();
+}
+
+/**
+ * 元素中存储的是键值去掉前缀和后缀之后剩下的两段：用户键值中间的部分，以及RID(前缀可能会覆盖RID的一部分)。
+ * 有后缀时，前缀不会超过用户键值去掉后缀的部分。
+ */
+void LeafIndexNodeHandler::copy_slot_to_key(const char *slot, char *key) const
+{
+  const int prefix_length = this->prefix_length();
+  const int head_length   = std::max(0, header_.attr_length - suffix_length() - prefix_length);
+  const int tail_start    = std::max(prefix_length, header_.attr_length);
+
+  memcpy(key + prefix_length, slot, head_length);
+  memcpy(key + tail_start, slot + head_length, key_size() - tail_start);
+}
+
+void LeafIndexNodeHandler::copy_key_to_slot(const char *key, char *slot) const
+{
+  const int prefix_length = this->prefix_length();
+  const int head_length   = std::max(0, header_.attr_length - suffix_length() - prefix_length);
+  const int tail_start    = std::max(prefix_length, header_.attr_length);
+
+  memcpy(slot, key + prefix_length, head_length);
+  memcpy(slot + head_length, key + tail_start, key_size() - tail_start);
+}
+
+int LeafIndexNodeHandler::compressed_bytes(int num, int key_size, int prefix_length, int suffix_length)
+{
+  return LeafIndexNode::HEADER_SIZE + LeafIndexNode::COMPRESSION_HEADER_SIZE + prefix_length + suffix_length +
+         num * (key_size - prefix_length - suffix_length);
+}
+
+int LeafIndexNodeHandler::used_bytes() const
+{
+  if (compressed()) {
+    return compressed_bytes(size(), key_size(), prefix_length(), suffix_length());
+  }
+  return LeafIndexNode::HEADER_SIZE + size() * item_size();
+}
+
+bool LeafIndexNodeHandler::can_insert(const char *key) const
+{
+  if (size() >= max_size()) {
+    return false;
+  }
+  if (!compressed() || size() == 0) {
+    return true;
+  }
+
+  // 插入之后前缀、后缀只会变短。真正插入时会重新计算，得到的结果不会比这里差
+  const int attr_length   = header_.attr_length;
+  const int prefix_length = common_prefix_length(prefix(), key, this->prefix_length());
+  const int suffix_length =
+      common_suffix_length(suffix() + this->suffix_length(), key + attr_length, this->suffix_length());
+  return compressed_bytes(size() + 1, key_size(), prefix_length, suffix_length) <= static_cast<int>(BP_PAGE_DATA_SIZE);
+}
+
+bool LeafIndexNodeHandler::can_merge_with(const LeafIndexNodeHandler &other) const
+{
+  const int num = size() + other.size();
+  if (num > max_size()) {
+    return false;
+  }
+  if (!compressed()) {
+    return true;
+  }
+
+  int prefix_length = 0;
+  int suffix_length = 0;
+  if (size() == 0) {
+    prefix_length = other.prefix_length();
+    suffix_length = other.suffix_length();
+  } else if (other.size() == 0) {
+    prefix_length = this->prefix_length();
+    suffix_length = this->suffix_length();
+  } else {
+    prefix_length =
+        common_prefix_length(prefix(), other.prefix(), std::min(this->prefix_length(), other.prefix_length()));
+    suffix_length = common_suffix_length(suffix() + this->suffix_length(),
+        other.suffix() + other.suffix_length(),
+        std::min(this->suffix_length(), other.suffix_length()));
+  }
+  return compressed_bytes(num, key_size(), prefix_length, suffix_length) <= static_cast<int>(BP_PAGE_DATA_SIZE);
+}
+
+void LeafIndexNodeHandler::compression_bounds(const char *items, int num, int &prefix_length, int &suffix_length) const
+{
+  const int item_size   = this->item_size();
+  const int attr_length = header_.attr_length;
+
+  prefix_length = key_size();
+  suffix_length = attr_length;
+  for (int i = 1; i < num; i++) {
+    const char *item = items + static_cast<size_t>(i) * item_size;
+    prefix_length    = common_prefix_length(items, item, prefix_length);
+    suffix_length    = common_suffix_length(items + attr_length, item + attr_length, suffix_length);
+  }
+
+  // 前缀和后缀不能重叠。优先保留前缀，前缀覆盖到RID的时候就没有后缀了
+  suffix_length = std::max(0, std::min(suffix_length, attr_length - prefix_length));
+}
+
+void LeafIndexNodeHandler::encode_items(const char *items, int num, int prefix_length, int suffix_length)
+{
+  const int item_size   = this->item_size();
+  const int attr_length = header_.attr_length;
+
+  int16_t *lengths = reinterpret_cast<int16_t *>(leaf_node_->array);
+  lengths[0]       = static_cast<int16_t>(num > 0 ? prefix_length : 0);
+  lengths[1]       = static_cast<int16_t>(num > 0 ? suffix_length : 0);
+  if (num > 0) {
+    memcpy(prefix(), items, prefix_length);
+    memcpy(suffix(), items + attr_length - suffix_length, suffix_length);
+  }
+
+  for (int i = 0; i < num; i++) {
+    copy_key_to_slot(items + static_cast<size_t>(i) * item_size, slot_at(i));
+  }
+  node_->key_num = num;
+}
+
+RC LeafIndexNodeHandler::recover_insert_items(int index, const char *items, int num)
+{
+  if (!compressed()) {
+    return IndexNodeHandler::recover_insert_items(index, items, num);
+  }
+
+  const int item_size   = this->item_size();
+  const int attr_length = header_.attr_length;
+  const int old_size    = size();
+
+  bool keep_bounds = old_size > 0;
+  for (int i = 0; keep_bounds && i < num; i++) {
+    const char *item = items + static_cast<size_t>(i) * item_size;
+    keep_bounds =
+        common_prefix_length(prefix(), item, prefix_length()) == prefix_length() &&
+        common_suffix_length(suffix() + suffix_length(), item + attr_length, suffix_length()) == suffix_length();
+  }
+
+  if (keep_bounds) {
+    // 前缀和后缀都没有变化，与不压缩的格式一样，移动后面的元素就可以了
+    const int slot_size = this->slot_size();
+    if (index < old_size) {
+      memmove(slot_at(index + num), slot_at(index), static_cast<size_t>(old_size - index) * slot_size);
+    }
+    increase_size(num);
+
+    for (int i = 0; i < num; i++) {
+      copy_key_to_slot(items + static_cast<size_t>(i) * item_size, slot_at(index + i));
+    }
+  } else {
+    // 前缀或后缀变了，所有元素的大小都会变化，整个页面重新编码
+    vector<char> all_items(static_cast<size_t>(old_size + num) * item_size);
+    vector<char> buffer;
+    if (index > 0) {
+      memcpy(all_items.data(), items_at(0, index, buffer), static_cast<size_t>(index) * item_size);
+    }
+    memcpy(all_items.data() + static_cast<size_t>(index) * item_size, items, static_cast<size_t>(num) * item_size);
+    if (index < old_size) {
+      memcpy(all_items.data() + static_cast<size_t>(index + num) * item_size,
+          items_at(index, old_size - index, buffer),
+          static_cast<size_t>(old_size - index) * item_size);
+    }
+
+    int prefix_length = 0;
+    int suffix_length = 0;
+    compression_bounds(all_items.data(), old_size + num, prefix_length, suffix_length);
+    encode_items(all_items.data(), old_size + num, prefix_length, suffix_length);
+  }
+
+  ASSERT(used_bytes() <= static_cast<int>(BP_PAGE_DATA_SIZE),
+         "compressed leaf page overflow. page num=%d, size=%d, prefix length=%d, suffix length=%d",
+         page_num(), size(), prefix_length(), suffix_length());
+  return RC::SUCCESS;
+}
+
+RC LeafIndexNodeHandler::recover_remove_items(int index, int num)
+{
+  if (!compressed()) {
+    return IndexNodeHandler::recover_remove_items(index, num);
+  }
+
+  // 删除元素不会让前缀、后缀变短，保留原来的前缀和后缀
+  const int slot_size = this->slot_size();
+  if (index < size() - num) {
+    memmove(slot_at(index), slot_at(index + num), static_cast<size_t>(size() - index - num) * slot_size);
+  }
+
+  increase_size(-num);
+  if (size() == 0) {
+    encode_items(nullptr, 0, 0, 0);
+  }
+  return RC::SUCCESS;
+}
+
 string to_string(const LeafIndexNodeHandler &handler, const KeyPrinter &printer)
 {
+  vector<char> key(handler.key_size());
+
   stringstream ss;
   ss << to_string((const IndexNodeHandler &)handler) << ",next page:" << handler.next_page();
-  ss << ",values=[" << printer(handler.__key_at(0));
+  if (handler.compressed()) {
+    ss << ",prefix length:" << handler.prefix_length() << ",suffix length:" << handler.suffix_length();
+  }
+  ss << ",values=[" << printer(handler.decode_key(0, key.data()));
   for (int i = 1; i < handler.size(); i++) {
-    ss << "," << printer(handler.__key_at(i));
+    ss << "," << printer(handler.decode_key(i, key.data()));
   }
   ss << "]";
   return ss.str();
@@ -363,9 +909,20 @@ bool LeafIndexNodeHandler::validate(const KeyComparator &comparator, DiskBufferP
     return false;
   }
 
+  if (compressed() && (prefix_length() < 0 || prefix_length() > key_size() || suffix_length() < 0 ||
+                          (suffix_length() > 0 && prefix_length() + suffix_length() > header_.attr_length) ||
+                          size() > max_size() || used_bytes() > static_cast<int>(BP_PAGE_DATA_SIZE))) {
+    LOG_WARN("invalid compressed leaf node. page num=%d, size=%d, prefix length=%d, suffix length=%d, used bytes=%d",
+             page_num(), size(), prefix_length(), suffix_length(), used_bytes());
+    return false;
+  }
+
+  vector<char> prev_key(key_size());
+  vector<char> key(key_size());
+
   const int node_size = size();
   for (int i = 1; i < node_size; i++) {
-    if (comparator(__key_at(i - 1), __key_at(i)) >= 0) {
+    if (comparator(decode_key(i - 1, prev_key.data()), decode_key(i, key.data())) >= 0) {
       LOG_WARN("page number = %d, invalid key order. id1=%d,id2=%d, this=%s",
                page_num(), i - 1, i, to_string(*this).c_str());
       return false;
@@ -394,7 +951,7 @@ bool LeafIndexNodeHandler::validate(const KeyComparator &comparator, DiskBufferP
   }
 
   if (0 != index_in_parent) {
-    int cmp_result = comparator(__key_at(0), parent_node.key_at(index_in_parent));
+    int cmp_result = comparator(decode_key(0, key.data()), parent_node.key_at(index_in_parent));
     if (cmp_result < 0) {
       LOG_WARN("invalid leaf node. first item should be greate than or equal to parent item. "
                "this page num=%d, parent page num=%d, index in parent=%d",
@@ -405,7 +962,7 @@ bool LeafIndexNodeHandler::validate(const KeyComparator &comparator, DiskBufferP
   }
 
   if (index_in_parent < parent_node.size() - 1) {
-    int cmp_result = comparator(__key_at(size() - 1), parent_node.key_at(index_in_parent + 1));
+    int cmp_result = comparator(decode_key(size() - 1, key.data()), parent_node.key_at(index_in_parent + 1));
     if (cmp_result >= 0) {
       LOG_WARN("invalid leaf node. last item should be less than the item at the first after item in parent."
                "this page num=%d, parent page num=%d, parent item to compare=%d",
@@ -525,10 +1082,7 @@ int InternalIndexNodeHandler::lookup(const KeyComparator &comparator, const char
     return 0;
   }
 
-  common::BinaryIterator<char> iter_begin(item_size(), __key_at(1));
-  common::BinaryIterator<char> iter_end(item_size(), __key_at(size));
-  common::BinaryIterator<char> iter = lower_bound(iter_begin, iter_end, key, comparator, found);
-  int                          ret  = static_cast<int>(iter - iter_begin) + 1;
+  int ret = comparator.lower_bound(__key_at(1), size - 1, item_size(), key, found) + 1;
   if (insert_position) {
     *insert_position = ret;
   }
@@ -539,6 +1093,25 @@ int InternalIndexNodeHandler::lookup(const KeyComparator &comparator, const char
   return ret;
 }
 
+PageNum InternalIndexNodeHandler::optimistic_child_page(const KeyComparator &comparator, const char *key) const
+{
+  // 只读取一次元素个数，并限制在合法范围内，即使读到了修改了一半的页面，也不会越界访问
+  const int key_num = std::atomic_ref<int>(internal_node_->key_num).load(std::memory_order_relaxed);
+  const int size    = std::clamp(key_num, 0, header_.internal_max_size);
+
+  int index = 0;
+  if (key != nullptr && size > 1) {
+    index = comparator.lower_bound(__key_at(1), size - 1, item_size(), key, nullptr) + 1;
+    if (index >= size || comparator(key, __key_at(index)) < 0) {
+      index--;
+    }
+  }
+
+  PageNum page_num = BP_INVALID_PAGE_NUM;
+  memcpy(&page_num, __value_at(index), sizeof(page_num));
+  return page_num;
+}
+
 char *InternalIndexNodeHandler::key_at(int index)
 {
   assert(index >= 0 && index < size());
@@ -790,7 +1363,22 @@ RC BplusTreeHandler::sync()
 }
 
 RC BplusTreeHandler::create(LogHandler &log_handler, BufferPoolManager &bpm, const char *file_name, AttrType attr_type,
-    int attr_length, int internal_max_size /* = -1*/, int leaf_max_size /* = -1 */)
+    int attr_length, int internal_max_size /* = -1*/, int leaf_max_size /* = -1 */, bool leaf_compressed /* = false */)
+{
+  return this->create(log_handler, bpm, file_name, vector<AttrType>{attr_type}, vector<int>{attr_length},
+      internal_max_size, leaf_max_size, leaf_compressed);
+}
+
+RC BplusTreeHandler::create(LogHandler &log_handler, DiskBufferPool &buffer_pool, AttrType attr_type, int attr_length,
+    int internal_max_size /* = -1 */, int leaf_max_size /* = -1 */, bool leaf_compressed /* = false */)
+{
+  return this->create(log_handler, buffer_pool, vector<AttrType>{attr_type}, vector<int>{attr_length},
+      internal_max_size, leaf_max_size, leaf_compressed);
+}
+
+RC BplusTreeHandler::create(LogHandler &log_handler, BufferPoolManager &bpm, const char *file_name,
+    const vector<AttrType> &attr_types, const vector<int> &attr_lengths, int internal_max_size /* = -1*/,
+    int leaf_max_size /* = -1 */, bool leaf_compressed /* = false */)
 {
   RC rc = bpm.create_file(file_name);
   if (OB_FAIL(rc)) {
@@ -808,7 +1396,7 @@ RC BplusTreeHandler::create(LogHandler &log_handler, BufferPoolManager &bpm, con
   }
   LOG_INFO("Successfully open index file %s.", file_name);
 
-  rc = this->create(log_handler, *bp, attr_type, attr_length, internal_max_size, leaf_max_size);
+  rc = this->create(log_handler, *bp, attr_types, attr_lengths, internal_max_size, leaf_max_size, leaf_compressed);
   if (OB_FAIL(rc)) {
     bpm.close_file(file_name);
     return rc;
@@ -818,14 +1406,27 @@ RC BplusTreeHandler::create(LogHandler &log_handler, BufferPoolManager &bpm, con
   return rc;
 }
 
-RC BplusTreeHandler::create(LogHandler &log_handler, DiskBufferPool &buffer_pool, AttrType attr_type, int attr_length,
-    int internal_max_size /* = -1 */, int leaf_max_size /* = -1 */)
+RC BplusTreeHandler::create(LogHandler &log_handler, DiskBufferPool &buffer_pool, const vector<AttrType> &attr_types,
+    const vector<int> &attr_lengths, int internal_max_size /* = -1 */, int leaf_max_size /* = -1 */,
+    bool leaf_compressed /* = false */)
 {
+  const int attr_num = static_cast<int>(attr_types.size());
+  if (attr_num <= 0 || attr_num > IndexFileHeader::MAX_ATTR_NUM || attr_lengths.size() != attr_types.size()) {
+    LOG_WARN("invalid index attributes. attr num=%d, attr length num=%d", attr_num, static_cast<int>(attr_lengths.size()));
+    return RC::INVALID_ARGUMENT;
+  }
+
+  int attr_length = 0;
+  for (int length : attr_lengths) {
+    attr_length += length;
+  }
+
   if (internal_max_size < 0) {
     internal_max_size = calc_internal_page_capacity(attr_length);
   }
   if (leaf_max_size < 0) {
-    leaf_max_size = calc_leaf_page_capacity(attr_length);
+    leaf_max_size =
+        leaf_compressed ? calc_compressed_leaf_page_capacity(attr_length) : calc_leaf_page_capacity(attr_length);
   }
 
   log_handler_      = &log_handler;
@@ -853,10 +1454,16 @@ RC BplusTreeHandler::create(LogHandler &log_handler, DiskBufferPool &buffer_pool
   IndexFileHeader *file_header   = (IndexFileHeader *)pdata;
   file_header->attr_length       = attr_length;
   file_header->key_length        = attr_length + sizeof(RID);
-  file_header->attr_type         = attr_type;
+  file_header->attr_type         = attr_types.front();
+  file_header->attr_num          = attr_num;
   file_header->internal_max_size = internal_max_size;
   file_header->leaf_max_size     = leaf_max_size;
+  file_header->leaf_compressed   = leaf_compressed ? 1 : 0;
   file_header->root_page         = BP_INVALID_PAGE_NUM;
+  for (int i = 0; i < attr_num; i++) {
+    file_header->attr_types[i]   = attr_types[i];
+    file_header->attr_lengths[i] = attr_lengths[i];
+  }
 
   // 取消记录日志的原因请参考下面的sync调用的地方。
   // mtr.logger().init_header_page(header_frame, *file_header);
@@ -873,8 +1480,7 @@ RC BplusTreeHandler::create(LogHandler &log_handler, DiskBufferPool &buffer_pool
     return RC::NOMEM;
   }
 
-  key_comparator_.init(file_header->attr_type, file_header->attr_length);
-  key_printer_.init(file_header->attr_type, file_header->attr_length);
+  init_key_helpers();
 
   /*
   虽然我们针对B+树记录了WAL，但是我们记录的都是逻辑日志，并没有记录某个页面如何修改的物理日志。
@@ -945,12 +1551,19 @@ RC BplusTreeHandler::open(LogHandler &log_handler, DiskBufferPool &buffer_pool)
   // close old page_handle
   buffer_pool.unpin_page(frame);
 
-  key_comparator_.init(file_header_.attr_type, file_header_.attr_length);
-  key_printer_.init(file_header_.attr_type, file_header_.attr_length);
+  init_key_helpers();
   LOG_INFO("Successfully open index");
   return RC::SUCCESS;
 }
 
+void BplusTreeHandler::init_key_helpers()
+{
+  const vector<AttrType> attr_types   = file_header_.attr_type_list();
+  const vector<int>      attr_lengths = file_header_.attr_length_list();
+  key_comparator_.init(attr_types, attr_lengths);
+  key_printer_.init(attr_types, attr_lengths);
+}
+
 RC BplusTreeHandler::close()
 {
   if (disk_buffer_pool_ != nullptr) {
@@ -1035,9 +1648,93 @@ RC BplusTreeHandler::print_tree()
   } else {
     rc = print_internal_node_recursive(frame);
   }
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  BplusTreeStats tree_stats;
+  rc = stats(tree_stats);
+  if (OB_SUCC(rc)) {
+    LOG_INFO("bplus tree stats: %s", tree_stats.to_string().c_str());
+  }
   return rc;
 }
 
+RC BplusTreeHandler::stats(BplusTreeStats &stats)
+{
+  stats = BplusTreeStats();
+  if (disk_buffer_pool_ == nullptr || is_empty()) {
+    return RC::SUCCESS;
+  }
+
+  BplusTreeMiniTransaction mtr(*this);
+  return stats_recursive(mtr, file_header_.root_page, 1 /*depth*/, stats);
+}
+
+RC BplusTreeHandler::stats_recursive(BplusTreeMiniTransaction &mtr, PageNum page_num, int depth, BplusTreeStats &stats)
+{
+  Frame *frame = nullptr;
+  RC     rc    = disk_buffer_pool_->get_this_page(page_num, &frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to fetch page. page id=%d, rc=%d:%s", page_num, rc, strrc(rc));
+    return rc;
+  }
+
+  stats.height = std::max(stats.height, depth);
+
+  IndexNodeHandler node(mtr, file_header_, frame);
+  if (node.is_leaf()) {
+    LeafIndexNodeHandler leaf_node(mtr, file_header_, frame);
+    stats.leaf_node_num++;
+    stats.entry_num += leaf_node.size();
+    stats.leaf_used_bytes += leaf_node.used_bytes();
+    disk_buffer_pool_->unpin_page(frame);
+    return RC::SUCCESS;
+  }
+
+  InternalIndexNodeHandler internal_node(mtr, file_header_, frame);
+  stats.internal_node_num++;
+  stats.internal_item_num += internal_node.size();
+
+  vector<PageNum> children;
+  for (int i = 0; i < internal_node.size(); i++) {
+    children.push_back(internal_node.value_at(i));
+  }
+  disk_buffer_pool_->unpin_page(frame);
+
+  for (PageNum child : children) {
+    rc = stats_recursive(mtr, child, depth + 1, stats);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+double BplusTreeStats::internal_fanout() const
+{
+  return internal_node_num == 0 ? 0.0 : static_cast<double>(internal_item_num) / internal_node_num;
+}
+
+double BplusTreeStats::leaf_fanout() const
+{
+  return leaf_node_num == 0 ? 0.0 : static_cast<double>(entry_num) / leaf_node_num;
+}
+
+double BplusTreeStats::leaf_fill_ratio() const
+{
+  return leaf_node_num == 0 ? 0.0 : static_cast<double>(leaf_used_bytes) / (leaf_node_num * BP_PAGE_DATA_SIZE);
+}
+
+string BplusTreeStats::to_string() const
+{
+  stringstream ss;
+  ss << "height:" << height << ",internal nodes:" << internal_node_num << ",leaf nodes:" << leaf_node_num
+     << ",entries:" << entry_num << ",internal fanout:" << internal_fanout() << ",leaf fanout:" << leaf_fanout()
+     << ",leaf fill ratio:" << leaf_fill_ratio();
+  return ss.str();
+}
+
 RC BplusTreeHandler::print_leafs()
 {
   if (is_empty()) {
@@ -1174,6 +1871,13 @@ bool BplusTreeHandler::is_empty() const { return file_header_.root_page == BP_IN
 
 RC BplusTreeHandler::find_leaf(BplusTreeMiniTransaction &mtr, BplusTreeOperationType op, const char *key, Frame *&frame)
 {
+  if (op == BplusTreeOperationType::READ && optimistic_read_) {
+    RC rc = optimistic_find_leaf(mtr, key, frame);
+    if (rc == RC::SUCCESS || rc == RC::EMPTY) {
+      return rc;
+    }
+  }
+
   auto child_page_getter = [this, key](InternalIndexNodeHandler &internal_node) {
     return internal_node.value_at(internal_node.lookup(key_comparator_, key));
   };
@@ -1182,6 +1886,13 @@ RC BplusTreeHandler::find_leaf(BplusTreeMiniTransaction &mtr, BplusTreeOperation
 
 RC BplusTreeHandler::left_most_page(BplusTreeMiniTransaction &mtr, Frame *&frame)
 {
+  if (optimistic_read_) {
+    RC rc = optimistic_find_leaf(mtr, nullptr /*key*/, frame);
+    if (rc == RC::SUCCESS || rc == RC::EMPTY) {
+      return rc;
+    }
+  }
+
   auto child_page_getter = [](InternalIndexNodeHandler &internal_node) { return internal_node.value_at(0); };
   return find_leaf_internal(mtr, BplusTreeOperationType::READ, child_page_getter, frame);
 }
@@ -1224,6 +1935,96 @@ RC BplusTreeHandler::find_leaf_internal(BplusTreeMiniTransaction &mtr, BplusTree
   return RC::SUCCESS;
 }
 
+RC BplusTreeHandler::optimistic_find_leaf(BplusTreeMiniTransaction &mtr, const char *key, Frame *&frame)
+{
+  // 写操作频繁时乐观读可能一直失败，重试几次之后就改用 crabing protocol
+  static constexpr int MAX_RETRY_TIMES = 8;
+
+  LatchMemo &latch_memo = mtr.latch_memo();
+  const int  memo_point = latch_memo.memo_point();
+
+  RC rc = RC::SUCCESS;
+  for (int i = 0; i < MAX_RETRY_TIMES; i++) {
+    rc = optimistic_find_leaf_once(mtr, key, frame);
+    if (rc == RC::SUCCESS || rc == RC::EMPTY) {
+      return rc;
+    }
+
+    latch_memo.release_from(memo_point);
+    frame = nullptr;
+    if (rc != RC::LOCKED_NEED_WAIT) {
+      // 可能读到了已经释放的页面，交给 crabing protocol 处理
+      LOG_TRACE("optimistic read failed. rc=%s", strrc(rc));
+      return rc;
+    }
+
+    this_thread::yield();
+  }
+  return rc;
+}
+
+RC BplusTreeHandler::optimistic_find_leaf_once(BplusTreeMiniTransaction &mtr, const char *key, Frame *&frame)
+{
+  LatchMemo &latch_memo = mtr.latch_memo();
+  const int  memo_point = latch_memo.memo_point();
+
+  const uint64_t root_version = root_version_.load();
+  const PageNum  root_page    = std::atomic_ref<PageNum>(file_header_.root_page).load();
+  if (root_page == BP_INVALID_PAGE_NUM) {
+    return RC::EMPTY;
+  }
+
+  RC rc = latch_memo.get_page(root_page, frame);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  // 拿到页帧版本号时，这个页面依然是根节点，之后根节点再有变化，一定会修改这个页面
+  uint64_t version = frame->read_version();
+  if (root_version_.load() != root_version) {
+    return RC::LOCKED_NEED_WAIT;
+  }
+
+  Frame   *parent_frame   = nullptr;
+  uint64_t parent_version = 0;
+  while (!std::atomic_ref<bool>(reinterpret_cast<IndexNode *>(frame->data())->is_leaf).load(std::memory_order_relaxed)) {
+    InternalIndexNodeHandler internal_node(mtr, file_header_, frame);
+    const PageNum            child_page_num = internal_node.optimistic_child_page(key_comparator_, key);
+    // 先校验再使用读到的页面编号，避免访问一个随机的页面
+    if (!frame->validate_version(version)) {
+      return RC::LOCKED_NEED_WAIT;
+    }
+
+    // 经过的页面都保持pin住，否则页帧可能被淘汰后复用，版本号就没有意义了
+    parent_frame   = frame;
+    parent_version = version;
+
+    rc = latch_memo.get_page(child_page_num, frame);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    // 父节点没有变化，说明拿到版本号时，这个页面依然是父节点的子节点
+    version = frame->read_version();
+    if (!parent_frame->validate_version(parent_version)) {
+      return RC::LOCKED_NEED_WAIT;
+    }
+  }
+
+  // 叶子节点需要加锁，扫描时会一直持有叶子节点的锁
+  // 父节点没有变化，说明叶子节点没有分裂或合并，依然是我们要找的叶子节点
+  latch_memo.slatch(frame);
+  const bool valid = (parent_frame != nullptr) ? parent_frame->validate_version(parent_version)
+                                               : root_version_.load() == root_version;
+  if (!valid || !reinterpret_cast<IndexNode *>(frame->data())->is_leaf) {
+    return RC::LOCKED_NEED_WAIT;
+  }
+
+  // 只释放这次查找经过的内部节点的pin，保留叶子节点的pin和读锁，调用者之前加的锁不受影响
+  latch_memo.release_range(memo_point, latch_memo.memo_point() - 2);
+  return RC::SUCCESS;
+}
+
 RC BplusTreeHandler::crabing_protocal_fetch_page(
     BplusTreeMiniTransaction &mtr, BplusTreeOperationType op, PageNum page_num, bool is_root_node, Frame *&frame)
 {
@@ -1257,7 +2058,7 @@ RC BplusTreeHandler::insert_entry_into_leaf_node(
     return RC::RECORD_DUPLICATE_KEY;
   }
 
-  if (leaf_node.size() < leaf_node.max_size()) {
+  if (leaf_node.can_insert(key)) {
     leaf_node.insert(insert_position, key, (const char *)rid);
     frame->mark_dirty();
     // disk_buffer_pool_->unpin_page(frame); // unpin pages 由latch memo 来操作
@@ -1427,8 +2228,7 @@ RC BplusTreeHandler::recover_init_header_page(
   header_dirty_ = false;
   frame->mark_dirty();
 
-  key_comparator_.init(file_header_.attr_type, file_header_.attr_length);
-  key_printer_.init(file_header_.attr_type, file_header_.attr_length);
+  init_key_helpers();
 
   return RC::SUCCESS;
 }
@@ -1441,7 +2241,9 @@ void BplusTreeHandler::update_root_page_num_locked(BplusTreeMiniTransaction &mtr
   IndexFileHeader *file_header = reinterpret_cast<IndexFileHeader *>(frame->data());
   mtr.logger().update_root_page(frame, root_page_num, file_header->root_page);
   file_header->root_page = root_page_num;
-  file_header_.root_page = root_page_num;
+  // 乐观读不加 root_lock_，先修改版本号，读者看到新的根节点时，一定也能看到版本号的变化
+  root_version_.fetch_add(1);
+  std::atomic_ref<PageNum>(file_header_.root_page).store(root_page_num);
   header_dirty_          = true;
   frame->mark_dirty();
   LOG_DEBUG("set root page to %d", root_page_num);
@@ -1556,6 +2358,185 @@ RC BplusTreeHandler::get_entry(const char *user_key, int key_len, list<RID> &rid
   return rc;
 }
 
+RC BplusTreeHandler::get_entries(
+    const char *user_keys, int key_num, int key_stride, vector<RID> &rids, vector<int> *offsets /* = nullptr */)
+{
+  rids.clear();
+  if (offsets != nullptr) {
+    offsets->clear();
+    offsets->reserve(key_num + 1);
+    offsets->push_back(0);
+  }
+
+  const AttrComparator &attr_comparator = key_comparator_.attr_comparator();
+  const int             attr_length     = file_header_.attr_length;
+
+  BplusTreeMiniTransaction mtr(*this);
+
+  vector<char> search_key(file_header_.key_length);
+  vector<char> resume_key(file_header_.key_length);
+
+  RC          rc         = RC::SUCCESS;
+  bool        empty      = false;
+  Frame      *frame      = nullptr;
+  int         index      = 0;
+  const char *prev_key   = nullptr;
+  size_t      prev_begin = 0;
+  for (int i = 0; i < key_num; i++) {
+    const char  *user_key = user_keys + static_cast<size_t>(i) * key_stride;
+    const size_t begin    = rids.size();
+
+    const int order = prev_key == nullptr ? 1 : attr_comparator(user_key, prev_key);
+    if (order == 0) {
+      // 与前一个键值相同
+      for (size_t j = prev_begin; j < begin; j++) {
+        rids.push_back(rids[j]);
+      }
+    } else if (!empty) {
+      memcpy(search_key.data(), user_key, attr_length);
+      memcpy(search_key.data() + attr_length, RID::min(), sizeof(RID));
+
+      rc = batch_seek(mtr, search_key.data(), order > 0 /*walk*/, frame, index);
+      if (rc == RC::EMPTY) {
+        empty = true;
+        rc    = RC::SUCCESS;
+      } else if (OB_FAIL(rc)) {
+        LOG_WARN("failed to seek key in bplus tree. rc=%s", strrc(rc));
+        return rc;
+      }
+
+      while (!empty) {
+        LeafIndexNodeHandler leaf(mtr, file_header_, frame);
+        const int            leaf_size = leaf.size();
+        for (; index < leaf_size; index++) {
+          if (attr_comparator(leaf.key_at(index), user_key) != 0) {
+            break;
+          }
+          rids.push_back(*reinterpret_cast<const RID *>(leaf.value_at(index)));
+        }
+        if (index < leaf_size) {
+          break;
+        }
+
+        // 当前叶子节点的数据都匹配，后面的叶子节点可能还有
+        memcpy(resume_key.data(), search_key.data(), file_header_.key_length);
+        if (rids.size() > begin) {
+          memcpy(resume_key.data() + attr_length, &rids.back(), sizeof(RID));
+        }
+        rc = batch_next_leaf(mtr, resume_key.data(), frame, index);
+        if (rc == RC::RECORD_EOF) {
+          rc = RC::SUCCESS;
+          break;
+        } else if (OB_FAIL(rc)) {
+          LOG_WARN("failed to move to next leaf. rc=%s", strrc(rc));
+          return rc;
+        }
+      }
+    }
+
+    prev_key   = user_key;
+    prev_begin = begin;
+    if (offsets != nullptr) {
+      offsets->push_back(static_cast<int>(rids.size()));
+    }
+  }
+  return rc;
+}
+
+RC BplusTreeHandler::batch_seek(BplusTreeMiniTransaction &mtr, const char *key, bool walk, Frame *&frame, int &index)
+{
+  // 向右最多查看这么多个叶子节点，再远就从根节点开始查找
+  static constexpr int MAX_LEAF_HOPS = 2;
+
+  RC         rc         = RC::SUCCESS;
+  LatchMemo &latch_memo = mtr.latch_memo();
+  for (int hops = 0; walk && frame != nullptr; hops++) {
+    LeafIndexNodeHandler leaf(mtr, file_header_, frame);
+    if (leaf.size() > 0 && key_comparator_(leaf.key_at(leaf.size() - 1), key) >= 0) {
+      index = leaf.lookup(key_comparator_, key);
+      return RC::SUCCESS;
+    }
+
+    const PageNum next_page_num = leaf.next_page();
+    if (next_page_num == BP_INVALID_PAGE_NUM) {
+      // 已经是最后一个叶子节点，后面没有更大的键值了
+      index = leaf.size();
+      return RC::SUCCESS;
+    }
+
+    if (hops >= MAX_LEAF_HOPS) {
+      break;
+    }
+
+    Frame    *next_frame = nullptr;
+    const int memo_point = latch_memo.memo_point();
+    rc                   = latch_memo.get_page(next_page_num, next_frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get next page. page num=%d, rc=%s", next_page_num, strrc(rc));
+      return rc;
+    }
+    if (!latch_memo.try_slatch(next_frame)) {
+      break;
+    }
+    latch_memo.release_to(memo_point);
+    frame = next_frame;
+  }
+
+  latch_memo.release();
+  frame = nullptr;
+
+  rc = find_leaf(mtr, BplusTreeOperationType::READ, key, frame);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  LeafIndexNodeHandler leaf(mtr, file_header_, frame);
+  index = leaf.lookup(key_comparator_, key);
+  return RC::SUCCESS;
+}
+
+RC BplusTreeHandler::batch_next_leaf(BplusTreeMiniTransaction &mtr, const char *resume_key, Frame *&frame, int &index)
+{
+  LatchMemo &latch_memo = mtr.latch_memo();
+
+  LeafIndexNodeHandler leaf(mtr, file_header_, frame);
+  const PageNum        next_page_num = leaf.next_page();
+  if (next_page_num == BP_INVALID_PAGE_NUM) {
+    return RC::RECORD_EOF;
+  }
+
+  Frame    *next_frame = nullptr;
+  const int memo_point = latch_memo.memo_point();
+  RC        rc         = latch_memo.get_page(next_page_num, next_frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to get next page. page num=%d, rc=%s", next_page_num, strrc(rc));
+    return rc;
+  }
+
+  if (latch_memo.try_slatch(next_frame)) {
+    latch_memo.release_to(memo_point);
+    frame = next_frame;
+    index = 0;
+    return RC::SUCCESS;
+  }
+
+  latch_memo.release();
+  frame = nullptr;
+
+  rc = find_leaf(mtr, BplusTreeOperationType::READ, resume_key, frame);
+  if (OB_FAIL(rc)) {
+    return rc == RC::EMPTY ? RC::RECORD_EOF : rc;
+  }
+
+  LeafIndexNodeHandler resume_leaf(mtr, file_header_, frame);
+  bool                 found = false;
+  index                      = resume_leaf.lookup(key_comparator_, resume_key, &found);
+  if (found) {
+    index++;
+  }
+  return RC::SUCCESS;
+}
+
 RC BplusTreeHandler::adjust_root(BplusTreeMiniTransaction &mtr, Frame *root_frame)
 {
   LatchMemo &latch_memo = mtr.latch_memo();
@@ -1653,7 +2634,7 @@ RC BplusTreeHandler::coalesce_or_redistribute(BplusTreeMiniTransaction &mtr, Fra
   latch_memo.xlatch(neighbor_frame);
 
   IndexNodeHandlerType neighbor_node(mtr, file_header_, neighbor_frame);
-  if (index_node.size() + neighbor_node.size() > index_node.max_size()) {
+  if (!index_node.can_merge_with(neighbor_node)) {
     rc = redistribute<IndexNodeHandlerType>(mtr, neighbor_frame, frame, parent_frame, index);
   } else {
     rc = coalesce<IndexNodeHandlerType>(mtr, neighbor_frame, frame, parent_frame, index);
@@ -1829,8 +2810,11 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
 
   LatchMemo &latch_memo = mtr_.latch_memo();
 
+  const bool composite_key = tree_handler_.key_comparator_.attr_comparator().attr_num() > 1;
+
   // 校验输入的键值是否是合法范围
-  if (left_user_key && right_user_key) {
+  // 多个字段的索引，边界可能只包含前面几个字段，不合法的范围在扫描时自然得到空的结果
+  if (left_user_key && right_user_key && !composite_key) {
     const auto &attr_comparator = tree_handler_.key_comparator_.attr_comparator();
     const int   result          = attr_comparator(left_user_key, right_user_key);
     if (result > 0 ||  // left < right
@@ -1856,7 +2840,14 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
   } else {
 
     char *fixed_left_key = const_cast<char *>(left_user_key);
-    if (tree_handler_.file_header_.attr_type == AttrType::CHARS ||
+    if (composite_key) {
+      // 包含左边界时，后面的字段使用最小值补齐，否则使用最大值
+      rc = fix_prefix_key(left_user_key, left_len, !left_inclusive /*fill_max*/, &fixed_left_key);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to fix left user key. rc=%s", strrc(rc));
+        return rc;
+      }
+    } else if (tree_handler_.file_header_.attr_type == AttrType::CHARS ||
        tree_handler_.file_header_.attr_type == AttrType::TEXT) {
       bool should_inclusive_after_fix = false;
       rc = fix_user_key(left_user_key, left_len, true /*greater*/, &fixed_left_key, &should_inclusive_after_fix);
@@ -1905,6 +2896,7 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
         return RC::SUCCESS;
       }
 
+      read_ahead(current_frame_->page_num(), next_page_num);
       rc = latch_memo.get_page(next_page_num, current_frame_);
       if (OB_FAIL(rc)) {
         LOG_WARN("failed to fetch next page. page num=%d, rc=%s", next_page_num, strrc(rc));
@@ -1924,7 +2916,14 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
 
     char *fixed_right_key          = const_cast<char *>(right_user_key);
     bool  should_include_after_fix = false;
-    if (tree_handler_.file_header_.attr_type == AttrType::CHARS || 
+    if (composite_key) {
+      // 包含右边界时，后面的字段使用最大值补齐，否则使用最小值
+      rc = fix_prefix_key(right_user_key, right_len, right_inclusive /*fill_max*/, &fixed_right_key);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to fix right user key. rc=%s", strrc(rc));
+        return rc;
+      }
+    } else if (tree_handler_.file_header_.attr_type == AttrType::CHARS || 
         tree_handler_.file_header_.attr_type == AttrType::TEXT) {
       rc = fix_user_key(right_user_key, right_len, false /*want_greater*/, &fixed_right_key, &should_include_after_fix);
       if (OB_FAIL(rc)) {
@@ -1974,6 +2973,14 @@ bool BplusTreeScanner::touch_end()
   return compare_result > 0;
 }
 
+void BplusTreeScanner::read_ahead(PageNum current_page_num, PageNum next_page_num)
+{
+  if (next_page_num > current_page_num) {
+    DiskBufferPool &buffer_pool = *tree_handler_.disk_buffer_pool_;
+    (void)buffer_pool.read_ahead(next_page_num, buffer_pool.read_ahead_pages());
+  }
+}
+
 RC BplusTreeScanner::next_entry(RID &rid)
 {
   if (nullptr == current_frame_) {
@@ -2006,6 +3013,8 @@ RC BplusTreeScanner::next_entry(RID &rid)
 
   LatchMemo &latch_memo = mtr_.latch_memo();
 
+  read_ahead(current_frame_->page_num(), next_page_num);
+
   const int memo_point = latch_memo.memo_point();
   rc                   = latch_memo.get_page(next_page_num, current_frame_);
   if (OB_FAIL(rc)) {
@@ -2086,3 +3095,54 @@ RC BplusTreeScanner::fix_user_key(
   *fixed_key = key_buf;
   return RC::SUCCESS;
 }
+
+RC BplusTreeScanner::fix_prefix_key(const char *user_key, int key_len, bool fill_max, char **fixed_key)
+{
+  if (nullptr == fixed_key) {
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const IndexFileHeader &header      = tree_handler_.file_header_;
+  const int32_t          attr_length = header.attr_length;
+  if (key_len >= attr_length) {
+    *fixed_key = const_cast<char *>(user_key);
+    return RC::SUCCESS;
+  }
+
+  char *key_buf = new char[attr_length];
+  if (nullptr == key_buf) {
+    return RC::NOMEM;
+  }
+
+  // 边界中只保留完整的字段，后面的字段按照类型补齐
+  int offset = 0;
+  for (int i = 0; i < header.attr_num; i++) {
+    const int length = header.attr_lengths[i];
+    if (offset + length <= key_len) {
+      memcpy(key_buf + offset, user_key + offset, length);
+      offset += length;
+      continue;
+    }
+
+    char *field = key_buf + offset;
+    switch (header.attr_types[i]) {
+      case AttrType::INTS:
+      case AttrType::DATES: {
+        const int32_t value = fill_max ? numeric_limits<int32_t>::max() : numeric_limits<int32_t>::min();
+        memcpy(field, &value, sizeof(value));
+      } break;
+      case AttrType::FLOATS: {
+        const float value = fill_max ? numeric_limits<float>::infinity() : -numeric_limits<float>::infinity();
+        memcpy(field, &value, sizeof(value));
+      } break;
+      default: {
+        // 字符串按照无符号字节比较
+        memset(field, fill_max ? 0xFF : 0, length);
+      } break;
+    }
+    offset += length;
+  }
+
+  *fixed_key = key_buf;
+  return RC::SUCCESS;
+}
@@ -19,10 +19,13 @@ See the Mulan PSL v2 for more details. */
 
 #include <string.h>
 
+#include "common/defs.h"
+#include "common/lang/atomic.h"
 #include "common/lang/comparator.h"
 #include "common/lang/memory.h"
 #include "common/lang/sstream.h"
 #include "common/lang/functional.h"
+#include "common/lang/vector.h"
 #include "common/log/log.h"
 #include "sql/parser/parse_defs.h"
 #include "storage/buffer/disk_buffer_pool.h"
@@ -49,90 +52,227 @@ enum class BplusTreeOperationType
   DELETE,
 };
 
+/**
+ * @brief 按照字段类型比较索引中的属性值(BplusTree)
+ * @details 索引中的属性值是定长的，可以直接按照类型解释内存，不需要构造 Value 对象再按照类型分发。
+ * 没有特化的类型仍然使用 DataType 的比较方法。
+ * @ingroup BPlusTree
+ */
+template <AttrType type>
+struct AttrCompare
+{
+  static int compare(const char *v1, const char *v2, int length)
+  {
+    Value left;
+    left.set_type(type);
+    left.set_data(v1, length);
+    Value right;
+    right.set_type(type);
+    right.set_data(v2, length);
+    return DataType::type_instance(type)->compare(left, right);
+  }
+};
+
+template <>
+struct AttrCompare<AttrType::INTS>
+{
+  static int compare(const char *v1, const char *v2, int /*length*/)
+  {
+    int32_t left, right;
+    memcpy(&left, v1, sizeof(left));
+    memcpy(&right, v2, sizeof(right));
+    return (left > right) - (left < right);
+  }
+};
+
+/// 日期在索引中保存为整数
+template <>
+struct AttrCompare<AttrType::DATES> : public AttrCompare<AttrType::INTS>
+{};
+
+template <>
+struct AttrCompare<AttrType::FLOATS>
+{
+  /// 与 common::compare_float 一致，差值在 EPSILON 以内认为相等
+  static int compare(const char *v1, const char *v2, int /*length*/)
+  {
+    float left, right;
+    memcpy(&left, v1, sizeof(left));
+    memcpy(&right, v2, sizeof(right));
+    const float cmp = left - right;
+    return (cmp > EPSILON) - (cmp < -EPSILON);
+  }
+};
+
+template <>
+struct AttrCompare<AttrType::CHARS>
+{
+  /// 与 common::compare_string 一致，字符串不足定长的部分以'\0'填充
+  static int compare(const char *v1, const char *v2, int length)
+  {
+    const int result = strncmp(v1, v2, length);
+    return (result > 0) - (result < 0);
+  }
+};
+
+/**
+ * @brief 比较索引键值，先比较属性，属性相同时再比较RID
+ * @ingroup BPlusTree
+ */
+template <AttrType type>
+int compare_key(const char *v1, const char *v2, int attr_length)
+{
+  const int result = AttrCompare<type>::compare(v1, v2, attr_length);
+  if (result != 0) {
+    return result;
+  }
+
+  const RID *rid1 = (const RID *)(v1 + attr_length);
+  const RID *rid2 = (const RID *)(v2 + attr_length);
+  return RID::compare(rid1, rid2);
+}
+
 /**
  * @brief 属性比较(BplusTree)
+ * @details 创建或打开索引时按照字段类型选好比较函数，比较时不再按照类型分发。
+ * 多个字段的索引，属性值是各个字段依次拼接起来的，按照字段的顺序逐个比较。
  * @ingroup BPlusTree
  */
 class AttrComparator
 {
 public:
-  void init(AttrType type, int length)
-  {
-    attr_type_   = type;
-    attr_length_ = length;
-  }
+  using CompareFunc = int (*)(const char *v1, const char *v2, int length);
 
-  int attr_length() const { return attr_length_; }
+public:
+  void init(AttrType type, int length);
+  void init(const vector<AttrType> &types, const vector<int> &lengths);
+
+  /// 第一个字段的类型
+  AttrType attr_type() const { return columns_.empty() ? AttrType::UNDEFINED : columns_.front().type; }
+  /// 所有字段的总长度
+  int      attr_length() const { return attr_length_; }
+  int      attr_num() const { return static_cast<int>(columns_.size()); }
 
   int operator()(const char *v1, const char *v2) const
   {
-    // TODO: optimized the comparison
-    Value left;
-    left.set_type(attr_type_);
-    left.set_data(v1, attr_length_);
-    Value right;
-    right.set_type(attr_type_);
-    right.set_data(v2, attr_length_);
-    return DataType::type_instance(attr_type_)->compare(left, right);
+    if (columns_.size() == 1) {
+      return columns_.front().compare(v1, v2, attr_length_);
+    }
+    return compare_columns(v1, v2);
   }
 
 private:
-  AttrType attr_type_;
-  int      attr_length_;
+  int compare_columns(const char *v1, const char *v2) const;
+
+private:
+  struct Column
+  {
+    AttrType    type    = AttrType::UNDEFINED;
+    int         offset  = 0;
+    int         length  = 0;
+    CompareFunc compare = nullptr;
+  };
+
+  vector<Column> columns_;
+  int            attr_length_ = 0;
 };
 
 /**
  * @brief 键值比较(BplusTree)
  * @details BplusTree的键值除了字段属性，还有RID，是为了避免属性值重复而增加的。
+ * 与 AttrComparator 一样，单个字段时比较函数和节点内的查找函数都是在初始化时按照字段类型选定的，
+ * 多个字段时逐个字段比较。
  * @ingroup BPlusTree
  */
 class KeyComparator
 {
 public:
-  void init(AttrType type, int length) { attr_comparator_.init(type, length); }
+  using CompareFunc    = int (*)(const char *v1, const char *v2, int attr_length);
+  using LowerBoundFunc = int (*)(
+      const char *items, int size, int item_size, int attr_length, const char *key, bool *found);
+
+public:
+  void init(AttrType type, int length);
+  void init(const vector<AttrType> &types, const vector<int> &lengths);
 
   const AttrComparator &attr_comparator() const { return attr_comparator_; }
 
   int operator()(const char *v1, const char *v2) const
   {
-    int result = attr_comparator_(v1, v2);
-    if (result != 0) {
-      return result;
+    if (compare_func_ != nullptr) {
+      return compare_func_(v1, v2, attr_comparator_.attr_length());
     }
+    return compare_columns(v1, v2);
+  }
 
-    const RID *rid1 = (const RID *)(v1 + attr_comparator_.attr_length());
-    const RID *rid2 = (const RID *)(v2 + attr_comparator_.attr_length());
-    return RID::compare(rid1, rid2);
+  /**
+   * @brief 在节点中查找第一个不小于 key 的键值
+   * @param items 第一个键值的位置，键值放在每个item的开头
+   * @param size item的个数
+   * @param item_size 每个item的大小
+   * @param key 要查找的键值
+   * @param found 是否找到了相同的键值
+   * @return int 第一个不小于 key 的item的下标，如果都小于 key 就返回 size
+   */
+  int lower_bound(const char *items, int size, int item_size, const char *key, bool *found = nullptr) const
+  {
+    if (lower_bound_func_ != nullptr) {
+      return lower_bound_func_(items, size, item_size, attr_comparator_.attr_length(), key, found);
+    }
+    return lower_bound_columns(items, size, item_size, key, found);
   }
 
+private:
+  void init_funcs();
+
+  int compare_columns(const char *v1, const char *v2) const;
+  int lower_bound_columns(const char *items, int size, int item_size, const char *key, bool *found) const;
+
 private:
   AttrComparator attr_comparator_;
+  CompareFunc    compare_func_     = nullptr;
+  LowerBoundFunc lower_bound_func_ = nullptr;
 };
 
 /**
  * @brief 属性打印,调试使用(BplusTree)
+ * @details 多个字段的属性值使用逗号分隔
  * @ingroup BPlusTree
  */
 class AttrPrinter
 {
 public:
-  void init(AttrType type, int length)
+  void init(AttrType type, int length) { init(vector<AttrType>{type}, vector<int>{length}); }
+  void init(const vector<AttrType> &types, const vector<int> &lengths)
   {
-    attr_type_   = type;
-    attr_length_ = length;
+    attr_types_   = types;
+    attr_lengths_ = lengths;
+    attr_length_  = 0;
+    for (int length : lengths) {
+      attr_length_ += length;
+    }
   }
 
   int attr_length() const { return attr_length_; }
 
   string operator()(const char *v) const
   {
-    Value value(attr_type_, const_cast<char *>(v), attr_length_);
-    return value.to_string();
+    string result;
+    for (size_t i = 0; i < attr_types_.size(); i++) {
+      if (i > 0) {
+        result += ",";
+      }
+      Value value(attr_types_[i], const_cast<char *>(v), attr_lengths_[i]);
+      result += value.to_string();
+      v += attr_lengths_[i];
+    }
+    return result;
   }
 
 private:
-  AttrType attr_type_;
-  int      attr_length_;
+  vector<AttrType> attr_types_;
+  vector<int>      attr_lengths_;
+  int              attr_length_ = 0;
 };
 
 /**
@@ -143,6 +283,7 @@ class KeyPrinter
 {
 public:
   void init(AttrType type, int length) { attr_printer_.init(type, length); }
+  void init(const vector<AttrType> &types, const vector<int> &lengths) { attr_printer_.init(types, lengths); }
 
   const AttrPrinter &attr_printer() const { return attr_printer_; }
 
@@ -164,21 +305,46 @@ private:
  * @brief the meta information of bplus tree
  * @ingroup BPlusTree
  * @details this is the first page of bplus tree.
- * only one field can be supported, can you extend it to multi-fields?
+ * 多个字段的索引，键值是各个字段按照顺序拼接起来的，attr_length 是所有字段的总长度，
+ * attr_type 是第一个字段的类型。旧版本创建的索引文件中 attr_num 是0，表示只有一个字段。
+ * leaf_compressed 为1时叶子节点使用压缩格式，参考 LeafIndexNode。压缩格式的叶子节点，leaf_max_size 是
+ * 不做任何压缩时一个页面能放下的元素个数。
  */
 struct IndexFileHeader
 {
+  static constexpr int MAX_ATTR_NUM = 8;  ///< 一个索引最多包含的字段个数
+
   IndexFileHeader()
   {
     memset(this, 0, sizeof(IndexFileHeader));
     root_page = BP_INVALID_PAGE_NUM;
   }
-  PageNum  root_page;          ///< 根节点在磁盘中的页号
-  int32_t  internal_max_size;  ///< 内部节点最大的键值对数
-  int32_t  leaf_max_size;      ///< 叶子节点最大的键值对数
-  int32_t  attr_length;        ///< 键值的长度
-  int32_t  key_length;         ///< attr length + sizeof(RID)
-  AttrType attr_type;          ///< 键值的类型
+  PageNum  root_page;                   ///< 根节点在磁盘中的页号
+  int32_t  internal_max_size;           ///< 内部节点最大的键值对数
+  int32_t  leaf_max_size;               ///< 叶子节点最大的键值对数
+  int32_t  attr_length;                 ///< 键值的长度
+  int32_t  key_length;                  ///< attr length + sizeof(RID)
+  AttrType attr_type;                   ///< 键值的类型
+  int32_t  attr_num;                    ///< 字段的个数
+  AttrType attr_types[MAX_ATTR_NUM];    ///< 每个字段的类型
+  int32_t  attr_lengths[MAX_ATTR_NUM];  ///< 每个字段的长度
+  int32_t  leaf_compressed;             ///< 叶子节点是否使用压缩格式
+
+  vector<AttrType> attr_type_list() const
+  {
+    if (attr_num <= 0) {
+      return {attr_type};
+    }
+    return vector<AttrType>(attr_types, attr_types + attr_num);
+  }
+
+  vector<int> attr_length_list() const
+  {
+    if (attr_num <= 0) {
+      return {attr_length};
+    }
+    return vector<int>(attr_lengths, attr_lengths + attr_num);
+  }
 
   const string to_string() const
   {
@@ -187,9 +353,11 @@ struct IndexFileHeader
     ss << "attr_length:" << attr_length << ","
        << "key_length:" << key_length << ","
        << "attr_type:" << attr_type_to_string(attr_type) << ","
+       << "attr_num:" << attr_num << ","
        << "root_page:" << root_page << ","
        << "internal_max_size:" << internal_max_size << ","
-       << "leaf_max_size:" << leaf_max_size << ";";
+       << "leaf_max_size:" << leaf_max_size << ","
+       << "leaf_compressed:" << leaf_compressed << ";";
 
     return ss.str();
   }
@@ -224,10 +392,21 @@ struct IndexNode
  * so the key in leaf page must be unique.
  * the value is rid.
  * can you implenment a cluster index ?
+ *
+ * 压缩格式(IndexFileHeader::leaf_compressed):
+ * @code
+ * | common header | next page id | prefix length | suffix length | prefix | suffix |
+ * | key0 slot | key1 slot | ... | keyn slot |
+ * @endcode
+ * 页面上所有的键值都有相同的前缀，用户键值部分(不含RID)也有相同的后缀，比如CHARS类型末尾填充的0。
+ * 前缀和后缀只存储一份，每个元素(slot)只存储中间不同的部分和RID。
+ * 值就是键值最后的RID，不再单独存储。每个元素依然是定长的，可以直接做二分查找。
+ * 插入的键值与当前的前缀或后缀不同时，整个页面重新编码。
  */
 struct LeafIndexNode : public IndexNode
 {
-  static constexpr int HEADER_SIZE = IndexNode::HEADER_SIZE + 4;
+  static constexpr int HEADER_SIZE             = IndexNode::HEADER_SIZE + 4;
+  static constexpr int COMPRESSION_HEADER_SIZE = 2 * sizeof(int16_t);  ///< 压缩格式中记录前缀、后缀长度的字段大小
 
   PageNum next_brother;
   /**
@@ -308,8 +487,8 @@ public:
 
   friend string to_string(const IndexNodeHandler &handler);
 
-  RC recover_insert_items(int index, const char *items, int num);
-  RC recover_remove_items(int index, int num);
+  virtual RC recover_insert_items(int index, const char *items, int num);
+  virtual RC recover_remove_items(int index, int num);
 
 protected:
   /**
@@ -364,17 +543,76 @@ public:
 
   bool validate(const KeyComparator &comparator, DiskBufferPool *bp) const;
 
+  /// 是否使用压缩格式
+  bool compressed() const { return header_.leaf_compressed != 0; }
+  /// 压缩格式中所有键值共同的前缀长度
+  int prefix_length() const;
+  /// 压缩格式中所有用户键值(不含RID)共同的后缀长度
+  int suffix_length() const;
+  /// 页面上实际使用的字节数
+  int used_bytes() const;
+
+  /**
+   * @brief 插入这个键值后，当前页面是否还能放得下
+   * @details 压缩格式的页面，插入的键值可能会让前缀变短，所以不能只看元素个数
+   */
+  bool can_insert(const char *key) const;
+
+  /**
+   * @brief 两个节点的数据能否合并到一个节点中
+   */
+  bool can_merge_with(const LeafIndexNodeHandler &other) const;
+
+  RC recover_insert_items(int index, const char *items, int num) override;
+  RC recover_remove_items(int index, int num) override;
+
   friend string to_string(const LeafIndexNodeHandler &handler, const KeyPrinter &printer);
 
 protected:
   char *__item_at(int index) const override;
 
+  /**
+   * @brief 获取从 index 开始的 num 个元素，每个元素都是完整的键值加上RID
+   * @details 不压缩的页面直接返回页面中的地址，压缩的页面会解码到 buffer 中
+   */
+  const char *items_at(int index, int num, vector<char> &buffer) const;
+
+  /**
+   * @brief 获取完整的键值
+   * @details 不压缩的页面直接返回页面中的地址，压缩的页面会解码到 buffer 中，buffer 至少要有 key_size 大小
+   */
+  const char *decode_key(int index, char *buffer) const;
+
   RC append(const char *items, int num);
   RC append(const char *item);
   RC preappend(const char *item);
 
 private:
+  /// 压缩格式中前缀的地址
+  char *prefix() const;
+  /// 压缩格式中用户键值公共后缀的地址
+  char *suffix() const;
+  /// 压缩格式中第 index 个元素的地址
+  char *slot_at(int index) const;
+  /// 压缩格式中每个元素的大小
+  int slot_size() const { return key_size() - prefix_length() - suffix_length(); }
+  /// 压缩格式中，把元素中存储的部分拷贝到完整的键值中。键值中的前缀和后缀需要调用方提前填好
+  void copy_slot_to_key(const char *slot, char *key) const;
+  /// 压缩格式中，把完整的键值中需要存储的部分拷贝到元素中
+  void copy_key_to_slot(const char *key, char *slot) const;
+  /// 压缩格式中，设置前缀、后缀的长度，把 num 个完整的元素重新写到页面中
+  void encode_items(const char *items, int num, int prefix_length, int suffix_length);
+  /// 压缩格式中，计算 num 个完整的元素可以使用的最长的前缀和后缀
+  void compression_bounds(const char *items, int num, int &prefix_length, int &suffix_length) const;
+  /// 压缩格式中，num 个元素使用指定长度的前缀和后缀需要多少字节
+  static int compressed_bytes(int num, int key_size, int prefix_length, int suffix_length);
+
+private:
+  friend class BplusTreeBulkLoader;
+
   LeafIndexNode *leaf_node_ = nullptr;
+
+  mutable vector<char> key_buffer_;  ///< 压缩格式中 key_at/value_at 解码后的键值
 };
 
 /**
@@ -412,6 +650,14 @@ public:
   int lookup(
       const KeyComparator &comparator, const char *key, bool *found = nullptr, int *insert_position = nullptr) const;
 
+  /**
+   * @brief 不加锁查找指定key所属的子节点，用于乐观读
+   * @details 页面可能正在被其它线程修改，读到的内容可能不一致，这里只保证不会越界访问页面，
+   * 调用者需要使用页帧的版本号校验结果是否有效。
+   * @param key 查找的键值，为空时返回最左边的子节点
+   */
+  PageNum optimistic_child_page(const KeyComparator &comparator, const char *key) const;
+
   /**
    * @brief 把当前节点的所有数据都迁移到另一个节点上
    *
@@ -422,6 +668,11 @@ public:
   RC move_last_to_front(InternalIndexNodeHandler &other);
   RC move_half_to(InternalIndexNodeHandler &other);
 
+  /**
+   * @brief 两个节点的数据能否合并到一个节点中
+   */
+  bool can_merge_with(const InternalIndexNodeHandler &other) const { return size() + other.size() <= max_size(); }
+
   bool validate(const KeyComparator &comparator, DiskBufferPool *bp) const;
 
   friend string to_string(const InternalIndexNodeHandler &handler, const KeyPrinter &printer);
@@ -439,9 +690,33 @@ private:
   int item_size() const override;
 
 private:
+  friend class BplusTreeBulkLoader;
+
   InternalIndexNode *internal_node_ = nullptr;
 };
 
+/**
+ * @brief B+树的统计信息
+ * @ingroup BPlusTree
+ * @details 扇出是指每个节点平均有多少个元素，叶子节点压缩后扇出变大，树的高度也可能会变低
+ */
+struct BplusTreeStats
+{
+  int     height            = 0;  ///< 树的高度，只有一个叶子节点时是1
+  int64_t internal_node_num = 0;  ///< 内部节点的个数
+  int64_t leaf_node_num     = 0;  ///< 叶子节点的个数
+  int64_t internal_item_num = 0;  ///< 所有内部节点上的元素个数
+  int64_t entry_num         = 0;  ///< 所有叶子节点上的元素个数
+  int64_t leaf_used_bytes   = 0;  ///< 所有叶子节点实际使用的字节数
+
+  double internal_fanout() const;
+  double leaf_fanout() const;
+  /// 叶子节点页面的平均使用率
+  double leaf_fill_ratio() const;
+
+  string to_string() const;
+};
+
 /**
  * @brief B+树的实现
  * @ingroup BPlusTree
@@ -458,11 +733,23 @@ public:
    * @param attr_length 属性长度
    * @param internal_max_size 内部节点最大大小
    * @param leaf_max_size 叶子节点最大大小
+   * @param leaf_compressed 叶子节点是否使用压缩格式
    */
   RC create(LogHandler &log_handler, BufferPoolManager &bpm, const char *file_name, AttrType attr_type, int attr_length,
-      int internal_max_size = -1, int leaf_max_size = -1);
+      int internal_max_size = -1, int leaf_max_size = -1, bool leaf_compressed = false);
   RC create(LogHandler &log_handler, DiskBufferPool &buffer_pool, AttrType attr_type, int attr_length,
-      int internal_max_size = -1, int leaf_max_size = -1);
+      int internal_max_size = -1, int leaf_max_size = -1, bool leaf_compressed = false);
+
+  /**
+   * @brief 创建一个多个字段的B+树
+   * @details 键值是各个字段按照顺序拼接起来的，比较时按照字段的顺序逐个比较
+   * @param attr_types 每个字段的类型
+   * @param attr_lengths 每个字段的长度
+   */
+  RC create(LogHandler &log_handler, BufferPoolManager &bpm, const char *file_name, const vector<AttrType> &attr_types,
+      const vector<int> &attr_lengths, int internal_max_size = -1, int leaf_max_size = -1, bool leaf_compressed = false);
+  RC create(LogHandler &log_handler, DiskBufferPool &buffer_pool, const vector<AttrType> &attr_types,
+      const vector<int> &attr_lengths, int internal_max_size = -1, int leaf_max_size = -1, bool leaf_compressed = false);
 
   /**
    * @brief 打开一个B+树
@@ -502,6 +789,19 @@ public:
    */
   RC get_entry(const char *user_key, int key_len, list<RID> &rids);
 
+  /**
+   * @brief 批量查找多个键值对应的记录
+   * @details 键值按照从小到大的顺序给出时，下一个键值通常就在当前的叶子节点或者右边相邻的几个叶子节点中，
+   * 这时直接在已经加了读锁的叶子节点上向右查找，不再从根节点向下查找。
+   * 键值不是递增的，或者离当前的叶子节点比较远时，才重新从根节点开始查找。
+   * 相邻的两个键值相同时，直接复用前一个键值的结果。
+   * @param user_keys key_num 个完整长度(attr_length)的键值，第 i 个键值的位置是 user_keys + i * key_stride
+   * @param[out] rids 所有匹配的记录位置，按照键值的顺序连续存放
+   * @param[out] offsets 不为空时，第 i 个键值匹配的记录是 rids 中的 [offsets[i], offsets[i+1])
+   */
+  RC get_entries(
+      const char *user_keys, int key_num, int key_stride, vector<RID> &rids, vector<int> *offsets = nullptr);
+
   RC sync();
 
   /**
@@ -511,6 +811,13 @@ public:
    */
   bool validate_tree();
 
+  /**
+   * @brief 读操作查找叶子节点时是否使用乐观读
+   * @details 默认开启。关闭后所有的读操作都使用 crabing protocol，主要用来做性能对比
+   */
+  void set_optimistic_read(bool enable) { optimistic_read_ = enable; }
+  bool optimistic_read() const { return optimistic_read_; }
+
 public:
   const IndexFileHeader &file_header() const { return file_header_; }
   DiskBufferPool        &buffer_pool() const { return *disk_buffer_pool_; }
@@ -535,6 +842,11 @@ public:
   RC print_tree();
   RC print_leafs();
 
+  /**
+   * @brief 遍历整棵树，统计树的高度、扇出等信息
+   */
+  RC stats(BplusTreeStats &stats);
+
 private:
   /**
    * 这些函数都是线程不安全的，不要在多线程的环境下调用
@@ -545,6 +857,25 @@ private:
   bool validate_leaf_link(BplusTreeMiniTransaction &mtr);
   bool validate_node_recursive(BplusTreeMiniTransaction &mtr, Frame *frame);
 
+  RC stats_recursive(BplusTreeMiniTransaction &mtr, PageNum page_num, int depth, BplusTreeStats &stats);
+
+  /**
+   * @brief 批量查找时，定位到 key 在叶子节点中的位置
+   * @param walk 是否可以从当前的叶子节点(frame)向右查找。否则释放当前的叶子节点，从根节点开始查找
+   * @param[in,out] frame 当前加了读锁的叶子节点
+   * @param[out] index key 在叶子节点中的位置，可能等于叶子节点的大小
+   */
+  RC batch_seek(BplusTreeMiniTransaction &mtr, const char *key, bool walk, Frame *&frame, int &index);
+
+  /**
+   * @brief 批量查找时，移动到下一个叶子节点
+   * @details 向右加锁的顺序与插入、删除相反，加锁失败时不能等待，释放当前的叶子节点后，
+   * 从根节点重新查找 resume_key 后面的位置
+   * @param resume_key 已经处理过的最后一个键值
+   * @return 没有下一个叶子节点时返回 RC::RECORD_EOF
+   */
+  RC batch_next_leaf(BplusTreeMiniTransaction &mtr, const char *resume_key, Frame *&frame, int &index);
+
 protected:
   /**
    * @brief 查找叶子节点
@@ -568,6 +899,19 @@ protected:
   RC find_leaf_internal(BplusTreeMiniTransaction &mtr, BplusTreeOperationType op,
       const function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame);
 
+  /**
+   * @brief 使用乐观读查找叶子节点
+   * @details 从根节点向下查找时不对内部节点加锁，只记录页帧的版本号，读取完子节点的页面编号后，
+   * 再校验版本号是否变化，变化了就从根节点重新开始。找到叶子节点后，对叶子节点加读锁，然后校验
+   * 父节点的版本号，确认叶子节点依然是要找的节点。
+   * 写操作依然使用 crabing protocol，修改节点时都会加写锁，从而修改页帧的版本号。
+   * 重试的次数过多时返回 RC::LOCKED_NEED_WAIT，调用者可以改用 crabing protocol。
+   * @param key 查找的键值，为空时查找最左边的叶子节点
+   * @param[out] frame 返回找到的叶子节点，已经加了读锁
+   */
+  RC optimistic_find_leaf(BplusTreeMiniTransaction &mtr, const char *key, Frame *&frame);
+  RC optimistic_find_leaf_once(BplusTreeMiniTransaction &mtr, const char *key, Frame *&frame);
+
   /**
    * @brief 使用crabing protocol 获取页面
    */
@@ -635,6 +979,11 @@ protected:
 private:
   common::MemPoolItem::item_unique_ptr make_key(const char *user_key, const RID &rid);
 
+  /**
+   * @brief 按照文件头中记录的字段初始化键值比较和打印的对象
+   */
+  void init_key_helpers();
+
 protected:
   LogHandler     *log_handler_      = nullptr;  /// 日志处理器
   DiskBufferPool *disk_buffer_pool_ = nullptr;  /// 磁盘缓冲池
@@ -645,6 +994,10 @@ protected:
   // 这个锁可以使用递归读写锁，但是这里偷懒先不改
   common::SharedMutex root_lock_;
 
+  /// 根节点每变化一次就加1。乐观读不加 root_lock_，通过它判断读取的根节点是否依然有效
+  atomic<uint64_t> root_version_{0};
+  bool             optimistic_read_ = true;
+
   KeyComparator key_comparator_;
   KeyPrinter    key_printer_;
 
@@ -653,6 +1006,7 @@ protected:
 private:
   friend class BplusTreeScanner;
   friend class BplusTreeTester;
+  friend class BplusTreeBulkLoader;
 };
 
 /**
@@ -668,7 +1022,8 @@ public:
   /**
    * @brief 扫描指定范围的数据
    * @param left_user_key 扫描范围的左边界，如果是null，则没有左边界
-   * @param left_len left_user_key 的内存大小(只有在变长字段中才会关注)
+   * @param left_len left_user_key 的内存大小(只有在变长字段中才会关注)。
+   * 多个字段的索引，边界可以只包含前面几个字段，这时的长度是这几个字段的长度之和
    * @param left_inclusive 左边界的值是否包含在内
    * @param right_user_key 扫描范围的右边界。如果是null，则没有右边界
    * @param right_len right_user_key 的内存大小(只有在变长字段中才会关注)
@@ -701,6 +1056,12 @@ private:
    */
   RC fix_user_key(const char *user_key, int key_len, bool want_greater, char **fixed_key, bool *should_inclusive);
 
+  /**
+   * 多个字段的索引，如果边界只包含前面几个字段，就用对应类型的最小值或最大值补齐后面的字段
+   * @param fill_max 是否使用最大值补齐
+   */
+  RC fix_prefix_key(const char *user_key, int key_len, bool fill_max, char **fixed_key);
+
   void fetch_item(RID &rid);
 
   /**
@@ -708,6 +1069,12 @@ private:
    */
   bool touch_end();
 
+  /**
+   * @brief 移动到下一个叶子节点之前，预读后面的页面
+   * @details 叶子节点大多是按照页面编号递增分配的，只有下一个叶子节点的编号更大时才预读
+   */
+  void read_ahead(PageNum current_page_num, PageNum next_page_num);
+
 private:
   bool                     inited_ = false;
   BplusTreeHandler        &tree_handler_;
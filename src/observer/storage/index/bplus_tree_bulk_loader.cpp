@@ -0,0 +1,413 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/index/bplus_tree_bulk_loader.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/chrono.h"
+#include "common/lang/fstream.h"
+#include "common/lang/memory.h"
+#include "common/lang/queue.h"
+#include "common/log/log.h"
+#include "storage/index/bplus_tree.h"
+#include "storage/index/bplus_tree_log.h"
+
+namespace {
+
+/**
+ * @brief 顺序读取一个有序的临时文件
+ */
+class RunReader
+{
+public:
+  RunReader(const string &file_name, int entry_size) : entry_(entry_size)
+  {
+    stream_.open(file_name, ios_base::in | ios_base::binary);
+  }
+
+  bool is_open() const { return stream_.is_open(); }
+
+  /**
+   * @brief 读取下一个键值
+   * @return 读到了文件末尾返回 RC::RECORD_EOF
+   */
+  RC next()
+  {
+    stream_.read(entry_.data(), entry_.size());
+    if (stream_.gcount() == 0 && stream_.eof()) {
+      return RC::RECORD_EOF;
+    }
+    if (static_cast<size_t>(stream_.gcount()) != entry_.size()) {
+      return RC::IOERR_READ;
+    }
+    return RC::SUCCESS;
+  }
+
+  const char *entry() const { return entry_.data(); }
+
+private:
+  ifstream     stream_;
+  vector<char> entry_;
+};
+
+}  // namespace
+
+BplusTreeBulkLoader::BplusTreeBulkLoader(BplusTreeHandler &handler, const BplusTreeBulkLoadOptions &options)
+    : handler_(handler), options_(options)
+{
+  key_length_  = handler_.file_header().key_length;
+  attr_length_ = handler_.file_header().attr_length;
+}
+
+BplusTreeBulkLoader::~BplusTreeBulkLoader() { remove_run_files(); }
+
+RC BplusTreeBulkLoader::add(const char *user_key, const RID &rid)
+{
+  const size_t offset = buffer_.size();
+  buffer_.resize(offset + key_length_);
+  memcpy(buffer_.data() + offset, user_key, attr_length_);
+  memcpy(buffer_.data() + offset + attr_length_, &rid, sizeof(rid));
+  entry_num_++;
+
+  // 排序时每个键值还需要一个指针
+  const size_t memory_size = buffer_.size() / key_length_ * (key_length_ + sizeof(const char *));
+  if (memory_size >= options_.sort_buffer_size) {
+    return spill_buffer();
+  }
+  return RC::SUCCESS;
+}
+
+RC BplusTreeBulkLoader::finish()
+{
+  if (!handler_.is_empty()) {
+    LOG_WARN("cannot bulk load into a non-empty bplus tree");
+    return RC::INTERNAL;
+  }
+
+  const auto begin_time = chrono::steady_clock::now();
+
+  RC rc = RC::SUCCESS;
+  if (run_files_.empty()) {
+    sort_buffer();
+
+    size_t index  = 0;
+    auto   source = [this, &index](const char *&entry) {
+      if (index >= sorted_.size()) {
+        return RC::RECORD_EOF;
+      }
+      entry = sorted_[index++];
+      return RC::SUCCESS;
+    };
+    rc = build(source);
+  } else {
+    // 内存中剩余的数据也写到临时文件中，再统一做归并
+    rc = spill_buffer();
+    if (OB_SUCC(rc)) {
+      rc = merge_and_build();
+    }
+  }
+
+  remove_run_files();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to bulk load bplus tree. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - begin_time);
+  LOG_INFO("bulk load bplus tree done. entries=%ld, runs=%d, levels=%d, leaves=%ld, elapsed=%ldms",
+           entry_num_, run_num_, static_cast<int>(levels_.size()), levels_.empty() ? 0L : levels_[0].node_num,
+           static_cast<long>(elapsed.count()));
+  return RC::SUCCESS;
+}
+
+void BplusTreeBulkLoader::sort_buffer()
+{
+  sorted_.clear();
+  sorted_.reserve(buffer_.size() / key_length_);
+  for (size_t offset = 0; offset < buffer_.size(); offset += key_length_) {
+    sorted_.push_back(buffer_.data() + offset);
+  }
+
+  const KeyComparator &comparator = handler_.key_comparator_;
+  sort(sorted_.begin(), sorted_.end(), [&comparator](const char *left, const char *right) {
+    return comparator(left, right) < 0;
+  });
+}
+
+RC BplusTreeBulkLoader::spill_buffer()
+{
+  if (buffer_.empty()) {
+    return RC::SUCCESS;
+  }
+
+  sort_buffer();
+
+  string   file_name = options_.temp_file_prefix + ".run." + to_string(run_files_.size());
+  ofstream stream(file_name, ios_base::out | ios_base::binary | ios_base::trunc);
+  if (!stream.is_open()) {
+    LOG_WARN("failed to open bulk load run file. file=%s, errmsg=%s", file_name.c_str(), strerror(errno));
+    return RC::IOERR_OPEN;
+  }
+  run_files_.push_back(file_name);
+  run_num_++;
+
+  for (const char *entry : sorted_) {
+    stream.write(entry, key_length_);
+  }
+  stream.close();
+  if (stream.fail()) {
+    LOG_WARN("failed to write bulk load run file. file=%s, errmsg=%s", file_name.c_str(), strerror(errno));
+    return RC::IOERR_WRITE;
+  }
+
+  LOG_INFO("spill sorted keys to file. file=%s, entries=%ld", file_name.c_str(), static_cast<long>(sorted_.size()));
+  sorted_.clear();
+  buffer_.clear();
+  return RC::SUCCESS;
+}
+
+RC BplusTreeBulkLoader::merge_and_build()
+{
+  vector<unique_ptr<RunReader>> readers;
+  for (const string &file_name : run_files_) {
+    auto reader = make_unique<RunReader>(file_name, key_length_);
+    if (!reader->is_open()) {
+      LOG_WARN("failed to open bulk load run file. file=%s", file_name.c_str());
+      return RC::IOERR_OPEN;
+    }
+    readers.push_back(std::move(reader));
+  }
+
+  // 小顶堆，每个临时文件当前的键值中最小的在堆顶
+  const KeyComparator &comparator = handler_.key_comparator_;
+  auto                 greater    = [&comparator, &readers](size_t left, size_t right) {
+    return comparator(readers[left]->entry(), readers[right]->entry()) > 0;
+  };
+  priority_queue<size_t, vector<size_t>, decltype(greater)> heap(greater);
+
+  for (size_t i = 0; i < readers.size(); i++) {
+    RC rc = readers[i]->next();
+    if (OB_SUCC(rc)) {
+      heap.push(i);
+    } else if (rc != RC::RECORD_EOF) {
+      return rc;
+    }
+  }
+
+  // 堆顶的键值要先拷贝出来，读取下一个键值时会被覆盖
+  vector<char> current(key_length_);
+  auto         source = [&](const char *&entry) {
+    if (heap.empty()) {
+      return RC::RECORD_EOF;
+    }
+
+    const size_t index = heap.top();
+    heap.pop();
+    memcpy(current.data(), readers[index]->entry(), key_length_);
+    entry = current.data();
+
+    RC rc = readers[index]->next();
+    if (OB_SUCC(rc)) {
+      heap.push(index);
+    } else if (rc != RC::RECORD_EOF) {
+      return rc;
+    }
+    return RC::SUCCESS;
+  };
+
+  return build(source);
+}
+
+RC BplusTreeBulkLoader::build(const EntrySource &source)
+{
+  plan_levels();
+
+  const AttrComparator &attr_comparator = handler_.key_comparator_.attr_comparator();
+
+  // 叶子节点的元素是键值加上RID，键值里面也包含了RID
+  vector<char> leaf_item(key_length_ + sizeof(RID));
+  const char  *entry = nullptr;
+  RC           rc    = RC::SUCCESS;
+  while (OB_SUCC(rc = source(entry))) {
+    if (options_.unique && !last_entry_.empty() && attr_comparator(last_entry_.data(), entry) == 0) {
+      LOG_WARN("duplicate key found while building unique index");
+      return RC::RECORD_DUPLICATE_KEY;
+    }
+    last_entry_.assign(entry, entry + key_length_);
+
+    memcpy(leaf_item.data(), entry, key_length_);
+    memcpy(leaf_item.data() + key_length_, entry + attr_length_, sizeof(RID));
+    rc = add_item(0, leaf_item.data());
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to fetch sorted keys. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  if (root_page_num_ == BP_INVALID_PAGE_NUM) {
+    return RC::SUCCESS;  // 没有任何数据
+  }
+  return set_root(root_page_num_);
+}
+
+void BplusTreeBulkLoader::plan_levels()
+{
+  const IndexFileHeader &header = handler_.file_header();
+
+  levels_.clear();
+  if (entry_num_ == 0) {
+    return;
+  }
+
+  int64_t item_num  = entry_num_;
+  int     max_size  = header.leaf_max_size;
+  int     item_size = key_length_ + sizeof(RID);
+  while (true) {
+    Level &level    = levels_.emplace_back();
+    level.item_num  = item_num;
+    level.node_num  = node_num_of(item_num, max_size);
+    level.item_size = item_size;
+
+    // 只有一个节点的那一层就是根节点
+    if (level.node_num == 1) {
+      break;
+    }
+
+    item_num  = level.node_num;
+    max_size  = header.internal_max_size;
+    item_size = key_length_ + sizeof(PageNum);
+  }
+}
+
+int64_t BplusTreeBulkLoader::node_num_of(int64_t item_num, int max_size) const
+{
+  const int min_size = max_size - max_size / 2;
+  const int capacity = std::clamp(max_size * options_.fill_factor / 100, min_size, max_size);
+
+  int64_t node_num = (item_num + capacity - 1) / capacity;
+  // 平均分配之后，每个节点的元素个数不能少于最小值，否则后续删除时的合并逻辑会出问题
+  while (node_num > 1 && item_num / node_num < min_size) {
+    node_num--;
+  }
+  return node_num;
+}
+
+RC BplusTreeBulkLoader::add_item(size_t level_index, const char *item)
+{
+  Level &level = levels_[level_index];
+  if (level.items.empty()) {
+    level.node_size = static_cast<int>(level.item_num / level.node_num + (level.node_index < level.item_num % level.node_num ? 1 : 0));
+    level.items.reserve(static_cast<size_t>(level.node_size) * level.item_size);
+  }
+
+  level.items.insert(level.items.end(), item, item + level.item_size);
+  if (static_cast<int>(level.items.size() / level.item_size) < level.node_size) {
+    return RC::SUCCESS;
+  }
+
+  return flush_node(level_index);
+}
+
+RC BplusTreeBulkLoader::flush_node(size_t level_index)
+{
+  Level     &level     = levels_[level_index];
+  const bool is_leaf   = (level_index == 0);
+  const int  item_num  = static_cast<int>(level.items.size() / level.item_size);
+
+  RC                       rc = RC::SUCCESS;
+  BplusTreeMiniTransaction mtr(handler_);
+  LatchMemo               &latch_memo = mtr.latch_memo();
+
+  Frame *frame = nullptr;
+  if (level.page_num != BP_INVALID_PAGE_NUM) {
+    rc = latch_memo.get_page(level.page_num, frame);
+  } else {
+    rc = latch_memo.allocate_page(frame);
+  }
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to get page for bulk load. level=%d, rc=%s", static_cast<int>(level_index), strrc(rc));
+    return rc;
+  }
+
+  const IndexFileHeader &header    = handler_.file_header();
+  PageNum                next_page = BP_INVALID_PAGE_NUM;
+  if (is_leaf) {
+    LeafIndexNodeHandler node(mtr, header, frame);
+    node.init_empty();
+    rc = node.append(level.items.data(), item_num);
+
+    // 先分配下一个叶子节点的页面，才能把叶子节点串起来
+    if (OB_SUCC(rc) && level.node_index + 1 < level.node_num) {
+      Frame *next_frame = nullptr;
+      rc                = latch_memo.allocate_page(next_frame);
+      if (OB_SUCC(rc)) {
+        next_frame->mark_dirty();
+        next_page = next_frame->page_num();
+        rc        = node.set_next_page(next_page);
+      }
+    }
+  } else {
+    // 插入的同时会设置所有子节点的父节点
+    InternalIndexNodeHandler node(mtr, header, frame);
+    node.init_empty();
+    rc = node.append(level.items.data(), item_num);
+  }
+
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to fill node while bulk loading. level=%d, rc=%s", static_cast<int>(level_index), strrc(rc));
+    return rc;
+  }
+
+  frame->mark_dirty();
+
+  // 这个页面所有的修改作为一条日志记录下来
+  rc = mtr.commit();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to commit bulk load log. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  const PageNum page_num = frame->page_num();
+  level.node_index++;
+  level.page_num = next_page;
+
+  if (level_index + 1 >= levels_.size()) {
+    root_page_num_ = page_num;
+    level.items.clear();
+    return RC::SUCCESS;
+  }
+
+  // 当前节点的第一个键值作为上一层节点中的键值
+  vector<char> parent_item(key_length_ + sizeof(PageNum));
+  memcpy(parent_item.data(), level.items.data(), key_length_);
+  memcpy(parent_item.data() + key_length_, &page_num, sizeof(page_num));
+  level.items.clear();
+
+  return add_item(level_index + 1, parent_item.data());
+}
+
+RC BplusTreeBulkLoader::set_root(PageNum root_page_num)
+{
+  BplusTreeMiniTransaction mtr(handler_);
+  mtr.latch_memo().xlatch(&handler_.root_lock_);
+  handler_.update_root_page_num_locked(mtr, root_page_num);
+  return mtr.commit();
+}
+
+void BplusTreeBulkLoader::remove_run_files()
+{
+  for (const string &file_name : run_files_) {
+    ::remove(file_name.c_str());
+  }
+  run_files_.clear();
+}
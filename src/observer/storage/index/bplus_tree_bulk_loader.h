@@ -0,0 +1,145 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/functional.h"
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+#include "storage/buffer/page.h"
+
+class BplusTreeHandler;
+struct RID;
+
+/**
+ * @brief 批量构建B+树的参数
+ * @ingroup BPlusTree
+ */
+struct BplusTreeBulkLoadOptions
+{
+  /// 节点的填充比例(百分比)。留一些空间，后续插入时不会马上分裂
+  int fill_factor = 90;
+
+  /// 排序使用的内存大小，超过之后就把排好序的数据写到临时文件中，最后再做多路归并
+  size_t sort_buffer_size = 64 * 1024 * 1024;
+
+  /// 是否是唯一索引。唯一索引遇到重复的键值时返回 RC::RECORD_DUPLICATE_KEY
+  bool unique = false;
+
+  /// 临时文件名的前缀，实际的文件名后面会加上编号
+  string temp_file_prefix;
+};
+
+/**
+ * @brief 在已有数据的表上创建索引时，批量构建B+树
+ * @ingroup BPlusTree
+ * @details 逐条调用 insert_entry 时，每条数据都要从根节点向下查找，还会不停地分裂节点，
+ * 每次修改都会记录一条日志。批量构建时，先把所有的 (key, RID) 收集起来排序，内存放不下时
+ * 写到临时文件中，然后从叶子节点开始自底向上按照顺序填满每一层的节点。
+ * 每个节点的内容都是一次写完的，日志也是以页面为单位记录的。
+ *
+ * 只能在一棵空的B+树上使用，构建的过程中其它人不能访问这棵树。
+ * @code
+ * BplusTreeBulkLoader loader(handler, options);
+ * loader.add(key, rid); // 任意顺序
+ * ...
+ * loader.finish();
+ * @endcode
+ */
+class BplusTreeBulkLoader
+{
+public:
+  BplusTreeBulkLoader(BplusTreeHandler &handler, const BplusTreeBulkLoadOptions &options);
+  ~BplusTreeBulkLoader();
+
+  /**
+   * @brief 添加一个键值对
+   * @param user_key 用户的键值，长度与索引字段的长度一致
+   */
+  RC add(const char *user_key, const RID &rid);
+
+  /**
+   * @brief 排序并构建B+树
+   */
+  RC finish();
+
+  int64_t entry_num() const { return entry_num_; }
+  int     run_num() const { return run_num_; }
+
+private:
+  /// 每次获取一个排好序的键值，没有数据时返回 RC::RECORD_EOF
+  using EntrySource = function<RC(const char *&entry)>;
+
+  /**
+   * @brief 每一层节点的构建状态
+   * @details 总的数据量在排序之后就知道了，所以每一层有多少个节点、每个节点放多少个元素都可以提前算好，
+   * 元素平均分配到各个节点上，保证每个节点都不少于最小的元素个数。
+   */
+  struct Level
+  {
+    int64_t      item_num   = 0;  ///< 这一层一共有多少个元素
+    int64_t      node_num   = 0;  ///< 这一层一共有多少个节点
+    int64_t      node_index = 0;  ///< 当前正在填充第几个节点
+    int          node_size  = 0;  ///< 当前节点计划放多少个元素
+    int          item_size  = 0;  ///< 每个元素的大小
+    vector<char> items;           ///< 当前节点已经收集的元素
+    PageNum      page_num = BP_INVALID_PAGE_NUM;  ///< 当前节点的页面。叶子节点需要提前分配，用于设置兄弟节点
+  };
+
+  /**
+   * @brief 对内存中的键值排序
+   */
+  void sort_buffer();
+
+  /**
+   * @brief 把内存中的键值排序后写到一个临时文件中
+   */
+  RC spill_buffer();
+
+  /**
+   * @brief 对所有的临时文件做多路归并，按照顺序构建B+树
+   */
+  RC merge_and_build();
+
+  /**
+   * @brief 按照顺序获取所有的键值，自底向上构建B+树
+   */
+  RC build(const EntrySource &source);
+
+  void    plan_levels();
+  int64_t node_num_of(int64_t item_num, int max_size) const;
+
+  /**
+   * @brief 向某一层当前的节点中添加一个元素，节点满了就写到页面中，并把它加入到上一层
+   */
+  RC add_item(size_t level_index, const char *item);
+  RC flush_node(size_t level_index);
+  RC set_root(PageNum root_page_num);
+
+  void remove_run_files();
+
+private:
+  BplusTreeHandler        &handler_;
+  BplusTreeBulkLoadOptions options_;
+
+  int key_length_  = 0;  ///< 键值的长度，包含了RID
+  int attr_length_ = 0;  ///< 用户键值的长度
+
+  vector<char>         buffer_;     ///< 还没有写到临时文件中的键值
+  vector<const char *> sorted_;     ///< 排好序的键值
+  vector<string>       run_files_;  ///< 已经写出去的有序的临时文件
+  int                  run_num_   = 0;  ///< 一共写出去了多少个临时文件
+  int64_t              entry_num_ = 0;
+
+  vector<Level> levels_;
+  vector<char>  last_entry_;  ///< 上一个键值，用于检查唯一索引
+  PageNum       root_page_num_ = BP_INVALID_PAGE_NUM;
+};
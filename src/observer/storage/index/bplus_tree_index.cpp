@@ -19,7 +19,8 @@ See the Mulan PSL v2 for more details. */
 
 BplusTreeIndex::~BplusTreeIndex() noexcept { close(); }
 
-RC BplusTreeIndex::create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+RC BplusTreeIndex::create(
+    Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
 {
   if (inited_) {
     LOG_WARN("Failed to create index due to the index has been created before. file_name:%s, index:%s, field:%s",
@@ -27,10 +28,19 @@ RC BplusTreeIndex::create(Table *table, const char *file_name, const IndexMeta &
     return RC::RECORD_OPENNED;
   }
 
-  Index::init(index_meta, field_meta);
+  Index::init(index_meta, field_metas);
 
   BufferPoolManager &bpm = table->db()->buffer_pool_manager();
-  RC rc = index_handler_.create(table->db()->log_handler(), bpm, file_name, field_meta.type(), field_meta.len());
+  vector<AttrType> attr_types;
+  vector<int>      attr_lengths;
+  for (const FieldMeta &field_meta : field_metas) {
+    attr_types.push_back(field_meta.type());
+    attr_lengths.push_back(field_meta.len());
+  }
+
+  RC rc = index_handler_.create(
+      table->db()->log_handler(), bpm, file_name, attr_types, attr_lengths, -1 /*internal_max_size*/,
+      -1 /*leaf_max_size*/, leaf_compressed_);
   if (RC::SUCCESS != rc) {
     LOG_WARN("Failed to create index_handler, file_name:%s, index:%s, field:%s, rc:%s",
         file_name, index_meta.name(), index_meta.field(), strrc(rc));
@@ -44,7 +54,8 @@ RC BplusTreeIndex::create(Table *table, const char *file_name, const IndexMeta &
   return RC::SUCCESS;
 }
 
-RC BplusTreeIndex::open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+RC BplusTreeIndex::open(
+    Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
 {
   if (inited_) {
     LOG_WARN("Failed to open index due to the index has been initedd before. file_name:%s, index:%s, field:%s",
@@ -52,7 +63,7 @@ RC BplusTreeIndex::open(Table *table, const char *file_name, const IndexMeta &in
     return RC::RECORD_OPENNED;
   }
 
-  Index::init(index_meta, field_meta);
+  Index::init(index_meta, field_metas);
 
   BufferPoolManager &bpm = table->db()->buffer_pool_manager();
   RC                 rc  = index_handler_.open(table->db()->log_handler(), bpm, file_name);
@@ -82,17 +93,24 @@ RC BplusTreeIndex::close()
 
 RC BplusTreeIndex::insert_entry(const char *record, const RID *rid)
 {
-  return index_handler_.insert_entry(record + field_meta_.offset(), rid);
+  string key_buffer;
+  return index_handler_.insert_entry(extract_key(record, key_buffer), rid);
+}
+
+RC BplusTreeIndex::get_entry(const char *key, int key_len, std::list<RID> &rids)
+{
+  return index_handler_.get_entry(key, key_len, rids);
 }
 
-RC BplusTreeIndex::get_entry(const char *record, int key_len, std::list<RID> &rids)
+RC BplusTreeIndex::get_entries(const char *keys, int key_num, vector<RID> &rids, vector<int> *offsets)
 {
-  return index_handler_.get_entry(record + field_meta_.offset(), key_len, rids);
+  return index_handler_.get_entries(keys, key_num, key_length_, rids, offsets);
 }
 
 RC BplusTreeIndex::delete_entry(const char *record, const RID *rid)
 {
-  return index_handler_.delete_entry(record + field_meta_.offset(), rid);
+  string key_buffer;
+  return index_handler_.delete_entry(extract_key(record, key_buffer), rid);
 }
 
 IndexScanner *BplusTreeIndex::create_scanner(
@@ -110,6 +128,11 @@ IndexScanner *BplusTreeIndex::create_scanner(
 
 RC BplusTreeIndex::sync() { return index_handler_.sync(); }
 
+unique_ptr<BplusTreeBulkLoader> BplusTreeIndex::create_bulk_loader(const BplusTreeBulkLoadOptions &options)
+{
+  return make_unique<BplusTreeBulkLoader>(index_handler_, options);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 BplusTreeIndexScanner::BplusTreeIndexScanner(BplusTreeHandler &tree_handler) : tree_scanner_(tree_handler) {}
 
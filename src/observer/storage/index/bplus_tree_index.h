@@ -14,7 +14,9 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include "common/lang/memory.h"
 #include "storage/index/bplus_tree.h"
+#include "storage/index/bplus_tree_bulk_loader.h"
 #include "storage/index/index.h"
 
 /**
@@ -27,12 +29,21 @@ public:
   BplusTreeIndex() = default;
   virtual ~BplusTreeIndex() noexcept;
 
-  RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta) override;
-  RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta) override;
+  RC create(
+      Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC open(
+      Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
   RC close();
 
   RC insert_entry(const char *record, const RID *rid) override;
-  RC get_entry(const char *record, int key_len, std::list<RID> &rids) override;
+  RC get_entry(const char *key, int key_len, std::list<RID> &rids) override;
+
+  using Index::get_entries;
+  /**
+   * @brief 批量查询多个键值
+   * @details 键值按照从小到大的顺序排列时，沿着叶子节点从左向右查找，参考 BplusTreeHandler::get_entries
+   */
+  RC get_entries(const char *keys, int key_num, vector<RID> &rids, vector<int> *offsets = nullptr) override;
   RC delete_entry(const char *record, const RID *rid) override;
 
   /**
@@ -43,9 +54,22 @@ public:
 
   RC sync() override;
 
+  /**
+   * @brief 创建一个批量构建器，用于在已有数据的表上创建索引
+   * @details 只能在刚创建的空索引上使用
+   */
+  unique_ptr<BplusTreeBulkLoader> create_bulk_loader(const BplusTreeBulkLoadOptions &options);
+
+  /**
+   * @brief 叶子节点是否使用压缩格式
+   * @details 需要在 create 之前设置，打开已有的索引时以文件中记录的为准
+   */
+  void set_leaf_compressed(bool leaf_compressed) { leaf_compressed_ = leaf_compressed; }
+
 private:
-  bool             inited_ = false;
-  Table           *table_  = nullptr;
+  bool             inited_          = false;
+  bool             leaf_compressed_ = false;
+  Table           *table_           = nullptr;
   BplusTreeHandler index_handler_;
 };
 
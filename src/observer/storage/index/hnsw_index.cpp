@@ -0,0 +1,603 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "storage/index/hnsw_index.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/defer.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/fstream.h"
+#include "common/lang/functional.h"
+#include "common/lang/limits.h"
+#include "common/lang/queue.h"
+#include "common/lang/sstream.h"
+#include "common/log/log.h"
+#include "storage/table/table.h"
+
+using namespace common;
+
+namespace {
+
+/**
+ * @brief 记录一次搜索中访问过的节点
+ * @details 每个线程一个，每次搜索把 tag 加1，不需要每次都清空
+ */
+class VisitedList
+{
+public:
+  void reset(size_t node_num)
+  {
+    if (tags_.size() < node_num) {
+      tags_.resize(node_num, 0);
+    }
+    if (++current_ == 0) {
+      std::fill(tags_.begin(), tags_.end(), 0);
+      current_ = 1;
+    }
+  }
+
+  /// 第一次访问时返回true
+  bool visit(int node)
+  {
+    if (tags_[node] == current_) {
+      return false;
+    }
+    tags_[node] = current_;
+    return true;
+  }
+
+private:
+  vector<uint32_t> tags_;
+  uint32_t         current_ = 0;
+};
+
+thread_local VisitedList visited_list;
+
+}  // namespace
+
+const string HnswIndexFileHeader::to_string() const
+{
+  stringstream ss;
+  ss << "dimension:" << dimension << ";"
+     << "distance type:" << vector_distance_type_name(static_cast<VectorDistanceType>(distance_type)) << ";"
+     << "m:" << m << ";"
+     << "ef construction:" << ef_construction << ";"
+     << "ef search:" << ef_search << ";"
+     << "node num:" << node_num << ";"
+     << "entry point:" << entry_point << ";"
+     << "max level:" << max_level << ";";
+  return ss.str();
+}
+
+HnswIndex::~HnswIndex() noexcept { close(); }
+
+void HnswIndex::set_options(VectorDistanceType distance_type, int m, int ef_construction, int ef_search)
+{
+  distance_type_   = distance_type;
+  m_               = std::max(m, 2);
+  ef_construction_ = std::max(ef_construction, m_);
+  ef_search_       = std::max(ef_search, 1);
+}
+
+void HnswIndex::set_ef_search(int ef_search) { ef_search_ = std::max(ef_search, 1); }
+
+RC HnswIndex::init_field(const FieldMeta &field_meta)
+{
+  if (field_meta.type() != AttrType::VECTORS) {
+    LOG_WARN("hnsw index only supports vector field. field=%s, type=%s",
+             field_meta.name(), attr_type_to_string(field_meta.type()));
+    return RC::SCHEMA_FIELD_TYPE_MISMATCH;
+  }
+
+  dimension_ = field_meta.len() / static_cast<int>(sizeof(float));
+  if (dimension_ <= 0) {
+    LOG_WARN("invalid vector dimension for hnsw index. field=%s, dimension=%d", field_meta.name(), dimension_);
+    return RC::INVALID_ARGUMENT;
+  }
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::create(
+    Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  RC rc = create(file_name, index_meta, field_metas);
+  if (OB_SUCC(rc)) {
+    table_ = table;
+  }
+  return rc;
+}
+
+RC HnswIndex::open(
+    Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  RC rc = open(file_name, index_meta, field_metas);
+  if (OB_SUCC(rc)) {
+    table_ = table;
+  }
+  return rc;
+}
+
+RC HnswIndex::create(const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (inited_) {
+    LOG_WARN("Failed to create index due to the index has been created before. file_name:%s, index:%s",
+        file_name, index_meta.name());
+    return RC::RECORD_OPENNED;
+  }
+
+  if (field_metas.size() != 1) {
+    LOG_WARN("hnsw index only supports one field. index=%s", index_meta.name());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  if (filesystem::exists(file_name)) {
+    LOG_WARN("index file already exists. file name=%s", file_name);
+    return RC::FILE_EXIST;
+  }
+
+  Index::init(index_meta, field_metas);
+
+  RC rc = init_field(field_metas.front());
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  file_name_   = file_name;
+  entry_point_ = -1;
+  max_level_   = -1;
+  nodes_.clear();
+  vectors_.clear();
+  rid_to_node_.clear();
+
+  rc = save();
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  inited_ = true;
+  LOG_INFO("Successfully create hnsw index. file_name:%s, index:%s, dimension:%d, distance:%s, m:%d, "
+           "ef_construction:%d, ef_search:%d",
+      file_name, index_meta.name(), dimension_, vector_distance_type_name(distance_type_), m_, ef_construction_,
+      ef_search_);
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::open(const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (inited_) {
+    LOG_WARN("Failed to open index due to the index has been opened before. file_name:%s, index:%s",
+        file_name, index_meta.name());
+    return RC::RECORD_OPENNED;
+  }
+
+  if (field_metas.size() != 1) {
+    LOG_WARN("hnsw index only supports one field. index=%s", index_meta.name());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  Index::init(index_meta, field_metas);
+
+  RC rc = init_field(field_metas.front());
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  file_name_ = file_name;
+  rc         = load();
+  if (OB_FAIL(rc)) {
+    nodes_.clear();
+    vectors_.clear();
+    rid_to_node_.clear();
+    return rc;
+  }
+
+  inited_ = true;
+  LOG_INFO("Successfully open hnsw index. file_name:%s, index:%s, nodes:%d",
+      file_name, index_meta.name(), static_cast<int>(nodes_.size()));
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::close()
+{
+  if (!inited_) {
+    return RC::SUCCESS;
+  }
+
+  RC rc = sync();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to save hnsw index while closing. file name=%s, rc=%s", file_name_.c_str(), strrc(rc));
+  }
+
+  inited_ = false;
+  nodes_.clear();
+  vectors_.clear();
+  rid_to_node_.clear();
+  return rc;
+}
+
+RC HnswIndex::sync()
+{
+  lock_.lock_shared();
+  DEFER(lock_.unlock_shared());
+
+  if (!inited_) {
+    return RC::SUCCESS;
+  }
+  return save();
+}
+
+/**
+ * 先写到临时文件中，成功之后再改名，避免写了一半的时候异常退出破坏原来的文件
+ */
+RC HnswIndex::save()
+{
+  const string temp_file_name = file_name_ + ".tmp";
+
+  ofstream stream(temp_file_name, ios_base::out | ios_base::binary | ios_base::trunc);
+  if (!stream.is_open()) {
+    LOG_WARN("failed to open file. file name=%s, error=%s", temp_file_name.c_str(), strerror(errno));
+    return RC::IOERR_OPEN;
+  }
+
+  HnswIndexFileHeader file_header;
+  file_header.dimension       = dimension_;
+  file_header.distance_type   = static_cast<int32_t>(distance_type_);
+  file_header.m               = m_;
+  file_header.ef_construction = ef_construction_;
+  file_header.ef_search       = ef_search_;
+  file_header.node_num        = static_cast<int32_t>(nodes_.size());
+  file_header.entry_point     = entry_point_;
+  file_header.max_level       = max_level_;
+  stream.write(reinterpret_cast<const char *>(&file_header), sizeof(file_header));
+
+  for (size_t i = 0; i < nodes_.size(); i++) {
+    const Node   &node    = nodes_[i];
+    const int32_t level   = node.level;
+    const int32_t deleted = node.deleted ? 1 : 0;
+    stream.write(reinterpret_cast<const char *>(&node.rid), sizeof(node.rid));
+    stream.write(reinterpret_cast<const char *>(&level), sizeof(level));
+    stream.write(reinterpret_cast<const char *>(&deleted), sizeof(deleted));
+    stream.write(reinterpret_cast<const char *>(vector_of(static_cast<int>(i))), dimension_ * sizeof(float));
+    for (const vector<int> &neighbors : node.neighbors) {
+      const int32_t neighbor_num = static_cast<int32_t>(neighbors.size());
+      stream.write(reinterpret_cast<const char *>(&neighbor_num), sizeof(neighbor_num));
+      stream.write(reinterpret_cast<const char *>(neighbors.data()), neighbor_num * sizeof(int));
+    }
+  }
+
+  stream.close();
+  if (stream.fail()) {
+    LOG_WARN("failed to write file. file name=%s, error=%s", temp_file_name.c_str(), strerror(errno));
+    ::remove(temp_file_name.c_str());
+    return RC::IOERR_WRITE;
+  }
+
+  if (0 != ::rename(temp_file_name.c_str(), file_name_.c_str())) {
+    LOG_WARN("failed to rename file. from=%s, to=%s, error=%s",
+        temp_file_name.c_str(), file_name_.c_str(), strerror(errno));
+    ::remove(temp_file_name.c_str());
+    return RC::IOERR_WRITE;
+  }
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::load()
+{
+  ifstream stream(file_name_, ios_base::in | ios_base::binary);
+  if (!stream.is_open()) {
+    LOG_WARN("failed to open file. file name=%s, error=%s", file_name_.c_str(), strerror(errno));
+    return RC::IOERR_OPEN;
+  }
+
+  HnswIndexFileHeader file_header;
+  if (!stream.read(reinterpret_cast<char *>(&file_header), sizeof(file_header))) {
+    LOG_WARN("failed to read file header. file name=%s", file_name_.c_str());
+    return RC::IOERR_READ;
+  }
+
+  if (file_header.dimension != dimension_) {
+    LOG_WARN("dimension mismatch. file header=%s, field dimension=%d", file_header.to_string().c_str(), dimension_);
+    return RC::INTERNAL;
+  }
+
+  distance_type_   = static_cast<VectorDistanceType>(file_header.distance_type);
+  m_               = file_header.m;
+  ef_construction_ = file_header.ef_construction;
+  ef_search_       = file_header.ef_search;
+  entry_point_     = file_header.entry_point;
+  max_level_       = file_header.max_level;
+
+  const int node_num = file_header.node_num;
+  nodes_.resize(node_num);
+  vectors_.resize(static_cast<size_t>(node_num) * dimension_);
+  rid_to_node_.clear();
+  for (int i = 0; i < node_num; i++) {
+    Node   &node    = nodes_[i];
+    int32_t level   = 0;
+    int32_t deleted = 0;
+    stream.read(reinterpret_cast<char *>(&node.rid), sizeof(node.rid));
+    stream.read(reinterpret_cast<char *>(&level), sizeof(level));
+    stream.read(reinterpret_cast<char *>(&deleted), sizeof(deleted));
+    stream.read(reinterpret_cast<char *>(vectors_.data() + static_cast<size_t>(i) * dimension_),
+        dimension_ * sizeof(float));
+    if (!stream || level < 0) {
+      LOG_WARN("hnsw index file is broken. file name=%s, node=%d", file_name_.c_str(), i);
+      return RC::IOERR_READ;
+    }
+
+    node.level   = level;
+    node.deleted = deleted != 0;
+    node.neighbors.resize(level + 1);
+    for (vector<int> &neighbors : node.neighbors) {
+      int32_t neighbor_num = 0;
+      stream.read(reinterpret_cast<char *>(&neighbor_num), sizeof(neighbor_num));
+      if (!stream || neighbor_num < 0 || neighbor_num > node_num) {
+        LOG_WARN("hnsw index file is broken. file name=%s, node=%d", file_name_.c_str(), i);
+        return RC::IOERR_READ;
+      }
+      neighbors.resize(neighbor_num);
+      stream.read(reinterpret_cast<char *>(neighbors.data()), neighbor_num * sizeof(int));
+    }
+    if (!stream) {
+      LOG_WARN("hnsw index file is broken. file name=%s, node=%d", file_name_.c_str(), i);
+      return RC::IOERR_READ;
+    }
+
+    if (!node.deleted) {
+      rid_to_node_[node.rid] = i;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+int HnswIndex::random_level()
+{
+  // 层数服从指数分布，每高一层节点数大约变成 1/m
+  const double level_mult = 1.0 / log(static_cast<double>(m_));
+  const double random     = uniform_real_distribution<double>(numeric_limits<double>::min(), 1.0)(level_random_);
+  return static_cast<int>(-log(random) * level_mult);
+}
+
+float HnswIndex::distance(const float *query, int node) const
+{
+  return vector_distance(distance_type_, query, vector_of(node), dimension_);
+}
+
+void HnswIndex::greedy_search(const float *query, int level, int &node, float &node_distance) const
+{
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int neighbor : nodes_[node].neighbors[level]) {
+      const float neighbor_distance = distance(query, neighbor);
+      if (neighbor_distance < node_distance) {
+        node          = neighbor;
+        node_distance = neighbor_distance;
+        changed       = true;
+      }
+    }
+  }
+}
+
+vector<HnswIndex::DistanceNode> HnswIndex::search_layer(
+    const float *query, int entry, float entry_distance, int ef, int level) const
+{
+  VisitedList &visited = visited_list;
+  visited.reset(nodes_.size());
+  visited.visit(entry);
+
+  // candidates 是待扩展的节点，距离小的优先；results 是当前最近的 ef 个节点，距离大的在堆顶
+  priority_queue<DistanceNode, vector<DistanceNode>, std::greater<DistanceNode>> candidates;
+  priority_queue<DistanceNode>                                             results;
+  candidates.emplace(entry_distance, entry);
+  results.emplace(entry_distance, entry);
+
+  while (!candidates.empty()) {
+    const DistanceNode current = candidates.top();
+    if (current.first > results.top().first && static_cast<int>(results.size()) >= ef) {
+      break;
+    }
+    candidates.pop();
+
+    for (int neighbor : nodes_[current.second].neighbors[level]) {
+      if (!visited.visit(neighbor)) {
+        continue;
+      }
+
+      const float neighbor_distance = distance(query, neighbor);
+      if (static_cast<int>(results.size()) < ef || neighbor_distance < results.top().first) {
+        candidates.emplace(neighbor_distance, neighbor);
+        results.emplace(neighbor_distance, neighbor);
+        if (static_cast<int>(results.size()) > ef) {
+          results.pop();
+        }
+      }
+    }
+  }
+
+  vector<DistanceNode> sorted_results(results.size());
+  for (int i = static_cast<int>(results.size()) - 1; i >= 0; i--) {
+    sorted_results[i] = results.top();
+    results.pop();
+  }
+  return sorted_results;
+}
+
+vector<int> HnswIndex::select_neighbors(const vector<DistanceNode> &candidates, int max_num) const
+{
+  vector<int> selected;
+  for (const DistanceNode &candidate : candidates) {
+    if (static_cast<int>(selected.size()) >= max_num) {
+      break;
+    }
+
+    // 内积不满足三角不等式，(负的)距离也不是越近越小，启发式会剪掉太多的边，导致部分节点不可达
+    if (distance_type_ == VectorDistanceType::INNER_PRODUCT) {
+      selected.push_back(candidate.second);
+      continue;
+    }
+
+    bool good = true;
+    for (int neighbor : selected) {
+      if (distance(vector_of(candidate.second), neighbor) < candidate.first) {
+        good = false;
+        break;
+      }
+    }
+    if (good) {
+      selected.push_back(candidate.second);
+    }
+  }
+  return selected;
+}
+
+void HnswIndex::connect(int node, int neighbor, int level)
+{
+  vector<int> &neighbors = nodes_[node].neighbors[level];
+  neighbors.push_back(neighbor);
+  if (static_cast<int>(neighbors.size()) <= max_neighbors(level)) {
+    return;
+  }
+
+  vector<DistanceNode> candidates;
+  candidates.reserve(neighbors.size());
+  for (int candidate : neighbors) {
+    candidates.emplace_back(distance(vector_of(node), candidate), candidate);
+  }
+  std::sort(candidates.begin(), candidates.end());
+  neighbors = select_neighbors(candidates, max_neighbors(level));
+}
+
+RC HnswIndex::insert_entry(const char *record, const RID *rid)
+{
+  lock_.lock();
+  DEFER(lock_.unlock());
+
+  if (!inited_) {
+    LOG_WARN("hnsw index is not inited");
+    return RC::INTERNAL;
+  }
+
+  if (rid_to_node_.find(*rid) != rid_to_node_.end()) {
+    LOG_WARN("rid already exists in hnsw index. index=%s, rid=%s", index_meta_.name(), rid->to_string().c_str());
+    return RC::RECORD_DUPLICATE_KEY;
+  }
+
+  string       key_buffer;
+  const float *query = reinterpret_cast<const float *>(extract_key(record, key_buffer));
+
+  const int node_id = static_cast<int>(nodes_.size());
+  const int level   = random_level();
+
+  Node node;
+  node.rid   = *rid;
+  node.level = level;
+  node.neighbors.resize(level + 1);
+  nodes_.push_back(std::move(node));
+  vectors_.insert(vectors_.end(), query, query + dimension_);
+  rid_to_node_[*rid] = node_id;
+
+  if (entry_point_ < 0) {
+    entry_point_ = node_id;
+    max_level_   = level;
+    return RC::SUCCESS;
+  }
+
+  // 在比自己高的层中只需要找到最近的节点作为下一层的入口
+  int   current          = entry_point_;
+  float current_distance = distance(query, current);
+  for (int l = max_level_; l > level; l--) {
+    greedy_search(query, l, current, current_distance);
+  }
+
+  for (int l = std::min(level, max_level_); l >= 0; l--) {
+    vector<DistanceNode> candidates = search_layer(query, current, current_distance, ef_construction_, l);
+
+    vector<int> neighbors = select_neighbors(candidates, m_);
+    for (int neighbor : neighbors) {
+      connect(neighbor, node_id, l);
+    }
+    nodes_[node_id].neighbors[l] = std::move(neighbors);
+
+    current          = candidates.front().second;
+    current_distance = candidates.front().first;
+  }
+
+  if (level > max_level_) {
+    entry_point_ = node_id;
+    max_level_   = level;
+  }
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::delete_entry(const char *record, const RID *rid)
+{
+  lock_.lock();
+  DEFER(lock_.unlock());
+
+  auto iter = rid_to_node_.find(*rid);
+  if (iter == rid_to_node_.end()) {
+    return RC::RECORD_NOT_EXIST;
+  }
+
+  nodes_[iter->second].deleted = true;
+  rid_to_node_.erase(iter);
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::ann_search(const float *query, size_t limit, vector<RID> &rids, vector<float> *distances /* = nullptr */)
+{
+  return ann_search(query, limit, 0 /*ef_search*/, rids, distances);
+}
+
+RC HnswIndex::ann_search(
+    const float *query, size_t limit, int ef_search, vector<RID> &rids, vector<float> *distances /* = nullptr */)
+{
+  rids.clear();
+  if (distances != nullptr) {
+    distances->clear();
+  }
+
+  lock_.lock_shared();
+  DEFER(lock_.unlock_shared());
+
+  if (!inited_ || entry_point_ < 0 || limit == 0) {
+    return RC::SUCCESS;
+  }
+
+  int   current          = entry_point_;
+  float current_distance = distance(query, current);
+  for (int l = max_level_; l > 0; l--) {
+    greedy_search(query, l, current, current_distance);
+  }
+
+  // 删除的节点也会占用候选集的位置，所以候选集要比 limit 多出删除的节点个数才能保证结果足够
+  ef_search = std::max<int>(ef_search <= 0 ? ef_search_ : ef_search, static_cast<int>(limit));
+  ef_search = std::min<int>(ef_search + static_cast<int>(nodes_.size() - rid_to_node_.size()), nodes_.size());
+
+  vector<DistanceNode> results = search_layer(query, current, current_distance, ef_search, 0);
+  for (const DistanceNode &result : results) {
+    if (rids.size() >= limit) {
+      break;
+    }
+
+    const Node &node = nodes_[result.second];
+    if (node.deleted) {
+      continue;
+    }
+    rids.push_back(node.rid);
+    if (distances != nullptr) {
+      distances->push_back(result.first);
+    }
+  }
+  return RC::SUCCESS;
+}
@@ -0,0 +1,183 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/mutex.h"
+#include "common/lang/random.h"
+#include "common/lang/unordered_map.h"
+#include "common/lang/utility.h"
+#include "common/lang/vector.h"
+#include "common/math/vector_distance.h"
+#include "storage/index/index.h"
+
+/**
+ * @brief hnsw 索引文件的文件头
+ * @ingroup Index
+ * @details 文件头之后依次存放每个节点：
+ * @code
+ * | RID | level | deleted | vector | level 0 neighbor num | neighbors | ... | level N neighbor num | neighbors |
+ * @endcode
+ */
+struct HnswIndexFileHeader
+{
+  int32_t dimension;        ///< 向量的维度
+  int32_t distance_type;    ///< 距离的计算方式，参考 common::VectorDistanceType
+  int32_t m;                ///< 每个节点在每一层的邻居个数，第0层是 2 * m
+  int32_t ef_construction;  ///< 插入时搜索的候选集大小
+  int32_t ef_search;        ///< 查询时默认的候选集大小
+  int32_t node_num;         ///< 节点的个数，包括已经删除的节点
+  int32_t entry_point;      ///< 最高层的入口节点
+  int32_t max_level;        ///< 最高的层数
+
+  const string to_string() const;
+};
+
+/**
+ * @brief HNSW(Hierarchical Navigable Small World) 向量索引
+ * @ingroup Index
+ * @details 每个向量是图中的一个节点，随机分配一个层数，在它所在的每一层中与 m 个相近的节点相连。
+ * 上层的节点少、边长，下层的节点多、边短。查询时从最高层的入口节点开始，每一层贪心地走到离查询向量最近的节点，
+ * 再进入下一层，在第0层用大小为 ef_search 的候选集做最佳优先搜索。ef_search 越大召回率越高，查询越慢。
+ *
+ * 图全部在内存中，sync 和 close 时把整个图写到单独的索引文件中(先写临时文件再改名)，open 时读取出来。
+ * 修改不记录日志，异常重启后需要重建索引。
+ *
+ * 删除只做标记，被删除的节点仍然用于导航，不会出现在结果中。
+ * 查询之间可以并发，插入和删除互斥。
+ */
+class HnswIndex : public Index
+{
+public:
+  HnswIndex() = default;
+  virtual ~HnswIndex() noexcept;
+
+  bool is_vector_index() override { return true; }
+
+  /**
+   * @brief 设置创建索引的参数，需要在 create 之前调用
+   * @param m 每个节点在每一层的邻居个数
+   * @param ef_construction 插入时搜索的候选集大小，越大图的质量越好，插入越慢
+   * @param ef_search 查询时默认的候选集大小
+   */
+  void set_options(common::VectorDistanceType distance_type, int m, int ef_construction, int ef_search);
+
+  /**
+   * @brief 调整查询时默认的候选集大小
+   */
+  void set_ef_search(int ef_search);
+
+  common::VectorDistanceType distance_type() const { return distance_type_; }
+  int                        dimension() const { return dimension_; }
+  int                        m() const { return m_; }
+  int                        ef_construction() const { return ef_construction_; }
+  int                        ef_search() const { return ef_search_; }
+  int                        max_level() const { return max_level_; }
+  /// 节点的个数，包括已经删除的节点
+  int                        node_num() const { return static_cast<int>(nodes_.size()); }
+
+  RC create(
+      Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC open(
+      Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+
+  RC create(const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas);
+  RC open(const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas);
+  RC close();
+
+  RC insert_entry(const char *record, const RID *rid) override;
+  RC delete_entry(const char *record, const RID *rid) override;
+
+  /// 向量索引只支持近似查询
+  RC get_entry(const char *key, int key_len, list<RID> &rids) override { return RC::UNSUPPORTED; }
+  IndexScanner *create_scanner(const char *left_key, int left_len, bool left_inclusive, const char *right_key,
+      int right_len, bool right_inclusive) override
+  {
+    return nullptr;
+  }
+
+  RC ann_search(const float *query, size_t limit, vector<RID> &rids, vector<float> *distances = nullptr) override;
+
+  /**
+   * @brief 查找离 query 最近的 limit 个向量
+   * @param ef_search 候选集大小，小于等于0时使用默认值。实际使用的值不小于 limit
+   */
+  RC ann_search(const float *query, size_t limit, int ef_search, vector<RID> &rids, vector<float> *distances = nullptr);
+
+  RC sync() override;
+
+private:
+  /// 距离和节点编号
+  using DistanceNode = pair<float, int>;
+
+  struct Node
+  {
+    RID                 rid;
+    int                 level   = 0;
+    bool                deleted = false;
+    vector<vector<int>> neighbors;  ///< 每一层的邻居
+  };
+
+  RC init_field(const FieldMeta &field_meta);
+  RC load();
+  RC save();
+
+  int random_level();
+  int max_neighbors(int level) const { return level == 0 ? 2 * m_ : m_; }
+
+  const float *vector_of(int node) const { return vectors_.data() + static_cast<size_t>(node) * dimension_; }
+  float        distance(const float *query, int node) const;
+
+  /**
+   * @brief 在某一层中贪心地走到离 query 最近的节点
+   */
+  void greedy_search(const float *query, int level, int &node, float &node_distance) const;
+
+  /**
+   * @brief 在某一层中从 entry 开始做最佳优先搜索
+   * @return 最近的 ef 个节点，按照距离从近到远排列
+   */
+  vector<DistanceNode> search_layer(const float *query, int entry, float entry_distance, int ef, int level) const;
+
+  /**
+   * @brief 启发式地选择邻居
+   * @details 候选节点离已经选择的某个邻居比离自己更近时就跳过，这样邻居会分布在不同的方向上，
+   * 对聚集的数据召回率更高。内积距离直接选择最近的几个
+   * @param candidates 按照距离从近到远排列
+   */
+  vector<int> select_neighbors(const vector<DistanceNode> &candidates, int max_num) const;
+
+  /**
+   * @brief 把 neighbor 加入到 node 的邻居中，邻居太多时重新选择
+   */
+  void connect(int node, int neighbor, int level);
+
+private:
+  bool   inited_ = false;
+  Table *table_  = nullptr;
+  string file_name_;
+
+  common::VectorDistanceType distance_type_ = common::VectorDistanceType::L2;
+
+  int dimension_       = 0;
+  int m_               = 16;
+  int ef_construction_ = 200;
+  int ef_search_       = 64;
+
+  int entry_point_ = -1;  ///< 最高层的入口节点，没有节点时是-1
+  int max_level_   = -1;
+
+  vector<Node>                     nodes_;
+  vector<float>                    vectors_;      ///< 所有节点的向量，按照节点编号连续存放
+  unordered_map<RID, int, RIDHash> rid_to_node_;  ///< 没有删除的节点
+  mt19937                          level_random_{100};
+
+  common::SharedMutex lock_;
+};
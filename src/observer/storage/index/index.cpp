@@ -13,10 +13,112 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "storage/index/index.h"
+#include "common/lang/list.h"
+#include "common/log/log.h"
+#include "storage/common/column.h"
 
-RC Index::init(const IndexMeta &index_meta, const FieldMeta &field_meta)
+RC Index::init(const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
 {
-  index_meta_ = index_meta;
-  field_meta_ = field_meta;
+  index_meta_  = index_meta;
+  field_metas_ = field_metas;
+  key_length_  = 0;
+  for (const FieldMeta &field_meta : field_metas_) {
+    key_length_ += field_meta.len();
+  }
+  return RC::SUCCESS;
+}
+
+const char *Index::extract_key(const char *record, string &key_buffer) const
+{
+  if (field_metas_.size() == 1) {
+    return record + field_metas_.front().offset();
+  }
+
+  key_buffer.resize(key_length_);
+  int offset = 0;
+  for (const FieldMeta &field_meta : field_metas_) {
+    memcpy(key_buffer.data() + offset, record + field_meta.offset(), field_meta.len());
+    offset += field_meta.len();
+  }
+  return key_buffer.data();
+}
+
+RC Index::get_entries(const char *keys, int key_num, vector<RID> &rids, vector<int> *offsets /* = nullptr */)
+{
+  rids.clear();
+  if (offsets != nullptr) {
+    offsets->clear();
+    offsets->push_back(0);
+  }
+
+  list<RID> key_rids;
+  for (int i = 0; i < key_num; i++) {
+    key_rids.clear();
+    RC rc = get_entry(keys + static_cast<size_t>(i) * key_length_, key_length_, key_rids);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    rids.insert(rids.end(), key_rids.begin(), key_rids.end());
+    if (offsets != nullptr) {
+      offsets->push_back(static_cast<int>(rids.size()));
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC Index::get_entries(const Column &keys, vector<RID> &rids, vector<int> *offsets /* = nullptr */)
+{
+  if (field_metas_.size() != 1) {
+    LOG_WARN("batch lookup by column only supports single field index. index=%s", index_meta_.name());
+    return RC::UNSUPPORTED;
+  }
+
+  const FieldMeta &field_meta = field_metas_.front();
+  if (keys.attr_type() != field_meta.type()) {
+    LOG_WARN("column type mismatch. index=%s, column type=%s, field type=%s",
+        index_meta_.name(), attr_type_to_string(keys.attr_type()), attr_type_to_string(field_meta.type()));
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const bool constant = keys.column_type() == Column::Type::CONSTANT_COLUMN;
+  const int  key_num  = constant ? std::min(keys.count(), 1) : keys.count();
+
+  // 字符串列的长度可能与索引字段不同，按照索引字段的长度截断或者补0
+  const char *key_data = keys.data();
+  string      key_buffer;
+  if (keys.attr_len() != key_length_) {
+    if (keys.attr_type() != AttrType::CHARS) {
+      LOG_WARN("column length mismatch. index=%s, column length=%d, key length=%d",
+          index_meta_.name(), keys.attr_len(), key_length_);
+      return RC::INVALID_ARGUMENT;
+    }
+
+    key_buffer.assign(static_cast<size_t>(key_num) * key_length_, '\0');
+    for (int i = 0; i < key_num; i++) {
+      const char *value = keys.data() + static_cast<size_t>(i) * keys.attr_len();
+      memcpy(key_buffer.data() + static_cast<size_t>(i) * key_length_,
+          value,
+          std::min(keys.attr_len(), key_length_));
+    }
+    key_data = key_buffer.data();
+  }
+
+  RC rc = get_entries(key_data, key_num, rids, offsets);
+  if (OB_FAIL(rc) || !constant || keys.count() <= 1) {
+    return rc;
+  }
+
+  // 常量列的每一行都是同一个值，查询一次就够了
+  const size_t rid_num = rids.size();
+  rids.reserve(rid_num * keys.count());
+  for (int i = 1; i < keys.count(); i++) {
+    for (size_t j = 0; j < rid_num; j++) {
+      rids.push_back(rids[j]);
+    }
+    if (offsets != nullptr) {
+      offsets->push_back(static_cast<int>(rids.size()));
+    }
+  }
   return RC::SUCCESS;
 }
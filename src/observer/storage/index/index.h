@@ -17,11 +17,14 @@ See the Mulan PSL v2 for more details. */
 #include <stddef.h>
 #include <vector>
 
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
 #include "common/sys/rc.h"
 #include "storage/field/field_meta.h"
 #include "storage/index/index_meta.h"
 #include "storage/record/record_manager.h"
 
+class Column;
 class IndexScanner;
 
 /**
@@ -40,17 +43,30 @@ public:
   Index()          = default;
   virtual ~Index() = default;
 
-  virtual RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+  virtual RC create(
+      Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
   {
     return RC::UNSUPPORTED;
   }
-  virtual RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+  virtual RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
   {
     return RC::UNSUPPORTED;
   }
 
   virtual bool is_vector_index() { return false; }
 
+  /**
+   * @brief 向量索引的近似查询，查找离 query 最近的 limit 个向量
+   * @details 不同的向量索引使用各自默认的搜索参数，优化器可以用这个接口访问任意一种向量索引
+   * @param query 查询向量，维度与索引字段一致
+   * @param[out] rids 按照距离从近到远排列
+   * @param[out] distances 不为空时返回每个向量的距离
+   */
+  virtual RC ann_search(const float *query, size_t limit, vector<RID> &rids, vector<float> *distances = nullptr)
+  {
+    return RC::UNSUPPORTED;
+  }
+
   const IndexMeta &index_meta() const { return index_meta_; }
 
   /**
@@ -62,13 +78,29 @@ public:
   virtual RC insert_entry(const char *record, const RID *rid) = 0;
 
   /**
-   * @brief 查询指定记录对应的索引项
+   * @brief 查询指定键值对应的索引项
    *
-   * @param record 要查询的记录，假设记录是定长的
-   * @param key_len record 的长度
+   * @param key 要查询的键值，可以使用 extract_key 从记录中获取
+   * @param key_len key 的长度
    * @param[out] rids 返回所有匹配记录的位置
    */
-  virtual RC get_entry(const char *record, int key_len, std::list<RID> &rids) = 0;
+  virtual RC get_entry(const char *key, int key_len, std::list<RID> &rids) = 0;
+
+  /**
+   * @brief 批量查询多个键值对应的索引项
+   * @details 默认逐个调用 get_entry。键值按照从小到大的顺序排列时，支持批量查找的索引可以少做很多次查找
+   * @param keys key_num 个键值，每个键值的长度都是 key_length()
+   * @param key_num 键值的个数
+   * @param[out] rids 所有匹配记录的位置，按照键值的顺序连续存放
+   * @param[out] offsets 不为空时，第 i 个键值匹配的记录是 rids 中的 [offsets[i], offsets[i+1])
+   */
+  virtual RC get_entries(const char *keys, int key_num, vector<RID> &rids, vector<int> *offsets = nullptr);
+
+  /**
+   * @brief 批量查询一列数据中每个值对应的索引项
+   * @details 只支持单个字段的索引，列的类型需要与索引字段的类型一致
+   */
+  RC get_entries(const Column &keys, vector<RID> &rids, vector<int> *offsets = nullptr);
 
   /**
    * @brief 删除一条数据
@@ -97,16 +129,28 @@ public:
    */
   virtual RC sync() = 0;
 
-  void             set_unique(bool unique) { unique_ = unique; }
-  bool             is_unique() const { return unique_; }
-  const FieldMeta &field_meta() const { return field_meta_; }
+  void                     set_unique(bool unique) { unique_ = unique; }
+  bool                     is_unique() const { return unique_; }
+  /// 第一个字段
+  const FieldMeta         &field_meta() const { return field_metas_.front(); }
+  const vector<FieldMeta> &field_metas() const { return field_metas_; }
+  /// 键值的长度，即所有字段的长度之和
+  int                      key_length() const { return key_length_; }
+
+  /**
+   * @brief 从记录中取出索引的键值
+   * @details 键值是索引的各个字段按照顺序拼接起来的。只有一个字段时直接返回字段在记录中的位置，
+   * 否则把字段拷贝到 key_buffer 中
+   */
+  const char *extract_key(const char *record, string &key_buffer) const;
 
 protected:
-  RC init(const IndexMeta &index_meta, const FieldMeta &field_meta);
+  RC init(const IndexMeta &index_meta, const vector<FieldMeta> &field_metas);
 
 protected:
-  IndexMeta index_meta_;  ///< 索引的元数据
-  FieldMeta field_meta_;  ///< 当前实现仅考虑一个字段的索引
+  IndexMeta         index_meta_;   ///< 索引的元数据
+  vector<FieldMeta> field_metas_;  ///< 索引包含的字段，按照键值中的顺序排列
+  int               key_length_ = 0;
 
   bool unique_ = false;
 };
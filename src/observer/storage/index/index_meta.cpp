@@ -21,16 +21,30 @@ See the Mulan PSL v2 for more details. */
 
 const static Json::StaticString FIELD_NAME("name");
 const static Json::StaticString FIELD_FIELD_NAME("field_name");
+const static Json::StaticString FIELD_FIELD_NAMES("field_names");
 
 RC IndexMeta::init(const char *name, const FieldMeta &field, bool unique)
+{
+  return init(name, vector<const FieldMeta *>{&field}, unique);
+}
+
+RC IndexMeta::init(const char *name, const vector<const FieldMeta *> &fields, bool unique)
 {
   if (common::is_blank(name)) {
     LOG_ERROR("Failed to init index, name is empty.");
     return RC::INVALID_ARGUMENT;
   }
 
-  name_   = name;
-  field_  = field.name();
+  if (fields.empty()) {
+    LOG_ERROR("Failed to init index, no field. name=%s", name);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  name_ = name;
+  fields_.clear();
+  for (const FieldMeta *field : fields) {
+    fields_.emplace_back(field->name());
+  }
   unique_ = unique;
   return RC::SUCCESS;
 }
@@ -38,35 +52,65 @@ RC IndexMeta::init(const char *name, const FieldMeta &field, bool unique)
 void IndexMeta::to_json(Json::Value &json_value) const
 {
   json_value[FIELD_NAME]       = name_;
-  json_value[FIELD_FIELD_NAME] = field_;
+  json_value[FIELD_FIELD_NAME] = fields_.front();
+
+  // 旧版本只记录了一个字段，这里保留 field_name，多个字段记录在 field_names 中
+  Json::Value fields_value(Json::arrayValue);
+  for (const string &field : fields_) {
+    fields_value.append(field);
+  }
+  json_value[FIELD_FIELD_NAMES] = std::move(fields_value);
 }
 
 RC IndexMeta::from_json(const TableMeta &table, const Json::Value &json_value, IndexMeta &index)
 {
-  const Json::Value &name_value  = json_value[FIELD_NAME];
-  const Json::Value &field_value = json_value[FIELD_FIELD_NAME];
+  const Json::Value &name_value   = json_value[FIELD_NAME];
+  const Json::Value &field_value  = json_value[FIELD_FIELD_NAME];
+  const Json::Value &fields_value = json_value[FIELD_FIELD_NAMES];
   if (!name_value.isString()) {
     LOG_ERROR("Index name is not a string. json value=%s", name_value.toStyledString().c_str());
     return RC::INTERNAL;
   }
 
-  if (!field_value.isString()) {
-    LOG_ERROR("Field name of index [%s] is not a string. json value=%s",
-        name_value.asCString(), field_value.toStyledString().c_str());
-    return RC::INTERNAL;
+  vector<const Json::Value *> field_values;
+  if (fields_value.isArray()) {
+    for (const Json::Value &value : fields_value) {
+      field_values.push_back(&value);
+    }
+  } else {
+    field_values.push_back(&field_value);
   }
 
-  const FieldMeta *field = table.field(field_value.asCString());
-  if (nullptr == field) {
-    LOG_ERROR("Deserialize index [%s]: no such field: %s", name_value.asCString(), field_value.asCString());
-    return RC::SCHEMA_FIELD_MISSING;
+  vector<const FieldMeta *> fields;
+  for (const Json::Value *value : field_values) {
+    if (!value->isString()) {
+      LOG_ERROR("Field name of index [%s] is not a string. json value=%s",
+          name_value.asCString(), value->toStyledString().c_str());
+      return RC::INTERNAL;
+    }
+
+    const FieldMeta *field = table.field(value->asCString());
+    if (nullptr == field) {
+      LOG_ERROR("Deserialize index [%s]: no such field: %s", name_value.asCString(), value->asCString());
+      return RC::SCHEMA_FIELD_MISSING;
+    }
+    fields.push_back(field);
   }
 
-  return index.init(name_value.asCString(), *field);
+  return index.init(name_value.asCString(), fields);
 }
 
 const char *IndexMeta::name() const { return name_.c_str(); }
 
-const char *IndexMeta::field() const { return field_.c_str(); }
+const char *IndexMeta::field() const { return fields_.empty() ? "" : fields_.front().c_str(); }
 
-void IndexMeta::desc(ostream &os) const { os << "index name=" << name_ << ", field=" << field_; }
\ No newline at end of file
+void IndexMeta::desc(ostream &os) const
+{
+  os << "index name=" << name_ << ", field=";
+  for (size_t i = 0; i < fields_.size(); i++) {
+    if (i > 0) {
+      os << ",";
+    }
+    os << fields_[i];
+  }
+}
@@ -16,6 +16,7 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/sys/rc.h"
 #include "common/lang/string.h"
+#include "common/lang/vector.h"
 
 class TableMeta;
 class FieldMeta;
@@ -27,7 +28,7 @@ class Value;
 /**
  * @brief 描述一个索引
  * @ingroup Index
- * @details 一个索引包含了表的哪些字段，索引的名称等。
+ * @details 一个索引包含了表的哪些字段，索引的名称等。索引可以包含多个字段，字段的顺序就是键值比较的顺序。
  * 如果以后实现了多种类型的索引，还需要记录索引的类型，对应类型的一些元数据等
  */
 class IndexMeta
@@ -36,11 +37,15 @@ public:
   IndexMeta() = default;
 
   RC init(const char *name, const FieldMeta &field, bool unique = false);
+  RC init(const char *name, const vector<const FieldMeta *> &fields, bool unique = false);
 
 public:
-  const char *name() const;
-  const char *field() const;
-  bool        is_unique() const { return unique_; }
+  const char           *name() const;
+  /// 第一个字段的名字
+  const char           *field() const;
+  const vector<string> &fields() const { return fields_; }
+  int                   field_num() const { return static_cast<int>(fields_.size()); }
+  bool                  is_unique() const { return unique_; }
 
   void desc(ostream &os) const;
 
@@ -49,7 +54,7 @@ public:
   static RC from_json(const TableMeta &table, const Json::Value &json_value, IndexMeta &index);
 
 protected:
-  string name_;   // index's name
-  string field_;  // field's name
-  bool   unique_ = false;
+  string         name_;    // index's name
+  vector<string> fields_;  // fields' name
+  bool           unique_ = false;
 };
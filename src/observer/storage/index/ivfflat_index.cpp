@@ -0,0 +1,894 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <math.h>
+
+#include "storage/index/ivfflat_index.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/defer.h"
+#include "common/lang/limits.h"
+#include "common/lang/queue.h"
+#include "common/lang/random.h"
+#include "common/lang/sstream.h"
+#include "common/lang/utility.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/db/db.h"
+#include "storage/table/table.h"
+
+using namespace common;
+
+#define IVFFLAT_HEADER_PAGE 1
+
+namespace {
+
+/// k-means 最多迭代的次数
+constexpr int KMEANS_MAX_ITERATIONS = 20;
+/// 每个聚类中心最多使用这么多个样本参与训练
+constexpr int KMEANS_MAX_SAMPLES_PER_LIST = 256;
+
+/**
+ * @brief 获取页面并加锁，析构时自动释放
+ */
+class PageGuard
+{
+public:
+  explicit PageGuard(DiskBufferPool &buffer_pool) : buffer_pool_(buffer_pool) {}
+  ~PageGuard() { release(); }
+
+  RC fetch(PageNum page_num, bool write)
+  {
+    release();
+    RC rc = buffer_pool_.get_this_page(page_num, &frame_);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get page. page num=%d, rc=%s", page_num, strrc(rc));
+      frame_ = nullptr;
+      return rc;
+    }
+    latch(write);
+    return RC::SUCCESS;
+  }
+
+  RC allocate()
+  {
+    release();
+    RC rc = buffer_pool_.allocate_page(&frame_);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to allocate page. rc=%s", strrc(rc));
+      frame_ = nullptr;
+      return rc;
+    }
+    latch(true /*write*/);
+    frame_->mark_dirty();
+    return RC::SUCCESS;
+  }
+
+  void release()
+  {
+    if (frame_ == nullptr) {
+      return;
+    }
+    if (write_) {
+      frame_->write_unlatch();
+    } else {
+      frame_->read_unlatch();
+    }
+    buffer_pool_.unpin_page(frame_);
+    frame_ = nullptr;
+  }
+
+  PageNum page_num() const { return frame_->page_num(); }
+  char   *data() const { return frame_->data(); }
+  void    mark_dirty() { frame_->mark_dirty(); }
+
+  template <typename T>
+  T *as() const
+  {
+    return reinterpret_cast<T *>(frame_->data());
+  }
+
+private:
+  void latch(bool write)
+  {
+    write_ = write;
+    if (write) {
+      frame_->write_latch();
+    } else {
+      frame_->read_latch();
+    }
+  }
+
+private:
+  DiskBufferPool &buffer_pool_;
+  Frame          *frame_ = nullptr;
+  bool            write_ = false;
+};
+
+/**
+ * @brief 查询时的候选结果，按照距离组成大顶堆
+ */
+struct Candidate
+{
+  float distance;
+  RID   rid;
+
+  bool operator<(const Candidate &other) const { return distance < other.distance; }
+};
+
+void normalize(float *vector, int dim)
+{
+  const float norm = sqrtf(inner_product(vector, vector, dim));
+  if (norm > 0) {
+    for (int i = 0; i < dim; i++) {
+      vector[i] /= norm;
+    }
+  }
+}
+
+/**
+ * @brief 使用 k-means 计算 k 个聚类中心
+ * @details 使用 k-means++ 选择初始的聚类中心，然后迭代到分配不再变化或者达到最大的迭代次数。
+ * 某个聚类中心没有分配到任何向量时，就把离自己的聚类中心最远的向量拿过来作为新的聚类中心
+ */
+void kmeans(VectorDistanceType distance_type, const vector<const float *> &samples, int dim, int k,
+    vector<float> &centroids)
+{
+  const int sample_num = static_cast<int>(samples.size());
+  centroids.assign(static_cast<size_t>(k) * dim, 0.0f);
+
+  // k-means++：按照与已有聚类中心距离的平方的比例，随机选择下一个聚类中心
+  mt19937       random(k);
+  vector<float> min_distances(sample_num, numeric_limits<float>::max());
+  int           chosen = uniform_int_distribution<int>(0, sample_num - 1)(random);
+  for (int c = 0; c < k; c++) {
+    float *centroid = centroids.data() + static_cast<size_t>(c) * dim;
+    memcpy(centroid, samples[chosen], dim * sizeof(float));
+
+    double total = 0;
+    for (int i = 0; i < sample_num; i++) {
+      min_distances[i] = std::min(min_distances[i], l2_distance(samples[i], centroid, dim));
+      total += min_distances[i];
+    }
+
+    if (total <= 0) {
+      chosen = uniform_int_distribution<int>(0, sample_num - 1)(random);
+      continue;
+    }
+    double target = uniform_real_distribution<double>(0, total)(random);
+    chosen        = sample_num - 1;
+    for (int i = 0; i < sample_num; i++) {
+      target -= min_distances[i];
+      if (target <= 0) {
+        chosen = i;
+        break;
+      }
+    }
+  }
+
+  vector<int>    assignments(sample_num, -1);
+  vector<float>  distances(sample_num, 0.0f);
+  vector<double> sums(static_cast<size_t>(k) * dim);
+  vector<int>    counts(k);
+  for (int iteration = 0; iteration < KMEANS_MAX_ITERATIONS; iteration++) {
+    int changed = 0;
+    for (int i = 0; i < sample_num; i++) {
+      int   best          = 0;
+      float best_distance = numeric_limits<float>::max();
+      for (int c = 0; c < k; c++) {
+        const float distance =
+            vector_distance(distance_type, samples[i], centroids.data() + static_cast<size_t>(c) * dim, dim);
+        if (distance < best_distance) {
+          best          = c;
+          best_distance = distance;
+        }
+      }
+      if (assignments[i] != best) {
+        assignments[i] = best;
+        changed++;
+      }
+      distances[i] = best_distance;
+    }
+
+    if (changed == 0) {
+      break;
+    }
+
+    std::fill(sums.begin(), sums.end(), 0.0);
+    std::fill(counts.begin(), counts.end(), 0);
+    for (int i = 0; i < sample_num; i++) {
+      double *sum = sums.data() + static_cast<size_t>(assignments[i]) * dim;
+      for (int d = 0; d < dim; d++) {
+        sum[d] += samples[i][d];
+      }
+      counts[assignments[i]]++;
+    }
+
+    for (int c = 0; c < k; c++) {
+      float *centroid = centroids.data() + static_cast<size_t>(c) * dim;
+      if (counts[c] == 0) {
+        const int farthest = static_cast<int>(std::max_element(distances.begin(), distances.end()) - distances.begin());
+        memcpy(centroid, samples[farthest], dim * sizeof(float));
+        distances[farthest] = 0;
+        continue;
+      }
+
+      const double *sum = sums.data() + static_cast<size_t>(c) * dim;
+      for (int d = 0; d < dim; d++) {
+        centroid[d] = static_cast<float>(sum[d] / counts[c]);
+      }
+      if (distance_type == VectorDistanceType::COSINE) {
+        normalize(centroid, dim);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+const string IvfflatIndexFileHeader::to_string() const
+{
+  stringstream ss;
+  ss << "dimension:" << dimension << ";"
+     << "distance type:" << vector_distance_type_name(static_cast<VectorDistanceType>(distance_type)) << ";"
+     << "lists:" << lists << ";"
+     << "probes:" << probes << ";"
+     << "trained:" << trained << ";"
+     << "directory page:" << directory_page << ";";
+  return ss.str();
+}
+
+IvfflatIndex::~IvfflatIndex() noexcept { close(); }
+
+void IvfflatIndex::set_options(VectorDistanceType distance_type, int lists, int probes)
+{
+  distance_type_ = distance_type;
+  lists_         = std::max(lists, 1);
+  probes_        = std::max(probes, 1);
+}
+
+void IvfflatIndex::set_probes(int probes) { probes_ = std::max(probes, 1); }
+
+int IvfflatIndex::directory_page_capacity() const
+{
+  return (BP_PAGE_DATA_SIZE - static_cast<int>(sizeof(IvfflatDirectoryPage))) / directory_entry_size();
+}
+
+int IvfflatIndex::list_page_capacity() const
+{
+  return (BP_PAGE_DATA_SIZE - static_cast<int>(sizeof(IvfflatListPage))) / list_entry_size();
+}
+
+RC IvfflatIndex::create(
+    Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  RC rc = create(table->db()->log_handler(), table->db()->buffer_pool_manager(), file_name, index_meta, field_metas);
+  if (OB_SUCC(rc)) {
+    table_ = table;
+  }
+  return rc;
+}
+
+RC IvfflatIndex::open(
+    Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  RC rc = open(table->db()->log_handler(), table->db()->buffer_pool_manager(), file_name, index_meta, field_metas);
+  if (OB_SUCC(rc)) {
+    table_ = table;
+  }
+  return rc;
+}
+
+RC IvfflatIndex::init_file_header(const FieldMeta &field_meta)
+{
+  if (field_meta.type() != AttrType::VECTORS) {
+    LOG_WARN("ivfflat index only supports vector field. field=%s, type=%s",
+             field_meta.name(), attr_type_to_string(field_meta.type()));
+    return RC::SCHEMA_FIELD_TYPE_MISMATCH;
+  }
+
+  dimension_ = field_meta.len() / static_cast<int>(sizeof(float));
+  if (dimension_ <= 0 || list_page_capacity() <= 0 || directory_page_capacity() <= 0) {
+    LOG_WARN("invalid vector dimension for ivfflat index. field=%s, dimension=%d", field_meta.name(), dimension_);
+    return RC::INVALID_ARGUMENT;
+  }
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::create(LogHandler &log_handler, BufferPoolManager &bpm, const char *file_name,
+    const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (inited_) {
+    LOG_WARN("Failed to create index due to the index has been created before. file_name:%s, index:%s",
+        file_name, index_meta.name());
+    return RC::RECORD_OPENNED;
+  }
+
+  if (field_metas.size() != 1) {
+    LOG_WARN("ivfflat index only supports one field. index=%s", index_meta.name());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  Index::init(index_meta, field_metas);
+
+  RC rc = init_file_header(field_metas.front());
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  rc = bpm.create_file(file_name);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to create file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  rc = bpm.open_file(log_handler, file_name, disk_buffer_pool_);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to open file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  PageGuard header_page(*disk_buffer_pool_);
+  rc = header_page.allocate();
+  if (OB_FAIL(rc)) {
+    close();
+    return rc;
+  }
+  if (header_page.page_num() != IVFFLAT_HEADER_PAGE) {
+    LOG_WARN("header page num should be %d but got %d. is it a new file", IVFFLAT_HEADER_PAGE, header_page.page_num());
+    header_page.release();
+    close();
+    return RC::INTERNAL;
+  }
+  header_page.release();
+
+  trained_        = false;
+  directory_page_ = BP_INVALID_PAGE_NUM;
+  centroids_.clear();
+  list_infos_.clear();
+
+  rc = write_file_header();
+  if (OB_FAIL(rc)) {
+    close();
+    return rc;
+  }
+
+  inited_ = true;
+  LOG_INFO("Successfully create ivfflat index. file_name:%s, index:%s, dimension:%d, distance:%s, lists:%d, probes:%d",
+      file_name, index_meta.name(), dimension_, vector_distance_type_name(distance_type_), lists_, probes_);
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::open(LogHandler &log_handler, BufferPoolManager &bpm, const char *file_name,
+    const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (inited_) {
+    LOG_WARN("Failed to open index due to the index has been opened before. file_name:%s, index:%s",
+        file_name, index_meta.name());
+    return RC::RECORD_OPENNED;
+  }
+
+  if (field_metas.size() != 1) {
+    LOG_WARN("ivfflat index only supports one field. index=%s", index_meta.name());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  Index::init(index_meta, field_metas);
+
+  RC rc = init_file_header(field_metas.front());
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  rc = bpm.open_file(log_handler, file_name, disk_buffer_pool_);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to open file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  IvfflatIndexFileHeader file_header;
+  {
+    PageGuard header_page(*disk_buffer_pool_);
+    rc = header_page.fetch(IVFFLAT_HEADER_PAGE, false /*write*/);
+    if (OB_FAIL(rc)) {
+      close();
+      return rc;
+    }
+    memcpy(&file_header, header_page.data(), sizeof(file_header));
+  }
+
+  if (file_header.dimension != dimension_) {
+    LOG_WARN("dimension mismatch. file header=%s, field dimension=%d", file_header.to_string().c_str(), dimension_);
+    close();
+    return RC::INTERNAL;
+  }
+
+  distance_type_  = static_cast<VectorDistanceType>(file_header.distance_type);
+  lists_          = file_header.lists;
+  probes_         = file_header.probes;
+  trained_        = file_header.trained != 0;
+  directory_page_ = file_header.directory_page;
+
+  rc = load_directory();
+  if (OB_FAIL(rc)) {
+    close();
+    return rc;
+  }
+
+  inited_ = true;
+  LOG_INFO("Successfully open ivfflat index. file_name:%s, index:%s, header:%s",
+      file_name, index_meta.name(), file_header.to_string().c_str());
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::close()
+{
+  if (disk_buffer_pool_ != nullptr) {
+    // 页面的修改没有记录日志，关闭文件时不会刷脏页，需要自己刷下去
+    RC rc = disk_buffer_pool_->flush_all_pages();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to flush ivfflat index pages. rc=%s", strrc(rc));
+    }
+    disk_buffer_pool_->close_file();
+  }
+
+  disk_buffer_pool_ = nullptr;
+  inited_           = false;
+  centroids_.clear();
+  list_infos_.clear();
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::load_directory()
+{
+  centroids_.clear();
+  list_infos_.clear();
+  if (!trained_) {
+    return RC::SUCCESS;
+  }
+
+  const int entry_size = directory_entry_size();
+
+  PageGuard page(*disk_buffer_pool_);
+  for (PageNum page_num = directory_page_; page_num != BP_INVALID_PAGE_NUM;) {
+    RC rc = page.fetch(page_num, false /*write*/);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    const IvfflatDirectoryPage *directory_page = page.as<IvfflatDirectoryPage>();
+    for (int i = 0; i < directory_page->entry_num; i++) {
+      auto *entry = reinterpret_cast<const IvfflatDirectoryEntry *>(directory_page->entries + i * entry_size);
+
+      ListInfo info;
+      info.head_page       = entry->head_page;
+      info.tail_page       = entry->tail_page;
+      info.vector_num      = entry->vector_num;
+      info.directory_page  = page_num;
+      info.directory_index = i;
+      list_infos_.push_back(info);
+      centroids_.insert(centroids_.end(), entry->centroid, entry->centroid + dimension_);
+    }
+    page_num = directory_page->next_page;
+  }
+
+  if (static_cast<int>(list_infos_.size()) != lists_) {
+    LOG_WARN("ivfflat directory is broken. expect lists=%d, got=%d", lists_, static_cast<int>(list_infos_.size()));
+    return RC::INTERNAL;
+  }
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::write_file_header()
+{
+  PageGuard header_page(*disk_buffer_pool_);
+  RC        rc = header_page.fetch(IVFFLAT_HEADER_PAGE, true /*write*/);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  IvfflatIndexFileHeader *file_header = header_page.as<IvfflatIndexFileHeader>();
+  file_header->dimension              = dimension_;
+  file_header->distance_type          = static_cast<int32_t>(distance_type_);
+  file_header->lists                  = lists_;
+  file_header->probes                 = probes_;
+  file_header->trained                = trained_ ? 1 : 0;
+  file_header->directory_page         = directory_page_;
+  header_page.mark_dirty();
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::write_directory_entry(int list)
+{
+  const ListInfo &info = list_infos_[list];
+
+  PageGuard page(*disk_buffer_pool_);
+  RC        rc = page.fetch(info.directory_page, true /*write*/);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  auto *entry = reinterpret_cast<IvfflatDirectoryEntry *>(
+      page.as<IvfflatDirectoryPage>()->entries + info.directory_index * directory_entry_size());
+  entry->head_page  = info.head_page;
+  entry->tail_page  = info.tail_page;
+  entry->vector_num = info.vector_num;
+  page.mark_dirty();
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::train(const float *vectors, int num)
+{
+  lock_.lock();
+  DEFER(lock_.unlock());
+
+  if (!inited_) {
+    LOG_WARN("ivfflat index is not inited");
+    return RC::INTERNAL;
+  }
+  if (trained_) {
+    LOG_WARN("ivfflat index has been trained. index=%s", index_meta_.name());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  // 样本太多时随机选择一部分，训练的结果差别不大
+  vector<const float *> samples(num);
+  for (int i = 0; i < num; i++) {
+    samples[i] = vectors + static_cast<size_t>(i) * dimension_;
+  }
+  const int lists = std::max(1, std::min(lists_, num));
+  if (num > lists * KMEANS_MAX_SAMPLES_PER_LIST) {
+    std::shuffle(samples.begin(), samples.end(), mt19937(num));
+    samples.resize(lists * KMEANS_MAX_SAMPLES_PER_LIST);
+  }
+
+  if (samples.empty()) {
+    centroids_.assign(dimension_, 0.0f);
+  } else {
+    kmeans(distance_type_, samples, dimension_, lists, centroids_);
+  }
+
+  // 所有的聚类中心写到目录页面中
+  const int entry_size = directory_entry_size();
+  const int capacity   = directory_page_capacity();
+
+  list_infos_.assign(lists, ListInfo());
+  PageGuard prev_page(*disk_buffer_pool_);
+  for (int list = 0; list < lists; list += capacity) {
+    PageGuard page(*disk_buffer_pool_);
+    RC        rc = page.allocate();
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    IvfflatDirectoryPage *directory_page = page.as<IvfflatDirectoryPage>();
+    directory_page->next_page            = BP_INVALID_PAGE_NUM;
+    directory_page->entry_num            = std::min(capacity, lists - list);
+    for (int i = 0; i < directory_page->entry_num; i++) {
+      auto *entry       = reinterpret_cast<IvfflatDirectoryEntry *>(directory_page->entries + i * entry_size);
+      entry->head_page  = BP_INVALID_PAGE_NUM;
+      entry->tail_page  = BP_INVALID_PAGE_NUM;
+      entry->vector_num = 0;
+      memcpy(entry->centroid,
+          centroids_.data() + static_cast<size_t>(list + i) * dimension_,
+          dimension_ * sizeof(float));
+
+      list_infos_[list + i].directory_page  = page.page_num();
+      list_infos_[list + i].directory_index = i;
+    }
+
+    if (list == 0) {
+      directory_page_ = page.page_num();
+    } else {
+      prev_page.as<IvfflatDirectoryPage>()->next_page = page.page_num();
+      prev_page.mark_dirty();
+    }
+
+    const PageNum page_num = page.page_num();
+    page.release();
+    prev_page.release();
+    rc = prev_page.fetch(page_num, true /*write*/);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+  prev_page.release();
+
+  lists_   = lists;
+  trained_ = true;
+  RC rc    = write_file_header();
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  LOG_INFO("ivfflat index trained. index=%s, vectors=%d, samples=%d, lists=%d",
+      index_meta_.name(), num, static_cast<int>(samples.size()), lists_);
+  return RC::SUCCESS;
+}
+
+int IvfflatIndex::nearest_list(const float *vector) const
+{
+  int   best          = 0;
+  float best_distance = numeric_limits<float>::max();
+  for (int list = 0; list < lists_; list++) {
+    const float distance =
+        vector_distance(distance_type_, vector, centroids_.data() + static_cast<size_t>(list) * dimension_, dimension_);
+    if (distance < best_distance) {
+      best          = list;
+      best_distance = distance;
+    }
+  }
+  return best;
+}
+
+RC IvfflatIndex::insert_entry(const char *record, const RID *rid)
+{
+  lock_.lock();
+  DEFER(lock_.unlock());
+
+  if (!trained_) {
+    LOG_WARN("ivfflat index should be trained before inserting. index=%s", index_meta_.name());
+    return RC::INTERNAL;
+  }
+
+  string       key_buffer;
+  const float *vector = reinterpret_cast<const float *>(extract_key(record, key_buffer));
+  return append_to_list(nearest_list(vector), vector, *rid);
+}
+
+RC IvfflatIndex::append_to_list(int list, const float *vector, const RID &rid)
+{
+  ListInfo &info = list_infos_[list];
+
+  PageGuard tail_page(*disk_buffer_pool_);
+  PageGuard new_page(*disk_buffer_pool_);
+  PageGuard *target = &tail_page;
+
+  RC rc = RC::SUCCESS;
+  if (info.tail_page != BP_INVALID_PAGE_NUM) {
+    rc = tail_page.fetch(info.tail_page, true /*write*/);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+
+  if (info.tail_page == BP_INVALID_PAGE_NUM || tail_page.as<IvfflatListPage>()->entry_num >= list_page_capacity()) {
+    rc = new_page.allocate();
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    IvfflatListPage *list_page = new_page.as<IvfflatListPage>();
+    list_page->next_page       = BP_INVALID_PAGE_NUM;
+    list_page->prev_page       = info.tail_page;
+    list_page->entry_num       = 0;
+
+    if (info.tail_page == BP_INVALID_PAGE_NUM) {
+      info.head_page = new_page.page_num();
+    } else {
+      tail_page.as<IvfflatListPage>()->next_page = new_page.page_num();
+      tail_page.mark_dirty();
+    }
+    info.tail_page = new_page.page_num();
+    target         = &new_page;
+  }
+
+  IvfflatListPage *list_page = target->as<IvfflatListPage>();
+  char            *entry     = list_page->entries + list_page->entry_num * list_entry_size();
+  memcpy(entry, &rid, sizeof(RID));
+  memcpy(entry + sizeof(RID), vector, dimension_ * sizeof(float));
+  list_page->entry_num++;
+  target->mark_dirty();
+
+  info.vector_num++;
+  return write_directory_entry(list);
+}
+
+RC IvfflatIndex::delete_entry(const char *record, const RID *rid)
+{
+  lock_.lock();
+  DEFER(lock_.unlock());
+
+  if (!trained_) {
+    return RC::RECORD_NOT_EXIST;
+  }
+
+  string       key_buffer;
+  const float *vector = reinterpret_cast<const float *>(extract_key(record, key_buffer));
+
+  // 插入时使用的是最近的聚类中心，通常在这个倒排表中就能找到
+  const int nearest = nearest_list(vector);
+  bool      found   = false;
+  RC        rc      = remove_from_list(nearest, *rid, found);
+  for (int list = 0; OB_SUCC(rc) && !found && list < lists_; list++) {
+    if (list != nearest) {
+      rc = remove_from_list(list, *rid, found);
+    }
+  }
+
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  return found ? RC::SUCCESS : RC::RECORD_NOT_EXIST;
+}
+
+/**
+ * 找到之后，用倒排表最后一个元素填上删除的位置。最后一个页面空了就释放掉
+ */
+RC IvfflatIndex::remove_from_list(int list, const RID &rid, bool &found)
+{
+  ListInfo &info       = list_infos_[list];
+  const int entry_size = list_entry_size();
+
+  found = false;
+
+  PageGuard page(*disk_buffer_pool_);
+  int       index = -1;
+  for (PageNum page_num = info.head_page; page_num != BP_INVALID_PAGE_NUM && index < 0;) {
+    RC rc = page.fetch(page_num, true /*write*/);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    const IvfflatListPage *list_page = page.as<IvfflatListPage>();
+    for (int i = 0; i < list_page->entry_num; i++) {
+      if (0 == memcmp(list_page->entries + i * entry_size, &rid, sizeof(RID))) {
+        index = i;
+        break;
+      }
+    }
+    if (index < 0) {
+      page_num = list_page->next_page;
+    }
+  }
+
+  if (index < 0) {
+    return RC::SUCCESS;
+  }
+
+  found = true;
+
+  PageGuard  tail_page(*disk_buffer_pool_);
+  PageGuard *tail = &page;
+  if (page.page_num() != info.tail_page) {
+    RC rc = tail_page.fetch(info.tail_page, true /*write*/);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    tail = &tail_page;
+  }
+
+  IvfflatListPage *tail_list_page = tail->as<IvfflatListPage>();
+  const int        last           = tail_list_page->entry_num - 1;
+  if (tail != &page || index != last) {
+    memcpy(page.as<IvfflatListPage>()->entries + index * entry_size,
+        tail_list_page->entries + last * entry_size,
+        entry_size);
+  }
+  tail_list_page->entry_num--;
+  page.mark_dirty();
+  tail->mark_dirty();
+
+  if (tail_list_page->entry_num == 0 && info.tail_page != info.head_page) {
+    const PageNum empty_page_num = info.tail_page;
+    const PageNum prev_page_num  = tail_list_page->prev_page;
+    tail_page.release();
+    page.release();
+
+    PageGuard prev_page(*disk_buffer_pool_);
+    RC        rc = prev_page.fetch(prev_page_num, true /*write*/);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    prev_page.as<IvfflatListPage>()->next_page = BP_INVALID_PAGE_NUM;
+    prev_page.mark_dirty();
+    prev_page.release();
+
+    info.tail_page = prev_page_num;
+    rc             = disk_buffer_pool_->dispose_page(empty_page_num);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to dispose empty list page. page num=%d, rc=%s", empty_page_num, strrc(rc));
+    }
+  }
+
+  info.vector_num--;
+  return write_directory_entry(list);
+}
+
+RC IvfflatIndex::ann_search(
+    const float *query, size_t limit, int probes, vector<RID> &rids, vector<float> *distances /* = nullptr */)
+{
+  rids.clear();
+  if (distances != nullptr) {
+    distances->clear();
+  }
+
+  lock_.lock_shared();
+  DEFER(lock_.unlock_shared());
+
+  if (!inited_ || !trained_ || limit == 0) {
+    return RC::SUCCESS;
+  }
+
+  // 先找到离查询向量最近的几个聚类中心
+  probes = std::min(probes <= 0 ? probes_ : probes, lists_);
+  vector<pair<float, int>> centroid_distances(lists_);
+  for (int list = 0; list < lists_; list++) {
+    centroid_distances[list] = {
+        vector_distance(distance_type_, query, centroids_.data() + static_cast<size_t>(list) * dimension_, dimension_),
+        list};
+  }
+  std::partial_sort(centroid_distances.begin(), centroid_distances.begin() + probes, centroid_distances.end());
+
+  // 在这些聚类中心的倒排表中找最近的 limit 个向量
+  const int                 entry_size = list_entry_size();
+  priority_queue<Candidate> candidates;
+  PageGuard                 page(*disk_buffer_pool_);
+  for (int probe = 0; probe < probes; probe++) {
+    const ListInfo &info = list_infos_[centroid_distances[probe].second];
+    for (PageNum page_num = info.head_page; page_num != BP_INVALID_PAGE_NUM;) {
+      RC rc = page.fetch(page_num, false /*write*/);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+
+      const IvfflatListPage *list_page = page.as<IvfflatListPage>();
+      for (int i = 0; i < list_page->entry_num; i++) {
+        const char  *entry    = list_page->entries + i * entry_size;
+        const float *vector   = reinterpret_cast<const float *>(entry + sizeof(RID));
+        const float  distance = vector_distance(distance_type_, query, vector, dimension_);
+        if (candidates.size() < limit) {
+          candidates.push(Candidate{distance, *reinterpret_cast<const RID *>(entry)});
+        } else if (distance < candidates.top().distance) {
+          candidates.pop();
+          candidates.push(Candidate{distance, *reinterpret_cast<const RID *>(entry)});
+        }
+      }
+      page_num = list_page->next_page;
+    }
+  }
+  page.release();
+
+  rids.resize(candidates.size());
+  if (distances != nullptr) {
+    distances->resize(candidates.size());
+  }
+  for (int i = static_cast<int>(candidates.size()) - 1; i >= 0; i--) {
+    rids[i] = candidates.top().rid;
+    if (distances != nullptr) {
+      (*distances)[i] = candidates.top().distance;
+    }
+    candidates.pop();
+  }
+  return RC::SUCCESS;
+}
+
+vector<RID> IvfflatIndex::ann_search(const vector<float> &base_vector, size_t limit)
+{
+  vector<RID> rids;
+  if (static_cast<int>(base_vector.size()) != dimension_) {
+    LOG_WARN("dimension mismatch. query dimension=%d, index dimension=%d",
+        static_cast<int>(base_vector.size()), dimension_);
+    return rids;
+  }
+
+  RC rc = ann_search(base_vector.data(), limit, 0 /*probes*/, rids);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to search ivfflat index. rc=%s", strrc(rc));
+  }
+  return rids;
+}
+
+RC IvfflatIndex::sync()
+{
+  if (disk_buffer_pool_ == nullptr) {
+    return RC::SUCCESS;
+  }
+  return disk_buffer_pool_->flush_all_pages();
+}
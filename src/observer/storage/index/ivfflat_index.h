@@ -10,40 +10,199 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include "common/lang/mutex.h"
+#include "common/lang/vector.h"
+#include "common/math/vector_distance.h"
+#include "storage/buffer/page.h"
 #include "storage/index/index.h"
 
+class BufferPoolManager;
+class DiskBufferPool;
+class LogHandler;
+
+/**
+ * @brief ivfflat 索引文件的第一个页面
+ * @ingroup Index
+ */
+struct IvfflatIndexFileHeader
+{
+  int32_t dimension;       ///< 向量的维度
+  int32_t distance_type;   ///< 距离的计算方式，参考 common::VectorDistanceType
+  int32_t lists;           ///< 聚类中心的个数，每个聚类中心对应一个倒排表。训练之前是期望的个数
+  int32_t probes;          ///< 查询时默认搜索多少个倒排表
+  int32_t trained;         ///< 是否已经训练出了聚类中心
+  PageNum directory_page;  ///< 第一个目录页面
+
+  const string to_string() const;
+};
+
+/**
+ * @brief ivfflat 的目录页面，记录了所有的聚类中心和倒排表的位置
+ * @ingroup Index
+ * @code
+ * | next page | entry num | entry0 | entry1 | ... |
+ * entry: | head page | tail page | vector num | centroid |
+ * @endcode
+ */
+struct IvfflatDirectoryPage
+{
+  PageNum next_page;
+  int32_t entry_num;
+  char    entries[0];
+};
+
+struct IvfflatDirectoryEntry
+{
+  PageNum head_page;   ///< 倒排表的第一个页面
+  PageNum tail_page;   ///< 倒排表的最后一个页面，插入的数据都追加到这里
+  int32_t vector_num;  ///< 倒排表中向量的个数
+  float   centroid[0];
+};
+
+/**
+ * @brief ivfflat 的倒排表页面。一个倒排表由多个页面组成双向链表
+ * @ingroup Index
+ * @code
+ * | next page | prev page | entry num | entry0 | entry1 | ... |
+ * entry: | RID | vector |
+ * @endcode
+ */
+struct IvfflatListPage
+{
+  PageNum next_page;
+  PageNum prev_page;
+  int32_t entry_num;
+  char    entries[0];
+};
+
 /**
  * @brief ivfflat 向量索引
  * @ingroup Index
+ * @details IVF(Inverted File)-Flat：先用 k-means 把向量分成 lists 个簇，每个簇对应一个倒排表，
+ * 倒排表中存放原始的向量(flat，不做量化)。查询时只在离查询向量最近的 probes 个簇中计算距离，
+ * probes 越大召回率越高，查询越慢。
+ *
+ * 聚类中心在创建索引之后、插入数据之前，调用 train 使用已有的数据(或者样本)训练出来。
+ * 倒排表存放在 DiskBufferPool 的页面中，聚类中心和倒排表的位置也会缓存在内存中。
+ *
+ * 页面的修改不记录日志，异常重启后索引可能与数据不一致，需要重建索引。
+ * 整个索引使用一把读写锁，查询可以并发，修改互斥。
  */
 class IvfflatIndex : public Index
 {
 public:
-  IvfflatIndex(){};
-  virtual ~IvfflatIndex() noexcept {};
+  IvfflatIndex() = default;
+  virtual ~IvfflatIndex() noexcept;
+
+  bool is_vector_index() override { return true; }
+
+  /**
+   * @brief 设置创建索引的参数，需要在 create 之前调用
+   * @param lists 聚类中心的个数
+   * @param probes 查询时默认搜索多少个倒排表
+   */
+  void set_options(common::VectorDistanceType distance_type, int lists, int probes);
+
+  /**
+   * @brief 调整查询时默认搜索的倒排表个数
+   */
+  void set_probes(int probes);
+
+  common::VectorDistanceType distance_type() const { return distance_type_; }
+  int                        dimension() const { return dimension_; }
+  int                        lists() const { return lists_; }
+  int                        probes() const { return probes_; }
+  bool                       trained() const { return trained_; }
 
-  RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+  RC create(
+      Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC open(
+      Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+
+  RC create(LogHandler &log_handler, BufferPoolManager &bpm, const char *file_name, const IndexMeta &index_meta,
+      const vector<FieldMeta> &field_metas);
+  RC open(LogHandler &log_handler, BufferPoolManager &bpm, const char *file_name, const IndexMeta &index_meta,
+      const vector<FieldMeta> &field_metas);
+  RC close();
+
+  /**
+   * @brief 使用 k-means 训练聚类中心
+   * @details 只能训练一次。样本个数比较多时，只随机选择一部分参与训练。
+   * 样本比 lists 少时，聚类中心的个数就是样本的个数
+   * @param vectors num 个连续存放的向量
+   */
+  RC train(const float *vectors, int num);
+
+  RC insert_entry(const char *record, const RID *rid) override;
+  RC delete_entry(const char *record, const RID *rid) override;
+
+  /// 向量索引只支持近似查询
+  RC get_entry(const char *key, int key_len, list<RID> &rids) override { return RC::UNSUPPORTED; }
+  IndexScanner *create_scanner(const char *left_key, int left_len, bool left_inclusive, const char *right_key,
+      int right_len, bool right_inclusive) override
   {
-    return RC::UNIMPLEMENTED;
-  };
-  RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+    return nullptr;
+  }
+
+  RC ann_search(const float *query, size_t limit, vector<RID> &rids, vector<float> *distances = nullptr) override
   {
+    return ann_search(query, limit, 0 /*probes*/, rids, distances);
+  }
+
+  /**
+   * @brief 查找离 query 最近的 limit 个向量
+   * @param probes 搜索多少个倒排表，小于等于0时使用默认值
+   * @param[out] rids 按照距离从近到远排列
+   * @param[out] distances 不为空时返回每个向量的距离
+   */
+  RC ann_search(const float *query, size_t limit, int probes, vector<RID> &rids, vector<float> *distances = nullptr);
+
+  vector<RID> ann_search(const vector<float> &base_vector, size_t limit);
 
-    return RC::UNIMPLEMENTED;
+  RC sync() override;
+
+private:
+  /// 内存中缓存的倒排表信息
+  struct ListInfo
+  {
+    PageNum head_page       = BP_INVALID_PAGE_NUM;
+    PageNum tail_page       = BP_INVALID_PAGE_NUM;
+    int     vector_num      = 0;
+    PageNum directory_page  = BP_INVALID_PAGE_NUM;  ///< 目录项所在的页面
+    int     directory_index = 0;                    ///< 目录项在页面中的位置
   };
 
-  vector<RID> ann_search(const vector<float> &base_vector, size_t limit) { return vector<RID>(); }
+  RC init_file_header(const FieldMeta &field_meta);
+  RC load_directory();
+  RC write_file_header();
+  RC write_directory_entry(int list);
 
-  RC close() { return RC::UNIMPLEMENTED; }
+  /// 离 vector 最近的聚类中心
+  int nearest_list(const float *vector) const;
 
-  RC insert_entry(const char *record, const RID *rid) override { return RC::UNIMPLEMENTED; };
-  RC delete_entry(const char *record, const RID *rid) override { return RC::UNIMPLEMENTED; };
+  RC append_to_list(int list, const float *vector, const RID &rid);
+  RC remove_from_list(int list, const RID &rid, bool &found);
 
-  RC sync() override { return RC::UNIMPLEMENTED; };
+  int directory_entry_size() const { return sizeof(IvfflatDirectoryEntry) + dimension_ * sizeof(float); }
+  int list_entry_size() const { return sizeof(RID) + dimension_ * sizeof(float); }
+  int directory_page_capacity() const;
+  int list_page_capacity() const;
 
 private:
-  bool   inited_ = false;
-  Table *table_  = nullptr;
-  int    lists_  = 1;
-  int    probes_ = 1;
+  bool            inited_           = false;
+  Table          *table_            = nullptr;
+  DiskBufferPool *disk_buffer_pool_ = nullptr;
+
+  common::VectorDistanceType distance_type_ = common::VectorDistanceType::L2;
+
+  int  dimension_ = 0;
+  int  lists_     = 1;
+  int  probes_    = 1;
+  bool trained_   = false;
+
+  PageNum          directory_page_ = BP_INVALID_PAGE_NUM;
+  vector<float>    centroids_;   ///< lists_ * dimension_ 个float
+  vector<ListInfo> list_infos_;  ///< 每个倒排表的位置
+
+  common::SharedMutex lock_;
 };
@@ -158,3 +158,17 @@ void LatchMemo::release_to(int point)
   }
   items_.erase(items_.begin(), iter);
 }
+
+void LatchMemo::release_from(int point) { release_range(point, static_cast<int>(items_.size())); }
+
+void LatchMemo::release_range(int start, int end)
+{
+  ASSERT(start >= 0 && start <= end && end <= static_cast<int>(items_.size()),
+         "invalid memo range. start=%d, end=%d, items size=%d",
+         start, end, static_cast<int>(items_.size()));
+
+  for (int i = end - 1; i >= start; i--) {
+    release_item(items_[i]);
+  }
+  items_.erase(items_.begin() + start, items_.begin() + end);
+}
@@ -78,6 +78,12 @@ public:
 
   void release_to(int point);
 
+  /// @brief 释放从point开始（包含point）之后加的锁，用于放弃一次失败的尝试
+  void release_from(int point);
+
+  /// @brief 释放[start, end)区间内加的锁，不影响区间前后的其它锁
+  void release_range(int start, int end);
+
   int memo_point() const { return static_cast<int>(items_.size()); }
 
 private:
@@ -543,7 +543,7 @@ RC RecordFileHandler::init_free_pages()
   RC rc = RC::SUCCESS;
 
   BufferPoolIterator bp_iterator;
-  bp_iterator.init(*disk_buffer_pool_, 1);
+  bp_iterator.init(*disk_buffer_pool_, 1, true /*read_ahead*/);
   unique_ptr<RecordPageHandler> record_page_handler(RecordPageHandler::create(storage_format_));
   PageNum                       current_page_num = 0;
 
@@ -759,7 +759,7 @@ RC ChunkFileScanner::open_scan_chunk(
   log_handler_      = &log_handler;
   rw_mode_          = mode;
 
-  RC rc = bp_iterator_.init(buffer_pool, 1);
+  RC rc = bp_iterator_.init(buffer_pool, 1, true /*read_ahead*/);
   if (rc != RC::SUCCESS) {
     LOG_WARN("failed to init bp iterator. rc=%d:%s", rc, strrc(rc));
     return rc;
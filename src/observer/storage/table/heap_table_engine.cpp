@@ -10,6 +10,9 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/table/heap_table_engine.h"
 #include "storage/record/heap_record_scanner.h"
+#include "common/conf/ini.h"
+#include "common/ini_setting.h"
+#include "common/lang/string.h"
 #include "common/log/log.h"
 #include "storage/index/bplus_tree_index.h"
 #include "storage/common/meta_util.h"
@@ -78,6 +81,90 @@ RC HeapTableEngine::visit_record(const RID &rid, function<bool(Record &)> visito
   return record_handler_->visit_record(rid, visitor);
 }
 
+RC HeapTableEngine::purge_records(PageNum start_page, int page_limit, int record_limit,
+    function<bool(const Record &)> filter, PageNum &next_page, int &page_count, int &purged_num)
+{
+  next_page  = BP_INVALID_PAGE_NUM;
+  page_count = 0;
+  purged_num = 0;
+  if (page_limit <= 0 || record_limit <= 0) {
+    next_page = start_page;
+    return RC::SUCCESS;
+  }
+
+  // 第0个页面是文件头，数据从第1个页面开始，参考 HeapRecordScanner::open_scan
+  BufferPoolIterator bp_iterator;
+  RC                 rc = bp_iterator.init(*data_buffer_pool_, max(start_page, 1));
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to init bp iterator. table=%s, rc=%s", table_meta_->name(), strrc(rc));
+    return rc;
+  }
+
+  unique_ptr<RecordPageHandler> page_handler(RecordPageHandler::create(table_meta_->storage_format()));
+  vector<Record>                records;
+  PageNum                       page_num = BP_INVALID_PAGE_NUM;
+  while (page_count < page_limit && purged_num < record_limit && bp_iterator.has_next()) {
+    page_num = bp_iterator.next();
+    page_count++;
+
+    // 先拿着页面读锁找出要删除的记录，释放之后再删除，删除记录时会重新获取页面的写锁
+    records.clear();
+    rc = page_handler->init(*data_buffer_pool_, db_->log_handler(), page_num, ReadWriteMode::READ_ONLY);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to init record page handler. table=%s, page num=%d, rc=%s",
+               table_meta_->name(), page_num, strrc(rc));
+      return rc;
+    }
+
+    RecordPageIterator record_iterator;
+    record_iterator.init(page_handler.get());
+    Record record;
+    while (record_iterator.has_next()) {
+      rc = record_iterator.next(record);
+      if (OB_FAIL(rc)) {
+        break;
+      }
+
+      if (filter(record)) {
+        records.emplace_back();
+        records.back().copy_data(record.data(), record.len());
+        records.back().set_rid(record.rid());
+      }
+    }
+    page_handler->cleanup();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to iterate records. table=%s, page num=%d, rc=%s", table_meta_->name(), page_num, strrc(rc));
+      return rc;
+    }
+
+    for (const Record &purge_record : records) {
+      // 先删除索引项。索引项可能已经不存在了，比如在记录删除之后才创建的索引
+      for (Index *index : indexes_) {
+        rc = index->delete_entry(purge_record.data(), &purge_record.rid());
+        if (OB_FAIL(rc) && rc != RC::RECORD_NOT_EXIST) {
+          LOG_WARN("failed to delete index entry while purging records. table=%s, index=%s, rid=%s, rc=%s",
+                   table_meta_->name(), index->index_meta().name(), purge_record.rid().to_string().c_str(), strrc(rc));
+          return rc;
+        }
+      }
+
+      // 删除之后页面会放回 RecordFileHandler 的空闲页面集合中
+      rc = record_handler_->delete_record(&purge_record.rid());
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to delete record while purging records. table=%s, rid=%s, rc=%s",
+                 table_meta_->name(), purge_record.rid().to_string().c_str(), strrc(rc));
+        return rc;
+      }
+      purged_num++;
+    }
+  }
+
+  if (page_num != BP_INVALID_PAGE_NUM && bp_iterator.has_next()) {
+    next_page = page_num + 1;
+  }
+  return RC::SUCCESS;
+}
+
 RC HeapTableEngine::get_record(const RID &rid, Record &record)
 {
   RC rc = record_handler_->get_record(rid, record);
@@ -121,19 +208,32 @@ RC HeapTableEngine::get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadW
   return rc;
 }
 
-RC HeapTableEngine::create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name, bool unique)
+RC HeapTableEngine::create_index(
+    Trx *trx, const vector<const FieldMeta *> &field_metas, const char *index_name, bool unique)
 {
-  if (common::is_blank(index_name) || nullptr == field_meta) {
+  if (common::is_blank(index_name) || field_metas.empty()) {
     LOG_INFO("Invalid input arguments, table name is %s, index_name is blank or attribute_name is blank", table_meta_->name());
     return RC::INVALID_ARGUMENT;
   }
 
+  vector<FieldMeta> index_field_metas;
+  for (const FieldMeta *field_meta : field_metas) {
+    if (nullptr == field_meta) {
+      LOG_INFO("Invalid input arguments, table name is %s, index_name is %s, field is null", table_meta_->name(), index_name);
+      return RC::INVALID_ARGUMENT;
+    }
+    index_field_metas.push_back(*field_meta);
+  }
+
+  // 清理线程会遍历 indexes_，也可能删除已经加入新索引的记录，创建索引的整个过程都要暂停清理
+  MvccVacuum::PauseGuard vacuum_pause_guard(db_->vacuum());
+
   IndexMeta new_index_meta;
 
-  RC rc = new_index_meta.init(index_name, *field_meta, unique);
+  RC rc = new_index_meta.init(index_name, field_metas, unique);
   if (rc != RC::SUCCESS) {
     LOG_INFO("Failed to init IndexMeta in table:%s, index_name:%s, field_name:%s", 
-             table_meta_->name(), index_name, field_meta->name());
+             table_meta_->name(), index_name, field_metas.front()->name());
     return rc;
   }
 
@@ -141,64 +241,73 @@ RC HeapTableEngine::create_index(Trx *trx, const FieldMeta *field_meta, const ch
   BplusTreeIndex *index = new BplusTreeIndex();
   index->set_unique(new_index_meta.is_unique());
 
+  const string leaf_compression_str =
+      common::get_properties()->get(INDEX_LEAF_COMPRESSION, INDEX_LEAF_COMPRESSION_DEFAULT, STORAGE);
+  int leaf_compression = 0;
+  if (!common::str_to_val(leaf_compression_str, leaf_compression)) {
+    LOG_WARN("Invalid index leaf compression: %s, use default", leaf_compression_str.c_str());
+  }
+  index->set_leaf_compressed(leaf_compression != 0);
+
   LOG_INFO("Creating B+Tree index '%s' on table '%s', unique=%d",
          index_name, table_meta_->name(), index->is_unique());
 
   string index_file = table_index_file(db_->path().c_str(), table_meta_->name(), index_name);
 
-  rc = index->create(table_, index_file.c_str(), new_index_meta, *field_meta);
+  rc = index->create(table_, index_file.c_str(), new_index_meta, index_field_metas);
   if (rc != RC::SUCCESS) {
     delete index;
     LOG_ERROR("Failed to create bplus tree index. file name=%s, rc=%d:%s", index_file.c_str(), rc, strrc(rc));
     return rc;
   }
 
-  // 遍历当前的所有数据，插入这个索引
+  // 遍历当前的所有数据，批量构建这个索引
+  BplusTreeBulkLoadOptions bulk_load_options;
+  rc = load_bulk_load_options(bulk_load_options);
+  if (OB_FAIL(rc)) {
+    delete index;
+    return rc;
+  }
+  bulk_load_options.unique           = unique;
+  bulk_load_options.temp_file_prefix = index_file;
+
+  unique_ptr<BplusTreeBulkLoader> loader = index->create_bulk_loader(bulk_load_options);
+
   RecordScanner *scanner = nullptr;
   rc                     = get_record_scanner(scanner, trx, ReadWriteMode::READ_ONLY);
   if (rc != RC::SUCCESS) {
     LOG_WARN("failed to create scanner while creating index. table=%s, index=%s, rc=%s", 
              table_meta_->name(), index_name, strrc(rc));
+    delete index;
     return rc;
   }
 
   Record record;
+  string key_buffer;
   while (OB_SUCC(rc = scanner->next(record))) {
-    rc = index->insert_entry(record.data(), &record.rid());
-
-    LOG_WARN("Duplicate key found for unique index: table=%s, index=%s, key=%s",
-                 table_meta_->name(), index_name, record.data());
-
-    if (rc == RC::RECORD_DUPLICATE_KEY) {
-      if (unique) {
-        LOG_WARN("duplicate key found while creating unique index. table=%s, index=%s",
-                 table_meta_->name(), index_name);
-        scanner->close_scan();
-        delete scanner;
-        delete index;  // 回收
-        return RC::RECORD_DUPLICATE_KEY;
-      } else {
-        rc = RC::SUCCESS;
-      }
-    } else if (rc != RC::SUCCESS) {
-      LOG_WARN("failed to insert record into index while creating index. table=%s, index=%s, rc=%s",
-             table_meta_->name(), index_name, strrc(rc));
-      scanner->close_scan();
-      delete scanner;
-      delete index;
-      return rc;
+    rc = loader->add(index->extract_key(record.data(), key_buffer), record.rid());
+    if (OB_FAIL(rc)) {
+      break;
     }
   }
+  scanner->close_scan();
+  delete scanner;
 
   if (RC::RECORD_EOF == rc) {
-    rc = RC::SUCCESS;
-  } else {
-    LOG_WARN("failed to insert record into index while creating index. table=%s, index=%s, rc=%s",
+    rc = loader->finish();
+  }
+  loader.reset();
+
+  if (rc == RC::RECORD_DUPLICATE_KEY) {
+    LOG_WARN("duplicate key found while creating unique index. table=%s, index=%s", table_meta_->name(), index_name);
+    delete index;  // 回收
+    return rc;
+  } else if (OB_FAIL(rc)) {
+    LOG_WARN("failed to build index while creating index. table=%s, index=%s, rc=%s",
              table_meta_->name(), index_name, strrc(rc));
+    delete index;
     return rc;
   }
-  scanner->close_scan();
-  delete scanner;
   LOG_INFO("inserted all records into new index. table=%s, index=%s", table_meta_->name(), index_name);
 
   indexes_.push_back(index);    // 新的索引加入内存管理
@@ -249,20 +358,42 @@ RC HeapTableEngine::create_index(Trx *trx, const FieldMeta *field_meta, const ch
   return rc;
 }
 
+RC HeapTableEngine::load_bulk_load_options(BplusTreeBulkLoadOptions &options)
+{
+  const string fill_factor_str =
+      common::get_properties()->get(INDEX_BULK_LOAD_FILL_FACTOR, INDEX_BULK_LOAD_FILL_FACTOR_DEFAULT, STORAGE);
+  if (!common::str_to_val(fill_factor_str, options.fill_factor) || options.fill_factor <= 0 ||
+      options.fill_factor > 100) {
+    LOG_ERROR("Invalid index bulk load fill factor: %s", fill_factor_str.c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const string sort_buffer_str =
+      common::get_properties()->get(INDEX_BULK_LOAD_SORT_BUFFER_MB, INDEX_BULK_LOAD_SORT_BUFFER_MB_DEFAULT, STORAGE);
+  int sort_buffer_mb = 0;
+  if (!common::str_to_val(sort_buffer_str, sort_buffer_mb) || sort_buffer_mb <= 0) {
+    LOG_ERROR("Invalid index bulk load sort buffer size: %s", sort_buffer_str.c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+  options.sort_buffer_size = static_cast<size_t>(sort_buffer_mb) * 1024 * 1024;
+  return RC::SUCCESS;
+}
+
 RC HeapTableEngine::insert_entry_of_indexes(const char *record, const RID &rid)
 {
   RC rc = RC::SUCCESS;
   for (Index *index : indexes_) {
 
-    LOG_INFO("Processing index: UNIQUE=%d, field_offset=%d, field_len=%d",
+    LOG_INFO("Processing index: UNIQUE=%d, field_num=%d, key_len=%d",
              index->is_unique(),
-             index->field_meta().offset(),
-             index->field_meta().len());
+             index->index_meta().field_num(),
+             index->key_length());
 
     // 检查 UNIQUE 索引
     if (index->is_unique()) {
       std::list<RID> rids;
-      rc = index->get_entry(record + index->field_meta().offset(), index->field_meta().len(), rids);
+      string         key_buffer;
+      rc = index->get_entry(index->extract_key(record, key_buffer), index->key_length(), rids);
       if (rc != RC::SUCCESS) {
         return rc;
       }
@@ -365,20 +496,24 @@ RC HeapTableEngine::open()
   init();
   const int index_num = table_meta_->index_num();
   for (int i = 0; i < index_num; i++) {
-    const IndexMeta *index_meta = table_meta_->index(i);
-    const FieldMeta *field_meta = table_meta_->field(index_meta->field());
-    if (field_meta == nullptr) {
-      LOG_ERROR("Found invalid index meta info which has a non-exists field. table=%s, index=%s, field=%s",
-                table_meta_->name(), index_meta->name(), index_meta->field());
-      // skip cleanup
-      //  do all cleanup action in destructive Table function
-      return RC::INTERNAL;
+    const IndexMeta  *index_meta = table_meta_->index(i);
+    vector<FieldMeta> field_metas;
+    for (const string &field_name : index_meta->fields()) {
+      const FieldMeta *field_meta = table_meta_->field(field_name.c_str());
+      if (field_meta == nullptr) {
+        LOG_ERROR("Found invalid index meta info which has a non-exists field. table=%s, index=%s, field=%s",
+                  table_meta_->name(), index_meta->name(), field_name.c_str());
+        // skip cleanup
+        //  do all cleanup action in destructive Table function
+        return RC::INTERNAL;
+      }
+      field_metas.push_back(*field_meta);
     }
 
     BplusTreeIndex *index      = new BplusTreeIndex();
     string          index_file = table_index_file(db_->path().c_str(), table_meta_->name(), index_meta->name());
 
-    rc = index->open(table_, index_file.c_str(), *index_meta, *field_meta);
+    rc = index->open(table_, index_file.c_str(), *index_meta, field_metas);
     if (rc != RC::SUCCESS) {
       delete index;
       LOG_ERROR("Failed to open index. table=%s, index=%s, file=%s, rc=%s",
@@ -12,6 +12,7 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/table/table_engine.h"
 #include "storage/index/index.h"
+#include "storage/index/bplus_tree_bulk_loader.h"
 #include "storage/record/record_manager.h"
 #include "storage/db/db.h"
 
@@ -37,10 +38,13 @@ public:
   }
   RC get_record(const RID &rid, Record &record) override;
 
-  RC create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name, bool unique) override;
+  RC create_index(
+      Trx *trx, const vector<const FieldMeta *> &field_metas, const char *index_name, bool unique) override;
   RC get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode) override;
   RC get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode mode) override;
   RC visit_record(const RID &rid, function<bool(Record &)> visitor) override;
+  RC purge_records(PageNum start_page, int page_limit, int record_limit, function<bool(const Record &)> filter,
+      PageNum &next_page, int &page_count, int &purged_num) override;
   RC sync() override;
 
   Index *find_index(const char *index_name) const override;
@@ -50,6 +54,11 @@ public:
   RC init() override;
 
 private:
+  /**
+   * @brief 从配置文件中读取批量构建索引的参数
+   */
+  static RC load_bulk_load_options(BplusTreeBulkLoadOptions &options);
+
   RC insert_entry_of_indexes(const char *record, const RID &rid);
   RC delete_entry_of_indexes(const char *record, const RID &rid, bool error_on_not_exists);
 
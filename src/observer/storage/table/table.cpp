@@ -218,6 +218,12 @@ RC Table::insert_chunk(const Chunk &chunk) { return engine_->insert_chunk(chunk)
 
 RC Table::visit_record(const RID &rid, function<bool(Record &)> visitor) { return engine_->visit_record(rid, visitor); }
 
+RC Table::purge_records(PageNum start_page, int page_limit, int record_limit, function<bool(const Record &)> filter,
+    PageNum &next_page, int &page_count, int &purged_num)
+{
+  return engine_->purge_records(start_page, page_limit, record_limit, filter, next_page, page_count, purged_num);
+}
+
 RC Table::insert_record_with_trx(Record &record, Trx *trx) { return engine_->insert_record_with_trx(record, trx); }
 RC Table::delete_record_with_trx(const Record &record, Trx *trx)
 {
@@ -328,9 +334,9 @@ RC Table::get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode m
   return engine_->get_chunk_scanner(scanner, trx, mode);
 }
 
-RC Table::create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name, bool unique)
+RC Table::create_index(Trx *trx, const vector<const FieldMeta *> &field_metas, const char *index_name, bool unique)
 {
-  return engine_->create_index(trx, field_meta, index_name, unique);
+  return engine_->create_index(trx, field_metas, index_name, unique);
 }
 
 RC Table::delete_record(const Record &record) { return engine_->delete_record(record); }
@@ -99,8 +99,11 @@ public:
   RC update_record_with_trx(const Record &old_record, const Record &new_record, Trx *trx);
   RC get_record(const RID &rid, Record &record);
 
-  // TODO refactor
-  RC create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name, bool unique);
+  /**
+   * @brief 创建索引
+   * @param field_metas 索引包含的字段，字段的顺序就是索引键值的顺序
+   */
+  RC create_index(Trx *trx, const vector<const FieldMeta *> &field_metas, const char *index_name, bool unique);
 
   RC get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode);
 
@@ -115,6 +118,14 @@ public:
    */
   RC visit_record(const RID &rid, function<bool(Record &)> visitor);
 
+  /**
+   * @brief 物理删除满足条件的记录，同时删除索引项。不关心事务，参考 MvccVacuum
+   * @details 从 start_page 开始最多遍历 page_limit 个页面，删除的记录达到 record_limit 个时提前返回
+   * @param next_page 返回下一次从哪个页面开始，遍历完所有页面时是 BP_INVALID_PAGE_NUM
+   */
+  RC purge_records(PageNum start_page, int page_limit, int record_limit, function<bool(const Record &)> filter,
+      PageNum &next_page, int &page_count, int &purged_num);
+
 public:
   int32_t     table_id() const { return table_meta_.table_id(); }
   const char *name() const;
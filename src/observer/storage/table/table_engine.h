@@ -46,14 +46,30 @@ public:
   virtual RC update_record_with_trx(const Record &old_record, const Record &new_record, Trx *trx) = 0;
   virtual RC get_record(const RID &rid, Record &record)                                           = 0;
 
-  virtual RC     create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name, bool unique) = 0;
-  virtual RC     get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode)                = 0;
-  virtual RC     get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode mode)               = 0;
-  virtual RC     visit_record(const RID &rid, function<bool(Record &)> visitor)                           = 0;
-  virtual RC     sync()                                                                                   = 0;
-  virtual Index *find_index(const char *index_name) const                                                 = 0;
-  virtual Index *find_index_by_field(const char *field_name) const                                        = 0;
-  virtual RC     open()                                                                                   = 0;
+  virtual RC create_index(
+      Trx *trx, const vector<const FieldMeta *> &field_metas, const char *index_name, bool unique) = 0;
+
+  virtual RC     get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode)  = 0;
+  virtual RC     get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode mode) = 0;
+  virtual RC     visit_record(const RID &rid, function<bool(Record &)> visitor)             = 0;
+  virtual RC     sync()                                                                     = 0;
+  virtual Index *find_index(const char *index_name) const                                   = 0;
+  virtual Index *find_index_by_field(const char *field_name) const                          = 0;
+  virtual RC     open()                                                                     = 0;
+
+  /**
+   * @brief 从 start_page 开始遍历数据页面，物理删除 filter 返回 true 的记录以及它们的索引项
+   * @details 遍历 page_limit 个页面，或者删除的记录达到 record_limit 个之后，处理完当前页面就返回
+   * @param next_page 返回下一次从哪个页面开始，遍历到文件末尾时是 BP_INVALID_PAGE_NUM
+   * @param page_count 返回遍历了多少个页面
+   * @param purged_num 返回删除了多少条记录
+   */
+  virtual RC purge_records(PageNum start_page, int page_limit, int record_limit,
+      function<bool(const Record &)> filter, PageNum &next_page, int &page_count, int &purged_num)
+  {
+    return RC::UNSUPPORTED;
+  }
+
   // TODO: remove this function
   virtual RC init() = 0;
 
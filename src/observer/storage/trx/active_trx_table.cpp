@@ -0,0 +1,77 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/trx/active_trx_table.h"
+#include "common/lang/algorithm.h"
+#include "storage/trx/mvcc_trx.h"
+
+ActiveTrxTable::Shard &ActiveTrxTable::shard_of(const MvccTrx *trx)
+{
+  // 去掉低位，相邻分配的对象也会落到不同的分片上
+  const uintptr_t address = reinterpret_cast<uintptr_t>(trx);
+  return shards_[(address >> 6) % SHARD_NUM];
+}
+
+void ActiveTrxTable::add(MvccTrx *trx)
+{
+  Shard &shard = shard_of(trx);
+  shard.lock.lock();
+  shard.trxes.push_back(trx);
+  shard.lock.unlock();
+}
+
+void ActiveTrxTable::remove(MvccTrx *trx)
+{
+  Shard &shard = shard_of(trx);
+  shard.lock.lock();
+  auto iter = std::find(shard.trxes.begin(), shard.trxes.end(), trx);
+  if (iter != shard.trxes.end()) {
+    *iter = shard.trxes.back();
+    shard.trxes.pop_back();
+  }
+  shard.lock.unlock();
+}
+
+void ActiveTrxTable::all_trxes(vector<Trx *> &trxes)
+{
+  trxes.clear();
+  for (Shard &shard : shards_) {
+    shard.lock.lock();
+    trxes.insert(trxes.end(), shard.trxes.begin(), shard.trxes.end());
+    shard.lock.unlock();
+  }
+}
+
+void ActiveTrxTable::take_all(vector<MvccTrx *> &trxes)
+{
+  trxes.clear();
+  for (Shard &shard : shards_) {
+    shard.lock.lock();
+    trxes.insert(trxes.end(), shard.trxes.begin(), shard.trxes.end());
+    shard.trxes.clear();
+    shard.lock.unlock();
+  }
+}
+
+int32_t ActiveTrxTable::min_active_trx_id(int32_t upper_bound)
+{
+  int32_t min_trx_id = upper_bound;
+  for (Shard &shard : shards_) {
+    shard.lock.lock();
+    for (const MvccTrx *trx : shard.trxes) {
+      const int32_t trx_id = trx->active_trx_id();
+      if (trx_id > 0 && trx_id < min_trx_id) {
+        min_trx_id = trx_id;
+      }
+    }
+    shard.lock.unlock();
+  }
+  return min_trx_id;
+}
@@ -0,0 +1,65 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/array.h"
+#include "common/lang/mutex.h"
+#include "common/lang/vector.h"
+
+class Trx;
+class MvccTrx;
+
+/**
+ * @brief 记录所有存活的 MVCC 事务
+ * @ingroup Transaction
+ * @details 每条自动提交的语句都会创建并销毁一个事务，如果所有事务放在一个加锁的数组里，
+ * 会话之间就会在这把锁上排队。这里按照事务对象的地址把事务分散到多个分片中，每个分片一把锁，
+ * 分片按照缓存行对齐，不同的会话几乎不会访问同一个分片。
+ *
+ * 只有遍历所有事务(all_trxes、计算最小活跃事务ID)时才需要访问所有的分片，这些操作都不频繁。
+ */
+class ActiveTrxTable
+{
+public:
+  static constexpr int SHARD_NUM = 64;
+
+  ActiveTrxTable()  = default;
+  ~ActiveTrxTable() = default;
+
+  void add(MvccTrx *trx);
+  void remove(MvccTrx *trx);
+
+  void all_trxes(vector<Trx *> &trxes);
+
+  /**
+   * @brief 取出所有的事务，之后表是空的
+   */
+  void take_all(vector<MvccTrx *> &trxes);
+
+  /**
+   * @brief 所有活跃事务中最小的事务ID
+   * @details 活跃事务会公布自己的事务ID(参考 MvccTrx::active_trx_id)，没有活跃事务时返回 upper_bound。
+   * 调用者需要在遍历之前读取 upper_bound，即当前已经分配出去的最大事务ID加1。
+   */
+  int32_t min_active_trx_id(int32_t upper_bound);
+
+private:
+  struct alignas(64) Shard
+  {
+    common::Mutex     lock;
+    vector<MvccTrx *> trxes;
+  };
+
+  Shard &shard_of(const MvccTrx *trx);
+
+private:
+  array<Shard, SHARD_NUM> shards_;
+};
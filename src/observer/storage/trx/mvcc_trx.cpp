@@ -20,10 +20,10 @@ See the Mulan PSL v2 for more details. */
 
 MvccTrxKit::~MvccTrxKit()
 {
-  vector<Trx *> tmp_trxes;
-  tmp_trxes.swap(trxes_);
+  vector<MvccTrx *> tmp_trxes;
+  trxes_.take_all(tmp_trxes);
 
-  for (Trx *trx : tmp_trxes) {
+  for (MvccTrx *trx : tmp_trxes) {
     delete trx;
   }
 }
@@ -44,53 +44,52 @@ const vector<FieldMeta> *MvccTrxKit::trx_fields() const { return &fields_; }
 
 int32_t MvccTrxKit::next_trx_id() { return ++current_trx_id_; }
 
+int32_t MvccTrxKit::begin_trx_id(atomic<int32_t> &active_trx_id)
+{
+  active_trx_id.store(current_trx_id_.load() + 1);
+  const int32_t trx_id = next_trx_id();
+  active_trx_id.store(trx_id);
+  return trx_id;
+}
+
+int32_t MvccTrxKit::min_active_trx_id()
+{
+  // 先读取上限再遍历。遍历时才开始的事务，分配到的事务ID一定不小于这个上限
+  const int32_t upper_bound = current_trx_id_.load() + 1;
+  return trxes_.min_active_trx_id(upper_bound);
+}
+
+void MvccTrxKit::update_trx_id(int32_t trx_id)
+{
+  int32_t current_trx_id = current_trx_id_.load();
+  while (current_trx_id < trx_id && !current_trx_id_.compare_exchange_weak(current_trx_id, trx_id)) {
+  }
+}
+
 int32_t MvccTrxKit::max_trx_id() const { return numeric_limits<int32_t>::max(); }
 
 Trx *MvccTrxKit::create_trx(LogHandler &log_handler)
 {
-  Trx *trx = new MvccTrx(*this, log_handler);
-  if (trx != nullptr) {
-    lock_.lock();
-    trxes_.push_back(trx);
-    lock_.unlock();
-  }
+  MvccTrx *trx = new MvccTrx(*this, log_handler);
+  trxes_.add(trx);
   return trx;
 }
 
 Trx *MvccTrxKit::create_trx(LogHandler &log_handler, int32_t trx_id)
 {
-  Trx *trx = new MvccTrx(*this, log_handler, trx_id);
-  if (trx != nullptr) {
-    lock_.lock();
-    trxes_.push_back(trx);
-    if (current_trx_id_ < trx_id) {
-      current_trx_id_ = trx_id;
-    }
-    lock_.unlock();
-  }
+  MvccTrx *trx = new MvccTrx(*this, log_handler, trx_id);
+  trxes_.add(trx);
+  update_trx_id(trx_id);
   return trx;
 }
 
 void MvccTrxKit::destroy_trx(Trx *trx)
 {
-  lock_.lock();
-  for (auto iter = trxes_.begin(), itend = trxes_.end(); iter != itend; ++iter) {
-    if (*iter == trx) {
-      trxes_.erase(iter);
-      break;
-    }
-  }
-  lock_.unlock();
-
+  trxes_.remove(static_cast<MvccTrx *>(trx));
   delete trx;
 }
 
-void MvccTrxKit::all_trxes(vector<Trx *> &trxes)
-{
-  lock_.lock();
-  trxes = trxes_;
-  lock_.unlock();
-}
+void MvccTrxKit::all_trxes(vector<Trx *> &trxes) { trxes_.all_trxes(trxes); }
 
 LogReplayer *MvccTrxKit::create_log_replayer(Db &db, LogHandler &log_handler)
 {
@@ -103,7 +102,7 @@ MvccTrx::MvccTrx(MvccTrxKit &kit, LogHandler &log_handler) : Trx(TrxKit::Type::M
 {}
 
 MvccTrx::MvccTrx(MvccTrxKit &kit, LogHandler &log_handler, int32_t trx_id) 
-  : Trx(TrxKit::Type::MVCC), trx_kit_(kit), log_handler_(log_handler), trx_id_(trx_id)
+  : Trx(TrxKit::Type::MVCC), trx_kit_(kit), log_handler_(log_handler), trx_id_(trx_id), active_trx_id_(trx_id)
 {
   started_    = true;
   recovering_ = true;
@@ -250,7 +249,7 @@ RC MvccTrx::start_if_need()
 {
   if (!started_) {
     ASSERT(operations_.empty(), "try to start a new trx while operations is not empty");
-    trx_id_ = trx_kit_.next_trx_id();
+    trx_id_ = trx_kit_.begin_trx_id(active_trx_id_);
     LOG_DEBUG("current thread change to new trx with %d", trx_id_);
     started_ = true;
   }
@@ -326,6 +325,7 @@ RC MvccTrx::commit_with_trx_id(int32_t commit_xid)
   }
 
   operations_.clear();
+  active_trx_id_.store(0);
 
   LOG_TRACE("append trx commit log. trx id=%d, commit_xid=%d, rc=%s", trx_id_, commit_xid, strrc(rc));
   return rc;
@@ -401,6 +401,7 @@ RC MvccTrx::rollback()
   }
 
   operations_.clear();
+  active_trx_id_.store(0);
 
   if (!recovering_) {
     rc = log_handler_.rollback(trx_id_);
@@ -450,9 +451,10 @@ RC MvccTrx::redo(Db *db, const LogEntry &log_entry)
     } break;
 
     case MvccTrxLogOperation::Type::COMMIT: {
-      // auto *trx_log_record = reinterpret_cast<const MvccTrxCommitLogEntry *>(log_entry.data());
-      // commit_with_trx_id(trx_log_record->commit_trx_id);
       // 遇到了提交日志，说明前面的记录都已经提交成功了
+      // 记录上的版本号由页面日志恢复，这里要保证后面新开启的事务能看到这个提交
+      auto *trx_log_record = reinterpret_cast<const MvccTrxCommitLogEntry *>(log_entry.data());
+      trx_kit_.update_trx_id(trx_log_record->commit_trx_id);
     } break;
 
     case MvccTrxLogOperation::Type::ROLLBACK: {
@@ -14,7 +14,9 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include "common/lang/atomic.h"
 #include "common/lang/vector.h"
+#include "storage/trx/active_trx_table.h"
 #include "storage/trx/trx.h"
 #include "storage/trx/mvcc_trx_log.h"
 
@@ -42,6 +44,24 @@ public:
 public:
   int32_t next_trx_id();
 
+  /**
+   * @brief 为开始的事务分配事务ID，并通过 active_trx_id 公布出去
+   * @details 先公布一个不大于最终事务ID的下限，再分配事务ID。这样计算最小活跃事务ID时，
+   * 不会漏掉正在分配事务ID的事务
+   */
+  int32_t begin_trx_id(atomic<int32_t> &active_trx_id);
+
+  /**
+   * @brief 恢复时使用，保证后面分配的事务ID比日志中出现过的ID都大
+   */
+  void update_trx_id(int32_t trx_id);
+
+  /**
+   * @brief 所有活跃事务中最小的事务ID，没有活跃事务时是下一个要分配的事务ID
+   * @details 比这个ID小的事务提交的删除，对所有活跃事务和以后的事务都可见
+   */
+  int32_t min_active_trx_id();
+
 public:
   int32_t max_trx_id() const;
 
@@ -50,14 +70,13 @@ private:
 
   atomic<int32_t> current_trx_id_{0};
 
-  common::Mutex lock_;
-  vector<Trx *> trxes_;
+  ActiveTrxTable trxes_;
 };
 
 /**
  * @brief 多版本并发事务
  * @ingroup Transaction
- * TODO 没有垃圾回收
+ * @details 删除的记录由 MvccVacuum 回收
  */
 class MvccTrx : public Trx
 {
@@ -95,6 +114,9 @@ public:
 
   int32_t id() const override { return trx_id_; }
 
+  /// 事务开始之后是事务ID，没有开始时是0
+  int32_t active_trx_id() const { return active_trx_id_.load(); }
+
 private:
   RC   commit_with_trx_id(int32_t commit_id);
   void trx_fields(Table *table, Field &begin_xid_field, Field &end_xid_field) const;
@@ -109,6 +131,7 @@ private:
   MvccTrxKit       &trx_kit_;
   MvccTrxLogHandler log_handler_;
   int32_t           trx_id_     = -1;
+  atomic<int32_t>   active_trx_id_{0};
   bool              started_    = false;
   bool              recovering_ = false;
   OperationSet      operations_;
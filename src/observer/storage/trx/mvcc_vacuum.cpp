@@ -0,0 +1,206 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/trx/mvcc_vacuum.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/limits.h"
+#include "common/lang/sstream.h"
+#include "common/lang/vector.h"
+#include "common/log/log.h"
+#include "common/thread/thread_util.h"
+#include "storage/db/db.h"
+#include "storage/record/record.h"
+#include "storage/table/table.h"
+#include "storage/trx/mvcc_trx.h"
+
+using namespace common;
+
+string MvccVacuum::Stats::to_string() const
+{
+  stringstream ss;
+  ss << "rounds:" << rounds << ", pagesScanned:" << pages_scanned << ", recordsPurged:" << records_purged;
+  return ss.str();
+}
+
+MvccVacuum::MvccVacuum(Db &db, MvccTrxKit &trx_kit) : db_(db), trx_kit_(trx_kit) {}
+
+MvccVacuum::~MvccVacuum() { stop(); }
+
+RC MvccVacuum::start(int interval_ms, int pages_per_round, int records_per_round)
+{
+  if (thread_.joinable()) {
+    LOG_WARN("vacuum has been started. interval=%dms", interval_ms_);
+    return RC::INTERNAL;
+  }
+
+  if (interval_ms < 0 || pages_per_round <= 0 || records_per_round <= 0) {
+    LOG_WARN("invalid vacuum arguments. interval=%dms, pages per round=%d, records per round=%d",
+             interval_ms, pages_per_round, records_per_round);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  interval_ms_       = interval_ms;
+  pages_per_round_   = pages_per_round;
+  records_per_round_ = records_per_round;
+
+  if (interval_ms_ == 0) {
+    LOG_INFO("vacuum thread is disabled. pages per round=%d, records per round=%d",
+             pages_per_round_, records_per_round_);
+    return RC::SUCCESS;
+  }
+
+  running_ = true;
+  thread_  = thread(&MvccVacuum::thread_func, this);
+
+  LOG_INFO("vacuum started. interval=%dms, pages per round=%d, records per round=%d",
+           interval_ms_, pages_per_round_, records_per_round_);
+  return RC::SUCCESS;
+}
+
+void MvccVacuum::stop()
+{
+  if (!thread_.joinable()) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> guard(wakeup_lock_);
+    running_ = false;
+  }
+  wakeup_cond_.notify_all();
+
+  thread_.join();
+  LOG_INFO("vacuum stopped. stats=%s", stats().to_string().c_str());
+}
+
+int MvccVacuum::vacuum()
+{
+  lock_guard<mutex> guard(round_lock_);
+  return vacuum_tables(pages_per_round_, records_per_round_);
+}
+
+int MvccVacuum::vacuum_all()
+{
+  lock_guard<mutex> guard(round_lock_);
+  current_table_.clear();
+  current_page_ = BP_INVALID_PAGE_NUM;
+  return vacuum_tables(numeric_limits<int>::max(), numeric_limits<int>::max());
+}
+
+MvccVacuum::Stats MvccVacuum::stats() const
+{
+  Stats stats;
+  stats.rounds         = rounds_.load();
+  stats.pages_scanned  = pages_scanned_.load();
+  stats.records_purged = records_purged_.load();
+  return stats;
+}
+
+void MvccVacuum::thread_func()
+{
+  thread_set_name("MvccVacuum");
+  LOG_INFO("vacuum thread started");
+
+  const chrono::milliseconds interval(interval_ms_);
+  while (running_) {
+    const int purged_num = vacuum();
+    LOG_DEBUG("vacuum round done. purged=%d", purged_num);
+
+    unique_lock<mutex> guard(wakeup_lock_);
+    wakeup_cond_.wait_for(guard, interval, [this] { return !running_; });
+  }
+
+  LOG_INFO("vacuum thread stopped");
+}
+
+void MvccVacuum::pause() { round_lock_.lock(); }
+
+void MvccVacuum::resume() { round_lock_.unlock(); }
+
+int MvccVacuum::vacuum_tables(int page_limit, int record_limit)
+{
+  // 先计算水位线再遍历，之后开始的事务ID都比水位线大，不会看到要删除的记录
+  const int32_t min_active_trx_id = trx_kit_.min_active_trx_id();
+
+  vector<string> table_names;
+  db_.all_tables(table_names);
+  sort(table_names.begin(), table_names.end());
+  rounds_++;
+  if (table_names.empty()) {
+    current_table_.clear();
+    current_page_ = BP_INVALID_PAGE_NUM;
+    return 0;
+  }
+
+  // 从上一轮停下来的表继续。如果这张表已经删除了，就从它后面的表开始
+  auto   iter        = lower_bound(table_names.begin(), table_names.end(), current_table_);
+  size_t table_index = iter - table_names.begin();
+  if (iter == table_names.end() || *iter != current_table_) {
+    current_page_ = BP_INVALID_PAGE_NUM;
+    table_index %= table_names.size();
+  }
+
+  int purged_num = 0;
+  for (size_t i = 0; i < table_names.size() && page_limit > 0 && record_limit > 0; i++) {
+    const string &table_name = table_names[(table_index + i) % table_names.size()];
+    current_table_           = table_name;
+
+    Table *table = db_.find_table(table_name.c_str());
+    if (table == nullptr || table->table_meta().trx_fields().size() < 2) {
+      current_page_ = BP_INVALID_PAGE_NUM;
+      continue;
+    }
+
+    auto filter = [table, min_active_trx_id](const Record &record) {
+      return is_dead(table, record, min_active_trx_id);
+    };
+
+    PageNum next_page        = BP_INVALID_PAGE_NUM;
+    int     page_count       = 0;
+    int     table_purged_num = 0;
+    RC      rc               = table->purge_records(
+        current_page_, page_limit, record_limit, filter, next_page, page_count, table_purged_num);
+    if (OB_FAIL(rc) && rc != RC::UNSUPPORTED) {
+      LOG_WARN("failed to vacuum table. table=%s, start page=%d, rc=%s", table_name.c_str(), current_page_, strrc(rc));
+    }
+
+    page_limit -= page_count;
+    record_limit -= table_purged_num;
+    purged_num += table_purged_num;
+    pages_scanned_ += page_count;
+    records_purged_ += table_purged_num;
+
+    if (OB_SUCC(rc) && next_page != BP_INVALID_PAGE_NUM) {
+      // 额度用完了，这张表还没有清理完，下一轮接着清理
+      current_page_ = next_page;
+      return purged_num;
+    }
+
+    // 这张表清理完了(或者清理失败了)，下一轮从下一张表开始
+    current_table_ = table_names[(table_index + i + 1) % table_names.size()];
+    current_page_  = BP_INVALID_PAGE_NUM;
+  }
+
+  return purged_num;
+}
+
+bool MvccVacuum::is_dead(const Table *table, const Record &record, int32_t min_active_trx_id)
+{
+  // 可见性的判断参考 MvccTrx::visit_record
+  span<const FieldMeta> trx_fields = table->table_meta().trx_fields();
+
+  int32_t begin_xid = 0;
+  int32_t end_xid   = 0;
+  memcpy(&begin_xid, record.data() + trx_fields[0].offset(), sizeof(begin_xid));
+  memcpy(&end_xid, record.data() + trx_fields[1].offset(), sizeof(end_xid));
+
+  // 小于0的是还没有提交的插入或删除。提交的删除，只有事务ID不大于 end_xid 的事务才能看到
+  return begin_xid > 0 && end_xid > 0 && end_xid < min_active_trx_id;
+}
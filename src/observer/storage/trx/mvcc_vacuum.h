@@ -0,0 +1,164 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/atomic.h"
+#include "common/lang/chrono.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/mutex.h"
+#include "common/lang/string.h"
+#include "common/lang/thread.h"
+#include "common/sys/rc.h"
+#include "common/types.h"
+#include "storage/buffer/page.h"
+
+class Db;
+class Table;
+class Record;
+class MvccTrxKit;
+
+/**
+ * @brief 清理 MVCC 事务删除的记录
+ * @ingroup Transaction
+ * @details MvccTrx 删除记录时只是把 end_xid 设置为提交的事务ID，记录和索引项都还保留着，
+ * 参考 MvccTrx::delete_record。这些记录会一直占用页面空间，扫描时也要一条条地判断可见性。
+ *
+ * 所有活跃事务中最小的事务ID(MvccTrxKit::min_active_trx_id)是清理的水位线。end_xid 小于水位线的记录，
+ * 对所有活跃事务和以后开始的事务都不可见，可以物理删除，同时删除它的索引项，
+ * 页面会放回 RecordFileHandler 的空闲页面集合，后面插入的记录可以复用这些空间。
+ *
+ * 后台线程每隔 interval 执行一轮清理，每轮最多遍历 pages_per_round 个页面，删除 records_per_round 条记录，
+ * 避免清理占用太多的IO和日志带宽。每轮从上一轮停下来的表和页面继续，所有的表轮流清理。
+ *
+ * 页面锁和 RecordFileHandler 的锁只有在 CONCURRENCY 模式下才生效，所以只有这时才启动后台线程，
+ * 其它情况下可以直接调用 vacuum 执行清理。
+ */
+class MvccVacuum
+{
+public:
+  /// 默认多久执行一轮清理，单位毫秒，0表示不启动后台线程
+  static constexpr int DEFAULT_INTERVAL_MS = 1000;
+  /// 默认每轮最多遍历多少个页面
+  static constexpr int DEFAULT_PAGES_PER_ROUND = 256;
+  /// 默认每轮最多删除多少条记录
+  static constexpr int DEFAULT_RECORDS_PER_ROUND = 4096;
+
+  /**
+   * @brief 清理的统计信息
+   */
+  struct Stats
+  {
+    uint64_t rounds         = 0;  ///< 执行了多少轮清理
+    uint64_t pages_scanned  = 0;  ///< 遍历了多少个页面
+    uint64_t records_purged = 0;  ///< 删除了多少条记录
+
+    string to_string() const;
+  };
+
+  /**
+   * @brief 暂停清理
+   * @details 创建和删除表之前需要暂停，清理线程会遍历数据库中所有的表。会等待正在执行的清理结束
+   */
+  class PauseGuard
+  {
+  public:
+    explicit PauseGuard(MvccVacuum *vacuum) : vacuum_(vacuum)
+    {
+      if (vacuum_ != nullptr) {
+        vacuum_->pause();
+      }
+    }
+    ~PauseGuard()
+    {
+      if (vacuum_ != nullptr) {
+        vacuum_->resume();
+      }
+    }
+
+  private:
+    MvccVacuum *vacuum_;
+  };
+
+public:
+  MvccVacuum(Db &db, MvccTrxKit &trx_kit);
+  ~MvccVacuum();
+
+  /**
+   * @brief 设置速率限制并启动后台线程
+   * @param interval_ms 多久执行一轮清理，0表示不启动后台线程
+   * @param pages_per_round 每轮最多遍历多少个页面
+   * @param records_per_round 每轮最多删除多少条记录
+   */
+  RC start(int interval_ms, int pages_per_round, int records_per_round);
+
+  /**
+   * @brief 停止并等待后台线程结束
+   */
+  void stop();
+
+  /**
+   * @brief 执行一轮清理
+   * @details 从上一轮停下来的位置开始，受 pages_per_round 和 records_per_round 的限制
+   * @return 删除了多少条记录
+   */
+  int vacuum();
+
+  /**
+   * @brief 把所有的表完整地清理一遍，不受每轮的速率限制
+   * @return 删除了多少条记录
+   */
+  int vacuum_all();
+
+  Stats stats() const;
+
+  int interval_ms() const { return interval_ms_; }
+  int pages_per_round() const { return pages_per_round_; }
+  int records_per_round() const { return records_per_round_; }
+
+private:
+  void thread_func();
+
+  void pause();
+  void resume();
+
+  /**
+   * @brief 从 current_table_ 和 current_page_ 开始清理，直到用完额度或者所有的表都清理了一遍
+   * @details 调用者需要持有 round_lock_
+   */
+  int vacuum_tables(int page_limit, int record_limit);
+
+  /**
+   * @brief 记录是否已经被删除，而且对所有活跃事务都不可见
+   */
+  static bool is_dead(const Table *table, const Record &record, int32_t min_active_trx_id);
+
+private:
+  Db         &db_;
+  MvccTrxKit &trx_kit_;
+
+  int interval_ms_       = 0;
+  int pages_per_round_   = DEFAULT_PAGES_PER_ROUND;
+  int records_per_round_ = DEFAULT_RECORDS_PER_ROUND;
+
+  thread             thread_;
+  atomic_bool        running_{false};
+  mutex              wakeup_lock_;
+  condition_variable wakeup_cond_;
+
+  mutex round_lock_;  ///< 执行清理和暂停时持有
+
+  string  current_table_;                         ///< 上一轮停在了哪张表上
+  PageNum current_page_ = BP_INVALID_PAGE_NUM;  ///< 下一次从哪个页面开始，无效时从头开始
+
+  atomic<uint64_t> rounds_{0};
+  atomic<uint64_t> pages_scanned_{0};
+  atomic<uint64_t> records_purged_{0};
+};
@@ -12,7 +12,9 @@ See the Mulan PSL v2 for more details. */
 #include <iostream>
 
 #include "gtest/gtest.h"
+#include "common/lang/map.h"
 #include "sql/expr/aggregate_hash_table.h"
+#include "storage/field/field_meta.h"
 
 using namespace std;
 
@@ -103,6 +105,118 @@ TEST(AggregateHashTableTest, DISABLED_standard_hash_table)
   }
 }
 
+/**
+ * @brief 扫描哈希表，返回 (group1, group2) -> (sum(aggr1), count(*), avg(aggr2))
+ */
+template <typename HashTable>
+map<pair<string, int>, vector<string>> scan_groups(HashTable &hash_table)
+{
+  map<pair<string, int>, vector<string>> groups;
+
+  typename HashTable::Scanner scanner(&hash_table);
+  scanner.open_scan();
+  while (true) {
+    Chunk output_chunk;
+    output_chunk.add_column(make_unique<Column>(AttrType::CHARS, 8), 0);
+    output_chunk.add_column(make_unique<Column>(AttrType::INTS, 4), 1);
+    output_chunk.add_column(make_unique<Column>(AttrType::INTS, 4), 2);
+    output_chunk.add_column(make_unique<Column>(AttrType::INTS, 4), 3);
+    output_chunk.add_column(make_unique<Column>(AttrType::FLOATS, 4), 4);
+    RC rc = scanner.next(output_chunk);
+    if (rc == RC::RECORD_EOF) {
+      break;
+    }
+    EXPECT_EQ(RC::SUCCESS, rc);
+    for (int i = 0; i < output_chunk.rows(); i++) {
+      auto key = make_pair(output_chunk.get_value(0, i).get_string(), output_chunk.get_value(1, i).get_int());
+      EXPECT_EQ(0, groups.count(key));
+      groups[key] = {output_chunk.get_value(2, i).to_string(),
+          output_chunk.get_value(3, i).to_string(),
+          output_chunk.get_value(4, i).to_string()};
+    }
+  }
+  return groups;
+}
+
+TEST(AggregateHashTableTest, row_hash_table)
+{
+  FieldMeta group1_meta("group1", AttrType::CHARS, 0, 8, true, 0);
+  FieldMeta group2_meta("group2", AttrType::INTS, 8, 4, true, 1);
+  FieldMeta aggr1_meta("aggr1", AttrType::INTS, 12, 4, true, 2);
+  FieldMeta aggr2_meta("aggr2", AttrType::INTS, 16, 4, true, 3);
+
+  FieldExpr                 group1_expr(nullptr, &group1_meta);
+  FieldExpr                 group2_expr(nullptr, &group2_meta);
+  AggregateExpr             sum_expr(AggregateExpr::Type::SUM, make_unique<FieldExpr>(nullptr, &aggr1_meta));
+  AggregateExpr             count_expr(AggregateExpr::Type::COUNT, make_unique<ValueExpr>(Value(1)));
+  AggregateExpr             avg_expr(AggregateExpr::Type::AVG, make_unique<FieldExpr>(nullptr, &aggr2_meta));
+  std::vector<Expression *> group_by_exprs = {&group1_expr, &group2_expr};
+  std::vector<Expression *> aggregate_exprs = {&sum_expr, &count_expr, &avg_expr};
+  ASSERT_TRUE(RowAggregateHashTable::support(group_by_exprs, aggregate_exprs));
+
+  RowAggregateHashTable      row_hash_table(group_by_exprs, aggregate_exprs);
+  StandardAggregateHashTable standard_hash_table(aggregate_exprs);
+
+  // 分组数量远大于哈希表的初始容量，字符串结束符之后的内容不同也属于同一个分组
+  const int group_num = 5000;
+  for (int round = 0; round < 4; round++) {
+    Chunk group_chunk;
+    Chunk aggr_chunk;
+    group_chunk.add_column(make_unique<Column>(AttrType::CHARS, 8), 0);
+    group_chunk.add_column(make_unique<Column>(AttrType::INTS, 4), 1);
+    aggr_chunk.add_column(make_unique<Column>(AttrType::INTS, 4), 0);
+    aggr_chunk.add_column(make_unique<Column>(AttrType::INTS, 4), 1);
+    for (int i = 0; i < 4096; i++) {
+      const int id = (i * 7 + round * 4096) % group_num;
+      char      group1[8];
+      memset(group1, 'a' + round, sizeof(group1));
+      snprintf(group1, sizeof(group1), "g%d", id % 50);
+      int group2 = id / 50;
+      int aggr   = i - round;
+      group_chunk.column(0).append_one(group1);
+      group_chunk.column(1).append_one((char *)&group2);
+      aggr_chunk.column(0).append_one((char *)&aggr);
+      aggr_chunk.column(1).append_one((char *)&i);
+    }
+
+    Chunk aggr_values_chunk;
+    aggr_values_chunk.add_column(make_unique<Column>(), 0);
+    aggr_values_chunk.add_column(make_unique<Column>(), 1);
+    aggr_values_chunk.add_column(make_unique<Column>(), 2);
+    aggr_values_chunk.column(0).reference(aggr_chunk.column(0));
+    count_expr.child()->get_column(aggr_chunk, aggr_values_chunk.column(1));
+    aggr_values_chunk.column(2).reference(aggr_chunk.column(1));
+
+    ASSERT_EQ(RC::SUCCESS, row_hash_table.add_chunk(group_chunk, aggr_values_chunk));
+    ASSERT_EQ(RC::SUCCESS, standard_hash_table.add_chunk(group_chunk, aggr_values_chunk));
+  }
+
+  ASSERT_EQ(group_num, row_hash_table.size());
+  auto row_groups      = scan_groups(row_hash_table);
+  auto standard_groups = scan_groups(standard_hash_table);
+  ASSERT_EQ(group_num, row_groups.size());
+  ASSERT_EQ(standard_groups, row_groups);
+}
+
+TEST(AggregateHashTableTest, row_hash_table_support)
+{
+  FieldMeta int_meta("i", AttrType::INTS, 0, 4, true, 0);
+  FieldMeta float_meta("f", AttrType::FLOATS, 4, 4, true, 1);
+  FieldMeta chars_meta("c", AttrType::CHARS, 8, 4, true, 2);
+
+  FieldExpr     int_expr(nullptr, &int_meta);
+  FieldExpr     float_expr(nullptr, &float_meta);
+  AggregateExpr sum_expr(AggregateExpr::Type::SUM, make_unique<FieldExpr>(nullptr, &int_meta));
+  AggregateExpr max_expr(AggregateExpr::Type::MAX, make_unique<FieldExpr>(nullptr, &int_meta));
+  AggregateExpr sum_chars_expr(AggregateExpr::Type::SUM, make_unique<FieldExpr>(nullptr, &chars_meta));
+
+  ASSERT_TRUE(RowAggregateHashTable::support({&int_expr}, {&sum_expr}));
+  // 浮点数按字节比较和按值比较的结果不一致
+  ASSERT_FALSE(RowAggregateHashTable::support({&float_expr}, {&sum_expr}));
+  ASSERT_FALSE(RowAggregateHashTable::support({&int_expr}, {&max_expr}));
+  ASSERT_FALSE(RowAggregateHashTable::support({&int_expr}, {&sum_chars_expr}));
+}
+
 #ifdef USE_SIMD
 TEST(AggregateHashTableTest, DISABLED_linear_probing_hash_table)
 {
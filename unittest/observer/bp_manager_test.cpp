@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/frame_replacer.h"
 #include "gtest/gtest.h"
 
 void test_get(BPFrameManager &frame_manager)
@@ -125,6 +126,180 @@ TEST(test_frame_manager, test_frame_manager_simple_lru)
   frame_manager.cleanup();
 }
 
+TEST(test_frame_manager, test_frame_manager_single_shard)
+{
+  BPFrameManager frame_manager("Test", 1 /*shard_num*/);
+  frame_manager.init(2);
+  ASSERT_EQ(1, frame_manager.shard_num());
+
+  test_get(frame_manager);
+
+  test_alloc(frame_manager);
+
+  frame_manager.cleanup();
+}
+
+TEST(test_frame_manager, test_frame_manager_purge_across_shards)
+{
+  BPFrameManager frame_manager("Test", 4 /*shard_num*/);
+  frame_manager.init(1);
+
+  const int      buffer_pool_id = 0;
+  vector<Frame *> frames;
+  for (PageNum page_num = 0; true; page_num++) {
+    Frame *frame = frame_manager.alloc(buffer_pool_id, page_num);
+    if (frame == nullptr) {
+      break;
+    }
+    frames.push_back(frame);
+  }
+  ASSERT_EQ(frames.size(), frame_manager.total_frame_num());
+
+  // 只有一个页面没有被pin，不管它在哪个分片，都应该能被淘汰
+  Frame  *victim          = frames.back();
+  PageNum victim_page_num = victim->page_num();
+  victim->unpin();
+  frames.pop_back();
+
+  int purged_count = frame_manager.purge_frames(1, [victim](Frame *frame) {
+    EXPECT_EQ(victim, frame);
+    return RC::SUCCESS;
+  });
+  ASSERT_EQ(1, purged_count);
+  ASSERT_EQ(nullptr, frame_manager.get(buffer_pool_id, victim_page_num));
+  ASSERT_EQ(frames.size(), frame_manager.frame_num());
+
+  // 所有页面都被pin住时，不能淘汰任何页面
+  purged_count = frame_manager.purge_frames(1, [](Frame *) { return RC::SUCCESS; });
+  ASSERT_EQ(0, purged_count);
+
+  for (Frame *frame : frames) {
+    ASSERT_EQ(RC::SUCCESS, frame_manager.free(buffer_pool_id, frame->page_num(), frame));
+  }
+  ASSERT_EQ(0, frame_manager.frame_num());
+  frame_manager.cleanup();
+}
+
+TEST(test_frame_manager, test_frame_manager_2q)
+{
+  BPFrameManager frame_manager("Test", BPFrameManager::DEFAULT_SHARD_NUM, "2q");
+  frame_manager.init(2);
+  ASSERT_STREQ("2q", frame_manager.replacer_name());
+
+  test_get(frame_manager);
+
+  test_alloc(frame_manager);
+
+  frame_manager.cleanup();
+}
+
+TEST(test_frame_manager, test_frame_manager_unknown_replacer)
+{
+  BPFrameManager frame_manager("Test", 1 /*shard_num*/, "no_such_replacer");
+  ASSERT_EQ(RC::SUCCESS, frame_manager.init(1));
+  ASSERT_STREQ("lru", frame_manager.replacer_name());
+  frame_manager.cleanup();
+}
+
+TEST(test_frame_manager, test_frame_manager_hit_count)
+{
+  BPFrameManager frame_manager("Test");
+  frame_manager.init(1);
+
+  ASSERT_EQ(nullptr, frame_manager.get(0, 1));
+  Frame *frame = frame_manager.alloc(0, 1);
+  ASSERT_NE(nullptr, frame);
+  ASSERT_EQ(frame, frame_manager.get(0, 1));
+  frame->unpin();
+  ASSERT_EQ(1, frame_manager.hit_count());
+  ASSERT_EQ(1, frame_manager.miss_count());
+
+  ASSERT_EQ(RC::SUCCESS, frame_manager.free(0, 1, frame));
+  frame_manager.cleanup();
+}
+
+/**
+ * @brief 先访问两个热点页面，再做一次扫描，看看谁先被淘汰
+ * @param hot_page_first 热点页面是否先于扫描的页面被淘汰
+ */
+void test_scan_after_hot_page(FrameReplacer &replacer, bool hot_page_first)
+{
+  const int     scan_num = 6;
+  vector<Frame> frames(scan_num + 2);
+  for (int i = 0; i < static_cast<int>(frames.size()); i++) {
+    frames[i].set_buffer_pool_id(0);
+    frames[i].set_page_num(i);
+  }
+
+  // 第一个热点页面在内存中被访问了两次
+  Frame *hot_frame1 = &frames[0];
+  replacer.insert(hot_frame1);
+  replacer.access(hot_frame1);
+
+  // 第二个热点页面被淘汰以后又被加载进来
+  Frame *hot_frame2 = &frames[1];
+  replacer.insert(hot_frame2);
+  replacer.remove(hot_frame2);
+  replacer.insert(hot_frame2);
+
+  // 一次扫描，每个页面只访问一次
+  for (int i = 2; i < static_cast<int>(frames.size()); i++) {
+    replacer.insert(&frames[i]);
+  }
+
+  vector<Frame *> victims;
+  replacer.foreach_victim([&victims](Frame *frame) {
+    victims.push_back(frame);
+    return true;
+  });
+  ASSERT_EQ(frames.size(), victims.size());
+  if (hot_page_first) {
+    ASSERT_EQ(hot_frame1, victims[0]);
+    ASSERT_EQ(hot_frame2, victims[1]);
+  } else {
+    ASSERT_EQ(&frames[2], victims[0]);
+    ASSERT_EQ(hot_frame1, victims[victims.size() - 2]);
+    ASSERT_EQ(hot_frame2, victims[victims.size() - 1]);
+  }
+
+  // 遍历可以中途停止
+  int visited = 0;
+  replacer.foreach_victim([&visited](Frame *) { return ++visited < 2; });
+  ASSERT_EQ(2, visited);
+
+  for (Frame &frame : frames) {
+    replacer.remove(&frame);
+  }
+  int left = 0;
+  replacer.foreach_victim([&left](Frame *) {
+    left++;
+    return true;
+  });
+  ASSERT_EQ(0, left);
+}
+
+TEST(test_frame_replacer, test_lru_replacer)
+{
+  unique_ptr<FrameReplacer> replacer;
+  ASSERT_EQ(RC::SUCCESS, FrameReplacer::create("lru", 8, replacer));
+  ASSERT_STREQ("lru", replacer->name());
+
+  // LRU 中热点页面最久没有被访问，会被扫描的页面挤出去
+  test_scan_after_hot_page(*replacer, true /*hot_page_first*/);
+}
+
+TEST(test_frame_replacer, test_2q_replacer)
+{
+  unique_ptr<FrameReplacer> replacer;
+  ASSERT_EQ(RC::SUCCESS, FrameReplacer::create("2Q", 8, replacer));
+  ASSERT_STREQ("2q", replacer->name());
+
+  // 2Q 中扫描的页面只在 A1in 中，会先于热点页面被淘汰
+  test_scan_after_hot_page(*replacer, false /*hot_page_first*/);
+
+  ASSERT_EQ(RC::INVALID_ARGUMENT, FrameReplacer::create("unknown", 8, replacer));
+}
+
 int main(int argc, char **argv)
 {
 
@@ -0,0 +1,223 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "common/lang/algorithm.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/list.h"
+#include "common/lang/memory.h"
+#include "common/lang/random.h"
+#include "common/lang/vector.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/vacuous_log_handler.h"
+#include "storage/index/bplus_tree.h"
+#include "storage/index/bplus_tree_bulk_loader.h"
+#include "gtest/gtest.h"
+
+using namespace common;
+
+#define ORDER 8
+
+class BplusTreeBulkLoaderTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    filesystem::remove_all(test_directory_);
+    filesystem::create_directory(test_directory_);
+
+    ASSERT_EQ(RC::SUCCESS, bpm_.init(make_unique<VacuousDoubleWriteBuffer>()));
+    create_tree("bulk");
+  }
+
+  void TearDown() override
+  {
+    handler_->close();
+    filesystem::remove_all(test_directory_);
+  }
+
+  /// 创建一棵新的空树，替换掉当前的树
+  void create_tree(const string &name)
+  {
+    if (handler_) {
+      handler_->close();
+    }
+
+    filesystem::path file = test_directory_ / (name + ".btree");
+    ASSERT_EQ(RC::SUCCESS, bpm_.create_file(file.c_str()));
+
+    DiskBufferPool *buffer_pool = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bpm_.open_file(log_handler_, file.c_str(), buffer_pool));
+
+    handler_ = make_unique<BplusTreeHandler>();
+    ASSERT_EQ(RC::SUCCESS, handler_->create(log_handler_, *buffer_pool, AttrType::INTS, sizeof(int), ORDER, ORDER));
+
+    options_                  = BplusTreeBulkLoadOptions();
+    options_.temp_file_prefix = (test_directory_ / name).string();
+  }
+
+  /// 按照随机的顺序添加 [0, count) 中的每个数，每个数重复 duplicate 次
+  RC load(int count, int duplicate, BplusTreeBulkLoader &loader)
+  {
+    vector<int> keys;
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < duplicate; j++) {
+        keys.push_back(i);
+      }
+    }
+    shuffle(keys.begin(), keys.end(), mt19937(count));
+
+    for (size_t i = 0; i < keys.size(); i++) {
+      RID rid(static_cast<PageNum>(i / 100), static_cast<SlotNum>(i % 100));
+      RC  rc = loader.add(reinterpret_cast<const char *>(&keys[i]), rid);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+    return loader.finish();
+  }
+
+  /// 按顺序扫描整棵树，返回扫描到的数据条数
+  int scan_count()
+  {
+    BplusTreeScanner scanner(*handler_);
+    EXPECT_EQ(RC::SUCCESS, scanner.open(nullptr, 0, true, nullptr, 0, true));
+
+    int count = 0;
+    RID rid;
+    while (OB_SUCC(scanner.next_entry(rid))) {
+      count++;
+    }
+    scanner.close();
+    return count;
+  }
+
+protected:
+  filesystem::path             test_directory_{"bplus_tree_bulk_loader"};
+  VacuousLogHandler            log_handler_;
+  BufferPoolManager            bpm_;
+  unique_ptr<BplusTreeHandler> handler_;
+  BplusTreeBulkLoadOptions     options_;
+};
+
+TEST_F(BplusTreeBulkLoaderTest, empty)
+{
+  BplusTreeBulkLoader loader(*handler_, options_);
+  ASSERT_EQ(RC::SUCCESS, loader.finish());
+  ASSERT_TRUE(handler_->is_empty());
+}
+
+TEST_F(BplusTreeBulkLoaderTest, in_memory)
+{
+  const int count = 5000;
+
+  BplusTreeBulkLoader loader(*handler_, options_);
+  ASSERT_EQ(RC::SUCCESS, load(count, 1, loader));
+  ASSERT_EQ(0, loader.run_num());
+  ASSERT_TRUE(handler_->validate_tree());
+  ASSERT_EQ(count, scan_count());
+
+  for (int key : {0, 1, count / 2, count - 1}) {
+    list<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, handler_->get_entry(reinterpret_cast<const char *>(&key), sizeof(key), rids));
+    ASSERT_EQ(1, static_cast<int>(rids.size()));
+  }
+}
+
+TEST_F(BplusTreeBulkLoaderTest, spill)
+{
+  const int count     = 5000;
+  const int duplicate = 3;
+
+  // 每个临时文件只能放几百个键值
+  options_.sort_buffer_size = 4096;
+
+  BplusTreeBulkLoader loader(*handler_, options_);
+  ASSERT_EQ(RC::SUCCESS, load(count, duplicate, loader));
+  ASSERT_GT(loader.run_num(), 0);
+  ASSERT_TRUE(handler_->validate_tree());
+  ASSERT_EQ(count * duplicate, scan_count());
+
+  // 临时文件都已经删除了
+  for (const auto &entry : filesystem::directory_iterator(test_directory_)) {
+    ASSERT_EQ(string::npos, entry.path().string().find(".run.")) << entry.path();
+  }
+}
+
+TEST_F(BplusTreeBulkLoaderTest, unique)
+{
+  {
+    options_.unique           = true;
+    options_.sort_buffer_size = 4096;
+    BplusTreeBulkLoader loader(*handler_, options_);
+    ASSERT_EQ(RC::RECORD_DUPLICATE_KEY, load(1000, 2, loader));
+  }
+
+  create_tree("unique");
+  options_.unique = true;
+
+  BplusTreeBulkLoader loader(*handler_, options_);
+  ASSERT_EQ(RC::SUCCESS, load(1000, 1, loader));
+  ASSERT_EQ(1000, scan_count());
+}
+
+TEST_F(BplusTreeBulkLoaderTest, fill_factor)
+{
+  for (int fill_factor : {50, 75, 100}) {
+    create_tree("fill_factor_" + to_string(fill_factor));
+    options_.fill_factor = fill_factor;
+
+    BplusTreeBulkLoader loader(*handler_, options_);
+    ASSERT_EQ(RC::SUCCESS, load(1234, 1, loader));
+    ASSERT_TRUE(handler_->validate_tree()) << "fill factor " << fill_factor;
+    ASSERT_EQ(1234, scan_count());
+  }
+}
+
+TEST_F(BplusTreeBulkLoaderTest, modify_after_load)
+{
+  const int count = 2000;
+
+  BplusTreeBulkLoader loader(*handler_, options_);
+  ASSERT_EQ(RC::SUCCESS, load(count, 1, loader));
+
+  ASSERT_NE(RC::SUCCESS, loader.finish());  // 树已经不是空的了
+
+  // 批量构建之后，插入和删除依然可以正常分裂、合并节点
+  for (int i = count; i < count * 2; i++) {
+    RID rid(1000, i);
+    ASSERT_EQ(RC::SUCCESS, handler_->insert_entry(reinterpret_cast<const char *>(&i), &rid));
+  }
+  ASSERT_TRUE(handler_->validate_tree());
+  ASSERT_EQ(count * 2, scan_count());
+
+  vector<int> keys(count);
+  for (int i = 0; i < count; i++) {
+    keys[i] = i;
+  }
+  shuffle(keys.begin(), keys.end(), mt19937(1));
+  for (size_t i = 0; i < keys.size(); i++) {
+    // 加载时RID是按照打乱后的位置生成的，这里需要查出来再删除
+    list<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, handler_->get_entry(reinterpret_cast<const char *>(&keys[i]), sizeof(int), rids));
+    ASSERT_EQ(1, static_cast<int>(rids.size()));
+    ASSERT_EQ(RC::SUCCESS, handler_->delete_entry(reinterpret_cast<const char *>(&keys[i]), &rids.front()));
+  }
+  ASSERT_TRUE(handler_->validate_tree());
+  ASSERT_EQ(count, scan_count());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("bplus_tree_bulk_loader_test.log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
@@ -17,7 +17,11 @@ See the Mulan PSL v2 for more details. */
 #include <filesystem>
 
 #include "common/log/log.h"
+#include "common/lang/algorithm.h"
 #include "common/lang/memory.h"
+#include "common/lang/random.h"
+#include "common/lang/thread.h"
+#include "common/lang/vector.h"
 #include "common/lang/filesystem.h"
 #include "sql/parser/parse_defs.h"
 #include "storage/buffer/disk_buffer_pool.h"
@@ -518,6 +522,78 @@ TEST(test_bplus_tree, test_internal_index_node_handle)
   }
 }
 
+TEST(test_bplus_tree, test_key_comparator)
+{
+  // 按照类型特化的比较函数要与 DataType 的比较结果一致
+  auto generic_compare = [](AttrType type, const char *v1, const char *v2, int length) {
+    Value left;
+    left.set_type(type);
+    left.set_data(const_cast<char *>(v1), length);
+    Value right;
+    right.set_type(type);
+    right.set_data(const_cast<char *>(v2), length);
+    return DataType::type_instance(type)->compare(left, right);
+  };
+  auto sign = [](int v) { return (v > 0) - (v < 0); };
+
+  const int        attr_length = 8;
+  const int        key_length  = attr_length + sizeof(RID);
+  const int        item_size   = key_length + sizeof(RID);
+  vector<AttrType> types       = {AttrType::INTS, AttrType::DATES, AttrType::FLOATS, AttrType::CHARS};
+  for (AttrType type : types) {
+    // 属性值只有少数几个，让不同的键值有相同的属性
+    vector<vector<char>> keys;
+    for (int i = 0; i < 40; i++) {
+      vector<char> key(key_length, 0);
+      const int    value = i % 7 - 3;
+      if (type == AttrType::CHARS) {
+        const string str_value = "k" + to_string(value + 3);
+        memcpy(key.data(), str_value.data(), str_value.size());
+      } else if (type == AttrType::FLOATS) {
+        const float float_value = value * 0.5f;
+        memcpy(key.data(), &float_value, sizeof(float_value));
+      } else {
+        memcpy(key.data(), &value, sizeof(value));
+      }
+      RID rid(i % 3, i);
+      memcpy(key.data() + attr_length, &rid, sizeof(rid));
+      keys.push_back(key);
+    }
+
+    KeyComparator comparator;
+    comparator.init(type, attr_length);
+    for (const vector<char> &left : keys) {
+      for (const vector<char> &right : keys) {
+        ASSERT_EQ(sign(generic_compare(type, left.data(), right.data(), attr_length)),
+            sign(comparator.attr_comparator()(left.data(), right.data())));
+      }
+    }
+
+    vector<vector<char>> sorted_keys = keys;
+    sort(sorted_keys.begin(), sorted_keys.end(), [&comparator](const vector<char> &left, const vector<char> &right) {
+      return comparator(left.data(), right.data()) < 0;
+    });
+
+    // 节点中有不同个数的键值时，与顺序查找的结果一致
+    for (int size = 0; size <= static_cast<int>(sorted_keys.size()); size += 3) {
+      vector<char> items(size * item_size + 1);
+      for (int i = 0; i < size; i++) {
+        memcpy(items.data() + i * item_size, sorted_keys[i].data(), key_length);
+      }
+
+      for (const vector<char> &key : keys) {
+        int expected = 0;
+        while (expected < size && comparator(sorted_keys[expected].data(), key.data()) < 0) {
+          expected++;
+        }
+        bool found = false;
+        ASSERT_EQ(expected, comparator.lower_bound(items.data(), size, item_size, key.data(), &found));
+        ASSERT_EQ(expected < size && comparator(sorted_keys[expected].data(), key.data()) == 0, found);
+      }
+    }
+  }
+}
+
 TEST(test_bplus_tree, test_chars)
 {
   LoggerFactory::init_default("test_chars.log");
@@ -793,6 +869,280 @@ TEST(test_bplus_tree, test_scanner)
   handler.close();
 }
 
+TEST(test_bplus_tree, test_composite_key)
+{
+  LoggerFactory::init_default("test.log");
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::path buffer_pool_file = test_directory / "composite.btree";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  VacuousLogHandler log_handler;
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+  ASSERT_NE(nullptr, buffer_pool);
+
+  // 键值是 (int, char(4), float)
+  const vector<AttrType> attr_types   = {AttrType::INTS, AttrType::CHARS, AttrType::FLOATS};
+  const vector<int>      attr_lengths = {4, 4, 4};
+  const int              attr_length  = 12;
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(log_handler, *buffer_pool, attr_types, attr_lengths, ORDER, ORDER));
+  ASSERT_EQ(3, handler.file_header().attr_num);
+  ASSERT_EQ(attr_length, handler.file_header().attr_length);
+
+  auto make_user_key = [](int tenant, const char *name, float score) {
+    string key(12, '\0');
+    memcpy(key.data(), &tenant, sizeof(tenant));
+    memcpy(key.data() + 4, name, std::min(strlen(name), static_cast<size_t>(4)));
+    memcpy(key.data() + 8, &score, sizeof(score));
+    return key;
+  };
+
+  // 10个 tenant，每个 tenant 有 a/b/c 三个名字，每个名字有两个分数
+  const char *names[] = {"a", "b", "c"};
+  RID         rid;
+  for (int tenant = 0; tenant < 10; tenant++) {
+    for (int n = 0; n < 3; n++) {
+      for (int score = 0; score < 2; score++) {
+        string key   = make_user_key(tenant, names[n], static_cast<float>(score));
+        rid.page_num = tenant;
+        rid.slot_num = n * 2 + score;
+        ASSERT_EQ(RC::SUCCESS, handler.insert_entry(key.data(), &rid));
+      }
+    }
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  BplusTreeHandler *tree = &handler;
+  auto scan_count = [&tree](const char *left, int left_len, bool left_inclusive, const char *right, int right_len,
+                        bool right_inclusive, vector<RID> *rids = nullptr) {
+    BplusTreeScanner scanner(*tree);
+    EXPECT_EQ(RC::SUCCESS, scanner.open(left, left_len, left_inclusive, right, right_len, right_inclusive));
+    int count = 0;
+    RID rid;
+    RC  rc = RC::SUCCESS;
+    while ((rc = scanner.next_entry(rid)) == RC::SUCCESS) {
+      count++;
+      if (rids != nullptr) {
+        rids->push_back(rid);
+      }
+    }
+    EXPECT_EQ(RC::RECORD_EOF, rc);
+    return count;
+  };
+
+  // 完整的键值
+  string      key = make_user_key(3, "b", 1.0f);
+  vector<RID> rids;
+  ASSERT_EQ(1, scan_count(key.data(), attr_length, true, key.data(), attr_length, true, &rids));
+  ASSERT_EQ(RID(3, 3), rids.front());
+
+  // 只有第一个字段
+  int tenant = 3;
+  rids.clear();
+  ASSERT_EQ(6, scan_count((const char *)&tenant, 4, true, (const char *)&tenant, 4, true, &rids));
+  for (const RID &rid : rids) {
+    ASSERT_EQ(3, rid.page_num);
+  }
+  ASSERT_EQ(0, scan_count((const char *)&tenant, 4, false, (const char *)&tenant, 4, true));
+  ASSERT_EQ(0, scan_count((const char *)&tenant, 4, true, (const char *)&tenant, 4, false));
+
+  // 第一个字段的范围
+  int tenant_end = 5;
+  ASSERT_EQ(12, scan_count((const char *)&tenant, 4, true, (const char *)&tenant_end, 4, false));
+  ASSERT_EQ(12, scan_count((const char *)&tenant, 4, false, (const char *)&tenant_end, 4, true));
+  ASSERT_EQ(36, scan_count((const char *)&tenant, 4, false, nullptr, 0, true));
+  ASSERT_EQ(18, scan_count(nullptr, 0, true, (const char *)&tenant, 4, false));
+
+  // 前两个字段相同，第三个字段的范围
+  string prefix = make_user_key(3, "b", 0.0f).substr(0, 8);
+  ASSERT_EQ(2, scan_count(prefix.data(), 8, true, prefix.data(), 8, true));
+  string right = make_user_key(3, "b", 0.5f);
+  rids.clear();
+  ASSERT_EQ(1, scan_count(prefix.data(), 8, true, right.data(), attr_length, false, &rids));
+  ASSERT_EQ(RID(3, 2), rids.front());
+
+  // 第二个字段的范围
+  string left_prefix  = make_user_key(3, "a", 0.0f).substr(0, 8);
+  string right_prefix = make_user_key(3, "c", 0.0f).substr(0, 8);
+  ASSERT_EQ(2, scan_count(left_prefix.data(), 8, false, right_prefix.data(), 8, false));
+  ASSERT_EQ(6, scan_count(left_prefix.data(), 8, true, right_prefix.data(), 8, true));
+
+  // 删除之后再按照前缀查找
+  key = make_user_key(3, "b", 1.0f);
+  rid = RID(3, 3);
+  ASSERT_EQ(RC::SUCCESS, handler.delete_entry(key.data(), &rid));
+  ASSERT_EQ(5, scan_count((const char *)&tenant, 4, true, (const char *)&tenant, 4, true));
+
+  handler.close();
+
+  // 重新打开后字段信息保持不变
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+  BplusTreeHandler reopened;
+  ASSERT_EQ(RC::SUCCESS, reopened.open(log_handler, *buffer_pool));
+  ASSERT_EQ(3, reopened.file_header().attr_num);
+  ASSERT_EQ(AttrType::CHARS, reopened.file_header().attr_types[1]);
+  tree = &reopened;
+  ASSERT_EQ(59, scan_count(nullptr, 0, true, nullptr, 0, true));
+  ASSERT_EQ(5, scan_count((const char *)&tenant, 4, true, (const char *)&tenant, 4, true));
+  reopened.close();
+}
+
+TEST(test_bplus_tree, test_optimistic_read)
+{
+  LoggerFactory::init_default("test.log");
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::path buffer_pool_file = test_directory / "optimistic.btree";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  VacuousLogHandler log_handler;
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+  ASSERT_NE(nullptr, buffer_pool);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(log_handler, *buffer_pool, AttrType::INTS, sizeof(int), ORDER, ORDER));
+  ASSERT_TRUE(handler.optimistic_read());
+
+  // 偶数键值一直存在，奇数键值会在并发测试中反复插入删除
+  const int key_num = 2000;
+  for (int i = 0; i < key_num; i += 2) {
+    RID rid(i, i);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&i, &rid));
+  }
+
+  // 加写锁时版本号是奇数，释放写锁后版本号发生变化
+  Frame *root_frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(handler.file_header().root_page, &root_frame));
+  uint64_t version = root_frame->read_version();
+  ASSERT_EQ(0, version % 2);
+  ASSERT_TRUE(root_frame->validate_version(version));
+  root_frame->write_latch();
+  ASSERT_EQ(1, root_frame->read_version() % 2);
+  ASSERT_FALSE(root_frame->validate_version(version));
+  ASSERT_FALSE(root_frame->validate_version(root_frame->read_version()));
+  root_frame->write_unlatch();
+  ASSERT_EQ(version + 2, root_frame->read_version());
+  ASSERT_TRUE(root_frame->validate_version(version + 2));
+
+  // 只释放指定区间内的pin，区间前后的pin都保留
+  {
+    LatchMemo memo(buffer_pool);
+    Frame    *frame = nullptr;
+    for (int i = 0; i < 4; i++) {
+      ASSERT_EQ(RC::SUCCESS, memo.get_page(handler.file_header().root_page, frame));
+    }
+    ASSERT_EQ(5, root_frame->pin_count());
+    memo.release_range(1, 3);
+    ASSERT_EQ(2, memo.memo_point());
+    ASSERT_EQ(3, root_frame->pin_count());
+    memo.release_range(1, 1);
+    ASSERT_EQ(2, memo.memo_point());
+    memo.release();
+    ASSERT_EQ(1, root_frame->pin_count());
+  }
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(root_frame));
+
+  // 乐观读与 crabing protocol 的结果一致
+  auto scan_count = [&handler]() {
+    BplusTreeScanner scanner(handler);
+    EXPECT_EQ(RC::SUCCESS, scanner.open(nullptr, 0, true, nullptr, 0, true));
+    RID rid;
+    int count = 0;
+    while (scanner.next_entry(rid) == RC::SUCCESS) {
+      count++;
+    }
+    return count;
+  };
+
+  for (bool optimistic : {true, false}) {
+    handler.set_optimistic_read(optimistic);
+    for (int i = 0; i < key_num; i++) {
+      list<RID> rids;
+      ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&i, sizeof(i), rids));
+      if (i % 2 == 0) {
+        ASSERT_EQ(1, rids.size());
+        ASSERT_EQ(RID(i, i), rids.front());
+      } else {
+        ASSERT_EQ(0, rids.size());
+      }
+    }
+    ASSERT_EQ(key_num / 2, scan_count());
+  }
+  handler.set_optimistic_read(true);
+
+#ifdef CONCURRENCY
+  // 写线程不停地插入删除奇数键值，引起节点的分裂与合并，读线程查找的偶数键值必须都能找到
+  atomic<bool> stop{false};
+  atomic<int>  errors{0};
+
+  vector<thread> writers;
+  for (int t = 0; t < 2; t++) {
+    writers.emplace_back([&, t]() {
+      for (int round = 0; round < 5; round++) {
+        for (int i = 1 + t * 2; i < key_num; i += 4) {
+          RID rid(i, i);
+          if (handler.insert_entry((const char *)&i, &rid) != RC::SUCCESS) {
+            errors++;
+          }
+        }
+        for (int i = 1 + t * 2; i < key_num; i += 4) {
+          RID rid(i, i);
+          if (handler.delete_entry((const char *)&i, &rid) != RC::SUCCESS) {
+            errors++;
+          }
+        }
+      }
+    });
+  }
+
+  vector<thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&, t]() {
+      for (int i = t * 2; !stop.load(); i = (i + 8) % key_num) {
+        list<RID> rids;
+        RC        rc = handler.get_entry((const char *)&i, sizeof(i), rids);
+        if (rc == RC::LOCKED_NEED_WAIT) {
+          continue;  // 扫描跨页时可能需要重试
+        }
+        if (rc != RC::SUCCESS || rids.size() != 1 || rids.front() != RID(i, i)) {
+          errors++;
+        }
+      }
+    });
+  }
+
+  for (thread &writer : writers) {
+    writer.join();
+  }
+  stop = true;
+  for (thread &reader : readers) {
+    reader.join();
+  }
+
+  ASSERT_EQ(0, errors.load());
+  ASSERT_TRUE(handler.validate_tree());
+  ASSERT_EQ(key_num / 2, scan_count());
+#endif  // CONCURRENCY
+
+  handler.close();
+}
+
 TEST(test_bplus_tree, test_bplus_tree_insert)
 {
   LoggerFactory::init_default("test.log");
@@ -826,6 +1176,209 @@ TEST(test_bplus_tree, test_bplus_tree_insert)
   handler = nullptr;
 }
 
+TEST(test_bplus_tree, test_compressed_leaf_insert)
+{
+  LoggerFactory::init_default("test.log");
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::path buffer_pool_file = test_directory / "test_compressed_leaf_insert.btree";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  VacuousLogHandler log_handler;
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+  ASSERT_NE(nullptr, buffer_pool);
+
+  BplusTreeHandler *handler = new BplusTreeHandler();
+  ASSERT_EQ(RC::SUCCESS,
+      handler->create(log_handler, *buffer_pool, AttrType::INTS, sizeof(int), ORDER, ORDER, true /*leaf_compressed*/));
+  ASSERT_EQ(1, handler->file_header().leaf_compressed);
+
+  test_insert(handler);
+
+  test_get(handler);
+
+  test_delete(handler);
+
+  handler->close();
+  delete handler;
+  handler = nullptr;
+}
+
+TEST(test_bplus_tree, test_compressed_leaf_chars)
+{
+  LoggerFactory::init_default("test.log");
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  VacuousLogHandler log_handler;
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+
+  // 键值有很长的公共前缀，偶尔有一些前缀不同的键值，会让页面的前缀变短
+  const int attr_length = 200;
+  const int key_num     = 3000;
+  auto      make_key    = [](int i) {
+    string key(attr_length, '\0');
+    if (i % 97 == 0) {
+      snprintf(key.data(), key.size(), "other/%08d", i);
+    } else {
+      snprintf(key.data(), key.size(), "warehouse/district/customer/order/line/%08d", i);
+    }
+    return key;
+  };
+
+  vector<int> numbers(key_num);
+  for (int i = 0; i < key_num; i++) {
+    numbers[i] = i;
+  }
+  shuffle(numbers.begin(), numbers.end(), mt19937(key_num));
+
+  BplusTreeStats stats[2];
+  for (bool compressed : {false, true}) {
+    filesystem::path buffer_pool_file = test_directory / (compressed ? "compressed.btree" : "plain.btree");
+    ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+    DiskBufferPool *buffer_pool = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+
+    BplusTreeHandler handler;
+    ASSERT_EQ(RC::SUCCESS,
+        handler.create(log_handler, *buffer_pool, AttrType::CHARS, attr_length, -1, -1, compressed));
+
+    for (int i : numbers) {
+      string key = make_key(i);
+      RID    rid(i, i);
+      ASSERT_EQ(RC::SUCCESS, handler.insert_entry(key.data(), &rid));
+    }
+    ASSERT_TRUE(handler.validate_tree());
+    ASSERT_EQ(RC::SUCCESS, handler.stats(stats[compressed]));
+    ASSERT_EQ(key_num, stats[compressed].entry_num);
+
+    for (int i = 0; i < key_num; i++) {
+      string    key = make_key(i);
+      list<RID> rids;
+      ASSERT_EQ(RC::SUCCESS, handler.get_entry(key.data(), static_cast<int>(strlen(key.c_str())), rids));
+      ASSERT_EQ(1, rids.size());
+      ASSERT_EQ(RID(i, i), rids.front());
+    }
+
+    // 删除一半的数据，触发节点的合并与重新分配
+    for (int i : numbers) {
+      if (i % 2 == 0) {
+        string key = make_key(i);
+        RID    rid(i, i);
+        ASSERT_EQ(RC::SUCCESS, handler.delete_entry(key.data(), &rid));
+      }
+    }
+    ASSERT_TRUE(handler.validate_tree());
+
+    BplusTreeScanner scanner(handler);
+    ASSERT_EQ(RC::SUCCESS, scanner.open(nullptr, 0, true, nullptr, 0, true));
+    int count = 0;
+    RID rid;
+    while (scanner.next_entry(rid) == RC::SUCCESS) {
+      ASSERT_EQ(1, rid.page_num % 2);
+      count++;
+    }
+    scanner.close();
+    ASSERT_EQ(key_num / 2, count);
+
+    handler.close();
+  }
+
+  LOG_INFO("plain leaf: %s", stats[0].to_string().c_str());
+  LOG_INFO("compressed leaf: %s", stats[1].to_string().c_str());
+  ASSERT_LT(stats[1].leaf_node_num * 2, stats[0].leaf_node_num);
+  ASSERT_GT(stats[1].leaf_fanout(), stats[0].leaf_fanout() * 2);
+  ASSERT_LE(stats[1].height, stats[0].height);
+}
+
+TEST(test_bplus_tree, test_get_entries)
+{
+  LoggerFactory::init_default("test.log");
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  VacuousLogHandler log_handler;
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+
+  // 偶数的键值，每个键值重复 duplicate 次，重复的键值会跨越多个叶子节点
+  const int key_num   = 2000;
+  const int duplicate = 3;
+  for (bool compressed : {false, true}) {
+    filesystem::path buffer_pool_file = test_directory / (compressed ? "compressed.btree" : "plain.btree");
+    ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+    DiskBufferPool *buffer_pool = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+
+    BplusTreeHandler handler;
+    ASSERT_EQ(RC::SUCCESS,
+        handler.create(log_handler, *buffer_pool, AttrType::INTS, sizeof(int), ORDER, ORDER, compressed));
+
+    for (int i = 0; i < key_num; i += 2) {
+      for (int j = 0; j < duplicate; j++) {
+        RID rid(i, j);
+        ASSERT_EQ(RC::SUCCESS, handler.insert_entry(reinterpret_cast<const char *>(&i), &rid));
+      }
+    }
+
+    // 空的键值列表
+    vector<RID> empty_rids;
+    vector<int> empty_offsets;
+    ASSERT_EQ(RC::SUCCESS, handler.get_entries(nullptr, 0, sizeof(int), empty_rids, &empty_offsets));
+    ASSERT_EQ(1, empty_offsets.size());
+
+    // 有序的键值，包含不存在的键值、相同的键值和离得很远的键值
+    vector<int> probes;
+    for (int i = -3; i < key_num + 3; i += 1 + (i + 7) % 7) {
+      probes.push_back(i);
+      if (i % 5 == 0) {
+        probes.push_back(i);
+      }
+    }
+
+    auto check = [&](const vector<int> &keys) {
+      vector<RID> rids;
+      vector<int> offsets;
+      ASSERT_EQ(RC::SUCCESS,
+          handler.get_entries(reinterpret_cast<const char *>(keys.data()), static_cast<int>(keys.size()), sizeof(int), rids, &offsets));
+      ASSERT_EQ(keys.size() + 1, offsets.size());
+      ASSERT_EQ(rids.size(), static_cast<size_t>(offsets.back()));
+      for (size_t i = 0; i < keys.size(); i++) {
+        const int key      = keys[i];
+        const int expected = (key >= 0 && key < key_num && key % 2 == 0) ? duplicate : 0;
+        ASSERT_EQ(expected, offsets[i + 1] - offsets[i]) << "key=" << key;
+        for (int j = offsets[i]; j < offsets[i + 1]; j++) {
+          ASSERT_EQ(key, rids[j].page_num);
+        }
+      }
+    };
+
+    check(probes);
+
+    // 无序的键值也能得到正确的结果
+    shuffle(probes.begin(), probes.end(), mt19937(key_num));
+    check(probes);
+
+    handler.close();
+  }
+}
+
 int main(int argc, char **argv)
 {
 
@@ -18,6 +18,7 @@ See the Mulan PSL v2 for more details. */
 #include "common/log/log.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/clog/disk_log_handler.h"
+#include "storage/clog/vacuous_log_handler.h"
 #include "storage/buffer/buffer_pool_log.h"
 #include "storage/buffer/double_write_buffer.h"
 
@@ -393,6 +394,107 @@ TEST(BufferPoolLog, test_wal_multi_files)
   ASSERT_EQ(RC::SUCCESS, log_handler2.await_termination());
 }
 
+TEST(BufferPoolLog, test_wal_beyond_header_bitmap)
+{
+  /// 页面个数超过文件头位图能记录的个数，后面的页面记录在分配图中
+  /*
+   * 1. 分配页面，直到第1组也分配了一些页面
+   * 2. 释放第0组和第1组的一些页面，再分配时优先使用第0组
+   * 3. 重新打开文件，页面个数不变
+   * 4. 删除文件重做日志，页面个数不变
+   */
+  // 要分配几万个页面，TRACE 级别的日志太多了
+  const LOG_LEVEL log_level = g_log->get_log_level();
+  g_log->set_log_level(LOG_LEVEL_INFO);
+
+  filesystem::path test_path("test_disk_buffer_pool_wal_beyond_header_bitmap");
+  filesystem::path clog_path = test_path / "clog";
+
+  filesystem::remove_all(test_path);
+  filesystem::create_directory(test_path);
+
+  filesystem::path  buffer_pool_filename = test_path / "buffer_pool.bp";
+  BufferPoolManager buffer_pool_manager;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.create_file(buffer_pool_filename.c_str()));
+
+  BufferPoolLogReplayer log_replayer(buffer_pool_manager);
+  DiskBufferPool       *buffer_pool = nullptr;
+  DiskLogHandler        log_handler;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+
+  ASSERT_EQ(RC::SUCCESS, log_handler.init(clog_path.c_str()));
+  ASSERT_EQ(RC::SUCCESS, log_handler.replay(log_replayer, 0));
+  ASSERT_EQ(RC::SUCCESS, log_handler.start());
+
+  // 第1组的第一个页面是分配图，不会分配给调用方
+  const PageNum map_page_num      = BPFileHeader::BITMAP_PAGE_NUM;
+  const int     allocate_page_num = BPFileHeader::BITMAP_PAGE_NUM - 1 + 100;
+  for (int i = 0; i < allocate_page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    ASSERT_NE(map_page_num, frame->page_num());
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+  ASSERT_EQ(allocate_page_num, buffer_pool_page_count(buffer_pool));
+  ASSERT_NE(RC::SUCCESS, buffer_pool->dispose_page(map_page_num));
+
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->dispose_page(map_page_num + 10));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->dispose_page(map_page_num + 20));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->dispose_page(100));
+
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+  ASSERT_EQ(100, frame->page_num());
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+  ASSERT_EQ(map_page_num + 10, frame->page_num());
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+
+  const int page_count = allocate_page_num - 1;
+  ASSERT_EQ(page_count, buffer_pool_page_count(buffer_pool));
+
+  ASSERT_EQ(RC::SUCCESS, log_handler.stop());
+  ASSERT_EQ(RC::SUCCESS, log_handler.await_termination());
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.close_file(buffer_pool_filename.c_str()));
+
+  /// 重新打开文件，从分配图中加载页面的分配情况。这里的修改不记录日志，最后又恢复原状了
+  VacuousLogHandler vacuous_log_handler;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(vacuous_log_handler, buffer_pool_filename.c_str(), buffer_pool));
+  ASSERT_EQ(page_count, buffer_pool_page_count(buffer_pool));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+  ASSERT_EQ(map_page_num + 20, frame->page_num());
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->dispose_page(map_page_num + 20));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.close_file(buffer_pool_filename.c_str()));
+
+  /// 删除文件重做日志，分配图在回放日志时重新创建
+  ASSERT_TRUE(filesystem::remove(buffer_pool_filename));
+
+  BufferPoolManager buffer_pool_manager2;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager2.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager2.create_file(buffer_pool_filename.c_str()));
+
+  DiskLogHandler log_handler2;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager2.open_file(log_handler2, buffer_pool_filename.c_str(), buffer_pool));
+
+  BufferPoolLogReplayer log_replayer2(buffer_pool_manager2);
+  ASSERT_EQ(RC::SUCCESS, log_handler2.init(clog_path.c_str()));
+  ASSERT_EQ(RC::SUCCESS, log_handler2.replay(log_replayer2, 0));
+  ASSERT_EQ(page_count, buffer_pool_page_count(buffer_pool));
+  ASSERT_EQ(RC::SUCCESS, log_handler2.start());
+
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+  ASSERT_EQ(map_page_num + 20, frame->page_num());
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager2.close_file(buffer_pool_filename.c_str()));
+  ASSERT_EQ(RC::SUCCESS, log_handler2.stop());
+  ASSERT_EQ(RC::SUCCESS, log_handler2.await_termination());
+  filesystem::remove_all(test_path);
+  g_log->set_log_level(log_level);
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -60,6 +60,74 @@ TEST(ChunkTest, chunk_test)
   }
 }
 
+TEST(ChunkTest, selection)
+{
+  const int row_num = 10;
+  Chunk     chunk;
+  chunk.add_column(make_unique<Column>(AttrType::INTS, sizeof(int), row_num), 0);
+  chunk.add_column(make_unique<Column>(AttrType::CHARS, 7, row_num), 1);
+  for (int i = 0; i < row_num; i++) {
+    chunk.column(0).append_one((char *)&i);
+    chunk.column(1).append_value(Value(("s" + to_string(i)).c_str()));
+  }
+  ASSERT_FALSE(chunk.has_selection());
+  ASSERT_EQ(row_num, chunk.selected_rows());
+  ASSERT_EQ(nullptr, chunk.selection());
+
+  // 两个列引用同一份数据，再加一个常量列
+  Chunk filtered;
+  filtered.add_column(make_unique<Column>(), 0);
+  filtered.add_column(make_unique<Column>(), 1);
+  filtered.add_column(make_unique<Column>(), 2);
+  filtered.column(0).reference(chunk.column(0));
+  filtered.column(1).reference(chunk.column(0));
+  filtered.column(2).init(Value(100), row_num);
+
+  const vector<int> selection = {1, 4, 5, 9};
+  filtered.set_selection(selection.data(), static_cast<int>(selection.size()));
+  ASSERT_TRUE(filtered.has_selection());
+  ASSERT_EQ(row_num, filtered.rows());
+  ASSERT_EQ(4, filtered.selected_rows());
+  ASSERT_EQ(5, filtered.selected_row(2));
+
+  // reference 和拷贝都会带上选择向量
+  Chunk referenced;
+  referenced.reference(filtered);
+  ASSERT_EQ(4, referenced.selected_rows());
+  Chunk copied(referenced);
+  ASSERT_EQ(4, copied.selected_rows());
+  ASSERT_EQ(9, copied.selected_row(3));
+
+  ASSERT_EQ(RC::SUCCESS, referenced.compact());
+  ASSERT_FALSE(referenced.has_selection());
+  ASSERT_EQ(4, referenced.rows());
+  for (int i = 0; i < referenced.rows(); i++) {
+    ASSERT_EQ(selection[i], referenced.get_value(0, i).get_int());
+    ASSERT_EQ(selection[i], referenced.get_value(1, i).get_int());
+    ASSERT_EQ(100, referenced.get_value(2, i).get_int());
+  }
+
+  // 原来的数据没有被修改
+  ASSERT_EQ(row_num, chunk.rows());
+  ASSERT_EQ(4, filtered.selected_rows());
+  for (int i = 0; i < row_num; i++) {
+    ASSERT_EQ(i, chunk.get_value(0, i).get_int());
+  }
+
+  // 长度不是 1/2/4/8 的列
+  chunk.set_selection(selection.data(), static_cast<int>(selection.size()));
+  ASSERT_EQ(RC::SUCCESS, chunk.compact());
+  ASSERT_EQ(4, chunk.rows());
+  for (int i = 0; i < chunk.rows(); i++) {
+    ASSERT_EQ("s" + to_string(selection[i]), chunk.get_value(1, i).get_string());
+  }
+
+  chunk.set_selection(selection.data(), 0);
+  ASSERT_EQ(0, chunk.selected_rows());
+  chunk.reset_data();
+  ASSERT_FALSE(chunk.has_selection());
+}
+
 int main(int argc, char **argv)
 {
 
@@ -12,9 +12,12 @@ See the Mulan PSL v2 for more details. */
 // Created by wangyunlai on 2024/02/01
 //
 
+#include <fcntl.h>
 #include <filesystem>
+#include <unistd.h>
 
 #include "gtest/gtest.h"
+#include "common/io/io.h"
 #include "common/log/log.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/clog/vacuous_log_handler.h"
@@ -132,6 +135,131 @@ TEST(BufferPool, create)
   ASSERT_EQ(buffer_pool->id(), buffer_pool2->id());
 }
 
+TEST(DiskBufferPool, flush_all_pages)
+{
+  filesystem::path test_directory("buffer_pool");
+  filesystem::path bp_file = test_directory / "flush.bp";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(bp_file.c_str()));
+
+  VacuousLogHandler log_handler;
+  DiskBufferPool   *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, bp_file.c_str(), buffer_pool));
+
+  const int       page_num = 40;
+  vector<Frame *> frames;
+  for (int i = 0; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    frames.push_back(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->flush_all_pages());
+
+  // 修改部分页面，脏页分成了多段连续的页面
+  for (int i = 0; i < page_num; i++) {
+    if (i % 7 == 3) {
+      continue;
+    }
+    Frame *frame = frames[i];
+    snprintf(frame->page().data, BP_PAGE_DATA_SIZE, "page %d", frame->page_num());
+    frame->mark_dirty();
+  }
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->flush_all_pages());
+  for (Frame *frame : frames) {
+    ASSERT_FALSE(frame->dirty());
+  }
+
+  // 直接从文件中读取页面，检查是否都写入了磁盘
+  int fd = ::open(bp_file.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+  for (int i = 0; i < page_num; i++) {
+    Frame *frame = frames[i];
+    Page   page;
+    ASSERT_EQ(0, preadn(fd, &page, sizeof(page), static_cast<off_t>(frame->page_num()) * BP_PAGE_SIZE));
+    if (i % 7 == 3) {
+      ASSERT_EQ(0, page.data[0]);
+    } else {
+      ASSERT_EQ(string("page ") + to_string(frame->page_num()), string(page.data));
+    }
+    ASSERT_EQ(frame->check_sum(), page.check_sum);
+  }
+  ::close(fd);
+
+  for (Frame *frame : frames) {
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(bp_file.c_str()));
+}
+
+TEST(DiskBufferPool, read_ahead)
+{
+  filesystem::path test_directory("buffer_pool");
+  filesystem::path bp_file = test_directory / "read_ahead.bp";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(bp_file.c_str()));
+  ASSERT_EQ(BufferPoolManager::DEFAULT_READ_AHEAD_PAGES, bpm.read_ahead_pages());
+
+  VacuousLogHandler log_handler;
+  DiskBufferPool   *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, bp_file.c_str(), buffer_pool));
+
+  const int page_num = 200;
+  for (int i = 0; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    snprintf(frame->page().data, BP_PAGE_DATA_SIZE, "page %d", frame->page_num());
+    frame->mark_dirty();
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(bp_file.c_str()));
+
+  BPFrameManager &frame_manager = bpm.get_frame_manager();
+  auto scan = [&](bool use_iterator) -> uint64_t {
+    EXPECT_EQ(RC::SUCCESS, bpm.open_file(log_handler, bp_file.c_str(), buffer_pool));
+
+    const uint64_t     miss_count = frame_manager.miss_count();
+    BufferPoolIterator iterator;
+    iterator.init(*buffer_pool, 1, use_iterator);
+    int scanned = 0;
+    for (PageNum page = 1; page <= page_num; page++) {
+      if (use_iterator) {
+        EXPECT_TRUE(iterator.has_next());
+        EXPECT_EQ(page, iterator.next());
+      }
+
+      Frame *frame = nullptr;
+      EXPECT_EQ(RC::SUCCESS, buffer_pool->get_this_page(page, &frame));
+      EXPECT_EQ(string("page ") + to_string(page), string(frame->page().data));
+      EXPECT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+      scanned++;
+    }
+    EXPECT_EQ(page_num, scanned);
+
+    const uint64_t misses = frame_manager.miss_count() - miss_count;
+    EXPECT_EQ(RC::SUCCESS, bpm.close_file(bp_file.c_str()));
+    return misses;
+  };
+
+  // 通过迭代器提示预读，所有页面在访问前都已经在内存中了
+  ASSERT_EQ(static_cast<uint64_t>(0), scan(true /*use_iterator*/));
+
+  // 没有提示时，检测到顺序读以后开始预读
+  ASSERT_LT(scan(false /*use_iterator*/), static_cast<uint64_t>(page_num / 4));
+
+  // 关闭预读
+  bpm.set_read_ahead_pages(0);
+  ASSERT_EQ(static_cast<uint64_t>(page_num), scan(true /*use_iterator*/));
+  ASSERT_EQ(static_cast<uint64_t>(page_num), scan(false /*use_iterator*/));
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
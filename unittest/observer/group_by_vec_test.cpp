@@ -0,0 +1,250 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "gtest/gtest.h"
+
+#include "common/lang/map.h"
+#include "common/lang/tuple.h"
+#include "common/log/log.h"
+#include "sql/expr/expression.h"
+#include "sql/operator/group_by_vec_physical_operator.h"
+#include "storage/field/field_meta.h"
+
+using namespace std;
+using namespace common;
+
+/**
+ * @brief 按顺序输出事先准备好的 Chunk
+ */
+class ChunkListPhysicalOperator : public PhysicalOperator
+{
+public:
+  explicit ChunkListPhysicalOperator(vector<unique_ptr<Chunk>> &&chunks) : chunks_(std::move(chunks)) {}
+
+  PhysicalOperatorType type() const override { return PhysicalOperatorType::TABLE_SCAN_VEC; }
+
+  RC open(Trx *) override
+  {
+    pos_ = 0;
+    return RC::SUCCESS;
+  }
+
+  RC next(Chunk &chunk) override
+  {
+    if (pos_ >= chunks_.size()) {
+      return RC::RECORD_EOF;
+    }
+    return chunk.reference(*chunks_[pos_++]);
+  }
+
+  RC close() override { return RC::SUCCESS; }
+
+private:
+  vector<unique_ptr<Chunk>> chunks_;
+  size_t                    pos_ = 0;
+};
+
+/**
+ * @brief 子算子输出 (id int, name char(4), score float, grp int)，其中 grp = id % GROUP_IDS，
+ * 按照 (grp, name) 分组计算 sum(id)、count(*)、avg(score)
+ */
+class GroupByVecTest : public testing::Test
+{
+public:
+  static constexpr int GROUP_IDS  = 10;
+  static constexpr int GROUP_NAME = 3;
+
+  void SetUp() override
+  {
+    id_meta_.init("id", AttrType::INTS, 0, 4, true, 0);
+    name_meta_.init("name", AttrType::CHARS, 4, 4, true, 1);
+    score_meta_.init("score", AttrType::FLOATS, 8, 4, true, 2);
+    grp_meta_.init("grp", AttrType::INTS, 12, 4, true, 3);
+  }
+
+  unique_ptr<Expression> field(const FieldMeta &meta) { return make_unique<FieldExpr>(nullptr, &meta); }
+
+  static string name_of(int id) { return "n" + to_string(id % GROUP_NAME); }
+
+  /**
+   * @brief 生成 rows 行数据，每个 Chunk 最多 chunk_rows 行
+   */
+  vector<unique_ptr<Chunk>> make_chunks(int rows, int chunk_rows)
+  {
+    vector<unique_ptr<Chunk>> chunks;
+    for (int start = 0; start < rows; start += chunk_rows) {
+      auto chunk = make_unique<Chunk>();
+      chunk->add_column(make_unique<Column>(id_meta_), 0);
+      chunk->add_column(make_unique<Column>(name_meta_), 1);
+      chunk->add_column(make_unique<Column>(score_meta_), 2);
+      chunk->add_column(make_unique<Column>(grp_meta_), 3);
+      for (int id = start; id < min(rows, start + chunk_rows); id++) {
+        float score = id * 0.5f;
+        int   grp   = id % GROUP_IDS;
+        chunk->column(0).append_one(reinterpret_cast<const char *>(&id));
+        chunk->column(1).append_value(Value(name_of(id).c_str()));
+        chunk->column(2).append_one(reinterpret_cast<const char *>(&score));
+        chunk->column(3).append_one(reinterpret_cast<const char *>(&grp));
+      }
+      chunks.push_back(std::move(chunk));
+    }
+    return chunks;
+  }
+
+  /**
+   * @brief 执行 group by，返回 (grp, name) -> (sum, count, avg)
+   */
+  map<pair<int, string>, tuple<int, int, float>> execute(int rows, int chunk_rows)
+  {
+    vector<unique_ptr<Expression>> group_by_exprs;
+    group_by_exprs.push_back(field(grp_meta_));
+    group_by_exprs.push_back(field(name_meta_));
+
+    aggregate_exprs_.clear();
+    aggregate_exprs_.push_back(make_unique<AggregateExpr>(AggregateExpr::Type::SUM, field(id_meta_)));
+    aggregate_exprs_.push_back(
+        make_unique<AggregateExpr>(AggregateExpr::Type::COUNT, make_unique<ValueExpr>(Value(1))));
+    aggregate_exprs_.push_back(make_unique<AggregateExpr>(AggregateExpr::Type::AVG, field(score_meta_)));
+    vector<Expression *> aggregate_exprs;
+    for (auto &expr : aggregate_exprs_) {
+      aggregate_exprs.push_back(expr.get());
+    }
+
+    GroupByVecPhysicalOperator oper(std::move(group_by_exprs), std::move(aggregate_exprs));
+    oper.add_child(make_unique<ChunkListPhysicalOperator>(make_chunks(rows, chunk_rows)));
+
+    map<pair<int, string>, tuple<int, int, float>> groups;
+    EXPECT_EQ(RC::SUCCESS, oper.open(nullptr));
+
+    RC    rc = RC::SUCCESS;
+    Chunk chunk;
+    while (OB_SUCC(rc = oper.next(chunk))) {
+      EXPECT_EQ(5, chunk.column_num());
+      for (int i = 0; i < chunk.rows(); i++) {
+        auto key = make_pair(chunk.get_value(0, i).get_int(), chunk.get_value(1, i).get_string());
+        EXPECT_EQ(0, groups.count(key));
+        groups[key] = make_tuple(
+            chunk.get_value(2, i).get_int(), chunk.get_value(3, i).get_int(), chunk.get_value(4, i).get_float());
+      }
+    }
+    EXPECT_EQ(RC::RECORD_EOF, rc);
+    EXPECT_EQ(RC::SUCCESS, oper.close());
+    return groups;
+  }
+
+  void check(int rows, int chunk_rows)
+  {
+    map<pair<int, string>, tuple<int, int, float>> expected;
+    map<pair<int, string>, float>                  score_sums;
+    for (int id = 0; id < rows; id++) {
+      auto key = make_pair(id % GROUP_IDS, name_of(id));
+      auto &[sum, count, avg] = expected[key];
+      sum += id;
+      count++;
+      score_sums[key] += id * 0.5f;
+    }
+    for (auto &[key, value] : expected) {
+      get<2>(value) = score_sums[key] / get<1>(value);
+    }
+
+    map<pair<int, string>, tuple<int, int, float>> groups = execute(rows, chunk_rows);
+    ASSERT_EQ(expected.size(), groups.size());
+    for (auto &[key, value] : expected) {
+      auto iter = groups.find(key);
+      ASSERT_NE(groups.end(), iter) << key.first << "," << key.second;
+      ASSERT_EQ(get<0>(value), get<0>(iter->second));
+      ASSERT_EQ(get<1>(value), get<1>(iter->second));
+      ASSERT_FLOAT_EQ(get<2>(value), get<2>(iter->second));
+    }
+  }
+
+protected:
+  FieldMeta                      id_meta_;
+  FieldMeta                      name_meta_;
+  FieldMeta                      score_meta_;
+  FieldMeta                      grp_meta_;
+  vector<unique_ptr<Expression>> aggregate_exprs_;
+};
+
+TEST_F(GroupByVecTest, single_chunk) { check(100, 1000); }
+
+TEST_F(GroupByVecTest, multiple_chunks) { check(10000, 1024); }
+
+TEST_F(GroupByVecTest, empty) { ASSERT_TRUE(execute(0, 1024).empty()); }
+
+TEST_F(GroupByVecTest, float_group_key)
+{
+  // 浮点数分组列不能使用 RowAggregateHashTable，使用 StandardAggregateHashTable
+  vector<unique_ptr<Expression>> group_by_exprs;
+  group_by_exprs.push_back(field(score_meta_));
+  AggregateExpr count_expr(AggregateExpr::Type::COUNT, make_unique<ValueExpr>(Value(1)));
+
+  GroupByVecPhysicalOperator oper(std::move(group_by_exprs), {&count_expr});
+  oper.add_child(make_unique<ChunkListPhysicalOperator>(make_chunks(3000, 1024)));
+  ASSERT_EQ(RC::SUCCESS, oper.open(nullptr));
+
+  int   groups = 0;
+  Chunk chunk;
+  while (oper.next(chunk) == RC::SUCCESS) {
+    for (int i = 0; i < chunk.rows(); i++) {
+      ASSERT_EQ(1, chunk.get_value(1, i).get_int());
+    }
+    groups += chunk.rows();
+  }
+  ASSERT_EQ(3000, groups);
+  ASSERT_EQ(RC::SUCCESS, oper.close());
+}
+
+TEST_F(GroupByVecTest, selection)
+{
+  // 子算子输出的 Chunk 带有选择向量，只有 id 是偶数的行参与分组和聚合
+  vector<unique_ptr<Chunk>> chunks = make_chunks(3000, 1024);
+  int                       start  = 0;
+  for (unique_ptr<Chunk> &chunk : chunks) {
+    vector<int> selection;
+    for (int i = start % 2; i < chunk->rows(); i += 2) {
+      selection.push_back(i);
+    }
+    chunk->set_selection(selection.data(), static_cast<int>(selection.size()));
+    start += chunk->rows();
+  }
+
+  vector<unique_ptr<Expression>> group_by_exprs;
+  group_by_exprs.push_back(field(grp_meta_));
+  AggregateExpr sum_expr(AggregateExpr::Type::SUM, field(id_meta_));
+  AggregateExpr count_expr(AggregateExpr::Type::COUNT, make_unique<ValueExpr>(Value(1)));
+
+  GroupByVecPhysicalOperator oper(std::move(group_by_exprs), {&sum_expr, &count_expr});
+  oper.add_child(make_unique<ChunkListPhysicalOperator>(std::move(chunks)));
+  ASSERT_EQ(RC::SUCCESS, oper.open(nullptr));
+
+  map<int, pair<int, int>> expected;
+  for (int id = 0; id < 3000; id += 2) {
+    expected[id % GROUP_IDS].first += id;
+    expected[id % GROUP_IDS].second++;
+  }
+
+  map<int, pair<int, int>> groups;
+  Chunk                    chunk;
+  while (oper.next(chunk) == RC::SUCCESS) {
+    for (int i = 0; i < chunk.rows(); i++) {
+      groups[chunk.get_value(0, i).get_int()] = {chunk.get_value(1, i).get_int(), chunk.get_value(2, i).get_int()};
+    }
+  }
+  ASSERT_EQ(expected, groups);
+  ASSERT_EQ(RC::SUCCESS, oper.close());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("group_by_vec_test.log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
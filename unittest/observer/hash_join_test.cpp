@@ -0,0 +1,458 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+
+#include "gtest/gtest.h"
+#include "common/lang/memory.h"
+#include "common/lang/random.h"
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+#include "common/log/log.h"
+#include "session/session.h"
+#include "sql/expr/expression.h"
+#include "sql/expr/join_hash_table.h"
+#include "sql/operator/hash_join_physical_operator.h"
+#include "sql/operator/join_logical_operator.h"
+#include "sql/operator/predicate_logical_operator.h"
+#include "sql/operator/project_logical_operator.h"
+#include "sql/operator/table_get_logical_operator.h"
+#include "sql/optimizer/physical_plan_generator.h"
+#include "sql/optimizer/rewriter.h"
+#include "storage/db/db.h"
+#include "storage/record/record_scanner.h"
+#include "storage/table/table.h"
+#include "storage/trx/trx.h"
+
+using namespace std;
+using namespace common;
+
+TEST(JoinHashTable, find)
+{
+  const int        row_num = 100000;
+  mt19937_64       random(0);
+  vector<uint64_t> hashes;
+  for (int i = 0; i < row_num; i++) {
+    // 有一半的行哈希值重复
+    hashes.push_back(i % 2 == 0 ? random() : hashes.back());
+  }
+
+  for (size_t threshold : {numeric_limits<size_t>::max(), static_cast<size_t>(64 * 1024)}) {
+    JoinHashTable hash_table;
+    for (uint64_t hash : hashes) {
+      hash_table.add(hash);
+    }
+    hash_table.build(threshold);
+    if (threshold == numeric_limits<size_t>::max()) {
+      ASSERT_EQ(1, hash_table.partition_num());
+    } else {
+      ASSERT_GT(hash_table.partition_num(), 1);
+    }
+
+    // 每一行都能在自己的链表中找到
+    vector<uint32_t> heads(row_num);
+    hash_table.find_batch(hashes.data(), row_num, heads.data());
+    for (int i = 0; i < row_num; i++) {
+      ASSERT_EQ(hash_table.find(hashes[i]), heads[i]);
+
+      bool found = false;
+      for (uint32_t row = heads[i]; row != JoinHashTable::INVALID_ROW && !found; row = hash_table.next(row)) {
+        found = (row == static_cast<uint32_t>(i));
+      }
+      ASSERT_TRUE(found);
+    }
+
+    ASSERT_EQ(JoinHashTable::INVALID_ROW, hash_table.find(random()));
+  }
+}
+
+/**
+ * @brief 按行扫描表，每次返回 CHUNK_ROWS 行组成的 Chunk
+ * @details PAX 格式的表还不能按 Chunk 读取，测试向量化的 hash join 时用它替换 TableScanVecPhysicalOperator，
+ * 返回的列与 TableScanVecPhysicalOperator 相同
+ */
+class RowChunkScanPhysicalOperator : public PhysicalOperator
+{
+public:
+  static constexpr int CHUNK_ROWS = 100;
+
+  RowChunkScanPhysicalOperator(Table *table) : table_(table) {}
+  ~RowChunkScanPhysicalOperator() override { close(); }
+
+  PhysicalOperatorType type() const override { return PhysicalOperatorType::TABLE_SCAN_VEC; }
+
+  string param() const override { return table_->name(); }
+
+  RC open(Trx *trx) override
+  {
+    for (int i = 0; i < table_->table_meta().field_num(); i++) {
+      const FieldMeta *field_meta = table_->table_meta().field(i);
+      chunk_.add_column(make_unique<Column>(*field_meta, CHUNK_ROWS), field_meta->field_id());
+    }
+    return table_->get_record_scanner(scanner_, trx, ReadWriteMode::READ_ONLY);
+  }
+
+  RC next(Chunk &chunk) override
+  {
+    chunk_.reset_data();
+    RC     rc = RC::SUCCESS;
+    Record record;
+    while (chunk_.rows() < CHUNK_ROWS && OB_SUCC(rc = scanner_->next(record))) {
+      for (int i = 0; i < chunk_.column_num(); i++) {
+        chunk_.column(i).append_one(record.data() + table_->table_meta().field(i)->offset());
+      }
+    }
+    if (OB_FAIL(rc) && rc != RC::RECORD_EOF) {
+      return rc;
+    }
+    if (chunk_.rows() == 0) {
+      return RC::RECORD_EOF;
+    }
+    return chunk.reference(chunk_);
+  }
+
+  RC close() override
+  {
+    if (scanner_ != nullptr) {
+      scanner_->close_scan();
+      delete scanner_;
+      scanner_ = nullptr;
+    }
+    chunk_.reset();
+    return RC::SUCCESS;
+  }
+
+private:
+  Table         *table_   = nullptr;
+  RecordScanner *scanner_ = nullptr;
+  Chunk          chunk_;
+};
+
+/**
+ * @brief 使用真实的表测试连接的逻辑计划改写、物理计划生成和执行
+ * @details t1(id, name) 有 T1_ROWS 行，id 不重复。t2(id, num, name) 中 id 在 [0, T2_DISTINCT_IDS) 的每个 id 有 4 行，
+ * 其中一行的 name 与 t1 不同，另外还有一些 id 在 t1 中不存在的行。
+ */
+class HashJoinTest : public testing::Test
+{
+public:
+  static constexpr int T1_ROWS         = 600;
+  static constexpr int T2_DISTINCT_IDS = 200;
+
+  void SetUp() override
+  {
+    const char *test_name = testing::UnitTest::GetInstance()->current_test_info()->name();
+    test_directory_       = filesystem::path("hash_join_test") / test_name;
+    filesystem::remove_all(test_directory_);
+    filesystem::create_directories(test_directory_);
+
+    db_ = make_unique<Db>();
+    // 向量化执行按 field_id 从 Chunk 中取列，不支持带有事务字段的表
+    ASSERT_EQ(RC::SUCCESS, db_->init("db", test_directory_.c_str(), "vacuous", "disk"));
+
+    t1_ = create_table("t1", {"id", "name"});
+    t2_ = create_table("t2", {"id", "num", "name"});
+    t3_ = create_table("t3", {"id", "name"});
+
+    for (int i = 0; i < T1_ROWS; i++) {
+      insert_record(t1_, {Value(i), Value(name_of(i).c_str())});
+    }
+    for (int i = 0; i < T2_DISTINCT_IDS * 4; i++) {
+      const int id = i % T2_DISTINCT_IDS;
+      insert_record(t2_, {Value(id), Value(i), Value(i / T2_DISTINCT_IDS == 3 ? "x" : name_of(id).c_str())});
+    }
+    for (int i = 0; i < 200; i++) {
+      insert_record(t2_, {Value(T1_ROWS + i), Value(i), Value(name_of(i).c_str())});
+    }
+
+    session_.set_hash_join(true);
+  }
+
+  void TearDown() override
+  {
+    db_.reset();
+    filesystem::remove_all(test_directory_);
+  }
+
+  static string name_of(int id) { return "n" + to_string(id % 100); }
+
+  Table *create_table(const char *name, const vector<const char *> &fields)
+  {
+    vector<AttrInfoSqlNode> attr_infos(fields.size());
+    for (size_t i = 0; i < fields.size(); i++) {
+      attr_infos[i].name   = fields[i];
+      attr_infos[i].type   = strcmp(fields[i], "name") == 0 ? AttrType::CHARS : AttrType::INTS;
+      attr_infos[i].length = strcmp(fields[i], "name") == 0 ? 8 : 4;
+    }
+    EXPECT_EQ(RC::SUCCESS, db_->create_table(name, attr_infos, {}));
+    return db_->find_table(name);
+  }
+
+  void insert_record(Table *table, vector<Value> values)
+  {
+    Trx *trx = db_->trx_kit().create_trx(db_->log_handler());
+    trx->start_if_need();
+    Record record;
+    ASSERT_EQ(RC::SUCCESS, table->make_record(values.size(), values.data(), record));
+    ASSERT_EQ(RC::SUCCESS, trx->insert_record(table, record));
+    ASSERT_EQ(RC::SUCCESS, trx->commit());
+    db_->trx_kit().destroy_trx(trx);
+  }
+
+  static unique_ptr<Expression> field(Table *table, const char *name)
+  {
+    return make_unique<FieldExpr>(table, table->table_meta().field(name));
+  }
+
+  /**
+   * @brief select left.id, left.name, right.id, right.name from left join right on <comparisons>
+   * @details 比较的两边按照右表、左表的顺序给出，改写时需要交换
+   */
+  unique_ptr<LogicalOperator> make_plan(Table *left, Table *right, const vector<const char *> &key_fields)
+  {
+    auto join_oper = make_unique<JoinLogicalOperator>();
+    join_oper->add_child(make_unique<TableGetLogicalOperator>(left, ReadWriteMode::READ_ONLY));
+    join_oper->add_child(make_unique<TableGetLogicalOperator>(right, ReadWriteMode::READ_ONLY));
+
+    vector<unique_ptr<Expression>> comparisons;
+    for (const char *key_field : key_fields) {
+      comparisons.push_back(
+          make_unique<ComparisonExpr>(CompOp::EQUAL_TO, field(right, key_field), field(left, key_field)));
+    }
+    auto predicate_oper = make_unique<PredicateLogicalOperator>(
+        make_unique<ConjunctionExpr>(ConjunctionExpr::Type::AND, comparisons));
+    predicate_oper->add_child(std::move(join_oper));
+
+    vector<unique_ptr<Expression>> projections;
+    projections.push_back(field(left, "id"));
+    projections.push_back(field(left, "name"));
+    projections.push_back(field(right, "id"));
+    projections.push_back(field(right, "name"));
+    unique_ptr<LogicalOperator> project_oper = make_unique<ProjectLogicalOperator>(std::move(projections));
+    project_oper->add_child(std::move(predicate_oper));
+
+    Rewriter rewriter;
+    bool     change_made = false;
+    do {
+      EXPECT_EQ(RC::SUCCESS, rewriter.rewrite(project_oper, change_made));
+    } while (change_made);
+    return project_oper;
+  }
+
+  static PhysicalOperator *find_operator(PhysicalOperator *oper, PhysicalOperatorType type)
+  {
+    if (oper->type() == type) {
+      return oper;
+    }
+    for (auto &child : oper->children()) {
+      PhysicalOperator *found = find_operator(child.get(), type);
+      if (found != nullptr) {
+        return found;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief 执行连接，检查每一行连接键都相等，返回结果的行数
+   * @param partition_threshold 不为0时设置 hash join 的分区阈值，并检查构建侧是否分区了
+   */
+  int execute(unique_ptr<LogicalOperator> logical_oper, bool vectorized, size_t partition_threshold = 0)
+  {
+    PhysicalPlanGenerator        generator;
+    unique_ptr<PhysicalOperator> oper;
+    RC rc = vectorized ? generator.create_vec(*logical_oper, oper, &session_)
+                       : generator.create(*logical_oper, oper, &session_);
+    EXPECT_EQ(RC::SUCCESS, rc);
+    if (OB_FAIL(rc)) {
+      return -1;
+    }
+
+    auto *hash_join_oper =
+        static_cast<HashJoinPhysicalOperator *>(find_operator(oper.get(), PhysicalOperatorType::HASH_JOIN));
+    if (partition_threshold != 0) {
+      EXPECT_NE(nullptr, hash_join_oper);
+      hash_join_oper->set_partition_threshold(partition_threshold);
+    }
+    if (vectorized) {
+      EXPECT_NE(nullptr, hash_join_oper);
+      for (unique_ptr<PhysicalOperator> &child : hash_join_oper->children()) {
+        EXPECT_EQ(PhysicalOperatorType::TABLE_SCAN_VEC, child->type());
+        child = make_unique<RowChunkScanPhysicalOperator>(db_->find_table(child->param().c_str()));
+      }
+    }
+
+    Trx *trx = db_->trx_kit().create_trx(db_->log_handler());
+    trx->start_if_need();
+    EXPECT_EQ(RC::SUCCESS, oper->open(trx));
+
+    int rows = 0;
+    if (vectorized) {
+      Chunk chunk;
+      while (OB_SUCC(rc = oper->next(chunk))) {
+        for (int i = 0; i < chunk.rows(); i++) {
+          EXPECT_EQ(0, chunk.get_value(0, i).compare(chunk.get_value(2, i)));
+        }
+        rows += chunk.rows();
+        chunk.reset();
+      }
+    } else {
+      while (OB_SUCC(rc = oper->next())) {
+        Tuple *tuple = oper->current_tuple();
+        Value  left_id;
+        Value  right_id;
+        EXPECT_EQ(RC::SUCCESS, tuple->cell_at(0, left_id));
+        EXPECT_EQ(RC::SUCCESS, tuple->cell_at(2, right_id));
+        EXPECT_EQ(0, left_id.compare(right_id));
+        rows++;
+      }
+    }
+    EXPECT_EQ(RC::RECORD_EOF, rc);
+
+    if (partition_threshold != 0) {
+      EXPECT_GT(hash_join_oper->partition_num(), 1);
+    }
+
+    EXPECT_EQ(RC::SUCCESS, oper->close());
+    trx->commit();
+    db_->trx_kit().destroy_trx(trx);
+
+    if (hash_join_oper != nullptr) {
+      spill_bytes_         = hash_join_oper->spill_bytes();
+      spill_partition_num_ = hash_join_oper->spill_partition_num();
+      spill_param_         = hash_join_oper->param();
+    }
+    return rows;
+  }
+
+  /**
+   * @brief 溢出到磁盘的临时文件个数，close 之后应该都被删除了
+   */
+  int spill_file_num() const
+  {
+    int num = 0;
+    for (const auto &entry : filesystem::recursive_directory_iterator(test_directory_)) {
+      if (entry.path().extension() == ".spill") {
+        num++;
+      }
+    }
+    return num;
+  }
+
+protected:
+  filesystem::path test_directory_;
+  unique_ptr<Db>   db_;
+  Session          session_;
+  Table           *t1_ = nullptr;
+  Table           *t2_ = nullptr;
+  Table           *t3_ = nullptr;
+
+  int64_t spill_bytes_         = 0;
+  int     spill_partition_num_ = 0;
+  string  spill_param_;
+};
+
+TEST_F(HashJoinTest, rewrite)
+{
+  unique_ptr<LogicalOperator> plan = make_plan(t1_, t2_, {"id", "name"});
+
+  // 连接条件都移动到了连接算子中，谓词算子被删除
+  ASSERT_EQ(1, plan->children().size());
+  ASSERT_EQ(LogicalOperatorType::JOIN, plan->children()[0]->type());
+
+  auto &join_oper = static_cast<JoinLogicalOperator &>(*plan->children()[0]);
+  ASSERT_EQ(2, join_oper.get_join_predicates().size());
+  for (auto &predicate : join_oper.get_join_predicates()) {
+    auto &comparison_expr = static_cast<ComparisonExpr &>(*predicate);
+    ASSERT_STREQ("t1", static_cast<FieldExpr &>(*comparison_expr.left()).table_name());
+    ASSERT_STREQ("t2", static_cast<FieldExpr &>(*comparison_expr.right()).table_name());
+  }
+
+  PhysicalPlanGenerator        generator;
+  unique_ptr<PhysicalOperator> oper;
+  ASSERT_EQ(RC::SUCCESS, generator.create(*plan, oper, &session_));
+  auto *hash_join_oper = find_operator(oper.get(), PhysicalOperatorType::HASH_JOIN);
+  ASSERT_NE(nullptr, hash_join_oper);
+  ASSERT_EQ("t1.id=t2.id AND t1.name=t2.name", hash_join_oper->param());
+}
+
+TEST_F(HashJoinTest, nested_loop_join)
+{
+  session_.set_hash_join(false);
+  ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t1_, t2_, {"id"}), false));
+  ASSERT_EQ(T2_DISTINCT_IDS * 3, execute(make_plan(t1_, t2_, {"id", "name"}), false));
+}
+
+TEST_F(HashJoinTest, tuple_mode)
+{
+  ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t1_, t2_, {"id"}), false));
+  ASSERT_EQ(T2_DISTINCT_IDS * 3, execute(make_plan(t1_, t2_, {"id", "name"}), false));
+  ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t2_, t1_, {"id"}), false));
+  ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t1_, t2_, {"id"}), false, 4096));
+
+  // 构建侧或探测侧没有数据
+  ASSERT_EQ(0, execute(make_plan(t1_, t3_, {"id"}), false));
+  ASSERT_EQ(0, execute(make_plan(t3_, t1_, {"id"}), false));
+}
+
+TEST_F(HashJoinTest, chunk_mode)
+{
+  ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t1_, t2_, {"id"}), true));
+  ASSERT_EQ(T2_DISTINCT_IDS * 3, execute(make_plan(t1_, t2_, {"id", "name"}), true));
+  ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t2_, t1_, {"id"}), true));
+  ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t1_, t2_, {"id"}), true, 4096));
+
+  ASSERT_EQ(0, execute(make_plan(t1_, t3_, {"id"}), true));
+  ASSERT_EQ(0, execute(make_plan(t3_, t1_, {"id"}), true));
+}
+
+TEST_F(HashJoinTest, spill)
+{
+  for (bool vectorized : {false, true}) {
+    // 不限制内存时不会溢出
+    session_.set_join_memory_limit(0);
+    ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t1_, t2_, {"id"}), vectorized));
+    ASSERT_EQ(0, spill_bytes_);
+    ASSERT_EQ(0, spill_partition_num_);
+    ASSERT_NE(string::npos, spill_param_.find("spill_partitions=0, spill_bytes=0"));
+
+    // 构建侧放不下，溢出一次就够了。按行执行时每行占用的内存更多
+    session_.set_join_memory_limit(vectorized ? 8 * 1024 : 64 * 1024);
+    ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t1_, t2_, {"id"}), vectorized));
+    ASSERT_GT(spill_bytes_, 0);
+    ASSERT_EQ(HashJoinPhysicalOperator::SPILL_FANOUT, spill_partition_num_);
+    ASSERT_NE(string::npos, spill_param_.find("spill_bytes="));
+    ASSERT_EQ(0, spill_file_num());
+
+    ASSERT_EQ(T2_DISTINCT_IDS * 3, execute(make_plan(t1_, t2_, {"id", "name"}), vectorized));
+    ASSERT_GT(spill_bytes_, 0);
+    ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t2_, t1_, {"id"}), vectorized));
+    ASSERT_GT(spill_bytes_, 0);
+    ASSERT_EQ(0, execute(make_plan(t1_, t3_, {"id"}), vectorized));
+    ASSERT_EQ(0, execute(make_plan(t3_, t1_, {"id"}), vectorized));
+
+    // 分区之后还是放不下，需要递归分区
+    session_.set_join_memory_limit(1024);
+    ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t1_, t2_, {"id"}), vectorized));
+    ASSERT_GT(spill_partition_num_, HashJoinPhysicalOperator::SPILL_FANOUT);
+
+    // 相同的连接键无法再分区，达到最大递归层数之后直接加载到内存中
+    ASSERT_EQ(T2_DISTINCT_IDS * 4, execute(make_plan(t2_, t1_, {"id"}), vectorized));
+    ASSERT_EQ(0, spill_file_num());
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  filesystem::path log_filename = filesystem::path(argv[0]).filename();
+  LoggerFactory::init_default(log_filename.string() + ".log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,334 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "common/lang/algorithm.h"
+#include "common/lang/atomic.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/memory.h"
+#include "common/lang/random.h"
+#include "common/lang/thread.h"
+#include "common/lang/vector.h"
+#include "common/math/vector_distance.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/vacuous_log_handler.h"
+#include "storage/index/hnsw_index.h"
+#include "storage/index/ivfflat_index.h"
+#include "gtest/gtest.h"
+
+using namespace common;
+
+namespace {
+
+constexpr int DIMENSION = 16;
+
+vector<float> random_vectors(int num, unsigned seed)
+{
+  mt19937                       random(seed);
+  normal_distribution<float>    distribution(0.0f, 1.0f);
+  uniform_int_distribution<int> cluster_distribution(0, 15);
+  vector<float>                 centers(16 * DIMENSION);
+  for (float &value : centers) {
+    value = distribution(random) * 3;
+  }
+
+  vector<float> vectors(static_cast<size_t>(num) * DIMENSION);
+  for (int i = 0; i < num; i++) {
+    const float *center = centers.data() + cluster_distribution(random) * DIMENSION;
+    for (int d = 0; d < DIMENSION; d++) {
+      vectors[static_cast<size_t>(i) * DIMENSION + d] = center[d] + distribution(random);
+    }
+  }
+  return vectors;
+}
+
+vector<RID> brute_force(VectorDistanceType type, const vector<float> &vectors, const float *query, size_t limit,
+    const vector<bool> &deleted = {})
+{
+  vector<pair<float, int>> distances;
+  for (int i = 0; i < static_cast<int>(vectors.size() / DIMENSION); i++) {
+    if (i < static_cast<int>(deleted.size()) && deleted[i]) {
+      continue;
+    }
+    distances.emplace_back(vector_distance(type, query, vectors.data() + i * DIMENSION, DIMENSION), i);
+  }
+  limit = std::min(limit, distances.size());
+  std::partial_sort(distances.begin(), distances.begin() + limit, distances.end());
+
+  vector<RID> rids;
+  for (size_t i = 0; i < limit; i++) {
+    rids.emplace_back(distances[i].second / 100, distances[i].second % 100);
+  }
+  return rids;
+}
+
+/// 结果中有多少个是真正最近的
+int hit_count(const vector<RID> &expected, const vector<RID> &rids)
+{
+  int hits = 0;
+  for (const RID &rid : rids) {
+    hits += std::count(expected.begin(), expected.end(), rid);
+  }
+  return hits;
+}
+
+}  // namespace
+
+class HnswIndexTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    filesystem::remove_all(test_directory_);
+    filesystem::create_directory(test_directory_);
+
+    field_meta_ = FieldMeta("embedding", AttrType::VECTORS, 0, DIMENSION * sizeof(float), true, 0);
+    ASSERT_EQ(RC::SUCCESS, index_meta_.init("hnsw", field_meta_));
+  }
+
+  void TearDown() override
+  {
+    index_.reset();
+    filesystem::remove_all(test_directory_);
+  }
+
+  void create_index(VectorDistanceType type, int m, int ef_construction, int ef_search)
+  {
+    index_ = make_unique<HnswIndex>();
+    index_->set_options(type, m, ef_construction, ef_search);
+    ASSERT_EQ(RC::SUCCESS, index_->create(file_name().c_str(), index_meta_, {field_meta_}));
+  }
+
+  /// 第 i 个向量的 RID 是 (i / 100, i % 100)
+  void load(const vector<float> &vectors)
+  {
+    for (int i = 0; i < static_cast<int>(vectors.size() / DIMENSION); i++) {
+      RID rid(i / 100, i % 100);
+      ASSERT_EQ(RC::SUCCESS, index_->insert_entry(record_of(vectors, i), &rid));
+    }
+  }
+
+  const char *record_of(const vector<float> &vectors, int i) const
+  {
+    return reinterpret_cast<const char *>(vectors.data() + i * DIMENSION);
+  }
+
+  string file_name() const { return (test_directory_ / "hnsw.index").string(); }
+
+protected:
+  filesystem::path      test_directory_ = "hnsw_index_test";
+  FieldMeta             field_meta_;
+  IndexMeta             index_meta_;
+  unique_ptr<HnswIndex> index_;
+};
+
+TEST_F(HnswIndexTest, recall)
+{
+  const vector<float> vectors = random_vectors(5000, 1);
+  const vector<float> queries = random_vectors(50, 2);
+  for (VectorDistanceType type :
+      {VectorDistanceType::L2, VectorDistanceType::COSINE, VectorDistanceType::INNER_PRODUCT}) {
+    create_index(type, 12, 100, 10);
+    load(vectors);
+    EXPECT_EQ(5000, index_->node_num());
+    EXPECT_GT(index_->max_level(), 0);
+
+    int low_hits  = 0;
+    int high_hits = 0;
+    for (int q = 0; q < 50; q++) {
+      const float *query    = queries.data() + q * DIMENSION;
+      vector<RID>  expected = brute_force(type, vectors, query, 10);
+
+      vector<RID>   rids;
+      vector<float> distances;
+      ASSERT_EQ(RC::SUCCESS, index_->ann_search(query, 10, rids, &distances));
+      ASSERT_EQ(10, static_cast<int>(rids.size()));
+      EXPECT_TRUE(std::is_sorted(distances.begin(), distances.end()));
+      low_hits += hit_count(expected, rids);
+
+      // 内积不是距离，需要更大的候选集
+      const int ef_search = type == VectorDistanceType::INNER_PRODUCT ? 5000 : 200;
+      ASSERT_EQ(RC::SUCCESS, index_->ann_search(query, 10, ef_search, rids));
+      high_hits += hit_count(expected, rids);
+    }
+
+    EXPECT_GE(high_hits, low_hits) << vector_distance_type_name(type);
+    EXPECT_GE(high_hits, 450) << vector_distance_type_name(type);
+
+    index_.reset();
+    filesystem::remove(file_name());
+  }
+}
+
+TEST_F(HnswIndexTest, delete_entry)
+{
+  const vector<float> vectors = random_vectors(2000, 3);
+  create_index(VectorDistanceType::L2, 8, 64, 64);
+  load(vectors);
+
+  vector<bool> deleted(2000, false);
+  for (int i = 0; i < 2000; i += 3) {
+    RID rid(i / 100, i % 100);
+    ASSERT_EQ(RC::SUCCESS, index_->delete_entry(record_of(vectors, i), &rid));
+    deleted[i] = true;
+  }
+  RID rid(0, 0);
+  EXPECT_EQ(RC::RECORD_NOT_EXIST, index_->delete_entry(record_of(vectors, 0), &rid));
+
+  int hits = 0;
+  for (int i = 0; i < 2000; i += 10) {
+    vector<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, index_->ann_search(vectors.data() + i * DIMENSION, 10, rids));
+    ASSERT_EQ(10, static_cast<int>(rids.size()));
+    for (const RID &result : rids) {
+      EXPECT_FALSE(deleted[result.page_num * 100 + result.slot_num]);
+    }
+    vector<RID> expected = brute_force(VectorDistanceType::L2, vectors, vectors.data() + i * DIMENSION, 10, deleted);
+    hits += hit_count(expected, rids);
+  }
+  EXPECT_GE(hits, 1900);
+
+  // 删除之后可以用同一个 RID 重新插入
+  ASSERT_EQ(RC::SUCCESS, index_->insert_entry(record_of(vectors, 0), &rid));
+  EXPECT_EQ(RC::RECORD_DUPLICATE_KEY, index_->insert_entry(record_of(vectors, 0), &rid));
+  vector<RID> rids;
+  ASSERT_EQ(RC::SUCCESS, index_->ann_search(vectors.data(), 1, rids));
+  EXPECT_EQ(vector<RID>{rid}, rids);
+}
+
+TEST_F(HnswIndexTest, reopen)
+{
+  const vector<float> vectors = random_vectors(1000, 4);
+  create_index(VectorDistanceType::COSINE, 10, 80, 40);
+  load(vectors);
+  RID deleted_rid(0, 7);
+  ASSERT_EQ(RC::SUCCESS, index_->delete_entry(record_of(vectors, 7), &deleted_rid));
+
+  const vector<float> queries = random_vectors(20, 5);
+  vector<vector<RID>> before(20);
+  for (int q = 0; q < 20; q++) {
+    ASSERT_EQ(RC::SUCCESS, index_->ann_search(queries.data() + q * DIMENSION, 10, before[q]));
+  }
+  ASSERT_EQ(RC::SUCCESS, index_->close());
+
+  index_ = make_unique<HnswIndex>();
+  ASSERT_EQ(RC::SUCCESS, index_->open(file_name().c_str(), index_meta_, {field_meta_}));
+  EXPECT_EQ(VectorDistanceType::COSINE, index_->distance_type());
+  EXPECT_EQ(10, index_->m());
+  EXPECT_EQ(80, index_->ef_construction());
+  EXPECT_EQ(40, index_->ef_search());
+  EXPECT_EQ(1000, index_->node_num());
+
+  for (int q = 0; q < 20; q++) {
+    vector<RID> after;
+    ASSERT_EQ(RC::SUCCESS, index_->ann_search(queries.data() + q * DIMENSION, 10, after));
+    EXPECT_EQ(before[q], after);
+  }
+  EXPECT_EQ(RC::RECORD_NOT_EXIST, index_->delete_entry(record_of(vectors, 7), &deleted_rid));
+
+  // 不能在已经存在的文件上创建索引
+  HnswIndex other;
+  EXPECT_EQ(RC::FILE_EXIST, other.create(file_name().c_str(), index_meta_, {field_meta_}));
+}
+
+#ifdef CONCURRENCY
+TEST_F(HnswIndexTest, concurrent_search)
+{
+  const vector<float> vectors = random_vectors(3000, 6);
+  create_index(VectorDistanceType::L2, 12, 100, 64);
+  load(vectors);
+
+  const vector<float> queries = random_vectors(100, 7);
+  vector<vector<RID>> expected(100);
+  for (int q = 0; q < 100; q++) {
+    ASSERT_EQ(RC::SUCCESS, index_->ann_search(queries.data() + q * DIMENSION, 10, expected[q]));
+  }
+
+  // 查询之间可以并发，同时还有其它线程在插入新的向量
+  const vector<float> more_vectors = random_vectors(1000, 8);
+  atomic<int>         mismatches(0);
+  vector<thread>      threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      for (int round = 0; round < 5; round++) {
+        for (int q = t; q < 100; q += 4) {
+          vector<RID> rids;
+          if (OB_FAIL(index_->ann_search(queries.data() + q * DIMENSION, 10, rids)) || rids.size() != 10) {
+            mismatches++;
+          }
+        }
+      }
+    });
+  }
+  threads.emplace_back([&]() {
+    for (int i = 0; i < 1000; i++) {
+      RID rid(1000 + i / 100, i % 100);
+      if (OB_FAIL(index_->insert_entry(record_of(more_vectors, i), &rid))) {
+        mismatches++;
+      }
+    }
+  });
+  for (thread &t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(0, mismatches.load());
+  EXPECT_EQ(4000, index_->node_num());
+}
+#endif  // CONCURRENCY
+
+TEST_F(HnswIndexTest, vector_index_interface)
+{
+  // 优化器只通过 Index 的接口访问向量索引，两种向量索引的结果应该都接近精确结果
+  const vector<float> vectors = random_vectors(2000, 9);
+  const vector<float> queries = random_vectors(20, 10);
+
+  create_index(VectorDistanceType::L2, 12, 100, 64);
+  load(vectors);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  VacuousLogHandler log_handler;
+  IvfflatIndex      ivfflat_index;
+  ivfflat_index.set_options(VectorDistanceType::L2, 16, 16);
+  string ivfflat_file = (test_directory_ / "ivfflat.index").string();
+  ASSERT_EQ(RC::SUCCESS, ivfflat_index.create(log_handler, bpm, ivfflat_file.c_str(), index_meta_, {field_meta_}));
+  ASSERT_EQ(RC::SUCCESS, ivfflat_index.train(vectors.data(), 2000));
+  for (int i = 0; i < 2000; i++) {
+    RID rid(i / 100, i % 100);
+    ASSERT_EQ(RC::SUCCESS, ivfflat_index.insert_entry(record_of(vectors, i), &rid));
+  }
+
+  for (Index *index : {static_cast<Index *>(index_.get()), static_cast<Index *>(&ivfflat_index)}) {
+    ASSERT_TRUE(index->is_vector_index());
+    int hits = 0;
+    for (int q = 0; q < 20; q++) {
+      const float *query = queries.data() + q * DIMENSION;
+      vector<RID>  rids;
+      ASSERT_EQ(RC::SUCCESS, index->ann_search(query, 10, rids));
+      hits += hit_count(brute_force(VectorDistanceType::L2, vectors, query, 10), rids);
+    }
+    EXPECT_GE(hits, 190);
+  }
+  ivfflat_index.close();
+}
+
+TEST_F(HnswIndexTest, invalid_field)
+{
+  FieldMeta int_field("id", AttrType::INTS, 0, sizeof(int), true, 0);
+  HnswIndex index;
+  EXPECT_EQ(RC::SCHEMA_FIELD_TYPE_MISMATCH, index.create(file_name().c_str(), index_meta_, {int_field}));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("hnsw_index_test.log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
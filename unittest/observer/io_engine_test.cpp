@@ -0,0 +1,338 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+#include "common/io/io.h"
+#include "common/lang/atomic.h"
+#include "common/lang/chrono.h"
+#include "common/lang/thread.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/buffer/io_engine.h"
+#include "storage/buffer/uring_io_engine.h"
+#include "storage/clog/vacuous_log_handler.h"
+
+using namespace std;
+using namespace common;
+
+class IoEngineTest : public testing::TestWithParam<const char *>
+{
+public:
+  static constexpr int BLOCK_SIZE = 4096;
+
+  void SetUp() override
+  {
+    ::remove(file_name_);
+    fd_ = ::open(file_name_, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd_, 0);
+
+    // 队列深度设置得很小，测试请求比队列深度多的情况
+    ASSERT_EQ(RC::SUCCESS, IoEngine::create(GetParam(), 2, engine_));
+  }
+
+  void TearDown() override
+  {
+    engine_.reset();
+    ::close(fd_);
+    ::remove(file_name_);
+  }
+
+  static void fill_block(char *block, int block_num) { memset(block, 'a' + block_num % 26, BLOCK_SIZE); }
+
+protected:
+  const char          *file_name_ = "io_engine_test.data";
+  int                  fd_        = -1;
+  unique_ptr<IoEngine> engine_;
+};
+
+TEST_P(IoEngineTest, write_then_read)
+{
+  const int BLOCKS_PER_REQUEST = 4;
+  const int REQUEST_NUM        = 8;
+  const int BLOCK_NUM          = BLOCKS_PER_REQUEST * REQUEST_NUM;
+
+  vector<char> write_data(BLOCK_NUM * BLOCK_SIZE);
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    fill_block(write_data.data() + i * BLOCK_SIZE, i);
+  }
+
+  IoBatch write_batch(*engine_);
+  for (int i = 0; i < REQUEST_NUM; i++) {
+    vector<struct iovec> iov;
+    for (int j = 0; j < BLOCKS_PER_REQUEST; j++) {
+      iov.push_back({write_data.data() + (i * BLOCKS_PER_REQUEST + j) * BLOCK_SIZE, BLOCK_SIZE});
+    }
+    write_batch.add_write(fd_, static_cast<off_t>(i) * BLOCKS_PER_REQUEST * BLOCK_SIZE, std::move(iov));
+  }
+  ASSERT_EQ(REQUEST_NUM, static_cast<int>(write_batch.size()));
+  ASSERT_EQ(RC::SUCCESS, write_batch.submit());
+  ASSERT_EQ(RC::SUCCESS, write_batch.wait());
+
+  // 逆序读，每个页面一个请求
+  vector<char> read_data(BLOCK_NUM * BLOCK_SIZE, 0);
+  IoBatch      read_batch(*engine_);
+  for (int i = BLOCK_NUM - 1; i >= 0; i--) {
+    read_batch.add_read(fd_, static_cast<off_t>(i) * BLOCK_SIZE, {{read_data.data() + i * BLOCK_SIZE, BLOCK_SIZE}});
+  }
+  ASSERT_EQ(RC::SUCCESS, read_batch.submit());
+  ASSERT_EQ(RC::SUCCESS, read_batch.wait());
+  ASSERT_EQ(write_data, read_data);
+
+  // 空的批次
+  IoBatch empty_batch(*engine_);
+  ASSERT_TRUE(empty_batch.empty());
+  ASSERT_EQ(RC::SUCCESS, empty_batch.submit());
+  ASSERT_EQ(RC::SUCCESS, empty_batch.wait());
+}
+
+TEST_P(IoEngineTest, read_end_of_file)
+{
+  char block[BLOCK_SIZE];
+  fill_block(block, 0);
+  ASSERT_EQ(0, pwriten(fd_, block, BLOCK_SIZE, 0));
+
+  char    buf[2][BLOCK_SIZE];
+  IoBatch batch(*engine_);
+  batch.add_read(fd_, 0, {{buf[0], BLOCK_SIZE}});
+  batch.add_read(fd_, BLOCK_SIZE, {{buf[1], BLOCK_SIZE}});
+  ASSERT_EQ(RC::SUCCESS, batch.submit());
+  ASSERT_EQ(RC::IOERR_READ, batch.wait());
+  ASSERT_EQ(0, batch.result(0));
+  ASSERT_EQ(-1, batch.result(1));
+  ASSERT_EQ(0, memcmp(block, buf[0], BLOCK_SIZE));
+}
+
+TEST_P(IoEngineTest, concurrent_batches)
+{
+  const int THREAD_NUM        = 4;
+  const int BLOCKS_PER_THREAD = 64;
+
+  vector<char> write_data(THREAD_NUM * BLOCKS_PER_THREAD * BLOCK_SIZE);
+  vector<char> read_data(write_data.size(), 0);
+  for (int i = 0; i < THREAD_NUM * BLOCKS_PER_THREAD; i++) {
+    fill_block(write_data.data() + i * BLOCK_SIZE, i);
+  }
+
+  vector<RC> rcs(THREAD_NUM, RC::INTERNAL);
+  auto       thread_func = [&](int thread_index) {
+    const int first_block = thread_index * BLOCKS_PER_THREAD;
+
+    IoBatch write_batch(*engine_);
+    for (int i = first_block; i < first_block + BLOCKS_PER_THREAD; i++) {
+      write_batch.add_write(fd_, static_cast<off_t>(i) * BLOCK_SIZE, {{write_data.data() + i * BLOCK_SIZE, BLOCK_SIZE}});
+    }
+    RC rc = write_batch.submit();
+    if (OB_SUCC(rc)) {
+      rc = write_batch.wait();
+    }
+    if (OB_FAIL(rc)) {
+      rcs[thread_index] = rc;
+      return;
+    }
+
+    IoBatch read_batch(*engine_);
+    for (int i = first_block; i < first_block + BLOCKS_PER_THREAD; i++) {
+      read_batch.add_read(fd_, static_cast<off_t>(i) * BLOCK_SIZE, {{read_data.data() + i * BLOCK_SIZE, BLOCK_SIZE}});
+    }
+    rc = read_batch.submit();
+    if (OB_SUCC(rc)) {
+      rc = read_batch.wait();
+    }
+    rcs[thread_index] = rc;
+  };
+
+  vector<thread> threads;
+  for (int i = 0; i < THREAD_NUM; i++) {
+    threads.emplace_back(thread_func, i);
+  }
+  for (thread &t : threads) {
+    t.join();
+  }
+
+  for (RC rc : rcs) {
+    ASSERT_EQ(RC::SUCCESS, rc);
+  }
+  ASSERT_EQ(write_data, read_data);
+}
+
+INSTANTIATE_TEST_SUITE_P(IoEngines, IoEngineTest, testing::Values("sync", "uring"));
+
+TEST(IoEngine, create)
+{
+  unique_ptr<IoEngine> engine;
+  ASSERT_EQ(RC::SUCCESS, IoEngine::create("SYNC", 8, engine));
+  ASSERT_STREQ("sync", engine->name());
+
+  // 系统不支持 io_uring 时会使用同步的引擎
+  ASSERT_EQ(RC::SUCCESS, IoEngine::create("", 8, engine));
+  ASSERT_TRUE(0 == strcmp("uring", engine->name()) || 0 == strcmp("sync", engine->name()));
+
+  ASSERT_EQ(RC::INVALID_ARGUMENT, IoEngine::create("aio", 8, engine));
+}
+
+#ifdef MINIOB_HAS_IO_URING
+/**
+ * @brief 可以让后台线程等待完成事件失败的 io_uring 引擎
+ */
+class FailingUringIoEngine : public UringIoEngine
+{
+public:
+  atomic<bool> fail{false};
+
+protected:
+  int wait_completions() override
+  {
+    if (fail.load()) {
+      errno = EIO;
+      return -1;
+    }
+    return UringIoEngine::wait_completions();
+  }
+};
+
+TEST(IoEngine, uring_reap_failure)
+{
+  const int BLOCK_SIZE = IoEngineTest::BLOCK_SIZE;
+  const int BLOCK_NUM  = 32;
+
+  auto engine = make_unique<FailingUringIoEngine>();
+  if (OB_FAIL(engine->init(4))) {
+    GTEST_SKIP() << "io_uring is not available";
+  }
+
+  const char *file_name = "io_engine_test.reap";
+  int         fd        = ::open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0);
+
+  vector<char> write_data(BLOCK_NUM * BLOCK_SIZE);
+  vector<char> read_data(write_data.size(), 0);
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    IoEngineTest::fill_block(write_data.data() + i * BLOCK_SIZE, i);
+  }
+
+  // 后台线程已经在内核中等待了，有请求完成以后，之后的等待都会失败，还没有完成的请求会被取消后同步执行
+  engine->fail = true;
+  IoBatch write_batch(*engine);
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    write_batch.add_write(fd, static_cast<off_t>(i) * BLOCK_SIZE, {{write_data.data() + i * BLOCK_SIZE, BLOCK_SIZE}});
+  }
+  ASSERT_EQ(RC::SUCCESS, write_batch.submit_and_wait());
+
+  // 之后的请求都在提交的线程中同步执行
+  IoBatch read_batch(*engine);
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    read_batch.add_read(fd, static_cast<off_t>(i) * BLOCK_SIZE, {{read_data.data() + i * BLOCK_SIZE, BLOCK_SIZE}});
+  }
+  ASSERT_EQ(RC::SUCCESS, read_batch.submit_and_wait());
+  ASSERT_EQ(write_data, read_data);
+
+  engine.reset();
+  ::close(fd);
+  ::remove(file_name);
+}
+
+TEST(IoEngine, uring_reap_failure_cancel)
+{
+  const int BLOCK_SIZE = IoEngineTest::BLOCK_SIZE;
+
+  auto engine = make_unique<FailingUringIoEngine>();
+  if (OB_FAIL(engine->init(4))) {
+    GTEST_SKIP() << "io_uring is not available";
+  }
+
+  const char *file_name = "io_engine_test.cancel";
+  int         fd        = ::open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0);
+  int pipe_fds[2];
+  ASSERT_EQ(0, ::pipe(pipe_fds));
+
+  vector<char> write_data(BLOCK_SIZE);
+  vector<char> read_data(BLOCK_SIZE, 0);
+  IoEngineTest::fill_block(write_data.data(), 0);
+
+  // 管道中没有数据，读请求会一直留在内核中。写请求完成以后等待完成事件开始失败，读请求需要先被取消
+  engine->fail = true;
+  IoBatch batch(*engine);
+  batch.add_read(pipe_fds[0], 0, {{read_data.data(), static_cast<size_t>(BLOCK_SIZE)}});
+  batch.add_write(fd, 0, {{write_data.data(), static_cast<size_t>(BLOCK_SIZE)}});
+  ASSERT_EQ(RC::IOERR_READ, batch.submit_and_wait());
+  ASSERT_EQ(ESPIPE, batch.result(0));  // 取消以后同步地重新执行，管道不支持 preadv
+  ASSERT_EQ(0, batch.result(1));
+
+  // 读请求已经完成了，之后写到管道中的数据不能再被读到请求的内存中
+  vector<char> pipe_data(BLOCK_SIZE, 'x');
+  ASSERT_EQ(BLOCK_SIZE, ::write(pipe_fds[1], pipe_data.data(), BLOCK_SIZE));
+  this_thread::sleep_for(chrono::milliseconds(100));
+  ASSERT_EQ(vector<char>(BLOCK_SIZE, 0), read_data);
+
+  vector<char> pipe_left(BLOCK_SIZE, 0);
+  ASSERT_EQ(BLOCK_SIZE, ::read(pipe_fds[0], pipe_left.data(), BLOCK_SIZE));
+  ASSERT_EQ(pipe_data, pipe_left);
+
+  engine.reset();
+  ::close(pipe_fds[0]);
+  ::close(pipe_fds[1]);
+  ::close(fd);
+  ::remove(file_name);
+}
+#endif  // MINIOB_HAS_IO_URING
+
+TEST(IoEngine, buffer_pool_flush_pages)
+{
+  const char *file_name = "io_engine_test.bp";
+  ::remove(file_name);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.init_io_engine("uring", 4));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+
+  VacuousLogHandler log_handler;
+  DiskBufferPool   *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, file_name, buffer_pool));
+
+  const int       PAGE_NUM = 32;
+  vector<PageNum> page_nums;
+  for (int i = 0; i < PAGE_NUM; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    memset(frame->data(), 'a' + i % 26, BP_PAGE_DATA_SIZE);
+    frame->mark_dirty();
+    page_nums.push_back(frame->page_num());
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->flush_all_pages());
+
+  int fd = ::open(file_name, O_RDONLY);
+  ASSERT_GE(fd, 0);
+  for (int i = 0; i < PAGE_NUM; i++) {
+    Page page;
+    ASSERT_EQ(0, preadn(fd, &page, sizeof(page), static_cast<off_t>(page_nums[i]) * sizeof(Page)));
+    for (int j = 0; j < BP_PAGE_DATA_SIZE; j++) {
+      ASSERT_EQ('a' + i % 26, page.data[j]);
+    }
+  }
+  ::close(fd);
+
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+  ::remove(file_name);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default(string(argv[0]) + ".log", LOG_LEVEL_TRACE);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,325 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <math.h>
+
+#include "common/lang/algorithm.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/memory.h"
+#include "common/lang/random.h"
+#include "common/lang/vector.h"
+#include "common/math/vector_distance.h"
+#include "common/value.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/vacuous_log_handler.h"
+#include "storage/index/ivfflat_index.h"
+#include "gtest/gtest.h"
+
+using namespace common;
+
+namespace {
+
+vector<float> random_vectors(int num, int dim, unsigned seed)
+{
+  mt19937                       random(seed);
+  normal_distribution<float>    distribution(0.0f, 1.0f);
+  uniform_int_distribution<int> cluster_distribution(0, 15);
+  vector<float>                 centers(16 * dim);
+  for (float &value : centers) {
+    value = distribution(random) * 10;
+  }
+
+  // 数据围绕着 16 个中心分布，和真实的数据一样有聚类的特征
+  vector<float> vectors(static_cast<size_t>(num) * dim);
+  for (int i = 0; i < num; i++) {
+    const float *center = centers.data() + cluster_distribution(random) * dim;
+    for (int d = 0; d < dim; d++) {
+      vectors[static_cast<size_t>(i) * dim + d] = center[d] + distribution(random);
+    }
+  }
+  return vectors;
+}
+
+vector<RID> brute_force(
+    VectorDistanceType type, const vector<float> &vectors, int dim, const float *query, size_t limit)
+{
+  const int                vector_num = static_cast<int>(vectors.size() / dim);
+  vector<pair<float, int>> distances(vector_num);
+  for (int i = 0; i < vector_num; i++) {
+    distances[i] = {vector_distance(type, query, vectors.data() + static_cast<size_t>(i) * dim, dim), i};
+  }
+  limit = std::min(limit, distances.size());
+  std::partial_sort(distances.begin(), distances.begin() + limit, distances.end());
+
+  vector<RID> rids;
+  for (size_t i = 0; i < limit; i++) {
+    rids.emplace_back(distances[i].second / 100, distances[i].second % 100);
+  }
+  return rids;
+}
+
+}  // namespace
+
+TEST(VectorDistance, kernels)
+{
+  mt19937                          random(1);
+  uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  for (int dim : {1, 3, 7, 8, 9, 16, 17, 31, 64, 100}) {
+    vector<float> a(dim), b(dim);
+    for (int i = 0; i < dim; i++) {
+      a[i] = distribution(random);
+      b[i] = distribution(random);
+    }
+
+    double l2 = 0, ip = 0, norm_a = 0, norm_b = 0;
+    for (int i = 0; i < dim; i++) {
+      l2 += (a[i] - b[i]) * (a[i] - b[i]);
+      ip += a[i] * b[i];
+      norm_a += a[i] * a[i];
+      norm_b += b[i] * b[i];
+    }
+    const double cosine = 1 - ip / sqrt(norm_a * norm_b);
+
+    EXPECT_NEAR(l2, l2_distance(a.data(), b.data(), dim), 1e-4) << "dim=" << dim;
+    EXPECT_NEAR(ip, inner_product(a.data(), b.data(), dim), 1e-4) << "dim=" << dim;
+    EXPECT_NEAR(cosine, cosine_distance(a.data(), b.data(), dim), 1e-4) << "dim=" << dim;
+    EXPECT_NEAR(-ip, vector_distance(VectorDistanceType::INNER_PRODUCT, a.data(), b.data(), dim), 1e-4);
+  }
+
+  vector<float> zero(8, 0.0f), one(8, 1.0f);
+  EXPECT_EQ(1.0f, cosine_distance(zero.data(), one.data(), 8));
+
+  VectorDistanceType type;
+  ASSERT_TRUE(vector_distance_type_from_string("cosine", type));
+  EXPECT_EQ(VectorDistanceType::COSINE, type);
+  EXPECT_FALSE(vector_distance_type_from_string("manhattan", type));
+}
+
+TEST(VectorType, compare_and_to_string)
+{
+  const float a[] = {1.0f, 2.5f, 3.0f};
+  const float b[] = {1.0f, 2.5f, 4.0f};
+
+  Value va, vb, va2;
+  va.set_vector(a, 3);
+  vb.set_vector(b, 3);
+  va2 = va;
+
+  EXPECT_EQ("[1,2.5,3]", va.to_string());
+  EXPECT_LT(va.compare(vb), 0);
+  EXPECT_GT(vb.compare(va), 0);
+  EXPECT_EQ(0, va.compare(va2));
+
+  Value shorter;
+  shorter.set_vector(a, 2);
+  EXPECT_LT(shorter.compare(va), 0);
+}
+
+class IvfflatIndexTest : public ::testing::Test
+{
+protected:
+  static constexpr int DIMENSION = 16;
+
+  void SetUp() override
+  {
+    filesystem::remove_all(test_directory_);
+    filesystem::create_directory(test_directory_);
+
+    bpm_ = make_unique<BufferPoolManager>();
+    ASSERT_EQ(RC::SUCCESS, bpm_->init(make_unique<VacuousDoubleWriteBuffer>()));
+
+    field_meta_ = FieldMeta("embedding", AttrType::VECTORS, 0, DIMENSION * sizeof(float), true, 0);
+    ASSERT_EQ(RC::SUCCESS, index_meta_.init("ivf", field_meta_));
+  }
+
+  void TearDown() override
+  {
+    index_.reset();
+    bpm_.reset();
+    filesystem::remove_all(test_directory_);
+  }
+
+  void create_index(VectorDistanceType type, int lists, int probes)
+  {
+    index_ = make_unique<IvfflatIndex>();
+    index_->set_options(type, lists, probes);
+    ASSERT_EQ(RC::SUCCESS, index_->create(log_handler_, *bpm_, file_name().c_str(), index_meta_, {field_meta_}));
+  }
+
+  /// 训练并插入所有的向量，第 i 个向量的 RID 是 (i / 100, i % 100)
+  void load(const vector<float> &vectors)
+  {
+    const int vector_num = static_cast<int>(vectors.size() / DIMENSION);
+    ASSERT_EQ(RC::SUCCESS, index_->train(vectors.data(), vector_num));
+    for (int i = 0; i < vector_num; i++) {
+      RID rid(i / 100, i % 100);
+      ASSERT_EQ(RC::SUCCESS, index_->insert_entry(record_of(vectors, i), &rid));
+    }
+  }
+
+  const char *record_of(const vector<float> &vectors, int i) const
+  {
+    return reinterpret_cast<const char *>(vectors.data() + static_cast<size_t>(i) * DIMENSION);
+  }
+
+  string file_name() const { return (test_directory_ / "ivf.index").string(); }
+
+protected:
+  filesystem::path              test_directory_ = "ivfflat_index_test";
+  VacuousLogHandler             log_handler_;
+  unique_ptr<BufferPoolManager> bpm_;
+  FieldMeta                     field_meta_;
+  IndexMeta                     index_meta_;
+  unique_ptr<IvfflatIndex>      index_;
+};
+
+TEST_F(IvfflatIndexTest, exhaustive_probes_match_brute_force)
+{
+  const vector<float> vectors = random_vectors(3000, DIMENSION, 2);
+  for (VectorDistanceType type :
+      {VectorDistanceType::L2, VectorDistanceType::COSINE, VectorDistanceType::INNER_PRODUCT}) {
+    create_index(type, 32, 4);
+    load(vectors);
+    EXPECT_EQ(32, index_->lists());
+
+    const vector<float> queries = random_vectors(20, DIMENSION, 3);
+    for (int q = 0; q < 20; q++) {
+      const float  *query = queries.data() + q * DIMENSION;
+      vector<RID>   rids;
+      vector<float> distances;
+      ASSERT_EQ(RC::SUCCESS, index_->ann_search(query, 10, index_->lists(), rids, &distances));
+      ASSERT_EQ(10, static_cast<int>(rids.size()));
+      EXPECT_TRUE(std::is_sorted(distances.begin(), distances.end()));
+
+      vector<RID> expected = brute_force(type, vectors, DIMENSION, query, 10);
+      EXPECT_EQ(expected, rids) << "distance=" << vector_distance_type_name(type) << ", query=" << q;
+    }
+
+    index_.reset();
+    bpm_->close_file(file_name().c_str());
+    filesystem::remove(file_name());
+  }
+}
+
+TEST_F(IvfflatIndexTest, recall_grows_with_probes)
+{
+  const vector<float> vectors = random_vectors(5000, DIMENSION, 4);
+  create_index(VectorDistanceType::L2, 64, 1);
+  load(vectors);
+
+  const vector<float> queries     = random_vectors(50, DIMENSION, 5);
+  double              last_recall = 0;
+  for (int probes : {1, 4, 16, 64}) {
+    int hits = 0;
+    for (int q = 0; q < 50; q++) {
+      const float *query = queries.data() + q * DIMENSION;
+      vector<RID>  rids;
+      ASSERT_EQ(RC::SUCCESS, index_->ann_search(query, 10, probes, rids));
+
+      vector<RID> expected = brute_force(VectorDistanceType::L2, vectors, DIMENSION, query, 10);
+      for (const RID &rid : rids) {
+        hits += std::count(expected.begin(), expected.end(), rid);
+      }
+    }
+    const double recall = hits / 500.0;
+    EXPECT_GE(recall, last_recall) << "probes=" << probes;
+    last_recall = recall;
+  }
+  EXPECT_DOUBLE_EQ(1.0, last_recall);
+}
+
+TEST_F(IvfflatIndexTest, insert_before_train)
+{
+  create_index(VectorDistanceType::L2, 8, 2);
+
+  const vector<float> vectors = random_vectors(1, DIMENSION, 6);
+  RID                 rid(1, 1);
+  EXPECT_NE(RC::SUCCESS, index_->insert_entry(record_of(vectors, 0), &rid));
+
+  vector<RID> rids;
+  ASSERT_EQ(RC::SUCCESS, index_->ann_search(vectors.data(), 10, 0, rids));
+  EXPECT_TRUE(rids.empty());
+}
+
+TEST_F(IvfflatIndexTest, delete_entry)
+{
+  // 列表少，每个倒排表会有多个页面
+  const vector<float> vectors = random_vectors(2000, DIMENSION, 7);
+  create_index(VectorDistanceType::L2, 2, 2);
+  load(vectors);
+
+  for (int i = 0; i < 2000; i += 2) {
+    RID rid(i / 100, i % 100);
+    ASSERT_EQ(RC::SUCCESS, index_->delete_entry(record_of(vectors, i), &rid));
+  }
+  RID deleted(0, 0);
+  EXPECT_EQ(RC::RECORD_NOT_EXIST, index_->delete_entry(record_of(vectors, 0), &deleted));
+
+  for (int i = 0; i < 2000; i += 97) {
+    vector<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, index_->ann_search(vectors.data() + i * DIMENSION, 2000, 0, rids));
+    ASSERT_EQ(1000, static_cast<int>(rids.size()));
+    for (const RID &rid : rids) {
+      EXPECT_EQ(1, (rid.page_num * 100 + rid.slot_num) % 2);
+    }
+    if (i % 2 == 1) {
+      EXPECT_EQ(RID(i / 100, i % 100), rids.front());
+    }
+  }
+
+  for (int i = 1; i < 2000; i += 2) {
+    RID rid(i / 100, i % 100);
+    ASSERT_EQ(RC::SUCCESS, index_->delete_entry(record_of(vectors, i), &rid));
+  }
+  vector<RID> rids;
+  ASSERT_EQ(RC::SUCCESS, index_->ann_search(vectors.data(), 10, 0, rids));
+  EXPECT_TRUE(rids.empty());
+
+  // 删空之后还可以继续插入
+  RID rid(0, 1);
+  ASSERT_EQ(RC::SUCCESS, index_->insert_entry(record_of(vectors, 1), &rid));
+  ASSERT_EQ(RC::SUCCESS, index_->ann_search(vectors.data(), 10, 0, rids));
+  EXPECT_EQ(vector<RID>{rid}, rids);
+}
+
+TEST_F(IvfflatIndexTest, reopen)
+{
+  const vector<float> vectors = random_vectors(1000, DIMENSION, 8);
+  create_index(VectorDistanceType::COSINE, 16, 16);
+  load(vectors);
+
+  vector<RID> before;
+  ASSERT_EQ(RC::SUCCESS, index_->ann_search(vectors.data() + 5 * DIMENSION, 10, 0, before));
+  index_.reset();
+
+  // 换一个新的 BufferPoolManager，数据只能从文件中读取
+  bpm_ = make_unique<BufferPoolManager>();
+  ASSERT_EQ(RC::SUCCESS, bpm_->init(make_unique<VacuousDoubleWriteBuffer>()));
+
+  index_ = make_unique<IvfflatIndex>();
+  ASSERT_EQ(RC::SUCCESS, index_->open(log_handler_, *bpm_, file_name().c_str(), index_meta_, {field_meta_}));
+  EXPECT_EQ(VectorDistanceType::COSINE, index_->distance_type());
+  EXPECT_EQ(16, index_->lists());
+  EXPECT_EQ(16, index_->probes());
+  EXPECT_TRUE(index_->trained());
+
+  vector<RID> after;
+  ASSERT_EQ(RC::SUCCESS, index_->ann_search(vectors.data() + 5 * DIMENSION, 10, 0, after));
+  EXPECT_EQ(before, after);
+  EXPECT_EQ(RID(0, 5), after.front());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("ivfflat_index_test.log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
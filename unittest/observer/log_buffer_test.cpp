@@ -18,6 +18,7 @@ See the Mulan PSL v2 for more details. */
 #define protected public
 #include "storage/clog/log_buffer.h"
 #include "storage/clog/log_file.h"
+#include "common/lang/thread.h"
 
 using namespace std;
 using namespace common;
@@ -66,6 +67,124 @@ TEST(LogEntryBuffer, test_append)
   filesystem::remove("test_log_entry_buffer.log");
 }
 
+TEST(LogEntryBuffer, test_group_flush)
+{
+  LSN            start_lsn = 0;
+  LSN            end_lsn   = 100;
+  LogEntryBuffer buffer;
+  ASSERT_EQ(RC::SUCCESS, buffer.init(start_lsn));
+
+  LSN lsn = 0;
+  ASSERT_FALSE(buffer.wait_flushed(1, chrono::milliseconds(1)));
+  ASSERT_FALSE(buffer.wait_for_entries(chrono::milliseconds(1)));
+
+  const int entry_num = 10;
+  for (int i = 0; i < entry_num; i++) {
+    ASSERT_EQ(RC::SUCCESS, buffer.append(lsn, LogModule::Id::BUFFER_POOL, vector<char>(10)));
+  }
+  ASSERT_TRUE(buffer.wait_for_entries(chrono::milliseconds(1)));
+
+  // 等待的线程在这一组日志刷盘后被唤醒
+  thread waiter([&buffer, lsn]() { ASSERT_TRUE(buffer.wait_flushed(lsn, chrono::seconds(10))); });
+
+  LogFileWriter writer;
+  ASSERT_EQ(RC::SUCCESS, writer.open("test_log_group_flush.log", end_lsn));
+  int count = 0;
+  ASSERT_EQ(RC::SUCCESS, buffer.flush(writer, count));
+  ASSERT_EQ(entry_num, count);
+  ASSERT_EQ(lsn, buffer.flushed_lsn());
+  ASSERT_EQ(0, buffer.entry_number());
+  ASSERT_EQ(0, buffer.bytes());
+  waiter.join();
+
+  // 超过文件上限的日志留在缓冲区中，下一个文件再写
+  for (LSN i = lsn + 1; i <= end_lsn + 5; i++) {
+    ASSERT_EQ(RC::SUCCESS, buffer.append(lsn, LogModule::Id::BUFFER_POOL, vector<char>(10)));
+  }
+  ASSERT_EQ(RC::LOG_FILE_FULL, buffer.flush(writer, count));
+  ASSERT_EQ(end_lsn - entry_num, count);
+  ASSERT_EQ(end_lsn, buffer.flushed_lsn());
+  ASSERT_EQ(5, buffer.entry_number());
+  ASSERT_EQ(RC::LOG_FILE_FULL, buffer.flush(writer, count));
+  ASSERT_EQ(0, count);
+  writer.close();
+
+  LogFileWriter next_writer;
+  ASSERT_EQ(RC::SUCCESS, next_writer.open("test_log_group_flush.log.next", end_lsn * 2));
+  ASSERT_EQ(RC::SUCCESS, buffer.flush(next_writer, count));
+  ASSERT_EQ(5, count);
+  ASSERT_EQ(lsn, buffer.flushed_lsn());
+  next_writer.close();
+
+  filesystem::remove("test_log_group_flush.log");
+  filesystem::remove("test_log_group_flush.log.next");
+}
+
+TEST(LogEntryBuffer, test_concurrent_append)
+{
+  // 多个线程并发追加日志，同时有一个线程在刷新。日志的总大小超过缓冲区，会发生回绕
+  LogEntryBuffer buffer;
+  ASSERT_EQ(RC::SUCCESS, buffer.init(0));
+
+  const int   thread_num       = 4;
+  const int   entry_per_thread = 2000;
+  const LSN   total_entry_num  = thread_num * entry_per_thread;
+  const char *filename         = "test_log_concurrent_append.log";
+  filesystem::remove(filename);
+
+  LogFileWriter writer;
+  ASSERT_EQ(RC::SUCCESS, writer.open(filename, total_entry_num));
+
+  thread flusher([&buffer, &writer, total_entry_num]() {
+    while (buffer.flushed_lsn() < total_entry_num) {
+      int count = 0;
+      ASSERT_EQ(RC::SUCCESS, buffer.flush(writer, count));
+      if (count == 0) {
+        buffer.wait_for_entries(chrono::milliseconds(10));
+      }
+    }
+  });
+
+  vector<thread> appenders;
+  for (int t = 0; t < thread_num; t++) {
+    appenders.emplace_back([&buffer, t]() {
+      for (int i = 0; i < entry_per_thread; i++) {
+        // 日志数据的内容由大小决定，读出来的时候可以检查
+        const int size = (t * entry_per_thread + i) % 2000 + 1;
+        LSN       lsn  = 0;
+        ASSERT_EQ(RC::SUCCESS, buffer.append(lsn, LogModule::Id::BUFFER_POOL, vector<char>(size, size % 128)));
+      }
+    });
+  }
+
+  for (thread &t : appenders) {
+    t.join();
+  }
+  flusher.join();
+  writer.close();
+
+  ASSERT_EQ(total_entry_num, buffer.current_lsn());
+  ASSERT_EQ(0, buffer.entry_number());
+  ASSERT_EQ(0, buffer.bytes());
+
+  LogFileReader reader;
+  ASSERT_EQ(RC::SUCCESS, reader.open(filename));
+  LSN expected_lsn = 1;
+  ASSERT_EQ(RC::SUCCESS, reader.iterate([&expected_lsn](LogEntry &entry) {
+    EXPECT_EQ(expected_lsn++, entry.lsn());
+    for (int i = 0; i < entry.payload_size(); i++) {
+      if (entry.data()[i] != entry.payload_size() % 128) {
+        return RC::INTERNAL;
+      }
+    }
+    return RC::SUCCESS;
+  }));
+  ASSERT_EQ(total_entry_num + 1, expected_lsn);
+  reader.close();
+
+  filesystem::remove(filename);
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,141 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "common/lang/vector.h"
+#include "common/log/log.h"
+#include "storage/clog/vacuous_log_handler.h"
+#include "storage/trx/mvcc_trx.h"
+
+using namespace std;
+using namespace common;
+
+TEST(MvccTrxKit, all_trxes)
+{
+  MvccTrxKit kit;
+  ASSERT_EQ(RC::SUCCESS, kit.init());
+
+  VacuousLogHandler log_handler;
+  vector<Trx *>     created;
+  for (int i = 0; i < 200; i++) {
+    created.push_back(kit.create_trx(log_handler));
+  }
+
+  vector<Trx *> trxes;
+  kit.all_trxes(trxes);
+  ASSERT_EQ(created.size(), trxes.size());
+
+  for (size_t i = 0; i < created.size(); i += 2) {
+    kit.destroy_trx(created[i]);
+  }
+  kit.all_trxes(trxes);
+  ASSERT_EQ(created.size() / 2, trxes.size());
+  for (Trx *trx : trxes) {
+    ASSERT_NE(created.end(), find(created.begin(), created.end(), trx));
+  }
+
+  for (size_t i = 1; i < created.size(); i += 2) {
+    kit.destroy_trx(created[i]);
+  }
+  kit.all_trxes(trxes);
+  ASSERT_TRUE(trxes.empty());
+}
+
+TEST(MvccTrxKit, min_active_trx_id)
+{
+  MvccTrxKit kit;
+  ASSERT_EQ(RC::SUCCESS, kit.init());
+
+  VacuousLogHandler log_handler;
+
+  // 没有活跃事务时是下一个要分配的事务ID
+  const int32_t idle_min_trx_id = kit.min_active_trx_id();
+
+  // 没有开始的事务不影响结果
+  Trx *idle_trx = kit.create_trx(log_handler);
+  ASSERT_EQ(idle_min_trx_id, kit.min_active_trx_id());
+
+  Trx *trx1 = kit.create_trx(log_handler);
+  Trx *trx2 = kit.create_trx(log_handler);
+  ASSERT_EQ(RC::SUCCESS, trx1->start_if_need());
+  ASSERT_EQ(RC::SUCCESS, trx2->start_if_need());
+  ASSERT_EQ(idle_min_trx_id, trx1->id());
+  ASSERT_LT(trx1->id(), trx2->id());
+  ASSERT_EQ(trx1->id(), kit.min_active_trx_id());
+
+  ASSERT_EQ(RC::SUCCESS, trx1->commit());
+  ASSERT_EQ(trx2->id(), kit.min_active_trx_id());
+
+  ASSERT_EQ(RC::SUCCESS, trx2->rollback());
+  ASSERT_GT(kit.min_active_trx_id(), trx2->id());
+
+  kit.destroy_trx(trx1);
+  kit.destroy_trx(trx2);
+  kit.destroy_trx(idle_trx);
+}
+
+#ifdef CONCURRENCY
+TEST(MvccTrxKit, concurrent_min_active_trx_id)
+{
+  MvccTrxKit kit;
+  ASSERT_EQ(RC::SUCCESS, kit.init());
+
+  VacuousLogHandler log_handler;
+
+  // 一直活跃的事务，最小活跃事务ID不能超过它
+  Trx *long_trx = kit.create_trx(log_handler);
+  ASSERT_EQ(RC::SUCCESS, long_trx->start_if_need());
+  const int32_t long_trx_id = long_trx->id();
+
+  const int      thread_num = 4;
+  atomic<bool>   stop{false};
+  vector<thread> threads;
+  for (int i = 0; i < thread_num; i++) {
+    threads.emplace_back([&kit, &log_handler, &stop]() {
+      while (!stop.load()) {
+        Trx *trx = kit.create_trx(log_handler);
+        trx->start_if_need();
+        // 自己还没有结束，最小活跃事务ID不会比自己大
+        EXPECT_LE(kit.min_active_trx_id(), trx->id());
+        trx->commit();
+        kit.destroy_trx(trx);
+      }
+    });
+  }
+
+  int32_t last_min_trx_id = 0;
+  for (int i = 0; i < 10000; i++) {
+    const int32_t min_trx_id = kit.min_active_trx_id();
+    ASSERT_GE(min_trx_id, last_min_trx_id);
+    ASSERT_LE(min_trx_id, long_trx_id);
+    last_min_trx_id = min_trx_id;
+  }
+
+  stop.store(true);
+  for (thread &t : threads) {
+    t.join();
+  }
+
+  ASSERT_EQ(RC::SUCCESS, long_trx->commit());
+  ASSERT_GT(kit.min_active_trx_id(), long_trx_id);
+  kit.destroy_trx(long_trx);
+}
+#endif  // CONCURRENCY
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  filesystem::path log_filename = filesystem::path(argv[0]).filename();
+  LoggerFactory::init_default(log_filename.string() + ".log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,318 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+
+#include "gtest/gtest.h"
+#include "common/lang/memory.h"
+#include "common/lang/vector.h"
+#include "common/log/log.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/db/db.h"
+#include "storage/index/index.h"
+#include "storage/record/record.h"
+#include "storage/record/record_scanner.h"
+#include "storage/table/table.h"
+#include "storage/trx/mvcc_vacuum.h"
+#include "storage/trx/trx.h"
+
+using namespace std;
+using namespace common;
+
+class MvccVacuumTest : public testing::Test
+{
+public:
+  static constexpr int RECORD_NUM = 2000;
+
+  void SetUp() override
+  {
+    const char *test_name = testing::UnitTest::GetInstance()->current_test_info()->name();
+    test_directory_       = filesystem::path("mvcc_vacuum_test") / test_name;
+    filesystem::remove_all(test_directory_);
+    filesystem::create_directories(test_directory_ / "db");
+
+    db_ = open_db("db");
+
+    vector<AttrInfoSqlNode> attr_infos(2);
+    attr_infos[0].name   = "id";
+    attr_infos[0].type   = AttrType::INTS;
+    attr_infos[0].length = 4;
+    attr_infos[1].name   = "payload";
+    attr_infos[1].type   = AttrType::CHARS;
+    attr_infos[1].length = 200;
+    ASSERT_EQ(RC::SUCCESS, db_->create_table("t", attr_infos, {}));
+    table_ = db_->find_table("t");
+    ASSERT_NE(nullptr, table_);
+
+    Trx *trx = db_->trx_kit().create_trx(db_->log_handler());
+    trx->start_if_need();
+    vector<const FieldMeta *> field_metas{table_->table_meta().field("id")};
+    ASSERT_EQ(RC::SUCCESS, table_->create_index(trx, field_metas, "t_id", false));
+    trx->commit();
+    db_->trx_kit().destroy_trx(trx);
+
+    // 测试中手动执行清理，CONCURRENCY 模式下先停掉后台线程
+    ASSERT_NE(nullptr, db_->vacuum());
+    db_->vacuum()->stop();
+  }
+
+  void TearDown() override
+  {
+    db_.reset();
+    filesystem::remove_all(test_directory_);
+  }
+
+  unique_ptr<Db> open_db(const char *name)
+  {
+    auto db = make_unique<Db>();
+    EXPECT_EQ(RC::SUCCESS, db->init(name, (test_directory_ / name).c_str(), "mvcc", "disk"));
+    return db;
+  }
+
+  void insert_records(int begin, int end)
+  {
+    Trx *trx = db_->trx_kit().create_trx(db_->log_handler());
+    trx->start_if_need();
+    for (int i = begin; i < end; i++) {
+      vector<Value> values(2);
+      values[0].set_int(i);
+      values[1].set_string("payload");
+      Record record;
+      ASSERT_EQ(RC::SUCCESS, table_->make_record(values.size(), values.data(), record));
+      ASSERT_EQ(RC::SUCCESS, trx->insert_record(table_, record));
+      rids_.push_back(record.rid());
+    }
+    ASSERT_EQ(RC::SUCCESS, trx->commit());
+    db_->trx_kit().destroy_trx(trx);
+  }
+
+  /// 删除 id 是偶数的记录
+  void delete_even_records()
+  {
+    Trx *trx = db_->trx_kit().create_trx(db_->log_handler());
+    trx->start_if_need();
+    for (size_t i = 0; i < rids_.size(); i += 2) {
+      Record record;
+      ASSERT_EQ(RC::SUCCESS, table_->get_record(rids_[i], record));
+      ASSERT_EQ(RC::SUCCESS, trx->delete_record(table_, record));
+    }
+    ASSERT_EQ(RC::SUCCESS, trx->commit());
+    db_->trx_kit().destroy_trx(trx);
+  }
+
+  /// 事务能看到多少条记录
+  static int visible_count(Table *table, Trx *trx)
+  {
+    RecordScanner *scanner = nullptr;
+    EXPECT_EQ(RC::SUCCESS, table->get_record_scanner(scanner, trx, ReadWriteMode::READ_ONLY));
+    int    count = 0;
+    Record record;
+    while (OB_SUCC(scanner->next(record))) {
+      count++;
+    }
+    delete scanner;
+    return count;
+  }
+
+  /// 不考虑事务，表中一共有多少条记录
+  static int physical_count(Table *table) { return visible_count(table, nullptr); }
+
+  static int index_entry_count(Table *table, const char *index_name = "t_id")
+  {
+    Index        *index   = table->find_index(index_name);
+    IndexScanner *scanner = index->create_scanner(nullptr, 0, true, nullptr, 0, true);
+    int           count   = 0;
+    RID           rid;
+    while (OB_SUCC(scanner->next_entry(&rid))) {
+      count++;
+    }
+    scanner->destroy();
+    return count;
+  }
+
+protected:
+  filesystem::path test_directory_;
+  unique_ptr<Db>   db_;
+  Table           *table_ = nullptr;
+  vector<RID>      rids_;
+};
+
+TEST_F(MvccVacuumTest, purge_dead_records)
+{
+  insert_records(0, RECORD_NUM);
+  delete_even_records();
+  ASSERT_EQ(RECORD_NUM, physical_count(table_));
+  ASSERT_EQ(RECORD_NUM, index_entry_count(table_));
+
+  MvccVacuum *vacuum = db_->vacuum();
+  ASSERT_EQ(RECORD_NUM / 2, vacuum->vacuum_all());
+  ASSERT_EQ(RECORD_NUM / 2, physical_count(table_));
+  ASSERT_EQ(RECORD_NUM / 2, index_entry_count(table_));
+  ASSERT_EQ(0, vacuum->vacuum_all());
+
+  Trx *trx = db_->trx_kit().create_trx(db_->log_handler());
+  trx->start_if_need();
+  ASSERT_EQ(RECORD_NUM / 2, visible_count(table_, trx));
+  trx->commit();
+  db_->trx_kit().destroy_trx(trx);
+
+  // 新插入的记录复用清理出来的空间
+  PageNum max_page = 0;
+  for (const RID &rid : rids_) {
+    max_page = max(max_page, rid.page_num);
+  }
+  rids_.clear();
+  insert_records(RECORD_NUM, RECORD_NUM + RECORD_NUM / 2);
+  for (const RID &rid : rids_) {
+    ASSERT_LE(rid.page_num, max_page);
+  }
+}
+
+TEST_F(MvccVacuumTest, keep_visible_records)
+{
+  insert_records(0, RECORD_NUM);
+
+  // 删除之前开始的事务还能看到所有的记录，这些记录不能清理
+  Trx *reader = db_->trx_kit().create_trx(db_->log_handler());
+  reader->start_if_need();
+
+  delete_even_records();
+
+  // 正在删除、还没有提交的记录也不能清理
+  Trx *deleter = db_->trx_kit().create_trx(db_->log_handler());
+  deleter->start_if_need();
+  Record record;
+  ASSERT_EQ(RC::SUCCESS, table_->get_record(rids_[1], record));
+  ASSERT_EQ(RC::SUCCESS, deleter->delete_record(table_, record));
+
+  MvccVacuum *vacuum = db_->vacuum();
+  ASSERT_EQ(0, vacuum->vacuum_all());
+  ASSERT_EQ(RECORD_NUM, visible_count(table_, reader));
+
+  ASSERT_EQ(RC::SUCCESS, reader->commit());
+  db_->trx_kit().destroy_trx(reader);
+  ASSERT_EQ(RECORD_NUM / 2, vacuum->vacuum_all());
+
+  ASSERT_EQ(RC::SUCCESS, deleter->commit());
+  db_->trx_kit().destroy_trx(deleter);
+  ASSERT_EQ(1, vacuum->vacuum_all());
+  ASSERT_EQ(RECORD_NUM / 2 - 1, physical_count(table_));
+}
+
+TEST_F(MvccVacuumTest, rate_limit)
+{
+  insert_records(0, RECORD_NUM);
+  delete_even_records();
+
+  // 后台线程没有启动，只修改每轮的额度
+  MvccVacuum *vacuum = db_->vacuum();
+  ASSERT_EQ(RC::SUCCESS, vacuum->start(0, 1, 10));
+
+  // 每轮最多遍历一个页面，一个页面上最多几十条记录，需要很多轮才能清理完
+  int purged_num = vacuum->vacuum();
+  ASSERT_GT(purged_num, 0);
+  ASSERT_LT(purged_num, RECORD_NUM / 20);
+
+  int rounds = 1;
+  for (int purged = 0; (purged = vacuum->vacuum()) > 0; rounds++) {
+    purged_num += purged;
+  }
+  ASSERT_GT(rounds, 20);
+  ASSERT_EQ(RECORD_NUM / 2, purged_num);
+  ASSERT_EQ(RECORD_NUM / 2, physical_count(table_));
+}
+
+TEST_F(MvccVacuumTest, recover)
+{
+  insert_records(0, RECORD_NUM);
+  delete_even_records();
+  ASSERT_EQ(RECORD_NUM / 2, db_->vacuum()->vacuum_all());
+
+  // 清理的修改有日志，复制文件之后恢复出来的数据是清理过的
+  auto &log_handler = static_cast<DiskLogHandler &>(db_->log_handler());
+  ASSERT_EQ(RC::SUCCESS, log_handler.wait_lsn(log_handler.current_lsn()));
+  filesystem::copy(test_directory_ / "db", test_directory_ / "db2", filesystem::copy_options::recursive);
+
+  unique_ptr<Db> db2   = open_db("db2");
+  Table         *table = db2->find_table("t");
+  ASSERT_NE(nullptr, table);
+  ASSERT_EQ(RECORD_NUM / 2, physical_count(table));
+}
+
+#ifdef CONCURRENCY
+TEST_F(MvccVacuumTest, background_thread)
+{
+  MvccVacuum *vacuum = db_->vacuum();
+  ASSERT_EQ(RC::SUCCESS, vacuum->start(10, 16, 100));
+
+  insert_records(0, RECORD_NUM);
+  delete_even_records();
+
+  for (int i = 0; i < 500 && physical_count(table_) > RECORD_NUM / 2; i++) {
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+  ASSERT_EQ(RECORD_NUM / 2, physical_count(table_));
+  ASSERT_EQ(RECORD_NUM / 2, index_entry_count(table_));
+}
+
+TEST_F(MvccVacuumTest, create_index_while_purging)
+{
+  insert_records(0, RECORD_NUM);
+  delete_even_records();
+
+  // 每轮只清理很少的记录，创建索引时清理线程还在运行
+  MvccVacuum *vacuum = db_->vacuum();
+  ASSERT_EQ(RC::SUCCESS, vacuum->start(1, 1, 10));
+
+  // 不带事务创建索引时，还没有清理的已删除记录也会加入新索引，之后要靠清理线程从新索引中删除
+  const int index_num = 8;
+  for (int i = 0; i < index_num; i++) {
+    vector<const FieldMeta *> field_metas{table_->table_meta().field("id")};
+    const string              index_name = "t_id_" + to_string(i);
+    ASSERT_EQ(RC::SUCCESS, table_->create_index(nullptr, field_metas, index_name.c_str(), false));
+  }
+
+  for (int i = 0; i < 1000 && physical_count(table_) > RECORD_NUM / 2; i++) {
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+  vacuum->stop();
+  ASSERT_EQ(RECORD_NUM / 2, physical_count(table_));
+
+  // 新插入的记录会复用清理出来的位置，新索引中不能有指向这些位置的旧记录
+  rids_.clear();
+  insert_records(RECORD_NUM, RECORD_NUM + RECORD_NUM / 2);
+  for (int i = 0; i < index_num; i++) {
+    const string index_name = "t_id_" + to_string(i);
+    ASSERT_EQ(RECORD_NUM, index_entry_count(table_, index_name.c_str()));
+
+    Index        *index   = table_->find_index(index_name.c_str());
+    IndexScanner *scanner = index->create_scanner(nullptr, 0, true, nullptr, 0, true);
+    RID           rid;
+    int           last_id = -1;
+    while (OB_SUCC(scanner->next_entry(&rid))) {
+      Record record;
+      ASSERT_EQ(RC::SUCCESS, table_->get_record(rid, record));
+      int id = 0;
+      memcpy(&id, record.data() + table_->table_meta().field("id")->offset(), sizeof(id));
+      ASSERT_GT(id, last_id);
+      last_id = id;
+    }
+    scanner->destroy();
+  }
+}
+#endif  // CONCURRENCY
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  filesystem::path log_filename = filesystem::path(argv[0]).filename();
+  LoggerFactory::init_default(log_filename.string() + ".log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,178 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "gtest/gtest.h"
+
+#include "common/lang/bitmap.h"
+#include "common/log/log.h"
+#include "storage/buffer/page_allocator.h"
+
+using namespace std;
+using namespace common;
+
+// 分组很小，方便测试跨组的情况。第0组100个页面，后面每组70个页面，都不是64的整数倍
+static const int FIRST_GROUP_PAGES = 100;
+static const int GROUP_PAGES       = 70;
+
+/**
+ * @brief 模拟 DiskBufferPool 扩展文件：新的一组先分配分配图，再分配新页面
+ */
+static PageNum extend_one(PageAllocator &allocator)
+{
+  PageNum page_num = allocator.page_count();
+  if (allocator.is_map_page(page_num)) {
+    page_num++;
+  }
+  allocator.extend(page_num + 1);
+  return page_num;
+}
+
+TEST(PageAllocator, groups)
+{
+  PageAllocator allocator(FIRST_GROUP_PAGES, GROUP_PAGES);
+  ASSERT_EQ(0, allocator.group_of(0));
+  ASSERT_EQ(0, allocator.group_of(FIRST_GROUP_PAGES - 1));
+  ASSERT_EQ(1, allocator.group_of(FIRST_GROUP_PAGES));
+  ASSERT_EQ(1, allocator.group_of(FIRST_GROUP_PAGES + GROUP_PAGES - 1));
+  ASSERT_EQ(2, allocator.group_of(FIRST_GROUP_PAGES + GROUP_PAGES));
+
+  ASSERT_EQ(0, allocator.group_start(0));
+  ASSERT_EQ(FIRST_GROUP_PAGES, allocator.group_start(1));
+  ASSERT_EQ(FIRST_GROUP_PAGES + 2 * GROUP_PAGES, allocator.group_start(3));
+
+  ASSERT_FALSE(allocator.is_map_page(0));
+  ASSERT_TRUE(allocator.is_map_page(FIRST_GROUP_PAGES));
+  ASSERT_FALSE(allocator.is_map_page(FIRST_GROUP_PAGES + 1));
+  ASSERT_TRUE(allocator.is_map_page(FIRST_GROUP_PAGES + GROUP_PAGES));
+}
+
+TEST(PageAllocator, allocate_and_free)
+{
+  PageAllocator allocator(FIRST_GROUP_PAGES, GROUP_PAGES);
+  allocator.reset(1);
+  char header_bitmap[FIRST_GROUP_PAGES / 8 + 1] = {0x01};
+  allocator.load_group(0, header_bitmap);
+
+  // 没有空闲页面时一直扩展文件，扩展到第3组
+  ASSERT_EQ(BP_INVALID_PAGE_NUM, allocator.find_free_page());
+  const int data_pages = FIRST_GROUP_PAGES + 2 * GROUP_PAGES;
+  for (int i = 0; i < data_pages; i++) {
+    PageNum page_num = extend_one(allocator);
+    ASSERT_FALSE(allocator.is_map_page(page_num));
+    ASSERT_TRUE(allocator.is_allocated(page_num));
+    ASSERT_EQ(BP_INVALID_PAGE_NUM, allocator.find_free_page());
+  }
+  ASSERT_EQ(3, allocator.group_of(allocator.page_count() - 1));
+
+  // 遍历时跳过分配图
+  int     count    = 0;
+  PageNum page_num = allocator.next_allocated_page(1);
+  while (page_num != BP_INVALID_PAGE_NUM) {
+    ASSERT_FALSE(allocator.is_map_page(page_num));
+    count++;
+    page_num = allocator.next_allocated_page(page_num + 1);
+  }
+  ASSERT_EQ(data_pages, count);
+
+  // 释放不同组的页面，总是先分配编号小的组
+  const PageNum pages[] = {FIRST_GROUP_PAGES + GROUP_PAGES + 5, 3, FIRST_GROUP_PAGES + 1, 99};
+  for (PageNum page : pages) {
+    ASSERT_TRUE(allocator.clear_allocated(page));
+    ASSERT_FALSE(allocator.clear_allocated(page));
+    ASSERT_FALSE(allocator.is_allocated(page));
+  }
+
+  const PageNum expected[] = {3, 99, FIRST_GROUP_PAGES + 1, FIRST_GROUP_PAGES + GROUP_PAGES + 5};
+  for (PageNum page : expected) {
+    ASSERT_EQ(page, allocator.find_free_page());
+    ASSERT_TRUE(allocator.set_allocated(page));
+    ASSERT_FALSE(allocator.set_allocated(page));
+  }
+  ASSERT_EQ(BP_INVALID_PAGE_NUM, allocator.find_free_page());
+
+  // 不存在的页面
+  ASSERT_FALSE(allocator.is_allocated(allocator.page_count()));
+  ASSERT_FALSE(allocator.set_allocated(allocator.page_count()));
+}
+
+TEST(PageAllocator, load_group)
+{
+  PageAllocator allocator(FIRST_GROUP_PAGES, GROUP_PAGES);
+
+  // 第1组只有一部分页面存在
+  const PageNum page_count = FIRST_GROUP_PAGES + 40;
+  allocator.reset(page_count);
+
+  char   header_bitmap[FIRST_GROUP_PAGES / 8 + 1] = {0};
+  Bitmap header(header_bitmap, FIRST_GROUP_PAGES);
+  for (int i = 0; i < FIRST_GROUP_PAGES; i++) {
+    if (i % 2 == 0) {
+      header.set_bit(i);
+    }
+  }
+  allocator.load_group(0, header_bitmap);
+
+  // 磁盘上超出 page_count 的位即使是0，也不能当做空闲页面
+  char   map_bitmap[GROUP_PAGES / 8 + 1] = {0};
+  Bitmap map(map_bitmap, GROUP_PAGES);
+  map.set_bit(0);
+  map.set_bit(1);
+  allocator.load_group(1, map_bitmap);
+
+  int free_count = 0;
+  for (PageNum page_num = allocator.find_free_page(); page_num != BP_INVALID_PAGE_NUM;
+       page_num         = allocator.find_free_page()) {
+    ASSERT_LT(page_num, page_count);
+    ASSERT_TRUE(allocator.set_allocated(page_num));
+    free_count++;
+  }
+  ASSERT_EQ(FIRST_GROUP_PAGES / 2 + 40 - 2, free_count);
+
+  // 再次扩展文件时，接着 page_count 往后分配
+  ASSERT_EQ(page_count, extend_one(allocator));
+  ASSERT_EQ(BP_INVALID_PAGE_NUM, allocator.find_free_page());
+}
+
+TEST(PageAllocator, reuse_freed_pages)
+{
+  // 分配和释放交替进行，每次分配的都是编号最小的空闲页面
+  PageAllocator allocator(FIRST_GROUP_PAGES, GROUP_PAGES);
+  allocator.reset(1);
+  char header_bitmap[FIRST_GROUP_PAGES / 8 + 1] = {0x01};
+  allocator.load_group(0, header_bitmap);
+
+  const int page_num = 1000;
+  for (int i = 0; i < page_num; i++) {
+    extend_one(allocator);
+  }
+
+  set<PageNum> freed;
+  for (PageNum i = allocator.page_count() - 1; i > 0; i -= 7) {
+    if (!allocator.is_map_page(i)) {
+      ASSERT_TRUE(allocator.clear_allocated(i));
+      freed.insert(i);
+    }
+  }
+
+  while (!freed.empty()) {
+    PageNum page = allocator.find_free_page();
+    ASSERT_EQ(*freed.begin(), page);
+    ASSERT_TRUE(allocator.set_allocated(page));
+    freed.erase(freed.begin());
+  }
+  ASSERT_EQ(BP_INVALID_PAGE_NUM, allocator.find_free_page());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("page_allocator_test.log", LOG_LEVEL_TRACE);
+  return RUN_ALL_TESTS();
+}
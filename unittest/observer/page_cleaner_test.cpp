@@ -0,0 +1,147 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+
+#include "gtest/gtest.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/buffer/page_cleaner.h"
+#include "storage/clog/vacuous_log_handler.h"
+
+using namespace std;
+using namespace common;
+
+/// 一个内存池的页帧，方便计算水位
+static const int FRAME_NUM = DEFAULT_ITEM_NUM_PER_POOL;
+
+class PageCleanerTest : public testing::Test
+{
+public:
+  void SetUp() override
+  {
+    filesystem::remove_all(directory_);
+    filesystem::create_directories(directory_);
+
+    bpm_ = make_unique<BufferPoolManager>(FRAME_NUM * BP_PAGE_SIZE);
+    ASSERT_EQ(RC::SUCCESS, bpm_->init(make_unique<VacuousDoubleWriteBuffer>()));
+    ASSERT_EQ(static_cast<size_t>(FRAME_NUM), bpm_->get_frame_manager().total_frame_num());
+
+    const string file_name = (directory_ / "page_cleaner.bp").string();
+    ASSERT_EQ(RC::SUCCESS, bpm_->create_file(file_name.c_str()));
+    ASSERT_EQ(RC::SUCCESS, bpm_->open_file(log_handler_, file_name.c_str(), buffer_pool_));
+  }
+
+  void TearDown() override
+  {
+    bpm_.reset();
+    filesystem::remove_all(directory_);
+  }
+
+  /**
+   * @brief 分配一些页面并修改，修改后不再 pin 住
+   */
+  void make_dirty_pages(int count)
+  {
+    for (int i = 0; i < count; i++) {
+      Frame *frame = nullptr;
+      ASSERT_EQ(RC::SUCCESS, buffer_pool_->allocate_page(&frame));
+      frame->mark_dirty();
+      buffer_pool_->unpin_page(frame);
+    }
+  }
+
+  size_t dirty_frame_num() const { return bpm_->get_frame_manager().dirty_frame_num(); }
+
+protected:
+  filesystem::path              directory_{"page_cleaner"};
+  VacuousLogHandler             log_handler_;
+  unique_ptr<BufferPoolManager> bpm_;
+  DiskBufferPool               *buffer_pool_ = nullptr;
+};
+
+TEST_F(PageCleanerTest, clean_to_low_watermark)
+{
+  PageCleaner &cleaner = bpm_->page_cleaner();
+  ASSERT_EQ(RC::INVALID_ARGUMENT, cleaner.start(1, 50, 10));
+  ASSERT_EQ(RC::SUCCESS, cleaner.start(0, 10, 50));
+
+  const size_t low_num = FRAME_NUM * cleaner.low_watermark() / 100;
+
+  // 没有超过低水位时不刷新。分配页面时文件头也会变成脏页
+  make_dirty_pages(static_cast<int>(low_num) - 1);
+  ASSERT_EQ(low_num, dirty_frame_num());
+  ASSERT_EQ(0, cleaner.clean());
+
+  // pin 住的脏页不会刷新
+  Frame *pinned_frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_->allocate_page(&pinned_frame));
+  pinned_frame->mark_dirty();
+
+  make_dirty_pages(FRAME_NUM / 2);
+  const size_t dirty_num = dirty_frame_num();
+  ASSERT_GT(dirty_num, low_num);
+
+  {
+    // 暂停时不刷新
+    PageCleaner::PauseGuard pause_guard(cleaner);
+    ASSERT_EQ(0, cleaner.clean());
+  }
+
+  const int flushed_count = cleaner.clean();
+  ASSERT_GE(flushed_count, static_cast<int>(dirty_num - low_num));
+  ASSERT_LE(dirty_frame_num(), low_num);
+  ASSERT_TRUE(pinned_frame->dirty());
+  buffer_pool_->unpin_page(pinned_frame);
+
+  PageCleaner::Stats stats = cleaner.stats();
+  ASSERT_EQ(static_cast<uint64_t>(flushed_count), stats.pages_flushed);
+  ASSERT_EQ(1UL, stats.rounds);
+  ASSERT_EQ(0UL, stats.foreground_stalls);
+}
+
+TEST_F(PageCleanerTest, foreground_stall)
+{
+  PageCleaner &cleaner = bpm_->page_cleaner();
+  ASSERT_EQ(RC::SUCCESS, cleaner.start(0, 10, 50));
+
+  // 所有的页帧都是脏页，再分配页面时只能由前台刷新
+  make_dirty_pages(FRAME_NUM * 2);
+  ASSERT_GT(cleaner.stats().foreground_stalls, 0UL);
+}
+
+TEST_F(PageCleanerTest, background_threads)
+{
+  PageCleaner &cleaner = bpm_->page_cleaner();
+  ASSERT_EQ(RC::SUCCESS, cleaner.start(2, 10, 50));
+  ASSERT_EQ(2, cleaner.thread_num());
+
+  make_dirty_pages(FRAME_NUM / 2);
+
+  const size_t low_num = FRAME_NUM * cleaner.low_watermark() / 100;
+  for (int i = 0; i < 100 && dirty_frame_num() > low_num; i++) {
+    this_thread::sleep_for(chrono::milliseconds(50));
+  }
+  ASSERT_LE(dirty_frame_num(), low_num);
+  ASSERT_GT(cleaner.stats().pages_flushed, 0UL);
+
+  // 后台线程运行时关闭文件
+  ASSERT_EQ(RC::SUCCESS, bpm_->close_file((directory_ / "page_cleaner.bp").c_str()));
+  cleaner.stop();
+  ASSERT_EQ(0, cleaner.thread_num());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("page_cleaner_test.log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
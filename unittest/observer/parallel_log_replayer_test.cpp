@@ -0,0 +1,251 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <string.h>
+
+#include "gtest/gtest.h"
+#include "common/conf/ini.h"
+#include "common/ini_setting.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/map.h"
+#include "common/lang/mutex.h"
+#include "common/log/log.h"
+#include "common/value.h"
+#include "storage/buffer/buffer_pool_log.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/parallel_log_replayer.h"
+#include "storage/db/db.h"
+#include "storage/record/record_log.h"
+#include "storage/record/record_scanner.h"
+#include "storage/table/table.h"
+#include "storage/trx/trx.h"
+
+using namespace std;
+using namespace common;
+
+/**
+ * @brief 记录每条日志回放的顺序，检查并发回放时的约束
+ */
+class CheckOrderReplayer : public LogReplayer
+{
+public:
+  RC replay(const LogEntry &entry) override
+  {
+    lock_guard guard(lock_);
+    switch (entry.module().id()) {
+      case LogModule::Id::BUFFER_POOL: {
+        auto *log = reinterpret_cast<const BufferPoolLogEntry *>(entry.data());
+        EXPECT_LT(buffer_pool_lsns_[log->buffer_pool_id], entry.lsn());
+        buffer_pool_lsns_[log->buffer_pool_id] = entry.lsn();
+      } break;
+      case LogModule::Id::RECORD_MANAGER: {
+        auto *log = reinterpret_cast<const RecordLogHeader *>(entry.data());
+        // 同一个页面按照LSN的顺序回放，并且在此之前的缓冲池日志都已经回放了
+        auto key = make_pair(log->buffer_pool_id, log->page_num);
+        EXPECT_LT(page_lsns_[key], entry.lsn());
+        EXPECT_LE(expected_buffer_pool_lsns_.at(entry.lsn()), buffer_pool_lsns_[log->buffer_pool_id]);
+        page_lsns_[key] = entry.lsn();
+      } break;
+      case LogModule::Id::TRANSACTION: {
+        trx_lsns_.push_back(entry.lsn());
+      } break;
+      default: break;
+    }
+    replayed_count_++;
+    return RC::SUCCESS;
+  }
+
+  RC on_done() override
+  {
+    done_count_ = replayed_count_;
+    return RC::SUCCESS;
+  }
+
+public:
+  mutex                            lock_;
+  map<int32_t, LSN>                buffer_pool_lsns_;
+  map<pair<int32_t, PageNum>, LSN> page_lsns_;
+  map<LSN, LSN>                    expected_buffer_pool_lsns_;  /// 回放记录日志时，最后一条缓冲池日志的LSN
+  vector<LSN>                      trx_lsns_;
+  int                              replayed_count_ = 0;
+  int                              done_count_     = 0;
+};
+
+TEST(ParallelLogReplayer, order)
+{
+  CheckOrderReplayer  check_replayer;
+  ParallelLogReplayer replayer(check_replayer, 4);
+  ASSERT_EQ(4, replayer.thread_num());
+
+  const int buffer_pool_num = 3;
+  const int page_num        = 10;
+
+  map<int32_t, LSN> allocated_lsns;
+  LSN               lsn       = 0;
+  int               entry_num = 0;
+  for (int round = 0; round < 100; round++) {
+    for (int32_t bp = 0; bp < buffer_pool_num; bp++) {
+      // 每隔几轮分配一个页面
+      if (round % 10 == 0) {
+        BufferPoolLogEntry bp_log;
+        bp_log.buffer_pool_id = bp;
+        bp_log.operation_type = BufferPoolOperation(BufferPoolOperation::Type::ALLOCATE).type_id();
+        bp_log.page_num       = round / 10;
+
+        LogEntry entry;
+        ASSERT_EQ(RC::SUCCESS,
+            entry.init(++lsn, LogModule::Id::BUFFER_POOL,
+                vector<char>(reinterpret_cast<char *>(&bp_log), reinterpret_cast<char *>(&bp_log) + sizeof(bp_log))));
+        ASSERT_EQ(RC::SUCCESS, replayer.replay(entry));
+        allocated_lsns[bp] = lsn;
+        entry_num++;
+      }
+
+      for (PageNum page = 0; page < page_num; page++) {
+        RecordLogHeader record_log;
+        memset(&record_log, 0, sizeof(record_log));
+        record_log.buffer_pool_id = bp;
+        record_log.page_num       = page;
+
+        LogEntry entry;
+        ASSERT_EQ(RC::SUCCESS,
+            entry.init(++lsn, LogModule::Id::RECORD_MANAGER,
+                vector<char>(reinterpret_cast<char *>(&record_log),
+                    reinterpret_cast<char *>(&record_log) + RecordLogHeader::SIZE)));
+        {
+          lock_guard guard(check_replayer.lock_);
+          check_replayer.expected_buffer_pool_lsns_[lsn] = allocated_lsns[bp];
+        }
+        ASSERT_EQ(RC::SUCCESS, replayer.replay(entry));
+        entry_num++;
+      }
+    }
+
+    LogEntry trx_entry;
+    ASSERT_EQ(RC::SUCCESS, trx_entry.init(++lsn, LogModule::Id::TRANSACTION, vector<char>(8)));
+    ASSERT_EQ(RC::SUCCESS, replayer.replay(trx_entry));
+    entry_num++;
+  }
+
+  ASSERT_EQ(RC::SUCCESS, replayer.on_done());
+  ASSERT_EQ(entry_num, check_replayer.done_count_);
+
+  // 事务日志在读取日志的线程中按顺序回放
+  ASSERT_EQ(100UL, check_replayer.trx_lsns_.size());
+  ASSERT_TRUE(is_sorted(check_replayer.trx_lsns_.begin(), check_replayer.trx_lsns_.end()));
+}
+
+TEST(ParallelLogReplayer, safe_thread_num)
+{
+  ASSERT_EQ(1, ParallelLogReplayer::safe_thread_num(1));
+#ifdef CONCURRENCY
+  ASSERT_EQ(4, ParallelLogReplayer::safe_thread_num(4));
+#else
+  // 没有并发控制时 buffer pool 不能在多个线程中访问
+  ASSERT_EQ(1, ParallelLogReplayer::safe_thread_num(4));
+#endif
+}
+
+TEST(ParallelLogReplayer, recover_db)
+{
+  /*
+  创建一个数据库，插入一些数据，一半的事务回滚。等日志都落地后把文件复制到另一个目录，
+  此时 buffer pool 中的页面都没有落地。使用多个线程(没有 CONCURRENCY 时只能用一个线程)回放日志，
+  检查数据是否一致。
+  */
+  filesystem::path test_directory("parallel_log_replayer_test");
+  filesystem::remove_all(test_directory);
+  filesystem::path db_path  = test_directory / "test_db";
+  filesystem::path db_path2 = test_directory / "test_db2";
+  filesystem::create_directories(db_path);
+
+  auto db = make_unique<Db>();
+  ASSERT_EQ(RC::SUCCESS, db->init("test_db", db_path.c_str(), "mvcc", "disk"));
+
+  const int               table_num = 4;
+  vector<AttrInfoSqlNode> attr_infos(4);
+  for (size_t i = 0; i < attr_infos.size(); i++) {
+    attr_infos[i].name   = "field_" + to_string(i);
+    attr_infos[i].type   = AttrType::INTS;
+    attr_infos[i].length = 4;
+  }
+  for (int i = 0; i < table_num; i++) {
+    ASSERT_EQ(RC::SUCCESS, db->create_table(("table_" + to_string(i)).c_str(), attr_infos, {}));
+    ASSERT_EQ(RC::SUCCESS, db->sync());
+  }
+
+  const int trx_num = 200;
+  for (int i = 0; i < trx_num; i++) {
+    Trx *trx = db->trx_kit().create_trx(db->log_handler());
+    ASSERT_EQ(RC::SUCCESS, trx->start_if_need());
+    for (int t = 0; t < table_num; t++) {
+      Table *table = db->find_table(("table_" + to_string(t)).c_str());
+      ASSERT_NE(nullptr, table);
+
+      vector<Value> values(attr_infos.size());
+      for (Value &value : values) {
+        value.set_int(i);
+      }
+      Record record;
+      ASSERT_EQ(RC::SUCCESS, table->make_record(values.size(), values.data(), record));
+      ASSERT_EQ(RC::SUCCESS, trx->insert_record(table, record));
+    }
+
+    if (i % 2 == 0) {
+      ASSERT_EQ(RC::SUCCESS, trx->commit());
+    } else {
+      ASSERT_EQ(RC::SUCCESS, trx->rollback());
+    }
+    db->trx_kit().destroy_trx(trx);
+  }
+
+  DiskLogHandler &log_handler = static_cast<DiskLogHandler &>(db->log_handler());
+  ASSERT_EQ(RC::SUCCESS, log_handler.wait_lsn(log_handler.current_lsn()));
+  filesystem::copy(db_path, db_path2, filesystem::copy_options::recursive);
+
+  get_properties()->put(CLOG_REPLAY_THREADS, "4", STORAGE);
+  auto db2 = make_unique<Db>();
+  RC   rc  = db2->init("test_db2", db_path2.c_str(), "mvcc", "disk");
+  get_properties()->put(CLOG_REPLAY_THREADS, CLOG_REPLAY_THREADS_DEFAULT, STORAGE);
+  ASSERT_EQ(RC::SUCCESS, rc);
+
+  Trx *trx = db2->trx_kit().create_trx(db2->log_handler());
+  ASSERT_EQ(RC::SUCCESS, trx->start_if_need());
+  for (int t = 0; t < table_num; t++) {
+    Table *table = db2->find_table(("table_" + to_string(t)).c_str());
+    ASSERT_NE(nullptr, table);
+
+    RecordScanner *scanner = nullptr;
+    ASSERT_EQ(RC::SUCCESS, table->get_record_scanner(scanner, nullptr, ReadWriteMode::READ_ONLY));
+    int    visible_count = 0;
+    Record record;
+    while (OB_SUCC(rc = scanner->next(record))) {
+      if (OB_SUCC(trx->visit_record(table, record, ReadWriteMode::READ_ONLY))) {
+        visible_count++;
+      }
+    }
+    delete scanner;
+    ASSERT_EQ(RC::RECORD_EOF, rc);
+    ASSERT_EQ(trx_num / 2, visible_count);
+  }
+  db2->trx_kit().destroy_trx(trx);
+
+  db2.reset();
+  db.reset();
+  filesystem::remove_all(test_directory);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("parallel_log_replayer_test.log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
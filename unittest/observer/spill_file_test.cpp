@@ -0,0 +1,85 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "gtest/gtest.h"
+
+#include "common/lang/filesystem.h"
+#include "common/log/log.h"
+#include "storage/common/spill_file.h"
+
+using namespace std;
+using namespace common;
+
+TEST(SpillFile, append_and_read)
+{
+  filesystem::path directory("spill_file_test");
+  filesystem::remove_all(directory);
+  filesystem::create_directories(directory);
+  const string path = (directory / "test.spill").string();
+
+  // 记录长度从0到比缓冲区还大，覆盖记录跨越缓冲区边界的情况
+  auto record_of = [](int i) {
+    return string((i * 997) % (SpillFile::BUFFER_SIZE + 100), static_cast<char>('a' + i % 26));
+  };
+  const int record_num = 200;
+
+  SpillFile file;
+  ASSERT_EQ(RC::SUCCESS, file.create(path));
+  int64_t data_size = 0;
+  for (int i = 0; i < record_num; i++) {
+    string record = record_of(i);
+    ASSERT_EQ(RC::SUCCESS, file.append(i * 31, record.data(), static_cast<int>(record.size())));
+    data_size += record.size();
+  }
+  ASSERT_EQ(record_num, file.record_num());
+  ASSERT_GT(file.size(), data_size);
+
+  // 可以反复读取多次
+  for (int round = 0; round < 2; round++) {
+    ASSERT_EQ(RC::SUCCESS, file.rewind());
+    for (int i = 0; i < record_num; i++) {
+      uint64_t    hash = 0;
+      const char *data = nullptr;
+      int         len  = 0;
+      ASSERT_EQ(RC::SUCCESS, file.next(hash, data, len));
+      ASSERT_EQ(static_cast<uint64_t>(i * 31), hash);
+      ASSERT_EQ(record_of(i), string(data, len));
+    }
+
+    uint64_t    hash = 0;
+    const char *data = nullptr;
+    int         len  = 0;
+    ASSERT_EQ(RC::RECORD_EOF, file.next(hash, data, len));
+  }
+
+  ASSERT_TRUE(filesystem::exists(path));
+  file.remove();
+  ASSERT_FALSE(filesystem::exists(path));
+  filesystem::remove_all(directory);
+}
+
+TEST(SpillFile, empty)
+{
+  SpillFile file;
+  ASSERT_EQ(RC::SUCCESS, file.create("spill_file_test_empty.spill"));
+  ASSERT_EQ(RC::SUCCESS, file.rewind());
+
+  uint64_t    hash = 0;
+  const char *data = nullptr;
+  int         len  = 0;
+  ASSERT_EQ(RC::RECORD_EOF, file.next(hash, data, len));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("spill_file_test.log", LOG_LEVEL_TRACE);
+  return RUN_ALL_TESTS();
+}